@@ -6,9 +6,9 @@
 #define PSMOVESERVICE_DEFAULT_PORT      "9512"
 
 // See ControllerManager.h in PSMoveService
-#define PSMOVESERVICE_MAX_CONTROLLER_COUNT  5
+#define PSMOVESERVICE_MAX_CONTROLLER_COUNT  16
 
 // See TrackerManager.h in PSMoveService
-#define PSMOVESERVICE_MAX_TRACKER_COUNT  4
+#define PSMOVESERVICE_MAX_TRACKER_COUNT  8
 
 #endif // CLIENT_CONSTANTS_H
\ No newline at end of file
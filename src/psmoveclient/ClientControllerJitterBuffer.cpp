@@ -0,0 +1,335 @@
+//-- includes -----
+#include "ClientControllerJitterBuffer.h"
+#include "MathUtility.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+//-- constants -----
+// Most data frames a jitter buffer holds before presenting the oldest early
+static const size_t k_max_jitter_buffer_frame_count = 64;
+// Furthest the jitter buffer extrapolates a pose past its newest data frame
+static const long long k_max_jitter_buffer_extrapolation_usec = 100000;
+// How fast the estimated offset between the service and local clocks creeps back up after
+// an unusually quick data frame, so the estimate can follow drift between the two clocks
+static const long long k_jitter_buffer_clock_offset_relax_usec = 2;
+
+//-- prototypes ----
+static bool get_data_frame_pose(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket &data_frame, PSMovePose &out_pose);
+static bool get_data_frame_velocities(
+    const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket &data_frame,
+    PSMoveFloatVector3 &out_velocity, PSMoveFloatVector3 &out_angular_velocity);
+static PSMoveQuaternion slerp_quaternion(const PSMoveQuaternion &a, const PSMoveQuaternion &b, float u);
+
+//-- public methods -----
+ClientControllerJitterBuffer::ClientControllerJitterBuffer(float delay_milliseconds)
+    : m_delay_usec(0)
+    , m_frames()
+    , m_presented_frame()
+    , m_has_presented_frame(false)
+{
+    setDelay(delay_milliseconds);
+    reset();
+}
+
+void ClientControllerJitterBuffer::setDelay(float delay_milliseconds)
+{
+    m_delay_usec = static_cast<long long>(std::max(delay_milliseconds, 0.f) * 1000.f);
+}
+
+void ClientControllerJitterBuffer::reset()
+{
+    m_frames.clear();
+    m_has_presented_frame = false;
+    m_has_clock_offset = false;
+    m_clock_offset_usec = 0;
+    m_last_transit_usec = 0;
+    m_newest_stream_sequence_num = -1;
+    m_late_frame_count = 0;
+    m_missing_frame_count = 0;
+    m_extrapolated_pose_count = 0;
+    m_jitter_usec = 0.f;
+}
+
+void ClientControllerJitterBuffer::addDataFrame(
+    const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *data_frame,
+    long long receive_time_usec)
+{
+    const int sequence_num = data_frame->sequence_num();
+
+    // Arrived after a newer frame was already presented
+    if (m_has_presented_frame && sequence_num <= m_presented_frame.data_frame.sequence_num())
+    {
+        ++m_late_frame_count;
+        return;
+    }
+
+    // Find where the frame goes in sequence order (usually the back)
+    std::deque<BufferedFrame>::iterator insert_iter = m_frames.end();
+    while (insert_iter != m_frames.begin() && (insert_iter - 1)->data_frame.sequence_num() >= sequence_num)
+    {
+        --insert_iter;
+    }
+
+    // Duplicate of a frame already in the buffer
+    if (insert_iter != m_frames.end() && insert_iter->data_frame.sequence_num() == sequence_num)
+    {
+        return;
+    }
+
+    // Gaps are counted with the stream's own numbering, since sequence_num also skips every controller update
+    // a rate capped or change-only stream leaves out on purpose (older services only send sequence_num)
+    const int stream_sequence_num = 
+        (data_frame->stream_sequence_num() > 0) ? data_frame->stream_sequence_num() : sequence_num;
+
+    if (stream_sequence_num > m_newest_stream_sequence_num)
+    {
+        if (m_newest_stream_sequence_num >= 0)
+        {
+            m_missing_frame_count += stream_sequence_num - m_newest_stream_sequence_num - 1;
+        }
+
+        m_newest_stream_sequence_num = stream_sequence_num;
+    }
+    else if (insert_iter == m_frames.end())
+    {
+        // The newest frame yet with an older stream number: the stream was restarted and numbers from 1 again
+        m_newest_stream_sequence_num = stream_sequence_num;
+    }
+    else if (m_missing_frame_count > 0)
+    {
+        // Filled in a gap after all
+        --m_missing_frame_count;
+    }
+
+    long long local_time_usec = receive_time_usec;
+    const long long publish_time_usec = static_cast<long long>(data_frame->publish_timestamp_usec());
+
+    // Older services don't stamp their data frames, in which case all there is to go on is the receive time
+    if (publish_time_usec != 0)
+    {
+        const long long transit_usec = receive_time_usec - publish_time_usec;
+
+        if (m_has_clock_offset)
+        {
+            // Interarrival jitter as in RFC 3550
+            const long long transit_change_usec = transit_usec - m_last_transit_usec;
+
+            m_jitter_usec += (static_cast<float>(std::abs(transit_change_usec)) - m_jitter_usec) / 16.f;
+            m_clock_offset_usec = std::min(m_clock_offset_usec + k_jitter_buffer_clock_offset_relax_usec, transit_usec);
+        }
+        else
+        {
+            m_clock_offset_usec = transit_usec;
+            m_has_clock_offset = true;
+        }
+
+        m_last_transit_usec = transit_usec;
+        local_time_usec = publish_time_usec + m_clock_offset_usec;
+    }
+
+    // Keep frame times in sequence order as the clock offset estimate moves around
+    if (m_has_presented_frame)
+    {
+        local_time_usec = std::max(local_time_usec, m_presented_frame.local_time_usec);
+    }
+    if (insert_iter != m_frames.begin())
+    {
+        local_time_usec = std::max(local_time_usec, (insert_iter - 1)->local_time_usec);
+    }
+    if (insert_iter != m_frames.end())
+    {
+        local_time_usec = std::min(local_time_usec, insert_iter->local_time_usec);
+    }
+
+    insert_iter = m_frames.insert(insert_iter, BufferedFrame());
+    insert_iter->local_time_usec = local_time_usec;
+    insert_iter->data_frame = *data_frame;
+}
+
+const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *
+ClientControllerJitterBuffer::popDueDataFrame(long long presentation_time_usec)
+{
+    const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *data_frame = nullptr;
+
+    if (!m_frames.empty() &&
+        (m_frames.front().local_time_usec <= presentation_time_usec || m_frames.size() > k_max_jitter_buffer_frame_count))
+    {
+        // Swap rather than copy so the presented frame's sub-messages get reused
+        m_presented_frame.local_time_usec = m_frames.front().local_time_usec;
+        m_presented_frame.data_frame.Swap(&m_frames.front().data_frame);
+        m_has_presented_frame = true;
+        m_frames.pop_front();
+
+        data_frame = &m_presented_frame.data_frame;
+    }
+
+    return data_frame;
+}
+
+bool ClientControllerJitterBuffer::computePresentedPose(long long presentation_time_usec, PSMovePose &out_pose)
+{
+    if (!m_has_presented_frame || !get_data_frame_pose(m_presented_frame.data_frame, out_pose))
+    {
+        return false;
+    }
+
+    const long long time_since_presented_usec = presentation_time_usec - m_presented_frame.local_time_usec;
+
+    if (!m_frames.empty())
+    {
+        const BufferedFrame &next_frame = m_frames.front();
+        const long long frame_interval_usec = next_frame.local_time_usec - m_presented_frame.local_time_usec;
+        PSMovePose next_pose;
+
+        if (frame_interval_usec > 0 && time_since_presented_usec > 0 && get_data_frame_pose(next_frame.data_frame, next_pose))
+        {
+            const float u = 
+                std::min(static_cast<float>(time_since_presented_usec) / static_cast<float>(frame_interval_usec), 1.f);
+
+            out_pose.Position = out_pose.Position + (next_pose.Position - out_pose.Position) * u;
+            out_pose.Orientation = slerp_quaternion(out_pose.Orientation, next_pose.Orientation, u);
+        }
+    }
+    else if (time_since_presented_usec > 0)
+    {
+        PSMoveFloatVector3 velocity, angular_velocity;
+
+        if (get_data_frame_velocities(m_presented_frame.data_frame, velocity, angular_velocity))
+        {
+            const float dt = 
+                static_cast<float>(std::min(time_since_presented_usec, k_max_jitter_buffer_extrapolation_usec)) / 1000000.f;
+            const PSMoveQuaternion q = out_pose.Orientation;
+            const PSMoveQuaternion omega = PSMoveQuaternion::create(0.f, angular_velocity.i, angular_velocity.j, angular_velocity.k);
+            const PSMoveQuaternion q_derivative = q * omega;
+
+            // Same first order prediction the service's filters use (dq/dt = q*omega/2)
+            out_pose.Position = out_pose.Position + velocity * dt;
+            out_pose.Orientation = PSMoveQuaternion::create(
+                q.w + q_derivative.w*0.5f*dt,
+                q.x + q_derivative.x*0.5f*dt,
+                q.y + q_derivative.y*0.5f*dt,
+                q.z + q_derivative.z*0.5f*dt);
+            out_pose.Orientation.normalize_with_default(q);
+
+            ++m_extrapolated_pose_count;
+        }
+    }
+
+    return true;
+}
+
+void ClientControllerJitterBuffer::getStatistics(ClientControllerJitterBufferStatistics &out_statistics) const
+{
+    out_statistics.BufferedFrameCount = static_cast<int>(m_frames.size());
+    out_statistics.LateFrameCount = m_late_frame_count;
+    out_statistics.MissingFrameCount = m_missing_frame_count;
+    out_statistics.ExtrapolatedPoseCount = m_extrapolated_pose_count;
+    out_statistics.JitterMilliseconds = m_jitter_usec / 1000.f;
+}
+
+//-- private functions -----
+static bool get_data_frame_pose(
+    const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket &data_frame,
+    PSMovePose &out_pose)
+{
+    bool bHasPose= false;
+
+    if (data_frame.isconnected())
+    {
+        switch (data_frame.controller_type())
+        {
+        case PSMoveProtocol::PSMOVE:
+            {
+                const auto &state= data_frame.psmove_state();
+
+                out_pose.Position= PSMovePosition::create(state.position().x(), state.position().y(), state.position().z());
+                out_pose.Orientation= PSMoveQuaternion::create(
+                    state.orientation().w(), state.orientation().x(), state.orientation().y(), state.orientation().z());
+                bHasPose= true;
+            } break;
+        case PSMoveProtocol::PSDUALSHOCK4:
+            {
+                const auto &state= data_frame.psdualshock4_state();
+
+                out_pose.Position= PSMovePosition::create(state.position().x(), state.position().y(), state.position().z());
+                out_pose.Orientation= PSMoveQuaternion::create(
+                    state.orientation().w(), state.orientation().x(), state.orientation().y(), state.orientation().z());
+                bHasPose= true;
+            } break;
+        default:
+            // No pose on a PSNavi
+            break;
+        }
+    }
+
+    return bHasPose;
+}
+
+static bool get_data_frame_velocities(
+    const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket &data_frame,
+    PSMoveFloatVector3 &out_velocity, 
+    PSMoveFloatVector3 &out_angular_velocity)
+{
+    bool bHasVelocities= false;
+
+    // Only sent when the stream was started with include_physics_data
+    if (data_frame.controller_type() == PSMoveProtocol::PSMOVE &&
+        data_frame.psmove_state().has_physics_data())
+    {
+        const auto &physics_data= data_frame.psmove_state().physics_data();
+
+        out_velocity= PSMoveFloatVector3::create(physics_data.velocity().i(), physics_data.velocity().j(), physics_data.velocity().k());
+        out_angular_velocity= PSMoveFloatVector3::create(
+            physics_data.angular_velocity().i(), physics_data.angular_velocity().j(), physics_data.angular_velocity().k());
+        bHasVelocities= true;
+    }
+    else if (data_frame.controller_type() == PSMoveProtocol::PSDUALSHOCK4 &&
+             data_frame.psdualshock4_state().has_physics_data())
+    {
+        const auto &physics_data= data_frame.psdualshock4_state().physics_data();
+
+        out_velocity= PSMoveFloatVector3::create(physics_data.velocity().i(), physics_data.velocity().j(), physics_data.velocity().k());
+        out_angular_velocity= PSMoveFloatVector3::create(
+            physics_data.angular_velocity().i(), physics_data.angular_velocity().j(), physics_data.angular_velocity().k());
+        bHasVelocities= true;
+    }
+
+    return bHasVelocities;
+}
+
+static PSMoveQuaternion slerp_quaternion(const PSMoveQuaternion &a, const PSMoveQuaternion &b, float u)
+{
+    float dot= a.w*b.w + a.x*b.x + a.y*b.y + a.z*b.z;
+    float sign= 1.f;
+
+    // Take the short way around
+    if (dot < 0.f)
+    {
+        dot= -dot;
+        sign= -1.f;
+    }
+
+    float weight_a= 1.f - u;
+    float weight_b= u;
+
+    // Nearly parallel quaternions lerp fine (and sin(theta) would be ~0)
+    if (dot < 0.9995f)
+    {
+        const float theta= acosf(dot);
+        const float sin_theta= sinf(theta);
+
+        weight_a= sinf((1.f - u)*theta) / sin_theta;
+        weight_b= sinf(u*theta) / sin_theta;
+    }
+
+    weight_b*= sign;
+
+    PSMoveQuaternion result= PSMoveQuaternion::create(
+        a.w*weight_a + b.w*weight_b,
+        a.x*weight_a + b.x*weight_b,
+        a.y*weight_a + b.y*weight_b,
+        a.z*weight_a + b.z*weight_b);
+
+    return result.normalize_with_default(*k_psmove_quaternion_identity);
+}
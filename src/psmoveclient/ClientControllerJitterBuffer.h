@@ -0,0 +1,69 @@
+#ifndef CLIENT_CONTROLLER_JITTER_BUFFER_H
+#define CLIENT_CONTROLLER_JITTER_BUFFER_H
+
+//-- includes -----
+#include "ClientControllerView.h"
+#include "PSMoveProtocol.pb.h"
+#include <deque>
+
+//-- definitions -----
+// Orders a controller's data frames by sequence number and holds them until their presentation time.
+// Frame times come from the service's publish timestamps, moved onto the local clock by the smallest
+// transit time seen, so frames are spaced the way the service sent them rather than how they arrived.
+// All times are in microseconds on the caller's local clock.
+class ClientControllerJitterBuffer
+{
+public:
+    ClientControllerJitterBuffer(float delay_milliseconds);
+
+    void setDelay(float delay_milliseconds);
+    inline long long getDelayUsec() const
+    {
+        return m_delay_usec;
+    }
+
+    void reset();
+
+    void addDataFrame(
+        const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *data_frame,
+        long long receive_time_usec);
+
+    // Returns the oldest frame that's due by the presentation time (or overflowing the buffer), or null.
+    // The frame is only valid until the next call.
+    const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *popDueDataFrame(long long presentation_time_usec);
+
+    // The pose at the presentation time: interpolated between the last presented frame and the next one,
+    // or extrapolated from the last presented frame's velocities when there is no next one yet
+    bool computePresentedPose(long long presentation_time_usec, PSMovePose &out_pose);
+
+    void getStatistics(ClientControllerJitterBufferStatistics &out_statistics) const;
+
+private:
+    struct BufferedFrame
+    {
+        long long local_time_usec;
+        PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket data_frame;
+    };
+
+    long long m_delay_usec;
+
+    // Frames waiting to be presented in sequence order
+    std::deque<BufferedFrame> m_frames;
+
+    // The newest frame applied to the controller view
+    BufferedFrame m_presented_frame;
+    bool m_has_presented_frame;
+
+    // Local time minus service time, estimated from the fastest data frames
+    bool m_has_clock_offset;
+    long long m_clock_offset_usec;
+    long long m_last_transit_usec;
+
+    int m_newest_stream_sequence_num;
+    int m_late_frame_count;
+    int m_missing_frame_count;
+    int m_extrapolated_pose_count;
+    float m_jitter_usec;
+};
+
+#endif // CLIENT_CONTROLLER_JITTER_BUFFER_H
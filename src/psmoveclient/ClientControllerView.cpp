@@ -1,11 +1,14 @@
 //-- includes -----
 #include "ClientControllerView.h"
+#include "ClientControllerJitterBuffer.h"
 #include "ClientNetworkManager.h"
 #include "PSMoveProtocolInterface.h"
 #include "PSMoveProtocol.pb.h"
 #include "MathUtility.h"
 #include <chrono>
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <assert.h>
 
 //-- pre-declarations -----
@@ -21,6 +24,7 @@ const PSMoveRawTrackerData k_empty_raw_tracker_data = { 0 };
 
 //-- prototypes ----
 static void update_button_state(PSMoveButtonState &button, unsigned int button_bitmask, unsigned int button_bit);
+static long long get_jitter_buffer_clock_usec();
 
 //-- implementation -----
 
@@ -247,6 +251,11 @@ void ClientPSMoveView::ApplyControllerDataFrame(
     }
 }
 
+void ClientPSMoveView::ApplyPresentedPose(const PSMovePose &pose)
+{
+    this->Pose= pose;
+}
+
 void ClientPSMoveView::Publish(
     PSMoveProtocol::DeviceInputDataFrame_ControllerDataPacket *data_frame)
 {
@@ -567,6 +576,11 @@ void ClientPSDualShock4View::ApplyControllerDataFrame(const PSMoveProtocol::Devi
     }
 }
 
+void ClientPSDualShock4View::ApplyPresentedPose(const PSMovePose &pose)
+{
+    this->Pose = pose;
+}
+
 void ClientPSDualShock4View::Publish(
     PSMoveProtocol::DeviceInputDataFrame_ControllerDataPacket *data_frame)
 {
@@ -648,11 +662,21 @@ const PSMoveRawTrackerData &ClientPSDualShock4View::GetRawTrackerData() const
 
 //-- ClientControllerView -----
 ClientControllerView::ClientControllerView(int PSMoveID)
+    : jitter_buffer(nullptr)
 {
     Clear();
     this->ControllerID= PSMoveID;
 }
 
+ClientControllerView::~ClientControllerView()
+{
+    if (jitter_buffer != nullptr)
+    {
+        delete jitter_buffer;
+        jitter_buffer= nullptr;
+    }
+}
+
 void ClientControllerView::Clear()
 {
     ControllerID = -1;
@@ -669,6 +693,11 @@ void ClientControllerView::Clear()
         std::chrono::duration_cast< std::chrono::milliseconds >(
                 std::chrono::system_clock::now().time_since_epoch()).count();
     data_frame_average_fps= 0.f;
+
+    if (jitter_buffer != nullptr)
+    {
+        jitter_buffer->reset();
+    }
 }
 
 void ClientControllerView::ApplyControllerDataFrame(
@@ -694,6 +723,20 @@ void ClientControllerView::ApplyControllerDataFrame(
         data_frame_last_received_time= now;
     }
 
+    if (jitter_buffer != nullptr)
+    {
+        // Applied in sequence order by PresentJitterBuffer()
+        jitter_buffer->addDataFrame(data_frame, get_jitter_buffer_clock_usec());
+    }
+    else
+    {
+        ApplyControllerDataFrameToView(data_frame);
+    }
+}
+
+void ClientControllerView::ApplyControllerDataFrameToView(
+    const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *data_frame)
+{
     if (data_frame->sequence_num() > this->OutputSequenceNum)
     {
         this->OutputSequenceNum= data_frame->sequence_num();
@@ -725,6 +768,78 @@ void ClientControllerView::ApplyControllerDataFrame(
     }
 }
 
+void ClientControllerView::EnableJitterBuffer(float delay_milliseconds)
+{
+    if (jitter_buffer != nullptr)
+    {
+        jitter_buffer->setDelay(delay_milliseconds);
+    }
+    else
+    {
+        jitter_buffer= new ClientControllerJitterBuffer(delay_milliseconds);
+    }
+}
+
+void ClientControllerView::DisableJitterBuffer()
+{
+    if (jitter_buffer != nullptr)
+    {
+        const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *data_frame;
+
+        while ((data_frame= jitter_buffer->popDueDataFrame(std::numeric_limits<long long>::max())) != nullptr)
+        {
+            ApplyControllerDataFrameToView(data_frame);
+        }
+
+        delete jitter_buffer;
+        jitter_buffer= nullptr;
+    }
+}
+
+void ClientControllerView::PresentJitterBuffer(float render_time_offset_milliseconds)
+{
+    if (jitter_buffer != nullptr)
+    {
+        const long long presentation_time_usec= 
+            get_jitter_buffer_clock_usec() 
+            + static_cast<long long>(render_time_offset_milliseconds * 1000.f) 
+            - jitter_buffer->getDelayUsec();
+        const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *data_frame;
+        PSMovePose presented_pose;
+
+        // Everything but the pose changes exactly as it would have without the buffer, just later
+        while ((data_frame= jitter_buffer->popDueDataFrame(presentation_time_usec)) != nullptr)
+        {
+            ApplyControllerDataFrameToView(data_frame);
+        }
+
+        if (jitter_buffer->computePresentedPose(presentation_time_usec, presented_pose))
+        {
+            switch (ControllerViewType)
+            {
+            case eControllerType::PSMove:
+                ViewState.PSMoveView.ApplyPresentedPose(presented_pose);
+                break;
+            case eControllerType::PSDualShock4:
+                ViewState.PSDualShock4View.ApplyPresentedPose(presented_pose);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+bool ClientControllerView::GetJitterBufferStatistics(ClientControllerJitterBufferStatistics &out_statistics) const
+{
+    if (jitter_buffer != nullptr)
+    {
+        jitter_buffer->getStatistics(out_statistics);
+    }
+
+    return jitter_buffer != nullptr;
+}
+
 bool ClientControllerView::GetHasUnpublishedState() const
 {
     bool bHasUnpublishedState = false;
@@ -953,4 +1068,10 @@ static void update_button_state(
         button= is_down ? PSMoveButton_PRESSED : PSMoveButton_UP;
         break;
     };
-}
\ No newline at end of file
+}
+
+static long long get_jitter_buffer_clock_usec()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
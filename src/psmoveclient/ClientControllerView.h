@@ -206,6 +206,7 @@ private:
 public:
     void Clear();
     void ApplyControllerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *data_frame);
+    void ApplyPresentedPose(const PSMovePose &pose);
     void Publish(PSMoveProtocol::DeviceInputDataFrame_ControllerDataPacket *data_frame);
 
     void SetRumble(float rumbleFraction);
@@ -533,6 +534,7 @@ private:
 public:
     void Clear();
     void ApplyControllerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *data_frame);
+    void ApplyPresentedPose(const PSMovePose &pose);
     void Publish(PSMoveProtocol::DeviceInputDataFrame_ControllerDataPacket *data_frame);
 
     void SetBigRumble(float rumbleFraction);
@@ -731,6 +733,16 @@ public:
     const PSMoveRawTrackerData &GetRawTrackerData() const;
 };
 
+/// How a controller's data frames are arriving, as seen by its jitter buffer
+struct CLIENTPSMOVEAPI ClientControllerJitterBufferStatistics
+{
+    int BufferedFrameCount;     ///< Frames received but not presented yet
+    int LateFrameCount;         ///< Frames dropped for arriving after a newer frame was presented
+    int MissingFrameCount;      ///< Data frames lost on the way (frames a rate capped or change-only stream leaves out don't count)
+    int ExtrapolatedPoseCount;  ///< Poses presented past the newest frame
+    float JitterMilliseconds;   ///< Smoothed variation in how long data frames take to arrive
+};
+
 class CLIENTPSMOVEAPI ClientControllerView
 {
 public:
@@ -761,13 +773,36 @@ private:
     long long data_frame_last_received_time;
     float data_frame_average_fps;
 
+    // Only allocated while the jitter buffer is enabled
+    class ClientControllerJitterBuffer *jitter_buffer;
+
+    void ApplyControllerDataFrameToView(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *data_frame);
+
 public:
     ClientControllerView(int ControllerID);
+    ~ClientControllerView();
 
     void Clear();
     void ApplyControllerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *data_frame);
     void Publish();
 
+    // Jitter Buffer
+    /// Holds data frames back by delay_milliseconds and presents them in sequence order, 
+    /// with the pose interpolated between frames so network and scheduling jitter doesn't show up as judder.
+    /// Past the newest frame the pose is extrapolated from its velocities (streams with includePhysicsData).
+    void EnableJitterBuffer(float delay_milliseconds);
+    /// Applies any frames still buffered
+    void DisableJitterBuffer();
+    inline bool GetIsJitterBufferEnabled() const
+    {
+        return jitter_buffer != nullptr;
+    }
+    /// Called by ClientPSMoveAPI::update() with no offset. Call it again after update() 
+    /// to present the controller as of the time the frame being rendered will be displayed,
+    /// given as an offset from now.
+    void PresentJitterBuffer(float render_time_offset_milliseconds);
+    bool GetJitterBufferStatistics(ClientControllerJitterBufferStatistics &out_statistics) const;
+
     // Listener State
     inline void IncListenerCount()
     {
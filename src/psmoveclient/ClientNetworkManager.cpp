@@ -63,8 +63,17 @@ public:
         , m_response_listener(responseListener)
         , m_netEventListener(netEventListener)
         , m_pending_requests()
+
+        , m_multicast_socket(m_io_service)
+        , m_multicast_sender_endpoint()
+        , m_multicast_group_address()
+        , m_multicast_group_port(0)
+        , m_has_pending_multicast_read(false)
+        , m_packed_multicast_data_frame(std::shared_ptr<PSMoveProtocol::DeviceOutputDataFrame>(new PSMoveProtocol::DeviceOutputDataFrame()))
+        , m_multicast_controller_subscriptions()
     {
         memset(m_output_data_frame_buffer, 0, sizeof(m_output_data_frame_buffer));
+        memset(m_multicast_data_frame_buffer, 0, sizeof(m_multicast_data_frame_buffer));
     }
 
     bool start()
@@ -93,6 +102,78 @@ public:
         start_udp_queued_data_frame_write();
     }
 
+    bool join_multicast_group(const std::string &group_address, int group_port)
+    {
+        if (m_multicast_socket.is_open())
+        {
+            if (group_address == m_multicast_group_address && group_port == m_multicast_group_port)
+            {
+                return true;
+            }
+
+            // The service moved its multicast group
+            close_multicast_socket();
+        }
+
+        boost::system::error_code error;
+        const asio::ip::address group = asio::ip::address::from_string(group_address, error);
+
+        if (!error && !group.is_multicast())
+        {
+            error = asio::error::invalid_argument;
+        }
+        if (!error)
+        {
+            m_multicast_socket.open(udp::v4(), error);
+        }
+        if (!error)
+        {
+            // Let other clients on this machine join the same group
+            m_multicast_socket.set_option(udp::socket::reuse_address(true), error);
+        }
+        if (!error)
+        {
+            m_multicast_socket.bind(udp::endpoint(udp::v4(), static_cast<unsigned short>(group_port)), error);
+        }
+        if (!error)
+        {
+            m_multicast_socket.set_option(asio::ip::multicast::join_group(group), error);
+        }
+
+        if (!error)
+        {
+            CLIENT_LOG_INFO("ClientNetworkManager::join_multicast_group") 
+                << "Joined multicast group " << group_address << ":" << group_port << std::endl;
+
+            m_multicast_group_address = group_address;
+            m_multicast_group_port = group_port;
+            start_multicast_read_data_frame();
+        }
+        else
+        {
+            CLIENT_LOG_ERROR("ClientNetworkManager::join_multicast_group") 
+                << "Failed to join multicast group " << group_address << ":" << group_port 
+                << ": " << error.message() << std::endl;
+
+            close_multicast_socket();
+        }
+
+        return !error;
+    }
+
+    void set_multicast_controller_subscription(int controller_id, bool subscribed)
+    {
+        if (controller_id >= 0)
+        {
+            if (controller_id >= static_cast<int>(m_multicast_controller_subscriptions.size()))
+            {
+                m_multicast_controller_subscriptions.resize(controller_id + 1, false);
+            }
+
+            m_multicast_controller_subscriptions[controller_id] = subscribed;
+        }
+    }
+
     void poll()
     {
         bool keep_polling = true;
@@ -165,6 +246,8 @@ public:
             }
         }
 
+        close_multicast_socket();
+
         m_connection_stopped= true;
         m_has_pending_tcp_read= false;
         m_has_pending_tcp_write= false;
@@ -715,6 +798,91 @@ private:
         }
     }
 
+    void close_multicast_socket()
+    {
+        if (m_multicast_socket.is_open())
+        {
+            // Closing the socket also leaves the group
+            boost::system::error_code close_error;
+            m_multicast_socket.close(close_error);
+        }
+
+        m_multicast_group_address.clear();
+        m_multicast_group_port = 0;
+        m_has_pending_multicast_read = false;
+    }
+
+    void start_multicast_read_data_frame()
+    {
+        if (!m_has_pending_multicast_read)
+        {
+            m_has_pending_multicast_read= true;
+            m_multicast_socket.async_receive_from(
+                asio::buffer(m_multicast_data_frame_buffer, sizeof(m_multicast_data_frame_buffer)),
+                m_multicast_sender_endpoint,
+                boost::bind(
+                    &ClientNetworkManagerImpl::handle_multicast_read_data_frame, 
+                    this,
+                    asio::placeholders::error));
+        }
+    }
+
+    void handle_multicast_read_data_frame(const boost::system::error_code& error)
+    {
+        // The socket was closed out from under the read
+        if (m_connection_stopped || !m_has_pending_multicast_read)
+            return;
+
+        m_has_pending_multicast_read= false;
+
+        if (!error)
+        {
+            handle_multicast_data_frame_received();
+
+            // Start reading the next incoming data frame
+            start_multicast_read_data_frame();
+        }
+        else
+        {
+            // The tcp connection (and unicast streams) are still fine, so only give up on the group
+            CLIENT_LOG_ERROR("ClientNetworkManager::handle_multicast_read_data_frame") 
+                << "Error on multicast receive: "  << error.message() << std::endl;
+            close_multicast_socket();
+        }
+    }
+
+    // Every client in the group gets every multicast data frame,
+    // so only forward the ones for controllers this client subscribed to.
+    void handle_multicast_data_frame_received()
+    {
+        unsigned msg_len = m_packed_multicast_data_frame.decode_header(m_multicast_data_frame_buffer, sizeof(m_multicast_data_frame_buffer));
+        unsigned total_len= HEADER_SIZE+msg_len;
+
+        if (total_len <= sizeof(m_multicast_data_frame_buffer) &&
+            m_packed_multicast_data_frame.unpack(m_multicast_data_frame_buffer, total_len))
+        {
+            DeviceOutputDataFramePtr data_frame = m_packed_multicast_data_frame.get_msg();
+
+            if (data_frame->device_category() == PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER)
+            {
+                const int controller_id = data_frame->controller_data_packet().controller_id();
+
+                if (controller_id >= 0 && 
+                    controller_id < static_cast<int>(m_multicast_controller_subscriptions.size()) &&
+                    m_multicast_controller_subscriptions[controller_id])
+                {
+                    m_data_frame_listener->handle_data_frame(data_frame);
+                }
+            }
+        }
+        else
+        {
+            // Anyone can send to a multicast group, so drop malformed frames rather than disconnecting
+            CLIENT_LOG_WARNING("ClientNetworkManager::handle_multicast_data_frame_received") 
+                << "Ignoring malformed multicast data frame from " << m_multicast_sender_endpoint << std::endl;
+        }
+    }
+
 private:
     const std::string &m_server_host;
     const std::string &m_server_port;
@@ -753,6 +921,19 @@ private:
 
     deque<RequestPtr> m_pending_requests;
     deque<DeviceInputDataFramePtr> m_pending_data_frames;
+
+    // Only open after joining the service's multicast group
+    udp::socket m_multicast_socket;
+    udp::endpoint m_multicast_sender_endpoint;
+    std::string m_multicast_group_address;
+    int m_multicast_group_port;
+    bool m_has_pending_multicast_read;
+
+    uint8_t m_multicast_data_frame_buffer[HEADER_SIZE+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
+    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> m_packed_multicast_data_frame;
+
+    // Indexed by controller id
+    vector<bool> m_multicast_controller_subscriptions;
 };
 
 // -ClientNetworkManager-
@@ -800,6 +981,16 @@ void ClientNetworkManager::send_device_data_frame(DeviceInputDataFramePtr data_f
     m_implementation_ptr->send_device_data_frame(data_frame);
 }
 
+bool ClientNetworkManager::join_multicast_group(const std::string &group_address, int group_port)
+{
+    return m_implementation_ptr->join_multicast_group(group_address, group_port);
+}
+
+void ClientNetworkManager::set_multicast_controller_subscription(int controller_id, bool subscribed)
+{
+    m_implementation_ptr->set_multicast_controller_subscription(controller_id, subscribed);
+}
+
 void ClientNetworkManager::update()
 {
     m_implementation_ptr->poll();
@@ -25,6 +25,13 @@ public:
     bool startup();
     void send_request(RequestPtr request);
     void send_device_data_frame(DeviceInputDataFramePtr data_frame);
+
+    // Starts listening to the service's multicast group (see RequestStartPSMoveDataStream::use_multicast).
+    // Rejoining the group already joined is a no-op.
+    bool join_multicast_group(const std::string &group_address, int group_port);
+    // Multicast data frames are only forwarded for the controllers subscribed to here
+    void set_multicast_controller_subscription(int controller_id, bool subscribed);
+
     void update();
     void shutdown();
 
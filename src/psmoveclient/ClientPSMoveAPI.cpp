@@ -88,6 +88,24 @@ public:
 
         // Process incoming/outgoing networking requests
         m_network_manager.update();
+
+        // Present whatever buffered controller data frames have come due
+        present_jitter_buffers();
+    }
+
+    void present_jitter_buffers()
+    {
+        for (t_controller_view_map_iterator view_entry = m_controller_view_map.begin();
+            view_entry != m_controller_view_map.end();
+            ++view_entry)
+        {
+            ClientControllerView *controllerView= view_entry->second;
+
+            if (controllerView->GetIsJitterBufferEnabled())
+            {
+                controllerView->PresentJitterBuffer(0.f);
+            }
+        }
     }
 
     void publish()
@@ -208,7 +226,10 @@ public:
         return request->request_id();
     }
 
-    ClientPSMoveAPI::t_request_id start_controller_data_stream(ClientControllerView * view, unsigned int flags)
+    ClientPSMoveAPI::t_request_id start_controller_data_stream(
+        ClientControllerView * view, 
+        unsigned int flags,
+        const ClientPSMoveAPI::ControllerDataStreamRateOptions *rate_options)
     {
         CLIENT_LOG_INFO("start_controller_data_stream") << "requesting controller stream start for ControllerID: " << view->GetControllerID() << std::endl;
 
@@ -242,6 +263,21 @@ public:
             request->mutable_request_start_psmove_data_stream()->set_include_physics_data(true);
         }
 
+        if ((flags & ClientPSMoveAPI::useMulticast) > 0)
+        {
+            request->mutable_request_start_psmove_data_stream()->set_use_multicast(true);
+        }
+
+        if (rate_options != nullptr)
+        {
+            auto *stream_request= request->mutable_request_start_psmove_data_stream();
+
+            stream_request->set_max_publish_rate_hz(rate_options->max_publish_rate_hz);
+            stream_request->set_publish_on_change_only(rate_options->publish_on_change_only);
+            stream_request->set_position_change_threshold_cm(rate_options->position_change_threshold_cm);
+            stream_request->set_orientation_change_threshold_deg(rate_options->orientation_change_threshold_deg);
+        }
+
         m_request_manager.send_request(request);
 
         return request->request_id();
@@ -256,6 +292,9 @@ public:
         request->set_type(PSMoveProtocol::Request_RequestType_STOP_CONTROLLER_DATA_STREAM);
         request->mutable_request_stop_psmove_data_stream()->set_controller_id(view->GetControllerID());
 
+        // Stop forwarding the controller's multicast data frames right away
+        m_network_manager.set_multicast_controller_subscription(view->GetControllerID(), false);
+
         m_request_manager.send_request(request);
 
         return request->request_id();
@@ -358,7 +397,10 @@ public:
         return request->request_id();
     }
 
-    ClientPSMoveAPI::t_request_id start_tracker_data_stream(ClientTrackerView *view)
+    ClientPSMoveAPI::t_request_id start_tracker_data_stream(
+        ClientTrackerView *view,
+        const ClientPSMoveAPI::TrackerColorMaskPreviewOptions *mask_preview_options,
+        const ClientPSMoveAPI::TrackerNetworkVideoOptions *network_video_options)
     {
         CLIENT_LOG_INFO("start_tracker_data_stream") << "requesting tracker stream start for TrackerID: " << view->getTrackerId() << std::endl;
 
@@ -367,6 +409,30 @@ public:
         request->set_type(PSMoveProtocol::Request_RequestType_START_TRACKER_DATA_STREAM);
         request->mutable_request_start_tracker_data_stream()->set_tracker_id(view->getTrackerId());
 
+        if (mask_preview_options != nullptr)
+        {
+            auto *stream_request= request->mutable_request_start_tracker_data_stream();
+
+            stream_request->set_include_color_mask_preview(true);
+            stream_request->set_mask_tracking_color(
+                static_cast<PSMoveProtocol::TrackingColorType>(mask_preview_options->tracking_color));
+            stream_request->set_mask_controller_id(mask_preview_options->controller_id);
+            stream_request->set_mask_downscale(mask_preview_options->downscale);
+        }
+
+        if (network_video_options != nullptr)
+        {
+            auto *stream_request= request->mutable_request_start_tracker_data_stream();
+
+            stream_request->set_include_network_video(true);
+            stream_request->set_network_video_max_rate_hz(network_video_options->max_rate_hz);
+            stream_request->set_network_video_downscale(network_video_options->downscale);
+            stream_request->set_network_video_jpeg_quality(network_video_options->jpeg_quality);
+        }
+
+        // Lets the view fall back to the network video if it can't open the shared memory
+        view->setNetworkVideoRequested(network_video_options != nullptr);
+
         m_request_manager.send_request(request);
 
         return request->request_id();
@@ -454,7 +520,18 @@ public:
         case PSMoveProtocol::Response_ResponseType_TRACKER_LIST_UPDATED:
             specificEventType = ClientPSMoveAPI::trackerListUpdated;
             break;
+        case PSMoveProtocol::Response_ResponseType_TRACKER_VIDEO_FRAME:
+            {
+                // Video frames go straight to the tracker view rather than through the event queue
+                const PSMoveProtocol::Response_ResultTrackerVideoFrame &video_frame = 
+                    notification->result_tracker_video_frame();
+                t_tracker_view_map_iterator view_entry = m_tracker_view_map.find(video_frame.tracker_id());
 
+                if (view_entry != m_tracker_view_map.end())
+                {
+                    view_entry->second->applyNetworkVideoFrame(&video_frame);
+                }
+            } return;
         }
 
         enqueue_event_message(specificEventType, notification);
@@ -501,6 +578,17 @@ public:
 
         if (response_message->request_id != ClientPSMoveAPI::INVALID_REQUEST_ID)
         {
+            const PSMoveProtocol::Request *request = 
+                reinterpret_cast<const PSMoveProtocol::Request *>(response_message->opaque_request_handle);
+
+            if (request->type() == PSMoveProtocol::Request_RequestType_START_CONTROLLER_DATA_STREAM &&
+                response_message->result_code == ClientPSMoveAPI::_clientPSMoveResultCode_ok)
+            {
+                this_ptr->handle_controller_data_stream_started(
+                    request->request_start_psmove_data_stream().controller_id(),
+                    reinterpret_cast<const PSMoveProtocol::Response *>(response_message->opaque_response_handle));
+            }
+
             // If there is a callback waiting to be called for this request,
             // then go ahead and execute it now.
             if (!this_ptr->execute_callback(response_message))
@@ -512,6 +600,25 @@ public:
         }
     }
 
+    // Listen to the service's multicast group if it's sending the controller's data frames there
+    void handle_controller_data_stream_started(int controller_id, const PSMoveProtocol::Response *response)
+    {
+        const PSMoveProtocol::Response_ResultControllerDataStreamStarted &stream_result =
+            response->result_controller_data_stream_started();
+        bool bMulticast = !stream_result.multicast_group_address().empty();
+
+        if (bMulticast &&
+            !m_network_manager.join_multicast_group(stream_result.multicast_group_address(), stream_result.multicast_port()))
+        {
+            CLIENT_LOG_ERROR("handle_controller_data_stream_started") 
+                << "Can't receive ControllerID " << controller_id 
+                << " data frames without joining the multicast group. Restart the stream without useMulticast." << std::endl;
+            bMulticast = false;
+        }
+
+        m_network_manager.set_multicast_controller_subscription(controller_id, bMulticast);
+    }
+
     // Message Helpers
     //-----------------
     void enqueue_event_message(
@@ -759,13 +866,14 @@ ClientPSMoveAPI::get_controller_list()
 ClientPSMoveAPI::t_request_id 
 ClientPSMoveAPI::start_controller_data_stream(
     ClientControllerView * view, 
-    unsigned int flags)
+    unsigned int flags,
+    const ControllerDataStreamRateOptions *rate_options)
 {
     ClientPSMoveAPI::t_request_id request_id= ClientPSMoveAPI::INVALID_REQUEST_ID;
 
     if (ClientPSMoveAPI::m_implementation_ptr != nullptr)
     {
-        request_id= ClientPSMoveAPI::m_implementation_ptr->start_controller_data_stream(view, flags);
+        request_id= ClientPSMoveAPI::m_implementation_ptr->start_controller_data_stream(view, flags, rate_options);
     }
 
     return request_id;
@@ -851,13 +959,16 @@ ClientPSMoveAPI::get_tracker_list()
 }
 
 ClientPSMoveAPI::t_request_id 
-ClientPSMoveAPI::start_tracker_data_stream(ClientTrackerView *view)
+ClientPSMoveAPI::start_tracker_data_stream(
+    ClientTrackerView *view,
+    const TrackerColorMaskPreviewOptions *mask_preview_options,
+    const TrackerNetworkVideoOptions *network_video_options)
 {
     ClientPSMoveAPI::t_request_id request_id = ClientPSMoveAPI::INVALID_REQUEST_ID;
 
     if (ClientPSMoveAPI::m_implementation_ptr != nullptr)
     {
-        request_id = ClientPSMoveAPI::m_implementation_ptr->start_tracker_data_stream(view);
+        request_id = ClientPSMoveAPI::m_implementation_ptr->start_tracker_data_stream(view, mask_preview_options, network_video_options);
     }
 
     return request_id;
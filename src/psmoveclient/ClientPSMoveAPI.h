@@ -42,7 +42,35 @@ public:
         includePhysicsData = 0x02,
         includeRawSensorData = 0x04,
         includeCalibratedSensorData = 0x08,
-        includeRawTrackerData = 0x10
+        includeRawTrackerData = 0x10,
+        useMulticast = 0x20 ///< Receive the data frames over the service's multicast group, if it has one enabled
+    };
+
+    /// Optional limits on how often the service sends controller data frames to this client
+    struct ControllerDataStreamRateOptions
+    {
+        float max_publish_rate_hz;              ///< 0 = every controller update
+        bool publish_on_change_only;            ///< Skip frames when nothing meaningful changed
+        float position_change_threshold_cm;     ///< Used when publish_on_change_only is set
+        float orientation_change_threshold_deg; ///< Used when publish_on_change_only is set
+    };
+
+    /// Asks the service to also stream its tracking color mask for a tracker (used for color calibration)
+    struct TrackerColorMaskPreviewOptions
+    {
+        PSMoveTrackingColorType tracking_color; ///< Color preset to threshold the video frame with
+        int controller_id;                      ///< Use this controller's color presets (-1 = the tracker's)
+        int downscale;                          ///< Mask resolution divisor (1-8), keeps the stream small
+    };
+
+    /// Asks the service to also send JPEG compressed video frames over the network,
+    /// for clients that can't open the tracker's shared memory video stream (i.e. on another machine).
+    /// These settings are shared by every client streaming the tracker's video. 0 = service default.
+    struct TrackerNetworkVideoOptions
+    {
+        float max_rate_hz;  ///< Most video frames per second to send
+        int downscale;      ///< Video resolution divisor (1-8)
+        int jpeg_quality;   ///< 1-100
     };
 
     enum eControllerRumbleChannel
@@ -105,6 +133,10 @@ public:
     {
         int controller_id[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
         ClientControllerView::eControllerType controller_type[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+        unsigned int dropped_report_count[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+        float packet_loss_fraction[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+        float report_rate[PSMOVESERVICE_MAX_CONTROLLER_COUNT]; // reports per second
+        float optical_capture_skew[PSMOVESERVICE_MAX_CONTROLLER_COUNT]; // ms corrected between tracker observations
         int count;
     };
 
@@ -190,7 +222,10 @@ public:
     static void free_controller_view(ClientControllerView *view);
 
     static t_request_id get_controller_list();
-    static t_request_id start_controller_data_stream(ClientControllerView *view, unsigned int data_stream_flags);
+    static t_request_id start_controller_data_stream(
+        ClientControllerView *view, 
+        unsigned int data_stream_flags,
+        const ControllerDataStreamRateOptions *rate_options= nullptr);
     static t_request_id stop_controller_data_stream(ClientControllerView *view);
     static t_request_id set_led_tracking_color(ClientControllerView *view, PSMoveTrackingColorType tracking_color);
     static t_request_id reset_pose(ClientControllerView *view, const PSMoveQuaternion& q_pose);
@@ -200,7 +235,10 @@ public:
     static void free_tracker_view(ClientTrackerView *view);
 
     static t_request_id get_tracker_list();
-    static t_request_id start_tracker_data_stream(ClientTrackerView *view);
+    static t_request_id start_tracker_data_stream(
+        ClientTrackerView *view,
+        const TrackerColorMaskPreviewOptions *mask_preview_options= nullptr,
+        const TrackerNetworkVideoOptions *network_video_options= nullptr);
     static t_request_id stop_tracker_data_stream(ClientTrackerView *view);
 
     /// Used to send requests to the server by clients that have protocol access
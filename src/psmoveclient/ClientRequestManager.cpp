@@ -204,6 +204,20 @@ public:
                 // Add an entry to the controller list
                 controller_list->controller_type[dest_controller_count] = controllerType;
                 controller_list->controller_id[dest_controller_count] = ControllerResponse.controller_id();
+
+                // Report statistics
+                {
+                    const unsigned int received_count= ControllerResponse.received_report_count();
+                    const unsigned int dropped_count= ControllerResponse.dropped_report_count();
+                    const unsigned int expected_count= received_count + dropped_count;
+
+                    controller_list->dropped_report_count[dest_controller_count] = dropped_count;
+                    controller_list->packet_loss_fraction[dest_controller_count] =
+                        (expected_count > 0) ? static_cast<float>(dropped_count) / static_cast<float>(expected_count) : 0.f;
+                    controller_list->report_rate[dest_controller_count] = ControllerResponse.report_rate();
+                }
+
+                controller_list->optical_capture_skew[dest_controller_count] = ControllerResponse.optical_capture_skew();
                 ++dest_controller_count;
             }
 
@@ -250,6 +264,9 @@ public:
             case PSMoveProtocol::TrackerType::PS3EYE:
                 TrackerInfo.tracker_type = eTrackerType::PS3Eye;
                 break;
+            case PSMoveProtocol::TrackerType::REMOTE_TRACKER:
+                TrackerInfo.tracker_type = eTrackerType::RemoteTracker;
+                break;
             default:
                 assert(0 && "unreachable");
             }
@@ -268,6 +285,9 @@ public:
             case PSMoveProtocol::TrackerDriver::GENERIC_WEBCAM:
                 TrackerInfo.tracker_driver = eTrackerDriver::GENERIC_WEBCAM;
                 break;
+            case PSMoveProtocol::TrackerDriver::NETWORK:
+                TrackerInfo.tracker_driver = eTrackerDriver::NETWORK;
+                break;
             default:
                 assert(0 && "unreachable");
             }
@@ -296,6 +316,10 @@ public:
 
             TrackerInfo.tracker_pose= protocol_pose_to_psmove_pose(TrackerResponse.tracker_pose());
 
+            TrackerInfo.frame_rate = TrackerResponse.frame_rate();
+            TrackerInfo.frame_interval_jitter = TrackerResponse.frame_interval_jitter();
+            TrackerInfo.frame_latency = TrackerResponse.frame_latency();
+
             ++tracker_count;
         }
 
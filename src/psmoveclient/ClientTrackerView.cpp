@@ -1,9 +1,11 @@
 //-- includes -----
 #include "ClientTrackerView.h"
 #include "ClientLog.h"
+#include "ColorMaskRunLength.h"
 #include "MathGLM.h"
 #include "PSMoveProtocol.pb.h"
 #include "SharedTrackerState.h"
+#include <algorithm>
 #include <assert.h>
 #include <chrono>
 #include <sstream>
@@ -11,10 +13,19 @@
 #include <boost/interprocess/mapped_region.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
 #include <memory>
+#include <vector>
+
+// Only used to decode the network video stream, kept private to this library
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_JPEG
+#include "stb_image.h"
 
 //-- pre-declarations -----
 
 //-- constants -----
+// A mask frame sequence number this far behind the current one means the service restarted the stream
+static const int k_color_mask_sequence_restart_threshold = 30;
 
 //-- prototypes ----
 
@@ -112,7 +123,8 @@ public:
 
         // Make sure the shared memory is the size we expect
         size_t total_shared_mem_size =
-            SharedVideoFrameHeader::computeTotalSize(sharedFrameState->stride, sharedFrameState->height);
+            SharedVideoFrameHeader::computeTotalSize(
+                sharedFrameState->stride, sharedFrameState->height, sharedFrameState->slot_count);
         assert(m_region->get_size() >= total_shared_mem_size);
 
         // Re-allocate the buffer if any of the video properties changed
@@ -187,10 +199,199 @@ private:
     int m_last_frame_index;
 };
 
+//-- ClientColorMaskPreview -----
+// Reassembles the color mask the service splits by rows across tracker data frames.
+// Rows from an older mask than the one being assembled are dropped,
+// so a lost packet just leaves the previous mask's rows in place for a frame.
+class ClientColorMaskPreview
+{
+public:
+    ClientColorMaskPreview()
+        : m_mask()
+        , m_width(0)
+        , m_height(0)
+        , m_downscale(1)
+        , m_frame_sequence_num(-1)
+        , m_has_new_rows(false)
+    {
+        memset(&m_statistics, 0, sizeof(m_statistics));
+    }
+
+    void applyColorMaskPacket(const PSMoveProtocol::DeviceOutputDataFrame_TrackerDataPacket_ColorMaskPreview &packet)
+    {
+        const int width = packet.mask_width();
+        const int height = packet.mask_height();
+        const int frame_sequence_num = packet.frame_sequence_num();
+        const int start_row = packet.start_row();
+        const int row_count = packet.row_count();
+
+        if (width <= 0 || height <= 0 ||
+            start_row < 0 || row_count <= 0 || start_row + row_count > height)
+        {
+            return;
+        }
+
+        if (width != m_width || height != m_height)
+        {
+            m_mask.assign(static_cast<size_t>(width)*static_cast<size_t>(height), 0);
+            m_width = width;
+            m_height = height;
+        }
+        else if (frame_sequence_num < m_frame_sequence_num &&
+                 frame_sequence_num > m_frame_sequence_num - k_color_mask_sequence_restart_threshold)
+        {
+            // Late rows of a mask we've already moved past
+            return;
+        }
+
+        if (!ColorMaskRunLength::decodeRows(packet.row_runs(), width, row_count, m_mask.data() + start_row*width, width))
+        {
+            CLIENT_LOG_WARNING("ClientColorMaskPreview") << "Dropping malformed color mask rows";
+            return;
+        }
+
+        m_frame_sequence_num = frame_sequence_num;
+        m_downscale = packet.downscale();
+        m_statistics.blob_count = packet.blob_count();
+        m_statistics.masked_pixel_count = packet.masked_pixel_count();
+        m_statistics.largest_blob_area = packet.largest_blob_area();
+        m_statistics.largest_blob_center =
+            PSMoveFloatVector2::create(packet.largest_blob_center().x(), packet.largest_blob_center().y());
+        m_statistics.largest_blob_min =
+            PSMoveFloatVector2::create(packet.largest_blob_min().x(), packet.largest_blob_min().y());
+        m_statistics.largest_blob_max =
+            PSMoveFloatVector2::create(packet.largest_blob_max().x(), packet.largest_blob_max().y());
+        m_has_new_rows = true;
+    }
+
+    bool takeHasNewRows()
+    {
+        const bool bHasNewRows = m_has_new_rows;
+        m_has_new_rows = false;
+        return bHasNewRows;
+    }
+
+    inline const unsigned char *getMaskBuffer() const { return m_mask.empty() ? nullptr : m_mask.data(); }
+    inline int getWidth() const { return m_width; }
+    inline int getHeight() const { return m_height; }
+    inline int getDownscale() const { return m_downscale; }
+    inline const ClientColorMaskStatistics &getStatistics() const { return m_statistics; }
+
+private:
+    std::vector<unsigned char> m_mask;
+    int m_width, m_height;
+    int m_downscale;
+    int m_frame_sequence_num;
+    bool m_has_new_rows;
+    ClientColorMaskStatistics m_statistics;
+};
+
+//-- NetworkVideoFrameReader -----
+// Decodes the JPEG video frames sent to a network video stream back into full size BGR frames,
+// so they read just like the frames in shared memory.
+// Only the latest frame received gets decoded, and only once someone polls for it.
+class NetworkVideoFrameReader
+{
+public:
+    NetworkVideoFrameReader(int frame_width, int frame_height)
+        : m_bgr_frame_buffer()
+        , m_frame_width(0)
+        , m_frame_height(0)
+        , m_jpeg_data()
+        , m_jpeg_frame_width(frame_width)
+        , m_jpeg_frame_height(frame_height)
+        , m_has_new_jpeg_frame(false)
+    {
+        resizeVideoBuffer(frame_width, frame_height);
+    }
+
+    void applyVideoFrame(const PSMoveProtocol::Response_ResultTrackerVideoFrame &video_frame)
+    {
+        m_jpeg_data = video_frame.jpeg_data();
+        m_jpeg_frame_width = video_frame.frame_width();
+        m_jpeg_frame_height = video_frame.frame_height();
+        m_has_new_jpeg_frame = true;
+    }
+
+    bool readVideoFrame()
+    {
+        bool bNewFrame = false;
+
+        if (m_has_new_jpeg_frame)
+        {
+            int jpeg_width, jpeg_height, jpeg_channels;
+            unsigned char *rgb_buffer =
+                stbi_load_from_memory(
+                    reinterpret_cast<const stbi_uc *>(m_jpeg_data.data()), static_cast<int>(m_jpeg_data.size()),
+                    &jpeg_width, &jpeg_height, &jpeg_channels, 3);
+
+            m_has_new_jpeg_frame = false;
+
+            if (rgb_buffer != nullptr)
+            {
+                if (m_jpeg_frame_width != m_frame_width || m_jpeg_frame_height != m_frame_height)
+                {
+                    resizeVideoBuffer(m_jpeg_frame_width, m_jpeg_frame_height);
+                }
+
+                // Scale the downscaled frame back up (nearest neighbor) and swap RGB to BGR
+                for (int y = 0; y < m_frame_height; ++y)
+                {
+                    const unsigned char *src_row = rgb_buffer + (y * jpeg_height / m_frame_height) * jpeg_width * 3;
+                    unsigned char *dst_pixel = m_bgr_frame_buffer.data() + y * m_frame_width * 3;
+
+                    for (int x = 0; x < m_frame_width; ++x)
+                    {
+                        const unsigned char *src_pixel = src_row + (x * jpeg_width / m_frame_width) * 3;
+
+                        dst_pixel[0] = src_pixel[2];
+                        dst_pixel[1] = src_pixel[1];
+                        dst_pixel[2] = src_pixel[0];
+                        dst_pixel += 3;
+                    }
+                }
+
+                stbi_image_free(rgb_buffer);
+                bNewFrame = true;
+            }
+            else
+            {
+                CLIENT_LOG_WARNING("NetworkVideoFrameReader::readVideoFrame()") << "Failed to decode video frame: " << stbi_failure_reason();
+            }
+        }
+
+        return bNewFrame;
+    }
+
+    inline const unsigned char *getVideoFrameBuffer() const { return m_bgr_frame_buffer.empty() ? nullptr : m_bgr_frame_buffer.data(); }
+    inline int getVideoFrameWidth() const { return m_frame_width; }
+    inline int getVideoFrameHeight() const { return m_frame_height; }
+    inline int getVideoFrameStride() const { return m_frame_width * 3; }
+
+private:
+    void resizeVideoBuffer(int frame_width, int frame_height)
+    {
+        m_frame_width = std::max(frame_width, 0);
+        m_frame_height = std::max(frame_height, 0);
+        m_bgr_frame_buffer.assign(static_cast<size_t>(m_frame_width) * static_cast<size_t>(m_frame_height) * 3, 0);
+    }
+
+    std::vector<unsigned char> m_bgr_frame_buffer;
+    int m_frame_width, m_frame_height;
+
+    // Latest compressed frame received
+    std::string m_jpeg_data;
+    int m_jpeg_frame_width, m_jpeg_frame_height;
+    bool m_has_new_jpeg_frame;
+};
+
 // -- ClientTrackerView ------
 ClientTrackerView::ClientTrackerView(const ClientTrackerInfo &trackerInfo)
     : m_tracker_info(trackerInfo)
     , m_shared_memory_accesor(nullptr)
+    , m_color_mask_preview(nullptr)
+    , m_network_video_reader(nullptr)
+    , m_network_video_requested(false)
     , m_listener_count(0)
     , m_is_connected(false)
 {
@@ -200,6 +401,12 @@ ClientTrackerView::ClientTrackerView(const ClientTrackerInfo &trackerInfo)
 ClientTrackerView::~ClientTrackerView()
 {
     closeVideoStream();
+
+    if (m_color_mask_preview != nullptr)
+    {
+        delete m_color_mask_preview;
+        m_color_mask_preview = nullptr;
+    }
 }
 
 void ClientTrackerView::applyTrackerDataFrame(
@@ -207,6 +414,24 @@ void ClientTrackerView::applyTrackerDataFrame(
 {
     assert(data_frame->tracker_id() == getTrackerId());
 
+    // Mask rows are split across data frames that share a sequence number,
+    // so they have to be applied ahead of the sequence number check below
+    if (data_frame->has_color_mask_preview())
+    {
+        if (m_color_mask_preview == nullptr)
+        {
+            m_color_mask_preview = new ClientColorMaskPreview();
+        }
+
+        m_color_mask_preview->applyColorMaskPacket(data_frame->color_mask_preview());
+
+        // Only count the first chunk of each mask towards the data frame rate
+        if (data_frame->color_mask_preview().start_row() > 0)
+        {
+            return;
+        }
+    }
+
     // Compute the data frame receive window statistics if we have received enough samples
     {
         long long now =
@@ -233,6 +458,7 @@ void ClientTrackerView::applyTrackerDataFrame(
         switch (data_frame->tracker_type())
         {
         case PSMoveProtocol::PS3EYE:
+        case PSMoveProtocol::REMOTE_TRACKER:
         {
             //this->ControllerViewType = PSMove;
             //this->ViewState.PSMoveView.ApplyControllerDataFrame(data_frame);
@@ -244,6 +470,18 @@ void ClientTrackerView::applyTrackerDataFrame(
     }
 }
 
+void ClientTrackerView::applyNetworkVideoFrame(
+    const PSMoveProtocol::Response_ResultTrackerVideoFrame *video_frame)
+{
+    assert(video_frame->tracker_id() == getTrackerId());
+
+    // Frames that arrive before (or after) the video stream is open are of no use to anyone
+    if (m_network_video_reader != nullptr)
+    {
+        m_network_video_reader->applyVideoFrame(*video_frame);
+    }
+}
+
 void ClientTrackerView::clearTrackerDataFrameState()
 {
     m_sequence_num= 0;
@@ -256,7 +494,7 @@ bool ClientTrackerView::openVideoStream()
 {
     bool bSuccess = false;
 
-    if (m_shared_memory_accesor == nullptr)
+    if (m_shared_memory_accesor == nullptr && m_network_video_reader == nullptr)
     {
         m_shared_memory_accesor = new SharedVideoFrameReadOnlyAccessor();
 
@@ -264,6 +502,23 @@ bool ClientTrackerView::openVideoStream()
         {
             bSuccess = m_shared_memory_accesor->readVideoFrame();
         }
+
+        if (!bSuccess)
+        {
+            closeVideoStream();
+
+            if (m_network_video_requested)
+            {
+                CLIENT_LOG_INFO("ClientTrackerView::openVideoStream()") << "Using the network video stream for tracker " << getTrackerId();
+
+                // The network frames are scaled back up to the full video frame size
+                m_network_video_reader = 
+                    new NetworkVideoFrameReader(
+                        static_cast<int>(m_tracker_info.tracker_screen_dimensions.i),
+                        static_cast<int>(m_tracker_info.tracker_screen_dimensions.j));
+                bSuccess = true;
+            }
+        }
     }
     else
     {
@@ -271,12 +526,29 @@ bool ClientTrackerView::openVideoStream()
         bSuccess = true;
     }
 
-    if (!bSuccess)
+    return bSuccess;
+}
+
+bool ClientTrackerView::getIsSharedMemoryVideoStreamAvailable() const
+{
+    bool bAvailable = false;
+
+    try
     {
-        closeVideoStream();
+        // The service creates the shared memory when it opens the tracker, before anyone streams from it
+        boost::interprocess::shared_memory_object shared_memory_object(
+            boost::interprocess::open_only,
+            m_tracker_info.shared_memory_name,
+            boost::interprocess::read_only);
+
+        bAvailable = true;
+    }
+    catch (boost::interprocess::interprocess_exception &)
+    {
+        bAvailable = false;
     }
 
-    return bSuccess;
+    return bAvailable;
 }
 
 bool ClientTrackerView::pollVideoStream()
@@ -287,6 +559,10 @@ bool ClientTrackerView::pollVideoStream()
     {
         bNewFrame= m_shared_memory_accesor->readVideoFrame();
     }
+    else if (m_network_video_reader != nullptr)
+    {
+        bNewFrame= m_network_video_reader->readVideoFrame();
+    }
 
     return bNewFrame;
 }
@@ -298,26 +574,106 @@ void ClientTrackerView::closeVideoStream()
         delete m_shared_memory_accesor;
         m_shared_memory_accesor = nullptr;
     }
+
+    if (m_network_video_reader != nullptr)
+    {
+        delete m_network_video_reader;
+        m_network_video_reader = nullptr;
+    }
 }
 
 int ClientTrackerView::getVideoFrameWidth() const
 {
-    return (m_shared_memory_accesor != nullptr) ? m_shared_memory_accesor->getVideoFrameWidth() : 0;
+    if (m_shared_memory_accesor != nullptr)
+    {
+        return m_shared_memory_accesor->getVideoFrameWidth();
+    }
+    else if (m_network_video_reader != nullptr)
+    {
+        return m_network_video_reader->getVideoFrameWidth();
+    }
+
+    return 0;
 }
 
 int ClientTrackerView::getVideoFrameHeight() const
 {
-    return (m_shared_memory_accesor != nullptr) ? m_shared_memory_accesor->getVideoFrameHeight() : 0;
+    if (m_shared_memory_accesor != nullptr)
+    {
+        return m_shared_memory_accesor->getVideoFrameHeight();
+    }
+    else if (m_network_video_reader != nullptr)
+    {
+        return m_network_video_reader->getVideoFrameHeight();
+    }
+
+    return 0;
 }
 
 int ClientTrackerView::getVideoFrameStride() const
 {
-    return (m_shared_memory_accesor != nullptr) ? m_shared_memory_accesor->getVideoFrameStride() : 0;
+    if (m_shared_memory_accesor != nullptr)
+    {
+        return m_shared_memory_accesor->getVideoFrameStride();
+    }
+    else if (m_network_video_reader != nullptr)
+    {
+        return m_network_video_reader->getVideoFrameStride();
+    }
+
+    return 0;
 }
 
 const unsigned char *ClientTrackerView::getVideoFrameBuffer() const
 {
-    return (m_shared_memory_accesor != nullptr) ? m_shared_memory_accesor->getVideoFrameBuffer() : nullptr;
+    if (m_shared_memory_accesor != nullptr)
+    {
+        return m_shared_memory_accesor->getVideoFrameBuffer();
+    }
+    else if (m_network_video_reader != nullptr)
+    {
+        return m_network_video_reader->getVideoFrameBuffer();
+    }
+
+    return nullptr;
+}
+
+bool ClientTrackerView::pollColorMaskPreview()
+{
+    return (m_color_mask_preview != nullptr) ? m_color_mask_preview->takeHasNewRows() : false;
+}
+
+int ClientTrackerView::getColorMaskPreviewWidth() const
+{
+    return (m_color_mask_preview != nullptr) ? m_color_mask_preview->getWidth() : 0;
+}
+
+int ClientTrackerView::getColorMaskPreviewHeight() const
+{
+    return (m_color_mask_preview != nullptr) ? m_color_mask_preview->getHeight() : 0;
+}
+
+int ClientTrackerView::getColorMaskPreviewDownscale() const
+{
+    return (m_color_mask_preview != nullptr) ? m_color_mask_preview->getDownscale() : 1;
+}
+
+const unsigned char *ClientTrackerView::getColorMaskPreviewBuffer() const
+{
+    return (m_color_mask_preview != nullptr) ? m_color_mask_preview->getMaskBuffer() : nullptr;
+}
+
+bool ClientTrackerView::getColorMaskStatistics(ClientColorMaskStatistics &out_statistics) const
+{
+    bool bHasStatistics = false;
+
+    if (m_color_mask_preview != nullptr)
+    {
+        out_statistics = m_color_mask_preview->getStatistics();
+        bHasStatistics = true;
+    }
+
+    return bHasStatistics;
 }
 
 PSMoveFrustum ClientTrackerView::getTrackerFrustum() const
@@ -11,12 +11,14 @@ namespace PSMoveProtocol
 {
     class DeviceOutputDataFrame;
     class DeviceOutputDataFrame_TrackerDataPacket;
+    class Response_ResultTrackerVideoFrame;
 };
 
 //-- constants -----
 enum eTrackerType
 {
-    PS3Eye
+    PS3Eye,
+    RemoteTracker
 };
 
 enum eTrackerDriver
@@ -24,7 +26,8 @@ enum eTrackerDriver
     LIBUSB,
     CL_EYE,
     CL_EYE_MULTICAM,
-    GENERIC_WEBCAM
+    GENERIC_WEBCAM,
+    NETWORK
 };
 
 //-- declarations -----
@@ -52,6 +55,22 @@ struct CLIENTPSMOVEAPI ClientTrackerInfo
 
     // Camera Extrinsic properties
     PSMovePose tracker_pose;
+
+    // Measured frame timing of the current video mode
+    float frame_rate; // frames per second
+    float frame_interval_jitter; // ms
+    float frame_latency; // ms, capture to processing in the service
+};
+
+// Blob statistics of the service's color mask preview (see ClientPSMoveAPI::TrackerColorMaskPreviewOptions)
+struct CLIENTPSMOVEAPI ClientColorMaskStatistics
+{
+    int blob_count;
+    int masked_pixel_count;
+    int largest_blob_area; // pixels
+    PSMoveFloatVector2 largest_blob_center; // video frame pixels
+    PSMoveFloatVector2 largest_blob_min; // video frame pixels
+    PSMoveFloatVector2 largest_blob_max; // video frame pixels
 };
 
 class CLIENTPSMOVEAPI ClientTrackerView
@@ -59,6 +78,9 @@ class CLIENTPSMOVEAPI ClientTrackerView
 private:
     ClientTrackerInfo m_tracker_info;
     class SharedVideoFrameReadOnlyAccessor *m_shared_memory_accesor;
+    class ClientColorMaskPreview *m_color_mask_preview;
+    class NetworkVideoFrameReader *m_network_video_reader;
+    bool m_network_video_requested;
 
     int m_listener_count;
 
@@ -75,21 +97,42 @@ public:
     void applyTrackerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_TrackerDataPacket *data_frame);
     void clearTrackerDataFrameState();
 
+    // Apply a compressed video frame sent to a network video stream
+    void applyNetworkVideoFrame(const PSMoveProtocol::Response_ResultTrackerVideoFrame *video_frame);
+
+    // Set when the tracker data stream was started with network video (see ClientPSMoveAPI::TrackerNetworkVideoOptions)
+    inline void setNetworkVideoRequested(bool bRequested)
+    {
+        m_network_video_requested = bRequested;
+    }
+
     // Used to apply tracker property changes after config tools run
     inline ClientTrackerInfo &getTrackerInfoMutable()
     {
         return m_tracker_info;
     }
 
-    // Open the shared memory buffer specified in the tracker info
+    // Open the shared memory buffer specified in the tracker info.
+    // Falls back to the network video stream (if one was requested) when the shared memory
+    // can't be opened, e.g. because the service is running on another machine.
     bool openVideoStream();
 
-    // Extract the next frame from shared memory
+    // Extract the next frame from shared memory (or the network video stream)
     bool pollVideoStream();
     
     // Close the shared memory buffer
     void closeVideoStream();
 
+    // True if the tracker's shared memory video stream can be opened from this machine.
+    // Clients use this to decide whether to ask for the network video stream.
+    bool getIsSharedMemoryVideoStreamAvailable() const;
+
+    // True if the open video stream is the network video stream
+    inline bool getIsNetworkVideoStream() const
+    {
+        return m_network_video_reader != nullptr;
+    }
+
     // Listener State
     inline void incListenerCount()
     {
@@ -168,6 +211,15 @@ public:
 
     PSMoveFrustum getTrackerFrustum() const;
 
+    // Color mask preview assembled from the tracker data stream.
+    // Returns true if any new mask rows arrived since the last poll.
+    bool pollColorMaskPreview();
+    int getColorMaskPreviewWidth() const;
+    int getColorMaskPreviewHeight() const;
+    int getColorMaskPreviewDownscale() const;
+    const unsigned char *getColorMaskPreviewBuffer() const; // one byte per pixel, stride = width
+    bool getColorMaskStatistics(ClientColorMaskStatistics &out_statistics) const;
+
     // Statistics
     inline float GetDataFrameFPS() const
     {
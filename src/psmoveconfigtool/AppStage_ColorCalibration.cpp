@@ -31,6 +31,12 @@
 const char *AppStage_ColorCalibration::APP_STAGE_NAME = "ColorCalibration";
 
 //-- constants -----
+// The service's mask preview is sent at half the video resolution to keep the tracker stream small
+static const int k_color_mask_preview_downscale = 2;
+
+// Color tuning wants more detail than the default network video settings
+static const ClientPSMoveAPI::TrackerNetworkVideoOptions k_network_video_options = { 15.f, 1, 85 };
+
 static const char *k_video_display_mode_names[] = {
     "BGR",
     "HSV",
@@ -54,8 +60,7 @@ public:
         : videoTexture(nullptr)
         , bgrBuffer(nullptr)
         , hsvBuffer(nullptr)
-        , gsLowerBuffer(nullptr)
-        , gsUpperBuffer(nullptr)
+        , gsMaskBuffer(nullptr)
         , maskedBuffer(nullptr)
     {
         const int frameWidth = trackerView->getVideoFrameWidth();
@@ -72,8 +77,7 @@ public:
 
         bgrBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
         hsvBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
-        gsLowerBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
-        gsUpperBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
+        gsMaskBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC1);
         maskedBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
     }
 
@@ -85,16 +89,10 @@ public:
             maskedBuffer = nullptr;
         }
 
-        if (gsLowerBuffer != nullptr)
-        {
-            delete gsLowerBuffer;
-            gsLowerBuffer = nullptr;
-        }
-
-        if (gsUpperBuffer != nullptr)
+        if (gsMaskBuffer != nullptr)
         {
-            delete gsUpperBuffer;
-            gsUpperBuffer = nullptr;
+            delete gsMaskBuffer;
+            gsMaskBuffer = nullptr;
         }
 
         if (hsvBuffer != nullptr)
@@ -119,8 +117,7 @@ public:
     TextureAsset *videoTexture;
     cv::Mat *bgrBuffer; // source video frame
     cv::Mat *hsvBuffer; // source frame converted to HSV color space
-    cv::Mat *gsLowerBuffer; // HSV image clamped by HSV range into grayscale mask
-    cv::Mat *gsUpperBuffer; // HSV image clamped by HSV range into grayscale mask
+    cv::Mat *gsMaskBuffer; // service's color mask preview scaled up to the video frame size
     cv::Mat *maskedBuffer; // bgr image ANDed together with grayscale mask
 };
 
@@ -132,6 +129,7 @@ AppStage_ColorCalibration::AppStage_ColorCalibration(App *app)
     , m_isControllerStreamActive(false)
     , m_lastControllerSeqNum(-1)
     , m_trackerView(nullptr)
+    , m_useNetworkVideo(false)
     , m_menuState(AppStage_ColorCalibration::inactive)
     , m_video_buffer_state(nullptr)
     , m_videoDisplayMode(AppStage_ColorCalibration::eVideoDisplayMode::mode_bgr)
@@ -155,6 +153,9 @@ void AppStage_ColorCalibration::enter()
     assert(m_trackerView == nullptr);
     m_trackerView = ClientPSMoveAPI::allocate_tracker_view(*trackerInfo);
 
+    // Tuning a tracker on another machine needs the video sent over the network
+    m_useNetworkVideo = !m_trackerView->getIsSharedMemoryVideoStreamAvailable();
+
     // Assume that we can bind to controller 0
     assert(m_controllerView == nullptr);
     const int ControllerID = (m_overrideControllerId != -1) ? m_overrideControllerId : 0;
@@ -194,13 +195,14 @@ void AppStage_ColorCalibration::update()
     // Try and read the next video frame from shared memory
     if (m_video_buffer_state != nullptr)
     {
-        if (m_trackerView->pollVideoStream())
+        const bool bNewVideoFrame = m_trackerView->pollVideoStream();
+        const bool bNewMaskRows = m_trackerView->pollColorMaskPreview();
+
+        if (bNewVideoFrame)
         {
             const int frameWidth = m_trackerView->getVideoFrameWidth();
             const int frameHeight = m_trackerView->getVideoFrameHeight();
             const unsigned char *video_buffer = m_trackerView->getVideoFrameBuffer();
-            const unsigned char *display_buffer = video_buffer;
-            const TrackerColorPreset &preset = getColorPreset();
 
             // Copy the video frame buffer into the bgr opencv buffer
             {
@@ -208,70 +210,11 @@ void AppStage_ColorCalibration::update()
 
                 videoBufferMat.copyTo(*m_video_buffer_state->bgrBuffer);
             }
+        }
 
-            // Convert the video buffer to the HSV color space
-            cv::cvtColor(*m_video_buffer_state->bgrBuffer, *m_video_buffer_state->hsvBuffer, cv::COLOR_BGR2HSV);
-
-            // Clamp the HSV image, taking into account wrapping the hue angle
-            {
-                const float hue_min = preset.hue_center - preset.hue_range;
-                const float hue_max = preset.hue_center + preset.hue_range;
-                const float saturation_min = clampf(preset.saturation_center - preset.saturation_range, 0, 255);
-                const float saturation_max = clampf(preset.saturation_center + preset.saturation_range, 0, 255);
-                const float value_min = clampf(preset.value_center - preset.value_range, 0, 255);
-                const float value_max = clampf(preset.value_center + preset.value_range, 0, 255);
-
-                if (hue_min < 0)
-                {
-                    cv::inRange(
-                        *m_video_buffer_state->hsvBuffer,
-                        cv::Scalar(0, saturation_min, value_min),
-                        cv::Scalar(clampf(hue_max, 0, 180), saturation_max, value_max),
-                        *m_video_buffer_state->gsLowerBuffer);
-                    cv::inRange(
-                        *m_video_buffer_state->hsvBuffer,
-                        cv::Scalar(clampf(180 + hue_min, 0, 180), saturation_min, value_min),
-                        cv::Scalar(180, saturation_max, value_max),
-                        *m_video_buffer_state->gsUpperBuffer);
-                    cv::bitwise_or(
-                        *m_video_buffer_state->gsLowerBuffer, 
-                        *m_video_buffer_state->gsUpperBuffer, 
-                        *m_video_buffer_state->gsLowerBuffer);
-                }
-                else if (hue_max > 180)
-                {
-                    cv::inRange(
-                        *m_video_buffer_state->hsvBuffer,
-                        cv::Scalar(0, saturation_min, value_min),
-                        cv::Scalar(clampf(hue_max - 180, 0, 180), saturation_max, value_max),
-                        *m_video_buffer_state->gsLowerBuffer);
-                    cv::inRange(
-                        *m_video_buffer_state->hsvBuffer,
-                        cv::Scalar(clampf(hue_min, 0, 180), saturation_min, value_min),
-                        cv::Scalar(180, saturation_max, value_max),
-                        *m_video_buffer_state->gsUpperBuffer);
-                    cv::bitwise_or(
-                        *m_video_buffer_state->gsLowerBuffer, 
-                        *m_video_buffer_state->gsUpperBuffer, 
-                        *m_video_buffer_state->gsLowerBuffer);
-                }
-                else
-                {
-                    cv::inRange(
-                        *m_video_buffer_state->hsvBuffer,
-                        cv::Scalar(hue_min, saturation_min, value_min),
-                        cv::Scalar(hue_max, saturation_max, value_max),
-                        *m_video_buffer_state->gsLowerBuffer);
-                }
-            }
-
-            // Mask out the original video frame with the HSV filtered mask
-            *m_video_buffer_state->maskedBuffer = cv::Scalar(0, 0, 0);
-            cv::bitwise_and(
-                *m_video_buffer_state->bgrBuffer, 
-                *m_video_buffer_state->bgrBuffer, 
-                *m_video_buffer_state->maskedBuffer, 
-                *m_video_buffer_state->gsLowerBuffer);
+        if (bNewVideoFrame || bNewMaskRows)
+        {
+            const unsigned char *display_buffer = nullptr;
 
             switch (m_videoDisplayMode)
             {
@@ -279,11 +222,37 @@ void AppStage_ColorCalibration::update()
                 display_buffer = m_video_buffer_state->bgrBuffer->data;
                 break;
             case AppStage_ColorCalibration::mode_hsv:
+                // Convert the video buffer to the HSV color space
+                cv::cvtColor(*m_video_buffer_state->bgrBuffer, *m_video_buffer_state->hsvBuffer, cv::COLOR_BGR2HSV);
                 display_buffer = m_video_buffer_state->hsvBuffer->data;
                 break;
             case AppStage_ColorCalibration::mode_masked:
-                display_buffer = m_video_buffer_state->maskedBuffer->data;
-                break;
+                {
+                    const unsigned char *mask_buffer = m_trackerView->getColorMaskPreviewBuffer();
+
+                    // Mask out the original video frame with the service's color filter mask
+                    *m_video_buffer_state->maskedBuffer = cv::Scalar(0, 0, 0);
+                    if (mask_buffer != nullptr)
+                    {
+                        const cv::Mat maskPreviewMat(
+                            m_trackerView->getColorMaskPreviewHeight(),
+                            m_trackerView->getColorMaskPreviewWidth(),
+                            CV_8UC1,
+                            const_cast<unsigned char *>(mask_buffer));
+
+                        cv::resize(
+                            maskPreviewMat,
+                            *m_video_buffer_state->gsMaskBuffer,
+                            m_video_buffer_state->gsMaskBuffer->size(),
+                            0, 0, cv::INTER_NEAREST);
+                        cv::bitwise_and(
+                            *m_video_buffer_state->bgrBuffer, 
+                            *m_video_buffer_state->bgrBuffer, 
+                            *m_video_buffer_state->maskedBuffer, 
+                            *m_video_buffer_state->gsMaskBuffer);
+                    }
+                    display_buffer = m_video_buffer_state->maskedBuffer->data;
+                } break;
             default:
                 assert(0 && "unreachable");
                 break;
@@ -416,13 +385,17 @@ void AppStage_ColorCalibration::renderUI()
             ImGui::End();
         }
         
-        if (ImGui::IsMouseClicked(1) )
+        if (ImGui::IsMouseClicked(1) && m_video_buffer_state != nullptr)
         {
             ImVec2 mousePos = ImGui::GetMousePos();
             ImVec2 dispSize = ImGui::GetIO().DisplaySize;
-            int img_x = mousePos.x * m_video_buffer_state->hsvBuffer->cols / static_cast<int>(dispSize.x);
-            int img_y = mousePos.y * m_video_buffer_state->hsvBuffer->rows / static_cast<int>(dispSize.y);
-            cv::Vec< unsigned char, 3 > hsv_pixel = m_video_buffer_state->hsvBuffer->at<cv::Vec< unsigned char, 3 >>(cv::Point(img_x, img_y));
+            int img_x = mousePos.x * m_video_buffer_state->bgrBuffer->cols / static_cast<int>(dispSize.x);
+            int img_y = mousePos.y * m_video_buffer_state->bgrBuffer->rows / static_cast<int>(dispSize.y);
+
+            // The HSV buffer is only kept up to date in the HSV display mode, so just convert the picked pixel
+            cv::Mat hsv_pixel_mat;
+            cv::cvtColor((*m_video_buffer_state->bgrBuffer)(cv::Rect(img_x, img_y, 1, 1)), hsv_pixel_mat, cv::COLOR_BGR2HSV);
+            cv::Vec< unsigned char, 3 > hsv_pixel = hsv_pixel_mat.at<cv::Vec< unsigned char, 3 >>(0, 0);
             
             TrackerColorPreset preset = getColorPreset();
             preset.hue_center = hsv_pixel[0];
@@ -555,6 +528,19 @@ void AppStage_ColorCalibration::renderUI()
             ImGui::SameLine();
             ImGui::Text("Value Range: %f", getColorPreset().value_range);
 
+            // -- Mask Statistics (computed by the service) --
+            ClientColorMaskStatistics mask_statistics;
+            if (m_trackerView->getColorMaskStatistics(mask_statistics))
+            {
+                ImGui::Separator();
+                ImGui::Text("Blobs: %d (%d masked pixels)", mask_statistics.blob_count, mask_statistics.masked_pixel_count);
+                if (mask_statistics.blob_count > 0)
+                {
+                    ImGui::Text("Largest Blob: %d px at (%.0f, %.0f)",
+                        mask_statistics.largest_blob_area,
+                        mask_statistics.largest_blob_center.i, mask_statistics.largest_blob_center.j);
+                }
+            }
 
             ImGui::End();
         }
@@ -684,6 +670,9 @@ void AppStage_ColorCalibration::request_set_controller_tracking_color(
     }
 
     m_controllerView->SetLEDOverride(r, g, b);
+
+    // Have the service mask the video with the new color's preset
+    request_tracker_update_mask_preview();
 }
 
 void AppStage_ColorCalibration::request_tracker_start_stream()
@@ -692,13 +681,33 @@ void AppStage_ColorCalibration::request_tracker_start_stream()
     {
         setState(AppStage_ColorCalibration::pendingTrackerStartStreamRequest);
 
+        ClientPSMoveAPI::TrackerColorMaskPreviewOptions mask_preview_options;
+        mask_preview_options.tracking_color = m_trackingColorType;
+        mask_preview_options.controller_id = m_overrideControllerId;
+        mask_preview_options.downscale = k_color_mask_preview_downscale;
+
         // Tell the psmove service that we want to start streaming data from the tracker
+        // along with its color filter mask for the selected color
         ClientPSMoveAPI::register_callback(
-            ClientPSMoveAPI::start_tracker_data_stream(m_trackerView),
+            ClientPSMoveAPI::start_tracker_data_stream(
+                m_trackerView, &mask_preview_options, m_useNetworkVideo ? &k_network_video_options : nullptr),
             AppStage_ColorCalibration::handle_tracker_start_stream_response, this);
     }
 }
 
+void AppStage_ColorCalibration::request_tracker_update_mask_preview()
+{
+    ClientPSMoveAPI::TrackerColorMaskPreviewOptions mask_preview_options;
+    mask_preview_options.tracking_color = m_trackingColorType;
+    mask_preview_options.controller_id = m_overrideControllerId;
+    mask_preview_options.downscale = k_color_mask_preview_downscale;
+
+    // Starting an already running stream only updates its mask preview and network video settings
+    ClientPSMoveAPI::eat_response(
+        ClientPSMoveAPI::start_tracker_data_stream(
+            m_trackerView, &mask_preview_options, m_useNetworkVideo ? &k_network_video_options : nullptr));
+}
+
 void AppStage_ColorCalibration::handle_tracker_start_stream_response(
     const ClientPSMoveAPI::ResponseMessage *response,
     void *userdata)
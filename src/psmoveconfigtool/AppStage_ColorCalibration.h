@@ -76,6 +76,7 @@ protected:
     void request_set_controller_tracking_color(PSMoveTrackingColorType tracking_color);
 
     void request_tracker_start_stream();
+    void request_tracker_update_mask_preview();
     static void handle_tracker_start_stream_response(
         const ClientPSMoveAPI::ResponseMessage *response,
         void *userdata);
@@ -124,6 +125,7 @@ private:
     bool m_isControllerStreamActive;
     int m_lastControllerSeqNum;
     class ClientTrackerView *m_trackerView;
+    bool m_useNetworkVideo;
 
     // Menu state
     eMenuState m_menuState;
@@ -708,9 +708,14 @@ void AppStage_ComputeTrackerPoses::request_tracker_start_stream(
     // Increment the number of requests we're waiting to get back
     ++m_pendingTrackerStartCount;
 
+    // Ask for compressed video over the network (default settings) if the service is on another machine
+    const ClientPSMoveAPI::TrackerNetworkVideoOptions network_video_options = { 0.f, 0, 0 };
+    const bool bNeedsNetworkVideo = !trackerState.trackerView->getIsSharedMemoryVideoStreamAvailable();
+
     // Request data to start streaming to the tracker
     ClientPSMoveAPI::register_callback(
-        ClientPSMoveAPI::start_tracker_data_stream(trackerState.trackerView),
+        ClientPSMoveAPI::start_tracker_data_stream(
+            trackerState.trackerView, nullptr, bNeedsNetworkVideo ? &network_video_options : nullptr),
         AppStage_ComputeTrackerPoses::handle_tracker_start_stream_response, this);
 }
 
@@ -202,9 +202,14 @@ void AppStage_TestTracker::request_tracker_start_stream()
     {
         m_menuState = AppStage_TestTracker::pendingTrackerStartStreamRequest;
 
+        // Ask for compressed video over the network (default settings) if the service is on another machine
+        const ClientPSMoveAPI::TrackerNetworkVideoOptions network_video_options = { 0.f, 0, 0 };
+        const bool bNeedsNetworkVideo = !m_tracker_view->getIsSharedMemoryVideoStreamAvailable();
+
         // Tell the psmove service that we want to start streaming data from the tracker
         ClientPSMoveAPI::register_callback(
-            ClientPSMoveAPI::start_tracker_data_stream(m_tracker_view),
+            ClientPSMoveAPI::start_tracker_data_stream(
+                m_tracker_view, nullptr, bNeedsNetworkVideo ? &network_video_options : nullptr),
             AppStage_TestTracker::handle_tracker_start_stream_response, this);
     }
 }
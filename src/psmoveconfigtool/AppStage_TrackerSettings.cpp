@@ -55,7 +55,8 @@ void AppStage_TrackerSettings::render()
 
             switch (trackerInfo.tracker_type)
             {
-            case PSMoveProtocol::PS3EYE:
+            case eTrackerType::PS3Eye:
+            case eTrackerType::RemoteTracker: // A PS3 Eye on a tracker node
                 {
                     glm::mat4 scale3 = glm::scale(glm::mat4(1.f), glm::vec3(3.f, 3.f, 3.f));
                     drawPS3EyeModel(scale3);
@@ -137,6 +138,10 @@ void AppStage_TrackerSettings::renderUI()
                 {
                     ImGui::BulletText("Controller Type: PS3 Eye");
                 } break;
+            case eTrackerType::RemoteTracker:
+                {
+                    ImGui::BulletText("Controller Type: Remote Tracker");
+                } break;
             default:
                 assert(0 && "Unreachable");
             }
@@ -159,6 +164,10 @@ void AppStage_TrackerSettings::renderUI()
                 {
                     ImGui::BulletText("Controller Type: Generic Webcam");
                 } break;
+            case eTrackerDriver::NETWORK:
+                {
+                    ImGui::BulletText("Controller Type: Network (tracker node)");
+                } break;
             default:
                 assert(0 && "Unreachable");
             }
@@ -0,0 +1,168 @@
+//-- includes -----
+#include "ColorMaskRunLength.h"
+
+#include <cstring>
+
+//-- prototypes -----
+static int get_varint_size(unsigned int value);
+static void append_varint(unsigned int value, std::string &out_bytes);
+static bool read_varint(const std::string &bytes, size_t &in_out_offset, unsigned int &out_value);
+static bool encode_row(const unsigned char *pixels, int width, size_t max_bytes, bool bClip, std::string &out_runs);
+
+//-- public interface -----
+namespace ColorMaskRunLength
+{
+    int encodeRows(
+        const unsigned char *mask, int width, int height, int stride,
+        int start_row, int max_row_count, int max_bytes,
+        std::string &out_runs)
+    {
+        int row_count= 0;
+
+        out_runs.clear();
+
+        for (int row= start_row; row < height && row_count < max_row_count; ++row)
+        {
+            const unsigned char *pixels= mask + row*stride;
+            const size_t row_start_size= out_runs.size();
+
+            if (!encode_row(pixels, width, static_cast<size_t>(max_bytes), false, out_runs))
+            {
+                // Leave the row for the next call unless it wouldn't fit on its own either
+                out_runs.resize(row_start_size);
+
+                if (row_count == 0)
+                {
+                    encode_row(pixels, width, static_cast<size_t>(max_bytes), true, out_runs);
+                    ++row_count;
+                }
+
+                break;
+            }
+
+            ++row_count;
+        }
+
+        return row_count;
+    }
+
+    bool decodeRows(
+        const std::string &runs, int width, int row_count,
+        unsigned char *out_mask, int stride)
+    {
+        size_t offset= 0;
+        bool bSuccess= true;
+
+        for (int row= 0; bSuccess && row < row_count; ++row)
+        {
+            unsigned char *pixels= out_mask + row*stride;
+            int x= 0;
+            bool bMasked= false;
+
+            while (bSuccess && x < width)
+            {
+                unsigned int run= 0;
+
+                bSuccess=
+                    read_varint(runs, offset, run) &&
+                    run <= static_cast<unsigned int>(width - x);
+
+                if (bSuccess)
+                {
+                    memset(pixels + x, bMasked ? 255 : 0, run);
+                    x+= static_cast<int>(run);
+                    bMasked= !bMasked;
+                }
+            }
+        }
+
+        return bSuccess && offset == runs.size();
+    }
+};
+
+//-- private functions -----
+static int get_varint_size(unsigned int value)
+{
+    int size= 1;
+
+    while (value >= 0x80)
+    {
+        value>>= 7;
+        ++size;
+    }
+
+    return size;
+}
+
+static void append_varint(unsigned int value, std::string &out_bytes)
+{
+    while (value >= 0x80)
+    {
+        out_bytes.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value>>= 7;
+    }
+
+    out_bytes.push_back(static_cast<char>(value));
+}
+
+static bool read_varint(const std::string &bytes, size_t &in_out_offset, unsigned int &out_value)
+{
+    unsigned int value= 0;
+    int shift= 0;
+
+    while (in_out_offset < bytes.size() && shift < 32)
+    {
+        const unsigned char byte= static_cast<unsigned char>(bytes[in_out_offset++]);
+
+        value|= static_cast<unsigned int>(byte & 0x7F) << shift;
+        shift+= 7;
+
+        if ((byte & 0x80) == 0)
+        {
+            out_value= value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Appends the runs of one row. Returns false if the row didn't fit in max_bytes.
+// When clipping, the runs that don't fit are replaced by one run covering the rest of the row
+// (so the row always decodes to the right width).
+static bool encode_row(const unsigned char *pixels, int width, size_t max_bytes, bool bClip, std::string &out_runs)
+{
+    const size_t clipped_run_size= static_cast<size_t>(get_varint_size(static_cast<unsigned int>(width)));
+    bool bMasked= false;
+    int run_start= 0;
+
+    for (int x= 0; x < width; ++x)
+    {
+        const bool bPixelMasked= pixels[x] != 0;
+
+        if (bPixelMasked != bMasked)
+        {
+            const unsigned int run= static_cast<unsigned int>(x - run_start);
+            const size_t run_size= static_cast<size_t>(get_varint_size(run));
+
+            // Always keep room for the run that finishes the row
+            if (out_runs.size() + run_size + clipped_run_size > max_bytes)
+            {
+                if (bClip)
+                {
+                    append_varint(static_cast<unsigned int>(width - run_start), out_runs);
+                }
+
+                return false;
+            }
+
+            append_varint(run, out_runs);
+            run_start= x;
+            bMasked= bPixelMasked;
+        }
+    }
+
+    append_varint(static_cast<unsigned int>(width - run_start), out_runs);
+
+    return out_runs.size() <= max_bytes;
+}
@@ -0,0 +1,32 @@
+#ifndef COLOR_MASK_RUN_LENGTH_H
+#define COLOR_MASK_RUN_LENGTH_H
+
+//-- includes -----
+#include <string>
+
+//-- interface -----
+// Run-length encoding of the 8-bit tracking color masks the service sends for color calibration previews.
+// Each row is a sequence of run lengths that alternate between unmasked and masked pixels,
+// always starting with an unmasked run (which may be 0 long) and summing to the mask width.
+// Run lengths are stored as little endian base 128 varints (same as protobuf),
+// so a typical row with a blob or two in it costs a handful of bytes.
+namespace ColorMaskRunLength
+{
+    /// Appends rows of the mask starting at start_row to out_runs (cleared first).
+    /// Stops before the encoding would grow past max_bytes or once max_row_count rows are done.
+    /// A single row that can't fit in max_bytes on its own is clipped: its tail is sent as one run.
+    /// \param mask Mask pixels, any non-zero value counts as masked
+    /// \return The number of rows encoded (at least one if start_row is in the mask)
+    int encodeRows(
+        const unsigned char *mask, int width, int height, int stride,
+        int start_row, int max_row_count, int max_bytes,
+        std::string &out_runs);
+
+    /// Decodes row_count rows from runs into out_mask (masked pixels set to 255, the rest to 0).
+    /// \return false if the runs are malformed, in which case the rows are left partially written
+    bool decodeRows(
+        const std::string &runs, int width, int row_count,
+        unsigned char *out_mask, int stride);
+};
+
+#endif // COLOR_MASK_RUN_LENGTH_H
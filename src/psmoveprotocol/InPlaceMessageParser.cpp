@@ -0,0 +1,269 @@
+//-- includes -----
+#include "InPlaceMessageParser.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/wire_format.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <cstdint>
+#include <cstring>
+
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::internal::WireFormat;
+using google::protobuf::internal::WireFormatLite;
+
+//-- constants -----
+// Fields per message the parser can keep track of (PSMoveProtocol messages are well under this)
+static const int k_max_message_fields = 64;
+
+//-- public interface -----
+InPlaceMessageParser::InPlaceMessageParser()
+    : m_spare_count(0)
+    , m_string_scratch()
+{
+}
+
+InPlaceMessageParser::~InPlaceMessageParser()
+{
+    for (int spare_index = 0; spare_index < m_spare_count; ++spare_index)
+    {
+        delete m_spares[spare_index].message;
+    }
+}
+
+bool InPlaceMessageParser::parse(Message *message, const void *data, int size)
+{
+    CodedInputStream input(static_cast<const unsigned char *>(data), size);
+
+    return merge_message(message, &input, true) && input.ConsumedEntireMessage();
+}
+
+//-- private methods -----
+// Reads fields until the end of the message (or the current limit).
+// When bReplace is set the message's old contents get overwritten, otherwise the fields are
+// merged into it (a sub-message that shows up more than once, which protobuf allows).
+bool InPlaceMessageParser::merge_message(Message *message, CodedInputStream *input, bool bReplace)
+{
+    const Descriptor *descriptor = message->GetDescriptor();
+    const Reflection *reflection = message->GetReflection();
+    const int field_count = descriptor->field_count();
+    bool bFieldSeen[k_max_message_fields];
+    int element_count[k_max_message_fields]; // Elements written so far to each repeated message field
+
+    if (field_count > k_max_message_fields)
+    {
+        return false;
+    }
+
+    memset(bFieldSeen, 0, sizeof(bFieldSeen));
+    memset(element_count, 0, sizeof(element_count));
+
+    for (uint32_t tag = input->ReadTag(); tag != 0; tag = input->ReadTag())
+    {
+        const FieldDescriptor *field = descriptor->FindFieldByNumber(WireFormatLite::GetTagFieldNumber(tag));
+        const bool bLengthDelimited = WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+
+        if (field == nullptr)
+        {
+            // Unknown field (ex: from a newer client), dropped like proto3 does
+            if (!WireFormatLite::SkipField(input, tag))
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        const int field_index = field->index();
+        const bool bFirstOccurrence = !bFieldSeen[field_index];
+        bFieldSeen[field_index] = true;
+
+        if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE && bLengthDelimited)
+        {
+            Message *sub_message = nullptr;
+            bool bReplaceSubMessage = true;
+
+            if (field->is_repeated())
+            {
+                // Merging appends to whatever elements are already there
+                if (bFirstOccurrence && !bReplace)
+                {
+                    element_count[field_index] = reflection->FieldSize(*message, field);
+                }
+
+                const int element_index = element_count[field_index]++;
+
+                if (element_index < reflection->FieldSize(*message, field))
+                {
+                    sub_message = reflection->MutableRepeatedMessage(message, field, element_index);
+                }
+                else if ((sub_message = take_set_aside(field)) != nullptr)
+                {
+                    reflection->AddAllocatedMessage(message, field, sub_message);
+                }
+                else
+                {
+                    sub_message = reflection->AddMessage(message, field);
+                }
+            }
+            else
+            {
+                const bool bHadField = reflection->HasField(*message, field);
+
+                if (!bHadField)
+                {
+                    Message *spare = take_set_aside(field);
+
+                    if (spare != nullptr)
+                    {
+                        reflection->SetAllocatedMessage(message, spare, field);
+                    }
+                }
+
+                // Stale contents get overwritten, a second occurrence merges into the first
+                sub_message = reflection->MutableMessage(message, field);
+                bReplaceSubMessage = !bHadField || (bReplace && bFirstOccurrence);
+            }
+
+            uint32_t length;
+            if (!input->ReadVarint32(&length) || !input->IncrementRecursionDepth())
+            {
+                return false;
+            }
+
+            const CodedInputStream::Limit limit = input->PushLimit(static_cast<int>(length));
+            const bool bParsed =
+                merge_message(sub_message, input, bReplaceSubMessage) &&
+                input->ConsumedEntireMessage();
+            input->PopLimit(limit);
+            input->DecrementRecursionDepth();
+
+            if (!bParsed)
+            {
+                return false;
+            }
+        }
+        else if (!field->is_repeated() &&
+                 field->cpp_type() == FieldDescriptor::CPPTYPE_STRING &&
+                 bLengthDelimited)
+        {
+            if (!merge_string(message, field, input))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            // Repeated scalars get appended to, so start them over the first time they show up
+            if (field->is_repeated() && bFirstOccurrence && bReplace)
+            {
+                reflection->ClearField(message, field);
+            }
+
+            if (!WireFormat::ParseAndMergeField(tag, field, message, input))
+            {
+                return false;
+            }
+        }
+    }
+
+    if (bReplace)
+    {
+        // Whatever this message left out goes back to its default.
+        // Sub-messages are set aside rather than freed so the next message that has them doesn't allocate.
+        for (int field_index = 0; field_index < field_count; ++field_index)
+        {
+            const FieldDescriptor *field = descriptor->field(field_index);
+
+            if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE)
+            {
+                if (field->is_repeated())
+                {
+                    while (reflection->FieldSize(*message, field) > element_count[field_index])
+                    {
+                        set_aside(field, reflection->ReleaseLast(message, field));
+                    }
+                }
+                else if (!bFieldSeen[field_index] && reflection->HasField(*message, field))
+                {
+                    set_aside(field, reflection->ReleaseMessage(message, field));
+                }
+            }
+            else if (!bFieldSeen[field_index])
+            {
+                reflection->ClearField(message, field);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool InPlaceMessageParser::merge_string(Message *message, const FieldDescriptor *field, CodedInputStream *input)
+{
+    const Reflection *reflection = message->GetReflection();
+    uint32_t length;
+    const void *data = nullptr;
+    int buffer_size = 0;
+
+    if (!input->ReadVarint32(&length))
+    {
+        return false;
+    }
+
+    // parse() always reads from one array, so the whole string sits in the buffer
+    if (length > 0 &&
+        (!input->GetDirectBufferPointer(&data, &buffer_size) || static_cast<uint32_t>(buffer_size) < length))
+    {
+        return false;
+    }
+
+    // Data frames keep sending the same strings (ex: the tracker node name and token), so leave those be.
+    // Setting a new value is the one thing that allocates.
+    const std::string &value = reflection->GetStringReference(*message, field, &m_string_scratch);
+
+    if (value.size() != length || (length > 0 && memcmp(value.data(), data, length) != 0))
+    {
+        reflection->SetString(message, field, std::string(static_cast<const char *>(data), length));
+    }
+
+    return length == 0 || input->Skip(static_cast<int>(length));
+}
+
+void InPlaceMessageParser::set_aside(const FieldDescriptor *field, Message *sub_message)
+{
+    if (m_spare_count < MAX_IN_PLACE_SPARE_MESSAGES)
+    {
+        m_spares[m_spare_count].field = field;
+        m_spares[m_spare_count].message = sub_message;
+        ++m_spare_count;
+    }
+    else
+    {
+        delete sub_message;
+    }
+}
+
+Message *InPlaceMessageParser::take_set_aside(const FieldDescriptor *field)
+{
+    Message *sub_message = nullptr;
+
+    for (int spare_index = m_spare_count - 1; spare_index >= 0; --spare_index)
+    {
+        if (m_spares[spare_index].field == field)
+        {
+            sub_message = m_spares[spare_index].message;
+            m_spares[spare_index] = m_spares[m_spare_count - 1];
+            --m_spare_count;
+            break;
+        }
+    }
+
+    return sub_message;
+}
@@ -0,0 +1,66 @@
+#ifndef IN_PLACE_MESSAGE_PARSER_H
+#define IN_PLACE_MESSAGE_PARSER_H
+
+//-- includes -----
+#include <string>
+
+//-- pre-declarations -----
+namespace google {
+    namespace protobuf {
+        class FieldDescriptor;
+        class Message;
+        namespace io {
+            class CodedInputStream;
+        }
+    }
+}
+
+//-- constants -----
+// Most sub-messages that can be set aside between parses before extras get freed
+#define MAX_IN_PLACE_SPARE_MESSAGES 64
+
+//-- definitions -----
+/// Parses a stream of messages into the same message object without going back to the heap.
+/// Message::Clear() frees every sub-message (proto3 has no other way to mark them absent),
+/// so ParseFromArray() re-allocates all of them for every data frame.
+/// This instead overwrites the message in place: sub-messages, repeated elements and string
+/// storage are reused, and the ones a data frame leaves out are set aside rather than freed.
+/// The parsed message matches what ParseFromArray() gives, has_*() included.
+/// Only a message bigger than any seen so far (more repeated elements or sub-messages
+/// than have been set aside, a longer string) or a string whose value changed allocates.
+class InPlaceMessageParser
+{
+public:
+    InPlaceMessageParser();
+    ~InPlaceMessageParser();
+
+    /// Replaces the contents of message with the one serialized in data
+    /// \return false if the data is malformed, in which case the message is left partially written
+    bool parse(google::protobuf::Message *message, const void *data, int size);
+
+private:
+    // Not copyable, it owns the set aside sub-messages
+    InPlaceMessageParser(const InPlaceMessageParser &);
+    InPlaceMessageParser &operator=(const InPlaceMessageParser &);
+
+    bool merge_message(
+        google::protobuf::Message *message, google::protobuf::io::CodedInputStream *input, bool bReplace);
+    bool merge_string(
+        google::protobuf::Message *message, const google::protobuf::FieldDescriptor *field,
+        google::protobuf::io::CodedInputStream *input);
+    void set_aside(const google::protobuf::FieldDescriptor *field, google::protobuf::Message *sub_message);
+    google::protobuf::Message *take_set_aside(const google::protobuf::FieldDescriptor *field);
+
+    struct SpareMessage
+    {
+        const google::protobuf::FieldDescriptor *field;
+        google::protobuf::Message *message;
+    };
+    SpareMessage m_spares[MAX_IN_PLACE_SPARE_MESSAGES];
+    int m_spare_count;
+
+    // Required by Reflection::GetStringReference(), never actually used for plain string fields
+    std::string m_string_scratch;
+};
+
+#endif // IN_PLACE_MESSAGE_PARSER_H
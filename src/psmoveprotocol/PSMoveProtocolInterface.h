@@ -5,8 +5,15 @@
 #include <memory>
 
 //-- constants -----
-#define MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE 500
+// Controller data frames with raw tracker data grow ~55 bytes per tracker: with all eight trackers
+// (TrackerManager::k_max_supported_devices) and every other stream option on a PSMove frame comes to ~690 bytes.
+// Only the packed bytes get sent, so this is just the largest datagram either side will handle.
+#define MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE 768
 #define MAX_INPUT_DATA_FRAME_MESSAGE_SIZE 64
+// Tracker node observations (DeviceInputDataFrame.TrackerDataPacket) are bigger than any other input frame:
+// with a 64 character node name and token, the camera properties and a sphere observation 
+// for all six tracking colors a packet comes to ~700 bytes. Still fits in one unfragmented UDP datagram.
+#define MAX_TRACKER_INPUT_DATA_FRAME_MESSAGE_SIZE 768
  
 //-- pre-declarations -----
 namespace PSMoveProtocol
@@ -12,6 +12,8 @@ public:
         , height(0)
         , stride(0)
         , frame_index(0)
+        , slot_count(1)
+        , current_slot(0)
     {
     }
     
@@ -22,11 +24,28 @@ public:
     int height;
     int stride;
     int frame_index;
-    // Buffer stored past the end of the header
+    // The service writes video frames straight into one of several buffer slots
+    // and then makes that slot current. Readers only ever look at the current slot.
+    int slot_count;
+    int current_slot;
+    // Buffer slots stored past the end of the header
 
+    const unsigned char *getSlotBuffer(int slot) const
+    {
+        return 
+            reinterpret_cast<const unsigned char *>(this) + sizeof(SharedVideoFrameHeader) + 
+            slot*computeVideoBufferSize(stride, height);
+    }
+
+    unsigned char *getSlotBufferMutable(int slot)
+    {
+        return const_cast<unsigned char *>(getSlotBuffer(slot));
+    }
+
+    // The most recently published video frame
     const unsigned char *getBuffer() const
     {
-        return reinterpret_cast<const unsigned char *>(this) + sizeof(SharedVideoFrameHeader);
+        return getSlotBuffer(current_slot);
     }
 
     unsigned char *getBufferMutable()
@@ -39,9 +58,9 @@ public:
         return stride*height;
     }
 
-    static size_t computeTotalSize(int stride, int height)
+    static size_t computeTotalSize(int stride, int height, int slot_count = 1)
     {
-        return sizeof(SharedVideoFrameHeader) + computeVideoBufferSize(stride, height);
+        return sizeof(SharedVideoFrameHeader) + slot_count*computeVideoBufferSize(stride, height);
     }
 };
 
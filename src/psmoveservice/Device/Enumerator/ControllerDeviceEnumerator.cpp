@@ -21,61 +21,118 @@ USBDeviceInfo g_supported_controller_infos[MAX_CONTROLLER_TYPE_INDEX] = {
     { 0x054c, 0x05C4 }, // PSDualShock4
 };
 
+// -- private methods -----
+static bool is_supported_controller_device(
+    const CommonDeviceState::eDeviceType device_type, 
+    const struct hid_device_info *dev)
+{
+    bool bIsValid = true;
+
+	//###HipsterSloth $TODO Disable the navi until it actually works
+	if (device_type == CommonDeviceState::PSNavi)
+	{
+		bIsValid = false;
+	}
+
+#ifdef _WIN32
+    /**
+    * Windows Quirk: Each psmove dev is enumerated 3 times.
+    * The one with "&col01#" in the path is the one we will get most of our data from. Only count this one.
+    * The one with "&col02#" in the path is the one we will get the bluetooth address from.
+    **/
+    if (bIsValid && device_type == CommonDeviceState::PSMove && strstr(dev->path, "&col01#") == nullptr)
+    {
+        bIsValid = false;
+    }
+#endif
+
+    return bIsValid;
+}
+
 // -- ControllerDeviceEnumerator -----
 ControllerDeviceEnumerator::ControllerDeviceEnumerator()
     : DeviceEnumerator(CommonDeviceState::PSMove)
-    , devs(nullptr)
-    , cur_dev(nullptr)
+    , m_devices()
+    , m_device_index(0)
 {
     assert(m_deviceType >= 0 && GET_DEVICE_TYPE_INDEX(m_deviceType) < MAX_CONTROLLER_TYPE_INDEX);
 
-    USBDeviceInfo &dev_info = g_supported_controller_infos[GET_DEVICE_TYPE_INDEX(m_deviceType)];
-    devs = hid_enumerate(dev_info.vendor_id, dev_info.product_id);
-    cur_dev = devs;
-
-    if (!is_valid())
-    {
-        next();
-    }
+    build_device_list();
 }
 
 ControllerDeviceEnumerator::ControllerDeviceEnumerator(CommonDeviceState::eDeviceType deviceType)
     : DeviceEnumerator(deviceType)
-    , devs(nullptr)
-    , cur_dev(nullptr)
+    , m_devices()
+    , m_device_index(0)
 {
     assert(m_deviceType >= 0 && GET_DEVICE_TYPE_INDEX(m_deviceType) < MAX_CONTROLLER_TYPE_INDEX);
 
-    USBDeviceInfo &dev_info = g_supported_controller_infos[GET_DEVICE_TYPE_INDEX(m_deviceType)];
-    devs = hid_enumerate(dev_info.vendor_id, dev_info.product_id);
-    cur_dev = devs;
-
-    if (!is_valid())
-    {
-        next();
-    }
+    build_device_list();
 }
 
 ControllerDeviceEnumerator::~ControllerDeviceEnumerator()
 {
-    if (devs != nullptr)
+}
+
+void ControllerDeviceEnumerator::build_device_list()
+{
+    // Walk the hid enumeration of every supported controller type,
+    // starting from the device type this enumerator was created with
+    for (int type_index = GET_DEVICE_TYPE_INDEX(m_deviceType); type_index < MAX_CONTROLLER_TYPE_INDEX; ++type_index)
+    {
+        const CommonDeviceState::eDeviceType device_type =
+            static_cast<CommonDeviceState::eDeviceType>(GET_DEVICE_TYPE_CLASS(m_deviceType) + type_index);
+        USBDeviceInfo &dev_info = g_supported_controller_infos[type_index];
+        struct hid_device_info *devs = hid_enumerate(dev_info.vendor_id, dev_info.product_id);
+
+        for (struct hid_device_info *cur_dev = devs; cur_dev != nullptr; cur_dev = cur_dev->next)
+        {
+            if (is_supported_controller_device(device_type, cur_dev))
+            {
+                ControllerDeviceInfo device_info;
+                char mb_serial[256];
+
+                device_info.device_type = device_type;
+                device_info.path = cur_dev->path;
+                device_info.has_serial_number =
+                    cur_dev->serial_number != nullptr &&
+                    ServerUtility::convert_wcs_to_mbs(cur_dev->serial_number, mb_serial, sizeof(mb_serial));
+                device_info.serial_number = device_info.has_serial_number ? mb_serial : "";
+
+                m_devices.push_back(device_info);
+            }
+        }
+
+        if (devs != nullptr)
+        {
+            hid_free_enumeration(devs);
+        }
+    }
+
+    if (is_valid())
     {
-        hid_free_enumeration(devs);
+        m_deviceType = m_devices[m_device_index].device_type;
     }
 }
 
 const char *ControllerDeviceEnumerator::get_path() const
 {
-    return (cur_dev != nullptr) ? cur_dev->path : nullptr;
+    return is_valid() ? m_devices[m_device_index].path.c_str() : nullptr;
 }
 
 bool ControllerDeviceEnumerator::get_serial_number(char *out_mb_serial, const size_t mb_buffer_size) const
 {
     bool success = false;
 
-    if (cur_dev != nullptr && cur_dev->serial_number != nullptr)
+    if (is_valid() && m_devices[m_device_index].has_serial_number)
     {
-        success = ServerUtility::convert_wcs_to_mbs(cur_dev->serial_number, out_mb_serial, mb_buffer_size);
+        const std::string &serial_number = m_devices[m_device_index].serial_number;
+
+        if (serial_number.length() < mb_buffer_size)
+        {
+            strncpy(out_mb_serial, serial_number.c_str(), mb_buffer_size);
+            success = true;
+        }
     }
 
     return success;
@@ -83,66 +140,23 @@ bool ControllerDeviceEnumerator::get_serial_number(char *out_mb_serial, const si
 
 bool ControllerDeviceEnumerator::is_valid() const
 {
-    bool bIsValid = cur_dev != nullptr;
-
-	//###HipsterSloth $TODO Disable the navi until it actually works
-	if (m_deviceType == CommonDeviceState::PSNavi)
-	{
-		bIsValid = false;
-	}
-
-#ifdef _WIN32
-    /**
-    * Windows Quirk: Each psmove dev is enumerated 3 times.
-    * The one with "&col01#" in the path is the one we will get most of our data from. Only count this one.
-    * The one with "&col02#" in the path is the one we will get the bluetooth address from.
-    **/
-    if (bIsValid && m_deviceType == CommonDeviceState::PSMove && strstr(cur_dev->path, "&col01#") == nullptr)
-    {
-        bIsValid = false;
-    }
-#endif
-
-    return bIsValid;
+    return m_device_index < static_cast<int>(m_devices.size());
 }
 
 bool ControllerDeviceEnumerator::next()
 {
     bool foundValid = false;
 
-    while (!foundValid && m_deviceType < CommonDeviceState::SUPPORTED_CONTROLLER_TYPE_COUNT)
+    if (is_valid())
     {
-        if (cur_dev != nullptr)
-        {
-            cur_dev = cur_dev->next;
-            foundValid = is_valid();
-        }
+        ++m_device_index;
+        foundValid = is_valid();
 
-        // If there are more device types to scan
-        // move on to the next vid/pid device enumeration
-        if (!foundValid && cur_dev == nullptr)
+        if (foundValid)
         {
-            m_deviceType = static_cast<CommonDeviceState::eDeviceType>(m_deviceType + 1);
-
-            // Free any previous enumeration
-            if (devs != nullptr)
-            {
-                hid_free_enumeration(devs);
-                cur_dev= nullptr;
-                devs= nullptr;
-            }
-
-            if (GET_DEVICE_TYPE_INDEX(m_deviceType) < MAX_CONTROLLER_TYPE_INDEX)
-            {
-                USBDeviceInfo &dev_info = g_supported_controller_infos[GET_DEVICE_TYPE_INDEX(m_deviceType)];
-
-                // Create a new HID enumeration
-                devs = hid_enumerate(dev_info.vendor_id, dev_info.product_id);
-                cur_dev = devs;
-                foundValid = is_valid();
-            }
+            m_deviceType = m_devices[m_device_index].device_type;
         }
     }
 
     return foundValid;
-}
\ No newline at end of file
+}
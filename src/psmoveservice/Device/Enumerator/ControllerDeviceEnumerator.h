@@ -3,6 +3,12 @@
 
 #include "DeviceEnumerator.h"
 
+#include <string>
+#include <vector>
+
+/// Captures the list of connected controllers when constructed.
+/// Because the hid enumeration is done up front, an enumerator can be built on the
+/// device enumeration thread and then iterated cheaply on the main thread.
 class ControllerDeviceEnumerator : public DeviceEnumerator
 {
 public:
@@ -16,8 +22,20 @@ public:
 
     bool get_serial_number(char *out_mb_serial, const size_t mb_buffer_size) const;
 
+protected:
+    void build_device_list();
+
 private:
-    struct hid_device_info *devs, *cur_dev;
+    struct ControllerDeviceInfo
+    {
+        CommonDeviceState::eDeviceType device_type;
+        std::string path;
+        std::string serial_number;
+        bool has_serial_number;
+    };
+
+    std::vector<ControllerDeviceInfo> m_devices;
+    int m_device_index;
 };
 
-#endif // CONTROLLER_DEVICE_ENUMERATOR_H
\ No newline at end of file
+#endif // CONTROLLER_DEVICE_ENUMERATOR_H
@@ -1,5 +1,6 @@
 // -- includes -----
 #include "TrackerDeviceEnumerator.h"
+#include "RemoteTracker.h"
 #include "ServerUtility.h"
 #include "assert.h"
 #include "libusb.h"
@@ -17,6 +18,7 @@
 // -- globals -----
 USBDeviceInfo g_supported_tracker_infos[MAX_CAMERA_TYPE_INDEX] = {
     { 0x1415, 0x2000 }, // PS3Eye
+    { 0x0000, 0x0000 }, // RemoteTracker (not a usb device)
     //{0x2833, 0x0201 }, // RiftDK2 Sensor
     //{0x045e, 0x02ae}, // V1 Kinect
 };
@@ -24,101 +26,60 @@ USBDeviceInfo g_supported_tracker_infos[MAX_CAMERA_TYPE_INDEX] = {
 // -- methods -----
 TrackerDeviceEnumerator::TrackerDeviceEnumerator()
     : DeviceEnumerator(CommonDeviceState::PS3EYE)
-    , usb_context(nullptr)
-    , devs(nullptr)
-    , cur_dev(nullptr)
-    , dev_index(0)
-    , dev_count(0)
-    , camera_index(-1)
+    , m_devices()
+    , m_device_index(0)
 {
     assert(m_deviceType >= 0 && GET_DEVICE_TYPE_INDEX(m_deviceType) < MAX_CAMERA_TYPE_INDEX);
 
-    libusb_init(&usb_context);
-    dev_count = static_cast<int>(libusb_get_device_list(usb_context, &devs));
-    cur_dev = (devs != nullptr) ? devs[0] : nullptr;
-    camera_index = 0;
-
-    if (!recompute_current_device_validity())
-    {
-        camera_index = -1;
-        next();
-    }
-    else
-    {
-        camera_index = 0;
-    }
+    build_device_list();
 }
 
 TrackerDeviceEnumerator::TrackerDeviceEnumerator(CommonDeviceState::eDeviceType deviceType)
     : DeviceEnumerator(deviceType)
-    , devs(nullptr)
-    , cur_dev(nullptr)
-    , dev_index(0)
-    , dev_count(0)
-    , camera_index(-1)
-    , dev_valid(false)
+    , m_devices()
+    , m_device_index(0)
 {
     assert(m_deviceType >= 0 && GET_DEVICE_TYPE_INDEX(m_deviceType) < MAX_CAMERA_TYPE_INDEX);
 
-    memset(dev_port_numbers, 255, sizeof(dev_port_numbers));
-
-    libusb_init(&usb_context);
-    dev_count = static_cast<int>(libusb_get_device_list(usb_context, &devs));
-    cur_dev = (devs != nullptr) ? devs[0] : nullptr;
+    build_device_list();
+}
 
-    if (!is_valid())
-    {
-        camera_index = -1;
-        next();
-    }
-    else
-    {
-        camera_index = 0;
-    }
+TrackerDeviceEnumerator::TrackerDeviceEnumerator(const TrackerDeviceInfo &device_info)
+    : DeviceEnumerator(device_info.device_type)
+    , m_devices(1, device_info)
+    , m_device_index(0)
+{
 }
 
 TrackerDeviceEnumerator::~TrackerDeviceEnumerator()
 {
-    if (devs != nullptr)
-    {
-        libusb_free_device_list(devs, 1);
-    }
-
-    libusb_exit(usb_context);
 }
 
 const char *TrackerDeviceEnumerator::get_path() const
 {
-    const char *result = nullptr;
-
-    if (cur_dev != nullptr)
-    {
-        struct libusb_device_descriptor dev_desc;
-        libusb_get_device_descriptor(cur_dev, &dev_desc);
-
-        snprintf(
-            (char *)(cur_path), sizeof(cur_path),
-            "USB\\VID_%04X&PID_%04X\\%d\\%d",
-            dev_desc.idVendor, dev_desc.idProduct, dev_index, camera_index);
-
-        result = cur_path;
-    }
+    return is_valid() ? m_devices[m_device_index].path.c_str() : nullptr;
+}
 
-    return result;
+int TrackerDeviceEnumerator::get_camera_index() const
+{
+    return is_valid() ? m_devices[m_device_index].camera_index : -1;
 }
 
 bool TrackerDeviceEnumerator::is_valid() const
 {
-    return dev_valid;
+    return m_device_index < static_cast<int>(m_devices.size());
 }
 
-bool TrackerDeviceEnumerator::recompute_current_device_validity()
+static bool is_supported_tracker_device(
+    const CommonDeviceState::eDeviceType device_type,
+    struct libusb_device *cur_dev,
+    uint8_t *dev_port_numbers)
 {
-    dev_valid = false;
+    bool dev_valid = false;
 
     if (cur_dev != nullptr)
     {
-        USBDeviceInfo &dev_info = g_supported_tracker_infos[GET_DEVICE_TYPE_INDEX(m_deviceType)];
+        USBDeviceInfo &dev_info = g_supported_tracker_infos[GET_DEVICE_TYPE_INDEX(device_type)];
         struct libusb_device_descriptor dev_desc;
 
         int libusb_result = libusb_get_device_descriptor(cur_dev, &dev_desc);
@@ -138,23 +99,16 @@ bool TrackerDeviceEnumerator::recompute_current_device_validity()
                 // (i.e. has a different device port path)
                 if (memcmp(port_numbers, dev_port_numbers, sizeof(port_numbers)) != 0)
                 {
-                    libusb_device_handle *devhandle;
-
-                    // Finally need to test that we can actually open the device
-                    // (or see that device is already open)
-                    libusb_result = libusb_open(cur_dev, &devhandle);
-                    if (libusb_result == LIBUSB_SUCCESS || libusb_result == LIBUSB_ERROR_ACCESS)
-                    {
-                        if (libusb_result == LIBUSB_SUCCESS)
-                        {
-                            libusb_close(devhandle);
-                        }
-
-                        // Cache the port number for the last valid device found
-                        memcpy(dev_port_numbers, port_numbers, sizeof(port_numbers));
-
-                        dev_valid = true;
-                    }
+                    // Deliberately not testing the device with libusb_open() here:
+                    // this runs on the device enumeration thread while the tracker
+                    // threads may be streaming from the very same cameras.
+                    // A camera that turns out not to be openable just fails in open()
+                    // and gets retried after the reconnect interval.
+
+                    // Cache the port number for the last valid device found
+                    memcpy(dev_port_numbers, port_numbers, sizeof(port_numbers));
+
+                    dev_valid = true;
                 }
             }
         }
@@ -167,31 +121,98 @@ bool TrackerDeviceEnumerator::next()
 {
     bool foundValid = false;
 
-    while (cur_dev != nullptr && !foundValid)
+    if (is_valid())
+    {
+        ++m_device_index;
+        foundValid = is_valid();
+
+        if (foundValid)
+        {
+            m_deviceType = m_devices[m_device_index].device_type;
+        }
+    }
+
+    return foundValid;
+}
+
+TrackerDeviceEnumerator *TrackerDeviceEnumerator::allocate_current_device_snapshot() const
+{
+    return is_valid() ? new TrackerDeviceEnumerator(m_devices[m_device_index]) : nullptr;
+}
+
+void TrackerDeviceEnumerator::build_device_list()
+{
+    struct libusb_context* usb_context = nullptr;
+    struct libusb_device **devs = nullptr;
+    uint8_t last_port_numbers[MAX_USB_DEVICE_PORT_PATH];
+    int camera_index = 0;
+
+    memset(last_port_numbers, 255, sizeof(last_port_numbers));
+
+    // Only reads the bus topology and device descriptors, no device is opened
+    libusb_init(&usb_context);
+    const int dev_count = static_cast<int>(libusb_get_device_list(usb_context, &devs));
+
+    // Walk the usb device list once for every supported camera type,
+    // starting from the device type this enumerator was created with
+    for (int type_index = GET_DEVICE_TYPE_INDEX(m_deviceType); type_index < MAX_CAMERA_TYPE_INDEX; ++type_index)
     {
-        ++dev_index;
-        cur_dev = (dev_index < dev_count) ? devs[dev_index] : nullptr;
-        foundValid = recompute_current_device_validity();
-
-        // If there are more device types to scan
-        // move on to the next vid/pid device enumeration
-        if (cur_dev == nullptr &&
-            GET_DEVICE_TYPE_CLASS(m_deviceType + 1) == CommonDeviceState::TrackingCamera &&
-            (m_deviceType + 1) < CommonDeviceState::SUPPORTED_CAMERA_TYPE_COUNT)
+        const CommonDeviceState::eDeviceType device_type =
+            static_cast<CommonDeviceState::eDeviceType>(GET_DEVICE_TYPE_CLASS(m_deviceType) + type_index);
+
+        // Remote trackers are found from the frames tracker nodes have sent, not on the usb bus
+        if (device_type == CommonDeviceState::RemoteTracker)
         {
-            m_deviceType = static_cast<CommonDeviceState::eDeviceType>(m_deviceType + 1);
+            std::vector<std::string> remote_device_paths;
+            RemoteTrackerRegistry::getInstance()->getActiveDevicePaths(remote_device_paths);
 
-            // Reset the device iterator
-            dev_index = 0;
-            cur_dev = (devs != nullptr) ? devs[0] : nullptr;
-            foundValid = recompute_current_device_validity();
+            for (const std::string &remote_device_path : remote_device_paths)
+            {
+                TrackerDeviceInfo device_info;
+                device_info.device_type = device_type;
+                device_info.path = remote_device_path;
+                device_info.camera_index = -1;
+                m_devices.push_back(device_info);
+            }
+
+            continue;
+        }
+
+        for (int dev_index = 0; devs != nullptr && dev_index < dev_count; ++dev_index)
+        {
+            struct libusb_device *dev = devs[dev_index];
+
+            if (is_supported_tracker_device(device_type, dev, last_port_numbers))
+            {
+                struct libusb_device_descriptor dev_desc;
+                char dev_path[256];
+
+                libusb_get_device_descriptor(dev, &dev_desc);
+                snprintf(
+                    dev_path, sizeof(dev_path),
+                    "USB\\VID_%04X&PID_%04X\\%d\\%d",
+                    dev_desc.idVendor, dev_desc.idProduct, dev_index, camera_index);
+
+                TrackerDeviceInfo device_info;
+                device_info.device_type = device_type;
+                device_info.path = dev_path;
+                device_info.camera_index = camera_index;
+                m_devices.push_back(device_info);
+
+                ++camera_index;
+            }
         }
     }
 
-    if (foundValid)
+    if (devs != nullptr)
     {
-        ++camera_index;
+        libusb_free_device_list(devs, 1);
     }
 
-    return foundValid;
+    libusb_exit(usb_context);
+
+    if (is_valid())
+    {
+        m_deviceType = m_devices[m_device_index].device_type;
+    }
 }
\ No newline at end of file
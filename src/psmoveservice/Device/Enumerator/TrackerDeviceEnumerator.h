@@ -3,6 +3,12 @@
 
 #include "DeviceEnumerator.h"
 
+#include <string>
+#include <vector>
+
+/// Captures the list of connected tracking cameras when constructed.
+/// Because the libusb enumeration is done up front, an enumerator can be built on the
+/// device enumeration thread and then iterated cheaply on the main thread.
 class TrackerDeviceEnumerator : public DeviceEnumerator
 {
 public:
@@ -13,19 +19,26 @@ public:
     bool is_valid() const override;
     bool next() override;
     const char *get_path() const override;
-    inline int get_camera_index() const { return camera_index; }
+    int get_camera_index() const;
+
+    /// Makes an enumerator holding only the current device (ex: to open it on another thread)
+    TrackerDeviceEnumerator *allocate_current_device_snapshot() const;
 
 protected:
-    bool recompute_current_device_validity();
+    void build_device_list();
 
 private:
-    char cur_path[256];
-    struct libusb_context* usb_context;
-    struct libusb_device **devs, *cur_dev;
-    unsigned char dev_port_numbers[MAX_USB_DEVICE_PORT_PATH];
-    int dev_index, dev_count;
-    int camera_index;
-    bool dev_valid;
+    struct TrackerDeviceInfo
+    {
+        CommonDeviceState::eDeviceType device_type;
+        std::string path;
+        int camera_index;
+    };
+
+    TrackerDeviceEnumerator(const TrackerDeviceInfo &device_info);
+
+    std::vector<TrackerDeviceInfo> m_devices;
+    int m_device_index;
 };
 
 #endif // TRACKER_DEVICE_ENUMERATOR_H
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define DEVICE_INTERFACE_H
 
 // -- includes -----
+#include <chrono>
 #include <string>
 #include <tuple>
 
@@ -175,7 +176,8 @@ struct CommonDeviceState
         SUPPORTED_CONTROLLER_TYPE_COUNT = Controller + 0x03,
         
         PS3EYE = TrackingCamera + 0x00,
-        SUPPORTED_CAMERA_TYPE_COUNT = TrackingCamera + 0x01,
+        RemoteTracker = TrackingCamera + 0x01,
+        SUPPORTED_CAMERA_TYPE_COUNT = TrackingCamera + 0x02,
     };
     
     eDeviceType DeviceType;
@@ -210,6 +212,9 @@ struct CommonDeviceState
         case PS3EYE:
             result = "PSEYE";
             break;
+        case RemoteTracker:
+            result = "RemoteTracker";
+            break;
         default:
             result = "UNKNOWN";
         }
@@ -248,7 +253,13 @@ struct CommonControllerState : CommonDeviceState
     enum BatteryLevel Battery;
     unsigned int AllButtons;                    // all-buttons, used to detect changes
 
-    //TODO: high-precision timestamp. Need to do in hidapi?
+    // Time since the previous report, measured with the controller's own timestamp counter.
+    // Not valid for the first report after opening the controller or after a long stall.
+    float TimeDeltaSeconds;
+    bool bTimeDeltaValid;
+
+    // Number of reports missing between the previous report and this one
+    int DroppedReportCount;
     
     inline CommonControllerState()
     {
@@ -261,9 +272,181 @@ struct CommonControllerState : CommonDeviceState
         DeviceType= SUPPORTED_CONTROLLER_TYPE_COUNT; // invalid
         Battery= Batt_MAX;
         AllButtons= 0;
+        TimeDeltaSeconds= 0.f;
+        bTimeDeltaValid= false;
+        DroppedReportCount= 0;
+    }
+};
+
+// Input report counters for a controller
+struct CommonControllerReportStatistics
+{
+    unsigned int ReceivedReportCount;
+    unsigned int DroppedReportCount;
+    float ReportRate; // received reports per second, by the controller's clock
+
+    inline CommonControllerReportStatistics()
+    {
+        clear();
+    }
+
+    inline void clear()
+    {
+        ReceivedReportCount= 0;
+        DroppedReportCount= 0;
+        ReportRate= 0.f;
+    }
+
+    inline float getPacketLossFraction() const
+    {
+        const unsigned int expected_report_count= ReceivedReportCount + DroppedReportCount;
+
+        return (expected_report_count > 0) 
+            ? static_cast<float>(DroppedReportCount) / static_cast<float>(expected_report_count)
+            : 0.f;
     }
 };
 
+// Turns the wrapping timestamp and sequence counters found in controller input reports
+// into a time delta and a dropped report count for each report.
+// If the length of a timestamp tick isn't known (pass 0), it is measured from the
+// arrival times of back-to-back reports first, and no time deltas are reported until then.
+class ControllerReportClock
+{
+public:
+    // How much back-to-back report arrival time to average over when measuring the tick length
+    static const int k_tick_measurement_milliseconds= 2000;
+    // Back-to-back reports that arrive further apart than this are left out of the tick measurement
+    static const int k_tick_measurement_max_gap_milliseconds= 100;
+
+    ControllerReportClock(
+        int timestamp_bits, 
+        float timestamp_tick_seconds, 
+        int sequence_bits, 
+        float nominal_report_interval_seconds)
+        : m_timestamp_mask((1u << timestamp_bits) - 1)
+        , m_timestamp_tick_seconds(timestamp_tick_seconds)
+        , m_sequence_modulus(1 << sequence_bits)
+        , m_nominal_report_interval_seconds(nominal_report_interval_seconds)
+        , m_measured_tick_count(0.0)
+        , m_measured_arrival_seconds(0.0)
+    {
+        reset();
+    }
+
+    // Call when the controller is (re)opened.
+    // A measured tick length is kept since it's a property of the controller hardware.
+    inline void reset()
+    {
+        m_bHasLastReport= false;
+        m_last_raw_timestamp= 0;
+        m_last_raw_sequence= 0;
+        m_last_arrival_time= std::chrono::time_point<std::chrono::high_resolution_clock>();
+        m_average_report_interval_seconds= m_nominal_report_interval_seconds;
+    }
+
+    // Returns 0 while the tick length is still being measured
+    inline float getTimestampTickSeconds() const
+    {
+        return m_timestamp_tick_seconds;
+    }
+
+    // Fills in TimeDeltaSeconds, bTimeDeltaValid and DroppedReportCount on the given state
+    void processReport(
+        unsigned int raw_timestamp, 
+        int raw_sequence, 
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &arrival_time,
+        CommonControllerState &state)
+    {
+        state.TimeDeltaSeconds= 0.f;
+        state.bTimeDeltaValid= false;
+        state.DroppedReportCount= 0;
+
+        if (m_bHasLastReport)
+        {
+            const std::chrono::duration<float> arrival_delta= arrival_time - m_last_arrival_time;
+            const unsigned int timestamp_ticks= (raw_timestamp - m_last_raw_timestamp) & m_timestamp_mask;
+            int sequence_step= ((raw_sequence - m_last_raw_sequence) % m_sequence_modulus + m_sequence_modulus) % m_sequence_modulus;
+
+            if (m_timestamp_tick_seconds <= 0.f)
+            {
+                measure_tick_length(timestamp_ticks, sequence_step, arrival_delta.count());
+            }
+            else
+            {
+                const float timestamp_period= static_cast<float>(m_timestamp_mask + 1) * m_timestamp_tick_seconds;
+
+                // The timestamp counter can't tell how many times it wrapped, 
+                // so only trust it when the reports arrived less than one counter period apart
+                if (timestamp_ticks > 0 && arrival_delta.count() < timestamp_period)
+                {
+                    state.TimeDeltaSeconds= static_cast<float>(timestamp_ticks) * m_timestamp_tick_seconds;
+                    state.bTimeDeltaValid= true;
+
+                    // The sequence counter wraps after only a few reports.
+                    // Use the timestamp to count any whole wraps it can't see.
+                    const float estimated_step= state.TimeDeltaSeconds / m_average_report_interval_seconds;
+                    const int missed_wraps= 
+                        static_cast<int>((estimated_step - static_cast<float>(sequence_step)) / static_cast<float>(m_sequence_modulus) + 0.5f);
+
+                    if (missed_wraps > 0)
+                    {
+                        sequence_step+= missed_wraps * m_sequence_modulus;
+                    }
+
+                    // Track the actual report interval using back-to-back reports
+                    if (sequence_step == 1)
+                    {
+                        m_average_report_interval_seconds+= 
+                            0.05f * (state.TimeDeltaSeconds - m_average_report_interval_seconds);
+                    }
+                }
+            }
+
+            state.DroppedReportCount= (sequence_step > 1) ? sequence_step - 1 : 0;
+        }
+
+        m_last_raw_timestamp= raw_timestamp;
+        m_last_raw_sequence= raw_sequence;
+        m_last_arrival_time= arrival_time;
+        m_bHasLastReport= true;
+    }
+
+private:
+    // Averages timestamp ticks against arrival time over back-to-back reports.
+    // Individual arrival times jitter with the USB/Bluetooth polling, but the sum doesn't drift.
+    void measure_tick_length(unsigned int timestamp_ticks, int sequence_step, float arrival_delta_seconds)
+    {
+        if (sequence_step == 1 && 
+            timestamp_ticks > 0 && 
+            arrival_delta_seconds > 0.f &&
+            arrival_delta_seconds < static_cast<float>(k_tick_measurement_max_gap_milliseconds) / 1000.f)
+        {
+            m_measured_tick_count+= static_cast<double>(timestamp_ticks);
+            m_measured_arrival_seconds+= static_cast<double>(arrival_delta_seconds);
+
+            if (m_measured_arrival_seconds >= static_cast<double>(k_tick_measurement_milliseconds) / 1000.0)
+            {
+                m_timestamp_tick_seconds= static_cast<float>(m_measured_arrival_seconds / m_measured_tick_count);
+            }
+        }
+    }
+
+    const unsigned int m_timestamp_mask;
+    float m_timestamp_tick_seconds;
+    const int m_sequence_modulus;
+    const float m_nominal_report_interval_seconds;
+
+    double m_measured_tick_count;
+    double m_measured_arrival_seconds;
+
+    bool m_bHasLastReport;
+    unsigned int m_last_raw_timestamp;
+    int m_last_raw_sequence;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_last_arrival_time;
+    float m_average_report_interval_seconds;
+};
+
 struct CommonDeviceTrackingShape
 {
     union{
@@ -382,6 +565,7 @@ public:
         CL,
         CLMulti,
         Generic_Webcam,
+        Network,
 
         SUPPORTED_DRIVER_TYPE_COUNT,
     };
@@ -399,6 +583,25 @@ public:
     // Returns a pointer to the last video frame buffer captured
     virtual const unsigned char *getVideoFrameBuffer() const = 0;
 
+    // Sets the buffer the next video frame gets written into (at least stride*height bytes).
+    // Pass nullptr to have the tracker use its own buffer.
+    // The caller keeps the buffer alive for as long as getVideoFrameBuffer() may return it.
+    virtual void setVideoFrameTargetBuffer(unsigned char *buffer) = 0;
+
+    // Returns when the last video frame was captured.
+    // Taken as close to the camera's USB transfer completing as the driver allows.
+    virtual std::chrono::time_point<std::chrono::high_resolution_clock> getFrameCaptureTimestamp() const = 0;
+
+    // Returns the sequence number of the last video frame (-1 if no frame yet).
+    // A gap in the sequence means frames were dropped.
+    virtual int getFrameSequenceNumber() const = 0;
+
+    // Returns the number of video frames dropped since the tracker was opened
+    virtual int getDroppedFrameCount() const = 0;
+
+    // Returns the rate the camera is delivering video frames at (0 if not known)
+    virtual double getFrameRate() const = 0;
+
     static const char *getDriverTypeString(eDriverType device_type)
     {
         const char *result = nullptr;
@@ -417,6 +620,9 @@ public:
         case Generic_Webcam:
             result = "Generic_Webcam";
             break;
+        case Network:
+            result = "Network";
+            break;
         default:
             result = "UNKNOWN";
         }
@@ -2,17 +2,24 @@
 #include "ControllerManager.h"
 #include "BluetoothQueries.h"
 #include "ControllerDeviceEnumerator.h"
+#include "ControllerOpticalPoseStorage.h"
+#include "JobSystem.h"
 #include "OrientationFilter.h"
 #include "ServerLog.h"
 #include "ServerControllerView.h"
 #include "ServerDeviceView.h"
+#include "ServerTrackerView.h"
 #include "ServerNetworkManager.h"
 #include "ServerUtility.h"
 #include "hidapi.h"
 
 //-- methods -----
 ControllerManager::ControllerManager()
-    : DeviceTypeManager(1000, 2)
+    : DeviceTypeManager(1000, 2, k_default_max_devices)
+    , tracker_max_device_count(TrackerManager::k_default_max_devices)
+    , m_updating_controllers()
+    , m_updating_controller_count(0)
+    , m_optical_pose_storage(nullptr)
 {
 }
 
@@ -21,20 +28,32 @@ ControllerManager::startup()
 {
     bool success = true;
 
-    if (!DeviceTypeManager::startup())
+    // Initialize HIDAPI
+    // (needs to happen before the base startup kicks off the device enumeration thread)
+    if (hid_init() == -1)
     {
+        SERVER_LOG_ERROR("ControllerManager::startup") << "Failed to initialize HIDAPI";
         success = false;
     }
 
     if (success)
     {
-        // Initialize HIDAPI
-        if (hid_init() == -1)
-        {
-            SERVER_LOG_ERROR("ControllerManager::startup") << "Failed to initialize HIDAPI";
-            success = false;
-        }
+        // Controllers opened by the base startup's enumeration point into this
+        m_optical_pose_storage = new ControllerOpticalPoseStorage(getMaxDevices(), tracker_max_device_count);
+    }
+
+    if (success && !DeviceTypeManager::startup())
+    {
+        success = false;
+    }
 
+    if (success)
+    {
+        m_updating_controllers.resize(getMaxDevices(), nullptr);
+    }
+
+    if (success)
+    {
         // Put all of the available tracking colors in the queue
         for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
         {
@@ -58,23 +77,58 @@ ControllerManager::shutdown()
 {
     DeviceTypeManager::shutdown();
 
+    // All of the controller views have been closed and let go of their slices
+    if (m_optical_pose_storage != nullptr)
+    {
+        delete m_optical_pose_storage;
+        m_optical_pose_storage = nullptr;
+    }
+
     // Shutdown HIDAPI
     hid_exit();
 }
 
 void
-ControllerManager::updateStateAndPredict(TrackerManager* tracker_manager)
+ControllerManager::updateStateAndPredict(TrackerManager* tracker_manager, JobSystem *job_system)
 {
+    m_updating_controller_count = 0;
+
     for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
     {
         ServerControllerViewPtr controllerView = getControllerViewPtr(device_id);
 
 		if (controllerView->getIsOpen() && controllerView->getIsBluetooth())
 		{
-			controllerView->updateOpticalPoseEstimation(tracker_manager);
-			controllerView->updateStateAndPredict();
+            controllerView->scheduleOpticalPoseEstimation(tracker_manager);
+
+            m_updating_controllers[m_updating_controller_count] = controllerView.get();
+            ++m_updating_controller_count;
 		}
     }
+
+    // Blob tracking: one job per tracker.
+    // A tracker's video buffers are scratch space for every controller it looks for,
+    // so all of the controllers for one tracker run in order on the same job.
+    job_system->parallelFor(
+        tracker_manager->getMaxDevices(),
+        [this, tracker_manager](int tracker_id) {
+            ServerTrackerViewPtr trackerView = tracker_manager->getTrackerViewPtr(tracker_id);
+
+            for (int list_index = 0; list_index < m_updating_controller_count; ++list_index)
+            {
+                m_updating_controllers[list_index]->computeTrackerPoseEstimate(trackerView.get(), tracker_id);
+            }
+        });
+
+    // Optical pose fusion and filtering: one job per controller
+    job_system->parallelFor(
+        m_updating_controller_count,
+        [this, tracker_manager](int list_index) {
+            ServerControllerView *controllerView = m_updating_controllers[list_index];
+
+			controllerView->updateOpticalPoseEstimation(tracker_manager);
+			controllerView->updateStateAndPredict();
+        });
 }
 
 DeviceEnumerator *
@@ -101,7 +155,7 @@ ControllerManager::setControllerRumble(
     float rumble_amount,
     CommonControllerState::RumbleChannel channel)
 {
-    if (ServerUtility::is_index_valid(controller_id, k_max_devices))
+    if (ServerUtility::is_index_valid(controller_id, getMaxDevices()))
     {
         getControllerViewPtr(controller_id)->setControllerRumble(rumble_amount, channel);
     }
@@ -10,6 +10,7 @@
 
 #include <memory>
 #include <deque>
+#include <vector>
 
 //-- typedefs -----
 class ServerControllerView;
@@ -27,12 +28,22 @@ public:
     /// Call hid_close()
     void shutdown() override;
     
-    void updateStateAndPredict(TrackerManager* tracker_manager);
+    /// Runs the per tracker blob tracking and the per controller filtering on the job system's threads
+    /// and returns once all of it is done (before anything gets published)
+    void updateStateAndPredict(TrackerManager* tracker_manager, class JobSystem *job_system);
 
-    static const int k_max_devices = 5;
-    int getMaxDevices() const override
+    /// Controller slots used when the device manager config doesn't specify a count
+    static const int k_default_max_devices = 5;
+    /// Upper limit on controller slots (see PSMOVESERVICE_MAX_CONTROLLER_COUNT on the client)
+    static const int k_max_supported_devices = 16;
+
+    /// Tracker slots each controller keeps an optical pose estimate for (set before startup, like max_device_count)
+    int tracker_max_device_count;
+
+    /// The per tracker optical pose state of every controller slot (null outside of startup/shutdown)
+    inline class ControllerOpticalPoseStorage *getOpticalPoseStorage() const
     {
-        return ControllerManager::k_max_devices;
+        return m_optical_pose_storage;
     }
 
     inline std::string getCachedBluetoothHostAddress() const
@@ -54,6 +65,11 @@ protected:
     void free_device_enumerator(class DeviceEnumerator *) override;
     ServerDeviceView *allocate_device_view(int device_id) override;
 
+    CommonDeviceState::eDeviceClass getDeviceClass() const override
+    {
+        return CommonDeviceState::Controller;
+    }
+
     const PSMoveProtocol::Response_ResponseType getListUpdatedResponseType() override
     {
         return ControllerManager::k_list_udpated_response_type;
@@ -63,6 +79,13 @@ private:
     static const PSMoveProtocol::Response_ResponseType k_list_udpated_response_type = PSMoveProtocol::Response_ResponseType_CONTROLLER_LIST_UPDATED;
     std::deque<eCommonTrackingColorID> m_available_controller_color_ids;
     std::string m_bluetooth_host_address;
+
+    // Controllers being updated this tick (sized to the controller capacity at startup)
+    std::vector<ServerControllerView *> m_updating_controllers;
+    int m_updating_controller_count;
+
+    // Sized to controller capacity x tracker capacity at startup
+    class ControllerOpticalPoseStorage *m_optical_pose_storage;
 };
 
 #endif // CONTROLLER_MANAGER_H
\ No newline at end of file
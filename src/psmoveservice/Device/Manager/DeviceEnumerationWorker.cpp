@@ -0,0 +1,406 @@
+//-- includes -----
+#include "DeviceEnumerationWorker.h"
+#include "DeviceEnumerator.h"
+#include "ServerLog.h"
+#include "ThreadScheduling.h"
+
+#include <cassert>
+#include <chrono>
+
+#if defined(__linux__)
+#include <libudev.h>
+#include <poll.h>
+#elif defined(HAVE_PS3EYE)
+#include "libusb.h"
+#endif
+
+//-- constants -----
+// How long the worker blocks waiting on hotplug events before checking for requests
+static const int k_hotplug_wait_timeout_ms = 100;
+
+// Devices show up as a burst of events and aren't always ready to open right away.
+// Wait for the event stream to go quiet for this long before enumerating.
+static const int k_hotplug_settle_time_ms = 250;
+
+//-- private definitions -----
+class IDeviceHotplugNotifier
+{
+public:
+    virtual ~IDeviceHotplugNotifier() {}
+
+    virtual bool startup(CommonDeviceState::eDeviceClass device_class) = 0;
+    virtual void shutdown() = 0;
+
+    // Blocks for at most timeout_ms.
+    // Returns true if any device of the watched class was added or removed.
+    virtual bool wait_for_device_change(int timeout_ms) = 0;
+};
+
+#if defined(__linux__)
+// Watches udev for hidraw (controllers) or usb (cameras) device arrival/removal
+class UdevHotplugNotifier : public IDeviceHotplugNotifier
+{
+public:
+    UdevHotplugNotifier()
+        : m_udev(nullptr)
+        , m_monitor(nullptr)
+    {
+    }
+
+    bool startup(CommonDeviceState::eDeviceClass device_class) override
+    {
+        bool bSuccess = false;
+
+        m_udev = udev_new();
+        if (m_udev != nullptr)
+        {
+            m_monitor = udev_monitor_new_from_netlink(m_udev, "udev");
+        }
+
+        if (m_monitor != nullptr)
+        {
+            if (device_class == CommonDeviceState::Controller)
+            {
+                // Covers both USB and Bluetooth connected controllers
+                udev_monitor_filter_add_match_subsystem_devtype(m_monitor, "hidraw", nullptr);
+            }
+            else
+            {
+                udev_monitor_filter_add_match_subsystem_devtype(m_monitor, "usb", "usb_device");
+            }
+
+            bSuccess = udev_monitor_enable_receiving(m_monitor) >= 0;
+        }
+
+        if (!bSuccess)
+        {
+            shutdown();
+        }
+
+        return bSuccess;
+    }
+
+    void shutdown() override
+    {
+        if (m_monitor != nullptr)
+        {
+            udev_monitor_unref(m_monitor);
+            m_monitor = nullptr;
+        }
+
+        if (m_udev != nullptr)
+        {
+            udev_unref(m_udev);
+            m_udev = nullptr;
+        }
+    }
+
+    bool wait_for_device_change(int timeout_ms) override
+    {
+        struct pollfd monitor_fd;
+        bool bDeviceChanged = false;
+
+        monitor_fd.fd = udev_monitor_get_fd(m_monitor);
+        monitor_fd.events = POLLIN;
+        monitor_fd.revents = 0;
+
+        if (poll(&monitor_fd, 1, timeout_ms) > 0)
+        {
+            // Drain every pending event (the monitor socket is non-blocking)
+            struct udev_device *dev;
+
+            while ((dev = udev_monitor_receive_device(m_monitor)) != nullptr)
+            {
+                bDeviceChanged = true;
+                udev_device_unref(dev);
+            }
+        }
+
+        return bDeviceChanged;
+    }
+
+private:
+    struct udev *m_udev;
+    struct udev_monitor *m_monitor;
+};
+#elif defined(HAVE_PS3EYE) && defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000102)
+// Uses libusb's hotplug support to watch for cameras (not available on Windows)
+class LibUSBHotplugNotifier : public IDeviceHotplugNotifier
+{
+public:
+    LibUSBHotplugNotifier()
+        : m_usb_context(nullptr)
+        , m_callback_handle(0)
+        , m_callback_registered(false)
+        , m_device_changed(false)
+    {
+    }
+
+    bool startup(CommonDeviceState::eDeviceClass device_class) override
+    {
+        bool bSuccess = false;
+
+        // Controllers are HID devices which libusb can't see on all platforms.
+        // This is a private libusb context that only listens for arrival/removal
+        // events; it never opens the cameras the tracker threads are capturing from.
+        if (device_class == CommonDeviceState::TrackingCamera &&
+            libusb_init(&m_usb_context) == LIBUSB_SUCCESS)
+        {
+            if (libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG))
+            {
+                int result = 
+                    libusb_hotplug_register_callback(
+                        m_usb_context,
+                        static_cast<libusb_hotplug_event>(LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT),
+                        static_cast<libusb_hotplug_flag>(0),
+                        LIBUSB_HOTPLUG_MATCH_ANY,
+                        LIBUSB_HOTPLUG_MATCH_ANY,
+                        LIBUSB_HOTPLUG_MATCH_ANY,
+                        &LibUSBHotplugNotifier::hotplug_callback,
+                        this,
+                        &m_callback_handle);
+
+                m_callback_registered = (result == LIBUSB_SUCCESS);
+                bSuccess = m_callback_registered;
+            }
+        }
+
+        if (!bSuccess)
+        {
+            shutdown();
+        }
+
+        return bSuccess;
+    }
+
+    void shutdown() override
+    {
+        if (m_callback_registered)
+        {
+            libusb_hotplug_deregister_callback(m_usb_context, m_callback_handle);
+            m_callback_registered = false;
+        }
+
+        if (m_usb_context != nullptr)
+        {
+            libusb_exit(m_usb_context);
+            m_usb_context = nullptr;
+        }
+    }
+
+    bool wait_for_device_change(int timeout_ms) override
+    {
+        struct timeval timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+        // Hotplug callbacks get dispatched from inside the event handler
+        libusb_handle_events_timeout_completed(m_usb_context, &timeout, nullptr);
+
+        bool bDeviceChanged = m_device_changed;
+        m_device_changed = false;
+
+        return bDeviceChanged;
+    }
+
+private:
+    static int LIBUSB_CALL hotplug_callback(
+        libusb_context *ctx,
+        libusb_device *device,
+        libusb_hotplug_event event,
+        void *user_data)
+    {
+        reinterpret_cast<LibUSBHotplugNotifier *>(user_data)->m_device_changed = true;
+
+        // Keep the callback registered
+        return 0;
+    }
+
+    libusb_context *m_usb_context;
+    libusb_hotplug_callback_handle m_callback_handle;
+    bool m_callback_registered;
+    bool m_device_changed;
+};
+#endif
+
+static IDeviceHotplugNotifier *
+allocate_hotplug_notifier(CommonDeviceState::eDeviceClass device_class)
+{
+    IDeviceHotplugNotifier *notifier = nullptr;
+
+#if defined(__linux__)
+    notifier = new UdevHotplugNotifier();
+#elif defined(HAVE_PS3EYE) && defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000102)
+    notifier = new LibUSBHotplugNotifier();
+#endif
+
+    if (notifier != nullptr && !notifier->startup(device_class))
+    {
+        delete notifier;
+        notifier = nullptr;
+    }
+
+    return notifier;
+}
+
+//-- methods -----
+DeviceEnumerationWorker::DeviceEnumerationWorker(
+    const std::string &name,
+    CommonDeviceState::eDeviceClass device_class,
+    t_allocate_enumerator allocate_enumerator,
+    t_free_enumerator free_enumerator)
+    : m_name(name)
+    , m_device_class(device_class)
+    , m_allocate_enumerator(allocate_enumerator)
+    , m_free_enumerator(free_enumerator)
+    , m_hotplug_notifier(nullptr)
+    , m_thread_running(false)
+    , m_stop_requested(false)
+    , m_enumeration_requested(false)
+    , m_enumeration_result(nullptr)
+{
+}
+
+DeviceEnumerationWorker::~DeviceEnumerationWorker()
+{
+    assert(!m_thread_running);
+    assert(m_hotplug_notifier == nullptr);
+    assert(m_enumeration_result == nullptr);
+}
+
+bool
+DeviceEnumerationWorker::startup()
+{
+    assert(!m_thread_running);
+
+    m_hotplug_notifier = allocate_hotplug_notifier(m_device_class);
+
+    if (m_hotplug_notifier != nullptr)
+    {
+        SERVER_LOG_INFO("DeviceEnumerationWorker::startup") << m_name << " - Using hotplug notifications";
+    }
+    else
+    {
+        SERVER_LOG_INFO("DeviceEnumerationWorker::startup") << m_name << " - Hotplug notifications unavailable, falling back to polling";
+    }
+
+    m_stop_requested = false;
+    m_thread_running = true;
+    m_thread = std::thread(&DeviceEnumerationWorker::thread_func, this);
+
+    return true;
+}
+
+void
+DeviceEnumerationWorker::shutdown()
+{
+    if (m_thread_running)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_stop_requested = true;
+            m_condition.notify_one();
+        }
+
+        m_thread.join();
+        m_thread_running = false;
+    }
+
+    if (m_hotplug_notifier != nullptr)
+    {
+        m_hotplug_notifier->shutdown();
+        delete m_hotplug_notifier;
+        m_hotplug_notifier = nullptr;
+    }
+
+    // Free any result the main thread never picked up
+    if (m_enumeration_result != nullptr)
+    {
+        m_free_enumerator(m_enumeration_result);
+        m_enumeration_result = nullptr;
+    }
+}
+
+void
+DeviceEnumerationWorker::request_enumeration()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_enumeration_requested = true;
+    m_condition.notify_one();
+}
+
+DeviceEnumerator *
+DeviceEnumerationWorker::take_enumeration_result()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    DeviceEnumerator *result = m_enumeration_result;
+    m_enumeration_result = nullptr;
+
+    return result;
+}
+
+void
+DeviceEnumerationWorker::thread_func()
+{
+    ThreadScheduling::applyToCurrentThread(_threadRole_background, "psm-enum");
+
+    for (;;)
+    {
+        bool bEnumerate = false;
+
+        // See if we've been asked to stop or to do an enumeration
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            // Without a hotplug notifier there's nothing else to wait on
+            if (m_hotplug_notifier == nullptr && !m_stop_requested && !m_enumeration_requested)
+            {
+                m_condition.wait(lock);
+            }
+
+            if (m_stop_requested)
+            {
+                break;
+            }
+
+            bEnumerate = m_enumeration_requested;
+            m_enumeration_requested = false;
+        }
+
+        if (!bEnumerate && m_hotplug_notifier != nullptr)
+        {
+            if (m_hotplug_notifier->wait_for_device_change(k_hotplug_wait_timeout_ms))
+            {
+                // Let the burst of events from a single plug/unplug finish first
+                while (m_hotplug_notifier->wait_for_device_change(k_hotplug_settle_time_ms))
+                {
+                }
+
+                SERVER_MT_LOG_DEBUG("DeviceEnumerationWorker") << m_name << " - Hotplug event, refreshing device list";
+                bEnumerate = true;
+            }
+        }
+
+        if (bEnumerate)
+        {
+            DeviceEnumerator *enumerator = m_allocate_enumerator();
+            DeviceEnumerator *stale_enumerator = nullptr;
+
+            // Hand off the new device list, replacing any list the main thread hasn't picked up yet
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                stale_enumerator = m_enumeration_result;
+                m_enumeration_result = enumerator;
+            }
+
+            if (stale_enumerator != nullptr)
+            {
+                m_free_enumerator(stale_enumerator);
+            }
+        }
+    }
+}
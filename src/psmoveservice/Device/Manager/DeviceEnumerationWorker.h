@@ -0,0 +1,68 @@
+#ifndef DEVICE_ENUMERATION_WORKER_H
+#define DEVICE_ENUMERATION_WORKER_H
+
+//-- includes -----
+#include "DeviceInterface.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+//-- definitions -----
+/// Builds device enumerators on a background thread so that the main loop never
+/// has to walk the HID/USB device lists itself.
+/// An enumeration is kicked off whenever the platform reports a hotplug event
+/// (udev on Linux, libusb hotplug where available) or when explicitly requested.
+/// On platforms without hotplug notifications the owner falls back to requesting
+/// an enumeration every reconnect interval.
+class DeviceEnumerationWorker
+{
+public:
+    typedef std::function<class DeviceEnumerator *()> t_allocate_enumerator;
+    typedef std::function<void(class DeviceEnumerator *)> t_free_enumerator;
+
+    DeviceEnumerationWorker(
+        const std::string &name,
+        CommonDeviceState::eDeviceClass device_class,
+        t_allocate_enumerator allocate_enumerator,
+        t_free_enumerator free_enumerator);
+    virtual ~DeviceEnumerationWorker();
+
+    bool startup();
+    void shutdown();
+
+    /// True if the worker gets notified of device arrival/removal by the OS
+    inline bool getHasHotplugNotifications() const
+    {
+        return m_hotplug_notifier != nullptr;
+    }
+
+    /// Ask the worker to build a fresh device list. Safe to call from any thread.
+    void request_enumeration();
+
+    /// Returns the most recently built device list (or nullptr if nothing new is ready).
+    /// The caller takes ownership and must release it with the free function.
+    class DeviceEnumerator *take_enumeration_result();
+
+private:
+    void thread_func();
+
+    std::string m_name;
+    CommonDeviceState::eDeviceClass m_device_class;
+    t_allocate_enumerator m_allocate_enumerator;
+    t_free_enumerator m_free_enumerator;
+
+    class IDeviceHotplugNotifier *m_hotplug_notifier;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+    bool m_thread_running;
+    bool m_stop_requested;
+    bool m_enumeration_requested;
+    class DeviceEnumerator *m_enumeration_result;
+};
+
+#endif // DEVICE_ENUMERATION_WORKER_H
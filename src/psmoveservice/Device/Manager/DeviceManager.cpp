@@ -1,9 +1,12 @@
 //-- includes -----
 #include "DeviceManager.h"
 
+#include "AllocationTracker.h"
 #include "ControllerManager.h"
 #include "DeviceEnumerator.h"
+#include "JobSystem.h"
 #include "OrientationFilter.h"
+#include "PSMoveCalibrationCache.h"
 #include "ServerControllerView.h"
 #include "ServerTrackerView.h"
 #include "ServerRequestHandler.h"
@@ -11,9 +14,11 @@
 #include "ServerDeviceView.h"
 #include "ServerNetworkManager.h"
 #include "ServerUtility.h"
+#include "ThreadScheduling.h"
 #include "PSMoveProtocol.pb.h"
 #include "PSMoveConfig.h"
 #include "TrackerManager.h"
+#include <algorithm>
 #include <chrono>
 
 //-- constants -----
@@ -21,6 +26,10 @@ static const int k_default_controller_reconnect_interval= 1000; // ms
 static const int k_default_controller_poll_interval= 2; // ms
 static const int k_default_tracker_reconnect_interval= 10000; // ms
 static const int k_default_tracker_poll_interval= 13; // 1000/75 ms
+static const int k_default_job_thread_count= 0; // one per hardware thread
+static const int k_timing_stats_report_interval= 10000; // ms
+static const double k_late_wakeup_threshold_usec= 1000.0; // main loop wakeups later than this count as missed ticks
+static const char *k_thread_scheduling_sections[_threadRole_COUNT] = { "main_thread", "job_threads", "background_threads" };
 
 class DeviceManagerConfig : public PSMoveConfig
 {
@@ -31,6 +40,9 @@ public:
         , controller_poll_interval(k_default_controller_poll_interval)
         , tracker_reconnect_interval(k_default_tracker_reconnect_interval)
         , tracker_poll_interval(k_default_tracker_poll_interval)
+        , controller_max_count(ControllerManager::k_default_max_devices)
+        , tracker_max_count(TrackerManager::k_default_max_devices)
+        , job_thread_count(k_default_job_thread_count)
     {};
 
     const boost::property_tree::ptree
@@ -42,6 +54,20 @@ public:
         pt.put("controller_poll_interval", controller_poll_interval);
         pt.put("tracker_reconnect_interval", tracker_reconnect_interval);
         pt.put("tracker_poll_interval", tracker_poll_interval);
+        pt.put("controller_max_count", controller_max_count);
+        pt.put("tracker_max_count", tracker_max_count);
+        pt.put("job_thread_count", job_thread_count);
+
+        for (int role = 0; role < _threadRole_COUNT; ++role)
+        {
+            const ThreadSchedulingPolicy &policy = thread_scheduling.policies[role];
+            const std::string section = std::string("scheduling.") + k_thread_scheduling_sections[role];
+
+            pt.put(section + ".cpu_set", policy.cpu_set);
+            pt.put(section + ".realtime_priority", policy.realtime_priority);
+            pt.put(section + ".nice", policy.nice);
+        }
+        pt.put("scheduling.lock_memory", thread_scheduling.lock_memory);
 
         return pt;
     }
@@ -53,12 +79,91 @@ public:
         controller_poll_interval = pt.get<int>("controller_poll_interval", k_default_controller_poll_interval);
         tracker_reconnect_interval = pt.get<int>("tracker_reconnect_interval", k_default_tracker_reconnect_interval);
         tracker_poll_interval = pt.get<int>("tracker_poll_interval", k_default_tracker_poll_interval);
+        controller_max_count = pt.get<int>("controller_max_count", ControllerManager::k_default_max_devices);
+        tracker_max_count = pt.get<int>("tracker_max_count", TrackerManager::k_default_max_devices);
+        job_thread_count = pt.get<int>("job_thread_count", k_default_job_thread_count);
+
+        for (int role = 0; role < _threadRole_COUNT; ++role)
+        {
+            ThreadSchedulingPolicy &policy = thread_scheduling.policies[role];
+            const std::string section = std::string("scheduling.") + k_thread_scheduling_sections[role];
+
+            policy.cpu_set = pt.get<std::string>(section + ".cpu_set", "");
+            policy.realtime_priority = pt.get<int>(section + ".realtime_priority", 0);
+            policy.nice = pt.get<int>(section + ".nice", 0);
+        }
+        thread_scheduling.lock_memory = pt.get<bool>("scheduling.lock_memory", false);
     }
 
     int controller_reconnect_interval;
     int controller_poll_interval;
     int tracker_reconnect_interval;
     int tracker_poll_interval;
+    int controller_max_count;
+    int tracker_max_count;
+    // Threads (including the main thread) that share the per-tick tracking work.
+    // 0 uses one per hardware thread, 1 runs everything on the main thread.
+    int job_thread_count;
+    // CPU pinning, real-time priority and memory locking for the service threads.
+    // All off by default; anything the OS refuses is logged and skipped.
+    ThreadSchedulingSettings thread_scheduling;
+};
+
+// Measures how long the per-tick optical tracking and publish loops take.
+// Reported periodically at debug level so the cost of larger device capacities can be checked on a live rig,
+// and each completed window is kept for GET_SERVICE_STATS requests.
+struct DeviceManagerTimingStats
+{
+    std::chrono::time_point<std::chrono::high_resolution_clock> last_report_time;
+    double predict_total_usec;
+    double predict_max_usec;
+    double publish_total_usec;
+    double publish_max_usec;
+    int sample_count;
+    double wakeup_latency_total_usec;
+    double wakeup_latency_max_usec;
+    int wakeup_sample_count;
+    int late_wakeup_count;
+
+    DeviceManagerTimingStats()
+    {
+        last_report_time = std::chrono::high_resolution_clock::now();
+        reset();
+    }
+
+    void reset()
+    {
+        predict_total_usec = 0.0;
+        predict_max_usec = 0.0;
+        publish_total_usec = 0.0;
+        publish_max_usec = 0.0;
+        sample_count = 0;
+        wakeup_latency_total_usec = 0.0;
+        wakeup_latency_max_usec = 0.0;
+        wakeup_sample_count = 0;
+        late_wakeup_count = 0;
+    }
+
+    void add_sample(double predict_usec, double publish_usec)
+    {
+        predict_total_usec += predict_usec;
+        predict_max_usec = std::max(predict_max_usec, predict_usec);
+        publish_total_usec += publish_usec;
+        publish_max_usec = std::max(publish_max_usec, publish_usec);
+        ++sample_count;
+    }
+
+    void add_wakeup_sample(double latency_usec)
+    {
+        wakeup_latency_total_usec += latency_usec;
+        wakeup_latency_max_usec = std::max(wakeup_latency_max_usec, latency_usec);
+        ++wakeup_sample_count;
+
+        if (latency_usec > k_late_wakeup_threshold_usec)
+        {
+            ++late_wakeup_count;
+        }
+    }
 };
 
 // DeviceManager - This is the interface used by PSMoveService
@@ -66,6 +171,9 @@ DeviceManager *DeviceManager::m_instance= nullptr;
 
 DeviceManager::DeviceManager()
     : m_config() // NULL config until startup
+    , m_timing_stats(new DeviceManagerTimingStats)
+    , m_service_stats()
+    , m_job_system(nullptr)
     , m_controller_manager(new ControllerManager())
     , m_tracker_manager(new TrackerManager())
 {
@@ -75,13 +183,21 @@ DeviceManager::~DeviceManager()
 {
     delete m_controller_manager;
     delete m_tracker_manager;
+    delete m_timing_stats;
+
+    if (m_job_system != nullptr)
+    {
+        delete m_job_system;
+    }
 }
 
 bool
 DeviceManager::startup()
 {
+    typedef std::chrono::time_point<std::chrono::high_resolution_clock> t_startup_timestamp;
     bool success= true;
 
+    const t_startup_timestamp startup_begin = std::chrono::high_resolution_clock::now();
     m_config = DeviceManagerConfigPtr(new DeviceManagerConfig);
 
 	// Load the config from disk
@@ -89,15 +205,61 @@ DeviceManager::startup()
 
 	// Save the config back out again in case defaults changed
 	m_config->save();
+
+    // Before the managers start, so the enumeration workers pick up their policy.
+    // The main thread keeps its name, which on Linux is the process name.
+    ThreadScheduling::setSettings(m_config->thread_scheduling);
+    ThreadScheduling::applyToCurrentThread(_threadRole_main, nullptr);
+
+    // The log sink and the config writer may already be running, so they apply theirs on their own threads
+    log_set_sink_thread_initializer([]() {
+        ThreadScheduling::applyToCurrentThread(_threadRole_background, "psm-log");
+    });
+    PSMoveConfig::setWriterThreadInitializer([]() {
+        ThreadScheduling::applyToCurrentThread(_threadRole_background, "psm-config");
+    });
     
+    const t_startup_timestamp controller_startup_begin = std::chrono::high_resolution_clock::now();
     m_controller_manager->reconnect_interval = m_config->controller_reconnect_interval;
     m_controller_manager->poll_interval = m_config->controller_poll_interval;
+    m_controller_manager->max_device_count = 
+        std::max(std::min(m_config->controller_max_count, ControllerManager::k_max_supported_devices), 1);
+    m_tracker_manager->max_device_count =
+        std::max(std::min(m_config->tracker_max_count, TrackerManager::k_max_supported_devices), 1);
+    m_controller_manager->tracker_max_device_count = m_tracker_manager->max_device_count;
     success &= m_controller_manager->startup();
     
+    const t_startup_timestamp tracker_startup_begin = std::chrono::high_resolution_clock::now();
     m_tracker_manager->reconnect_interval = m_config->tracker_reconnect_interval;
     m_tracker_manager->poll_interval = m_config->tracker_poll_interval;
     success &= m_tracker_manager->startup();
 
+    SERVER_LOG_INFO("DeviceManager::startup") << "Device capacity: "
+        << m_controller_manager->getMaxDevices() << " controllers, "
+        << m_tracker_manager->getMaxDevices() << " trackers";
+
+    const t_startup_timestamp job_system_startup_begin = std::chrono::high_resolution_clock::now();
+    m_job_system = new JobSystem(
+        (m_config->job_thread_count > 0) ? m_config->job_thread_count : JobSystem::getDefaultThreadCount(),
+        [](int thread_index) {
+            char thread_name[16];
+
+            ServerUtility::format_string(thread_name, sizeof(thread_name), "psm-job%d", thread_index);
+            ThreadScheduling::applyToCurrentThread(_threadRole_job, thread_name);
+            AllocationTracker::trackCurrentThread();
+        });
+
+    SERVER_LOG_INFO("DeviceManager::startup") << "Tracking job threads: " << m_job_system->getThreadCount();
+
+    // Devices themselves are opened later on as the enumeration results come in
+    // (trackers on background threads), so this only covers getting the managers going
+    const t_startup_timestamp startup_end = std::chrono::high_resolution_clock::now();
+    SERVER_LOG_INFO("DeviceManager::startup") << "Startup phases: config " 
+        << std::chrono::duration<double, std::milli>(controller_startup_begin - startup_begin).count() << "ms, controller manager "
+        << std::chrono::duration<double, std::milli>(tracker_startup_begin - controller_startup_begin).count() << "ms, tracker manager "
+        << std::chrono::duration<double, std::milli>(job_system_startup_begin - tracker_startup_begin).count() << "ms, job system "
+        << std::chrono::duration<double, std::milli>(startup_end - job_system_startup_begin).count() << "ms";
+
     m_instance= this;
     
     return success;
@@ -109,10 +271,60 @@ DeviceManager::update()
     m_controller_manager->poll(); // Update controller counts and poll button/IMU state
     m_tracker_manager->poll(); // Update tracker count and poll video frames
 
-    m_controller_manager->updateStateAndPredict(m_tracker_manager); // Compute pose/prediction of tracking blob+IMU state
+    const std::chrono::time_point<std::chrono::high_resolution_clock> predict_start = std::chrono::high_resolution_clock::now();
+    m_controller_manager->updateStateAndPredict(m_tracker_manager, m_job_system); // Compute pose/prediction of tracking blob+IMU state
 
+    const std::chrono::time_point<std::chrono::high_resolution_clock> publish_start = std::chrono::high_resolution_clock::now();
     m_controller_manager->publish(); // publish controller state to any listening clients  (common case)
     m_tracker_manager->publish(); // publish tracker state to any listening clients (probably only used by ConfigTool)
+
+    const std::chrono::time_point<std::chrono::high_resolution_clock> publish_end = std::chrono::high_resolution_clock::now();
+    update_timing_stats(
+        std::chrono::duration<double, std::micro>(publish_start - predict_start).count(),
+        std::chrono::duration<double, std::micro>(publish_end - publish_start).count());
+}
+
+void
+DeviceManager::addWakeupLatencySample(double latency_usec)
+{
+    m_timing_stats->add_wakeup_sample(std::max(latency_usec, 0.0));
+}
+
+void
+DeviceManager::update_timing_stats(double predict_usec, double publish_usec)
+{
+    m_timing_stats->add_sample(predict_usec, publish_usec);
+
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<double, std::milli> report_diff = now - m_timing_stats->last_report_time;
+
+    if (report_diff.count() >= k_timing_stats_report_interval)
+    {
+        const double N = static_cast<double>(std::max(m_timing_stats->sample_count, 1));
+        const double wakeup_N = static_cast<double>(std::max(m_timing_stats->wakeup_sample_count, 1));
+
+        SERVER_LOG_DEBUG("DeviceManager::update") 
+            << "(" << m_controller_manager->getMaxDevices() << " controller slots, " 
+            << m_tracker_manager->getMaxDevices() << " tracker slots) "
+            << "updateStateAndPredict avg/max: " << m_timing_stats->predict_total_usec / N << "/" << m_timing_stats->predict_max_usec << "us, "
+            << "publish avg/max: " << m_timing_stats->publish_total_usec / N << "/" << m_timing_stats->publish_max_usec << "us, "
+            << "wakeup latency avg/max: " << m_timing_stats->wakeup_latency_total_usec / wakeup_N << "/" << m_timing_stats->wakeup_latency_max_usec << "us "
+            << "(" << m_timing_stats->late_wakeup_count << " over " << k_late_wakeup_threshold_usec << "us)";
+
+        m_service_stats.stats_window_seconds = report_diff.count() / 1000.0;
+        m_service_stats.update_count = m_timing_stats->sample_count;
+        m_service_stats.predict_avg_usec = m_timing_stats->predict_total_usec / N;
+        m_service_stats.predict_max_usec = m_timing_stats->predict_max_usec;
+        m_service_stats.publish_avg_usec = m_timing_stats->publish_total_usec / N;
+        m_service_stats.publish_max_usec = m_timing_stats->publish_max_usec;
+        m_service_stats.wakeup_latency_avg_usec = m_timing_stats->wakeup_latency_total_usec / wakeup_N;
+        m_service_stats.wakeup_latency_max_usec = m_timing_stats->wakeup_latency_max_usec;
+        m_service_stats.late_wakeup_count = m_timing_stats->late_wakeup_count;
+        m_service_stats.late_wakeup_threshold_usec = k_late_wakeup_threshold_usec;
+
+        m_timing_stats->reset();
+        m_timing_stats->last_report_time = now;
+    }
 }
 
 void
@@ -123,6 +335,21 @@ DeviceManager::shutdown()
     m_controller_manager->shutdown();
     m_tracker_manager->shutdown();
 
+    // Stop re-reading controllers before the HID library goes away
+    PSMoveCalibrationCache::getInstance().shutdown();
+
+    if (m_job_system != nullptr)
+    {
+        delete m_job_system;
+        m_job_system = nullptr;
+    }
+
+    // Make sure any config changes still waiting on the writer thread hit the disk
+    PSMoveConfig::flushDeferredSaves();
+
+    PSMoveConfig::setWriterThreadInitializer(std::function<void()>());
+    log_set_sink_thread_initializer(std::function<void()>());
+
     m_instance= nullptr;
 }
 
@@ -17,6 +17,19 @@ class ServerTrackerView;
 typedef std::shared_ptr<ServerTrackerView> ServerTrackerViewPtr;
 
 //-- definitions -----
+/// Main loop timing over the last completed stats window.
+/// Everything is 0 until the first window completes.
+struct DeviceManagerServiceStats
+{
+    double stats_window_seconds;
+    int update_count;
+    double predict_avg_usec, predict_max_usec;
+    double publish_avg_usec, publish_max_usec;
+    double wakeup_latency_avg_usec, wakeup_latency_max_usec;
+    int late_wakeup_count;
+    double late_wakeup_threshold_usec;
+};
+
 /// This is the class that is actually used by the PSMoveService.
 class DeviceManager
 {
@@ -28,6 +41,14 @@ public:
     void update();  /**< Poll all connected devices for each specific manager. */
     void shutdown();/**< Shutdown the interfaces for each specific manager. */
 
+    /// How much later than requested the main loop woke up from its sleep.
+    /// Reported with the rest of the update timing stats.
+    void addWakeupLatencySample(double latency_usec);
+
+    /// The main loop timing and scheduling latency served to GET_SERVICE_STATS requests
+    inline const DeviceManagerServiceStats &getServiceStats() const
+    { return m_service_stats; }
+
     static inline DeviceManager *getInstance()
     { return m_instance; }
 
@@ -38,7 +59,12 @@ public:
     ServerTrackerViewPtr getTrackerViewPtr(int tracker_id);
     
 private:
+    void update_timing_stats(double predict_usec, double publish_usec);
+
     DeviceManagerConfigPtr m_config;
+    struct DeviceManagerTimingStats *m_timing_stats;
+    DeviceManagerServiceStats m_service_stats;
+    class JobSystem *m_job_system;
 
     /// Singleton instance of the class
     /// Assigned in startup, cleared in teardown
@@ -1,24 +1,61 @@
 //-- includes -----
 #include "DeviceTypeManager.h"
+#include "AllocationTracker.h"
+#include "DeviceEnumerationWorker.h"
 #include "DeviceEnumerator.h"
 #include "ServerLog.h"
 #include "ServerDeviceView.h"
 #include "ServerNetworkManager.h"
 #include "ServerUtility.h"
 #include "ServerRequestHandler.h"
+#include "ThreadScheduling.h"
+
+#include <atomic>
+#include <thread>
+
+//-- private definitions -----
+/// A device being opened on its own thread.
+/// The device is opened in a fresh view which replaces the closed view in its slot once it's ready.
+struct BackgroundDeviceOpen
+{
+    std::thread thread;
+    std::atomic<bool> finished;
+    bool in_progress;
+    bool success;
+    double open_milliseconds;
+    ServerDeviceViewPtr device_view;
+    DeviceEnumerator *enumerator;
+    std::string device_path;
+
+    BackgroundDeviceOpen()
+        : finished(false)
+        , in_progress(false)
+        , success(false)
+        , open_milliseconds(0.0)
+        , device_view()
+        , enumerator(nullptr)
+        , device_path()
+    {}
+};
 
 //-- methods -----
-/// Constructor and set intervals (ms) for reconnect and polling
-DeviceTypeManager::DeviceTypeManager(const int recon_int, const int poll_int)
+/// Constructor and set intervals (ms) for reconnect and polling, and the default device capacity
+DeviceTypeManager::DeviceTypeManager(const int recon_int, const int poll_int, const int max_devices)
     : reconnect_interval(recon_int)
     , poll_interval(poll_int)
+    , max_device_count(max_devices)
     , m_deviceViews(nullptr)
+    , m_exists_in_enumerator(nullptr)
+    , m_background_opens(nullptr)
+    , m_enumeration_worker(nullptr)
+    , m_retry_enumeration(false)
 {
 }
 
 DeviceTypeManager::~DeviceTypeManager()
 {
     assert(m_deviceViews == nullptr);
+    assert(m_enumeration_worker == nullptr);
 }
 
 /// Override if the device type needs to initialize any services (e.g., hid_init)
@@ -28,7 +65,10 @@ DeviceTypeManager::startup()
     assert(m_deviceViews == nullptr);
 
     const int maxDeviceCount = getMaxDevices();
+    assert(maxDeviceCount > 0);
     m_deviceViews = new ServerDeviceViewPtr[maxDeviceCount];
+    m_exists_in_enumerator = new bool[maxDeviceCount];
+    m_background_opens = new BackgroundDeviceOpen[maxDeviceCount];
 
     // Allocate all of the device views
     for (int device_id = 0; device_id < maxDeviceCount; ++device_id)
@@ -38,6 +78,19 @@ DeviceTypeManager::startup()
         m_deviceViews[device_id] = deviceView;
     }
 
+    // Device lists get built off of the main thread
+    // and handed back to us in poll() once they are ready
+    m_enumeration_worker = 
+        new DeviceEnumerationWorker(
+            (getDeviceClass() == CommonDeviceState::Controller) ? "Controllers" : "Trackers",
+            getDeviceClass(),
+            [this]() { return allocate_device_enumerator(); },
+            [this](DeviceEnumerator *enumerator) { free_device_enumerator(enumerator); });
+    m_enumeration_worker->startup();
+
+    // Build the initial device list
+    request_device_enumeration();
+
     return true;
 }
 
@@ -47,6 +100,17 @@ DeviceTypeManager::shutdown()
 {
     assert(m_deviceViews != nullptr);
 
+    // Stop the enumeration thread before closing any devices
+    if (m_enumeration_worker != nullptr)
+    {
+        m_enumeration_worker->shutdown();
+        delete m_enumeration_worker;
+        m_enumeration_worker = nullptr;
+    }
+
+    // Devices can't be interrupted part way through opening, so wait them out
+    wait_for_background_opens();
+
     // Close any controllers that were opened
     for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
     {
@@ -63,9 +127,16 @@ DeviceTypeManager::shutdown()
     // Free the device view pointer list
     delete[] m_deviceViews;
     m_deviceViews = nullptr;
+
+    delete[] m_exists_in_enumerator;
+    m_exists_in_enumerator = nullptr;
+
+    delete[] m_background_opens;
+    m_background_opens = nullptr;
 }
 
-/// Calls poll_devices and update_connected_devices if poll_interval and reconnect_interval has elapsed, respectively.
+/// Calls poll_devices if poll_interval has elapsed and applies any device list the enumeration thread finished.
+/// Device lists are rebuilt on hotplug events, or every reconnect_interval when hotplug events aren't available.
 void
 DeviceTypeManager::poll()
 {
@@ -80,19 +151,46 @@ DeviceTypeManager::poll()
         m_last_poll_time = now;
     }
 
-    // See if it's time to try update the list of connected devices
+    // See if it's time to ask for a fresh list of connected devices
     std::chrono::duration<double, std::milli> reconnect_diff = now - m_last_reconnect_time;
     if (reconnect_diff.count() >= reconnect_interval)
     {
-        if (update_connected_devices())
+        const bool bNeedsPolling = 
+            !m_enumeration_worker->getHasHotplugNotifications() && can_request_periodic_enumeration();
+
+        if (m_retry_enumeration || bNeedsPolling)
         {
-            m_last_reconnect_time = now;
+            request_device_enumeration();
+        }
+
+        m_last_reconnect_time = now;
+    }
+
+    // Hand over any devices that finished opening in the background
+    finish_background_opens();
+
+    // Open/close devices to match the latest list built by the enumeration thread
+    if (can_update_connected_devices())
+    {
+        DeviceEnumerator *enumerator = m_enumeration_worker->take_enumeration_result();
+
+        if (enumerator != nullptr)
+        {
+            update_connected_devices(enumerator);
+            free_device_enumerator(enumerator);
         }
     }
 }
 
+void
+DeviceTypeManager::request_device_enumeration()
+{
+    m_retry_enumeration = false;
+    m_enumeration_worker->request_enumeration();
+}
+
 bool
-DeviceTypeManager::update_connected_devices()
+DeviceTypeManager::update_connected_devices(DeviceEnumerator *enumerator)
 {
     bool success = false;
 
@@ -100,20 +198,17 @@ DeviceTypeManager::update_connected_devices()
     if (can_update_connected_devices())
     {
         const int maxDeviceCount = getMaxDevices();
-        bool exists_in_enumerator[64];
+        bool *exists_in_enumerator = m_exists_in_enumerator;
         bool bSendControllerUpdatedNotification = false;
 
         // Initialize temp table used to keep track of open devices
         // still found in the enumerator
-        assert(maxDeviceCount <= 64);
-        memset(exists_in_enumerator, 0, sizeof(exists_in_enumerator));
+        memset(exists_in_enumerator, 0, sizeof(bool) * maxDeviceCount);
 
         // Step 1
         // Mark any open devices that still show up in the enumerator.
         // Open devices shown in the enumerator that we haven't open yet.
         {
-            DeviceEnumerator *enumerator = allocate_device_enumerator();
-
             while (enumerator->is_valid())
             {
                 // Find device index for the device with the matching device path
@@ -125,12 +220,28 @@ DeviceTypeManager::update_connected_devices()
                     // Mark the device as having showed up in the enumerator
                     exists_in_enumerator[device_id]= true;
                 }
+                // Device still being opened in the background
+                else if (find_opening_device_device_id(enumerator) != -1)
+                {
+                    // Nothing to do until it's handed over in poll()
+                }
                 // New controller connected case
                 else
                 {
+                    // Opening a device allocates whether or not it works out
+                    AllocationTracker::noteConfigurationChange();
+
                     int device_id = find_first_closed_device_device_id();
+                    DeviceEnumerator *enumerator_snapshot = 
+                        (device_id != -1 && can_open_devices_in_background())
+                        ? allocate_device_enumerator_snapshot(enumerator)
+                        : nullptr;
 
-                    if (device_id != -1)
+                    if (enumerator_snapshot != nullptr)
+                    {
+                        start_background_open(device_id, enumerator_snapshot);
+                    }
+                    else if (device_id != -1)
                     {
                         // Fetch the controller from it's existing controller slot
                         ServerDeviceViewPtr availableDeviceView = getDeviceViewPtr(device_id);
@@ -149,11 +260,16 @@ DeviceTypeManager::update_connected_devices()
 
                             // Send notificiation to clients that a new device was added
                             bSendControllerUpdatedNotification = true;
+
+                            on_device_opened(device_id);
                         }
                         else
                         {
                             SERVER_LOG_ERROR("DeviceTypeManager::update_connected_devices") << 
                                 "Device device_id " << device_id << " (" << enumerator->get_path() << ") failed to open!";
+
+                            // Try again after the reconnect interval
+                            m_retry_enumeration = true;
                         }
                     }
                     else
@@ -166,8 +282,6 @@ DeviceTypeManager::update_connected_devices()
 
                 enumerator->next();
             }
-
-            free_device_enumerator(enumerator);
         }
 
         // Step 2
@@ -217,6 +331,9 @@ DeviceTypeManager::publish()
 void
 DeviceTypeManager::send_device_list_changed_notification()
 {
+    // Streams and per-device buffers are about to be rebuilt
+    AllocationTracker::noteConfigurationChange();
+
     ResponsePtr response(new PSMoveProtocol::Response);
     response->set_type(getListUpdatedResponseType());
     response->set_request_id(-1);
@@ -237,6 +354,151 @@ DeviceTypeManager::can_update_connected_devices()
     return !ServerRequestHandler::get_instance()->any_active_bluetooth_requests();
 }
 
+bool
+DeviceTypeManager::can_request_periodic_enumeration()
+{
+    return true;
+}
+
+bool
+DeviceTypeManager::can_open_devices_in_background()
+{
+    return false;
+}
+
+DeviceEnumerator *
+DeviceTypeManager::allocate_device_enumerator_snapshot(const DeviceEnumerator *enumerator)
+{
+    return nullptr;
+}
+
+void
+DeviceTypeManager::on_device_opened(int device_id)
+{
+}
+
+void
+DeviceTypeManager::on_device_view_replaced(ServerDeviceView *closed_view, ServerDeviceView *opened_view)
+{
+}
+
+void
+DeviceTypeManager::start_background_open(int device_id, DeviceEnumerator *enumerator_snapshot)
+{
+    BackgroundDeviceOpen &background_open = m_background_opens[device_id];
+    assert(!background_open.in_progress);
+
+    background_open.in_progress = true;
+    background_open.finished = false;
+    background_open.success = false;
+    background_open.open_milliseconds = 0.0;
+    background_open.device_view = ServerDeviceViewPtr(allocate_device_view(device_id));
+    background_open.enumerator = enumerator_snapshot;
+    background_open.device_path = enumerator_snapshot->get_path();
+
+    SERVER_LOG_INFO("DeviceTypeManager::start_background_open") <<
+        "Opening device device_id " << device_id << " (" << background_open.device_path << ") in the background";
+
+    // The thread only touches its own view and enumerator until it sets finished
+    BackgroundDeviceOpen *open_state = &background_open;
+    background_open.thread = std::thread([open_state, device_id]() {
+        char thread_name[16];
+        ServerUtility::format_string(thread_name, sizeof(thread_name), "psm-open%d", device_id);
+        ThreadScheduling::applyToCurrentThread(_threadRole_background, thread_name);
+
+        const std::chrono::time_point<std::chrono::high_resolution_clock> start_time = 
+            std::chrono::high_resolution_clock::now();
+
+        open_state->success = open_state->device_view->open(open_state->enumerator);
+
+        const std::chrono::duration<double, std::milli> open_time = 
+            std::chrono::high_resolution_clock::now() - start_time;
+        open_state->open_milliseconds = open_time.count();
+
+        open_state->finished = true;
+    });
+}
+
+void
+DeviceTypeManager::finish_background_opens()
+{
+    bool bSendControllerUpdatedNotification = false;
+
+    for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
+    {
+        BackgroundDeviceOpen &background_open = m_background_opens[device_id];
+
+        if (!background_open.in_progress || !background_open.finished)
+        {
+            continue;
+        }
+
+        background_open.thread.join();
+
+        if (background_open.success)
+        {
+            const char *device_type_name =
+                CommonDeviceState::getDeviceTypeString(background_open.device_view->getDevice()->getDeviceType());
+
+            SERVER_LOG_INFO("DeviceTypeManager::finish_background_opens") <<
+                "Device device_id " << device_id << " (" << device_type_name << ") opened in the background in "
+                << background_open.open_milliseconds << "ms";
+
+            // Swap the freshly opened view in for the closed one
+            on_device_view_replaced(m_deviceViews[device_id].get(), background_open.device_view.get());
+            m_deviceViews[device_id] = background_open.device_view;
+            bSendControllerUpdatedNotification = true;
+
+            on_device_opened(device_id);
+        }
+        else
+        {
+            SERVER_LOG_ERROR("DeviceTypeManager::finish_background_opens") << 
+                "Device device_id " << device_id << " (" << background_open.device_path << ") failed to open!";
+
+            // Try again after the reconnect interval
+            m_retry_enumeration = true;
+        }
+
+        free_device_enumerator(background_open.enumerator);
+        background_open.enumerator = nullptr;
+        background_open.device_view = ServerDeviceViewPtr();
+        background_open.device_path.clear();
+        background_open.in_progress = false;
+    }
+
+    // List of open devices changed, tell the clients
+    if (bSendControllerUpdatedNotification)
+    {
+        send_device_list_changed_notification();
+    }
+}
+
+void
+DeviceTypeManager::wait_for_background_opens()
+{
+    for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
+    {
+        BackgroundDeviceOpen &background_open = m_background_opens[device_id];
+
+        if (background_open.in_progress)
+        {
+            background_open.thread.join();
+
+            // The service is going away so there is no point in handing the device over
+            if (background_open.success)
+            {
+                background_open.device_view->close();
+            }
+
+            free_device_enumerator(background_open.enumerator);
+            background_open.enumerator = nullptr;
+            background_open.device_view = ServerDeviceViewPtr();
+            background_open.in_progress = false;
+        }
+    }
+}
+
 void
 DeviceTypeManager::poll_devices()
 {
@@ -284,7 +546,8 @@ DeviceTypeManager::find_first_closed_device_device_id()
     {
         ServerDeviceViewPtr device = getDeviceViewPtr(device_id);
 
-        if (device && !device->getIsOpen())
+        // Slots with a device opening in the background are taken
+        if (device && !device->getIsOpen() && !m_background_opens[device_id].in_progress)
         {
             result_device_id = device_id;
             break;
@@ -293,6 +556,28 @@ DeviceTypeManager::find_first_closed_device_device_id()
     return result_device_id;
 }
 
+int
+DeviceTypeManager::find_opening_device_device_id(const DeviceEnumerator *enumerator)
+{
+    int result_device_id = -1;
+    const char *device_path = enumerator->get_path();
+
+    for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
+    {
+        const BackgroundDeviceOpen &background_open = m_background_opens[device_id];
+
+        if (background_open.in_progress && 
+            device_path != nullptr &&
+            background_open.device_path == device_path)
+        {
+            result_device_id = device_id;
+            break;
+        }
+    }
+
+    return result_device_id;
+}
+
 ServerDeviceViewPtr
 DeviceTypeManager::getDeviceViewPtr(int device_id)
 {
@@ -4,6 +4,7 @@
 //-- includes -----
 #include <memory>
 #include <chrono>
+#include "DeviceInterface.h"
 #include "PSMoveProtocol.pb.h"
 
 //-- typedefs -----
@@ -15,7 +16,7 @@ typedef std::shared_ptr<ServerDeviceView> ServerDeviceViewPtr;
 class DeviceTypeManager
 {
 public:
-    DeviceTypeManager(const int recon_int = 1000, const int poll_int = 2);
+    DeviceTypeManager(const int recon_int = 1000, const int poll_int = 2, const int max_devices = 1);
     virtual ~DeviceTypeManager();
 
     virtual bool startup();
@@ -24,7 +25,11 @@ public:
     void poll();
     void publish();
 
-    virtual int getMaxDevices() const = 0;
+    /// Number of device slots. Fixed once startup() has allocated the device views.
+    inline int getMaxDevices() const
+    {
+        return max_device_count;
+    }
 
     /**
     Returns an upcast device view ptr. Useful for generic functions that are
@@ -37,6 +42,7 @@ public:
 
     int reconnect_interval;
     int poll_interval;
+    int max_device_count;
 
 protected:
     void poll_devices();
@@ -46,10 +52,27 @@ protected:
     No device objects are created or destroyed.
     Pointers are just shuffled around and devices opened and closed.
     */
-    bool update_connected_devices();
+    bool update_connected_devices(class DeviceEnumerator *enumerator);
+
+    /// Ask the enumeration thread to build a fresh list of connected devices
+    void request_device_enumeration();
 
     virtual bool can_poll_connected_devices();
     virtual bool can_update_connected_devices();
+    /// Override to stop the reconnect_interval rescans used when hotplug events are unavailable
+    virtual bool can_request_periodic_enumeration();
+    /// Override to open newly connected devices on background threads rather than in poll().
+    /// A device being opened keeps its slot reserved but stays closed until it's ready.
+    virtual bool can_open_devices_in_background();
+    /// Copies the enumerator's current device into a new enumerator a background open can own.
+    /// Return nullptr to open that device in poll() instead.
+    virtual class DeviceEnumerator *allocate_device_enumerator_snapshot(const class DeviceEnumerator *enumerator);
+    /// Called from poll() once a device has opened (in the background or not)
+    virtual void on_device_opened(int device_id);
+    /// Called from poll() right before a view opened in the background replaces the closed view in its slot.
+    /// Override to carry over state kept on the slot's view (ex: stream ref counts).
+    virtual void on_device_view_replaced(class ServerDeviceView *closed_view, class ServerDeviceView *opened_view);
+    virtual CommonDeviceState::eDeviceClass getDeviceClass() const = 0;
     virtual class DeviceEnumerator *allocate_device_enumerator() = 0;
     virtual void free_device_enumerator(class DeviceEnumerator *) = 0;
     virtual ServerDeviceView *allocate_device_view(int device_id) = 0;
@@ -60,11 +83,21 @@ protected:
 
     int find_first_closed_device_device_id();
     int find_open_device_device_id(const class DeviceEnumerator *enumerator);
+    int find_opening_device_device_id(const class DeviceEnumerator *enumerator);
+
+    void start_background_open(int device_id, class DeviceEnumerator *enumerator_snapshot);
+    void finish_background_opens();
+    void wait_for_background_opens();
 
     std::chrono::time_point<std::chrono::high_resolution_clock> m_last_reconnect_time;
     std::chrono::time_point<std::chrono::high_resolution_clock> m_last_poll_time;
 
     ServerDeviceViewPtr *m_deviceViews;
+    bool *m_exists_in_enumerator; // scratch table used by update_connected_devices
+    struct BackgroundDeviceOpen *m_background_opens; // per device slot
+
+    class DeviceEnumerationWorker *m_enumeration_worker;
+    bool m_retry_enumeration;
 };
 
 #endif // DEVICE_TYPE_MANAGER
\ No newline at end of file
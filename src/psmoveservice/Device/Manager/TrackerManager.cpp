@@ -5,6 +5,8 @@
 #include "ServerTrackerView.h"
 #include "ServerDeviceView.h"
 
+#include <algorithm>
+
 //-- constants -----
 
 //-- Tracker Manager Config -----
@@ -14,7 +16,11 @@ TrackerManagerConfig::TrackerManagerConfig(const std::string &fnamebase)
     : PSMoveConfig(fnamebase)
 {
     optical_tracking_timeout= 100;
+    optical_measurement_latency= 16;
+    multicam_sync_tolerance= 20;
+    stationary_optical_interval= 250;
 	use_bgr_to_hsv_lookup_table = true;
+    open_trackers_in_background= true;
     default_tracker_profile.exposure = 32;
     default_tracker_profile.gain = 32;
 	default_tracker_profile.color_preset_table.table_name= "default_tracker_profile";
@@ -32,7 +38,11 @@ TrackerManagerConfig::config2ptree()
     pt.put("version", TrackerManagerConfig::CONFIG_VERSION);
 
     pt.put("optical_tracking_timeout", optical_tracking_timeout);
+    pt.put("optical_measurement_latency", optical_measurement_latency);
+    pt.put("multicam_sync_tolerance", multicam_sync_tolerance);
+    pt.put("stationary_optical_interval", stationary_optical_interval);
 	pt.put("use_bgr_to_hsv_lookup_table", use_bgr_to_hsv_lookup_table);
+    pt.put("open_trackers_in_background", open_trackers_in_background);
     
     pt.put("default_tracker_profile.exposure", default_tracker_profile.exposure);
     pt.put("default_tracker_profile.gain", default_tracker_profile.gain);
@@ -50,7 +60,11 @@ TrackerManagerConfig::ptree2config(const boost::property_tree::ptree &pt)
     if (version == TrackerManagerConfig::CONFIG_VERSION)
     {
         optical_tracking_timeout= pt.get<int>("optical_tracking_timeout", optical_tracking_timeout);
+        optical_measurement_latency= pt.get<int>("optical_measurement_latency", optical_measurement_latency);
+        multicam_sync_tolerance= pt.get<int>("multicam_sync_tolerance", multicam_sync_tolerance);
+        stationary_optical_interval= pt.get<int>("stationary_optical_interval", stationary_optical_interval);
 		use_bgr_to_hsv_lookup_table = pt.get<bool>("use_bgr_to_hsv_lookup_table", use_bgr_to_hsv_lookup_table);
+        open_trackers_in_background= pt.get<bool>("open_trackers_in_background", open_trackers_in_background);
 
         default_tracker_profile.exposure = pt.get<float>("default_tracker_profile.exposure", 32);
         default_tracker_profile.gain = pt.get<float>("default_tracker_profile.gain", 32);
@@ -67,8 +81,8 @@ TrackerManagerConfig::ptree2config(const boost::property_tree::ptree &pt)
 
 //-- Tracker Manager -----
 TrackerManager::TrackerManager()
-    : DeviceTypeManager(10000, 13)
-    , m_tracker_list_dirty(false)
+    : DeviceTypeManager(10000, 13, k_default_max_devices)
+    , m_configured_poll_interval(13)
 {
 }
 
@@ -77,6 +91,9 @@ TrackerManager::startup()
 {
     bool bSuccess = DeviceTypeManager::startup();
 
+    // The device manager sets the poll interval from its config before startup
+    m_configured_poll_interval = poll_interval;
+
     if (bSuccess)
     {
 		// Load any config from disk
@@ -84,9 +101,6 @@ TrackerManager::startup()
 
         // Save back out the config in case there were updated defaults
         cfg.save();
-
-        // Refresh the tracker list
-        mark_tracker_list_dirty();
     }
 
     return bSuccess;
@@ -95,7 +109,7 @@ TrackerManager::startup()
 void
 TrackerManager::closeAllTrackers()
 {
-    for (int tracker_id = 0; tracker_id < k_max_devices; ++tracker_id)
+    for (int tracker_id = 0; tracker_id < getMaxDevices(); ++tracker_id)
     {
         ServerTrackerViewPtr tracker_view = getTrackerViewPtr(tracker_id);
 
@@ -113,15 +127,92 @@ TrackerManager::closeAllTrackers()
 }
 
 bool
-TrackerManager::can_update_connected_devices()
+TrackerManager::can_request_periodic_enumeration()
+{
+    // Scanning the usb bus for cameras tends to stall out the video polling threads,
+    // so only refresh the tracker list on hotplug events or when explicitly asked to.
+    return false;
+}
+
+bool
+TrackerManager::can_open_devices_in_background()
+{
+    // Opening a PS3 Eye and allocating its video buffers (and the color lookup table)
+    // can take a second or more per camera, which would stall the controllers if done in poll()
+    return cfg.open_trackers_in_background;
+}
+
+DeviceEnumerator *
+TrackerManager::allocate_device_enumerator_snapshot(const DeviceEnumerator *enumerator)
+{
+    DeviceEnumerator *snapshot = nullptr;
+
+    // Remote trackers open instantly and share the remote tracker registry with the main thread
+    if (enumerator->get_device_type() != CommonDeviceState::RemoteTracker)
+    {
+        snapshot = static_cast<const TrackerDeviceEnumerator *>(enumerator)->allocate_current_device_snapshot();
+    }
+
+    return snapshot;
+}
+
+void
+TrackerManager::on_device_opened(int device_id)
+{
+    // Poll fast enough to keep up with the new tracker
+    update_poll_interval();
+}
+
+void
+TrackerManager::on_device_view_replaced(ServerDeviceView *closed_view, ServerDeviceView *opened_view)
 {
-    return m_tracker_list_dirty && DeviceTypeManager::can_update_connected_devices();
+    // Connections still hold the stream ref counts of the closed view
+    static_cast<ServerTrackerView *>(opened_view)->takeStreamStateFrom(static_cast<ServerTrackerView *>(closed_view));
 }
 
 void 
 TrackerManager::mark_tracker_list_dirty()
 {
-    m_tracker_list_dirty= true;
+    request_device_enumeration();
+}
+
+void
+TrackerManager::update_poll_interval()
+{
+    // Trackers closing during shutdown() land here after the view list is being torn down
+    if (m_deviceViews == nullptr)
+    {
+        return;
+    }
+
+    double max_frame_rate= 0.0;
+
+    for (int tracker_id = 0; tracker_id < getMaxDevices(); ++tracker_id)
+    {
+        ServerTrackerViewPtr tracker_view = getTrackerViewPtr(tracker_id);
+
+        // Slots shutdown() has already released are empty
+        if (tracker_view && tracker_view->getIsOpen())
+        {
+            max_frame_rate= std::max(max_frame_rate, tracker_view->getFrameRate());
+        }
+    }
+
+    int new_poll_interval= m_configured_poll_interval;
+    if (max_frame_rate > 0.0)
+    {
+        // Poll at least as often as the fastest camera delivers frames
+        const int frame_interval= std::max(static_cast<int>(1000.0 / max_frame_rate), 1);
+
+        new_poll_interval= std::min(m_configured_poll_interval, frame_interval);
+    }
+
+    if (new_poll_interval != poll_interval)
+    {
+        SERVER_LOG_INFO("TrackerManager::update_poll_interval") << "Tracker poll interval " 
+            << poll_interval << "ms -> " << new_poll_interval << "ms (fastest camera " << max_frame_rate << "fps)";
+        poll_interval= new_poll_interval;
+    }
 }
 
 DeviceEnumerator *
@@ -134,9 +225,6 @@ void
 TrackerManager::free_device_enumerator(DeviceEnumerator *enumerator)
 {
     delete static_cast<TrackerDeviceEnumerator *>(enumerator);
-
-    // Tracker list is no longer dirty after we have iterated through the list of cameras
-    m_tracker_list_dirty = false;
 }
 
 ServerDeviceView *
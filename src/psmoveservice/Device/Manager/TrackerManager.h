@@ -45,7 +45,19 @@ public:
 
     long version;
     int optical_tracking_timeout;
+    // Time between a camera exposing a frame and the frame's USB transfer completing (ms).
+    // Optical measurements are fused into the controller filters at this much before their capture timestamp.
+    int optical_measurement_latency;
+    // Largest difference in capture time between two trackers' observations
+    // that still get synchronized and triangulated together (ms). 0 disables synchronization.
+    int multicam_sync_tolerance;
+    // How often a controller the IMU says is stationary gets a full optical solve (ms).
+    // In between, the last solve is reused. 0 solves every frame.
+    int stationary_optical_interval;
 	bool use_bgr_to_hsv_lookup_table;
+    // Open cameras (and warm up their video buffers) on background threads
+    // so controllers keep streaming while the cameras come up
+    bool open_trackers_in_background;
     TrackerProfile default_tracker_profile;
 };
 
@@ -58,18 +70,17 @@ public:
 
     void closeAllTrackers();
 
-    static const int k_max_devices = 4;
-    int getMaxDevices() const override
-    {
-        return TrackerManager::k_max_devices;
-    }
+    /// Tracker slots used when the device manager config doesn't specify a count
+    static const int k_default_max_devices = 4;
+    /// Upper limit on tracker slots (see PSMOVESERVICE_MAX_TRACKER_COUNT on the client)
+    static const int k_max_supported_devices = 8;
 
     ServerTrackerViewPtr getTrackerViewPtr(int device_id);
 
     inline void saveDefaultTrackerProfile(const TrackerProfile *profile)
     {
         cfg.default_tracker_profile = *profile;
-        cfg.save();
+        cfg.saveDeferred();
     }
 
     inline const TrackerProfile *getDefaultTrackerProfile() const
@@ -82,14 +93,29 @@ public:
         return cfg;
     }
 
-protected:
-    bool can_update_connected_devices() override;
+    /// Request a tracker enumeration (e.g. when a new remote tracker starts streaming)
     void mark_tracker_list_dirty();
 
+    /// Shortens the poll interval to keep up with the fastest open camera
+    /// (never longer than the configured tracker_poll_interval)
+    void update_poll_interval();
+
+protected:
+    bool can_request_periodic_enumeration() override;
+    bool can_open_devices_in_background() override;
+    DeviceEnumerator *allocate_device_enumerator_snapshot(const DeviceEnumerator *enumerator) override;
+    void on_device_opened(int device_id) override;
+    void on_device_view_replaced(class ServerDeviceView *closed_view, class ServerDeviceView *opened_view) override;
+
     DeviceEnumerator *allocate_device_enumerator() override;
     void free_device_enumerator(DeviceEnumerator *) override;
     ServerDeviceView *allocate_device_view(int device_id) override;
 
+    CommonDeviceState::eDeviceClass getDeviceClass() const override
+    {
+        return CommonDeviceState::TrackingCamera;
+    }
+
     const PSMoveProtocol::Response_ResponseType getListUpdatedResponseType() override
     {
         return TrackerManager::k_list_udpated_response_type;
@@ -99,7 +125,7 @@ private:
     static const PSMoveProtocol::Response_ResponseType k_list_udpated_response_type = PSMoveProtocol::Response_ResponseType_TRACKER_LIST_UPDATED;
 
     TrackerManagerConfig cfg;
-    bool m_tracker_list_dirty;
+    int m_configured_poll_interval;
 };
 
 #endif // TRACKER_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,60 @@
+//-- includes -----
+#include "ControllerOpticalPoseStorage.h"
+
+#include <algorithm>
+#include <assert.h>
+
+//-- public implementation -----
+ControllerOpticalPoseStorage::ControllerOpticalPoseStorage(const int controller_count, const int tracker_count)
+    : m_controller_count(controller_count)
+    , m_tracker_count(tracker_count)
+    , m_tracker_pose_estimations(controller_count*tracker_count)
+    , m_solved_poses(controller_count*tracker_count)
+    , m_solved_pose_valid(controller_count*tracker_count, 0)
+    , m_world_orientations(controller_count*tracker_count)
+    , m_orientation_weights(controller_count*tracker_count)
+    , m_valid_position_tracker_ids(controller_count*tracker_count)
+    , m_capture_timestamps(controller_count*tracker_count)
+    , m_synchronized_indices(controller_count*tracker_count)
+    , m_extrapolation_seconds(controller_count*tracker_count)
+    , m_synchronized_positions(controller_count*tracker_count)
+    , m_position2d_list(controller_count*tracker_count)
+{
+    for (int controller_id = 0; controller_id < m_controller_count; ++controller_id)
+    {
+        clearController(controller_id);
+    }
+}
+
+void ControllerOpticalPoseStorage::getControllerSlice(const int controller_id, ControllerOpticalPoseSlice &out_slice)
+{
+    assert(controller_id >= 0 && controller_id < m_controller_count);
+    const size_t first= static_cast<size_t>(controller_id*m_tracker_count);
+
+    out_slice.tracker_count= m_tracker_count;
+    out_slice.tracker_pose_estimations= &m_tracker_pose_estimations[first];
+    out_slice.solved_poses= &m_solved_poses[first];
+    out_slice.solved_pose_valid= &m_solved_pose_valid[first];
+    out_slice.world_orientations= &m_world_orientations[first];
+    out_slice.orientation_weights= &m_orientation_weights[first];
+    out_slice.valid_position_tracker_ids= &m_valid_position_tracker_ids[first];
+    out_slice.capture_timestamps= &m_capture_timestamps[first];
+    out_slice.synchronized_indices= &m_synchronized_indices[first];
+    out_slice.extrapolation_seconds= &m_extrapolation_seconds[first];
+    out_slice.synchronized_positions= &m_synchronized_positions[first];
+    out_slice.position2d_list= &m_position2d_list[first];
+}
+
+void ControllerOpticalPoseStorage::clearController(const int controller_id)
+{
+    assert(controller_id >= 0 && controller_id < m_controller_count);
+    const size_t first= static_cast<size_t>(controller_id*m_tracker_count);
+
+    for (int tracker_id = 0; tracker_id < m_tracker_count; ++tracker_id)
+    {
+        m_tracker_pose_estimations[first + tracker_id].clear();
+        m_solved_poses[first + tracker_id].clear();
+    }
+
+    std::fill(m_solved_pose_valid.begin() + first, m_solved_pose_valid.begin() + first + m_tracker_count, 0);
+}
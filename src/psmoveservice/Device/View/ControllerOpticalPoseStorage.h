@@ -0,0 +1,123 @@
+#ifndef CONTROLLER_OPTICAL_POSE_STORAGE_H
+#define CONTROLLER_OPTICAL_POSE_STORAGE_H
+
+//-- includes -----
+#include "DeviceInterface.h"
+#include "MathEigen.h"
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+// -- declarations -----
+struct ControllerOpticalPoseEstimation
+{
+    std::chrono::time_point<std::chrono::high_resolution_clock> last_update_timestamp;
+    std::chrono::time_point<std::chrono::high_resolution_clock> last_visible_timestamp;
+    // When the camera exposed the frame the estimate came from (frame capture time minus the optical latency)
+    std::chrono::time_point<std::chrono::high_resolution_clock> capture_timestamp;
+    // Multicam only: spread in capture time between the tracker observations
+    // that were synchronized to capture_timestamp before triangulating (ms)
+    float capture_skew_milliseconds;
+    bool bValidTimestamps;
+
+    CommonDevicePosition position;
+    CommonDeviceTrackingProjection projection;
+    bool bCurrentlyTracking;
+
+    CommonDeviceQuaternion orientation;
+    bool bOrientationValid;
+
+    inline void clear()
+    {
+        last_update_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+        last_visible_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+        capture_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+        capture_skew_milliseconds= 0.f;
+        bValidTimestamps= false;
+
+        position.clear();
+        bCurrentlyTracking= false;
+
+        orientation.clear();
+        bOrientationValid= false;
+
+        memset(&projection, 0, sizeof(CommonDeviceTrackingProjection));
+        projection.shape_type= eCommonTrackingProjectionType::INVALID_PROJECTION;
+    }
+};
+
+/// One controller's slice of a ControllerOpticalPoseStorage: every array has an entry per tracker slot.
+/// The scratch arrays are only meaningful during the tick that fills them.
+struct ControllerOpticalPoseSlice
+{
+    int tracker_count;
+
+    // The controller's pose estimate relative to each tracker
+    ControllerOpticalPoseEstimation *tracker_pose_estimations;
+
+    // Results of computeTrackerPoseEstimate for the current tick
+    ControllerOpticalPoseEstimation *solved_poses;
+    unsigned char *solved_pose_valid;
+
+    // Scratch space for the optical pose fusion in updateOpticalPoseEstimation
+    Eigen::Quaternionf *world_orientations;
+    float *orientation_weights;
+    int *valid_position_tracker_ids;
+    std::chrono::time_point<std::chrono::high_resolution_clock> *capture_timestamps;
+    int *synchronized_indices;
+    float *extrapolation_seconds;
+    CommonDevicePosition *synchronized_positions;
+    CommonDeviceScreenLocation *position2d_list;
+};
+
+/// The per tracker optical pose state of every controller slot, owned by the ControllerManager and
+/// sized once at startup from the configured capacities, so opening a controller or running a tick never allocates.
+/// Each field is one contiguous array indexed by controller_id*tracker_count + tracker_id:
+/// a controller's trackers sit next to each other for its fusion loop, and all of the controllers
+/// together are a dozen allocations rather than a dozen each.
+///
+/// The pose estimates stay whole structs rather than being split up by field too:
+/// computePoseForController fills in an estimate as a unit, the fusion loop reads nearly every field
+/// of each estimate it visits (timestamps, flags, position, projection and orientation), and the
+/// publishers and the tracker node publisher hand them out by pointer. Splitting them would touch the
+/// same bytes through more streams. The scratch arrays are split because each loop only walks one or two of them.
+class ControllerOpticalPoseStorage
+{
+public:
+    ControllerOpticalPoseStorage(const int controller_count, const int tracker_count);
+
+    inline int getControllerCount() const
+    {
+        return m_controller_count;
+    }
+
+    inline int getTrackerCount() const
+    {
+        return m_tracker_count;
+    }
+
+    /// Points out_slice at the given controller slot's arrays
+    void getControllerSlice(const int controller_id, ControllerOpticalPoseSlice &out_slice);
+
+    /// Resets the given controller slot's pose estimates, i.e. when a controller opens in it
+    void clearController(const int controller_id);
+
+private:
+    int m_controller_count;
+    int m_tracker_count;
+
+    std::vector<ControllerOpticalPoseEstimation> m_tracker_pose_estimations;
+    std::vector<ControllerOpticalPoseEstimation> m_solved_poses;
+    std::vector<unsigned char> m_solved_pose_valid;
+    std::vector<Eigen::Quaternionf, Eigen::aligned_allocator<Eigen::Quaternionf> > m_world_orientations;
+    std::vector<float> m_orientation_weights;
+    std::vector<int> m_valid_position_tracker_ids;
+    std::vector<std::chrono::time_point<std::chrono::high_resolution_clock> > m_capture_timestamps;
+    std::vector<int> m_synchronized_indices;
+    std::vector<float> m_extrapolation_seconds;
+    std::vector<CommonDevicePosition> m_synchronized_positions;
+    std::vector<CommonDeviceScreenLocation> m_position2d_list;
+};
+
+#endif // CONTROLLER_OPTICAL_POSE_STORAGE_H
@@ -4,6 +4,7 @@
 #include "BluetoothRequests.h"
 #include "ControllerManager.h"
 #include "DeviceManager.h"
+#include "FilterHistory.h"
 #include "MathAlignment.h"
 #include "ServerLog.h"
 #include "ServerRequestHandler.h"
@@ -16,18 +17,37 @@
 #include "PSMoveProtocol.pb.h"
 #include "ServerUtility.h"
 #include "ServerTrackerView.h"
+#include "TrackerObservationSync.h"
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
 
 //-- constants -----
 static const float k_min_time_delta_seconds = 1 / 120.f;
 static const float k_max_time_delta_seconds = 1 / 30.f;
-
+// Limits on the time delta between two controller reports (from the controller's own clock)
+static const float k_min_report_time_delta_seconds = 1 / 1000.f;
+static const float k_max_report_time_delta_seconds = 1 / 10.f;
+// How often the report rate statistic is recomputed
+static const float k_report_rate_window_seconds = 1.f;
+// Below these the IMU and position filter say the controller isn't moving
+static const float k_stationary_max_gyro_magnitude = 0.1f; // rad/s
+static const float k_stationary_max_accel_deviation = 0.05f; // g-units from 1g
+static const float k_stationary_max_speed = 2.f; // cm/s
+// How long the controller has to stay still before optical solves are throttled
+static const float k_stationary_settle_milliseconds = 500.f;
+// A verification solve that moved further than this means the controller moved after all
+static const float k_stationary_max_optical_drift = 1.f; // cm
+
+//-- private definitions -----
 //-- macros -----
 #define SET_BUTTON_BIT(bitmask, bit_index, button_state) \
     bitmask|= (button_state == CommonControllerState::Button_DOWN || button_state == CommonControllerState::Button_PRESSED) ? (0x1 << (bit_index)) : 0x0;
 
 //-- private methods -----
+static float get_state_time_delta(const CommonControllerState *controllerState, const float fallback_time_delta);
+
 static void init_filters_for_psmove(
     const PSMoveController *psmoveController, 
     OrientationFilter *orientation_filter, PositionFilter *position_filter);
@@ -58,13 +78,23 @@ ServerControllerView::ServerControllerView(const int device_id)
     , m_tracking_enabled(false)
     , m_LED_override_active(false)
     , m_device(nullptr)
-    , m_tracker_pose_estimation(nullptr)
+    , m_optical_pose()
     , m_multicam_pose_estimation(nullptr)
     , m_orientation_filter(nullptr)
     , m_position_filter(nullptr)
+    , m_filter_history(nullptr)
+    , m_last_fused_optical_timestamp()
+    , m_last_motion_timestamp()
+    , m_last_full_optical_solve_timestamp()
+    , m_optical_solve_throttled(false)
+    , m_full_optical_solve_this_tick(true)
     , m_lastPollSeqNumProcessed(-1)
     , m_last_filter_update_timestamp()
     , m_last_filter_update_timestamp_valid(false)
+    , m_report_statistics()
+    , m_report_rate_window_report_count(0)
+    , m_report_rate_window_dropped_count(0)
+    , m_report_rate_window_seconds(0.f)
 {
     m_tracking_color = std::make_tuple(0x00, 0x00, 0x00);
     m_LED_override_color = std::make_tuple(0x00, 0x00, 0x00);
@@ -85,11 +115,7 @@ bool ServerControllerView::allocate_device_interface(
             m_orientation_filter = new OrientationFilter();
             m_position_filter = new PositionFilter();
 
-            m_tracker_pose_estimation = new ControllerOpticalPoseEstimation[TrackerManager::k_max_devices];
-            for (int tracker_index = 0; tracker_index < TrackerManager::k_max_devices; ++tracker_index)
-            {
-                m_tracker_pose_estimation[tracker_index].clear();
-            }
+            allocate_tracker_pose_estimation();
 
             m_multicam_pose_estimation = new ControllerOpticalPoseEstimation();
             m_multicam_pose_estimation->clear();
@@ -107,11 +133,7 @@ bool ServerControllerView::allocate_device_interface(
             m_orientation_filter = new OrientationFilter();
             m_position_filter = new PositionFilter();
 
-            m_tracker_pose_estimation = new ControllerOpticalPoseEstimation[TrackerManager::k_max_devices];
-            for (int tracker_index = 0; tracker_index < TrackerManager::k_max_devices; ++tracker_index)
-            {
-                m_tracker_pose_estimation[tracker_index].clear();
-            }
+            allocate_tracker_pose_estimation();
 
             m_multicam_pose_estimation = new ControllerOpticalPoseEstimation();
             m_multicam_pose_estimation->clear();
@@ -123,6 +145,17 @@ bool ServerControllerView::allocate_device_interface(
     return m_device != nullptr;
 }
 
+void ServerControllerView::allocate_tracker_pose_estimation()
+{
+    // One pose estimate per tracker slot, kept in this controller slot's part of the manager's storage
+    ControllerOpticalPoseStorage *storage= DeviceManager::getInstance()->m_controller_manager->getOpticalPoseStorage();
+
+    storage->clearController(getDeviceID());
+    storage->getControllerSlice(getDeviceID(), m_optical_pose);
+
+    m_filter_history = new ControllerFilterHistory();
+}
+
 void ServerControllerView::free_device_interface()
 {
     if (m_multicam_pose_estimation != nullptr)
@@ -131,10 +164,13 @@ void ServerControllerView::free_device_interface()
         m_multicam_pose_estimation= nullptr;
     }
 
-    if (m_tracker_pose_estimation != nullptr)
+    // The slice points into the controller manager's storage, so just let go of it
+    m_optical_pose = ControllerOpticalPoseSlice();
+
+    if (m_filter_history != nullptr)
     {
-        delete[] m_tracker_pose_estimation;
-        m_tracker_pose_estimation = nullptr;
+        delete m_filter_history;
+        m_filter_history = nullptr;
     }
 
     if (m_orientation_filter != nullptr)
@@ -210,6 +246,19 @@ bool ServerControllerView::open(const class DeviceEnumerator *enumerator)
 
         // Reset the poll sequence number high water mark
         m_lastPollSeqNumProcessed= -1;
+
+        // Forget any filter history and fused optical measurements from a previous connection
+        if (m_filter_history != nullptr)
+        {
+            m_filter_history->clear();
+        }
+        m_last_fused_optical_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+
+        // Start the report statistics over
+        m_report_statistics.clear();
+        m_report_rate_window_report_count = 0;
+        m_report_rate_window_dropped_count = 0;
+        m_report_rate_window_seconds = 0.f;
     }
 
     // If needed for this kind of controller, assign a tracking color id
@@ -261,6 +310,48 @@ void ServerControllerView::close()
     ServerDeviceView::close();
 }
 
+void ServerControllerView::scheduleOpticalPoseEstimation(TrackerManager* tracker_manager)
+{
+    if (getIsTrackingEnabled())
+    {
+        assert(m_optical_pose.tracker_count == tracker_manager->getMaxDevices());
+
+        // While the IMU says the controller is sitting still only verify its pose now and then,
+        // reusing the last solve for the frames in between
+        m_full_optical_solve_this_tick= 
+            update_optical_solve_schedule(tracker_manager, std::chrono::high_resolution_clock::now());
+
+        std::fill(m_optical_pose.solved_pose_valid, m_optical_pose.solved_pose_valid + m_optical_pose.tracker_count, 0);
+    }
+}
+
+// Runs the blob tracking for this controller on the tracker's newest video frame.
+// Only touches this controller's solve slot for the given tracker (and the tracker's own 
+// video buffers), so different trackers can be processed on different threads.
+void ServerControllerView::computeTrackerPoseEstimate(ServerTrackerView *tracker, int tracker_id)
+{
+    if (getIsTrackingEnabled() && 
+        m_full_optical_solve_this_tick &&
+        tracker->getIsOpen() && 
+        tracker->getHasUnpublishedState())
+    {
+        assert(tracker_id >= 0 && tracker_id < m_optical_pose.tracker_count);
+
+        const ControllerOpticalPoseEstimation &trackerPoseEstimateRef = m_optical_pose.tracker_pose_estimations[tracker_id];
+        ControllerOpticalPoseEstimation &newTrackerPoseEstimate = m_optical_pose.solved_poses[tracker_id];
+        CommonDevicePose poseGuess= {trackerPoseEstimateRef.position, trackerPoseEstimateRef.orientation};
+
+        // Initially the newTrackerPoseEstimate is a copy of the existing pose
+        newTrackerPoseEstimate= trackerPoseEstimateRef;
+
+        m_optical_pose.solved_pose_valid[tracker_id]= 
+            tracker->computePoseForController(
+                this, 
+                trackerPoseEstimateRef.bOrientationValid ? &poseGuess : nullptr,
+                &newTrackerPoseEstimate) ? 1 : 0;
+    }
+}
+
 void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_manager)
 {
     const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
@@ -271,21 +362,30 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
     
     if (getIsTrackingEnabled())
     {
-        Eigen::Quaternionf controller_world_orientations[TrackerManager::k_max_devices];
-        float controller_orientation_weights[TrackerManager::k_max_devices];
+        assert(m_optical_pose.tracker_count == tracker_manager->getMaxDevices());
+
+        const bool bFullOpticalSolve= m_full_optical_solve_this_tick;
+        bool bSolvedNewFrame= false;
+        bool bVerificationMoved= false;
+
+        Eigen::Quaternionf *controller_world_orientations = m_optical_pose.world_orientations;
+        float *controller_orientation_weights = m_optical_pose.orientation_weights;
         int orientations_found = 0;
 
-        int valid_position_tracker_ids[TrackerManager::k_max_devices];
+        int *valid_position_tracker_ids = m_optical_pose.valid_position_tracker_ids;
         int positions_found = 0;
 
         float screen_area_sum= 0;
 
+        // Capture time of the newest camera frame that contributed to the estimate
+        std::chrono::time_point<std::chrono::high_resolution_clock> latest_capture_timestamp;
+
         // Compute an estimated 3d tracked position of the controller 
         // from the perspective of each tracker
         for (int tracker_id = 0; tracker_id < tracker_manager->getMaxDevices(); ++tracker_id)
         {
             ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
-            ControllerOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimation[tracker_id];
+            ControllerOpticalPoseEstimation &trackerPoseEstimateRef = m_optical_pose.tracker_pose_estimations[tracker_id];
 
             const bool bWasTracking= trackerPoseEstimateRef.bCurrentlyTracking;
 
@@ -294,38 +394,63 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
 
             if (tracker->getIsOpen())
             {
-                // See how long it's been since we got a new video frame
+                // See how long it's been since the camera captured a new video frame
                 const std::chrono::time_point<std::chrono::high_resolution_clock> now= 
                     std::chrono::high_resolution_clock::now();
+                const std::chrono::time_point<std::chrono::high_resolution_clock> frameCaptureTimestamp=
+                    tracker->getLastFrameCaptureTimestamp();
                 const std::chrono::duration<float, std::milli> timeSinceNewDataMillis= 
-                    now - tracker->getLastNewDataTimestamp();
+                    now - frameCaptureTimestamp;
                 const float timeoutMilli= 
                     static_cast<float>(DeviceManager::getInstance()->m_tracker_manager->getConfig().optical_tracking_timeout);
+                const int latencyMilli=
+                    DeviceManager::getInstance()->m_tracker_manager->getConfig().optical_measurement_latency;
 
                 // Can't compute tracking on video data that's too old
                 if (timeSinceNewDataMillis.count() < timeoutMilli)
                 {
-                    // Initially the newTrackerPoseEstimate is a copy of the existing pose
                     bool bIsVisibleThisUpdate= false;
 
-                    // If a new video frame is available this tick, 
-                    // attempt to update the tracking location
-                    if (tracker->getHasUnpublishedState())
+                    // If a new video frame was solved this tick (see computeTrackerPoseEstimate), 
+                    // update the tracking location
+                    if (tracker->getHasUnpublishedState() && bFullOpticalSolve)
                     {
-                        ControllerOpticalPoseEstimation newTrackerPoseEstimate= trackerPoseEstimateRef;
-                        CommonDevicePose poseGuess= {trackerPoseEstimateRef.position, trackerPoseEstimateRef.orientation};
+                        const ControllerOpticalPoseEstimation &newTrackerPoseEstimate= m_optical_pose.solved_poses[tracker_id];
 
-                        if (tracker->computePoseForController(
-                                this, 
-                                trackerPoseEstimateRef.bOrientationValid ? &poseGuess : nullptr,
-                                &newTrackerPoseEstimate))
+                        bSolvedNewFrame= true;
+
+                        if (m_optical_pose.solved_pose_valid[tracker_id] != 0)
                         {
                             bIsVisibleThisUpdate= true;
 
+                            // A stationary controller's verification solve should land where the last one did
+                            if (m_optical_solve_throttled && bWasTracking)
+                            {
+                                const CommonDevicePosition &old_position= trackerPoseEstimateRef.position;
+                                const CommonDevicePosition &new_position= newTrackerPoseEstimate.position;
+                                const Eigen::Vector3f drift(
+                                    new_position.x - old_position.x,
+                                    new_position.y - old_position.y,
+                                    new_position.z - old_position.z);
+
+                                bVerificationMoved|= drift.norm() > k_stationary_max_optical_drift;
+                            }
+
                             trackerPoseEstimateRef= newTrackerPoseEstimate;
-                            trackerPoseEstimateRef.last_visible_timestamp = now;
+                            trackerPoseEstimateRef.last_visible_timestamp = frameCaptureTimestamp;
+                            trackerPoseEstimateRef.capture_timestamp = 
+                                frameCaptureTimestamp - std::chrono::milliseconds(latencyMilli);
                         }
                     }
+                    else if (tracker->getHasUnpublishedState() && bWasTracking)
+                    {
+                        // The controller hasn't moved, so the last solve still describes this frame
+                        bIsVisibleThisUpdate= true;
+
+                        trackerPoseEstimateRef.last_visible_timestamp = frameCaptureTimestamp;
+                        trackerPoseEstimateRef.capture_timestamp = 
+                            frameCaptureTimestamp - std::chrono::milliseconds(latencyMilli);
+                    }
 
                     // If the position estimate isn't too old (or updated this tick), 
                     // say we have a valid tracked location
@@ -346,6 +471,11 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
                             valid_position_tracker_ids[positions_found] = tracker_id;
                             ++positions_found;
 
+                            if (trackerPoseEstimateRef.capture_timestamp > latest_capture_timestamp)
+                            {
+                                latest_capture_timestamp = trackerPoseEstimateRef.capture_timestamp;
+                            }
+
                             // If the pose has a valid tracker relative orientation,
                             // convert the orientation to world space and add it
                             // to a weighted list of orientations
@@ -374,19 +504,46 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
             trackerPoseEstimateRef.bValidTimestamps = true;
         }
 
+        // Only a full solve of a new frame counts as a verification,
+        // ticks without a new frame leave the next one due
+        if (bSolvedNewFrame)
+        {
+            m_last_full_optical_solve_timestamp= now;
+        }
+
+        // Go back to solving every frame if the verification pass saw the controller move
+        if (bVerificationMoved)
+        {
+            m_last_motion_timestamp= now;
+        }
+
+        // Line the tracker observations up in time before triangulating them
+        float capture_skew_milliseconds= 0.f;
+        if (positions_found > 1)
+        {
+            positions_found= 
+                synchronize_tracker_observations(
+                    tracker_manager,
+                    latest_capture_timestamp,
+                    valid_position_tracker_ids,
+                    positions_found,
+                    screen_area_sum,
+                    capture_skew_milliseconds);
+        }
+
         // If multiple trackers can see the controller, 
         // triangulate all pairs of trackers and average the results
         if (positions_found > 1)
         {
-            // Project the tracker relative 3d tracking position back on to the tracker camera plane
-            CommonDeviceScreenLocation position2d_list[TrackerManager::k_max_devices];
+            // Project the synchronized tracker relative 3d tracking position back on to the tracker camera plane
+            const CommonDevicePosition *synchronized_positions = m_optical_pose.synchronized_positions;
+            CommonDeviceScreenLocation *position2d_list = m_optical_pose.position2d_list;
             for (int list_index = 0; list_index < positions_found; ++list_index)
             {
                 const int tracker_id = valid_position_tracker_ids[list_index];
                 const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
-                const ControllerOpticalPoseEstimation &positionEstimate = m_tracker_pose_estimation[tracker_id];
                 
-                position2d_list[list_index] = tracker->projectTrackerRelativePosition(&positionEstimate.position);
+                position2d_list[list_index] = tracker->projectTrackerRelativePosition(&synchronized_positions[list_index]);
             }
 
             int pair_count = 0;
@@ -441,7 +598,7 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
             // Put the tracker relative position into world space
             const int tracker_id = valid_position_tracker_ids[0];
             const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
-            const CommonDevicePosition &tracker_relative_position = m_tracker_pose_estimation[tracker_id].position;
+            const CommonDevicePosition &tracker_relative_position = m_optical_pose.tracker_pose_estimations[tracker_id].position;
 
             // Only one tracker can see the controller
             m_multicam_pose_estimation->position = tracker->computeWorldPosition(&tracker_relative_position);
@@ -488,12 +645,183 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
         if (positions_found > 0)
         {
             m_multicam_pose_estimation->last_visible_timestamp = now;
+            m_multicam_pose_estimation->capture_timestamp = latest_capture_timestamp;
+            m_multicam_pose_estimation->capture_skew_milliseconds = capture_skew_milliseconds;
         }
         m_multicam_pose_estimation->last_update_timestamp = now;
         m_multicam_pose_estimation->bValidTimestamps = true;
     }
 }
 
+// True unless the latest IMU sample and the position filter agree the controller is sitting still.
+// Controllers without an IMU always count as moving.
+bool ServerControllerView::get_is_moving() const
+{
+    const CommonControllerState *controllerState= getState();
+    Eigen::Vector3f gyro, accel;
+
+    if (controllerState == nullptr)
+    {
+        return true;
+    }
+
+    switch (controllerState->DeviceType)
+    {
+    case CommonDeviceState::PSMove:
+        {
+            const PSMoveControllerState *psmoveState= static_cast<const PSMoveControllerState *>(controllerState);
+
+            // Index 1 is the newer of the two frames in the report
+            gyro= Eigen::Vector3f(psmoveState->CalibratedGyro[1][0], psmoveState->CalibratedGyro[1][1], psmoveState->CalibratedGyro[1][2]);
+            accel= Eigen::Vector3f(psmoveState->CalibratedAccel[1][0], psmoveState->CalibratedAccel[1][1], psmoveState->CalibratedAccel[1][2]);
+        } break;
+    case CommonDeviceState::PSDualShock4:
+        {
+            const PSDualShock4ControllerState *ds4State= static_cast<const PSDualShock4ControllerState *>(controllerState);
+
+            gyro= Eigen::Vector3f(ds4State->CalibratedGyro.i, ds4State->CalibratedGyro.j, ds4State->CalibratedGyro.k);
+            accel= Eigen::Vector3f(ds4State->CalibratedAccelerometer.i, ds4State->CalibratedAccelerometer.j, ds4State->CalibratedAccelerometer.k);
+        } break;
+    default:
+        return true;
+    }
+
+    if (gyro.norm() > k_stationary_max_gyro_magnitude ||
+        fabsf(accel.norm() - 1.f) > k_stationary_max_accel_deviation)
+    {
+        return true;
+    }
+
+    return m_position_filter != nullptr && m_position_filter->getVelocity().norm() > k_stationary_max_speed;
+}
+
+// Returns true if the controller needs a full optical solve this tick.
+// Any motion puts the controller straight back to a full solve on every new frame. 
+// Once it has been still for k_stationary_settle_milliseconds it's only solved every
+// stationary_optical_interval ms, to verify that it really hasn't moved.
+bool ServerControllerView::update_optical_solve_schedule(
+    TrackerManager* tracker_manager,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &now)
+{
+    const int intervalMilli= tracker_manager->getConfig().stationary_optical_interval;
+
+    // The bulb isn't showing the tracking color during an LED override
+    if (get_is_moving() || m_LED_override_active)
+    {
+        m_last_motion_timestamp= now;
+    }
+
+    const std::chrono::duration<float, std::milli> timeSinceMotion= now - m_last_motion_timestamp;
+    const std::chrono::duration<float, std::milli> timeSinceFullSolve= now - m_last_full_optical_solve_timestamp;
+    const bool bStationary= intervalMilli > 0 && timeSinceMotion.count() >= k_stationary_settle_milliseconds;
+    const bool bFullSolve= !bStationary || timeSinceFullSolve.count() >= static_cast<float>(intervalMilli);
+
+    if (bStationary != m_optical_solve_throttled)
+    {
+        if (bStationary)
+        {
+            SERVER_LOG_DEBUG("ServerControllerView::update_optical_solve_schedule") << "Controller " << getDeviceID()
+                << " stationary, verifying optical pose every " << intervalMilli << "ms";
+        }
+        else
+        {
+            SERVER_LOG_DEBUG("ServerControllerView::update_optical_solve_schedule") << "Controller " << getDeviceID()
+                << " moving, solving optical pose every frame";
+        }
+
+        m_optical_solve_throttled= bStationary;
+    }
+
+    return bFullSolve;
+}
+
+// Lines the per-tracker observations up in time (see synchronize_observation_times).
+// Compacts valid_position_tracker_ids down to the synchronized trackers, 
+// fills in m_optical_pose.synchronized_positions and returns the synchronized tracker count.
+int ServerControllerView::synchronize_tracker_observations(
+    TrackerManager* tracker_manager,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &reference_timestamp,
+    int *valid_position_tracker_ids,
+    const int positions_found,
+    float &inout_screen_area_sum,
+    float &out_capture_skew_milliseconds)
+{
+    const int toleranceMilli= tracker_manager->getConfig().multicam_sync_tolerance;
+    std::chrono::time_point<std::chrono::high_resolution_clock> *capture_timestamps= m_optical_pose.capture_timestamps;
+    int *synchronized_indices= m_optical_pose.synchronized_indices;
+    float *extrapolation_seconds= m_optical_pose.extrapolation_seconds;
+    CommonDevicePosition *synchronized_positions = m_optical_pose.synchronized_positions;
+
+    for (int list_index = 0; list_index < positions_found; ++list_index)
+    {
+        capture_timestamps[list_index]= m_optical_pose.tracker_pose_estimations[valid_position_tracker_ids[list_index]].capture_timestamp;
+    }
+
+    const int synchronized_count= 
+        synchronize_observation_times(
+            reference_timestamp, toleranceMilli,
+            capture_timestamps, positions_found,
+            synchronized_indices, extrapolation_seconds,
+            out_capture_skew_milliseconds);
+
+    // World space velocity of the controller (cm/s)
+    CommonDeviceVector velocity;
+    velocity.clear();
+    if (m_position_filter != nullptr)
+    {
+        const Eigen::Vector3f filter_velocity= m_position_filter->getVelocity();
+
+        velocity.i= filter_velocity.x();
+        velocity.j= filter_velocity.y();
+        velocity.k= filter_velocity.z();
+    }
+
+    // The kept indices are in order, so the ids can be compacted in place
+    float kept_screen_area_sum= 0.f;
+    float found_screen_area_sum= 0.f;
+    for (int list_index = 0; list_index < positions_found; ++list_index)
+    {
+        found_screen_area_sum+= m_optical_pose.tracker_pose_estimations[valid_position_tracker_ids[list_index]].projection.screen_area;
+    }
+
+    for (int sync_index = 0; sync_index < synchronized_count; ++sync_index)
+    {
+        const int tracker_id = valid_position_tracker_ids[synchronized_indices[sync_index]];
+        const ControllerOpticalPoseEstimation &positionEstimate = m_optical_pose.tracker_pose_estimations[tracker_id];
+
+        if (extrapolation_seconds[sync_index] > 0.f)
+        {
+            // Extrapolate the observation forward to the reference time
+            const ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
+            const CommonDevicePosition world_position= 
+                extrapolate_observation_position(
+                    tracker->computeWorldPosition(&positionEstimate.position), 
+                    velocity, 
+                    extrapolation_seconds[sync_index]);
+
+            synchronized_positions[sync_index]= tracker->computeTrackerRelativePosition(&world_position);
+        }
+        else
+        {
+            synchronized_positions[sync_index]= positionEstimate.position;
+        }
+
+        kept_screen_area_sum+= positionEstimate.projection.screen_area;
+        valid_position_tracker_ids[sync_index]= tracker_id;
+    }
+
+    if (synchronized_count < positions_found)
+    {
+        // Stale observations don't count towards the tracking quality either
+        inout_screen_area_sum-= found_screen_area_sum - kept_screen_area_sum;
+
+        SERVER_LOG_TRACE("ServerControllerView::synchronize_tracker_observations") << "Controller " << getDeviceID()
+            << " dropped " << (positions_found - synchronized_count) << " stale tracker observation(s) from triangulation";
+    }
+
+    return synchronized_count;
+}
+
 void ServerControllerView::updateStateAndPredict()
 {
     if (!getHasUnpublishedState())
@@ -532,56 +860,260 @@ void ServerControllerView::updateStateAndPredict()
     m_last_filter_update_timestamp = now;
     m_last_filter_update_timestamp_valid = true;
 
-    // Evenly apply the list of controller state updates over the time since last filter update
+    // States from controllers that report their own timestamps use the time between reports.
+    // Otherwise the list of controller state updates is evenly applied over the time since last filter update.
     float per_state_time_delta_seconds = time_delta_seconds / static_cast<float>(firstLookBackIndex + 1);
 
-    // Process the polled controller states forward in time
-    // computing the new orientation along the way.
+    // Keep count of received and dropped reports
     for (int lookBackIndex= firstLookBackIndex; lookBackIndex >= 0; --lookBackIndex)
     {
-        const CommonControllerState *controllerState= getState(lookBackIndex);
+        update_report_statistics(getState(lookBackIndex));
+    }
 
-        switch (controllerState->DeviceType)
+    if (get_uses_filter_history() && firstLookBackIndex < k_filter_history_size)
+    {
+        // Fuse the optical measurement at the sample it was captured at
+        // and re-apply the IMU samples that came after it
+        update_filters_with_history(firstLookBackIndex, per_state_time_delta_seconds, now);
+    }
+    else
+    {
+        // Without an IMU model there is nothing to re-propagate,
+        // so the current optical estimate is applied along with every new state
+        if (m_filter_history != nullptr)
         {
-        case CommonControllerState::PSMove:
-            {
-                const PSMoveController *psmoveController= this->castCheckedConst<PSMoveController>();
-                const PSMoveControllerState *psmoveState= static_cast<const PSMoveControllerState *>(controllerState);
-
-                // Only update the position filter when tracking is enabled
-                update_filters_for_psmove(
-                    psmoveController, psmoveState, 
-                    per_state_time_delta_seconds,
-                    m_multicam_pose_estimation, 
-                    m_orientation_filter, 
-                    getIsTrackingEnabled() ? m_position_filter : nullptr);
-            } break;
-        case CommonControllerState::PSNavi:
-            {
-                // No orientation or position to update
-                assert(m_orientation_filter == nullptr);
-                assert(m_position_filter == nullptr);
-            } break;
-        case CommonControllerState::PSDualShock4:
+            m_filter_history->clear();
+        }
+
+        // Process the polled controller states forward in time
+        // computing the new orientation along the way.
+        for (int lookBackIndex= firstLookBackIndex; lookBackIndex >= 0; --lookBackIndex)
+        {
+            const CommonControllerState *controllerState= getState(lookBackIndex);
+
+            update_filters_for_state(
+                controllerState, 
+                get_state_time_delta(controllerState, per_state_time_delta_seconds), 
+                m_multicam_pose_estimation);
+
+            // Consider this controller state sequence num processed
+            m_lastPollSeqNumProcessed= controllerState->PollSequenceNumber;
+        }
+    }
+}
+
+OrientationFilter * ServerControllerView::getOrientationFilterMutable()
+{
+    if (m_filter_history != nullptr)
+    {
+        m_filter_history->clear();
+    }
+
+    return m_orientation_filter;
+}
+
+PositionFilter * ServerControllerView::getPositionFilterMutable()
+{
+    if (m_filter_history != nullptr)
+    {
+        m_filter_history->clear();
+    }
+
+    return m_position_filter;
+}
+
+void ServerControllerView::update_report_statistics(const CommonControllerState *controllerState)
+{
+    ++m_report_statistics.ReceivedReportCount;
+    m_report_statistics.DroppedReportCount += controllerState->DroppedReportCount;
+
+    if (controllerState->bTimeDeltaValid)
+    {
+        ++m_report_rate_window_report_count;
+        m_report_rate_window_dropped_count += controllerState->DroppedReportCount;
+        m_report_rate_window_seconds += controllerState->TimeDeltaSeconds;
+
+        if (m_report_rate_window_seconds >= k_report_rate_window_seconds)
+        {
+            m_report_statistics.ReportRate = 
+                static_cast<float>(m_report_rate_window_report_count) / m_report_rate_window_seconds;
+
+            if (m_report_rate_window_dropped_count > 0)
             {
-                const PSDualShock4Controller *psdualshock4Controller = this->castCheckedConst<PSDualShock4Controller>();
-                const PSDualShock4ControllerState *psdualshock4State = 
-                    static_cast<const PSDualShock4ControllerState *>(controllerState);
-
-                // Only update the position filter when tracking is enabled
-                update_filters_for_psdualshock4(
-                    psdualshock4Controller, psdualshock4State,
-                    per_state_time_delta_seconds,
-                    m_multicam_pose_estimation,
-                    m_orientation_filter,
-                    getIsTrackingEnabled() ? m_position_filter : nullptr);
-            } break;
-        default:
-            assert(0 && "Unhandled controller type");
+                SERVER_LOG_DEBUG("ServerControllerView::update_report_statistics") 
+                    << "Controller " << getDeviceID() << " dropped " << m_report_rate_window_dropped_count 
+                    << " reports in the last " << m_report_rate_window_seconds << "s (" 
+                    << m_report_statistics.ReportRate << " reports/s received)";
+            }
+
+            m_report_rate_window_report_count = 0;
+            m_report_rate_window_dropped_count = 0;
+            m_report_rate_window_seconds = 0.f;
         }
+    }
+}
+
+bool ServerControllerView::get_uses_filter_history() const
+{
+    if (m_filter_history == nullptr || m_orientation_filter == nullptr || m_position_filter == nullptr)
+    {
+        return false;
+    }
+
+    // Only the filters that integrate IMU data between optical samples benefit from a replay.
+    // The optical-only smoothing filters just low-pass whatever optical position they are given.
+    const PositionFilter::FusionType position_fusion_type = m_position_filter->getFusionType();
+    const OrientationFilter::FusionType orientation_fusion_type = m_orientation_filter->getFusionType();
+
+    return 
+        position_fusion_type == PositionFilter::FusionTypeLowPassIMU ||
+        position_fusion_type == PositionFilter::FusionTypeComplimentaryOpticalIMU ||
+        orientation_fusion_type == OrientationFilter::FusionTypeComplementaryOpticalARG;
+}
+
+const CommonControllerState * ServerControllerView::find_state_by_poll_sequence_number(
+    int poll_sequence_number) const
+{
+    int lookBack = 0;
+    const CommonControllerState *state = getState(lookBack);
+
+    while (state != nullptr && state->PollSequenceNumber > poll_sequence_number)
+    {
+        ++lookBack;
+        state = getState(lookBack);
+    }
+
+    return (state != nullptr && state->PollSequenceNumber == poll_sequence_number) ? state : nullptr;
+}
+
+void ServerControllerView::update_filters_for_state(
+    const CommonControllerState *controllerState,
+    const float delta_time,
+    const ControllerOpticalPoseEstimation *poseEstimation)
+{
+    switch (controllerState->DeviceType)
+    {
+    case CommonControllerState::PSMove:
+        {
+            const PSMoveController *psmoveController= this->castCheckedConst<PSMoveController>();
+            const PSMoveControllerState *psmoveState= static_cast<const PSMoveControllerState *>(controllerState);
+
+            // Only update the position filter when tracking is enabled
+            update_filters_for_psmove(
+                psmoveController, psmoveState, 
+                delta_time,
+                poseEstimation, 
+                m_orientation_filter, 
+                getIsTrackingEnabled() ? m_position_filter : nullptr);
+        } break;
+    case CommonControllerState::PSNavi:
+        {
+            // No orientation or position to update
+            assert(m_orientation_filter == nullptr);
+            assert(m_position_filter == nullptr);
+        } break;
+    case CommonControllerState::PSDualShock4:
+        {
+            const PSDualShock4Controller *psdualshock4Controller = this->castCheckedConst<PSDualShock4Controller>();
+            const PSDualShock4ControllerState *psdualshock4State = 
+                static_cast<const PSDualShock4ControllerState *>(controllerState);
+
+            // Only update the position filter when tracking is enabled
+            update_filters_for_psdualshock4(
+                psdualshock4Controller, psdualshock4State,
+                delta_time,
+                poseEstimation,
+                m_orientation_filter,
+                getIsTrackingEnabled() ? m_position_filter : nullptr);
+        } break;
+    default:
+        assert(0 && "Unhandled controller type");
+    }
+}
+
+void ServerControllerView::update_filters_with_history(
+    const int firstLookBackIndex,
+    const float per_state_time_delta_seconds,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &now)
+{
+    ControllerFilterHistory *history = m_filter_history;
+    const int new_state_count = firstLookBackIndex + 1;
+
+    // Work out how long before now each new sample was taken, assuming the newest one arrived now.
+    // The sample spacing comes from the controller's report timestamps when it has them.
+    float state_ages[k_filter_history_size];
+    float state_time_deltas[k_filter_history_size];
+    float age = 0.f;
+    for (int lookBackIndex = 0; lookBackIndex <= firstLookBackIndex; ++lookBackIndex)
+    {
+        const CommonControllerState *controllerState = getState(lookBackIndex);
+
+        state_ages[lookBackIndex] = age;
+        state_time_deltas[lookBackIndex] = get_state_time_delta(controllerState, per_state_time_delta_seconds);
+        age += state_time_deltas[lookBackIndex];
+    }
+
+    // Add the new states to the history
+    for (int lookBackIndex = firstLookBackIndex; lookBackIndex >= 0; --lookBackIndex)
+    {
+        const CommonControllerState *controllerState = getState(lookBackIndex);
+        const std::chrono::duration<float> state_age(state_ages[lookBackIndex]);
+        FilterHistoryEntry &entry = history->push();
+
+        entry.sample_timestamp = 
+            now - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(state_age);
+        entry.poll_sequence_number = controllerState->PollSequenceNumber;
+        entry.delta_time = state_time_deltas[lookBackIndex];
+    }
+
+    const int first_new_index = history->count - new_state_count;
+    int optical_index = -1;
+
+    // See if there is an optical measurement that hasn't been fused yet
+    if (getIsTrackingEnabled() &&
+        (m_multicam_pose_estimation->bCurrentlyTracking || m_multicam_pose_estimation->bOrientationValid) &&
+        m_multicam_pose_estimation->capture_timestamp > m_last_fused_optical_timestamp)
+    {
+        optical_index = history->findOpticalSampleIndex(m_multicam_pose_estimation->capture_timestamp);
+        m_last_fused_optical_timestamp = m_multicam_pose_estimation->capture_timestamp;
+    }
+
+    // Rewind the filters to just before the optical sample if it lands on an older state
+    int replay_start_index = first_new_index;
+    if (optical_index >= 0 && optical_index < first_new_index)
+    {
+        history->rewindFiltersTo(optical_index, m_orientation_filter, m_position_filter);
+        replay_start_index = optical_index;
+    }
 
-        // Consider this controller state sequence num processed
-        m_lastPollSeqNumProcessed= controllerState->PollSequenceNumber;
+    // States before or after the optical sample only get IMU data
+    ControllerOpticalPoseEstimation noOpticalEstimate;
+    noOpticalEstimate.clear();
+
+    for (int history_index = replay_start_index; history_index < history->count; ++history_index)
+    {
+        FilterHistoryEntry &entry = history->at(history_index);
+        const CommonControllerState *controllerState = 
+            find_state_by_poll_sequence_number(entry.poll_sequence_number);
+
+        // Remember the filter state from before this sample in case we need to rewind to it later
+        history->saveFiltersBefore(history_index, m_orientation_filter, m_position_filter);
+
+        if (controllerState != nullptr)
+        {
+            entry.bOpticalApplied = (history_index == optical_index);
+
+            update_filters_for_state(
+                controllerState, 
+                entry.delta_time, 
+                entry.bOpticalApplied ? m_multicam_pose_estimation : &noOpticalEstimate);
+
+            // Consider this controller state sequence num processed
+            if (controllerState->PollSequenceNumber > m_lastPollSeqNumProcessed)
+            {
+                m_lastPollSeqNumProcessed = controllerState->PollSequenceNumber;
+            }
+        }
     }
 }
 
@@ -656,7 +1188,57 @@ ServerControllerView::getFilteredPhysics() const
     return physics;
 }
 
-bool 
+void
+ServerControllerView::getStreamSnapshot(ControllerStreamSnapshot &out_snapshot) const
+{
+    const CommonControllerState *controller_state = getState();
+    const CommonDevicePose pose = getFilteredPose();
+
+    out_snapshot.Clear();
+    out_snapshot.position = pose.Position;
+    out_snapshot.orientation = pose.Orientation;
+    out_snapshot.is_tracking = getIsCurrentlyTracking();
+
+    if (controller_state != nullptr)
+    {
+        out_snapshot.all_buttons = controller_state->AllButtons;
+        out_snapshot.battery = static_cast<int>(controller_state->Battery);
+
+        switch (controller_state->DeviceType)
+        {
+        case CommonDeviceState::PSMove:
+            {
+                const PSMoveControllerState *psmove_state = static_cast<const PSMoveControllerState *>(controller_state);
+
+                out_snapshot.analog_inputs[0] = psmove_state->TriggerValue;
+            } break;
+        case CommonDeviceState::PSNavi:
+            {
+                const PSNaviControllerState *psnavi_state = static_cast<const PSNaviControllerState *>(controller_state);
+
+                out_snapshot.analog_inputs[0] = psnavi_state->Trigger;
+                out_snapshot.analog_inputs[1] = psnavi_state->Stick_XAxis;
+                out_snapshot.analog_inputs[2] = psnavi_state->Stick_YAxis;
+            } break;
+        case CommonDeviceState::PSDualShock4:
+            {
+                const PSDualShock4ControllerState *ds4_state = static_cast<const PSDualShock4ControllerState *>(controller_state);
+
+                // Quantize to a byte so analog noise below the stick resolution doesn't count as a change
+                out_snapshot.analog_inputs[0] = static_cast<unsigned char>(ds4_state->LeftTrigger * 255.f);
+                out_snapshot.analog_inputs[1] = static_cast<unsigned char>(ds4_state->RightTrigger * 255.f);
+                out_snapshot.analog_inputs[2] = static_cast<unsigned char>((ds4_state->LeftAnalogX + 1.f) * 127.5f);
+                out_snapshot.analog_inputs[3] = static_cast<unsigned char>((ds4_state->LeftAnalogY + 1.f) * 127.5f);
+                out_snapshot.analog_inputs[4] = static_cast<unsigned char>((ds4_state->RightAnalogX + 1.f) * 127.5f);
+                out_snapshot.analog_inputs[5] = static_cast<unsigned char>((ds4_state->RightAnalogY + 1.f) * 127.5f);
+            } break;
+        default:
+            break;
+        }
+    }
+}
+
+bool
 ServerControllerView::getIsBluetooth() const
 {
     return (m_device != nullptr) ? m_device->getIsBluetooth() : false;
@@ -829,6 +1411,10 @@ void ServerControllerView::set_tracking_enabled_internal(bool bEnabled)
 
         m_tracking_enabled = bEnabled;
 
+        // Solve every frame until the controller has been seen sitting still for a while
+        m_last_motion_timestamp = std::chrono::high_resolution_clock::now();
+        m_optical_solve_throttled = false;
+
         update_LED_color_internal();
     }
 }
@@ -950,7 +1536,11 @@ void ServerControllerView::generate_controller_data_frame_for_stream(
 
     controller_data_frame->set_controller_id(controller_view->getDeviceID());
     controller_data_frame->set_sequence_num(controller_view->m_sequence_number);
+    controller_data_frame->set_stream_sequence_num(stream_info->stream_sequence_number);
     controller_data_frame->set_isconnected(controller_view->getDevice()->getIsOpen());
+    controller_data_frame->set_publish_timestamp_usec(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
 
     switch (controller_view->getControllerDeviceType())
     {
@@ -1083,7 +1673,10 @@ static void generate_psmove_data_frame_for_stream(
             auto *raw_tracker_data = psmove_data_frame->mutable_raw_tracker_data();
             int valid_tracker_count= 0;
 
-            for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
+            // Data frames are reused from one publish to the next, so start the lists over
+            raw_tracker_data->Clear();
+
+            for (int trackerId = 0; trackerId < controller_view->getTrackerPoseEstimateCount(); ++trackerId)
             {
                 const ControllerOpticalPoseEstimation *positionEstimate= 
                     controller_view->getTrackerPoseEstimate(trackerId);
@@ -1310,7 +1903,10 @@ static void generate_psdualshock4_data_frame_for_stream(
             auto *raw_tracker_data = psds4_data_frame->mutable_raw_tracker_data();
             int valid_tracker_count = 0;
 
-            for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
+            // Data frames are reused from one publish to the next, so start the lists over
+            raw_tracker_data->Clear();
+
+            for (int trackerId = 0; trackerId < controller_view->getTrackerPoseEstimateCount(); ++trackerId)
             {
                 const ControllerOpticalPoseEstimation *poseEstimate =
                     controller_view->getTrackerPoseEstimate(trackerId);
@@ -1406,6 +2002,16 @@ static void generate_psdualshock4_data_frame_for_stream(
     controller_data_frame->set_controller_type(PSMoveProtocol::PSDUALSHOCK4);
 }
 
+static float
+get_state_time_delta(
+    const CommonControllerState *controllerState, 
+    const float fallback_time_delta)
+{
+    return controllerState->bTimeDeltaValid
+        ? clampf(controllerState->TimeDeltaSeconds, k_min_report_time_delta_seconds, k_max_report_time_delta_seconds)
+        : fallback_time_delta;
+}
+
 static void
 init_filters_for_psmove(
     const PSMoveController *psmoveController, 
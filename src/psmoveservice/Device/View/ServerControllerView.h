@@ -6,39 +6,10 @@
 #include "ServerDeviceView.h"
 #include "PSMoveProtocolInterface.h"
 #include "TrackerManager.h"
+#include "ControllerOpticalPoseStorage.h"
 #include <chrono>
 
 // -- declarations -----
-struct ControllerOpticalPoseEstimation
-{
-    std::chrono::time_point<std::chrono::high_resolution_clock> last_update_timestamp;
-    std::chrono::time_point<std::chrono::high_resolution_clock> last_visible_timestamp;
-    bool bValidTimestamps;
-
-    CommonDevicePosition position;
-    CommonDeviceTrackingProjection projection;
-    bool bCurrentlyTracking;
-
-    CommonDeviceQuaternion orientation;
-    bool bOrientationValid;
-
-    inline void clear()
-    {
-        last_update_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
-        last_visible_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
-        bValidTimestamps= false;
-
-        position.clear();
-        bCurrentlyTracking= false;
-
-        orientation.clear();
-        bOrientationValid= false;
-
-        memset(&projection, 0, sizeof(CommonDeviceTrackingProjection));
-        projection.shape_type= eCommonTrackingProjectionType::INVALID_PROJECTION;
-    }
-};
-
 class ServerControllerView : public ServerDeviceView
 {
 public:
@@ -48,7 +19,12 @@ public:
     bool open(const class DeviceEnumerator *enumerator) override;
     void close() override;
 
-    // Compute pose/prediction of tracking blob+IMU state
+    // Compute pose/prediction of tracking blob+IMU state.
+    // Each tick: scheduleOpticalPoseEstimation(), then computeTrackerPoseEstimate() for every tracker
+    // (safe to run on a different thread per tracker), then updateOpticalPoseEstimation() 
+    // and updateStateAndPredict() (safe to run on a different thread per controller).
+    void scheduleOpticalPoseEstimation(TrackerManager* tracker_manager);
+    void computeTrackerPoseEstimate(class ServerTrackerView *tracker, int tracker_id);
     void updateOpticalPoseEstimation(TrackerManager* tracker_manager);
     void updateStateAndPredict();
 
@@ -56,9 +32,11 @@ public:
     bool setHostBluetoothAddress(const std::string &address);
     
     IDeviceInterface* getDevice() const override {return m_device;}
-    inline class OrientationFilter * getOrientationFilterMutable() { return m_orientation_filter; }
+    // NOTE: Fetching a mutable filter discards the filter history, 
+    // so that a later delayed optical measurement doesn't rewind past the change
+    class OrientationFilter * getOrientationFilterMutable();
     inline const class OrientationFilter * getOrientationFilter() const { return m_orientation_filter; }
-    inline class PositionFilter * getPositionFilterMutable() { return m_position_filter; }
+    class PositionFilter * getPositionFilterMutable();
     inline const class PositionFilter * getPositionFilter() const { return m_position_filter; }
 
     // Estimate the given pose if the controller at some point into the future
@@ -67,6 +45,12 @@ public:
     // Get the current physics from the filter position and orientation
     CommonDevicePhysics getFilteredPhysics() const;
 
+    // Fill in the state a change-only data stream compares against
+    void getStreamSnapshot(struct ControllerStreamSnapshot &out_snapshot) const;
+
+    // Received/dropped input report counts and report rate since the controller was opened
+    inline const CommonControllerReportStatistics &getReportStatistics() const { return m_report_statistics; }
+
     // Returns true if the device is connected via Bluetooth, false if by USB
     bool getIsBluetooth() const;
 
@@ -122,7 +106,12 @@ public:
 
     // Get the pose estimate relative to the given tracker id
     inline const ControllerOpticalPoseEstimation *getTrackerPoseEstimate(int trackerId) const {
-        return (m_tracker_pose_estimation != nullptr) ? &m_tracker_pose_estimation[trackerId] : nullptr;
+        return (m_optical_pose.tracker_pose_estimations != nullptr) ? &m_optical_pose.tracker_pose_estimations[trackerId] : nullptr;
+    }
+
+    // Number of per-tracker pose estimates (the tracker capacity when the controller was opened)
+    inline int getTrackerPoseEstimateCount() const {
+        return m_optical_pose.tracker_count;
     }
 
     // Get the pose estimate derived from multicam pose tracking
@@ -142,8 +131,31 @@ protected:
     void set_tracking_enabled_internal(bool bEnabled);
     void update_LED_color_internal();
     bool allocate_device_interface(const class DeviceEnumerator *enumerator) override;
+    void allocate_tracker_pose_estimation();
     void free_device_interface() override;
     void publish_device_data_frame() override;
+    void update_report_statistics(const CommonControllerState *controllerState);
+    int synchronize_tracker_observations(
+        TrackerManager* tracker_manager,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &reference_timestamp,
+        int *valid_position_tracker_ids,
+        const int positions_found,
+        float &inout_screen_area_sum,
+        float &out_capture_skew_milliseconds);
+    bool get_uses_filter_history() const;
+    bool get_is_moving() const;
+    bool update_optical_solve_schedule(
+        TrackerManager* tracker_manager,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &now);
+    const CommonControllerState *find_state_by_poll_sequence_number(int poll_sequence_number) const;
+    void update_filters_for_state(
+        const CommonControllerState *controllerState,
+        const float delta_time,
+        const ControllerOpticalPoseEstimation *poseEstimation);
+    void update_filters_with_history(
+        const int firstLookBackIndex,
+        const float per_state_time_delta_seconds,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &now);
     static void generate_controller_data_frame_for_stream(
         const ServerControllerView *controller_view,
         const struct ControllerStreamInfo *stream_info,
@@ -163,13 +175,28 @@ private:
     IControllerInterface *m_device;
     
     // Filter state
-    ControllerOpticalPoseEstimation *m_tracker_pose_estimation; // array of size TrackerManager::k_max_devices
+    // This controller slot's part of the controller manager's ControllerOpticalPoseStorage (all null until opened)
+    ControllerOpticalPoseSlice m_optical_pose;
     ControllerOpticalPoseEstimation *m_multicam_pose_estimation;
     class OrientationFilter *m_orientation_filter;
     class PositionFilter *m_position_filter;
+    struct ControllerFilterHistory *m_filter_history;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_last_fused_optical_timestamp;
+
+    // Optical solve scheduling (full rate while moving, periodic verification while stationary)
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_last_motion_timestamp;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_last_full_optical_solve_timestamp;
+    bool m_optical_solve_throttled;
+    bool m_full_optical_solve_this_tick;
     int m_lastPollSeqNumProcessed;
     std::chrono::time_point<std::chrono::high_resolution_clock> m_last_filter_update_timestamp;
     bool m_last_filter_update_timestamp_valid;
+
+    // Report statistics
+    CommonControllerReportStatistics m_report_statistics;
+    int m_report_rate_window_report_count;
+    int m_report_rate_window_dropped_count;
+    float m_report_rate_window_seconds;
 };
 
 #endif // SERVER_CONTROLLER_VIEW_H
\ No newline at end of file
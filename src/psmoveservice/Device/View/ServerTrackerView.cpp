@@ -9,29 +9,216 @@
 #include "MathAlignment.h"
 #include "PS3EyeTracker.h"
 #include "PSMoveProtocol.pb.h"
+#include "RemoteTracker.h"
 #include "ServerUtility.h"
 #include "ServerLog.h"
 #include "ServerRequestHandler.h"
 #include "SharedTrackerState.h"
 #include "TrackerManager.h"
+#include "TrackerNodePublisher.h"
+#include "BlobLabeler.h"
+#include "ColorMaskRunLength.h"
 
 #include <boost/interprocess/shared_memory_object.hpp>
 #include <boost/interprocess/mapped_region.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include "opencv2/opencv.hpp"
 #include "opencv2/calib3d/calib3d.hpp"
 
 #define USE_OPEN_CV_ELLIPSE_FIT
 
+//-- constants -----
+// Video frames in each tracker's frame pool: 
+// the frame being captured, the frame being filtered and published, and a spare
+static const int k_video_frame_pool_size = 3;
+
+// Shared memory video slots are at least this big (the largest PS3 Eye video mode, VGA in BGR),
+// so switching video modes resizes the frames in place instead of re-creating the shared memory
+// out from under the clients that have it mapped
+static const size_t k_min_shared_video_slot_size = 640 * 480 * 3;
+
+// Candidate tracking blobs are found on a pyramid level this many times smaller than the frame
+static const int k_coarse_pyramid_scale = 4;
+
+// Blobs are refined at the coarsest pyramid level that still leaves them at least this many pixels across
+static const int k_min_working_blob_diameter = 32;
+
+// Run-length encoded mask bytes per data frame, leaving room in MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE
+// for the rest of the tracker packet and the mask preview header
+static const int k_color_mask_preview_max_run_bytes = 360;
+
+// Network video stream defaults, used for any setting a client leaves at 0
+static const float k_default_network_video_max_rate_hz = 10.f;
+static const int k_default_network_video_downscale = 2;
+static const int k_default_network_video_jpeg_quality = 75;
+static const int k_max_network_video_downscale = 8;
+
 //-- private methods -----
+class VideoFramePool;
+
+// Counted reference to one of the video frames in a VideoFramePool.
+// The frame goes back to the pool when the last reference to it is released.
+// Only used on the main thread.
+class VideoFrameRef
+{
+public:
+    VideoFrameRef()
+        : m_pool(nullptr)
+        , m_slot(-1)
+    {}
+
+    VideoFrameRef(VideoFramePool *pool, int slot);
+
+    VideoFrameRef(const VideoFrameRef &other)
+        : m_pool(nullptr)
+        , m_slot(-1)
+    {
+        *this = other;
+    }
+
+    ~VideoFrameRef()
+    {
+        reset();
+    }
+
+    VideoFrameRef &operator=(const VideoFrameRef &other);
+
+    void reset();
+
+    inline bool isValid() const { return m_pool != nullptr; }
+    inline int getSlot() const { return m_slot; }
+    unsigned char *getBuffer() const;
+
+private:
+    VideoFramePool *m_pool;
+    int m_slot;
+};
+
+// Fixed set of video frame buffers, allocated when the tracker is opened.
+// The camera writes each frame straight into a pooled buffer and every later stage 
+// (filtering, the shared memory video stream) holds a reference to it instead of a copy.
+// When the tracker has a shared memory video stream the buffers are the stream's slots.
+class VideoFramePool
+{
+public:
+    VideoFramePool(int slot_count, size_t frame_size, unsigned char *slot_memory)
+        : m_ref_counts(slot_count, 0)
+        , m_frame_size(frame_size)
+        , m_slot_memory(slot_memory)
+        , m_heap_memory(nullptr)
+    {
+        if (m_slot_memory == nullptr)
+        {
+            m_heap_memory = new unsigned char[slot_count * frame_size];
+            m_slot_memory = m_heap_memory;
+        }
+    }
+
+    ~VideoFramePool()
+    {
+        for (int ref_count : m_ref_counts)
+        {
+            assert(ref_count == 0 && "Video frame still referenced when pool freed");
+        }
+
+        if (m_heap_memory != nullptr)
+        {
+            delete[] m_heap_memory;
+        }
+    }
+
+    // Returns a reference to an unused frame (or an invalid reference if every frame is in use)
+    VideoFrameRef acquire()
+    {
+        for (int slot = 0; slot < static_cast<int>(m_ref_counts.size()); ++slot)
+        {
+            if (m_ref_counts[slot] == 0)
+            {
+                return VideoFrameRef(this, slot);
+            }
+        }
+
+        return VideoFrameRef();
+    }
+
+    inline size_t getFrameSize() const { return m_frame_size; }
+
+    inline unsigned char *getSlotBuffer(int slot) const
+    {
+        return m_slot_memory + slot * m_frame_size;
+    }
+
+private:
+    friend class VideoFrameRef;
+
+    inline void addRef(int slot)
+    {
+        ++m_ref_counts[slot];
+    }
+
+    inline void release(int slot)
+    {
+        assert(m_ref_counts[slot] > 0);
+        --m_ref_counts[slot];
+    }
+
+    std::vector<int> m_ref_counts;
+    size_t m_frame_size;
+    unsigned char *m_slot_memory;
+    unsigned char *m_heap_memory;
+};
+
+VideoFrameRef::VideoFrameRef(VideoFramePool *pool, int slot)
+    : m_pool(pool)
+    , m_slot(slot)
+{
+    m_pool->addRef(m_slot);
+}
+
+VideoFrameRef &VideoFrameRef::operator=(const VideoFrameRef &other)
+{
+    if (other.m_pool != nullptr)
+    {
+        other.m_pool->addRef(other.m_slot);
+    }
+
+    reset();
+
+    m_pool = other.m_pool;
+    m_slot = other.m_slot;
+
+    return *this;
+}
+
+void VideoFrameRef::reset()
+{
+    if (m_pool != nullptr)
+    {
+        m_pool->release(m_slot);
+        m_pool = nullptr;
+        m_slot = -1;
+    }
+}
+
+unsigned char *VideoFrameRef::getBuffer() const
+{
+    return (m_pool != nullptr) ? m_pool->getSlotBuffer(m_slot) : nullptr;
+}
+
 class SharedVideoFrameReadWriteAccessor
 {
 public:
     SharedVideoFrameReadWriteAccessor()
         : m_shared_memory_object(nullptr)
         , m_region(nullptr)
+        , m_slot_capacity(0)
     {}
 
     ~SharedVideoFrameReadWriteAccessor()
@@ -39,7 +226,7 @@ public:
         dispose();
     }
 
-    bool initialize(const char *shared_memory_name, int width, int height, int stride)
+    bool initialize(const char *shared_memory_name, int width, int height, int stride, int slot_count)
     {
         bool bSuccess = false;
 
@@ -65,8 +252,10 @@ public:
                     boost::interprocess::read_write,
                     permissions);
 
-            // Resize the shared memory
-            m_shared_memory_object->truncate(SharedVideoFrameHeader::computeTotalSize(stride, width));
+            // Resize the shared memory, leaving room for bigger frames
+            m_slot_capacity =
+                std::max(SharedVideoFrameHeader::computeVideoBufferSize(stride, height), k_min_shared_video_slot_size);
+            m_shared_memory_object->truncate(sizeof(SharedVideoFrameHeader) + slot_count*m_slot_capacity);
 
             // Map all of the shared memory for read/write access
             m_region = new boost::interprocess::mapped_region(*m_shared_memory_object, boost::interprocess::read_write);
@@ -79,10 +268,12 @@ public:
             frameState->height = height;
             frameState->stride = stride;
             frameState->frame_index = 0;
+            frameState->slot_count = slot_count;
+            frameState->current_slot = 0;
             std::memset(
-                frameState->getBufferMutable(),
+                frameState->getSlotBufferMutable(0),
                 0,
-                SharedVideoFrameHeader::computeVideoBufferSize(stride, height));
+                slot_count*SharedVideoFrameHeader::computeVideoBufferSize(stride, height));
 
             bSuccess = true;
         }
@@ -98,6 +289,8 @@ public:
 
     void dispose()
     {
+        m_published_frame.reset();
+
         if (m_region != nullptr)
         {
             // Call the destructor manually on the frame header since it was constructed via placement new
@@ -120,19 +313,63 @@ public:
         }
     }
 
-    void writeVideoFrame(const unsigned char *buffer)
+    // Changes the frame size in place if the frames still fit in the existing slots.
+    // Clients keep their mapping and pick up the new size from the header.
+    // Published frames have to be released first, the frame pool they come from is going away.
+    bool resize(int width, int height, int stride)
+    {
+        if (m_region == nullptr || SharedVideoFrameHeader::computeVideoBufferSize(stride, height) > m_slot_capacity)
+        {
+            return false;
+        }
+
+        m_published_frame.reset();
+
+        SharedVideoFrameHeader *sharedFrameState = getFrameHeader();
+        {
+            boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> lock(sharedFrameState->mutex);
+
+            sharedFrameState->width = width;
+            sharedFrameState->height = height;
+            sharedFrameState->stride = stride;
+            sharedFrameState->current_slot = 0;
+            std::memset(
+                sharedFrameState->getSlotBufferMutable(0),
+                0,
+                sharedFrameState->slot_count*SharedVideoFrameHeader::computeVideoBufferSize(stride, height));
+            ++sharedFrameState->frame_index;
+        }
+
+        return true;
+    }
+
+    // The memory backing the frame buffer slots (used as the video frame pool)
+    unsigned char *getSlotMemory()
+    {
+        return getFrameHeader()->getSlotBufferMutable(0);
+    }
+
+    // Make a video frame that was written into one of the slots visible to readers.
+    // Holds a reference to the frame so it isn't reused while readers can see it.
+    void publishVideoFrame(const VideoFrameRef &frame)
     {
         SharedVideoFrameHeader *sharedFrameState = getFrameHeader();
-        boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> lock(sharedFrameState->mutex);
 
-        size_t buffer_size = 
-            SharedVideoFrameHeader::computeVideoBufferSize(sharedFrameState->stride, sharedFrameState->height);
-        size_t total_shared_mem_size =
-            SharedVideoFrameHeader::computeTotalSize(sharedFrameState->stride, sharedFrameState->height);
-        assert(m_region->get_size() >= total_shared_mem_size);
+        {
+            boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> lock(sharedFrameState->mutex);
+
+            assert(frame.getSlot() >= 0 && frame.getSlot() < sharedFrameState->slot_count);
+            sharedFrameState->current_slot = frame.getSlot();
+            ++sharedFrameState->frame_index;
+        }
 
-        ++sharedFrameState->frame_index;
-        std::memcpy(sharedFrameState->getBufferMutable(), buffer, buffer_size);
+        m_published_frame = frame;
+    }
+
+    // Called once no one is reading the stream, so the published frame can be reused
+    void releasePublishedVideoFrame()
+    {
+        m_published_frame.reset();
     }
 
 protected:
@@ -145,6 +382,8 @@ private:
     const char *m_shared_memory_name;
     boost::interprocess::shared_memory_object *m_shared_memory_object;
     boost::interprocess::mapped_region *m_region;
+    size_t m_slot_capacity;
+    VideoFrameRef m_published_frame;
 };
 
 struct OpenCVPlane2D
@@ -237,6 +476,10 @@ public:
 
 	static OpenCVBGRToHSVMapper *allocate()
 	{
+		// Trackers can be opened on several threads at once.
+		// Whoever gets here first builds the table while the rest wait for it.
+		std::lock_guard<std::mutex> lock(m_mutex);
+
 		if (m_refCount == 0)
 		{
 			assert(m_instance == nullptr);
@@ -250,6 +493,8 @@ public:
 
 	static void dispose(OpenCVBGRToHSVMapper *instance)
 	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
 		assert(m_instance != nullptr);
 		assert(m_instance == instance);
 		assert(m_refCount > 0);
@@ -278,6 +523,7 @@ public:
 private:
 	static OpenCVBGRToHSVMapper *m_instance;
 	static int m_refCount;
+	static std::mutex m_mutex;
 
 	OpenCVBGRToHSVMapper()
 	{
@@ -313,6 +559,7 @@ private:
 };
 OpenCVBGRToHSVMapper *OpenCVBGRToHSVMapper::m_instance = nullptr;
 int OpenCVBGRToHSVMapper::m_refCount= 0;
+std::mutex OpenCVBGRToHSVMapper::m_mutex;
 
 class OpenCVBufferState
 {
@@ -320,16 +567,32 @@ public:
     OpenCVBufferState(int width, int height)
         : frameWidth(width)
         , frameHeight(height)
+        , bgrFrame()
         , bgrBuffer(nullptr)
+        , ownedBgrBuffer(nullptr)
         , hsvBuffer(nullptr)
+        , hsvBufferValid(false)
+        , halfBgrBuffer(nullptr)
+        , halfHsvBuffer(nullptr)
+        , coarseBgrBuffer(nullptr)
+        , coarseHsvBuffer(nullptr)
+        , coarseMaskBuffer(nullptr)
+        , coarseScratchMaskBuffer(nullptr)
         , gsLowerBuffer(nullptr)
         , gsUpperBuffer(nullptr)
         , maskedBuffer(nullptr)
     {
 		const TrackerManagerConfig &cfg= DeviceManager::getInstance()->m_tracker_manager->getConfig();
 
-        bgrBuffer = new cv::Mat(height, width, CV_8UC3);
+        bgrBuffer = new cv::Mat();
+        ownedBgrBuffer = new cv::Mat(height, width, CV_8UC3);
         hsvBuffer = new cv::Mat(height, width, CV_8UC3);
+        halfBgrBuffer = new cv::Mat(height / 2, width / 2, CV_8UC3);
+        halfHsvBuffer = new cv::Mat(height / 2, width / 2, CV_8UC3);
+        coarseBgrBuffer = new cv::Mat(height / k_coarse_pyramid_scale, width / k_coarse_pyramid_scale, CV_8UC3);
+        coarseHsvBuffer = new cv::Mat(height / k_coarse_pyramid_scale, width / k_coarse_pyramid_scale, CV_8UC3);
+        coarseMaskBuffer = new cv::Mat(height / k_coarse_pyramid_scale, width / k_coarse_pyramid_scale, CV_8UC1);
+        coarseScratchMaskBuffer = new cv::Mat(height / k_coarse_pyramid_scale, width / k_coarse_pyramid_scale, CV_8UC1);
         gsLowerBuffer = new cv::Mat(height, width, CV_8UC1);
         gsUpperBuffer = new cv::Mat(height, width, CV_8UC1);
         maskedBuffer = new cv::Mat(height, width, CV_8UC3);
@@ -361,6 +624,36 @@ public:
             delete gsUpperBuffer;
         }
 
+        if (coarseScratchMaskBuffer != nullptr)
+        {
+            delete coarseScratchMaskBuffer;
+        }
+
+        if (coarseMaskBuffer != nullptr)
+        {
+            delete coarseMaskBuffer;
+        }
+
+        if (coarseHsvBuffer != nullptr)
+        {
+            delete coarseHsvBuffer;
+        }
+
+        if (coarseBgrBuffer != nullptr)
+        {
+            delete coarseBgrBuffer;
+        }
+
+        if (halfHsvBuffer != nullptr)
+        {
+            delete halfHsvBuffer;
+        }
+
+        if (halfBgrBuffer != nullptr)
+        {
+            delete halfBgrBuffer;
+        }
+
         if (hsvBuffer != nullptr)
         {
             delete hsvBuffer;
@@ -371,138 +664,442 @@ public:
             delete bgrBuffer;
         }
 
+        if (ownedBgrBuffer != nullptr)
+        {
+            delete ownedBgrBuffer;
+        }
+
 		if (bgr2hsv != nullptr)
 		{
 			OpenCVBGRToHSVMapper::dispose(bgr2hsv);
 		}
     }
 
+    // Filter a pooled video frame without copying it.
+    // Keeps a reference to the frame until the next one comes in.
+    void setVideoFrame(const VideoFrameRef &frame)
+    {
+        bgrFrame = frame;
+        *bgrBuffer = cv::Mat(frameHeight, frameWidth, CV_8UC3, frame.getBuffer());
+
+        // Flip image about the x-axis in place
+        cv::flip(*bgrBuffer, *bgrBuffer, 1);
+
+        buildCoarseLevel();
+    }
+
+    // Filter a video frame that isn't in the frame pool (copied into our own buffer)
     void writeVideoFrame(const unsigned char *video_buffer)
     {
         const cv::Mat videoBufferMat(frameHeight, frameWidth, CV_8UC3, const_cast<unsigned char *>(video_buffer));
 
+        bgrFrame.reset();
+        *bgrBuffer = *ownedBgrBuffer;
+
         // Copy and Flip image about the x-axis
         cv::flip(videoBufferMat, *bgrBuffer, 1);
 
+        buildCoarseLevel();
+    }
+
+    // Only the coarse pyramid level gets converted to HSV up front.
+    // Full (or half) resolution HSV is only computed in the windows around candidate blobs.
+    void buildCoarseLevel()
+    {
+        cv::resize(*bgrBuffer, *coarseBgrBuffer, coarseBgrBuffer->size(), 0, 0, cv::INTER_AREA);
+        convertToHSV(*coarseBgrBuffer, *coarseHsvBuffer);
+
+        hsvBufferValid = false;
+    }
+
+    void convertToHSV(const cv::Mat &bgr, cv::Mat &hsv)
+    {
         // Convert the video buffer to the HSV color space
 		if (bgr2hsv != nullptr)
 		{
-			bgr2hsv->cvtColor(*bgrBuffer, *hsvBuffer);
+			bgr2hsv->cvtColor(bgr, hsv);
 		}
 		else
 		{
-			cv::cvtColor(*bgrBuffer, *hsvBuffer, cv::COLOR_BGR2HSV);
+			cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
 		}
     }
 
+    // Clamp the HSV image into a grayscale mask, taking into account wrapping the hue angle
+    static void computeColorMask(
+        const CommonHSVColorRange &hsvColorRange,
+        const cv::Mat &hsv,
+        cv::Mat &mask,
+        cv::Mat &scratchMask)
+    {
+        const float hue_min = hsvColorRange.hue_range.center - hsvColorRange.hue_range.range;
+        const float hue_max = hsvColorRange.hue_range.center + hsvColorRange.hue_range.range;
+        const float saturation_min = clampf(hsvColorRange.saturation_range.center - hsvColorRange.saturation_range.range, 0, 255);
+        const float saturation_max = clampf(hsvColorRange.saturation_range.center + hsvColorRange.saturation_range.range, 0, 255);
+        const float value_min = clampf(hsvColorRange.value_range.center - hsvColorRange.value_range.range, 0, 255);
+        const float value_max = clampf(hsvColorRange.value_range.center + hsvColorRange.value_range.range, 0, 255);
+
+        if (hue_min < 0)
+        {
+            cv::inRange(
+                hsv,
+                cv::Scalar(0, saturation_min, value_min),
+                cv::Scalar(clampf(hue_max, 0, 180), saturation_max, value_max),
+                mask);
+            cv::inRange(
+                hsv,
+                cv::Scalar(clampf(180 + hue_min, 0, 180), saturation_min, value_min),
+                cv::Scalar(180, saturation_max, value_max),
+                scratchMask);
+            cv::bitwise_or(mask, scratchMask, mask);
+        }
+        else if (hue_max > 180)
+        {
+            cv::inRange(
+                hsv,
+                cv::Scalar(0, saturation_min, value_min),
+                cv::Scalar(clampf(hue_max - 180, 0, 180), saturation_max, value_max),
+                mask);
+            cv::inRange(
+                hsv,
+                cv::Scalar(clampf(hue_min, 0, 180), saturation_min, value_min),
+                cv::Scalar(180, saturation_max, value_max),
+                scratchMask);
+            cv::bitwise_or(mask, scratchMask, mask);
+        }
+        else
+        {
+            cv::inRange(
+                hsv,
+                cv::Scalar(hue_min, saturation_min, value_min),
+                cv::Scalar(hue_max, saturation_max, value_max),
+                mask);
+        }
+    }
+
+    // Traces the biggest blob in the mask into biggestContour.
+    // Candidate blobs are found on the coarse pyramid level, then only the window around
+    // the biggest one is filtered again at the coarsest resolution that still leaves 
+    // enough pixels across the blob for a precise fit (bulbs close to the camera don't 
+    // need every pixel, far away ones do).
     // Return points in raw image space:
     // i.e. [0, 0] at lower left  to [frameWidth-1, frameHeight-1] at lower right
-    bool computeBiggestContour(
-        const CommonHSVColorRange &hsvColorRange,
-        std::vector<cv::Point> &out_biggest_contour)
+    bool computeBiggestContour(const CommonHSVColorRange &hsvColorRange)
     {
-        // Clamp the HSV image, taking into account wrapping the hue angle
+        const cv::Rect frameRect(0, 0, frameWidth, frameHeight);
+        cv::Rect window = frameRect;
+        int scale = 1;
+        int workingWidth, workingHeight;
+        BlobLabeler *workingLabeler = &blobLabeler;
+
+        // Find candidate blobs on the coarse level
+        computeColorMask(hsvColorRange, *coarseHsvBuffer, *coarseMaskBuffer, *coarseScratchMaskBuffer);
+        coarseBlobLabeler.labelMask(
+            coarseMaskBuffer->data, coarseMaskBuffer->cols, coarseMaskBuffer->rows, static_cast<int>(coarseMaskBuffer->step));
+
+        const int coarseBlobIndex = coarseBlobLabeler.findLargestBlob();
+        if (coarseBlobIndex >= 0)
         {
-            const float hue_min = hsvColorRange.hue_range.center - hsvColorRange.hue_range.range;
-            const float hue_max = hsvColorRange.hue_range.center + hsvColorRange.hue_range.range;
-            const float saturation_min = clampf(hsvColorRange.saturation_range.center - hsvColorRange.saturation_range.range, 0, 255);
-            const float saturation_max = clampf(hsvColorRange.saturation_range.center + hsvColorRange.saturation_range.range, 0, 255);
-            const float value_min = clampf(hsvColorRange.value_range.center - hsvColorRange.value_range.range, 0, 255);
-            const float value_max = clampf(hsvColorRange.value_range.center + hsvColorRange.value_range.range, 0, 255);
-
-            if (hue_min < 0)
-            {
-                cv::inRange(
-                    *hsvBuffer,
-                    cv::Scalar(0, saturation_min, value_min),
-                    cv::Scalar(clampf(hue_max, 0, 180), saturation_max, value_max),
-                    *gsLowerBuffer);
-                cv::inRange(
-                    *hsvBuffer,
-                    cv::Scalar(clampf(180 + hue_min, 0, 180), saturation_min, value_min),
-                    cv::Scalar(180, saturation_max, value_max),
-                    *gsUpperBuffer);
-                cv::bitwise_or(*gsLowerBuffer, *gsUpperBuffer, *gsLowerBuffer);
-            }
-            else if (hue_max > 180)
-            {
-                cv::inRange(
-                    *hsvBuffer,
-                    cv::Scalar(0, saturation_min, value_min),
-                    cv::Scalar(clampf(hue_max - 180, 0, 180), saturation_max, value_max),
-                    *gsLowerBuffer);
-                cv::inRange(
-                    *hsvBuffer,
-                    cv::Scalar(clampf(hue_min, 0, 180), saturation_min, value_min),
-                    cv::Scalar(180, saturation_max, value_max),
-                    *gsUpperBuffer);
-                cv::bitwise_or(*gsLowerBuffer, *gsUpperBuffer, *gsLowerBuffer);
-            }
-            else
-            {
-                cv::inRange(
-                    *hsvBuffer,
-                    cv::Scalar(hue_min, saturation_min, value_min),
-                    cv::Scalar(hue_max, saturation_max, value_max),
-                    *gsLowerBuffer);
-            }
+            const BlobInfo &coarseBlob = coarseBlobLabeler.getBlob(coarseBlobIndex);
+            const int coarseBlobWidth = coarseBlob.max_x - coarseBlob.min_x + 1;
+            const int coarseBlobHeight = coarseBlob.max_y - coarseBlob.min_y + 1;
+
+            scale = selectBlobWorkingScale(
+                std::max(coarseBlobWidth, coarseBlobHeight), k_coarse_pyramid_scale, k_min_working_blob_diameter);
+
+            // Pad the candidate by a coarse pixel on every side to catch the blob's edges
+            window = cv::Rect(
+                (coarseBlob.min_x - 1) * k_coarse_pyramid_scale,
+                (coarseBlob.min_y - 1) * k_coarse_pyramid_scale,
+                (coarseBlobWidth + 2) * k_coarse_pyramid_scale,
+                (coarseBlobHeight + 2) * k_coarse_pyramid_scale) & frameRect;
         }
+        // Otherwise nothing survived the coarse level (e.g. a small, far away bulb),
+        // so fall back to searching the whole frame at full resolution
 
-        // Find the largest convex blob in the filtered grayscale buffer
+        if (scale == k_coarse_pyramid_scale)
+        {
+            // The coarse mask is already good enough for a blob this big
+            window = frameRect;
+            workingWidth = coarseMaskBuffer->cols;
+            workingHeight = coarseMaskBuffer->rows;
+            workingLabeler = &coarseBlobLabeler;
+        }
+        else
         {
-            std::vector<std::vector<cv::Point> > contours;
-            cv::findContours(*gsLowerBuffer, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
+            cv::Mat workingHsv;
 
-            if (contours.size() > 0)
+            if (scale == 1)
             {
-                double contArea = 0;
-                double newArea = 0;
-                for (auto it = contours.begin(); it != contours.end(); ++it) 
-                {
-                    newArea = cv::contourArea(*it);
+                workingHsv = (*hsvBuffer)(window);
 
-                    if (newArea > contArea)
-                    {
-                        contArea = newArea;
-                        out_biggest_contour = *it;
-                    }
+                if (!hsvBufferValid)
+                {
+                    convertToHSV((*bgrBuffer)(window), workingHsv);
+                    hsvBufferValid = (window == frameRect);
                 }
             }
+            else
+            {
+                const cv::Rect halfRect(0, 0, window.width / scale, window.height / scale);
+                cv::Mat halfBgr = (*halfBgrBuffer)(halfRect);
+
+                cv::resize((*bgrBuffer)(window), halfBgr, halfRect.size(), 0, 0, cv::INTER_AREA);
+                workingHsv = (*halfHsvBuffer)(halfRect);
+                convertToHSV(halfBgr, workingHsv);
+            }
+
+            workingWidth = workingHsv.cols;
+            workingHeight = workingHsv.rows;
+
+            cv::Mat workingMask = (*gsLowerBuffer)(cv::Rect(0, 0, workingWidth, workingHeight));
+            cv::Mat scratchMask = (*gsUpperBuffer)(cv::Rect(0, 0, workingWidth, workingHeight));
+            computeColorMask(hsvColorRange, workingHsv, workingMask, scratchMask);
+
+            blobLabeler.labelMask(workingMask.data, workingWidth, workingHeight, static_cast<int>(workingMask.step));
+        }
+
+        // Find the largest blob in the filtered grayscale buffer.
+        // The blob areas come out of a single labeling pass over the mask,
+        // so only the winner's boundary gets traced (however many specks of glare there are).
+        {
+            workingLabeler->traceBlobBoundary(workingLabeler->findLargestBlob(), biggestContour);
 
             //TODO: If our contour is suddenly much smaller than last frame,
             // but is next to an almost-as-big contour, then maybe these
             // 2 contours should be joined.
             // (i.e. if a finger is blocking the middle of the bulb)
-            if (out_biggest_contour.size() > 6)
+            if (biggestContour.size() > 6)
             {
                 // Remove any points in contour on edge of camera/ROI
-                std::vector<cv::Point>::iterator it = out_biggest_contour.begin();
-                while (it != out_biggest_contour.end()) {
-                    if (it->x == 0 || it->x == (frameWidth-1) || it->y == 0 || it->y == (frameHeight-1)) 
-                    {
-                        it = out_biggest_contour.erase(it);
-                    }
-                    else 
-                    {
-                        ++it;
-                    }
-                }
+                // (only the window sides that lie on the frame edge count)
+                const int minX = (window.x == 0) ? 0 : -1;
+                const int minY = (window.y == 0) ? 0 : -1;
+                const int maxX = (window.x + window.width >= frameWidth) ? workingWidth - 1 : workingWidth;
+                const int maxY = (window.y + window.height >= frameHeight) ? workingHeight - 1 : workingHeight;
+
+                biggestContour.erase(
+                    std::remove_if(
+                        biggestContour.begin(), biggestContour.end(), 
+                        [minX, minY, maxX, maxY](const cv::Point &p) { 
+                            return p.x == minX || p.x == maxX || p.y == minY || p.y == maxY; 
+                        }),
+                    biggestContour.end());
+            }
+
+            // Map the contour from the working window back into the full resolution frame
+            if (scale != 1 || window.x != 0 || window.y != 0)
+            {
+                mapWorkingPointsToFrame(window.x, window.y, scale, biggestContour);
+            }
+        }
+
+        return (biggestContour.size() > 5);
+    }
+
+    // Filters the whole frame at 1/downscale resolution into previewMaskBuffer 
+    // and labels its blobs (for color calibration previews)
+    void computePreviewMask(const CommonHSVColorRange &hsvColorRange, int downscale)
+    {
+        const cv::Size previewSize(frameWidth / downscale, frameHeight / downscale);
+        cv::Mat previewHsv;
+
+        if (previewSize == coarseHsvBuffer->size())
+        {
+            // Already converted for the blob search
+            previewHsv = *coarseHsvBuffer;
+        }
+        else if (downscale == 1)
+        {
+            if (!hsvBufferValid)
+            {
+                convertToHSV(*bgrBuffer, *hsvBuffer);
+                hsvBufferValid = true;
             }
+
+            previewHsv = *hsvBuffer;
+        }
+        else
+        {
+            previewBgrBuffer.create(previewSize, CV_8UC3);
+            previewHsvBuffer.create(previewSize, CV_8UC3);
+            cv::resize(*bgrBuffer, previewBgrBuffer, previewSize, 0, 0, cv::INTER_AREA);
+            convertToHSV(previewBgrBuffer, previewHsvBuffer);
+
+            previewHsv = previewHsvBuffer;
         }
 
-        return (out_biggest_contour.size() > 5);
+        previewMaskBuffer.create(previewSize, CV_8UC1);
+        previewScratchMaskBuffer.create(previewSize, CV_8UC1);
+        computeColorMask(hsvColorRange, previewHsv, previewMaskBuffer, previewScratchMaskBuffer);
+
+        previewBlobLabeler.labelMask(
+            previewMaskBuffer.data, previewMaskBuffer.cols, previewMaskBuffer.rows, static_cast<int>(previewMaskBuffer.step));
     }
 
     int frameWidth;
     int frameHeight;
+    VideoFrameRef bgrFrame; // pooled video frame bgrBuffer points into (if any)
     cv::Mat *bgrBuffer; // source video frame
-    cv::Mat *hsvBuffer; // source frame converted to HSV color space
+    cv::Mat *ownedBgrBuffer; // source video frame copy when the frame isn't pooled
+    cv::Mat *hsvBuffer; // source frame converted to HSV color space (only the windows searched)
+    bool hsvBufferValid; // true once the whole of hsvBuffer was converted this frame
+    cv::Mat *halfBgrBuffer; // half resolution copy of a search window
+    cv::Mat *halfHsvBuffer; // half resolution search window converted to HSV color space
+    cv::Mat *coarseBgrBuffer; // source frame at 1/k_coarse_pyramid_scale resolution
+    cv::Mat *coarseHsvBuffer; // coarse frame converted to HSV color space
+    cv::Mat *coarseMaskBuffer; // coarse HSV image clamped by HSV range into grayscale mask
+    cv::Mat *coarseScratchMaskBuffer; // coarse HSV image clamped by HSV range into grayscale mask
     cv::Mat *gsLowerBuffer; // HSV image clamped by HSV range into grayscale mask
     cv::Mat *gsUpperBuffer; // HSV image clamped by HSV range into grayscale mask
     cv::Mat *maskedBuffer; // bgr image ANDed together with grayscale mask
+    BlobLabeler coarseBlobLabeler; // finds candidate blobs in the coarse grayscale mask
+    BlobLabeler blobLabeler; // finds the blobs in the grayscale mask of the search window
+    std::vector<cv::Point> biggestContour; // boundary of the biggest blob found (reused every frame)
+    std::vector<cv::Point> convexContour; // convex hull of the biggest contour (reused every frame)
+    std::vector<Eigen::Vector2f> eigenContour; // convex hull in screen location space (reused every frame)
+    cv::Mat previewBgrBuffer; // downscaled source frame for the color mask preview
+    cv::Mat previewHsvBuffer; // downscaled frame converted to HSV color space
+    cv::Mat previewMaskBuffer; // color mask preview sent to clients
+    cv::Mat previewScratchMaskBuffer; // second half of a hue range that wraps around
+    BlobLabeler previewBlobLabeler; // blob statistics of the color mask preview
 	OpenCVBGRToHSVMapper *bgr2hsv; // Used to convert an rgb image to an hsv image
 };
 
+// Compresses video frames for the network video streams on its own thread 
+// so that the tracker poll never waits on the JPEG encoder.
+// Only the latest frame is kept: the tracker view doesn't submit a new frame until the last one is done.
+class NetworkVideoEncoder
+{
+public:
+    NetworkVideoEncoder()
+        : m_pending_frame()
+        , m_encoding_frame()
+        , m_pending_frame_sequence_num(-1)
+        , m_pending_frame_width(0)
+        , m_pending_frame_height(0)
+        , m_pending_downscale(1)
+        , m_pending_jpeg_quality(k_default_network_video_jpeg_quality)
+        , m_latest_frame()
+        , m_has_pending_frame(false)
+        , m_is_encoding(false)
+        , m_stop_requested(false)
+    {
+        m_thread = std::thread(&NetworkVideoEncoder::thread_func, this);
+    }
+
+    ~NetworkVideoEncoder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_stop_requested = true;
+            m_condition.notify_one();
+        }
+
+        // Waits on at most the one frame being compressed
+        m_thread.join();
+    }
+
+    bool getIsBusy() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_has_pending_frame || m_is_encoding;
+    }
+
+    // Downscales the video frame into the worker's input buffer and wakes the worker
+    void submitVideoFrame(const cv::Mat &bgr_frame, int frame_sequence_num, int downscale, int jpeg_quality)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (downscale > 1)
+        {
+            cv::resize(
+                bgr_frame, m_pending_frame, 
+                cv::Size(bgr_frame.cols / downscale, bgr_frame.rows / downscale),
+                0, 0, cv::INTER_AREA);
+        }
+        else
+        {
+            bgr_frame.copyTo(m_pending_frame);
+        }
+
+        m_pending_frame_sequence_num = frame_sequence_num;
+        m_pending_frame_width = bgr_frame.cols;
+        m_pending_frame_height = bgr_frame.rows;
+        m_pending_downscale = downscale;
+        m_pending_jpeg_quality = jpeg_quality;
+        m_has_pending_frame = true;
+        m_condition.notify_one();
+    }
+
+    TrackerNetworkVideoFramePtr getLatestVideoFrame() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_latest_frame;
+    }
+
+private:
+    void thread_func()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_stop_requested)
+        {
+            if (!m_has_pending_frame)
+            {
+                m_condition.wait(lock);
+                continue;
+            }
+
+            std::shared_ptr<TrackerNetworkVideoFrame> video_frame(new TrackerNetworkVideoFrame);
+            video_frame->frame_sequence_num = m_pending_frame_sequence_num;
+            video_frame->frame_width = m_pending_frame_width;
+            video_frame->frame_height = m_pending_frame_height;
+            video_frame->downscale = m_pending_downscale;
+
+            const std::vector<int> encode_params = { cv::IMWRITE_JPEG_QUALITY, m_pending_jpeg_quality };
+
+            cv::swap(m_pending_frame, m_encoding_frame);
+            m_has_pending_frame = false;
+            m_is_encoding = true;
+
+            // Compressing is the slow part, so don't hold the lock for it
+            lock.unlock();
+            const bool bEncoded = cv::imencode(".jpg", m_encoding_frame, video_frame->jpeg_data, encode_params);
+            lock.lock();
+
+            m_is_encoding = false;
+
+            if (bEncoded)
+            {
+                m_latest_frame = video_frame;
+            }
+            else
+            {
+                SERVER_LOG_WARNING("NetworkVideoEncoder") << "Failed to compress video frame " << video_frame->frame_sequence_num;
+            }
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+
+    cv::Mat m_pending_frame; // downscaled frame waiting for the worker
+    cv::Mat m_encoding_frame; // frame the worker is compressing
+    int m_pending_frame_sequence_num;
+    int m_pending_frame_width, m_pending_frame_height;
+    int m_pending_downscale;
+    int m_pending_jpeg_quality;
+    TrackerNetworkVideoFramePtr m_latest_frame;
+    bool m_has_pending_frame;
+    bool m_is_encoding;
+    bool m_stop_requested;
+};
+
 // -- Utility Methods -----
 static glm::quat computeGLMCameraTransformQuaternion(const ITrackerInterface *tracker_device);
 static glm::mat4 computeGLMCameraTransformMatrix(const ITrackerInterface *tracker_device);
@@ -541,27 +1138,48 @@ static void angleAxisVectorToCommonDeviceOrientation(
     const float axis_x, const float axis_y, const float axis_z, const float radians,
     CommonDeviceQuaternion &orientation);
 
+static void refresh_tracker_poll_interval()
+{
+    DeviceManager *device_manager= DeviceManager::getInstance();
+
+    if (device_manager != nullptr)
+    {
+        device_manager->m_tracker_manager->update_poll_interval();
+    }
+}
+
 //-- public implementation -----
 ServerTrackerView::ServerTrackerView(const int device_id)
     : ServerDeviceView(device_id)
     , m_shared_memory_accesor(nullptr)
     , m_shared_memory_video_stream_count(0)
+    , m_network_video_encoder(nullptr)
+    , m_network_video_stream_count(0)
+    , m_network_video_max_rate_hz(k_default_network_video_max_rate_hz)
+    , m_network_video_downscale(k_default_network_video_downscale)
+    , m_network_video_jpeg_quality(k_default_network_video_jpeg_quality)
+    , m_last_network_video_submit_time()
+    , m_frame_pool(nullptr)
     , m_opencv_buffer_state(nullptr)
     , m_device(nullptr)
+    , m_last_frame_sequence_number(-1)
+    , m_last_frame_capture_timestamp()
+    , m_mean_frame_interval(0.f)
+    , m_color_mask_preview_color(eCommonTrackingColorID::INVALID_COLOR)
+    , m_color_mask_preview_controller_id(-1)
 {
+    m_frame_statistics.clear();
+    m_color_mask_preview.clear();
     ServerUtility::format_string(m_shared_memory_name, sizeof(m_shared_memory_name), "tracker_view_%d", device_id);
 }
 
 ServerTrackerView::~ServerTrackerView()
 {
-    if (m_shared_memory_accesor != nullptr)
-    {
-        delete m_shared_memory_accesor;
-    }
+    free_video_buffers();
 
-    if (m_opencv_buffer_state != nullptr)
+    if (m_network_video_encoder != nullptr)
     {
-        delete m_opencv_buffer_state;
+        delete m_network_video_encoder;
     }
 
     if (m_device != nullptr)
@@ -588,58 +1206,171 @@ ServerTrackerView::getUSBDevicePath() const
     return m_device->getUSBDevicePath();
 }
 
+std::chrono::time_point<std::chrono::high_resolution_clock>
+ServerTrackerView::getLastFrameCaptureTimestamp() const
+{
+    return m_device->getFrameCaptureTimestamp();
+}
+
+int
+ServerTrackerView::getFrameSequenceNumber() const
+{
+    return m_device->getFrameSequenceNumber();
+}
+
+int
+ServerTrackerView::getDroppedFrameCount() const
+{
+    return m_device->getDroppedFrameCount();
+}
+
 std::string 
 ServerTrackerView::getSharedMemoryStreamName() const
 {
     return std::string(m_shared_memory_name);
 }
 
+// Can be called off of the main thread (see TrackerManager::can_open_devices_in_background()).
+// The tracker manager adjusts its poll interval for the new tracker once the open is handed back.
 bool ServerTrackerView::open(const class DeviceEnumerator *enumerator)
 {
+    const std::chrono::time_point<std::chrono::high_resolution_clock> open_start = std::chrono::high_resolution_clock::now();
     bool bSuccess = ServerDeviceView::open(enumerator);
+    const std::chrono::time_point<std::chrono::high_resolution_clock> device_opened = std::chrono::high_resolution_clock::now();
+
+    // Remote trackers never see video frames, so there is nothing to stream or filter
+    if (bSuccess && getTrackerDeviceType() != CommonDeviceState::RemoteTracker)
+    {
+        allocate_video_buffers();
+
+        const std::chrono::duration<double, std::milli> device_open_time = device_opened - open_start;
+        const std::chrono::duration<double, std::milli> buffer_warmup_time = 
+            std::chrono::high_resolution_clock::now() - device_opened;
+
+        SERVER_LOG_INFO("ServerTrackerView::open") << "Tracker " << getDeviceID()
+            << " device open took " << device_open_time.count() << "ms, video buffer and color table warm-up took "
+            << buffer_warmup_time.count() << "ms";
+    }
 
     if (bSuccess)
     {
-        int width, height, stride;
+        m_frame_statistics.clear();
+        m_last_frame_sequence_number= -1;
+        m_mean_frame_interval= 0.f;
+    }
+
+    return bSuccess;
+}
+
+// (Re)allocates the shared memory video stream, the video frame pool and the OpenCV scratch buffers 
+// to fit the current video frame dimensions
+bool ServerTrackerView::allocate_video_buffers()
+{
+    int width, height, stride;
+    bool bSuccess= false;
+
+    // Hang on to the shared memory while the rest gets re-allocated.
+    // Its published frame comes from the frame pool, so let go of that first.
+    SharedVideoFrameReadWriteAccessor *shared_memory_accesor= m_shared_memory_accesor;
+    m_shared_memory_accesor= nullptr;
+    if (shared_memory_accesor != nullptr)
+    {
+        shared_memory_accesor->releasePublishedVideoFrame();
+    }
+
+    free_video_buffers();
+
+    // Query the video frame first so that we know how big to make the buffer
+    if (m_device->getVideoFrameDimensions(&width, &height, &stride))
+    {
+        // Video stream clients keep their mapping when the new frames fit in the existing shared memory
+        if (shared_memory_accesor != nullptr && !shared_memory_accesor->resize(width, height, stride))
+        {
+            SERVER_LOG_WARNING("ServerTrackerView::allocate_video_buffers()") << "Re-creating shared memory "
+                << m_shared_memory_name << " for " << width << "x" << height << " frames, video stream clients need to restart their stream";
 
-        // Make sure the shared memory block has been removed first
-        boost::interprocess::shared_memory_object::remove(m_shared_memory_name);
+            delete shared_memory_accesor;
+            shared_memory_accesor = nullptr;
+        }
 
-        // Query the video frame first so that we know how big to make the buffer
-        if (m_device->getVideoFrameDimensions(&width, &height, &stride))
+        if (shared_memory_accesor == nullptr)
         {
-            assert(m_shared_memory_accesor == nullptr);
-            m_shared_memory_accesor = new SharedVideoFrameReadWriteAccessor();
+            shared_memory_accesor = new SharedVideoFrameReadWriteAccessor();
 
-            if (!m_shared_memory_accesor->initialize(m_shared_memory_name, width, height, stride))
+            if (!shared_memory_accesor->initialize(m_shared_memory_name, width, height, stride, k_video_frame_pool_size))
             {
-                delete m_shared_memory_accesor;
-                m_shared_memory_accesor = nullptr;
+                delete shared_memory_accesor;
+                shared_memory_accesor = nullptr;
 
                 SERVER_LOG_ERROR("ServerTrackerView::open()") << "Failed to allocated shared memory: " << m_shared_memory_name;
             }
-
-            // Allocate the OpenCV scratch buffers used for finding tracking blobs
-            m_opencv_buffer_state = new OpenCVBufferState(width, height);
         }
-        else
+
+        m_shared_memory_accesor = shared_memory_accesor;
+
+        // Video frames are captured straight into the shared memory slots when we have them,
+        // otherwise into a pool on the heap (and copied to shared memory when streaming)
+        m_frame_pool = new VideoFramePool(
+            k_video_frame_pool_size,
+            SharedVideoFrameHeader::computeVideoBufferSize(stride, height),
+            (m_shared_memory_accesor != nullptr) ? m_shared_memory_accesor->getSlotMemory() : nullptr);
+
+        // Allocate the OpenCV scratch buffers used for finding tracking blobs
+        m_opencv_buffer_state = new OpenCVBufferState(width, height);
+        bSuccess= true;
+    }
+    else
+    {
+        SERVER_LOG_ERROR("ServerTrackerView::open()") << "Failed to video frame dimensions";
+
+        if (shared_memory_accesor != nullptr)
         {
-            SERVER_LOG_ERROR("ServerTrackerView::open()") << "Failed to video frame dimensions";
+            delete shared_memory_accesor;
         }
     }
 
     return bSuccess;
 }
 
-void ServerTrackerView::close()
+// Frees the video buffers in reverse order of use.
+// Everything holding a pooled video frame has to go before the pool does.
+void ServerTrackerView::free_video_buffers()
 {
+    if (m_device != nullptr)
+    {
+        m_device->setVideoFrameTargetBuffer(nullptr);
+    }
+
     if (m_shared_memory_accesor != nullptr)
     {
         delete m_shared_memory_accesor;
         m_shared_memory_accesor = nullptr;
     }
 
+    if (m_opencv_buffer_state != nullptr)
+    {
+        delete m_opencv_buffer_state;
+        m_opencv_buffer_state = nullptr;
+    }
+
+    // The preview mask lived in the OpenCV buffers
+    m_color_mask_preview.clear();
+
+    if (m_frame_pool != nullptr)
+    {
+        delete m_frame_pool;
+        m_frame_pool = nullptr;
+    }
+}
+
+void ServerTrackerView::close()
+{
+    free_video_buffers();
+
     ServerDeviceView::close();
+
+    // The remaining trackers may not need polling as often
+    refresh_tracker_poll_interval();
 }
 
 void ServerTrackerView::startSharedMemoryVideoStream()
@@ -651,27 +1382,129 @@ void ServerTrackerView::stopSharedMemoryVideoStream()
 {
     assert(m_shared_memory_video_stream_count > 0);
     --m_shared_memory_video_stream_count;
+
+    // Let the last published frame go back into the pool
+    if (m_shared_memory_video_stream_count == 0 && m_shared_memory_accesor != nullptr)
+    {
+        m_shared_memory_accesor->releasePublishedVideoFrame();
+    }
+}
+
+void ServerTrackerView::startNetworkVideoStream()
+{
+    if (m_network_video_stream_count == 0)
+    {
+        assert(m_network_video_encoder == nullptr);
+        m_network_video_encoder = new NetworkVideoEncoder();
+    }
+
+    ++m_network_video_stream_count;
+}
+
+void ServerTrackerView::stopNetworkVideoStream()
+{
+    assert(m_network_video_stream_count > 0);
+    --m_network_video_stream_count;
+
+    // Stop the encoder thread once nobody is watching
+    if (m_network_video_stream_count == 0)
+    {
+        delete m_network_video_encoder;
+        m_network_video_encoder = nullptr;
+    }
+}
+
+void ServerTrackerView::takeStreamStateFrom(ServerTrackerView *closed_view)
+{
+    assert(m_shared_memory_video_stream_count == 0 && m_network_video_stream_count == 0);
+
+    m_shared_memory_video_stream_count = closed_view->m_shared_memory_video_stream_count;
+    closed_view->m_shared_memory_video_stream_count = 0;
+
+    m_network_video_stream_count = closed_view->m_network_video_stream_count;
+    closed_view->m_network_video_stream_count = 0;
+    std::swap(m_network_video_encoder, closed_view->m_network_video_encoder);
+
+    m_network_video_max_rate_hz = closed_view->m_network_video_max_rate_hz;
+    m_network_video_downscale = closed_view->m_network_video_downscale;
+    m_network_video_jpeg_quality = closed_view->m_network_video_jpeg_quality;
+}
+
+void ServerTrackerView::setNetworkVideoStreamSettings(float max_rate_hz, int downscale, int jpeg_quality)
+{
+    m_network_video_max_rate_hz = 
+        (max_rate_hz > 0.f) ? max_rate_hz : k_default_network_video_max_rate_hz;
+    m_network_video_downscale = 
+        (downscale > 0) ? std::min(downscale, k_max_network_video_downscale) : k_default_network_video_downscale;
+    m_network_video_jpeg_quality = 
+        (jpeg_quality > 0) ? std::min(jpeg_quality, 100) : k_default_network_video_jpeg_quality;
+}
+
+TrackerNetworkVideoFramePtr ServerTrackerView::getLatestNetworkVideoFrame() const
+{
+    return (m_network_video_encoder != nullptr) ? m_network_video_encoder->getLatestVideoFrame() : TrackerNetworkVideoFramePtr();
 }
 
 bool ServerTrackerView::poll()
 {
+    // Have the camera write the next video frame straight into a free pooled frame
+    VideoFrameRef capture_frame;
+    if (m_frame_pool != nullptr && m_device != nullptr)
+    {
+        capture_frame = m_frame_pool->acquire();
+        m_device->setVideoFrameTargetBuffer(capture_frame.getBuffer());
+    }
+
     bool bSuccess = ServerDeviceView::poll();
 
-    if (bSuccess && m_device != nullptr)
+    // Only filter each video frame once 
+    // (the pooled frames are flipped in place)
+    if (bSuccess && m_device != nullptr && update_frame_statistics())
     {
         const unsigned char *buffer = m_device->getVideoFrameBuffer();
 
         if (buffer != nullptr)
         {
-            // Cache the raw video frame and convert it to an HSV buffer for filtering later
+            // Convert the raw video frame to an HSV buffer for filtering later
             if (m_opencv_buffer_state != nullptr)
             {
-                m_opencv_buffer_state->writeVideoFrame(buffer);
+                const bool bWantsVideoStream= 
+                    m_shared_memory_accesor != nullptr && m_shared_memory_video_stream_count > 0;
 
-                // Copy the video frame to shared memory (if requested)
-                if (m_shared_memory_accesor != nullptr && m_shared_memory_video_stream_count > 0)
+                if (capture_frame.isValid() && buffer == capture_frame.getBuffer())
                 {
-                    m_shared_memory_accesor->writeVideoFrame(m_opencv_buffer_state->bgrBuffer->data);
+                    m_opencv_buffer_state->setVideoFrame(capture_frame);
+
+                    // The pooled frame already lives in shared memory so just point the readers at it
+                    if (bWantsVideoStream)
+                    {
+                        m_shared_memory_accesor->publishVideoFrame(capture_frame);
+                    }
+                }
+                else
+                {
+                    // The camera couldn't use the pooled frame (no free frame or a size mismatch)
+                    m_opencv_buffer_state->writeVideoFrame(buffer);
+
+                    // Copy the video frame to shared memory (if requested)
+                    if (bWantsVideoStream)
+                    {
+                        VideoFrameRef stream_frame = m_frame_pool->acquire();
+
+                        if (stream_frame.isValid())
+                        {
+                            std::memcpy(
+                                stream_frame.getBuffer(), 
+                                m_opencv_buffer_state->bgrBuffer->data, 
+                                m_frame_pool->getFrameSize());
+                            m_shared_memory_accesor->publishVideoFrame(stream_frame);
+                        }
+                    }
+                }
+
+                if (m_network_video_encoder != nullptr)
+                {
+                    update_network_video_stream();
                 }
             }
         }
@@ -680,6 +1513,79 @@ bool ServerTrackerView::poll()
     return bSuccess;
 }
 
+// Hands the latest video frame to the network video encoder when it's time for the next one
+// and the encoder has finished with the last one
+void ServerTrackerView::update_network_video_stream()
+{
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<float> time_since_submit = now - m_last_network_video_submit_time;
+
+    if (time_since_submit.count() >= 1.f / m_network_video_max_rate_hz && !m_network_video_encoder->getIsBusy())
+    {
+        m_network_video_encoder->submitVideoFrame(
+            *m_opencv_buffer_state->bgrBuffer,
+            m_last_frame_sequence_number,
+            m_network_video_downscale,
+            m_network_video_jpeg_quality);
+        m_last_network_video_submit_time = now;
+    }
+}
+
+double ServerTrackerView::getFrameRate() const
+{
+    return m_device->getFrameRate();
+}
+
+// Exponential moving averages of the frame interval, the interval's deviation from the mean (jitter)
+// and the time from frame capture to the frame being processed.
+// Returns true if the device has a video frame we haven't seen yet.
+bool ServerTrackerView::update_frame_statistics()
+{
+    static const float k_frame_statistics_smoothing= 0.05f;
+
+    const int frame_sequence_number= m_device->getFrameSequenceNumber();
+
+    if (frame_sequence_number < 0 || frame_sequence_number == m_last_frame_sequence_number)
+    {
+        return false;
+    }
+
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+    const std::chrono::time_point<std::chrono::high_resolution_clock> capture_timestamp= m_device->getFrameCaptureTimestamp();
+    const std::chrono::duration<float, std::milli> latency_millis= now - capture_timestamp;
+
+    if (m_last_frame_sequence_number >= 0 && frame_sequence_number > m_last_frame_sequence_number)
+    {
+        // Spread the time across any dropped frames
+        const std::chrono::duration<float, std::milli> interval_millis= capture_timestamp - m_last_frame_capture_timestamp;
+        const float frame_interval= 
+            interval_millis.count() / static_cast<float>(frame_sequence_number - m_last_frame_sequence_number);
+
+        if (m_mean_frame_interval <= 0.f)
+        {
+            m_mean_frame_interval= frame_interval;
+            m_frame_statistics.frame_latency= latency_millis.count();
+        }
+        else
+        {
+            const float deviation= fabsf(frame_interval - m_mean_frame_interval);
+
+            m_mean_frame_interval+= k_frame_statistics_smoothing * (frame_interval - m_mean_frame_interval);
+            m_frame_statistics.frame_interval_jitter+= 
+                k_frame_statistics_smoothing * (deviation - m_frame_statistics.frame_interval_jitter);
+            m_frame_statistics.frame_latency+= 
+                k_frame_statistics_smoothing * (latency_millis.count() - m_frame_statistics.frame_latency);
+        }
+
+        m_frame_statistics.frame_rate= (m_mean_frame_interval > 0.f) ? 1000.f / m_mean_frame_interval : 0.f;
+    }
+
+    m_last_frame_sequence_number= frame_sequence_number;
+    m_last_frame_capture_timestamp= capture_timestamp;
+
+    return true;
+}
+
 bool ServerTrackerView::allocate_device_interface(const class DeviceEnumerator *enumerator)
 {
     switch (enumerator->get_device_type())
@@ -688,6 +1594,10 @@ bool ServerTrackerView::allocate_device_interface(const class DeviceEnumerator *
     {
         m_device = new PS3EyeTracker();
     } break;
+    case CommonDeviceState::RemoteTracker:
+    {
+        m_device = new RemoteTracker();
+    } break;
     default:
         break;
     }
@@ -713,6 +1623,13 @@ void ServerTrackerView::publish_device_data_frame()
     // This will call generate_tracker_data_frame_for_stream for each listening connection.
     ServerRequestHandler::get_instance()->publish_tracker_data_frame(
         this, &ServerTrackerView::generate_tracker_data_frame_for_stream);
+
+    // When running as a tracker node, forward the blobs seen this frame on to the central service
+    if (TrackerNodePublisher::get_instance() != nullptr && 
+        getTrackerDeviceType() != CommonDeviceState::RemoteTracker)
+    {
+        TrackerNodePublisher::get_instance()->publish_tracker_observations(this, m_sequence_number);
+    }
 }
 
 void ServerTrackerView::generate_tracker_data_frame_for_stream(
@@ -726,13 +1643,21 @@ void ServerTrackerView::generate_tracker_data_frame_for_stream(
     tracker_data_frame->set_tracker_id(tracker_view->getDeviceID());
     tracker_data_frame->set_sequence_num(tracker_view->m_sequence_number);
     tracker_data_frame->set_isconnected(tracker_view->getIsOpen());
+    tracker_data_frame->set_publish_timestamp_usec(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
 
     switch (tracker_view->getTrackerDeviceType())
     {
     case CommonDeviceState::PS3EYE:
         {
+            tracker_data_frame->set_tracker_type(PSMoveProtocol::PS3EYE);
             //TODO: PS3EYE tracker location
         } break;
+    case CommonDeviceState::RemoteTracker:
+        {
+            tracker_data_frame->set_tracker_type(PSMoveProtocol::REMOTE_TRACKER);
+        } break;
     //case CommonDeviceState::RiftDK2Sensor:
     //    {
     //        //TODO: RiftDK2Sensor tracker location
@@ -818,7 +1743,44 @@ void ServerTrackerView::gatherTrackerOptions(PSMoveProtocol::Response_ResultTrac
 
 bool ServerTrackerView::setOptionIndex(const std::string &option_name, int option_index)
 {
-    return m_device->setOptionIndex(option_name, option_index);
+    int old_width= 0, old_height= 0;
+    m_device->getVideoFrameDimensions(&old_width, &old_height, nullptr);
+    const double old_frame_rate= m_device->getFrameRate();
+
+    const bool bSuccess= m_device->setOptionIndex(option_name, option_index);
+
+    if (bSuccess)
+    {
+        int new_width= 0, new_height= 0;
+        m_device->getVideoFrameDimensions(&new_width, &new_height, nullptr);
+        const double new_frame_rate= m_device->getFrameRate();
+
+        // Switching video modes changes the frame size and/or rate
+        if (new_width != old_width || new_height != old_height || new_frame_rate != old_frame_rate)
+        {
+            SERVER_LOG_INFO("ServerTrackerView::setOptionIndex") << "Tracker " << getDeviceID()
+                << " video mode " << old_width << "x" << old_height << " @ " << old_frame_rate << "Hz"
+                << " (measured " << m_frame_statistics.frame_rate << "fps, "
+                << m_frame_statistics.frame_interval_jitter << "ms jitter, "
+                << m_frame_statistics.frame_latency << "ms latency)"
+                << " -> " << new_width << "x" << new_height << " @ " << new_frame_rate << "Hz";
+
+            if ((new_width != old_width || new_height != old_height) &&
+                getTrackerDeviceType() != CommonDeviceState::RemoteTracker)
+            {
+                // Video stream clients pick up the new frame size from the shared memory header
+                allocate_video_buffers();
+            }
+
+            m_frame_statistics.clear();
+            m_last_frame_sequence_number= -1;
+            m_mean_frame_interval= 0.f;
+
+            refresh_tracker_poll_interval();
+        }
+    }
+
+    return bSuccess;
 }
 
 bool ServerTrackerView::getOptionIndex(const std::string &option_name, int &out_option_index) const
@@ -855,6 +1817,104 @@ void ServerTrackerView::getTrackingColorPreset(
     return m_device->getTrackingColorPreset(controller_id, color, out_preset);
 }
 
+const TrackerColorMaskPreview *
+ServerTrackerView::computeColorMaskPreview(
+    const ServerControllerView *controller,
+    eCommonTrackingColorID color,
+    int downscale)
+{
+    if (m_opencv_buffer_state == nullptr || m_last_frame_sequence_number < 0)
+    {
+        return nullptr;
+    }
+
+    const int controller_id = (controller != nullptr) ? controller->getDeviceID() : -1;
+
+    // Every stream asking for the same mask this frame shares it
+    if (m_color_mask_preview.frame_sequence_num == m_last_frame_sequence_number &&
+        m_color_mask_preview.downscale == downscale &&
+        m_color_mask_preview_color == color &&
+        m_color_mask_preview_controller_id == controller_id)
+    {
+        return &m_color_mask_preview;
+    }
+
+    CommonHSVColorRange hsvColorRange;
+    getTrackingColorPreset(controller, color, &hsvColorRange);
+
+    m_opencv_buffer_state->computePreviewMask(hsvColorRange, downscale);
+
+    const cv::Mat &mask = m_opencv_buffer_state->previewMaskBuffer;
+    const BlobLabeler &labeler = m_opencv_buffer_state->previewBlobLabeler;
+    const int largest_blob_index = labeler.findLargestBlob();
+    const float scale = static_cast<float>(downscale);
+    const int pixel_area = downscale*downscale;
+
+    m_color_mask_preview.clear();
+    m_color_mask_preview.frame_sequence_num = m_last_frame_sequence_number;
+    m_color_mask_preview.width = mask.cols;
+    m_color_mask_preview.height = mask.rows;
+    m_color_mask_preview.stride = static_cast<int>(mask.step);
+    m_color_mask_preview.downscale = downscale;
+    m_color_mask_preview.mask = mask.data;
+    m_color_mask_preview.blob_count = labeler.getBlobCount();
+    m_color_mask_preview.masked_pixel_count = cv::countNonZero(mask) * pixel_area;
+
+    if (largest_blob_index >= 0)
+    {
+        const BlobInfo &blob = labeler.getBlob(largest_blob_index);
+
+        // Mask pixel centers mapped back into video frame pixels
+        m_color_mask_preview.largest_blob_area = blob.area * pixel_area;
+        m_color_mask_preview.largest_blob_center_x = (blob.getCentroidX() + 0.5f) * scale;
+        m_color_mask_preview.largest_blob_center_y = (blob.getCentroidY() + 0.5f) * scale;
+        m_color_mask_preview.largest_blob_min_x = static_cast<float>(blob.min_x) * scale;
+        m_color_mask_preview.largest_blob_min_y = static_cast<float>(blob.min_y) * scale;
+        m_color_mask_preview.largest_blob_max_x = static_cast<float>(blob.max_x + 1) * scale;
+        m_color_mask_preview.largest_blob_max_y = static_cast<float>(blob.max_y + 1) * scale;
+    }
+
+    m_color_mask_preview_color = color;
+    m_color_mask_preview_controller_id = controller_id;
+
+    return &m_color_mask_preview;
+}
+
+int
+ServerTrackerView::generateColorMaskPreviewDataFrame(
+    const TrackerColorMaskPreview *preview,
+    int start_row,
+    DeviceOutputDataFramePtr &data_frame)
+{
+    PSMoveProtocol::DeviceOutputDataFrame_TrackerDataPacket_ColorMaskPreview *mask_packet =
+        data_frame->mutable_tracker_data_packet()->mutable_color_mask_preview();
+
+    const int row_count = 
+        ColorMaskRunLength::encodeRows(
+            preview->mask, preview->width, preview->height, preview->stride,
+            start_row, preview->height, k_color_mask_preview_max_run_bytes,
+            *mask_packet->mutable_row_runs());
+
+    mask_packet->set_frame_sequence_num(preview->frame_sequence_num);
+    mask_packet->set_mask_width(preview->width);
+    mask_packet->set_mask_height(preview->height);
+    mask_packet->set_downscale(preview->downscale);
+    mask_packet->set_start_row(start_row);
+    mask_packet->set_row_count(row_count);
+
+    mask_packet->set_blob_count(preview->blob_count);
+    mask_packet->set_masked_pixel_count(preview->masked_pixel_count);
+    mask_packet->set_largest_blob_area(preview->largest_blob_area);
+    mask_packet->mutable_largest_blob_center()->set_x(preview->largest_blob_center_x);
+    mask_packet->mutable_largest_blob_center()->set_y(preview->largest_blob_center_y);
+    mask_packet->mutable_largest_blob_min()->set_x(preview->largest_blob_min_x);
+    mask_packet->mutable_largest_blob_min()->set_y(preview->largest_blob_min_y);
+    mask_packet->mutable_largest_blob_max()->set_x(preview->largest_blob_max_x);
+    mask_packet->mutable_largest_blob_max()->set_y(preview->largest_blob_max_y);
+
+    return start_row + row_count;
+}
+
 bool
 ServerTrackerView::computePoseForController(
     const ServerControllerView* tracked_controller,
@@ -870,33 +1930,55 @@ ServerTrackerView::computePoseForController(
         bSuccess = tracked_controller->getTrackingShape(tracking_shape);
     }
 
-    // Get the HSV filter used to find the tracking blob
-    CommonHSVColorRange hsvColorRange;
+    // Get the color of the tracking blob
+    eCommonTrackingColorID tracked_color_id = eCommonTrackingColorID::INVALID_COLOR;
     if (bSuccess)
     {
-        eCommonTrackingColorID tracked_color_id = tracked_controller->getTrackingColorID();
+        tracked_color_id = tracked_controller->getTrackingColorID();
+        bSuccess = (tracked_color_id != eCommonTrackingColorID::INVALID_COLOR);
+    }
 
-        if (tracked_color_id != eCommonTrackingColorID::INVALID_COLOR)
+    if (bSuccess)
+    {
+        if (getTrackerDeviceType() == CommonDeviceState::RemoteTracker)
         {
-            getTrackingColorPreset(tracked_controller, tracked_color_id, &hsvColorRange);
+            // The tracker node already ran the blob tracking for us
+            bSuccess = computePoseFromRemoteObservation(&tracking_shape, tracked_color_id, out_pose_estimate);
         }
         else
         {
-            bSuccess = false;
+            // Get the HSV filter used to find the tracking blob
+            CommonHSVColorRange hsvColorRange;
+            getTrackingColorPreset(tracked_controller, tracked_color_id, &hsvColorRange);
+
+            bSuccess = computePoseForTrackingShape(&tracking_shape, &hsvColorRange, tracker_pose_guess, out_pose_estimate);
         }
     }
 
+    return bSuccess;
+}
+
+bool
+ServerTrackerView::computePoseForTrackingShape(
+    const CommonDeviceTrackingShape *tracking_shape_ptr,
+    const CommonHSVColorRange *hsv_color_range,
+    const CommonDevicePose *tracker_pose_guess,
+    ControllerOpticalPoseEstimation *out_pose_estimate)
+{
+    const CommonDeviceTrackingShape &tracking_shape = *tracking_shape_ptr;
+    bool bSuccess = (m_opencv_buffer_state != nullptr);
+
     // Find the contour associated with the controller
-    std::vector<cv::Point> biggest_contour;
     if (bSuccess)
     {
         ///###HipsterSloth $TODO - ROI seed on last known position, clamp to frame edges. 
-        bSuccess = m_opencv_buffer_state->computeBiggestContour(hsvColorRange, biggest_contour);
+        bSuccess = m_opencv_buffer_state->computeBiggestContour(*hsv_color_range);
     }
 
     // Compute the tracker relative 3d position of the controller from the contour
     if (bSuccess)
     {
+        const std::vector<cv::Point> &biggest_contour = m_opencv_buffer_state->biggestContour;
         float F_PX, F_PY;
         float PrincipalX, PrincipalY;
         m_device->getCameraIntrinsics(F_PX, F_PY, PrincipalX, PrincipalY);
@@ -912,7 +1994,7 @@ ServerTrackerView::computePoseForController(
                 getPixelDimensions(frameWidth, frameHeight);
 
                 // Compute the convex hull of the contour
-                std::vector<cv::Point> convex_contour;
+                std::vector<cv::Point> &convex_contour = m_opencv_buffer_state->convexContour;
                 cv::convexHull(biggest_contour, convex_contour);
 
                 // Convert opencv_contour in raw pixel space:
@@ -921,7 +2003,8 @@ ServerTrackerView::computePoseForController(
                 // i.e. [-frameWidth/2, -frameHeight/2]x[frameWidth/2, frameHeight/2]   
                 // TODO: Replace this with cv::undistortPoints
                 //http://docs.opencv.org/3.1.0/da/d54/group__imgproc__transform.html#ga55c716492470bfe86b0ee9bf3a1f0f7e&gsc.tab=0
-                std::vector<Eigen::Vector2f> eigen_contour;
+                std::vector<Eigen::Vector2f> &eigen_contour = m_opencv_buffer_state->eigenContour;
+                eigen_contour.clear();
                 std::for_each(
                     convex_contour.begin(),
                     convex_contour.end(),
@@ -976,6 +2059,45 @@ ServerTrackerView::computePoseForController(
     return bSuccess;
 }
 
+bool
+ServerTrackerView::computePoseFromRemoteObservation(
+    const CommonDeviceTrackingShape *tracking_shape,
+    eCommonTrackingColorID tracked_color_id,
+    ControllerOpticalPoseEstimation *out_pose_estimate) const
+{
+    const RemoteTracker *remote_tracker = castCheckedConst<RemoteTracker>();
+    const RemoteTrackerObservation *observation = remote_tracker->findObservation(tracked_color_id);
+    bool bSuccess = false;
+
+    if (observation != nullptr)
+    {
+        // Make sure the node fit the same kind of shape the controller uses
+        switch (tracking_shape->shape_type)
+        {
+        case eCommonTrackingShapeType::Sphere:
+            bSuccess = observation->projection.shape_type == eCommonTrackingProjectionType::ProjectionType_Ellipse;
+            break;
+        case eCommonTrackingShapeType::LightBar:
+            bSuccess = observation->projection.shape_type == eCommonTrackingProjectionType::ProjectionType_LightBar;
+            break;
+        default:
+            assert(0 && "Unreachable");
+            break;
+        }
+    }
+
+    if (bSuccess)
+    {
+        out_pose_estimate->position = observation->position;
+        out_pose_estimate->orientation = observation->orientation;
+        out_pose_estimate->bOrientationValid = observation->bOrientationValid;
+        out_pose_estimate->projection = observation->projection;
+        out_pose_estimate->bCurrentlyTracking = true;
+    }
+
+    return bSuccess;
+}
+
 CommonDevicePosition
 ServerTrackerView::computeWorldPosition(
     const CommonDevicePosition *tracker_relative_position)
@@ -990,6 +2112,20 @@ ServerTrackerView::computeWorldPosition(
     return result;
 }
 
+CommonDevicePosition
+ServerTrackerView::computeTrackerRelativePosition(
+    const CommonDevicePosition *world_position)
+{
+    const glm::vec4 world_pos(world_position->x, world_position->y, world_position->z, 1.f);
+    const glm::mat4 invCameraTransform= glm::inverse(computeGLMCameraTransformMatrix(m_device));
+    const glm::vec4 rel_pos = invCameraTransform * world_pos;
+    
+    CommonDevicePosition result;
+    result.set(rel_pos.x, rel_pos.y, rel_pos.z);
+
+    return result;
+}
+
 CommonDeviceQuaternion
 ServerTrackerView::computeWorldOrientation(
     const CommonDeviceQuaternion *tracker_relative_orientation)
@@ -1055,23 +2191,27 @@ ServerTrackerView::triangulateWorldPosition(
     float otherScreenWidth, otherScreenHeight;
     tracker->getPixelDimensions(otherScreenWidth, otherScreenHeight);
 
-    cv::Mat projPoints1 = 
-        cv::Mat(cv::Point2f(
-            screen_location->x + (screenWidth / 2), 
-            screen_location->y + (screenHeight / 2)));
-    cv::Mat projPoints2 = 
-        cv::Mat(cv::Point2f(
-            other_screen_location->x + (otherScreenWidth / 2),
-            other_screen_location->y + (otherScreenHeight / 2)));
+    // The matrices below are headers over stack memory so triangulating doesn't hit the heap
+    float projPointData1[2] = {
+        screen_location->x + (screenWidth / 2),
+        screen_location->y + (screenHeight / 2) };
+    float projPointData2[2] = {
+        other_screen_location->x + (otherScreenWidth / 2),
+        other_screen_location->y + (otherScreenHeight / 2) };
+    cv::Mat projPoints1(2, 1, CV_32F, projPointData1);
+    cv::Mat projPoints2(2, 1, CV_32F, projPointData2);
 
     // Compute the pinhole camera matrix for each tracker that allows you to raycast
     // from the tracker center in world space through the screen location, into the world
     // See: http://docs.opencv.org/2.4/modules/calib3d/doc/camera_calibration_and_3d_reconstruction.html
-    cv::Mat projMat1 = cv::Mat(computeOpenCVCameraPinholeMatrix(tracker->m_device));
-    cv::Mat projMat2 = cv::Mat(computeOpenCVCameraPinholeMatrix(other_tracker->m_device));
+    cv::Matx34f pinholeMatrix1 = computeOpenCVCameraPinholeMatrix(tracker->m_device);
+    cv::Matx34f pinholeMatrix2 = computeOpenCVCameraPinholeMatrix(other_tracker->m_device);
+    cv::Mat projMat1(3, 4, CV_32F, pinholeMatrix1.val);
+    cv::Mat projMat2(3, 4, CV_32F, pinholeMatrix2.val);
 
     // Triangulate the world position from the two cameras
-    cv::Mat point3D(1, 1, CV_32FC4);
+    float point3DData[4] = { 0.f, 0.f, 0.f, 1.f };
+    cv::Mat point3D(4, 1, CV_32F, point3DData);
     cv::triangulatePoints(projMat1, projMat2, projPoints1, projPoints2, point3D);
 
     // Return the world space position
@@ -1089,31 +2229,32 @@ ServerTrackerView::projectTrackerRelativePosition(const CommonDevicePosition *tr
 {
     CommonDeviceScreenLocation screenLocation;
 
+    // This runs for every controller every tick, so all the matrices below are
+    // headers over stack memory rather than heap allocated
     // Assume no distortion
     // TODO: Probably should get the distortion coefficients out of the tracker
-    cv::Mat cvDistCoeffs(4, 1, cv::DataType<float>::type);
-    cvDistCoeffs.at<float>(0) = 0;
-    cvDistCoeffs.at<float>(1) = 0;
-    cvDistCoeffs.at<float>(2) = 0;
-    cvDistCoeffs.at<float>(3) = 0;
+    float distCoeffsData[4] = { 0.f, 0.f, 0.f, 0.f };
+    cv::Mat cvDistCoeffs(4, 1, cv::DataType<float>::type, distCoeffsData);
 
     // Use the identity transform for tracker relative positions
-    cv::Mat rvec(3, 1, cv::DataType<double>::type, double(0));
-    cv::Mat tvec(3, 1, cv::DataType<double>::type, double(0));
+    double rvecData[3] = { 0.0, 0.0, 0.0 };
+    double tvecData[3] = { 0.0, 0.0, 0.0 };
+    cv::Mat rvec(3, 1, cv::DataType<double>::type, rvecData);
+    cv::Mat tvec(3, 1, cv::DataType<double>::type, tvecData);
 
     // Only one point to project
-    std::vector<cv::Point3f> cvObjectPoints;
-    cvObjectPoints.push_back(
-        cv::Point3f(
+    cv::Point3f objectPoint(
         trackerRelativePosition->x,
         trackerRelativePosition->y,
-        trackerRelativePosition->z));
+        trackerRelativePosition->z);
+    cv::Mat cvObjectPoints(1, 1, CV_32FC3, &objectPoint);
 
     // Compute the camera intrinsic matrix in opencv format
     cv::Matx33f cvCameraMatrix = computeOpenCVCameraIntrinsicMatrix(m_device);
 
     // Projected point 
-    std::vector<cv::Point2f> projectedPoints;
+    cv::Point2f projectedPoint;
+    cv::Mat projectedPoints(1, 1, CV_32FC2, &projectedPoint);
     cv::projectPoints(cvObjectPoints, rvec, tvec, cvCameraMatrix, cvDistCoeffs, projectedPoints);
 
     // cv::projectPoints() returns position in pixel coordinates where:
@@ -1124,8 +2265,8 @@ ServerTrackerView::projectTrackerRelativePosition(const CommonDevicePosition *tr
         float screenWidth, screenHeight;
         getPixelDimensions(screenWidth, screenHeight);
 
-        screenLocation.x = projectedPoints[0].x - (screenWidth / 2);
-        screenLocation.y = projectedPoints[0].y - (screenHeight / 2);
+        screenLocation.x = projectedPoint.x - (screenWidth / 2);
+        screenLocation.y = projectedPoint.y - (screenHeight / 2);
     }
 
     return screenLocation;
@@ -5,6 +5,9 @@
 #include "ServerDeviceView.h"
 #include "PSMoveProtocolInterface.h"
 
+#include <memory>
+#include <vector>
+
 // -- pre-declarations -----
 namespace PSMoveProtocol
 {
@@ -13,6 +16,62 @@ namespace PSMoveProtocol
 };
 
 // -- declarations -----
+// Frame timing measured by the tracker view since the tracker was opened or its video mode changed
+struct TrackerFrameStatistics
+{
+    float frame_rate; // frames per second
+    float frame_interval_jitter; // ms, mean deviation of the time between frames
+    float frame_latency; // ms, frame capture to the frame being processed
+
+    inline void clear()
+    {
+        frame_rate= 0.f;
+        frame_interval_jitter= 0.f;
+        frame_latency= 0.f;
+    }
+};
+
+// Color filter mask of the latest video frame, computed for color calibration previews
+struct TrackerColorMaskPreview
+{
+    int frame_sequence_num; // video frame the mask was computed from (-1 if none yet)
+    int width, height, stride; // mask pixels
+    int downscale; // video frame pixels per mask pixel
+    const unsigned char *mask; // non-zero where masked, owned by the tracker view
+
+    // Blob statistics in video frame pixels
+    int blob_count;
+    int masked_pixel_count;
+    int largest_blob_area;
+    float largest_blob_center_x, largest_blob_center_y;
+    float largest_blob_min_x, largest_blob_min_y;
+    float largest_blob_max_x, largest_blob_max_y;
+
+    inline void clear()
+    {
+        frame_sequence_num= -1;
+        width= height= stride= 0;
+        downscale= 1;
+        mask= nullptr;
+        blob_count= 0;
+        masked_pixel_count= 0;
+        largest_blob_area= 0;
+        largest_blob_center_x= largest_blob_center_y= 0.f;
+        largest_blob_min_x= largest_blob_min_y= 0.f;
+        largest_blob_max_x= largest_blob_max_y= 0.f;
+    }
+};
+
+// A JPEG compressed video frame for clients that can't open the shared memory video stream
+struct TrackerNetworkVideoFrame
+{
+    int frame_sequence_num; // video frame that was compressed
+    int frame_width, frame_height; // video frame pixels before downscaling
+    int downscale;
+    std::vector<unsigned char> jpeg_data;
+};
+typedef std::shared_ptr<const TrackerNetworkVideoFrame> TrackerNetworkVideoFramePtr;
+
 class ServerTrackerView : public ServerDeviceView
 {
 public:
@@ -27,9 +86,30 @@ public:
     void startSharedMemoryVideoStream();
     void stopSharedMemoryVideoStream();
 
+    // Starts or stops compressing video frames for network video streams.
+    // Ref counted like the shared memory stream. Frames are compressed on a worker thread.
+    void startNetworkVideoStream();
+    void stopNetworkVideoStream();
+
+    // Takes over the stream ref counts, network video encoder and settings of the closed view
+    // this one replaces in its slot, so the connections holding them can still release them
+    void takeStreamStateFrom(ServerTrackerView *closed_view);
+
+    // Compression settings shared by every network video stream of this tracker (0 = default)
+    void setNetworkVideoStreamSettings(float max_rate_hz, int downscale, int jpeg_quality);
+
+    // Returns the latest compressed video frame (nullptr if there isn't one yet)
+    TrackerNetworkVideoFramePtr getLatestNetworkVideoFrame() const;
+
     // Fetch the next video frame and copy to shared memory
     bool poll() override;
 
+    // Returns the rate the camera is delivering video frames at (0 if not known)
+    double getFrameRate() const;
+
+    // Frame rate, jitter and latency of the current video mode
+    inline const TrackerFrameStatistics &getFrameStatistics() const { return m_frame_statistics; }
+
     IDeviceInterface* getDevice() const override {return m_device;}
 
     // Returns what type of tracker this tracker view represents
@@ -43,6 +123,15 @@ public:
 
     // Returns the name of the shared memory block video frames are written to
     std::string getSharedMemoryStreamName() const;
+
+    // Returns when the latest video frame was captured by the camera
+    std::chrono::time_point<std::chrono::high_resolution_clock> getLastFrameCaptureTimestamp() const;
+
+    // Returns the sequence number of the latest video frame
+    int getFrameSequenceNumber() const;
+
+    // Returns the number of video frames dropped since the tracker was opened
+    int getDroppedFrameCount() const;
     
     double getExposure() const;
     void setExposure(double value);
@@ -55,9 +144,31 @@ public:
         const CommonDevicePose *tracker_pose_guess,
         struct ControllerOpticalPoseEstimation *out_pose_estimate);
 
+    /// Find the tracking blob with the given color in the latest video frame 
+    /// and compute its tracker relative pose (used directly by tracker nodes)
+    bool computePoseForTrackingShape(
+        const CommonDeviceTrackingShape *tracking_shape,
+        const CommonHSVColorRange *hsv_color_range,
+        const CommonDevicePose *tracker_pose_guess,
+        struct ControllerOpticalPoseEstimation *out_pose_estimate);
+
+    /// Filters the latest video frame with a tracking color preset for a mask preview stream.
+    /// The mask is reused until the next video frame or a call with different settings.
+    /// Returns nullptr if there is no video frame to filter.
+    const TrackerColorMaskPreview *computeColorMaskPreview(
+        const class ServerControllerView *controller,
+        eCommonTrackingColorID color,
+        int downscale);
+
+    /// Adds the mask rows starting at start_row that fit in one data frame to the frame's tracker packet.
+    /// Returns the row the next data frame should start at.
+    static int generateColorMaskPreviewDataFrame(
+        const TrackerColorMaskPreview *preview, int start_row, DeviceOutputDataFramePtr &data_frame);
+
     CommonDeviceScreenLocation projectTrackerRelativePosition(const CommonDevicePosition *trackerRelativePosition) const;
     
     CommonDevicePosition computeWorldPosition(const CommonDevicePosition *tracker_relative_position);
+    CommonDevicePosition computeTrackerRelativePosition(const CommonDevicePosition *world_position);
     CommonDeviceQuaternion computeWorldOrientation(const CommonDeviceQuaternion *tracker_relative_orientation);
 
     /// Given screen locations on two different trackers, compute the triangulated world space location
@@ -93,6 +204,16 @@ public:
     void getTrackingColorPreset(const class ServerControllerView *controller, eCommonTrackingColorID color, CommonHSVColorRange *out_preset) const;
 
 protected:
+    bool computePoseFromRemoteObservation(
+        const CommonDeviceTrackingShape *tracking_shape,
+        eCommonTrackingColorID tracked_color_id,
+        struct ControllerOpticalPoseEstimation *out_pose_estimate) const;
+
+    bool allocate_video_buffers();
+    void free_video_buffers();
+    bool update_frame_statistics();
+    void update_network_video_stream();
+
     bool allocate_device_interface(const class DeviceEnumerator *enumerator) override;
     void free_device_interface() override;
     void publish_device_data_frame() override;
@@ -104,8 +225,26 @@ private:
     char m_shared_memory_name[256];
     class SharedVideoFrameReadWriteAccessor *m_shared_memory_accesor;
     int m_shared_memory_video_stream_count;
+    class NetworkVideoEncoder *m_network_video_encoder;
+    int m_network_video_stream_count;
+    float m_network_video_max_rate_hz;
+    int m_network_video_downscale;
+    int m_network_video_jpeg_quality;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_last_network_video_submit_time;
+    class VideoFramePool *m_frame_pool;
     class OpenCVBufferState *m_opencv_buffer_state;
     ITrackerInterface *m_device;
+
+    // Frame timing state
+    TrackerFrameStatistics m_frame_statistics;
+    int m_last_frame_sequence_number;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_last_frame_capture_timestamp;
+    float m_mean_frame_interval; // ms
+
+    // Last mask computed for a color mask preview stream
+    TrackerColorMaskPreview m_color_mask_preview;
+    eCommonTrackingColorID m_color_mask_preview_color;
+    int m_color_mask_preview_controller_id;
 };
 
 #endif // SERVER_TRACKER_VIEW_H
@@ -0,0 +1,56 @@
+//-- includes -----
+#include "TrackerObservationSync.h"
+
+#include <algorithm>
+
+//-- public implementation -----
+int synchronize_observation_times(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &reference_timestamp,
+    const int tolerance_milliseconds,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> *capture_timestamps,
+    const int observation_count,
+    int *out_synchronized_indices,
+    float *out_extrapolation_seconds,
+    float &out_capture_skew_milliseconds)
+{
+    const bool bSyncEnabled= tolerance_milliseconds > 0;
+    int synchronized_count= 0;
+    float max_capture_age_milliseconds= 0.f;
+
+    for (int observation_index = 0; observation_index < observation_count; ++observation_index)
+    {
+        const std::chrono::duration<float, std::milli> captureAgeMillis= 
+            reference_timestamp - capture_timestamps[observation_index];
+
+        if (bSyncEnabled && captureAgeMillis.count() > static_cast<float>(tolerance_milliseconds))
+        {
+            // Too stale to line up with the other trackers
+            continue;
+        }
+
+        out_synchronized_indices[synchronized_count]= observation_index;
+        out_extrapolation_seconds[synchronized_count]= 
+            (bSyncEnabled && captureAgeMillis.count() > 0.f) ? captureAgeMillis.count() / 1000.f : 0.f;
+
+        max_capture_age_milliseconds= std::max(max_capture_age_milliseconds, captureAgeMillis.count());
+        ++synchronized_count;
+    }
+
+    out_capture_skew_milliseconds= max_capture_age_milliseconds;
+
+    return synchronized_count;
+}
+
+CommonDevicePosition extrapolate_observation_position(
+    const CommonDevicePosition &world_position,
+    const CommonDeviceVector &world_velocity,
+    const float seconds)
+{
+    CommonDevicePosition result;
+
+    result.x= world_position.x + world_velocity.i * seconds;
+    result.y= world_position.y + world_velocity.j * seconds;
+    result.z= world_position.z + world_velocity.k * seconds;
+
+    return result;
+}
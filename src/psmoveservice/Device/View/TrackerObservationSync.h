@@ -0,0 +1,34 @@
+#ifndef TRACKER_OBSERVATION_SYNC_H
+#define TRACKER_OBSERVATION_SYNC_H
+
+//-- includes -----
+#include "DeviceInterface.h"
+
+#include <chrono>
+
+//-- interface -----
+/// Soft synchronization of per-tracker observations (no camera genlock needed).
+/// Each camera exposes frames on its own clock, so one tracker's newest observation 
+/// can be up to a frame period older than another's. Observations captured more than 
+/// tolerance_milliseconds before the reference time are left out, and the rest get
+/// the time they have to be moved forward by to line up with the reference time.
+/// A tolerance of 0 disables synchronization (nothing is dropped or moved).
+/// Writes the indices of the kept observations (in order) to out_synchronized_indices,
+/// their extrapolation times to out_extrapolation_seconds and returns how many were kept.
+/// out_capture_skew_milliseconds is the age of the oldest kept observation.
+int synchronize_observation_times(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &reference_timestamp,
+    const int tolerance_milliseconds,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> *capture_timestamps,
+    const int observation_count,
+    int *out_synchronized_indices,
+    float *out_extrapolation_seconds,
+    float &out_capture_skew_milliseconds);
+
+/// Moves a world space position (cm) along a world space velocity (cm/s) for the given time
+CommonDevicePosition extrapolate_observation_position(
+    const CommonDevicePosition &world_position,
+    const CommonDeviceVector &world_velocity,
+    const float seconds);
+
+#endif // TRACKER_OBSERVATION_SYNC_H
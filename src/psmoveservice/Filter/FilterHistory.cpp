@@ -0,0 +1,106 @@
+//-- includes -----
+#include "FilterHistory.h"
+#include "OrientationFilter.h"
+#include "PositionFilter.h"
+
+//-- public implementation -----
+ControllerFilterHistory::ControllerFilterHistory()
+    : head(0)
+    , count(0)
+{
+    for (int entry_index = 0; entry_index < k_filter_history_size; ++entry_index)
+    {
+        FilterHistoryEntry &entry = entries[entry_index];
+
+        entry.sample_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+        entry.poll_sequence_number = -1;
+        entry.delta_time = 0.f;
+        entry.bOpticalApplied = false;
+        entry.orientation_filter_before = new OrientationFilter();
+        entry.position_filter_before = new PositionFilter();
+    }
+}
+
+ControllerFilterHistory::~ControllerFilterHistory()
+{
+    for (int entry_index = 0; entry_index < k_filter_history_size; ++entry_index)
+    {
+        delete entries[entry_index].orientation_filter_before;
+        delete entries[entry_index].position_filter_before;
+    }
+}
+
+FilterHistoryEntry &ControllerFilterHistory::push()
+{
+    if (count < k_filter_history_size)
+    {
+        ++count;
+    }
+    else
+    {
+        head = (head + 1) % k_filter_history_size;
+    }
+
+    FilterHistoryEntry &entry = at(count - 1);
+    entry.bOpticalApplied = false;
+
+    return entry;
+}
+
+int ControllerFilterHistory::findOpticalSampleIndex(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &capture_timestamp) const
+{
+    if (count == 0)
+    {
+        return -1;
+    }
+
+    // Find the first sample taken at or after the camera frame was captured.
+    // If the frame is newer than every sample, fuse it with the newest one.
+    int optical_index = count - 1;
+    for (int history_index = 0; history_index < count; ++history_index)
+    {
+        if (at(history_index).sample_timestamp >= capture_timestamp)
+        {
+            optical_index = history_index;
+            break;
+        }
+    }
+
+    // Never rewind past an optical measurement that has already been fused
+    for (int history_index = count - 1; history_index >= 0; --history_index)
+    {
+        if (at(history_index).bOpticalApplied)
+        {
+            if (optical_index <= history_index)
+            {
+                optical_index = history_index + 1;
+            }
+            break;
+        }
+    }
+
+    return optical_index;
+}
+
+void ControllerFilterHistory::saveFiltersBefore(
+    int index, 
+    const OrientationFilter *orientation_filter, 
+    const PositionFilter *position_filter)
+{
+    FilterHistoryEntry &entry = at(index);
+
+    entry.orientation_filter_before->copyFusionState(*orientation_filter);
+    entry.position_filter_before->copyFusionState(*position_filter);
+}
+
+void ControllerFilterHistory::rewindFiltersTo(
+    int index, 
+    OrientationFilter *orientation_filter, 
+    PositionFilter *position_filter) const
+{
+    const FilterHistoryEntry &entry = at(index);
+
+    orientation_filter->copyFusionState(*entry.orientation_filter_before);
+    position_filter->copyFusionState(*entry.position_filter_before);
+}
@@ -0,0 +1,71 @@
+#ifndef FILTER_HISTORY_H
+#define FILTER_HISTORY_H
+
+//-- includes -----
+#include <chrono>
+
+//-- constants -----
+// Number of processed controller states remembered for delayed optical fusion.
+// Matches the depth of the controller state buffers (PSMOVE_STATE_BUFFER_MAX/PSDS4_STATE_BUFFER_MAX)
+// since a state has to still be in the buffer to be replayed.
+static const int k_filter_history_size = 16;
+
+//-- declarations -----
+/// A controller state that has been run through the filters,
+/// along with the filter state from just before it was applied
+struct FilterHistoryEntry
+{
+    std::chrono::time_point<std::chrono::high_resolution_clock> sample_timestamp;
+    int poll_sequence_number;
+    float delta_time;
+    bool bOpticalApplied;
+    class OrientationFilter *orientation_filter_before;
+    class PositionFilter *position_filter_before;
+};
+
+/// Ring buffer of the most recently processed controller states.
+/// Lets an optical measurement that arrives late be fused at the sample it was captured at,
+/// after which the newer IMU samples are re-applied on top of it.
+/// The snapshot filters are allocated up front so updates never allocate.
+struct ControllerFilterHistory
+{
+    FilterHistoryEntry entries[k_filter_history_size];
+    int head; // index of the oldest entry
+    int count;
+
+    ControllerFilterHistory();
+    ~ControllerFilterHistory();
+
+    inline void clear()
+    {
+        head = 0;
+        count = 0;
+    }
+
+    /// 0 is the oldest entry, count-1 the newest
+    inline FilterHistoryEntry &at(int index)
+    {
+        return entries[(head + index) % k_filter_history_size];
+    }
+    inline const FilterHistoryEntry &at(int index) const
+    {
+        return entries[(head + index) % k_filter_history_size];
+    }
+
+    /// Appends a new entry, overwriting the oldest one when full
+    FilterHistoryEntry &push();
+
+    /// Returns the index of the sample an optical measurement captured at the given time gets fused at:
+    /// the first sample taken at or after the capture (the newest one if the frame is newer than every sample),
+    /// but never at or before a sample that already had an optical measurement fused.
+    /// Returns count if every sample is at or before an already fused one, -1 if the history is empty.
+    int findOpticalSampleIndex(const std::chrono::time_point<std::chrono::high_resolution_clock> &capture_timestamp) const;
+
+    /// Remembers the filter state from just before the given sample gets applied
+    void saveFiltersBefore(int index, const class OrientationFilter *orientation_filter, const class PositionFilter *position_filter);
+
+    /// Rewinds the filters to the state they were in just before the given sample was applied
+    void rewindFiltersTo(int index, class OrientationFilter *orientation_filter, class PositionFilter *position_filter) const;
+};
+
+#endif // FILTER_HISTORY_H
@@ -277,6 +277,11 @@ void OrientationFilter::resetFilterState()
     m_FusionState->initialize();
 }
 
+void OrientationFilter::copyFusionState(const OrientationFilter &other)
+{
+    *m_FusionState = *other.m_FusionState;
+}
+
 void OrientationFilter::update(
     const float delta_time, 
     const OrientationSensorPacket &sensorPacket)
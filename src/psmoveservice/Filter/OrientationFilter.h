@@ -122,6 +122,10 @@ public:
     void resetFilterState();
     void update(const float delta_time, const OrientationSensorPacket &packet);
 
+    /// Overwrite the fusion state with the fusion state of another filter.
+    /// Used to rewind the filter to an earlier sample when fusing a delayed optical measurement.
+    void copyFusionState(const OrientationFilter &other);
+
 private:
     OrientationFilterSpace m_FilterSpace;
     struct OrientationSensorFusionState *m_FusionState;
@@ -2,6 +2,7 @@
 #include "PositionFilter.h"
 #include "MathEigen.h"
 #include "ServerLog.h"
+#include <chrono>
 
 //-- constants -----
 // The max distance between samples that we apply low pass filter on the optical position filter
@@ -221,6 +222,11 @@ void PositionFilter::resetFilterState()
     m_FusionState->initialize();
 }
 
+void PositionFilter::copyFusionState(const PositionFilter &other)
+{
+    *m_FusionState = *other.m_FusionState;
+}
+
 void PositionFilter::update(
     const float delta_time,
     const PositionSensorPacket &sensorPacket)
@@ -118,6 +118,10 @@ public:
     void resetFilterState();
     void update(const float delta_time, const PositionSensorPacket &packet);
 
+    /// Overwrite the fusion state with the fusion state of another filter.
+    /// Used to rewind the filter to an earlier sample when fusing a delayed optical measurement.
+    void copyFusionState(const PositionFilter &other);
+
 private:
     PositionFilterConstants m_FilterConstants;
     PositionFilterSpace m_FilterSpace;
@@ -33,6 +33,12 @@
 #define PSDS4_BTADDR_SIZE 6
 #define PSDS4_STATE_BUFFER_MAX 16
 
+// Report timestamp and sequence counters
+#define PSDS4_TIMESTAMP_BITS 16
+#define PSDS4_TIMESTAMP_TICK_SECONDS (16.f / 3.f / 1000000.f) // 5.33us
+#define PSDS4_SEQUENCE_BITS 6
+#define PSDS4_NOMINAL_REPORT_INTERVAL_SECONDS 0.004f // Bluetooth reports at ~250Hz
+
 #define PSDS4_TRACKING_TRIANGLE_WIDTH  .9386f // The width of a triangle enclosed in the DS4 tracking bar in cm
 #define PSDS4_TRACKING_TRIANGLE_HEIGHT  .6548f // The height of a triangle enclosed in the DS4 tracking bar in cm
 
@@ -358,6 +364,9 @@ PSDualShock4Controller::PSDualShock4Controller()
     , RumbleLeft(0)
     , bWriteStateDirty(false)
     , NextPollSequenceNumber(0)
+    , ReportClock(
+        PSDS4_TIMESTAMP_BITS, PSDS4_TIMESTAMP_TICK_SECONDS,
+        PSDS4_SEQUENCE_BITS, PSDS4_NOMINAL_REPORT_INTERVAL_SECONDS)
 {
     HIDDetails.Handle = nullptr;
 
@@ -371,6 +380,9 @@ PSDualShock4Controller::PSDualShock4Controller()
     OutData->_unknown1[1] = 0x00;
     OutData->rumbleFlags = PSDS4_RUMBLE_ENABLED;
 
+    // Fixed size history so polling never allocates
+    ControllerStates.set_capacity(PSDS4_STATE_BUFFER_MAX);
+
     // Make sure there is an initial empty state in the tracker queue
     {
         PSDualShock4ControllerState empty_state;
@@ -510,11 +522,12 @@ bool PSDualShock4Controller::open(
                 cfg.load();
 
 				// Save it back out again in case any defaults changed
-				cfg.save();
+				cfg.saveDeferred();
             }
 
             // Reset the polling sequence counter
             NextPollSequenceNumber = 0;
+            ReportClock.reset();
 
             // Write out the initial controller state
             if (success && IsBluetooth)
@@ -615,7 +628,7 @@ PSDualShock4Controller::setTrackingColorID(const eCommonTrackingColorID tracking
 	if (getIsOpen() && getIsBluetooth())
 	{
 		cfg.tracking_color_id = tracking_color_id;
-		cfg.save();
+		cfg.saveDeferred();
 		bSuccess = true;
 	}
 
@@ -916,6 +929,8 @@ PSDualShock4Controller::poll()
             // Sequence and timestamp
             newState.RawSequence = InData->buttons3.state.counter;
             newState.RawTimeStamp = InData->timestamp;
+            ReportClock.processReport(
+                newState.RawTimeStamp, newState.RawSequence, std::chrono::high_resolution_clock::now(), newState);
 
             // Convert the 0-10 battery level into the batter level
             switch (InData->batteryLevel)
@@ -948,13 +963,7 @@ PSDualShock4Controller::poll()
                 break;
             }            
 
-            // Make room for new entry if at the max queue size
-            if (ControllerStates.size() >= PSDS4_STATE_BUFFER_MAX)
-            {
-                ControllerStates.erase(ControllerStates.begin(),
-                    ControllerStates.begin() + ControllerStates.size() - PSDS4_STATE_BUFFER_MAX);
-            }
-
+            // Overwrites the oldest entry once the queue is at PSDS4_STATE_BUFFER_MAX
             ControllerStates.push_back(newState);
         }
 
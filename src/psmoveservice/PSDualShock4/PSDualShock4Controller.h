@@ -6,9 +6,9 @@
 #include "DeviceInterface.h"
 #include "MathUtility.h"
 #include "hidapi.h"
+#include <boost/circular_buffer.hpp>
 #include <string>
 #include <vector>
-#include <deque>
 #include <chrono>
 
 // The angle the accelerometer reading is pitched forward when the DS4 is on a flat surface
@@ -310,7 +310,8 @@ private:
 
     // Read Controller State
     int NextPollSequenceNumber;
-    std::deque<PSDualShock4ControllerState> ControllerStates;
+    ControllerReportClock ReportClock;
+    boost::circular_buffer<PSDualShock4ControllerState> ControllerStates;
     PSDualShock4DataInput* InData;                        // Buffer to read hidapi reports into
     PSDualShock4DataOutput* OutData;                      // Buffer to write hidapi reports out from
 };
@@ -5,7 +5,21 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-- constants -----
+// How long a config has to go unmodified before the writer thread flushes it to disk.
+// Long enough to coalesce a config tool slider drag into a single write.
+static const int k_deferred_save_debounce_ms = 250;
 
 // Format: {hue center, hue range}, {sat center, sat range}, {val center, val range}
 // All hue angles are 60 degrees apart to maximize hue separation for 6 max tracked colors.
@@ -21,14 +35,288 @@ const CommonHSVColorRange g_default_color_presets[] = {
 };
 const CommonHSVColorRange *k_default_color_presets = g_default_color_presets;
 
+//-- private methods -----
+static bool write_config_atomic(const std::string &config_path, const boost::property_tree::ptree &pt);
+
+//-- private definitions -----
+// Owns the background thread that writes deferred config saves to disk.
+// Pending writes are keyed by config path so only the latest snapshot of each file gets written.
+// Only one write of a given path is ever in progress, so snapshots land on disk in the order they were taken.
+class PSMoveConfigWriter
+{
+public:
+    static PSMoveConfigWriter &getInstance()
+    {
+        static PSMoveConfigWriter s_instance;
+        return s_instance;
+    }
+
+    ~PSMoveConfigWriter()
+    {
+        flush();
+    }
+
+    void enqueue(const std::string &config_path, const boost::property_tree::ptree &pt)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        PendingWrite &pending= m_pending_writes[config_path];
+        pending.pt= pt;
+        pending.last_modified= std::chrono::steady_clock::now();
+
+        if (m_thread_running)
+        {
+            m_condition.notify_one();
+        }
+        else if (!m_flush_requested)
+        {
+            m_thread_running= true;
+            m_initializer_pending= static_cast<bool>(m_thread_initializer);
+            m_thread= std::thread(&PSMoveConfigWriter::thread_func, this);
+        }
+        // else a flush is in progress and writes this out once the writer thread has stopped
+    }
+
+    void setThreadInitializer(const std::function<void()> &initializer)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_thread_initializer= initializer;
+        m_initializer_pending= m_thread_running && static_cast<bool>(initializer);
+
+        if (m_initializer_pending)
+        {
+            m_condition.notify_one();
+        }
+    }
+
+    // Writes the snapshot on the calling thread once any write of the same path already in progress is done.
+    // Deferred saves still waiting on the writer thread are older than this snapshot and get dropped.
+    bool writeNow(const std::string &config_path, const boost::property_tree::ptree &pt)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_pending_writes.erase(config_path);
+        m_write_complete_condition.wait(lock, [this, &config_path]() { return m_writing_paths.count(config_path) == 0; });
+        m_writing_paths.insert(config_path);
+
+        lock.unlock();
+        const bool bSuccess= write_config_atomic(config_path, pt);
+        lock.lock();
+
+        finish_write(config_path);
+
+        return bSuccess;
+    }
+
+    void flush()
+    {
+        std::thread thread;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            if (m_flush_requested)
+            {
+                // Someone else is already flushing, wait for them to finish
+                m_flush_complete_condition.wait(lock, [this]() { return !m_flush_requested; });
+                return;
+            }
+
+            if (!m_thread_running)
+            {
+                return;
+            }
+
+            // Only this caller joins the thread
+            m_thread_running= false;
+            m_flush_requested= true;
+            thread.swap(m_thread);
+            m_condition.notify_one();
+        }
+
+        // The thread writes out everything still pending before exiting
+        thread.join();
+
+        // Saves enqueued after the thread's final drain are written here
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_pending_writes.empty())
+        {
+            std::vector<t_ready_write> late_writes;
+
+            take_ready_writes(true, late_writes);
+
+            if (late_writes.empty())
+            {
+                // Everything left is waiting on a save() of the same path
+                m_write_complete_condition.wait(lock);
+                continue;
+            }
+
+            write_ready_writes(lock, late_writes);
+        }
+
+        m_flush_requested= false;
+        m_flush_complete_condition.notify_all();
+    }
+
+private:
+    struct PendingWrite
+    {
+        boost::property_tree::ptree pt;
+        std::chrono::steady_clock::time_point last_modified;
+    };
+    typedef std::pair<std::string, boost::property_tree::ptree> t_ready_write;
+
+    PSMoveConfigWriter()
+        : m_pending_writes()
+        , m_writing_paths()
+        , m_thread_running(false)
+        , m_flush_requested(false)
+        , m_initializer_pending(false)
+    {
+    }
+
+    // Assumes m_mutex is held.
+    // Moves the writes that have been quiet for the debounce time (or all of them) into out_ready_writes,
+    // skipping paths that are being written right now, and marks their paths as being written.
+    // Returns when the next remaining write settles.
+    std::chrono::steady_clock::time_point take_ready_writes(bool bTakeAll, std::vector<t_ready_write> &out_ready_writes)
+    {
+        const std::chrono::milliseconds debounce(k_deferred_save_debounce_ms);
+        const std::chrono::steady_clock::time_point now= std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point next_deadline= now + debounce;
+
+        for (auto iter= m_pending_writes.begin(); iter != m_pending_writes.end(); )
+        {
+            const std::chrono::steady_clock::time_point deadline= iter->second.last_modified + debounce;
+
+            if (m_writing_paths.count(iter->first) != 0)
+            {
+                // Picked up again once that write is done
+                ++iter;
+            }
+            else if (bTakeAll || deadline <= now)
+            {
+                m_writing_paths.insert(iter->first);
+                out_ready_writes.push_back(t_ready_write(iter->first, std::move(iter->second.pt)));
+                iter= m_pending_writes.erase(iter);
+            }
+            else
+            {
+                if (deadline < next_deadline)
+                {
+                    next_deadline= deadline;
+                }
+                ++iter;
+            }
+        }
+
+        return next_deadline;
+    }
+
+    // Assumes lock holds m_mutex, which is released while touching the disk
+    void write_ready_writes(std::unique_lock<std::mutex> &lock, const std::vector<t_ready_write> &ready_writes)
+    {
+        lock.unlock();
+        for (const t_ready_write &ready_write : ready_writes)
+        {
+            write_config_atomic(ready_write.first, ready_write.second);
+        }
+        lock.lock();
+
+        for (const t_ready_write &ready_write : ready_writes)
+        {
+            finish_write(ready_write.first);
+        }
+    }
+
+    // Assumes m_mutex is held
+    void finish_write(const std::string &config_path)
+    {
+        m_writing_paths.erase(config_path);
+        m_write_complete_condition.notify_all();
+
+        // A deferred save of this path may have been held back by the write
+        if (m_pending_writes.count(config_path) != 0)
+        {
+            m_condition.notify_one();
+        }
+    }
+
+    void thread_func()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        for (;;)
+        {
+            if (m_initializer_pending)
+            {
+                const std::function<void()> initializer= m_thread_initializer;
+
+                m_initializer_pending= false;
+
+                lock.unlock();
+                initializer();
+                lock.lock();
+                continue;
+            }
+
+            if (m_pending_writes.empty())
+            {
+                if (m_flush_requested)
+                {
+                    break;
+                }
+
+                m_condition.wait(lock);
+                continue;
+            }
+
+            // Pull out every write that has settled (or all of them when flushing)
+            std::vector<t_ready_write> ready_writes;
+            const std::chrono::steady_clock::time_point next_deadline= 
+                take_ready_writes(m_flush_requested, ready_writes);
+
+            if (ready_writes.empty())
+            {
+                m_condition.wait_until(lock, next_deadline);
+                continue;
+            }
+
+            // Don't hold the lock while touching the disk
+            write_ready_writes(lock, ready_writes);
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::condition_variable m_flush_complete_condition;
+    std::condition_variable m_write_complete_condition;
+    std::map<std::string, PendingWrite> m_pending_writes;
+    std::set<std::string> m_writing_paths;
+    std::thread m_thread;
+    bool m_thread_running;
+    bool m_flush_requested;
+    std::function<void()> m_thread_initializer;
+    bool m_initializer_pending;
+};
+
 PSMoveConfig::PSMoveConfig(const std::string &fnamebase)
 : ConfigFileBase(fnamebase)
 {
 }
 
-const std::string
+const std::string &
 PSMoveConfig::getConfigPath()
 {
+    // Only resolve the path (and create the config directory) once per config file
+    if (!m_configPath.empty() && m_configPathFileBase == ConfigFileBase)
+    {
+        return m_configPath;
+    }
+
     const char *homedir;
 #ifdef _WIN32
     size_t homedir_buffer_req_size;
@@ -49,13 +337,35 @@ PSMoveConfig::getConfigPath()
     boost::filesystem::create_directory(configpath);
     configpath /= ConfigFileBase + ".json";
     std::cout << "Config file name: " << configpath << std::endl;
-    return configpath.string();
+
+    m_configPath= configpath.string();
+    m_configPathFileBase= ConfigFileBase;
+
+    return m_configPath;
 }
 
-void
+bool
 PSMoveConfig::save()
 {
-    boost::property_tree::write_json(getConfigPath(), config2ptree());
+    return PSMoveConfigWriter::getInstance().writeNow(getConfigPath(), config2ptree());
+}
+
+void
+PSMoveConfig::saveDeferred()
+{
+    PSMoveConfigWriter::getInstance().enqueue(getConfigPath(), config2ptree());
+}
+
+void
+PSMoveConfig::flushDeferredSaves()
+{
+    PSMoveConfigWriter::getInstance().flush();
+}
+
+void
+PSMoveConfig::setWriterThreadInitializer(const std::function<void()> &initializer)
+{
+    PSMoveConfigWriter::getInstance().setThreadInitializer(initializer);
 }
 
 bool
@@ -173,6 +483,36 @@ PSMoveConfig::readTrackingColor(
 	return tracking_color_id;
 }
 
+static bool
+write_config_atomic(
+    const std::string &config_path,
+    const boost::property_tree::ptree &pt)
+{
+    static std::atomic<unsigned int> s_temp_file_counter(0);
+
+    // Write to a temp file first and then swap it in,
+    // so a crash mid-write never leaves a truncated config behind.
+    // Every write gets its own temp file so two writers can never interleave in one.
+    const std::string temp_path = config_path + "." + std::to_string(s_temp_file_counter++) + ".tmp";
+    bool bSuccess = false;
+
+    try
+    {
+        boost::property_tree::write_json(temp_path, pt);
+        boost::filesystem::rename(temp_path, config_path);
+        bSuccess = true;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to write config file " << config_path << ": " << e.what() << std::endl;
+
+        boost::system::error_code error;
+        boost::filesystem::remove(temp_path, error);
+    }
+
+    return bSuccess;
+}
+
 static void
 writeColorPropertyPreset(
     boost::property_tree::ptree &pt,
@@ -2,6 +2,7 @@
 #define PSMOVE_CONFIG_H
 
 //-- includes -----
+#include <functional>
 #include <string>
 #include <boost/property_tree/ptree.hpp>
 
@@ -12,8 +13,27 @@ extern const struct CommonHSVColorRange *k_default_color_presets;
 class PSMoveConfig {
 public:
     PSMoveConfig(const std::string &fnamebase = std::string("PSMoveConfig"));
-    void save();
+    // Writes the config right away (after any write of the same file already in progress).
+    // Returns false if the file couldn't be written.
+    bool save();
     bool load();
+
+    // Snapshot the config and hand it off to the background config writer.
+    // Repeated calls within the debounce window are coalesced into a single write.
+    // Safe to call from the device update loop.
+    void saveDeferred();
+
+    // Block until every deferred save has been written to disk and stop the writer thread.
+    // Call this on shutdown so that no pending config changes are lost.
+    static void flushDeferredSaves();
+
+    // Runs the given function on the config writer thread, every time the thread starts
+    // and once on the running thread, e.g. to apply the service's thread scheduling policy.
+    // Pass an empty function to stop running it.
+    static void setWriterThreadInitializer(const std::function<void()> &initializer);
+
+    // Where the config file for ConfigFileBase lives (creating the config directory if needed)
+    const std::string &getConfigPath();
     
     std::string ConfigFileBase;
 
@@ -43,7 +63,8 @@ public:
 	static int readTrackingColor(const boost::property_tree::ptree &pt);
 
 private:
-    const std::string getConfigPath();
+    std::string m_configPath;
+    std::string m_configPathFileBase;
 };
 /*
 Note that PSMoveConfig is an abstract class because it has 2 pure virtual functions.
@@ -0,0 +1,370 @@
+//-- includes -----
+#include "PSMoveCalibrationCache.h"
+#include "ServerLog.h"
+
+#include <boost/optional.hpp>
+
+//-- constants -----
+// Bump this version when you are making a breaking config change.
+const int PSMoveCalibrationCache::CONFIG_VERSION= 1;
+
+//-- prototypes -----
+static int hex_digit_value(char hex_digit);
+
+//-- public methods -----
+PSMoveCalibrationCache &
+PSMoveCalibrationCache::getInstance()
+{
+    static PSMoveCalibrationCache s_instance;
+    return s_instance;
+}
+
+PSMoveCalibrationCache::PSMoveCalibrationCache()
+    : PSMoveConfig("PSMoveCalibrationCache")
+    , m_entries()
+    , m_pending_validations()
+    , m_validation_results()
+    , m_thread_running(false)
+    , m_stop_requested(false)
+{
+    load();
+}
+
+PSMoveCalibrationCache::~PSMoveCalibrationCache()
+{
+    shutdown();
+}
+
+bool
+PSMoveCalibrationCache::findEntry(const std::string &serial, PSMoveCalibrationCacheEntry &out_entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter= m_entries.find(serial);
+    bool bFound= false;
+
+    // An entry is only useful for skipping the open time feature reports if it has both addresses
+    if (iter != m_entries.end() && !iter->second.bt_addr.empty() && !iter->second.host_bt_addr.empty())
+    {
+        out_entry= iter->second;
+        bFound= true;
+    }
+
+    return bFound;
+}
+
+void
+PSMoveCalibrationCache::storeEntry(const std::string &serial, const PSMoveCalibrationCacheEntry &entry)
+{
+    bool bModified= false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bool bChanged= false;
+
+        bModified= mergeEntry(m_entries[serial], entry, bChanged);
+    }
+
+    if (bModified)
+    {
+        saveDeferred();
+    }
+}
+
+void
+PSMoveCalibrationCache::requestValidation(const std::string &serial, t_read_device read_device)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_stop_requested)
+    {
+        return;
+    }
+
+    ValidationRequest request;
+    request.serial= serial;
+    request.read_device= read_device;
+    m_pending_validations.push_back(request);
+
+    // Forget the result of any earlier validation of this controller
+    ValidationResult &result= m_validation_results[serial];
+    result.finished= false;
+    result.changed= false;
+    result.entry= PSMoveCalibrationCacheEntry();
+
+    if (!m_thread_running)
+    {
+        m_thread_running= true;
+        m_thread= std::thread(&PSMoveCalibrationCache::thread_func, this);
+    }
+    else
+    {
+        m_condition.notify_one();
+    }
+}
+
+bool
+PSMoveCalibrationCache::takeValidationResult(
+    const std::string &serial,
+    bool &out_changed,
+    PSMoveCalibrationCacheEntry &out_entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter= m_validation_results.find(serial);
+    bool bFinished= false;
+
+    if (iter != m_validation_results.end() && iter->second.finished)
+    {
+        out_changed= iter->second.changed;
+        out_entry= iter->second.entry;
+        m_validation_results.erase(iter);
+        bFinished= true;
+    }
+
+    return bFinished;
+}
+
+void
+PSMoveCalibrationCache::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_thread_running)
+        {
+            return;
+        }
+
+        m_stop_requested= true;
+        m_pending_validations.clear();
+        m_condition.notify_one();
+    }
+
+    // Waits on at most the one device read in flight
+    m_thread.join();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_thread_running= false;
+    }
+}
+
+bool
+PSMoveCalibrationCache::mergeEntry(
+    PSMoveCalibrationCacheEntry &cached_entry,
+    const PSMoveCalibrationCacheEntry &entry,
+    bool &out_changed)
+{
+    bool bModified= false;
+
+    out_changed= false;
+
+    if (!entry.bt_addr.empty() && entry.bt_addr != cached_entry.bt_addr)
+    {
+        out_changed|= !cached_entry.bt_addr.empty();
+        cached_entry.bt_addr= entry.bt_addr;
+        bModified= true;
+    }
+
+    if (!entry.host_bt_addr.empty() && entry.host_bt_addr != cached_entry.host_bt_addr)
+    {
+        out_changed|= !cached_entry.host_bt_addr.empty();
+        cached_entry.host_bt_addr= entry.host_bt_addr;
+        bModified= true;
+    }
+
+    if (!entry.calibration_blob.empty() && entry.calibration_blob != cached_entry.calibration_blob)
+    {
+        out_changed|= !cached_entry.calibration_blob.empty();
+        cached_entry.calibration_blob= entry.calibration_blob;
+        bModified= true;
+    }
+
+    return bModified;
+}
+
+std::string
+PSMoveCalibrationCache::blobToHexString(const std::vector<unsigned char> &blob)
+{
+    static const char k_hex_digits[]= "0123456789abcdef";
+    std::string hex;
+
+    hex.reserve(blob.size() * 2);
+    for (unsigned char byte : blob)
+    {
+        hex+= k_hex_digits[byte >> 4];
+        hex+= k_hex_digits[byte & 0x0f];
+    }
+
+    return hex;
+}
+
+bool
+PSMoveCalibrationCache::hexStringToBlob(const std::string &hex, std::vector<unsigned char> &out_blob)
+{
+    bool success= (hex.size() % 2) == 0;
+
+    out_blob.clear();
+    out_blob.reserve(hex.size() / 2);
+
+    for (size_t char_index= 0; success && char_index < hex.size(); char_index+= 2)
+    {
+        // Digit by digit, sscanf("%2x") would let through signs and spaces
+        const int high= hex_digit_value(hex[char_index]);
+        const int low= hex_digit_value(hex[char_index + 1]);
+
+        success= high >= 0 && low >= 0;
+        out_blob.push_back(static_cast<unsigned char>((high << 4) | low));
+    }
+
+    if (!success)
+    {
+        out_blob.clear();
+    }
+
+    return success;
+}
+
+const boost::property_tree::ptree
+PSMoveCalibrationCache::config2ptree()
+{
+    boost::property_tree::ptree pt;
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    pt.put("version", PSMoveCalibrationCache::CONFIG_VERSION);
+
+    for (auto iter= m_entries.begin(); iter != m_entries.end(); ++iter)
+    {
+        boost::property_tree::ptree entry_pt;
+
+        entry_pt.put("bt_addr", iter->second.bt_addr);
+        entry_pt.put("host_bt_addr", iter->second.host_bt_addr);
+        entry_pt.put("calibration_blob", blobToHexString(iter->second.calibration_blob));
+
+        // Serial numbers can contain '.' on some platforms so don't use it as the path separator
+        pt.put_child(boost::property_tree::ptree::path_type("controllers/" + iter->first, '/'), entry_pt);
+    }
+
+    return pt;
+}
+
+void
+PSMoveCalibrationCache::ptree2config(const boost::property_tree::ptree &pt)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const int version= pt.get<int>("version", 0);
+
+    m_entries.clear();
+
+    if (version == PSMoveCalibrationCache::CONFIG_VERSION)
+    {
+        boost::optional<const boost::property_tree::ptree &> controllers_pt= pt.get_child_optional("controllers");
+
+        if (controllers_pt)
+        {
+            for (auto iter= controllers_pt->begin(); iter != controllers_pt->end(); ++iter)
+            {
+                PSMoveCalibrationCacheEntry entry;
+
+                entry.bt_addr= iter->second.get<std::string>("bt_addr", "");
+                entry.host_bt_addr= iter->second.get<std::string>("host_bt_addr", "");
+
+                if (!hexStringToBlob(iter->second.get<std::string>("calibration_blob", ""), entry.calibration_blob))
+                {
+                    SERVER_LOG_WARNING("PSMoveCalibrationCache") <<
+                        "Ignoring malformed cached calibration blob for controller " << iter->first;
+                }
+
+                m_entries[iter->first]= entry;
+            }
+        }
+    }
+    else
+    {
+        SERVER_LOG_WARNING("PSMoveCalibrationCache") <<
+            "Config version " << version << " does not match expected version " <<
+            PSMoveCalibrationCache::CONFIG_VERSION << ", Starting with an empty cache.";
+    }
+}
+
+//-- private methods -----
+void
+PSMoveCalibrationCache::thread_func()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stop_requested)
+    {
+        if (m_pending_validations.empty())
+        {
+            m_condition.wait(lock);
+            continue;
+        }
+
+        ValidationRequest request= m_pending_validations.front();
+        m_pending_validations.pop_front();
+
+        // The feature report round trips are the slow part, so don't hold the lock for them
+        lock.unlock();
+        PSMoveCalibrationCacheEntry fresh_entry;
+        const bool bReadOk= request.read_device(fresh_entry);
+        lock.lock();
+
+        bool bChanged= false;
+        bool bModified= false;
+
+        if (bReadOk)
+        {
+            bModified= mergeEntry(m_entries[request.serial], fresh_entry, bChanged);
+
+            if (bChanged)
+            {
+                SERVER_LOG_WARNING("PSMoveCalibrationCache") <<
+                    "Cached calibration for controller " << request.serial << " was stale. Updating.";
+            }
+        }
+        else
+        {
+            SERVER_LOG_WARNING("PSMoveCalibrationCache") <<
+                "Failed to re-read controller " << request.serial << " to validate its cached calibration.";
+        }
+
+        // Only report back if the controller is still waiting on a result
+        auto result_iter= m_validation_results.find(request.serial);
+        if (result_iter != m_validation_results.end() && !result_iter->second.finished)
+        {
+            result_iter->second.finished= true;
+            result_iter->second.changed= bChanged;
+            result_iter->second.entry= m_entries[request.serial];
+        }
+
+        if (bModified)
+        {
+            // config2ptree() takes the lock itself
+            lock.unlock();
+            saveDeferred();
+            lock.lock();
+        }
+    }
+}
+
+//-- private functions -----
+static int hex_digit_value(char hex_digit)
+{
+    int value= -1;
+
+    if (hex_digit >= '0' && hex_digit <= '9')
+    {
+        value= hex_digit - '0';
+    }
+    else if (hex_digit >= 'a' && hex_digit <= 'f')
+    {
+        value= 10 + hex_digit - 'a';
+    }
+    else if (hex_digit >= 'A' && hex_digit <= 'F')
+    {
+        value= 10 + hex_digit - 'A';
+    }
+
+    return value;
+}
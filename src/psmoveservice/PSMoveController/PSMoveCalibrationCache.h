@@ -0,0 +1,100 @@
+#ifndef PSMOVE_CALIBRATION_CACHE_H
+#define PSMOVE_CALIBRATION_CACHE_H
+
+//-- includes -----
+#include "PSMoveConfig.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-- definitions -----
+/// What a PS Move reports over feature reports when it connects
+struct PSMoveCalibrationCacheEntry
+{
+    std::string bt_addr;      // The bluetooth address of the controller
+    std::string host_bt_addr; // The bluetooth address of the adapter registered with the controller
+    std::vector<unsigned char> calibration_blob; // Raw accelerometer/gyro calibration (empty if never read)
+};
+
+/// Persistent cache of the PS Move bluetooth addresses and calibration blob keyed by serial number.
+/// A controller found in the cache opens without any feature report round trips,
+/// which are slow over bluetooth. The cached values are re-read from the device on
+/// a background thread once the controller is already streaming and any difference
+/// is handed back to the controller to apply.
+class PSMoveCalibrationCache : public PSMoveConfig
+{
+public:
+    static const int CONFIG_VERSION;
+
+    /// Reads the device on the validation thread. Must only use its own HID handles.
+    typedef std::function<bool(PSMoveCalibrationCacheEntry &out_entry)> t_read_device;
+
+    static PSMoveCalibrationCache &getInstance();
+
+    /// Copies out the cached entry for a controller. Returns false on a cache miss.
+    bool findEntry(const std::string &serial, PSMoveCalibrationCacheEntry &out_entry);
+
+    /// Updates the cached entry for a controller. An empty field keeps its cached value.
+    void storeEntry(const std::string &serial, const PSMoveCalibrationCacheEntry &entry);
+
+    /// Queues a background re-read of the controller to check the cache against
+    void requestValidation(const std::string &serial, t_read_device read_device);
+
+    /// Polled by the controller after requestValidation().
+    /// Returns true once the validation has finished. out_changed is set if the device
+    /// no longer matched what was cached, in which case out_entry holds the fresh values.
+    bool takeValidationResult(const std::string &serial, bool &out_changed, PSMoveCalibrationCacheEntry &out_entry);
+
+    /// Stops the validation thread. Validations still queued are dropped.
+    void shutdown();
+
+    /// Merges the non-empty fields of entry into cached_entry.
+    /// Returns true if cached_entry was modified. out_changed is set if a value
+    /// that was already cached turned out to be different.
+    static bool mergeEntry(
+        PSMoveCalibrationCacheEntry &cached_entry, const PSMoveCalibrationCacheEntry &entry, bool &out_changed);
+
+    /// How the calibration blob is stored in the config file (two lower case hex digits per byte)
+    static std::string blobToHexString(const std::vector<unsigned char> &blob);
+    /// Returns false (and an empty blob) if the string isn't an even number of hex digits
+    static bool hexStringToBlob(const std::string &hex, std::vector<unsigned char> &out_blob);
+
+    virtual const boost::property_tree::ptree config2ptree() override;
+    virtual void ptree2config(const boost::property_tree::ptree &pt) override;
+
+private:
+    struct ValidationRequest
+    {
+        std::string serial;
+        t_read_device read_device;
+    };
+
+    struct ValidationResult
+    {
+        bool finished;
+        bool changed;
+        PSMoveCalibrationCacheEntry entry;
+    };
+
+    PSMoveCalibrationCache();
+    ~PSMoveCalibrationCache();
+
+    void thread_func();
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::map<std::string, PSMoveCalibrationCacheEntry> m_entries;
+    std::deque<ValidationRequest> m_pending_validations;
+    std::map<std::string, ValidationResult> m_validation_results;
+    std::thread m_thread;
+    bool m_thread_running;
+    bool m_stop_requested;
+};
+
+#endif // PSMOVE_CALIBRATION_CACHE_H
@@ -35,6 +35,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 //-- includes -----
 #include "PSMoveController.h"
+#include "PSMoveCalibrationCache.h"
 #include "ControllerDeviceEnumerator.h"
 #include "ServerLog.h"
 #include "ServerUtility.h"
@@ -61,6 +62,12 @@ POSSIBILITY OF SUCH DAMAGE.
 #define PSMOVE_CALIBRATION_BLOB_SIZE (PSMOVE_CALIBRATION_SIZE*3 - 2*2) /* Three blocks, minus header (2 bytes) for blocks 2,3 */
 #define PSMOVE_STATE_BUFFER_MAX 16
 
+/* Report timestamp and sequence counters */
+#define PSMOVE_TIMESTAMP_BITS 16
+#define PSMOVE_TIMESTAMP_TICK_SECONDS 0.f // Not documented, so the report clock measures it
+#define PSMOVE_SEQUENCE_BITS 4
+#define PSMOVE_NOMINAL_REPORT_INTERVAL_SECONDS 0.0115f
+
 #define PSMOVE_TRACKING_BULB_RADIUS  2.25f // The radius of the psmove tracking bulb in cm
 
 /* Minimum time (in milliseconds) psmove write updates */
@@ -178,6 +185,11 @@ struct PSMoveDataInput {
 static std::string btAddrUcharToString(const unsigned char* addr_buff);
 static bool stringToBTAddrUchar(const std::string &addr, unsigned char *addr_buff, const int addr_buf_size);
 static int decodeCalibration(char *data, int offset);
+static bool readBTAddresses(hid_device *handle, std::string &out_host, std::string &out_controller);
+static bool readCalibrationBlob(hid_device *handle, unsigned char *out_blob);
+static void decodeCalibrationBlob(const unsigned char *blob, PSMoveControllerConfig &cfg);
+static bool readCalibrationCacheEntry(
+    const std::string &device_path, const std::string &device_path_addr, PSMoveCalibrationCacheEntry &out_entry);
 static int psmove_decode_16bit(char *data, int offset);
 inline enum CommonControllerState::ButtonState getButtonState(unsigned int buttons, unsigned int lastButtons, int buttonMask);
 inline bool hid_error_mbs(hid_device *dev, char *out_mb_error, size_t mb_buffer_size);
@@ -346,12 +358,17 @@ PSMoveControllerConfig::getMegnetometerEllipsoid(struct EigenFitEllipsoid *out_e
 
 // -- PSMove Controller -----
 PSMoveController::PSMoveController()
-    : LedR(0)
+    : bCalibrationCacheValidationPending(false)
+    , bCalibrationFromCache(false)
+    , LedR(0)
     , LedG(0)
     , LedB(0)
     , Rumble(0)
     , bWriteStateDirty(false)
     , NextPollSequenceNumber(0)
+    , ReportClock(
+        PSMOVE_TIMESTAMP_BITS, PSMOVE_TIMESTAMP_TICK_SECONDS, 
+        PSMOVE_SEQUENCE_BITS, PSMOVE_NOMINAL_REPORT_INTERVAL_SECONDS)
 {
     HIDDetails.Handle = nullptr;
     HIDDetails.Handle_addr = nullptr;
@@ -359,6 +376,9 @@ PSMoveController::PSMoveController()
     InData = new PSMoveDataInput;
     InData->type = PSMove_Req_GetInput;
 
+    // Fixed size history so polling never allocates
+    ControllerStates.set_capacity(PSMOVE_STATE_BUFFER_MAX);
+
     // Make sure there is an initial empty state in the tracker queue
     {     
         PSMoveControllerState empty_state;
@@ -448,23 +468,41 @@ bool PSMoveController::open(
 
         if (getIsOpen())  // Controller was opened and has an index
         {
-            // Get the bluetooth address
-    #ifdef __APPLE__
-            // On my Mac, getting the bt feature report when connected via
-            // bt crashes the controller. So we simply copy the serial number.
-            // It gets modified in getBTAddress.
-            // TODO: Copy this over anyway even in Windows. Check getBTAddress
-            // comments for handling windows serial_number.
-            // Once done, we can remove the ifndef above.
-            std::string mbs(cur_dev_serial_number);
-            HIDDetails.Bt_addr = mbs;
-            
-            if (!bluetooth_get_host_address(HIDDetails.Host_bt_addr))
+            // A controller we've seen before over bluetooth can skip the feature report
+            // round trips below. The cached values get checked in the background once it's streaming.
+            PSMoveCalibrationCacheEntry cache_entry;
+            const bool bUseCache= 
+                IsBluetooth && 
+                PSMoveCalibrationCache::getInstance().findEntry(cur_dev_serial_number, cache_entry);
+
+            bCalibrationFromCache= false;
+
+            if (bUseCache)
             {
-                HIDDetails.Host_bt_addr= "00:00:00:00:00:00";
+                HIDDetails.Bt_addr= cache_entry.bt_addr;
+                HIDDetails.Host_bt_addr= cache_entry.host_bt_addr;
             }
+            else
+            {
+                // Get the bluetooth address
+    #ifdef __APPLE__
+                // On my Mac, getting the bt feature report when connected via
+                // bt crashes the controller. So we simply copy the serial number.
+                // It gets modified in getBTAddress.
+                // TODO: Copy this over anyway even in Windows. Check getBTAddress
+                // comments for handling windows serial_number.
+                // Once done, we can remove the ifndef above.
+                std::string mbs(cur_dev_serial_number);
+                HIDDetails.Bt_addr = mbs;
+                
+                if (!bluetooth_get_host_address(HIDDetails.Host_bt_addr))
+                {
+                    HIDDetails.Host_bt_addr= "00:00:00:00:00:00";
+                }
     #endif
-            if (getBTAddress(HIDDetails.Host_bt_addr, HIDDetails.Bt_addr))
+            }
+
+            if (bUseCache || getBTAddress(HIDDetails.Host_bt_addr, HIDDetails.Bt_addr))
             {
                 // Load the config file
                 std::string btaddr = HIDDetails.Bt_addr;
@@ -479,12 +517,49 @@ bool PSMoveController::open(
                         SERVER_LOG_ERROR("PSMoveController::open") << "PSMoveController(" << cur_dev_path << ") has invalid calibration. Reloading.";
                     }
 
-                    // Load calibration from controller internal memory.
-                    loadCalibration();
+                    if (bUseCache && cache_entry.calibration_blob.size() == PSMOVE_CALIBRATION_BLOB_SIZE)
+                    {
+                        // Use the cached copy of the controller internal memory.
+                        decodeCalibrationBlob(cache_entry.calibration_blob.data(), cfg);
+                        cfg.is_valid= true;
+                        bCalibrationFromCache= true;
+                    }
+                    else
+                    {
+                        // Load calibration from controller internal memory.
+                        loadCalibration();
+                    }
                 }
 
 				// Always save the config back out in case some defaults changed
-				cfg.save();
+				cfg.saveDeferred();
+
+                if (IsBluetooth)
+                {
+                    PSMoveCalibrationCache &cache= PSMoveCalibrationCache::getInstance();
+                    const std::string device_path= HIDDetails.Device_path;
+                    const std::string device_path_addr= HIDDetails.Device_path_addr;
+
+                    CalibrationCacheSerial= cur_dev_serial_number;
+
+                    if (!bUseCache)
+                    {
+                        PSMoveCalibrationCacheEntry new_entry;
+
+                        new_entry.bt_addr= HIDDetails.Bt_addr;
+                        new_entry.host_bt_addr= HIDDetails.Host_bt_addr;
+                        cache.storeEntry(CalibrationCacheSerial, new_entry);
+                    }
+
+                    // Re-read the device on the cache's own thread (and own HID handles),
+                    // which also fills in the calibration blob on a first connection
+                    cache.requestValidation(
+                        CalibrationCacheSerial,
+                        [device_path, device_path_addr](PSMoveCalibrationCacheEntry &out_entry) {
+                            return readCalibrationCacheEntry(device_path, device_path_addr, out_entry);
+                        });
+                    bCalibrationCacheValidationPending= true;
+                }
 
                 success= true;
             }
@@ -498,6 +573,7 @@ bool PSMoveController::open(
 
             // Reset the polling sequence counter
             NextPollSequenceNumber= 0;
+            ReportClock.reset();
         }
         else
         {
@@ -515,6 +591,9 @@ void PSMoveController::close()
     {
         SERVER_LOG_INFO("PSMoveController::close") << "Closing PSMoveController(" << HIDDetails.Device_path << ")";
 
+        // Any result still pending gets replaced when the controller next opens
+        bCalibrationCacheValidationPending= false;
+
         if (HIDDetails.Handle != nullptr)
         {
             hid_close(HIDDetails.Handle);
@@ -600,7 +679,7 @@ PSMoveController::setTrackingColorID(const eCommonTrackingColorID tracking_color
 	if (getIsOpen() && getIsBluetooth())
 	{
 		cfg.tracking_color_id = tracking_color_id;
-		cfg.save();
+		cfg.saveDeferred();
 		bSuccess = true;
 	}
 
@@ -697,51 +776,10 @@ PSMoveController::getBTAddress(std::string& host, std::string& controller)
     }
     else
     {
-        int res;
-        
-        unsigned char btg[PSMOVE_BTADDR_GET_SIZE];
-        unsigned char ctrl_char_buff[PSMOVE_BTADDR_SIZE];
-        unsigned char host_char_buff[PSMOVE_BTADDR_SIZE];
-
-        memset(btg, 0, sizeof(btg));
-        btg[0] = PSMove_Req_GetBTAddr;
         /* _WIN32 only has move->handle_addr for getting bluetooth address. */
-        if (HIDDetails.Handle_addr) {
-            res = hid_get_feature_report(HIDDetails.Handle_addr, btg, sizeof(btg));
-        }
-        else {
-            res = hid_get_feature_report(HIDDetails.Handle, btg, sizeof(btg));
-        }
-
-        if (res == sizeof(btg)) {
-
-            memcpy(host_char_buff, btg + 10, PSMOVE_BTADDR_SIZE);
-            host = btAddrUcharToString(host_char_buff);
-
-            memcpy(ctrl_char_buff, btg + 1, PSMOVE_BTADDR_SIZE);
-            controller = btAddrUcharToString(ctrl_char_buff);
-
-            success = true;
-        }
-        else
-        {
-            char hidapi_err_mbs[256];
-            bool valid_error_mesg= false;
-            
-            if (HIDDetails.Handle_addr)
-            {
-                valid_error_mesg = hid_error_mbs(HIDDetails.Handle_addr, hidapi_err_mbs, sizeof(hidapi_err_mbs));
-            }
-            else
-            {
-                valid_error_mesg = hid_error_mbs(HIDDetails.Handle, hidapi_err_mbs, sizeof(hidapi_err_mbs));
-            }
-
-            if (valid_error_mesg)
-            {
-                SERVER_LOG_ERROR("PSMoveController::getBTAddress") << "HID ERROR: " << hidapi_err_mbs;
-            }
-        }
+        success = readBTAddresses(
+            (HIDDetails.Handle_addr != nullptr) ? HIDDetails.Handle_addr : HIDDetails.Handle,
+            host, controller);
     }
 
     return success;
@@ -750,15 +788,10 @@ PSMoveController::getBTAddress(std::string& host, std::string& controller)
 void
 PSMoveController::loadCalibration()
 {
-    bool is_valid= true;
-
     // The calibration provides a scale factor (k) and offset (b) to convert
     // raw accelerometer and gyroscope readings into something more useful.
     // https://github.com/nitsch/moveonpc/wiki/Calibration-data
 
-    // calibration data storage - loaded from file (if bluetooth) or usb
-    char usb_calibration[PSMOVE_CALIBRATION_BLOB_SIZE];
-
     // Default values are pass-through (raw*1 + 0)
     cfg.cal_ag_xyz_kb = {{ 
             {{ {{ 1, 0 }}, {{ 1, 0 }}, {{ 1, 0 }} }}, 
@@ -767,96 +800,53 @@ PSMoveController::loadCalibration()
 
     // Load the calibration from the controller itself.
     unsigned char hid_cal[PSMOVE_CALIBRATION_BLOB_SIZE];
+    bool is_valid= readCalibrationBlob(HIDDetails.Handle, hid_cal);
 
-    for (int block_index=0; is_valid && block_index<3; block_index++) 
+    if (is_valid)
     {
-        unsigned char cal[PSMOVE_CALIBRATION_SIZE];
-        int dest_offset;
-        int src_offset;
+        decodeCalibrationBlob(hid_cal, cfg);
+    }
 
-        memset(cal, 0, sizeof(cal));
-        cal[0] = PSMove_Req_GetCalibration;
+    cfg.is_valid= is_valid;
+}
 
-        int res = hid_get_feature_report(HIDDetails.Handle, cal, sizeof(cal));
+void
+PSMoveController::pollCalibrationCacheValidation()
+{
+    PSMoveCalibrationCacheEntry fresh_entry;
+    bool bChanged= false;
 
-        if (res == PSMOVE_CALIBRATION_SIZE)
+    if (PSMoveCalibrationCache::getInstance().takeValidationResult(CalibrationCacheSerial, bChanged, fresh_entry))
+    {
+        bCalibrationCacheValidationPending= false;
+
+        if (bChanged)
         {
-            if (cal[1] == 0x00) 
+            if (fresh_entry.host_bt_addr != HIDDetails.Host_bt_addr)
             {
-                /* First block */
-                dest_offset = 0;
-                src_offset = 0;
-            }
-            else if (cal[1] == 0x01) 
-            {
-                /* Second block */
-                dest_offset = PSMOVE_CALIBRATION_SIZE;
-                src_offset = 2;
+                SERVER_LOG_WARNING("PSMoveController::pollCalibrationCacheValidation") 
+                    << "PSMoveController(" << HIDDetails.Device_path << ") is paired to host " << fresh_entry.host_bt_addr
+                    << ", not the cached " << HIDDetails.Host_bt_addr;
+                HIDDetails.Host_bt_addr= fresh_entry.host_bt_addr;
             }
-            else if (cal[1] == 0x82) 
-            {
-                /* Third block */
-                dest_offset = 2*PSMOVE_CALIBRATION_SIZE - 2;
-                src_offset = 2;
-            }
-            else
-            {
-                SERVER_LOG_ERROR("PSMoveController::loadCalibration") 
-                    << "Unexpected calibration block id(0x" << std::hex << std::setfill('0') << std::setw(2) << cal[1] 
-                    << " on block #" << block_index;
-                is_valid= false;
-            }
-        }
-        else
-        {
-            char hidapi_err_mbs[256];
-            bool valid_error_mesg = hid_error_mbs(HIDDetails.Handle, hidapi_err_mbs, sizeof(hidapi_err_mbs));
 
-            // Device no longer in valid state.
-            if (valid_error_mesg)
+            if (fresh_entry.bt_addr != HIDDetails.Bt_addr)
             {
-                SERVER_LOG_ERROR("PSMoveController::loadCalibration") << "HID ERROR: " << hidapi_err_mbs;
+                // The config file is named after the address, so that only switches on the next open
+                SERVER_LOG_WARNING("PSMoveController::pollCalibrationCacheValidation") 
+                    << "PSMoveController(" << HIDDetails.Device_path << ") reports bluetooth address " << fresh_entry.bt_addr
+                    << ", not the cached " << HIDDetails.Bt_addr << ". Reconnect it to load the matching config.";
             }
 
-            is_valid= false;
-        }
-
-        if (is_valid)
-        {
-            memcpy(hid_cal+dest_offset, cal+src_offset, sizeof(cal)-src_offset);
-        }
-    }
-
-    if (is_valid)
-    {
-        memcpy(usb_calibration, hid_cal, PSMOVE_CALIBRATION_BLOB_SIZE);
-        
-        // Convert the calibration blob into constant & offset for each accel dim.
-        std::vector< std::vector<int> > dim_lohi = { {1, 3}, {5, 4}, {2, 0} };
-        std::vector<int> res_lohi(2, 0);
-        int dim_ix = 0;
-        int lohi_ix = 0;
-        for (dim_ix = 0; dim_ix < 3; dim_ix++)
-        {
-            for (lohi_ix = 0; lohi_ix < 2; lohi_ix++)
+            if (bCalibrationFromCache && fresh_entry.calibration_blob.size() == PSMOVE_CALIBRATION_BLOB_SIZE)
             {
-                res_lohi[lohi_ix] = decodeCalibration(usb_calibration, 0x04 + 6*dim_lohi[dim_ix][lohi_ix] + 2*dim_ix);
+                SERVER_LOG_WARNING("PSMoveController::pollCalibrationCacheValidation") 
+                    << "PSMoveController(" << HIDDetails.Device_path << ") cached calibration was stale. Reloading.";
+                decodeCalibrationBlob(fresh_entry.calibration_blob.data(), cfg);
+                cfg.saveDeferred();
             }
-            cfg.cal_ag_xyz_kb[0][dim_ix][0] = 2.f / (float)(res_lohi[1] - res_lohi[0]);
-            cfg.cal_ag_xyz_kb[0][dim_ix][1] = -(cfg.cal_ag_xyz_kb[0][dim_ix][0] * (float)res_lohi[0]) - 1.f;
-        }
-        
-        // Convert the calibration blob into constant for each gyro dim.
-        float factor = (float)(2.0 * M_PI * 80.0) / 60.0f;
-        for (dim_ix = 0; dim_ix < 3; dim_ix++)
-        {
-            cfg.cal_ag_xyz_kb[1][dim_ix][0] = factor / (float)(decodeCalibration(usb_calibration, 0x46 + 10 * dim_ix)
-                                                    - decodeCalibration(usb_calibration, 0x2a + 2*dim_ix));
-            // No offset for gyroscope
         }
     }
-
-    cfg.is_valid= is_valid;
 }
 
 IControllerInterface::ePollResult
@@ -873,6 +863,11 @@ PSMoveController::poll()
     {
         static const int k_max_iterations= 32;        
 
+        if (bCalibrationCacheValidationPending)
+        {
+            pollCalibrationCacheValidation();
+        }
+
         for (int iteration= 0; iteration < k_max_iterations; ++iteration)
         {
             // Attempt to read the next update packet from the controller
@@ -1020,13 +1015,19 @@ PSMoveController::poll()
             newState.RawTimeStamp = InData->timelow | (InData->timehigh << 8);
             newState.TempRaw = (InData->temphigh << 4) | ((InData->templow_mXhigh & 0xF0) >> 4);
 
-            // Make room for new entry if at the max queue size
-            if (ControllerStates.size() >= PSMOVE_STATE_BUFFER_MAX)
+            // Time since the last report and any reports lost in between.
+            // NOTE: Each report holds two IMU frames that are half of the time delta apart.
+            const bool bTimestampTickKnown= ReportClock.getTimestampTickSeconds() > 0.f;
+            ReportClock.processReport(
+                newState.RawTimeStamp, newState.RawSequence, std::chrono::high_resolution_clock::now(), newState);
+
+            if (!bTimestampTickKnown && ReportClock.getTimestampTickSeconds() > 0.f)
             {
-                ControllerStates.erase(ControllerStates.begin(),
-                    ControllerStates.begin() + ControllerStates.size() - PSMOVE_STATE_BUFFER_MAX);
+                SERVER_LOG_INFO("PSMoveController::poll") << "Measured a report timestamp tick of " 
+                    << ReportClock.getTimestampTickSeconds() * 1000000.f << "us";
             }
 
+            // Overwrites the oldest entry once the queue is at PSMOVE_STATE_BUFFER_MAX
             ControllerStates.push_back(newState);
         }
 
@@ -1266,6 +1267,187 @@ decodeCalibration(char *data, int offset)
     return (low | (high << 8)) - 0x8000;
 }
 
+static bool
+readBTAddresses(hid_device *handle, std::string &out_host, std::string &out_controller)
+{
+    bool success= false;
+    unsigned char btg[PSMOVE_BTADDR_GET_SIZE];
+    unsigned char ctrl_char_buff[PSMOVE_BTADDR_SIZE];
+    unsigned char host_char_buff[PSMOVE_BTADDR_SIZE];
+
+    memset(btg, 0, sizeof(btg));
+    btg[0] = PSMove_Req_GetBTAddr;
+
+    int res = hid_get_feature_report(handle, btg, sizeof(btg));
+
+    if (res == sizeof(btg)) 
+    {
+        memcpy(host_char_buff, btg + 10, PSMOVE_BTADDR_SIZE);
+        out_host = btAddrUcharToString(host_char_buff);
+
+        memcpy(ctrl_char_buff, btg + 1, PSMOVE_BTADDR_SIZE);
+        out_controller = btAddrUcharToString(ctrl_char_buff);
+
+        success = true;
+    }
+    else
+    {
+        char hidapi_err_mbs[256];
+        bool valid_error_mesg = hid_error_mbs(handle, hidapi_err_mbs, sizeof(hidapi_err_mbs));
+
+        if (valid_error_mesg)
+        {
+            SERVER_LOG_ERROR("PSMoveController::getBTAddress") << "HID ERROR: " << hidapi_err_mbs;
+        }
+    }
+
+    return success;
+}
+
+static bool
+readCalibrationBlob(hid_device *handle, unsigned char *out_blob)
+{
+    bool is_valid= true;
+
+    for (int block_index=0; is_valid && block_index<3; block_index++) 
+    {
+        unsigned char cal[PSMOVE_CALIBRATION_SIZE];
+        int dest_offset;
+        int src_offset;
+
+        memset(cal, 0, sizeof(cal));
+        cal[0] = PSMove_Req_GetCalibration;
+
+        int res = hid_get_feature_report(handle, cal, sizeof(cal));
+
+        if (res == PSMOVE_CALIBRATION_SIZE)
+        {
+            if (cal[1] == 0x00) 
+            {
+                /* First block */
+                dest_offset = 0;
+                src_offset = 0;
+            }
+            else if (cal[1] == 0x01) 
+            {
+                /* Second block */
+                dest_offset = PSMOVE_CALIBRATION_SIZE;
+                src_offset = 2;
+            }
+            else if (cal[1] == 0x82) 
+            {
+                /* Third block */
+                dest_offset = 2*PSMOVE_CALIBRATION_SIZE - 2;
+                src_offset = 2;
+            }
+            else
+            {
+                SERVER_LOG_ERROR("PSMoveController::loadCalibration") 
+                    << "Unexpected calibration block id(0x" << std::hex << std::setfill('0') << std::setw(2) << cal[1] 
+                    << " on block #" << block_index;
+                is_valid= false;
+            }
+        }
+        else
+        {
+            char hidapi_err_mbs[256];
+            bool valid_error_mesg = hid_error_mbs(handle, hidapi_err_mbs, sizeof(hidapi_err_mbs));
+
+            // Device no longer in valid state.
+            if (valid_error_mesg)
+            {
+                SERVER_LOG_ERROR("PSMoveController::loadCalibration") << "HID ERROR: " << hidapi_err_mbs;
+            }
+
+            is_valid= false;
+        }
+
+        if (is_valid)
+        {
+            memcpy(out_blob+dest_offset, cal+src_offset, sizeof(cal)-src_offset);
+        }
+    }
+
+    return is_valid;
+}
+
+static void
+decodeCalibrationBlob(const unsigned char *blob, PSMoveControllerConfig &cfg)
+{
+    char usb_calibration[PSMOVE_CALIBRATION_BLOB_SIZE];
+
+    memcpy(usb_calibration, blob, PSMOVE_CALIBRATION_BLOB_SIZE);
+    
+    // Convert the calibration blob into constant & offset for each accel dim.
+    std::vector< std::vector<int> > dim_lohi = { {1, 3}, {5, 4}, {2, 0} };
+    std::vector<int> res_lohi(2, 0);
+    int dim_ix = 0;
+    int lohi_ix = 0;
+    for (dim_ix = 0; dim_ix < 3; dim_ix++)
+    {
+        for (lohi_ix = 0; lohi_ix < 2; lohi_ix++)
+        {
+            res_lohi[lohi_ix] = decodeCalibration(usb_calibration, 0x04 + 6*dim_lohi[dim_ix][lohi_ix] + 2*dim_ix);
+        }
+        cfg.cal_ag_xyz_kb[0][dim_ix][0] = 2.f / (float)(res_lohi[1] - res_lohi[0]);
+        cfg.cal_ag_xyz_kb[0][dim_ix][1] = -(cfg.cal_ag_xyz_kb[0][dim_ix][0] * (float)res_lohi[0]) - 1.f;
+    }
+    
+    // Convert the calibration blob into constant for each gyro dim.
+    float factor = (float)(2.0 * M_PI * 80.0) / 60.0f;
+    for (dim_ix = 0; dim_ix < 3; dim_ix++)
+    {
+        cfg.cal_ag_xyz_kb[1][dim_ix][0] = factor / (float)(decodeCalibration(usb_calibration, 0x46 + 10 * dim_ix)
+                                                - decodeCalibration(usb_calibration, 0x2a + 2*dim_ix));
+        // No offset for gyroscope
+    }
+}
+
+// Runs on the calibration cache thread, so it opens its own handles rather than sharing the polled ones
+static bool
+readCalibrationCacheEntry(
+    const std::string &device_path, 
+    const std::string &device_path_addr, 
+    PSMoveCalibrationCacheEntry &out_entry)
+{
+    hid_device *handle = hid_open_path(device_path.c_str());
+    hid_device *handle_addr = device_path_addr.empty() ? nullptr : hid_open_path(device_path_addr.c_str());
+    bool success = (handle != nullptr);
+
+#ifndef __APPLE__
+    // Getting the bt feature report over bt crashes the controller on OSX (see PSMoveController::open)
+    if (success)
+    {
+        success = readBTAddresses(
+            (handle_addr != nullptr) ? handle_addr : handle, 
+            out_entry.host_bt_addr, out_entry.bt_addr);
+    }
+#endif
+
+    if (success)
+    {
+        unsigned char hid_cal[PSMOVE_CALIBRATION_BLOB_SIZE];
+
+        success = readCalibrationBlob(handle, hid_cal);
+        if (success)
+        {
+            out_entry.calibration_blob.assign(hid_cal, hid_cal + PSMOVE_CALIBRATION_BLOB_SIZE);
+        }
+    }
+
+    if (handle_addr != nullptr)
+    {
+        hid_close(handle_addr);
+    }
+
+    if (handle != nullptr)
+    {
+        hid_close(handle);
+    }
+
+    return success;
+}
+
 /* Decode 16-bit signed value from data pointer and offset */
 static int
 psmove_decode_16bit(char *data, int offset)
@@ -6,9 +6,9 @@
 #include "DeviceInterface.h"
 #include "MathUtility.h"
 #include "hidapi.h"
+#include <boost/circular_buffer.hpp>
 #include <string>
 #include <array>
-#include <deque>
 #include <chrono>
 
 struct PSMoveHIDDetails {
@@ -224,6 +224,7 @@ public:
 private:    
     bool getBTAddress(std::string& host, std::string& controller);
     void loadCalibration();                         // Use USB or file if on BT
+    void pollCalibrationCacheValidation();          // Apply anything the background re-read found stale
     
     bool writeDataOut();                            // Setters will call this
     
@@ -231,6 +232,9 @@ private:
     PSMoveControllerConfig cfg;
     PSMoveHIDDetails HIDDetails;
     bool IsBluetooth;                               // true if valid serial number on device opening
+    std::string CalibrationCacheSerial;             // Key into the PSMoveCalibrationCache (bluetooth only)
+    bool bCalibrationCacheValidationPending;        // Waiting on the background re-read of the cached values
+    bool bCalibrationFromCache;                     // cfg calibration was decoded from the cached blob
 
     // Cached Setter State
     unsigned char LedR, LedG, LedB;
@@ -241,7 +245,8 @@ private:
 
     // Read Controller State
     int NextPollSequenceNumber;
-    std::deque<PSMoveControllerState> ControllerStates;
+    ControllerReportClock ReportClock;
+    boost::circular_buffer<PSMoveControllerState> ControllerStates;
     PSMoveDataInput* InData;                        // Buffer to copy hidapi reports into
 };
 #endif // PSMOVE_CONTROLLER_H
\ No newline at end of file
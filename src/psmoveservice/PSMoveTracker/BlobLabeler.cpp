@@ -0,0 +1,288 @@
+// -- includes -----
+#include "BlobLabeler.h"
+#include <climits>
+#include <cstddef>
+
+//-- constants -----
+// Neighbor offsets, counter-clockwise on screen starting East (image y points down)
+static const int k_direction_dx[8] = { 1,  1,  0, -1, -1, -1,  0,  1 };
+static const int k_direction_dy[8] = { 0, -1, -1, -1,  0,  1,  1,  1 };
+
+// Tracing starts on the top-most, left-most pixel as if we had arrived moving South-East
+const int BlobLabeler::k_initial_trace_direction = 7;
+
+//-- prototypes -----
+static void clear_blob_info(BlobInfo &info);
+static void add_run_to_blob_info(BlobInfo &info, int y, int x_start, int x_end);
+static void merge_blob_info(BlobInfo &target, const BlobInfo &source);
+
+//-- public methods -----
+BlobLabeler::BlobLabeler()
+    : m_mask(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_stride(0)
+{
+}
+
+int BlobLabeler::labelMask(const unsigned char *mask, int width, int height, int stride)
+{
+    m_mask = mask;
+    m_width = width;
+    m_height = height;
+    m_stride = stride;
+
+    m_runs.clear();
+    m_label_parents.clear();
+    m_label_info.clear();
+    m_blobs.clear();
+
+    // Runs of the previous row are [prev_begin, prev_end) in m_runs
+    size_t prev_begin = 0;
+    size_t prev_end = 0;
+
+    for (int y = 0; y < height; ++y)
+    {
+        const unsigned char *row = mask + y*stride;
+        const size_t row_begin = m_runs.size();
+        int x = 0;
+
+        while (x < width)
+        {
+            if (row[x] == 0)
+            {
+                ++x;
+                continue;
+            }
+
+            Run run;
+            run.y = y;
+            run.x_start = x;
+            while (x < width && row[x] != 0)
+            {
+                ++x;
+            }
+            run.x_end = x - 1;
+            run.label = -1;
+
+            // Skip previous row runs that end before this one could touch them (8-connected)
+            while (prev_begin < prev_end && m_runs[prev_begin].x_end < run.x_start - 1)
+            {
+                ++prev_begin;
+            }
+
+            // Join every previous row run this one touches
+            for (size_t prev_index = prev_begin;
+                 prev_index < prev_end && m_runs[prev_index].x_start <= run.x_end + 1;
+                 ++prev_index)
+            {
+                run.label =
+                    (run.label < 0)
+                    ? find_root(m_runs[prev_index].label)
+                    : merge_labels(run.label, m_runs[prev_index].label);
+            }
+
+            if (run.label < 0)
+            {
+                run.label = add_label();
+            }
+
+            add_run_to_blob_info(m_label_info[run.label], run.y, run.x_start, run.x_end);
+            m_runs.push_back(run);
+        }
+
+        prev_begin = row_begin;
+        prev_end = m_runs.size();
+    }
+
+    // Every root label is a blob
+    for (int label = 0; label < static_cast<int>(m_label_parents.size()); ++label)
+    {
+        if (m_label_parents[label] == label)
+        {
+            m_blobs.push_back(m_label_info[label]);
+        }
+    }
+
+    return getBlobCount();
+}
+
+int BlobLabeler::findLargestBlob() const
+{
+    int largest_blob_index = -1;
+    int largest_area = 0;
+
+    for (int blob_index = 0; blob_index < getBlobCount(); ++blob_index)
+    {
+        if (m_blobs[blob_index].area > largest_area)
+        {
+            largest_area = m_blobs[blob_index].area;
+            largest_blob_index = blob_index;
+        }
+    }
+
+    return largest_blob_index;
+}
+
+//-- public functions -----
+int selectBlobWorkingScale(int coarse_blob_diameter, int coarse_scale, int min_working_diameter)
+{
+    const int projected_diameter = coarse_blob_diameter * coarse_scale;
+    int scale = coarse_scale;
+
+    while (scale > 1 && projected_diameter / scale < min_working_diameter)
+    {
+        scale /= 2;
+    }
+
+    return scale;
+}
+
+//-- private methods -----
+int BlobLabeler::add_label()
+{
+    const int label = static_cast<int>(m_label_parents.size());
+    BlobInfo info;
+
+    clear_blob_info(info);
+    m_label_parents.push_back(label);
+    m_label_info.push_back(info);
+
+    return label;
+}
+
+int BlobLabeler::find_root(int label)
+{
+    while (m_label_parents[label] != label)
+    {
+        // Path halving
+        m_label_parents[label] = m_label_parents[m_label_parents[label]];
+        label = m_label_parents[label];
+    }
+
+    return label;
+}
+
+int BlobLabeler::merge_labels(int label_a, int label_b)
+{
+    int root_a = find_root(label_a);
+    int root_b = find_root(label_b);
+
+    if (root_a != root_b)
+    {
+        // Keep the older label as the root
+        if (root_b < root_a)
+        {
+            const int temp = root_a;
+            root_a = root_b;
+            root_b = temp;
+        }
+
+        m_label_parents[root_b] = root_a;
+        merge_blob_info(m_label_info[root_a], m_label_info[root_b]);
+    }
+
+    return root_a;
+}
+
+// Moves (x, y) to the next boundary pixel, searching the neighbors
+// counter-clockwise starting from the one after the background pixel we last passed.
+// Returns false if the pixel has no set neighbors.
+bool BlobLabeler::step_boundary(int &x, int &y, int &direction) const
+{
+    const int search_start = (direction % 2 == 0) ? (direction + 7) % 8 : (direction + 6) % 8;
+
+    for (int step = 0; step < 8; ++step)
+    {
+        const int search_direction = (search_start + step) % 8;
+        const int neighbor_x = x + k_direction_dx[search_direction];
+        const int neighbor_y = y + k_direction_dy[search_direction];
+
+        if (is_set(neighbor_x, neighbor_y))
+        {
+            x = neighbor_x;
+            y = neighbor_y;
+            direction = search_direction;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool BlobLabeler::is_set(int x, int y) const
+{
+    return x >= 0 && x < m_width && y >= 0 && y < m_height && m_mask[y*m_stride + x] != 0;
+}
+
+//-- private functions -----
+static void clear_blob_info(BlobInfo &info)
+{
+    info.area = 0;
+    info.min_x = info.min_y = INT_MAX;
+    info.max_x = info.max_y = INT_MIN;
+    info.start_x = info.start_y = -1;
+    info.m10 = info.m01 = 0.0;
+    info.m20 = info.m11 = info.m02 = 0.0;
+}
+
+// Sum of k*k for k in [0, n]
+static double sum_of_squares(int n)
+{
+    const double N = static_cast<double>(n);
+
+    return (n > 0) ? N*(N + 1.0)*(2.0*N + 1.0) / 6.0 : 0.0;
+}
+
+static void add_run_to_blob_info(BlobInfo &info, int y, int x_start, int x_end)
+{
+    const int length = x_end - x_start + 1;
+    const double Y = static_cast<double>(y);
+    const double sum_x = static_cast<double>(length) * static_cast<double>(x_start + x_end) / 2.0;
+
+    if (info.area == 0 || y < info.start_y || (y == info.start_y && x_start < info.start_x))
+    {
+        info.start_x = x_start;
+        info.start_y = y;
+    }
+
+    info.area += length;
+    if (x_start < info.min_x) info.min_x = x_start;
+    if (x_end > info.max_x) info.max_x = x_end;
+    if (y < info.min_y) info.min_y = y;
+    if (y > info.max_y) info.max_y = y;
+
+    info.m10 += sum_x;
+    info.m01 += static_cast<double>(length) * Y;
+    info.m20 += sum_of_squares(x_end) - sum_of_squares(x_start - 1);
+    info.m11 += sum_x * Y;
+    info.m02 += static_cast<double>(length) * Y * Y;
+}
+
+static void merge_blob_info(BlobInfo &target, const BlobInfo &source)
+{
+    if (source.area == 0)
+    {
+        return;
+    }
+
+    if (target.area == 0 ||
+        source.start_y < target.start_y ||
+        (source.start_y == target.start_y && source.start_x < target.start_x))
+    {
+        target.start_x = source.start_x;
+        target.start_y = source.start_y;
+    }
+
+    target.area += source.area;
+    if (source.min_x < target.min_x) target.min_x = source.min_x;
+    if (source.max_x > target.max_x) target.max_x = source.max_x;
+    if (source.min_y < target.min_y) target.min_y = source.min_y;
+    if (source.max_y > target.max_y) target.max_y = source.max_y;
+
+    target.m10 += source.m10;
+    target.m01 += source.m01;
+    target.m20 += source.m20;
+    target.m11 += source.m11;
+    target.m02 += source.m02;
+}
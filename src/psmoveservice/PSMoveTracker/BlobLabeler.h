@@ -0,0 +1,139 @@
+#ifndef BLOB_LABELER_H
+#define BLOB_LABELER_H
+
+// -- includes -----
+#include <vector>
+
+// -- definitions -----
+/// Area, bounds and raw moments of one 8-connected blob in a mask
+struct BlobInfo
+{
+    int area; // pixels
+    int min_x, min_y;
+    int max_x, max_y;
+    int start_x, start_y; // top-most, left-most pixel (where the boundary trace starts)
+    double m10, m01; // sum of x, sum of y
+    double m20, m11, m02; // sum of x*x, x*y, y*y
+
+    inline float getCentroidX() const { return static_cast<float>(m10 / static_cast<double>(area)); }
+    inline float getCentroidY() const { return static_cast<float>(m01 / static_cast<double>(area)); }
+};
+
+/// Single pass, run-length connected component labeler for binary masks.
+/// Each row of the mask is split into runs of set pixels which are joined to
+/// the overlapping runs of the previous row with a union-find, accumulating
+/// each blob's area, bounding box and moments as it goes.
+/// Only the boundary of a blob we actually want gets traced.
+/// All of the working buffers are kept between frames so the steady state doesn't allocate.
+class BlobLabeler
+{
+public:
+    BlobLabeler();
+
+    /// Labels every blob of non-zero pixels in the given 8-bit mask.
+    /// Returns the number of blobs found.
+    int labelMask(const unsigned char *mask, int width, int height, int stride);
+
+    inline int getBlobCount() const { return static_cast<int>(m_blobs.size()); }
+    inline const BlobInfo &getBlob(int blob_index) const { return m_blobs[blob_index]; }
+
+    /// Returns the index of the blob with the most pixels, or -1 if the mask was empty
+    int findLargestBlob() const;
+
+    /// Traces the outer boundary of the given blob in the mask passed to the 
+    /// last labelMask() call into out_boundary (cleared first, capacity kept).
+    /// t_point only needs a (x, y) constructor, e.g. cv::Point.
+    template <typename t_point>
+    void traceBlobBoundary(int blob_index, std::vector<t_point> &out_boundary) const
+    {
+        out_boundary.clear();
+
+        if (blob_index >= 0 && blob_index < getBlobCount())
+        {
+            const BlobInfo &blob = m_blobs[blob_index];
+            int x = blob.start_x;
+            int y = blob.start_y;
+            int direction = k_initial_trace_direction;
+            int second_x = -1, second_y = -1;
+
+            out_boundary.push_back(t_point(x, y));
+
+            // Moore neighbor tracing, stopping once we leave the start pixel 
+            // the same way we did the first time
+            for (;;)
+            {
+                const bool bWasAtStart = (x == blob.start_x && y == blob.start_y);
+
+                if (!step_boundary(x, y, direction))
+                {
+                    // Single pixel blob
+                    break;
+                }
+
+                if (second_x < 0)
+                {
+                    second_x = x;
+                    second_y = y;
+                }
+                else if (bWasAtStart && x == second_x && y == second_y)
+                {
+                    // Drop the repeated start pixel
+                    out_boundary.pop_back();
+                    break;
+                }
+
+                out_boundary.push_back(t_point(x, y));
+            }
+        }
+    }
+
+private:
+    struct Run
+    {
+        int y;
+        int x_start, x_end; // inclusive
+        int label;
+    };
+
+    int add_label();
+    int find_root(int label);
+    int merge_labels(int label_a, int label_b);
+    bool step_boundary(int &x, int &y, int &direction) const;
+    bool is_set(int x, int y) const;
+
+    static const int k_initial_trace_direction;
+
+    // The mask labeled by the last labelMask() call
+    const unsigned char *m_mask;
+    int m_width;
+    int m_height;
+    int m_stride;
+
+    // Reused between frames
+    std::vector<Run> m_runs;
+    std::vector<int> m_label_parents;
+    std::vector<BlobInfo> m_label_info;
+    std::vector<BlobInfo> m_blobs;
+};
+
+/// Picks the resolution a blob found on the coarse pyramid level (1/coarse_scale resolution)
+/// gets refined at: the coarsest power of two scale, up to coarse_scale, that still leaves 
+/// the blob at least min_working_diameter pixels across. Returns 1 for full resolution.
+int selectBlobWorkingScale(int coarse_blob_diameter, int coarse_scale, int min_working_diameter);
+
+/// Maps points traced in a window filtered at 1/scale resolution back into full resolution
+/// frame coordinates. Each point lands on the middle of the block of frame pixels it covers.
+/// t_point only needs x and y members, e.g. cv::Point.
+template <typename t_point>
+void mapWorkingPointsToFrame(int window_x, int window_y, int scale, std::vector<t_point> &points)
+{
+    const int half_pixel = scale / 2;
+
+    for (t_point &p : points)
+    {
+        p.x = window_x + p.x*scale + half_pixel;
+        p.y = window_y + p.y*scale + half_pixel;
+    }
+}
+
+#endif // BLOB_LABELER_H
@@ -15,17 +15,39 @@ static const char *OPTION_FOV_SETTING = "FOV Setting";
 static const char *OPTION_FOV_RED_DOT = "Red Dot";
 static const char *OPTION_FOV_BLUE_DOT = "Blue Dot";
 
+static const char *OPTION_VIDEO_MODE = "Video Mode";
+static const char *OPTION_VIDEO_MODE_VGA_60HZ = "640x480 @ 60Hz";
+static const char *OPTION_VIDEO_MODE_QVGA_120HZ = "320x240 @ 120Hz";
+static const char *OPTION_VIDEO_MODE_QVGA_187HZ = "320x240 @ 187Hz";
+
+// Resolution the stored camera intrinsics are relative to
+static const double k_intrinsics_reference_width = 640.0;
+
+struct PS3EyeVideoModeProperties
+{
+    int width;
+    int height;
+    int frame_rate;
+};
+static const PS3EyeVideoModeProperties k_video_mode_properties[PS3EyeTrackerConfig::eVideoMode::MAX_VIDEO_MODES] = {
+    {640, 480, 60}, // VGA_60Hz
+    {320, 240, 120}, // QVGA_120Hz
+    {320, 240, 187}, // QVGA_187Hz
+};
+
 // -- private definitions -----
 class PSEyeCaptureData
 {
 public:
     PSEyeCaptureData()
         : frame()
+        , ownFrame()
     {
 
     }
 
-    cv::Mat frame;
+    cv::Mat frame; // The last frame captured (may be in the target buffer)
+    cv::Mat ownFrame; // Captured into when there is no target buffer
 };
 
 // -- public methods
@@ -47,6 +69,7 @@ PS3EyeTrackerConfig::PS3EyeTrackerConfig(const std::string &fnamebase)
     , zNear(10.0) // cm
     , zFar(200.0) // cm
     , fovSetting(BlueDot)
+    , videoMode(VGA_60Hz)
 {
     pose.clear();
 
@@ -76,6 +99,7 @@ PS3EyeTrackerConfig::config2ptree()
     pt.put("zNear", zNear);
     pt.put("zFar", zFar);
     pt.put("fovSetting", static_cast<int>(fovSetting));
+    pt.put("videoMode", static_cast<int>(videoMode));
 
     pt.put("pose.orientation.w", pose.Orientation.w);
     pt.put("pose.orientation.x", pose.Orientation.x);
@@ -117,6 +141,14 @@ PS3EyeTrackerConfig::ptree2config(const boost::property_tree::ptree &pt)
         fovSetting = 
             static_cast<PS3EyeTrackerConfig::eFOVSetting>(
                 pt.get<int>("fovSetting", PS3EyeTrackerConfig::eFOVSetting::BlueDot));
+        videoMode =
+            static_cast<PS3EyeTrackerConfig::eVideoMode>(
+                pt.get<int>("videoMode", PS3EyeTrackerConfig::eVideoMode::VGA_60Hz));
+
+        if (videoMode < 0 || videoMode >= PS3EyeTrackerConfig::eVideoMode::MAX_VIDEO_MODES)
+        {
+            videoMode = PS3EyeTrackerConfig::eVideoMode::VGA_60Hz;
+        }
 
         pose.Orientation.w = pt.get<float>("pose.orientation.w", 1.0);
         pose.Orientation.x = pt.get<float>("pose.orientation.x", 0.0);
@@ -221,9 +253,13 @@ PS3EyeTracker::PS3EyeTracker()
     , USBDevicePath()
     , VideoCapture(nullptr)
     , CaptureData(nullptr)
+    , TargetFrameBuffer(nullptr)
     , DriverType(PS3EyeTracker::Libusb)
     , NextPollSequenceNumber(0)
-    , TrackerStates()
+    , TrackerStates(PS3EYE_STATE_BUFFER_MAX)
+    , FrameCaptureTimestamp()
+    , FrameSequenceNumber(-1)
+    , DroppedFrameCount(0)
 {
 }
 
@@ -259,9 +295,10 @@ bool PS3EyeTracker::matchesDeviceEnumerator(const DeviceEnumerator *enumerator)
 
     if (pEnum->get_device_type() == CommonControllerState::PS3EYE)
     {
-        std::string enumerator_path = pEnum->get_path();
+        // Compare in place, this runs for every open device on every enumeration
+        const char *enumerator_path = pEnum->get_path();
 
-        matches = (enumerator_path == USBDevicePath);
+        matches = (enumerator_path != nullptr && USBDevicePath == enumerator_path);
     }
 
     return matches;
@@ -291,6 +328,8 @@ bool PS3EyeTracker::open(const DeviceEnumerator *enumerator)
         {
             CaptureData = new PSEyeCaptureData;
             USBDevicePath = enumerator->get_path();
+            FrameSequenceNumber = -1;
+            DroppedFrameCount = 0;
             bSuccess = true;
         }
         else
@@ -312,10 +351,9 @@ bool PS3EyeTracker::open(const DeviceEnumerator *enumerator)
 		// Load the ps3eye config
         cfg.load();
 		// Save the config back out again in case defaults changed
-		cfg.save();
+		cfg.saveDeferred();
 
-		VideoCapture->set(cv::CAP_PROP_EXPOSURE, cfg.exposure);
-		VideoCapture->set(cv::CAP_PROP_GAIN, cfg.gain);
+        applyVideoMode();
     }
 
     return bSuccess;
@@ -337,8 +375,19 @@ IDeviceInterface::ePollResult PS3EyeTracker::poll()
 
     if (getIsOpen())
     {
+        // Debayer straight into the target buffer if we have one,
+        // otherwise into our own frame (only reallocated if the frame size changes)
+        cv::Mat frame = CaptureData->ownFrame;
+        if (TargetFrameBuffer != nullptr)
+        {
+            int width, height;
+
+            getVideoFrameDimensions(&width, &height, nullptr);
+            frame = cv::Mat(height, width, CV_8UC3, TargetFrameBuffer);
+        }
+
         if (!VideoCapture->grab() || 
-            !VideoCapture->retrieve(CaptureData->frame, cv::CAP_OPENNI_BGR_IMAGE))
+            !VideoCapture->retrieve(frame, cv::CAP_OPENNI_BGR_IMAGE))
         {
             // Device still in valid state
             result = IControllerInterface::_PollResultSuccessNoData;
@@ -347,6 +396,31 @@ IDeviceInterface::ePollResult PS3EyeTracker::poll()
         {
             // New data available. Keep iterating.
             result = IControllerInterface::_PollResultSuccessNewData;
+
+            if (TargetFrameBuffer == nullptr)
+            {
+                CaptureData->ownFrame = frame;
+            }
+            CaptureData->frame = frame;
+
+            // Use the time the capture stamped on the frame if it has one
+            std::chrono::time_point<std::chrono::high_resolution_clock> capture_timestamp;
+            int frame_sequence_number;
+            if (VideoCapture->getLastFrameCaptureInfo(capture_timestamp, frame_sequence_number))
+            {
+                if (FrameSequenceNumber >= 0 && frame_sequence_number > FrameSequenceNumber + 1)
+                {
+                    DroppedFrameCount += frame_sequence_number - FrameSequenceNumber - 1;
+                }
+
+                FrameCaptureTimestamp = capture_timestamp;
+                FrameSequenceNumber = frame_sequence_number;
+            }
+            else
+            {
+                FrameCaptureTimestamp = std::chrono::high_resolution_clock::now();
+                ++FrameSequenceNumber;
+            }
         }
 
         {
@@ -358,13 +432,7 @@ IDeviceInterface::ePollResult PS3EyeTracker::poll()
             newState.PollSequenceNumber = NextPollSequenceNumber;
             ++NextPollSequenceNumber;
 
-            // Make room for new entry if at the max queue size
-            //###bwalker $TODO Make this a fixed size circular buffer
-            if (TrackerStates.size() >= PS3EYE_STATE_BUFFER_MAX)
-            {
-                TrackerStates.erase(TrackerStates.begin(), TrackerStates.begin() + TrackerStates.size() - PS3EYE_STATE_BUFFER_MAX);
-            }
-
+            // Overwrites the oldest entry once the queue is at PS3EYE_STATE_BUFFER_MAX
             TrackerStates.push_back(newState);
         }
     }
@@ -406,6 +474,26 @@ const CommonDeviceState *PS3EyeTracker::getState(int lookBack) const
     return result;
 }
 
+std::chrono::time_point<std::chrono::high_resolution_clock> PS3EyeTracker::getFrameCaptureTimestamp() const
+{
+    return FrameCaptureTimestamp;
+}
+
+int PS3EyeTracker::getFrameSequenceNumber() const
+{
+    return FrameSequenceNumber;
+}
+
+int PS3EyeTracker::getDroppedFrameCount() const
+{
+    return DroppedFrameCount;
+}
+
+double PS3EyeTracker::getFrameRate() const
+{
+    return VideoCapture->get(cv::CAP_PROP_FPS);
+}
+
 ITrackerInterface::eDriverType PS3EyeTracker::getDriverType() const
 {
     //###bwalker $TODO Get the driver type from VideoCapture
@@ -487,11 +575,23 @@ const unsigned char *PS3EyeTracker::getVideoFrameBuffer() const
     return result;
 }
 
+void PS3EyeTracker::setVideoFrameTargetBuffer(unsigned char *buffer)
+{
+    // The old target memory is going away, so forget any frame we captured into it
+    if (buffer == nullptr && TargetFrameBuffer != nullptr && 
+        CaptureData != nullptr && CaptureData->frame.data != CaptureData->ownFrame.data)
+    {
+        CaptureData->frame = cv::Mat();
+    }
+
+    TargetFrameBuffer = buffer;
+}
+
 void PS3EyeTracker::setExposure(double value)
 {
     VideoCapture->set(cv::CAP_PROP_EXPOSURE, value);
     cfg.exposure = value;
-    cfg.save();
+    cfg.saveDeferred();
 }
 
 double PS3EyeTracker::getExposure() const
@@ -503,7 +603,7 @@ void PS3EyeTracker::setGain(double value)
 {
 	VideoCapture->set(cv::CAP_PROP_GAIN, value);
 	cfg.gain = value;
-	cfg.save();
+	cfg.saveDeferred();
 }
 
 double PS3EyeTracker::getGain() const
@@ -515,21 +615,25 @@ void PS3EyeTracker::getCameraIntrinsics(
     float &outFocalLengthX, float &outFocalLengthY,
     float &outPrincipalX, float &outPrincipalY) const
 {
-    outFocalLengthX = static_cast<float>(cfg.focalLengthX);
-    outFocalLengthY = static_cast<float>(cfg.focalLengthY);
-    outPrincipalX = static_cast<float>(cfg.principalX);
-    outPrincipalY = static_cast<float>(cfg.principalY);
+    const float scale = getIntrinsicsScale();
+
+    outFocalLengthX = static_cast<float>(cfg.focalLengthX) * scale;
+    outFocalLengthY = static_cast<float>(cfg.focalLengthY) * scale;
+    outPrincipalX = static_cast<float>(cfg.principalX) * scale;
+    outPrincipalY = static_cast<float>(cfg.principalY) * scale;
 }
 
 void PS3EyeTracker::setCameraIntrinsics(
     float focalLengthX, float focalLengthY,
     float principalX, float principalY)
 {
-    cfg.focalLengthX = focalLengthX;
-    cfg.focalLengthY = focalLengthY;
-    cfg.principalX = principalX;
-    cfg.principalY = principalY;
-    cfg.save();
+    const float scale = getIntrinsicsScale();
+
+    cfg.focalLengthX = focalLengthX / scale;
+    cfg.focalLengthY = focalLengthY / scale;
+    cfg.principalX = principalX / scale;
+    cfg.principalY = principalY / scale;
+    cfg.saveDeferred();
 }
 
 CommonDevicePose PS3EyeTracker::getTrackerPose() const
@@ -541,11 +645,12 @@ void PS3EyeTracker::setTrackerPose(
     const struct CommonDevicePose *pose)
 {
     cfg.pose = *pose;
-    cfg.save();
+    cfg.saveDeferred();
 }
 
 void PS3EyeTracker::getFOV(float &outHFOV, float &outVFOV) const
 {
+    // QVGA reads out the whole sensor at a lower resolution, so the FOV is the same in every video mode
     outHFOV = static_cast<float>(cfg.hfov);
     outVFOV = static_cast<float>(cfg.vfov);
 }
@@ -565,6 +670,14 @@ void PS3EyeTracker::gatherTrackerOptions(
     optionSet->add_option_strings(OPTION_FOV_RED_DOT);
     optionSet->add_option_strings(OPTION_FOV_BLUE_DOT);
     optionSet->set_option_index(static_cast<int>(cfg.fovSetting));
+
+    optionSet = settings->add_option_sets();
+
+    optionSet->set_option_name(OPTION_VIDEO_MODE);
+    optionSet->add_option_strings(OPTION_VIDEO_MODE_VGA_60HZ);
+    optionSet->add_option_strings(OPTION_VIDEO_MODE_QVGA_120HZ);
+    optionSet->add_option_strings(OPTION_VIDEO_MODE_QVGA_187HZ);
+    optionSet->set_option_index(static_cast<int>(cfg.videoMode));
 }
 
 bool PS3EyeTracker::setOptionIndex(
@@ -579,7 +692,18 @@ bool PS3EyeTracker::setOptionIndex(
     {
         cfg.fovSetting = static_cast<PS3EyeTrackerConfig::eFOVSetting>(option_index);
         //###HipsterSloth $TODO Update the focal lengths?
-        cfg.save();
+        cfg.saveDeferred();
+
+        bValidOption = true;
+    }
+    else if (option_name == OPTION_VIDEO_MODE &&
+        option_index >= 0 &&
+        option_index < PS3EyeTrackerConfig::eVideoMode::MAX_VIDEO_MODES)
+    {
+        cfg.videoMode = static_cast<PS3EyeTrackerConfig::eVideoMode>(option_index);
+        cfg.saveDeferred();
+
+        applyVideoMode();
 
         bValidOption = true;
     }
@@ -598,6 +722,11 @@ bool PS3EyeTracker::getOptionIndex(
         out_option_index = static_cast<int>(cfg.fovSetting);
         bValidOption = true;
     }
+    else if (option_name == OPTION_VIDEO_MODE)
+    {
+        out_option_index = static_cast<int>(cfg.videoMode);
+        bValidOption = true;
+    }
 
     return bValidOption;
 }
@@ -632,7 +761,7 @@ void PS3EyeTracker::setTrackingColorPreset(
 	CommonHSVColorRangeTable *table= cfg.getOrAddColorRangeTable(controller_serial);
 
     table->color_presets[color] = *preset;
-    cfg.save();
+    cfg.saveDeferred();
 }
 
 void PS3EyeTracker::getTrackingColorPreset(
@@ -643,4 +772,42 @@ void PS3EyeTracker::getTrackingColorPreset(
 	const CommonHSVColorRangeTable *table= cfg.getColorRangeTable(controller_serial);
 
     *out_preset = table->color_presets[color];
-}
\ No newline at end of file
+}
+
+// -- private methods
+void PS3EyeTracker::applyVideoMode()
+{
+    const PS3EyeVideoModeProperties &mode = k_video_mode_properties[cfg.videoMode];
+
+    // Changing the frame size or rate re-initializes the camera,
+    // so both change in one restart and the sensor settings get re-applied after
+    VideoCapture->setVideoMode(mode.width, mode.height, mode.frame_rate);
+    VideoCapture->set(cv::CAP_PROP_EXPOSURE, cfg.exposure);
+    VideoCapture->set(cv::CAP_PROP_GAIN, cfg.gain);
+
+    const int width = static_cast<int>(VideoCapture->get(cv::CAP_PROP_FRAME_WIDTH));
+    const int height = static_cast<int>(VideoCapture->get(cv::CAP_PROP_FRAME_HEIGHT));
+    const double frame_rate = VideoCapture->get(cv::CAP_PROP_FPS);
+
+    if (width != mode.width || height != mode.height)
+    {
+        SERVER_LOG_WARNING("PS3EyeTracker::applyVideoMode") << "PS3EyeTracker(" << USBDevicePath 
+            << ") driver doesn't support " << mode.width << "x" << mode.height 
+            << ", running at " << width << "x" << height << " @ " << frame_rate << "Hz";
+    }
+    else
+    {
+        SERVER_LOG_INFO("PS3EyeTracker::applyVideoMode") << "PS3EyeTracker(" << USBDevicePath 
+            << ") running at " << width << "x" << height << " @ " << frame_rate << "Hz";
+    }
+
+    // Frame sequence numbers restart with the camera
+    FrameSequenceNumber = -1;
+}
+
+float PS3EyeTracker::getIntrinsicsScale() const
+{
+    const double width = (VideoCapture != nullptr) ? VideoCapture->get(cv::CAP_PROP_FRAME_WIDTH) : 0.0;
+
+    return (width > 0.0) ? static_cast<float>(width / k_intrinsics_reference_width) : 1.f;
+}
@@ -5,9 +5,10 @@
 #include "PSMoveConfig.h"
 #include "DeviceEnumerator.h"
 #include "DeviceInterface.h"
+#include <chrono>
+#include <boost/circular_buffer.hpp>
 #include <string>
 #include <vector>
-#include <deque>
 
 // -- pre-declarations -----
 namespace PSMoveProtocol
@@ -27,6 +28,15 @@ public:
         MAX_FOV_SETTINGS
     };
 
+    enum eVideoMode
+    {
+        VGA_60Hz, // 640x480 @ 60fps
+        QVGA_120Hz, // 320x240 @ 120fps
+        QVGA_187Hz, // 320x240 @ 187fps
+
+        MAX_VIDEO_MODES
+    };
+
     PS3EyeTrackerConfig(const std::string &fnamebase = "PS3EyeTrackerConfig");
     
     virtual const boost::property_tree::ptree config2ptree();
@@ -40,6 +50,7 @@ public:
     long max_poll_failure_count;
     double exposure;
 	double gain;
+    // Camera intrinsics at 640x480, scaled to the resolution of the active video mode
     double focalLengthX;
     double focalLengthY;
     double principalX;
@@ -49,6 +60,7 @@ public:
     double zNear;
     double zFar;
     eFOVSetting fovSetting;
+    eVideoMode videoMode;
     CommonDevicePose pose;
 	CommonHSVColorRangeTable SharedColorPresets;
 	std::vector<CommonHSVColorRangeTable> ControllerColorPresets;
@@ -96,6 +108,11 @@ public:
     std::string getUSBDevicePath() const override;
     bool getVideoFrameDimensions(int *out_width, int *out_height, int *out_stride) const override;
     const unsigned char *getVideoFrameBuffer() const override;
+    void setVideoFrameTargetBuffer(unsigned char *buffer) override;
+    std::chrono::time_point<std::chrono::high_resolution_clock> getFrameCaptureTimestamp() const override;
+    int getFrameSequenceNumber() const override;
+    int getDroppedFrameCount() const override;
+    double getFrameRate() const override;
     void setExposure(double value) override;
     double getExposure() const override;
 	void setGain(double value) override;
@@ -122,14 +139,23 @@ public:
     { return cfg; }
 
 private:
+    void applyVideoMode();
+    float getIntrinsicsScale() const;
+
     PS3EyeTrackerConfig cfg;
     std::string USBDevicePath;
     class PSEyeVideoCapture *VideoCapture;
     class PSEyeCaptureData *CaptureData;
+    unsigned char *TargetFrameBuffer;
     ITrackerInterface::eDriverType DriverType;    
     
     // Read Controller State
     int NextPollSequenceNumber;
-    std::deque<PS3EyeTrackerState> TrackerStates;
+    boost::circular_buffer<PS3EyeTrackerState> TrackerStates;
+
+    // Last video frame capture info
+    std::chrono::time_point<std::chrono::high_resolution_clock> FrameCaptureTimestamp;
+    int FrameSequenceNumber;
+    int DroppedFrameCount;
 };
 #endif // PS3EYE_TRACKER_H
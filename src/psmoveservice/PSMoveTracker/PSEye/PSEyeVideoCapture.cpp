@@ -2,9 +2,16 @@
 #include <opencv2/videoio/videoio.hpp>
 #include <opencv2/videoio/videoio_c.h>
 #include "opencv2/imgproc.hpp"
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #ifdef HAVE_PS3EYE
 #include "ps3eye.h"
+#include <mutex>
+
+// Cameras can be opened on several threads at once, but the PS3EYEDriver
+// device list and its shared USB transfer thread aren't thread safe
+static std::mutex g_ps3eye_driver_mutex;
 #endif
 #ifdef HAVE_CLEYE
 #include "CLEyeMulticam.h"
@@ -48,6 +55,60 @@ public:
     virtual int getCaptureDomain() { return CAP_ANY; } // Return the type of the capture object: CAP_VFW, etc...
 };
 
+/**
+ Stamps every frame a custom capture grabs and gives it a sequence number.
+ The drivers don't tell us when a frame was skipped, so the sequence number advances 
+ by however many frame intervals passed since the previous frame.
+ The timestamp and sequence number are read back through the 
+ CV_CAP_PROP_POS_MSEC and CV_CAP_PROP_POS_FRAMES properties.
+*/
+class PSEyeFrameClock
+{
+public:
+    PSEyeFrameClock()
+        : m_frameSequenceNumber(0)
+        , m_lastFrameTimestamp()
+    {
+    }
+
+    void reset()
+    {
+        m_frameSequenceNumber = 0;
+        m_lastFrameTimestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+    }
+
+    void stampFrame(double frameRate)
+    {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+        int framesElapsed = 1;
+
+        if (m_frameSequenceNumber > 0 && frameRate > 0.0)
+        {
+            const std::chrono::duration<double> timeSinceLastFrame = now - m_lastFrameTimestamp;
+            const int roundedFramesElapsed = static_cast<int>(std::floor(timeSinceLastFrame.count() * frameRate + 0.5));
+
+            framesElapsed = (roundedFramesElapsed > 1) ? roundedFramesElapsed : 1;
+        }
+
+        m_frameSequenceNumber += framesElapsed;
+        m_lastFrameTimestamp = now;
+    }
+
+    double getTimestampMsec() const
+    {
+        return std::chrono::duration<double, std::milli>(m_lastFrameTimestamp.time_since_epoch()).count();
+    }
+
+    double getFrameSequenceNumber() const
+    {
+        return static_cast<double>(m_frameSequenceNumber);
+    }
+
+private:
+    int m_frameSequenceNumber;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_lastFrameTimestamp;
+};
+
 /*
 -- Camera-specific implementations of cv::IVideoCapture --
  Examples
@@ -110,6 +171,10 @@ public:
             return 0;
         case CV_CAP_PROP_SHARPNESS:
             return 0;
+        case CV_CAP_PROP_POS_MSEC:
+            return m_frameClock.getTimestampMsec();
+        case CV_CAP_PROP_POS_FRAMES:
+            return m_frameClock.getFrameSequenceNumber();
         }
         return 0;
     }
@@ -167,6 +232,8 @@ public:
     bool retrieveFrame(int channel, cv::OutputArray outArray)
     {
         CLEyeCameraGetFrame(m_eye, pCapBuffer, 33);
+        m_frameClock.stampFrame(60.0);
+
         const int from_to[] = { 0, 0, 1, 1, 2, 2 };
         const CvArr** src = (const CvArr**)&m_frame4ch;
         CvArr** dst = (CvArr**)&m_frame;
@@ -228,6 +295,7 @@ protected:
             CLEyeCameraStart(m_eye);
             CLEyeSetCameraParameter(m_eye, CLEYE_AUTO_EXPOSURE, false);
             CLEyeSetCameraParameter(m_eye, CLEYE_AUTO_GAIN, false);
+            m_frameClock.reset();
             m_index = _index;
         }
         return isOpened();
@@ -251,6 +319,7 @@ protected:
     IplImage* m_frame;
     IplImage* m_frame4ch;
     CLEyeCameraInstance m_eye;
+    PSEyeFrameClock m_frameClock;
 };
 
 // We don't need an implementation for CL EYE Driver because
@@ -300,6 +369,10 @@ public:
         case CV_CAP_PROP_SHARPNESS:
             // [0, 63] -> [0, 255]
             return (double)(eye->getSharpness())*256.0 / 64.0;
+        case CV_CAP_PROP_POS_MSEC:
+            return m_frameClock.getTimestampMsec();
+        case CV_CAP_PROP_POS_FRAMES:
+            return m_frameClock.getFrameSequenceNumber();
         }
         return 0;
     }
@@ -322,12 +395,19 @@ public:
         case CV_CAP_PROP_EXPOSURE:
             // [0, 255] [120]
             eye->setExposure((int)round(value));
+            break;
         case CV_CAP_PROP_FPS:
-            return false; //TODO: Modifying FPS probably requires resetting the camera
+            // The driver rounds to the nearest rate the current resolution supports
+            return restart(m_width, m_height, (int)round(value));
         case CV_CAP_PROP_FRAME_HEIGHT:
-            return false; //TODO: Modifying frame size probably requires resetting the camera
+            // Only 640x480 (VGA) and 320x240 (QVGA) are supported
+            return (value <= 240) 
+                ? restart(320, 240, eye->getFrameRate())
+                : restart(640, 480, eye->getFrameRate());
         case CV_CAP_PROP_FRAME_WIDTH:
-            return false;
+            return (value <= 320) 
+                ? restart(320, 240, eye->getFrameRate())
+                : restart(640, 480, eye->getFrameRate());
         case CV_CAP_PROP_GAIN:
             // [0, 255] -> [0, 63] [20]
             val = (int)(value * 64.0 / 256.0);
@@ -348,13 +428,21 @@ public:
 
     bool grabFrame()
     {
-        return eye->isStreaming();
+        if (!eye->isStreaming())
+        {
+            return false;
+        }
+
+        // getFrame() hands over the frame the driver's USB transfer callback queued up,
+        // so stamp the frame as soon as we have it and leave the debayering to retrieveFrame()
+        eye->getFrame(m_MatBayer.data);
+        m_frameClock.stampFrame(static_cast<double>(eye->getFrameRate()));
+
+        return true;
     }
 
     bool retrieveFrame(int outputType, cv::OutputArray outArray)
     {
-        eye->getFrame(m_MatBayer.data);
-
         cv::cvtColor(m_MatBayer, outArray, CV_BayerGB2BGR);
         return true;
     }
@@ -368,6 +456,20 @@ public:
         return (m_index != -1);
     }
 
+    // Only 640x480 (VGA) and 320x240 (QVGA) are supported.
+    // The driver rounds the frame rate to the nearest one the resolution supports.
+    bool setVideoMode(int width, int height, int frame_rate)
+    {
+        if (!eye)
+        {
+            return false;
+        }
+
+        return (width <= 320 && height <= 240)
+            ? restart(320, 240, frame_rate)
+            : restart(640, 480, frame_rate);
+    }
+
     std::string getUniqueIndentifier() const
     {
         std::string identifier = "ps3eye_";
@@ -390,7 +492,11 @@ protected:
     bool open(int _index)
     {
         // Enumerate libusb devices
-        std::vector<ps3eye::PS3EYECam::PS3EYERef> devices = ps3eye::PS3EYECam::getDevices();
+        std::vector<ps3eye::PS3EYECam::PS3EYERef> devices;
+        {
+            std::lock_guard<std::mutex> lock(g_ps3eye_driver_mutex);
+            devices = ps3eye::PS3EYECam::getDevices();
+        }
         std::cout << "ps3eye::PS3EYECam::getDevices() found " << devices.size() << " devices." << std::endl;
         
         if (devices.size() > (unsigned int)_index) {
@@ -401,11 +507,15 @@ protected:
             {
                 // Change any default settings here
                 
-                eye->start();
+                {
+                    std::lock_guard<std::mutex> lock(g_ps3eye_driver_mutex);
+                    eye->start();
+                }
                 
                 eye->setAutogain(false);
                 eye->setAutoWhiteBalance(false);
                 
+                m_frameClock.reset();
                 m_index = _index;
                 refreshDimensions();
                 
@@ -420,6 +530,38 @@ protected:
         // eye will close itself when going out of scope.
         m_index = -1;
     }
+
+    // Frame size and rate can only be changed by re-initializing the camera
+    bool restart(int width, int height, int frame_rate)
+    {
+        if (width == m_width && height == m_height && frame_rate == (int)eye->getFrameRate())
+        {
+            return true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(g_ps3eye_driver_mutex);
+            eye->stop();
+        }
+
+        if (!eye->init(width, height, frame_rate, ps3eye::PS3EYECam::EOutputFormat::Bayer))
+        {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(g_ps3eye_driver_mutex);
+            eye->start();
+        }
+
+        eye->setAutogain(false);
+        eye->setAutoWhiteBalance(false);
+
+        m_frameClock.reset();
+        refreshDimensions();
+
+        return true;
+    }
     
     void refreshDimensions()
     {
@@ -434,6 +576,7 @@ protected:
     size_t m_size;
     cv::Mat m_MatBayer;
     ps3eye::PS3EYECam::PS3EYERef eye;
+    PSEyeFrameClock m_frameClock;
 };
 
 #endif
@@ -596,11 +739,67 @@ double PSEyeVideoCapture::get(int propId) const
     return cv::VideoCapture::get(propId);
 }
 
+bool PSEyeVideoCapture::setVideoMode(int width, int height, int frame_rate)
+{
+#ifdef HAVE_PS3EYE
+    if (!icap.empty() && icap->getCaptureDomain() == PSEYE_CAP_PS3EYE)
+    {
+        return icap.dynamicCast<PSEYECaptureCAM_PS3EYE>()->setVideoMode(width, height, frame_rate);
+    }
+#endif
+
+    const bool bSizeSet = set(CV_CAP_PROP_FRAME_WIDTH, width) && set(CV_CAP_PROP_FRAME_HEIGHT, height);
+    const bool bRateSet = set(CV_CAP_PROP_FPS, frame_rate);
+
+    return bSizeSet && bRateSet;
+}
+
 std::string PSEyeVideoCapture::getUniqueIndentifier() const
 {
     return m_indentifier;
 }
 
+bool PSEyeVideoCapture::getLastFrameCaptureInfo(
+    std::chrono::time_point<std::chrono::high_resolution_clock> &out_capture_timestamp,
+    int &out_frame_sequence_number) const
+{
+    bool bSuccess = false;
+
+#if defined(HAVE_CLEYE) || defined(HAVE_PS3EYE)
+    // Only our own captures stamp frames. 
+    // The native OpenCV captures use these properties for file playback position.
+    if (!icap.empty())
+    {
+        const int domain = icap->getCaptureDomain();
+
+        if (
+#ifdef HAVE_CLEYE
+            domain == PSEYE_CAP_CLMULTI ||
+#endif
+#ifdef HAVE_PS3EYE
+            domain == PSEYE_CAP_PS3EYE ||
+#endif
+            false)
+        {
+            const double frame_sequence_number = icap->getProperty(CV_CAP_PROP_POS_FRAMES);
+
+            if (frame_sequence_number > 0.0)
+            {
+                const std::chrono::duration<double, std::milli> capture_msec(icap->getProperty(CV_CAP_PROP_POS_MSEC));
+
+                out_capture_timestamp = 
+                    std::chrono::time_point<std::chrono::high_resolution_clock>(
+                        std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(capture_msec));
+                out_frame_sequence_number = static_cast<int>(frame_sequence_number);
+                bSuccess = true;
+            }
+        }
+    }
+#endif
+
+    return bSuccess;
+}
+
 cv::Ptr<cv::IVideoCapture> PSEyeVideoCapture::pseyeVideoCapture_create(int index)
 {
     // https://github.com/Itseez/opencv/blob/09e6c82190b558e74e2e6a53df09844665443d6d/modules/videoio/src/cap.cpp#L432
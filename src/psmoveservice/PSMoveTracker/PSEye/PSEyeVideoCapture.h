@@ -2,6 +2,7 @@
 #define PSEYE_VIDEO_CAPTURE_H
 
 #include <opencv2/videoio.hpp>
+#include <chrono>
 
 /// Video capture class that prioritizes PS3 Eye devices.
 /**
@@ -46,8 +47,25 @@ public:
     /// Use cv::VideoCapture::get() unless \ref eyeType == PSEYE_CLEYE_DRIVER
     double get(int propId) const override;
 
+    /// Change the frame size and frame rate together.
+    /**
+    The PS3EYEDriver capture has to re-initialize the camera to change either one,
+    so this does both in a single restart instead of one per cv::VideoCapture::set() call.
+    Other captures fall back to setting the width and then the frame rate.
+    */
+    bool setVideoMode(int width, int height, int frame_rate);
+
     /// Get the unique identifier for the camera
     std::string getUniqueIndentifier() const;
+
+    /// Get the capture time and sequence number of the last grabbed frame.
+    /**
+    Only available for the PS3EYEDriver and CL Eye MultiCam captures.
+    Returns false for the native OpenCV capture.
+    */
+    bool getLastFrameCaptureInfo(
+        std::chrono::time_point<std::chrono::high_resolution_clock> &out_capture_timestamp,
+        int &out_frame_sequence_number) const;
     
 protected:
     int m_index; /**< Keep track of index. Necessary for PSEYE_CLEYE_DRIVER */
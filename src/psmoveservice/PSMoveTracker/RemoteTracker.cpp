@@ -0,0 +1,532 @@
+// -- includes -----
+#include "RemoteTracker.h"
+#include "ServerLog.h"
+#include "ServerUtility.h"
+#include "PSMoveProtocol.pb.h"
+#include "TrackerDeviceEnumerator.h"
+#include <cctype>
+#include <cstring>
+
+// -- constants -----
+// A tracker node that hasn't sent a frame in this long is considered disconnected
+static const int k_remote_tracker_timeout_ms = 2000;
+
+// -- Remote Tracker Config
+const int RemoteTrackerConfig::CONFIG_VERSION = 1;
+
+RemoteTrackerConfig::RemoteTrackerConfig(const std::string &fnamebase)
+    : PSMoveConfig(fnamebase)
+    , is_valid(false)
+    , version(CONFIG_VERSION)
+    , max_poll_failure_count(100)
+{
+    pose.clear();
+};
+
+const boost::property_tree::ptree
+RemoteTrackerConfig::config2ptree()
+{
+    boost::property_tree::ptree pt;
+
+    pt.put("is_valid", is_valid);
+    pt.put("version", RemoteTrackerConfig::CONFIG_VERSION);
+    pt.put("max_poll_failure_count", max_poll_failure_count);
+
+    pt.put("pose.orientation.w", pose.Orientation.w);
+    pt.put("pose.orientation.x", pose.Orientation.x);
+    pt.put("pose.orientation.y", pose.Orientation.y);
+    pt.put("pose.orientation.z", pose.Orientation.z);
+    pt.put("pose.position.x", pose.Position.x);
+    pt.put("pose.position.y", pose.Position.y);
+    pt.put("pose.position.z", pose.Position.z);
+
+    return pt;
+}
+
+void
+RemoteTrackerConfig::ptree2config(const boost::property_tree::ptree &pt)
+{
+    version = pt.get<int>("version", 0);
+
+    if (version == RemoteTrackerConfig::CONFIG_VERSION)
+    {
+        is_valid = pt.get<bool>("is_valid", false);
+        max_poll_failure_count = pt.get<long>("max_poll_failure_count", 100);
+
+        pose.Orientation.w = pt.get<float>("pose.orientation.w", 1.0);
+        pose.Orientation.x = pt.get<float>("pose.orientation.x", 0.0);
+        pose.Orientation.y = pt.get<float>("pose.orientation.y", 0.0);
+        pose.Orientation.z = pt.get<float>("pose.orientation.z", 0.0);
+        pose.Position.x = pt.get<float>("pose.position.x", 0.0);
+        pose.Position.y = pt.get<float>("pose.position.y", 0.0);
+        pose.Position.z = pt.get<float>("pose.position.z", 0.0);
+    }
+    else
+    {
+        SERVER_LOG_WARNING("RemoteTrackerConfig") <<
+            "Config version " << version << " does not match expected version " <<
+            RemoteTrackerConfig::CONFIG_VERSION << ", Using defaults.";
+    }
+}
+
+// -- Remote Tracker Frame
+void
+RemoteTrackerFrame::makeDevicePath(const std::string &node_name, int node_tracker_id, std::string &out_device_path)
+{
+    char path[256];
+
+    ServerUtility::format_string(path, sizeof(path), "remote://%s/%d", node_name.c_str(), node_tracker_id);
+
+    out_device_path.assign(path);
+}
+
+// -- Remote Tracker Registry
+RemoteTrackerRegistry *
+RemoteTrackerRegistry::getInstance()
+{
+    static RemoteTrackerRegistry g_registry;
+
+    return &g_registry;
+}
+
+RemoteTrackerRegistry::RemoteTrackerRegistry()
+    : m_frame_mutex()
+    , m_latest_frames()
+{
+}
+
+bool
+RemoteTrackerRegistry::submitFrame(const RemoteTrackerFrame &frame)
+{
+    std::lock_guard<std::mutex> lock(m_frame_mutex);
+    bool bIsNewTracker = false;
+
+    auto iter = m_latest_frames.find(frame.device_path);
+    if (iter != m_latest_frames.end())
+    {
+        // A tracker that went quiet long enough to get closed counts as new again
+        bIsNewTracker = isFrameStale(iter->second);
+
+        // Throw out frames that arrived out of order
+        if (bIsNewTracker || frame.frame_id > iter->second.frame_id)
+        {
+            iter->second = frame;
+        }
+    }
+    else
+    {
+        m_latest_frames.insert(std::make_pair(frame.device_path, frame));
+        bIsNewTracker = true;
+    }
+
+    return bIsNewTracker;
+}
+
+bool
+RemoteTrackerRegistry::getLatestFrame(const std::string &device_path, RemoteTrackerFrame &out_frame) const
+{
+    std::lock_guard<std::mutex> lock(m_frame_mutex);
+    bool bFound = false;
+
+    auto iter = m_latest_frames.find(device_path);
+    if (iter != m_latest_frames.end())
+    {
+        out_frame = iter->second;
+        bFound = true;
+    }
+
+    return bFound;
+}
+
+void
+RemoteTrackerRegistry::removeTracker(const std::string &device_path)
+{
+    std::lock_guard<std::mutex> lock(m_frame_mutex);
+
+    m_latest_frames.erase(device_path);
+}
+
+void
+RemoteTrackerRegistry::getActiveDevicePaths(std::vector<std::string> &out_device_paths) const
+{
+    std::lock_guard<std::mutex> lock(m_frame_mutex);
+
+    for (auto iter = m_latest_frames.begin(); iter != m_latest_frames.end(); ++iter)
+    {
+        if (!isFrameStale(iter->second))
+        {
+            out_device_paths.push_back(iter->first);
+        }
+    }
+}
+
+bool
+RemoteTrackerRegistry::isFrameStale(const RemoteTrackerFrame &frame) const
+{
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<double, std::milli> frame_age = now - frame.receive_timestamp;
+
+    return frame_age.count() > k_remote_tracker_timeout_ms;
+}
+
+// -- Remote Tracker
+RemoteTracker::RemoteTracker()
+    : cfg()
+    , DevicePath()
+    , bIsOpen(false)
+    , LatestFrame()
+    , TrackerState()
+    , DroppedFrameCount(0)
+{
+}
+
+RemoteTracker::~RemoteTracker()
+{
+    if (getIsOpen())
+    {
+        SERVER_LOG_ERROR("~RemoteTracker") << "Tracker deleted without calling close() first!";
+    }
+}
+
+// -- IDeviceInterface
+bool RemoteTracker::matchesDeviceEnumerator(const DeviceEnumerator *enumerator) const
+{
+    // Down-cast the enumerator so we can use the correct get_path.
+    const TrackerDeviceEnumerator *pEnum = static_cast<const TrackerDeviceEnumerator *>(enumerator);
+
+    bool matches = false;
+
+    if (pEnum->get_device_type() == CommonDeviceState::RemoteTracker)
+    {
+        // Compare in place, this runs for every open device on every enumeration
+        const char *enumerator_path = pEnum->get_path();
+
+        matches = (enumerator_path != nullptr && DevicePath == enumerator_path);
+    }
+
+    return matches;
+}
+
+bool RemoteTracker::open(const DeviceEnumerator *enumerator)
+{
+    const char *cur_dev_path = enumerator->get_path();
+    bool bSuccess = false;
+
+    if (getIsOpen())
+    {
+        SERVER_LOG_WARNING("RemoteTracker::open") << "RemoteTracker(" << cur_dev_path << ") already open. Ignoring request.";
+        bSuccess = true;
+    }
+    else
+    {
+        SERVER_LOG_INFO("RemoteTracker::open") << "Opening RemoteTracker(" << cur_dev_path << ")";
+
+        // Can't open the tracker until we know the camera properties the node is using
+        if (RemoteTrackerRegistry::getInstance()->getLatestFrame(cur_dev_path, LatestFrame))
+        {
+            DevicePath = cur_dev_path;
+            bIsOpen = true;
+            bSuccess = true;
+        }
+        else
+        {
+            SERVER_LOG_ERROR("RemoteTracker::open") << "No frames received from RemoteTracker(" << cur_dev_path << ")";
+        }
+    }
+
+    if (bSuccess)
+    {
+        // Turn the device path into something that can be used as a file name
+        std::string config_name = "RemoteTrackerConfig_";
+        for (const char *c = cur_dev_path + strlen("remote://"); *c != '\0'; ++c)
+        {
+            config_name.push_back(isalnum(*c) ? *c : '_');
+        }
+
+        cfg = RemoteTrackerConfig(config_name);
+
+        // Load the remote tracker config
+        cfg.load();
+        // Save the config back out again in case defaults changed
+        cfg.saveDeferred();
+    }
+
+    return bSuccess;
+}
+
+bool RemoteTracker::getIsOpen() const
+{
+    return bIsOpen;
+}
+
+bool RemoteTracker::getIsReadyToPoll() const
+{
+    return getIsOpen();
+}
+
+IDeviceInterface::ePollResult RemoteTracker::poll()
+{
+    IDeviceInterface::ePollResult result = IDeviceInterface::_PollResultFailure;
+
+    if (getIsOpen())
+    {
+        const int last_frame_id = LatestFrame.frame_id;
+
+        if (RemoteTrackerRegistry::getInstance()->getLatestFrame(DevicePath, LatestFrame) &&
+            LatestFrame.frame_id != last_frame_id)
+        {
+            // New data available
+            result = IDeviceInterface::_PollResultSuccessNewData;
+
+            // Frame ids the tracker node skipped (or that were lost on the network) were dropped
+            if (last_frame_id >= 0 && LatestFrame.frame_id > last_frame_id + 1)
+            {
+                DroppedFrameCount += LatestFrame.frame_id - last_frame_id - 1;
+            }
+
+            TrackerState.PollSequenceNumber = LatestFrame.frame_id;
+        }
+        else
+        {
+            // Device still in valid state.
+            // Closed by the ServerTrackerView if the tracker node stays quiet for too long.
+            result = IDeviceInterface::_PollResultSuccessNoData;
+        }
+    }
+
+    return result;
+}
+
+void RemoteTracker::close()
+{
+    if (getIsOpen())
+    {
+        RemoteTrackerRegistry::getInstance()->removeTracker(DevicePath);
+    }
+
+    DevicePath.clear();
+    LatestFrame.observations.clear();
+    LatestFrame.frame_id = -1;
+    DroppedFrameCount = 0;
+    bIsOpen = false;
+}
+
+long RemoteTracker::getMaxPollFailureCount() const
+{
+    return cfg.max_poll_failure_count;
+}
+
+CommonDeviceState::eDeviceType RemoteTracker::getDeviceType() const
+{
+    return CommonDeviceState::RemoteTracker;
+}
+
+const CommonDeviceState *RemoteTracker::getState(int lookBack) const
+{
+    return (lookBack == 0) ? &TrackerState : nullptr;
+}
+
+// -- ITrackerInterface
+ITrackerInterface::eDriverType RemoteTracker::getDriverType() const
+{
+    return ITrackerInterface::Network;
+}
+
+std::string RemoteTracker::getUSBDevicePath() const
+{
+    return DevicePath;
+}
+
+bool RemoteTracker::getVideoFrameDimensions(
+    int *out_width,
+    int *out_height,
+    int *out_stride) const
+{
+    if (out_width != nullptr)
+    {
+        *out_width = LatestFrame.pixel_width;
+    }
+
+    if (out_height != nullptr)
+    {
+        *out_height = LatestFrame.pixel_height;
+    }
+
+    if (out_stride != nullptr)
+    {
+        // Tracker nodes capture BGR frames
+        *out_stride = 3 * LatestFrame.pixel_width;
+    }
+
+    return getIsOpen();
+}
+
+const unsigned char *RemoteTracker::getVideoFrameBuffer() const
+{
+    // Video frames never leave the tracker node
+    return nullptr;
+}
+
+void RemoteTracker::setVideoFrameTargetBuffer(unsigned char *buffer)
+{
+    // No video frames to write
+}
+
+std::chrono::time_point<std::chrono::high_resolution_clock> RemoteTracker::getFrameCaptureTimestamp() const
+{
+    // The capture time the tracker node sends is on its own clock,
+    // so the best we can do locally is when the frame arrived
+    return LatestFrame.receive_timestamp;
+}
+
+int RemoteTracker::getFrameSequenceNumber() const
+{
+    return LatestFrame.frame_id;
+}
+
+int RemoteTracker::getDroppedFrameCount() const
+{
+    return DroppedFrameCount;
+}
+
+double RemoteTracker::getFrameRate() const
+{
+    // The node decides how fast it streams
+    return 0.0;
+}
+
+void RemoteTracker::setExposure(double value)
+{
+    SERVER_LOG_WARNING("RemoteTracker::setExposure") << "Exposure is set on the tracker node for " << DevicePath;
+}
+
+double RemoteTracker::getExposure() const
+{
+    return 0.0;
+}
+
+void RemoteTracker::setGain(double value)
+{
+    SERVER_LOG_WARNING("RemoteTracker::setGain") << "Gain is set on the tracker node for " << DevicePath;
+}
+
+double RemoteTracker::getGain() const
+{
+    return 0.0;
+}
+
+void RemoteTracker::getCameraIntrinsics(
+    float &outFocalLengthX, float &outFocalLengthY,
+    float &outPrincipalX, float &outPrincipalY) const
+{
+    outFocalLengthX = LatestFrame.focal_length_x;
+    outFocalLengthY = LatestFrame.focal_length_y;
+    outPrincipalX = LatestFrame.principal_x;
+    outPrincipalY = LatestFrame.principal_y;
+}
+
+void RemoteTracker::setCameraIntrinsics(
+    float focalLengthX, float focalLengthY,
+    float principalX, float principalY)
+{
+    // The tracker node computes its observations with its own intrinsics
+    SERVER_LOG_WARNING("RemoteTracker::setCameraIntrinsics") << "Camera intrinsics are set on the tracker node for " << DevicePath;
+}
+
+CommonDevicePose RemoteTracker::getTrackerPose() const
+{
+    return cfg.pose;
+}
+
+void RemoteTracker::setTrackerPose(
+    const struct CommonDevicePose *pose)
+{
+    cfg.pose = *pose;
+    cfg.saveDeferred();
+}
+
+void RemoteTracker::getFOV(float &outHFOV, float &outVFOV) const
+{
+    outHFOV = LatestFrame.hfov;
+    outVFOV = LatestFrame.vfov;
+}
+
+void RemoteTracker::getZRange(float &outZNear, float &outZFar) const
+{
+    outZNear = LatestFrame.znear;
+    outZFar = LatestFrame.zfar;
+}
+
+void RemoteTracker::gatherTrackerOptions(
+    PSMoveProtocol::Response_ResultTrackerSettings* settings) const
+{
+    // No options are adjustable from the central service
+}
+
+bool RemoteTracker::setOptionIndex(
+    const std::string &option_name,
+    int option_index)
+{
+    return false;
+}
+
+bool RemoteTracker::getOptionIndex(
+    const std::string &option_name,
+    int &out_option_index) const
+{
+    return false;
+}
+
+void RemoteTracker::gatherTrackingColorPresets(
+    const std::string &controller_serial,
+    PSMoveProtocol::Response_ResultTrackerSettings* settings) const
+{
+    // The real presets live on the tracker node, so just report the defaults
+    for (int list_index = 0; list_index < MAX_TRACKING_COLOR_TYPES; ++list_index)
+    {
+        const CommonHSVColorRange &hsvRange = k_default_color_presets[list_index];
+        const eCommonTrackingColorID colorType = static_cast<eCommonTrackingColorID>(list_index);
+
+        PSMoveProtocol::TrackingColorPreset *colorPreset= settings->add_color_presets();
+        colorPreset->set_color_type(static_cast<PSMoveProtocol::TrackingColorType>(colorType));
+        colorPreset->set_hue_center(hsvRange.hue_range.center);
+        colorPreset->set_hue_range(hsvRange.hue_range.range);
+        colorPreset->set_saturation_center(hsvRange.saturation_range.center);
+        colorPreset->set_saturation_range(hsvRange.saturation_range.range);
+        colorPreset->set_value_center(hsvRange.value_range.center);
+        colorPreset->set_value_range(hsvRange.value_range.range);
+    }
+}
+
+void RemoteTracker::setTrackingColorPreset(
+    const std::string &controller_serial,
+    eCommonTrackingColorID color,
+    const CommonHSVColorRange *preset)
+{
+    SERVER_LOG_WARNING("RemoteTracker::setTrackingColorPreset") << "Color presets are set on the tracker node for " << DevicePath;
+}
+
+void RemoteTracker::getTrackingColorPreset(
+    const std::string &controller_serial,
+    eCommonTrackingColorID color,
+    CommonHSVColorRange *out_preset) const
+{
+    *out_preset = k_default_color_presets[color];
+}
+
+const RemoteTrackerObservation *
+RemoteTracker::findObservation(eCommonTrackingColorID tracking_color_id) const
+{
+    const RemoteTrackerObservation *result = nullptr;
+
+    for (const RemoteTrackerObservation &observation : LatestFrame.observations)
+    {
+        if (observation.tracking_color_id == tracking_color_id)
+        {
+            result = &observation;
+            break;
+        }
+    }
+
+    return result;
+}
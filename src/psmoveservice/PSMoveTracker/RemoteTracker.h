@@ -0,0 +1,193 @@
+#ifndef REMOTE_TRACKER_H
+#define REMOTE_TRACKER_H
+
+// -- includes -----
+#include "PSMoveConfig.h"
+#include "DeviceEnumerator.h"
+#include "DeviceInterface.h"
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// -- pre-declarations -----
+namespace PSMoveProtocol
+{
+    class Response_ResultTrackerSettings;
+};
+
+// -- definitions -----
+class RemoteTrackerConfig : public PSMoveConfig
+{
+public:
+    RemoteTrackerConfig(const std::string &fnamebase = "RemoteTrackerConfig");
+
+    virtual const boost::property_tree::ptree config2ptree();
+    virtual void ptree2config(const boost::property_tree::ptree &pt);
+
+    bool is_valid;
+    long version;
+    long max_poll_failure_count;
+    CommonDevicePose pose;
+
+    static const int CONFIG_VERSION;
+};
+
+/// The tracker relative pose of one tracking blob seen by a tracker node
+struct RemoteTrackerObservation
+{
+    eCommonTrackingColorID tracking_color_id;
+    CommonDevicePosition position;
+    CommonDeviceQuaternion orientation;
+    bool bOrientationValid;
+    CommonDeviceTrackingProjection projection;
+};
+
+/// Everything a tracker node sent about a single video frame
+struct RemoteTrackerFrame
+{
+    std::string device_path;
+    int frame_id;
+    long long capture_timestamp_usec;
+    std::chrono::time_point<std::chrono::high_resolution_clock> receive_timestamp;
+
+    int pixel_width;
+    int pixel_height;
+    float focal_length_x, focal_length_y;
+    float principal_x, principal_y;
+    float hfov, vfov;
+    float znear, zfar;
+
+    std::vector<RemoteTrackerObservation> observations;
+
+    RemoteTrackerFrame()
+        : device_path()
+        , frame_id(-1)
+        , capture_timestamp_usec(0)
+        , receive_timestamp()
+        , pixel_width(0), pixel_height(0)
+        , focal_length_x(0.f), focal_length_y(0.f)
+        , principal_x(0.f), principal_y(0.f)
+        , hfov(0.f), vfov(0.f)
+        , znear(0.f), zfar(0.f)
+        , observations()
+    {}
+
+    /// Writes into out_device_path so a reused frame keeps its string storage
+    static void makeDevicePath(const std::string &node_name, int node_tracker_id, std::string &out_device_path);
+};
+
+/// Holds the most recent frame received from every remote tracker.
+/// Frames are written by the request handler on the main thread
+/// and the device list is read by the tracker enumerator on the device enumeration thread.
+class RemoteTrackerRegistry
+{
+public:
+    static RemoteTrackerRegistry *getInstance();
+
+    /// Returns true if this frame came from a tracker that wasn't already streaming
+    bool submitFrame(const RemoteTrackerFrame &frame);
+
+    /// Returns false if nothing has been received from the given tracker
+    bool getLatestFrame(const std::string &device_path, RemoteTrackerFrame &out_frame) const;
+
+    /// Drops the frame state for a tracker that was closed,
+    /// so that the next frame it sends gets it reopened
+    void removeTracker(const std::string &device_path);
+
+    /// Appends the device paths of all remote trackers that have sent a frame recently
+    void getActiveDevicePaths(std::vector<std::string> &out_device_paths) const;
+
+private:
+    RemoteTrackerRegistry();
+
+    bool isFrameStale(const RemoteTrackerFrame &frame) const;
+
+    mutable std::mutex m_frame_mutex;
+    std::map<std::string, RemoteTrackerFrame> m_latest_frames;
+};
+
+struct RemoteTrackerState : public CommonDeviceState
+{
+    RemoteTrackerState()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        CommonDeviceState::clear();
+        DeviceType = CommonDeviceState::RemoteTracker;
+    }
+};
+
+/// A tracking camera attached to a tracker node on another machine.
+/// The tracker node runs the blob tracking and only sends over the resulting observations.
+class RemoteTracker : public ITrackerInterface {
+public:
+    RemoteTracker();
+    ~RemoteTracker();
+
+    // -- IDeviceInterface
+    bool matchesDeviceEnumerator(const DeviceEnumerator *enumerator) const override;
+    bool open(const DeviceEnumerator *enumerator) override;
+    bool getIsOpen() const override;
+    bool getIsReadyToPoll() const override;
+    IDeviceInterface::ePollResult poll() override;
+    void close() override;
+    long getMaxPollFailureCount() const override;
+    static CommonDeviceState::eDeviceType getDeviceTypeStatic()
+    { return CommonDeviceState::RemoteTracker; }
+    CommonDeviceState::eDeviceType getDeviceType() const override;
+    const CommonDeviceState *getState(int lookBack = 0) const override;
+
+    // -- ITrackerInterface
+    ITrackerInterface::eDriverType getDriverType() const override;
+    std::string getUSBDevicePath() const override;
+    bool getVideoFrameDimensions(int *out_width, int *out_height, int *out_stride) const override;
+    const unsigned char *getVideoFrameBuffer() const override;
+    void setVideoFrameTargetBuffer(unsigned char *buffer) override;
+    std::chrono::time_point<std::chrono::high_resolution_clock> getFrameCaptureTimestamp() const override;
+    int getFrameSequenceNumber() const override;
+    int getDroppedFrameCount() const override;
+    double getFrameRate() const override;
+    void setExposure(double value) override;
+    double getExposure() const override;
+    void setGain(double value) override;
+    double getGain() const override;
+    void getCameraIntrinsics(
+        float &outFocalLengthX, float &outFocalLengthY,
+        float &outPrincipalX, float &outPrincipalY) const override;
+    void setCameraIntrinsics(
+        float focalLengthX, float focalLengthY,
+        float principalX, float principalY) override;
+    CommonDevicePose getTrackerPose() const override;
+    void setTrackerPose(const struct CommonDevicePose *pose) override;
+    void getFOV(float &outHFOV, float &outVFOV) const override;
+    void getZRange(float &outZNear, float &outZFar) const override;
+    void gatherTrackerOptions(PSMoveProtocol::Response_ResultTrackerSettings* settings) const override;
+    bool setOptionIndex(const std::string &option_name, int option_index) override;
+    bool getOptionIndex(const std::string &option_name, int &out_option_index) const override;
+    void gatherTrackingColorPresets(const std::string &controller_serial, PSMoveProtocol::Response_ResultTrackerSettings* settings) const override;
+    void setTrackingColorPreset(const std::string &controller_serial, eCommonTrackingColorID color, const CommonHSVColorRange *preset) override;
+    void getTrackingColorPreset(const std::string &controller_serial, eCommonTrackingColorID color, CommonHSVColorRange *out_preset) const override;
+
+    // -- Getters
+    inline const RemoteTrackerConfig &getConfig() const
+    { return cfg; }
+
+    // Returns the latest observation of the given tracking color, if the tracker node saw it
+    const RemoteTrackerObservation *findObservation(eCommonTrackingColorID tracking_color_id) const;
+
+private:
+    RemoteTrackerConfig cfg;
+    std::string DevicePath;
+    bool bIsOpen;
+
+    // The most recent frame polled from the RemoteTrackerRegistry
+    RemoteTrackerFrame LatestFrame;
+    RemoteTrackerState TrackerState;
+    int DroppedFrameCount;
+};
+#endif // REMOTE_TRACKER_H
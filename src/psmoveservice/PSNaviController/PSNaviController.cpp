@@ -102,6 +102,9 @@ PSNaviController::PSNaviController()
     NextPollSequenceNumber= 0;
     InData = new PSNaviDataInput;
     InData->type = PSNavi_Req_GetInput;
+
+    // Fixed size history so polling never allocates
+    ControllerStates.set_capacity(PSNAVI_STATE_BUFFER_MAX);
 }
 
 PSNaviController::~PSNaviController()
@@ -513,13 +516,7 @@ PSNaviController::poll()
             // Other
             newState.Battery = static_cast<CommonControllerState::BatteryLevel>(InData->battery);
 
-            // Make room for new entry if at the max queue size
-            if (ControllerStates.size() >= PSNAVI_STATE_BUFFER_MAX)
-            {
-                ControllerStates.erase(ControllerStates.begin(),
-                                        ControllerStates.begin()+ControllerStates.size()-PSNAVI_STATE_BUFFER_MAX);
-            }
-
+            // Overwrites the oldest entry once the queue is at PSNAVI_STATE_BUFFER_MAX
             ControllerStates.push_back(newState);
         }
     }
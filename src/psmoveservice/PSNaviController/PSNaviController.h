@@ -5,9 +5,9 @@
 #include "DeviceEnumerator.h"
 #include "DeviceInterface.h"
 #include "hidapi.h"
+#include <boost/circular_buffer.hpp>
 #include <string>
 #include <vector>
-#include <deque>
 
 struct PSNaviHIDDetails {
     std::string Device_path;
@@ -127,7 +127,7 @@ private:
 
     // Read Controller State
     int NextPollSequenceNumber;
-    std::deque<PSNaviControllerState> ControllerStates;
+    boost::circular_buffer<PSNaviControllerState> ControllerStates;
     PSNaviDataInput* InData;                        // Buffer to copy hidapi reports into
 };
 #endif // PSMOVE_CONTROLLER_H
\ No newline at end of file
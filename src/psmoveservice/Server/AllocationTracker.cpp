@@ -0,0 +1,278 @@
+//-- includes -----
+#include "AllocationTracker.h"
+#include "ServerLog.h"
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#if defined(PSMOVESERVICE_TRACK_ALLOCATIONS) && defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
+
+//-- macros -----
+// Whether malloc itself gets counted (which covers operator new as well)
+#if defined(PSMOVESERVICE_TRACK_ALLOCATIONS) && (defined(__GLIBC__) || (defined(_MSC_VER) && defined(_DEBUG)))
+#define HOOK_MALLOC 1
+#else
+#define HOOK_MALLOC 0
+#endif
+
+//-- constants -----
+// Time after a device or stream change before ticks have to stop allocating
+static const long long k_steady_state_settle_milliseconds = 5000;
+// Don't report more often than this while a tick keeps allocating
+static const long long k_violation_report_interval_milliseconds = 10000;
+
+//-- globals -----
+static std::atomic<unsigned long long> g_allocation_count(0);
+static std::atomic<long long> g_last_configuration_change_milliseconds(0);
+static std::atomic<int> g_violation_count(0);
+static long long g_last_violation_report_milliseconds = 0;
+static int g_unreported_violation_count = 0;
+
+#ifdef PSMOVESERVICE_TRACK_ALLOCATIONS
+static thread_local bool t_track_allocations = false;
+#endif
+
+//-- prototypes -----
+static long long get_milliseconds_now();
+#if defined(_MSC_VER) && HOOK_MALLOC
+static int crt_allocation_hook(int allocation_type, void *, size_t, int, long, const unsigned char *, int);
+#endif
+
+//-- public interface -----
+namespace AllocationTracker
+{
+    bool getIsEnabled()
+    {
+#ifdef PSMOVESERVICE_TRACK_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool getIsMallocHooked()
+    {
+        return HOOK_MALLOC != 0;
+    }
+
+    void trackCurrentThread()
+    {
+#if defined(_MSC_VER) && HOOK_MALLOC
+        // The debug CRT calls a single process wide hook for every heap operation
+        static std::atomic<bool> s_crt_hook_installed(false);
+        if (!s_crt_hook_installed.exchange(true))
+        {
+            _CrtSetAllocHook(crt_allocation_hook);
+        }
+#endif
+#ifdef PSMOVESERVICE_TRACK_ALLOCATIONS
+        t_track_allocations = true;
+#endif
+    }
+
+    unsigned long long getAllocationCount()
+    {
+        return g_allocation_count.load(std::memory_order_relaxed);
+    }
+
+    void noteConfigurationChange()
+    {
+        if (getIsEnabled())
+        {
+            g_last_configuration_change_milliseconds.store(get_milliseconds_now(), std::memory_order_relaxed);
+        }
+    }
+
+    unsigned long long beginTick()
+    {
+        return getAllocationCount();
+    }
+
+    unsigned long long endTick(unsigned long long tick_start_count)
+    {
+        const unsigned long long tick_allocation_count = getAllocationCount() - tick_start_count;
+
+        if (getIsEnabled() && tick_allocation_count > 0)
+        {
+            const long long now = get_milliseconds_now();
+            const long long settle_time =
+                now - g_last_configuration_change_milliseconds.load(std::memory_order_relaxed);
+
+            if (settle_time >= k_steady_state_settle_milliseconds)
+            {
+                ++g_violation_count;
+                ++g_unreported_violation_count;
+
+                if (now - g_last_violation_report_milliseconds >= k_violation_report_interval_milliseconds)
+                {
+                    SERVER_LOG_ERROR("AllocationTracker::endTick")
+                        << "Steady state update tick made " << tick_allocation_count << " heap allocations ("
+                        << g_unreported_violation_count << " allocating ticks since the last report)";
+
+                    g_last_violation_report_milliseconds = now;
+                    g_unreported_violation_count = 0;
+                }
+
+                assert(tick_allocation_count == 0 && "Steady state update tick allocated");
+            }
+        }
+
+        return tick_allocation_count;
+    }
+
+    int getSteadyStateViolationCount()
+    {
+        return g_violation_count.load();
+    }
+};
+
+//-- private functions -----
+static long long get_milliseconds_now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-- global allocator hooks -----
+#ifdef PSMOVESERVICE_TRACK_ALLOCATIONS
+static inline void count_allocation()
+{
+    if (t_track_allocations)
+    {
+        g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+#if HOOK_MALLOC && defined(__GLIBC__)
+// glibc lets the executable replace malloc and friends, the originals stay reachable under these names
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *memory, size_t size);
+extern "C" void *__libc_memalign(size_t alignment, size_t size);
+
+extern "C" void *malloc(size_t size) noexcept
+{
+    count_allocation();
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept
+{
+    count_allocation();
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *memory, size_t size) noexcept
+{
+    count_allocation();
+    return __libc_realloc(memory, size);
+}
+
+extern "C" void *memalign(size_t alignment, size_t size) noexcept
+{
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+// What cv::fastMalloc uses on Linux
+extern "C" int posix_memalign(void **out_memory, size_t alignment, size_t size) noexcept
+{
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0)
+    {
+        return EINVAL;
+    }
+
+    count_allocation();
+    void *memory = __libc_memalign(alignment, size);
+    if (memory == nullptr)
+    {
+        return ENOMEM;
+    }
+
+    *out_memory = memory;
+    return 0;
+}
+#endif // HOOK_MALLOC && __GLIBC__
+
+#if HOOK_MALLOC && defined(_MSC_VER)
+static int crt_allocation_hook(
+    int allocation_type, void *, size_t, int, long, const unsigned char *, int)
+{
+    if (allocation_type == _HOOK_ALLOC || allocation_type == _HOOK_REALLOC)
+    {
+        count_allocation();
+    }
+
+    return 1; // Let the heap operation go ahead
+}
+#endif // HOOK_MALLOC && _MSC_VER
+
+static void *counted_allocate(std::size_t size)
+{
+    // Counted by the malloc hook when there is one
+#if !HOOK_MALLOC
+    count_allocation();
+#endif
+
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void *operator new(std::size_t size)
+{
+    void *memory = counted_allocate(size);
+
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_allocate(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept
+{
+    std::free(memory);
+}
+#endif // PSMOVESERVICE_TRACK_ALLOCATIONS
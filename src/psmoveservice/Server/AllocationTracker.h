@@ -0,0 +1,44 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+//-- interface -----
+// Counts heap allocations made by the service update loop.
+// Only active in builds with PSMOVESERVICE_TRACK_ALLOCATIONS defined,
+// which replaces the global operator new/delete and, where the C runtime allows it
+// (glibc, the MSVC debug CRT), hooks malloc and friends too so that allocations made
+// through C APIs and OpenCV's cv::fastMalloc get counted. Otherwise every call here is a no-op.
+//
+// Once devices are open and streaming a tick of the update loop is expected to
+// run entirely out of preallocated buffers. Anything that legitimately allocates
+// (devices opening/closing, client requests) must call noteConfigurationChange()
+// so the ticks right after it aren't flagged.
+namespace AllocationTracker
+{
+    /// True when the global allocator is hooked
+    bool getIsEnabled();
+
+    /// True when malloc is hooked as well as operator new
+    bool getIsMallocHooked();
+
+    /// Counts allocations made on the calling thread from now on.
+    /// Used for the main loop thread and the job system workers.
+    void trackCurrentThread();
+
+    /// Allocations made so far by every tracked thread
+    unsigned long long getAllocationCount();
+
+    /// Restarts the settle period before allocations count as steady state violations
+    void noteConfigurationChange();
+
+    /// Call at the start of an update loop tick. Returns the value to pass to endTick().
+    unsigned long long beginTick();
+
+    /// Logs an error (and asserts in debug builds) if a steady state tick allocated.
+    /// \return The number of allocations made since beginTick()
+    unsigned long long endTick(unsigned long long tick_start_count);
+
+    /// Steady state ticks seen so far that allocated
+    int getSteadyStateViolationCount();
+};
+
+#endif // ALLOCATION_TRACKER_H
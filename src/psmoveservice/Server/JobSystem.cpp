@@ -0,0 +1,230 @@
+//-- includes -----
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-- constants -----
+// More threads than this just fight over the few trackers and controllers there are
+static const int k_max_job_threads = 8;
+
+//-- private definitions -----
+// One thread's share of the current batch of jobs: [next, end).
+// The owner takes jobs from the front and other threads steal them from the back.
+struct JobRange
+{
+    std::mutex mutex;
+    int next;
+    int end;
+
+    JobRange()
+        : next(0)
+        , end(0)
+    {}
+};
+
+class JobSystemImpl
+{
+public:
+    JobSystemImpl(int thread_count, const JobSystem::WorkerStartedCallback &worker_started)
+        : m_worker_started(worker_started)
+        , m_ranges(thread_count)
+        , m_job(nullptr)
+        , m_batch_index(0)
+        , m_remaining_job_count(0)
+        , m_exit_requested(false)
+    {
+        // Thread 0 is whoever calls parallelFor()
+        for (int thread_index = 1; thread_index < thread_count; ++thread_index)
+        {
+            m_threads.push_back(std::thread(&JobSystemImpl::worker_thread_func, this, thread_index));
+        }
+    }
+
+    ~JobSystemImpl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_batch_mutex);
+            m_exit_requested = true;
+        }
+        m_batch_started.notify_all();
+
+        for (std::thread &thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    inline int getThreadCount() const
+    {
+        return static_cast<int>(m_ranges.size());
+    }
+
+    void parallelFor(int job_count, const std::function<void(int)> &job)
+    {
+        const int thread_count = getThreadCount();
+
+        if (thread_count <= 1 || job_count <= 1)
+        {
+            for (int job_index = 0; job_index < job_count; ++job_index)
+            {
+                job(job_index);
+            }
+
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_batch_mutex);
+
+            m_job = &job;
+            m_remaining_job_count = job_count;
+
+            // Give every thread an even, contiguous share of the jobs
+            for (int thread_index = 0; thread_index < thread_count; ++thread_index)
+            {
+                JobRange &range = m_ranges[thread_index];
+                std::lock_guard<std::mutex> range_lock(range.mutex);
+
+                range.next = (job_count * thread_index) / thread_count;
+                range.end = (job_count * (thread_index + 1)) / thread_count;
+            }
+
+            ++m_batch_index;
+        }
+        m_batch_started.notify_all();
+
+        run_jobs(0);
+
+        // Wait on any jobs still running on the other threads
+        std::unique_lock<std::mutex> lock(m_batch_mutex);
+        m_batch_finished.wait(lock, [this]() { return m_remaining_job_count == 0; });
+        m_job = nullptr;
+    }
+
+private:
+    void worker_thread_func(int thread_index)
+    {
+        int last_batch_index = 0;
+
+        if (m_worker_started)
+        {
+            m_worker_started(thread_index);
+        }
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_batch_mutex);
+                m_batch_started.wait(lock, [this, last_batch_index]() {
+                    return m_exit_requested || m_batch_index != last_batch_index;
+                });
+
+                if (m_exit_requested)
+                {
+                    break;
+                }
+
+                last_batch_index = m_batch_index;
+            }
+
+            run_jobs(thread_index);
+        }
+    }
+
+    void run_jobs(int thread_index)
+    {
+        int job_index;
+
+        while (take_own_job(thread_index, job_index) || steal_job(thread_index, job_index))
+        {
+            // m_job was set before the job ranges were filled in (see parallelFor)
+            (*m_job)(job_index);
+
+            std::lock_guard<std::mutex> lock(m_batch_mutex);
+            if (--m_remaining_job_count == 0)
+            {
+                m_batch_finished.notify_one();
+            }
+        }
+    }
+
+    bool take_own_job(int thread_index, int &out_job_index)
+    {
+        JobRange &range = m_ranges[thread_index];
+        std::lock_guard<std::mutex> lock(range.mutex);
+
+        if (range.next < range.end)
+        {
+            out_job_index = range.next;
+            ++range.next;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool steal_job(int thread_index, int &out_job_index)
+    {
+        const int thread_count = getThreadCount();
+
+        for (int offset = 1; offset < thread_count; ++offset)
+        {
+            JobRange &range = m_ranges[(thread_index + offset) % thread_count];
+            std::lock_guard<std::mutex> lock(range.mutex);
+
+            if (range.next < range.end)
+            {
+                --range.end;
+                out_job_index = range.end;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    JobSystem::WorkerStartedCallback m_worker_started;
+    std::vector<std::thread> m_threads;
+    std::vector<JobRange> m_ranges;
+
+    // Current batch (guarded by m_batch_mutex)
+    std::mutex m_batch_mutex;
+    std::condition_variable m_batch_started;
+    std::condition_variable m_batch_finished;
+    const std::function<void(int)> *m_job;
+    int m_batch_index;
+    int m_remaining_job_count;
+    bool m_exit_requested;
+};
+
+//-- public interface -----
+JobSystem::JobSystem(int thread_count, const WorkerStartedCallback &worker_started)
+    : implementation_ptr(new JobSystemImpl(std::max(std::min(thread_count, k_max_job_threads), 1), worker_started))
+{
+}
+
+JobSystem::~JobSystem()
+{
+    delete implementation_ptr;
+}
+
+int JobSystem::getThreadCount() const
+{
+    return implementation_ptr->getThreadCount();
+}
+
+void JobSystem::parallelFor(int job_count, const std::function<void(int)> &job)
+{
+    implementation_ptr->parallelFor(job_count, job);
+}
+
+int JobSystem::getDefaultThreadCount()
+{
+    const int hardware_thread_count = static_cast<int>(std::thread::hardware_concurrency());
+
+    return std::max(std::min(hardware_thread_count, k_max_job_threads), 1);
+}
@@ -0,0 +1,38 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+//-- includes -----
+#include <functional>
+
+//-- definitions -----
+// Small fork/join job scheduler used to spread the per-tick tracking work over several cores.
+// parallelFor() splits the job indices evenly over the threads (the calling thread included).
+// Each thread works through its own share front to back and, once it runs out,
+// steals jobs from the back of the other threads' shares.
+// Jobs must only write state that no other job in the same batch touches;
+// then the results don't depend on which thread ran which job.
+class JobSystem
+{
+public:
+    // Called on each worker thread (index 1 and up) before it runs any jobs
+    typedef std::function<void(int thread_index)> WorkerStartedCallback;
+
+    // thread_count includes the calling thread, so 1 runs every job inline
+    JobSystem(int thread_count, const WorkerStartedCallback &worker_started = WorkerStartedCallback());
+    virtual ~JobSystem();
+
+    int getThreadCount() const;
+
+    // Runs job(index) for every index in [0, job_count) and returns once they have all finished.
+    // Jobs must not call parallelFor() themselves.
+    void parallelFor(int job_count, const std::function<void(int)> &job);
+
+    // Thread count to use when the config asks for one per hardware thread
+    static int getDefaultThreadCount();
+
+private:
+    // private implementation - same lifetime as the JobSystem
+    class JobSystemImpl *implementation_ptr;
+};
+
+#endif // JOB_SYSTEM_H
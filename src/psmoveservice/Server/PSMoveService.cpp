@@ -2,15 +2,19 @@
 #define BOOST_LIB_DIAGNOSTIC
 
 #include "PSMoveService.h"
+#include "AllocationTracker.h"
 #include "ServerNetworkManager.h"
 #include "ServerRequestHandler.h"
 #include "DeviceManager.h"
 #include "ServerLog.h"
+#include "TrackerNodePublisher.h"
 
 #include <boost/asio.hpp>
 #include <boost/application.hpp>
 #include <boost/program_options.hpp>
+#include <chrono>
 #include <fstream>
+#include <iostream>
 #include <cstdio>
 #include <string>
 #include <signal.h>
@@ -29,17 +33,23 @@ using namespace boost;
 #endif // defined(BOOST_POSIX_API)
 
 const int PSMOVE_SERVER_PORT = 9512;
+const int PSMOVE_TRACKER_NODE_PORT = 9513; // So a tracker node can share a machine with the central service
+const int PSMOVE_UPDATE_SLEEP_MS = 1;
 
 //-- definitions -----
 class PSMoveServiceImpl
 {
 public:
-    PSMoveServiceImpl()
+    PSMoveServiceImpl(const PSMoveService::ProgramSettings *settings)
         : m_io_service()
         , m_signals(m_io_service)
         , m_device_manager()
         , m_request_handler(&m_device_manager)
-        , m_network_manager(&m_io_service, PSMOVE_SERVER_PORT, &m_request_handler)
+        , m_network_manager(
+            &m_io_service, 
+            settings->tracker_node_mode ? PSMOVE_TRACKER_NODE_PORT : PSMOVE_SERVER_PORT,
+            &m_request_handler)
+        , m_tracker_node_publisher(settings->tracker_node_mode ? new TrackerNodePublisher(&m_io_service) : nullptr)
         , m_status()
     {
         // Register to handle the signals that indicate when the server should exit.
@@ -51,6 +61,14 @@ public:
         m_signals.async_wait(boost::bind(&PSMoveServiceImpl::handle_termination_signal, this));
     }
 
+    ~PSMoveServiceImpl()
+    {
+        if (m_tracker_node_publisher != nullptr)
+        {
+            delete m_tracker_node_publisher;
+        }
+    }
+
     /// Entry point into boost::application
     int operator()(application::context& context)
     {
@@ -63,14 +81,30 @@ public:
             {
                 m_status = context.find<application::status>();
 
+                // Startup opened every device, so give the update loop time to settle
+                // before counting its allocations
+                AllocationTracker::trackCurrentThread();
+                AllocationTracker::noteConfigurationChange();
+
                 while (m_status->state() != application::status::stoped)
                 {
-                    if (m_status->state() != application::status::paused)
+                    const bool bRunning = m_status->state() != application::status::paused;
+
+                    if (bRunning)
                     {
                         update();
                     }
 
-                    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+                    const std::chrono::time_point<std::chrono::high_resolution_clock> sleep_start = std::chrono::high_resolution_clock::now();
+                    boost::this_thread::sleep(boost::posix_time::milliseconds(PSMOVE_UPDATE_SLEEP_MS));
+                    const std::chrono::time_point<std::chrono::high_resolution_clock> sleep_end = std::chrono::high_resolution_clock::now();
+
+                    // How late the OS let us back on the CPU
+                    if (bRunning)
+                    {
+                        m_device_manager.addWakeupLatencySample(
+                            std::chrono::duration<double, std::micro>(sleep_end - sleep_start).count() - PSMOVE_UPDATE_SLEEP_MS*1000.0);
+                    }
                 }
             }
             else
@@ -165,12 +199,24 @@ private:
             }
         }
 
+        /** Start streaming tracker observations to the central service (tracker node mode only) */
+        if (success && m_tracker_node_publisher != nullptr)
+        {
+            if (!m_tracker_node_publisher->startup())
+            {
+                SERVER_LOG_FATAL("PSMoveService") << "Failed to initialize the tracker node publisher";
+                success= false;
+            }
+        }
+
         return success;
     }
 
     /// Called in the application loop.
     void update()
     {
+        const unsigned long long tick_allocations = AllocationTracker::beginTick();
+
         /** Update an async requests still waiting to complete */
         m_request_handler.update();
 
@@ -182,10 +228,18 @@ private:
 
         /** Process incoming/outgoing networking requests */
         m_network_manager.update();
+
+        AllocationTracker::endTick(tick_allocations);
     }
 
     void shutdown()
     {
+        // Stop forwarding tracker observations
+        if (m_tracker_node_publisher != nullptr)
+        {
+            m_tracker_node_publisher->shutdown();
+        }
+
         // Kill any pending request state
         m_request_handler.shutdown();
 
@@ -219,6 +273,9 @@ private:
     // Manages all TCP and UDP client connections
     ServerNetworkManager m_network_manager;
 
+    // Sends tracker observations to the central service when running as a tracker node
+    TrackerNodePublisher *m_tracker_node_publisher;
+
     // Whether the application should keep running or not
     std::shared_ptr<application::status> m_status;
 };
@@ -244,6 +301,8 @@ static void parse_program_settings(
     {
         settings.admin_password.clear();
     }
+
+    settings.tracker_node_mode= options_map.count("tracker_node") > 0;
 }
 
 #if defined(BOOST_WINDOWS_API) 
@@ -446,6 +505,7 @@ int PSMoveService::exec(int argc, char *argv[])
         (",d", "Run as background daemon/service")
         ("log_level,l", program_options::value<std::string>(), "The level of logging to use: trace, debug, info, warning, error, fatal")
         ("admin_password,p", program_options::value<std::string>(), "Remember the admin password for this machine (optional)")
+        ("tracker_node,t", "Run as a headless tracker node that streams blob observations to a central service (see TrackerNodeConfig)")
 #if defined(BOOST_WINDOWS_API)
         (",i", "install service")
         (",u", "uninstall service")
@@ -500,10 +560,10 @@ int PSMoveService::exec(int argc, char *argv[])
     log_init(this->getProgramSettings()->log_level);
 
     // Start the service app
-    SERVER_LOG_INFO("main") << "Starting PSMoveService";
+    SERVER_LOG_INFO("main") << "Starting PSMoveService" << (m_settings.tracker_node_mode ? " (tracker node mode)" : "");
     try
     {
-        PSMoveServiceImpl app;
+        PSMoveServiceImpl app(this->getProgramSettings());
         application::context app_context;
         
         // service aspects
@@ -12,6 +12,7 @@ public:
     {
         std::string log_level;
         std::string admin_password;
+        bool tracker_node_mode;
     };
 
     PSMoveService();
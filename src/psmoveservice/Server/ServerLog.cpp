@@ -1,27 +1,296 @@
 //-- includes -----
 #include "ServerLog.h"
-#include "PSMoveService.h"
 
+#include <atomic>
 #include <chrono>
-#include <fstream>
+#include <cstdint>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
-//-- globals -----
-e_log_severity_level g_min_log_level;
+//-- constants -----
+// Must be a power of two
+static const size_t k_log_ring_buffer_size = 4096;
+// How long the sink thread sleeps when there is nothing to write
+static const int k_log_sink_idle_sleep_ms = 5;
+
+//-- private definitions -----
+// Bounded multi-producer/single-consumer queue of log lines
+// (after Dmitry Vyukov's bounded MPMC queue).
+// Each slot has a sequence number that tells producers and the consumer
+// whose turn it is to touch the slot, so pushing a line never takes a lock.
+class LogRingBuffer
+{
+public:
+    LogRingBuffer()
+        : m_slots(k_log_ring_buffer_size)
+        , m_enqueue_pos(0)
+        , m_dequeue_pos(0)
+    {
+        for (size_t index = 0; index < k_log_ring_buffer_size; ++index)
+        {
+            m_slots[index].sequence.store(index, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false if the ring buffer is full
+    bool try_push(std::string &line)
+    {
+        size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        Slot *slot;
+
+        for (;;)
+        {
+            slot = &m_slots[pos & (k_log_ring_buffer_size - 1)];
+
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0)
+            {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->line.swap(line);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Only called from the sink thread (or after it has stopped)
+    bool try_pop(std::string &out_line)
+    {
+        const size_t pos = m_dequeue_pos;
+        Slot *slot = &m_slots[pos & (k_log_ring_buffer_size - 1)];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+
+        if (sequence != pos + 1)
+        {
+            return false;
+        }
+
+        out_line.swap(slot->line);
+        slot->line.clear();
+        m_dequeue_pos = pos + 1;
+        slot->sequence.store(pos + k_log_ring_buffer_size, std::memory_order_release);
+
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        std::string line;
+    };
+
+    std::vector<Slot> m_slots;
+    std::atomic<size_t> m_enqueue_pos;
+    size_t m_dequeue_pos;
+};
+
+// Owns the ring buffer and the thread that writes queued lines to the console
+class AsyncLogSink
+{
+public:
+    AsyncLogSink()
+        : m_ring_buffer()
+        , m_dropped_line_count(0)
+        , m_active_writer_count(0)
+        , m_is_running(false)
+        , m_exit_signaled(false)
+        , m_initializer_pending(false)
+        , m_thread()
+    {
+    }
+
+    ~AsyncLogSink()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        if (!m_is_running)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_initializer_mutex);
+                m_initializer_pending = static_cast<bool>(m_thread_initializer);
+            }
+
+            m_exit_signaled = false;
+            m_thread = std::thread(&AsyncLogSink::thread_func, this);
+            m_is_running = true;
+        }
+    }
+
+    void stop()
+    {
+        if (m_is_running)
+        {
+            // New lines go straight to the console from here on
+            m_is_running = false;
+            m_exit_signaled = true;
+            m_thread.join();
+
+            // Wait out any writer that saw the sink running and hasn't pushed its line yet
+            while (m_active_writer_count.load() > 0)
+            {
+                std::this_thread::yield();
+            }
+
+            // Write out anything that was queued while the thread was exiting
+            drain_ring_buffer();
+            std::cout.flush();
+        }
+    }
+
+    void write_line(std::string &line)
+    {
+        // stop() waits for this count to reach zero before its final drain,
+        // so a line pushed here is never left behind in the ring buffer
+        m_active_writer_count.fetch_add(1);
+
+        if (m_is_running.load())
+        {
+            if (!m_ring_buffer.try_push(line))
+            {
+                // Don't block the caller when the console can't keep up
+                m_dropped_line_count.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            m_active_writer_count.fetch_sub(1);
+        }
+        else
+        {
+            m_active_writer_count.fetch_sub(1);
+
+            std::cout << line;
+        }
+    }
+
+    void set_thread_initializer(const std::function<void()> &initializer)
+    {
+        std::lock_guard<std::mutex> lock(m_initializer_mutex);
+
+        m_thread_initializer = initializer;
+        m_initializer_pending = static_cast<bool>(initializer);
+    }
+
+private:
+    // Returns true if anything was written to the console
+    bool drain_ring_buffer()
+    {
+        std::string line;
+        bool bWroteAnything = false;
+
+        while (m_ring_buffer.try_pop(line))
+        {
+            std::cout << line;
+            bWroteAnything = true;
+        }
+
+        const int dropped_line_count = m_dropped_line_count.exchange(0, std::memory_order_relaxed);
+        if (dropped_line_count > 0)
+        {
+            std::cout << "[log] " << dropped_line_count << " log lines dropped (log sink full)" << std::endl;
+            bWroteAnything = true;
+        }
+
+        return bWroteAnything;
+    }
 
+    void thread_func()
+    {
+        for (;;)
+        {
+            if (m_initializer_pending.exchange(false))
+            {
+                std::function<void()> initializer;
+                {
+                    std::lock_guard<std::mutex> lock(m_initializer_mutex);
+                    initializer = m_thread_initializer;
+                }
+
+                if (initializer)
+                {
+                    initializer();
+                }
+            }
+
+            // Read the exit flag before draining so that lines queued before stop() are not lost
+            const bool bExitSignaled = m_exit_signaled.load();
+            const bool bWroteAnything = drain_ring_buffer();
 
-// Connect the normal logger to standard output
-std::ostream g_normal_logger(std::cout.rdbuf());
+            if (bWroteAnything)
+            {
+                std::cout.flush();
+            }
 
-// Null stream eats the log
-NullStream<char> g_null_logger;
+            if (bExitSignaled)
+            {
+                break;
+            }
+
+            if (!bWroteAnything)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(k_log_sink_idle_sleep_ms));
+            }
+        }
+    }
 
-ThreadSafeStream<char> g_mt_normal_logger(&g_normal_logger);
-ThreadSafeStream<char> g_mt_null_logger(&g_null_logger);
+    LogRingBuffer m_ring_buffer;
+    std::atomic_int m_dropped_line_count;
+    std::atomic_int m_active_writer_count;
+    std::atomic_bool m_is_running;
+    std::atomic_bool m_exit_signaled;
+    std::mutex m_initializer_mutex;
+    std::function<void()> m_thread_initializer;
+    std::atomic_bool m_initializer_pending;
+    std::thread m_thread;
+};
+
+//-- globals -----
+e_log_severity_level g_min_log_level= _log_severity_level_info;
+
+static AsyncLogSink g_async_log_sink;
 
 //-- public implementation -----
+ServerLogMessage::ServerLogMessage(const char *function_name)
+    : m_stream()
+{
+    m_stream << log_get_timestamp_prefix() << function_name << " - ";
+}
+
+ServerLogMessage::~ServerLogMessage()
+{
+    std::string line = m_stream.str();
+
+    // One log line per message, whether or not the caller ended it with std::endl
+    if (line.empty() || line.back() != '\n')
+    {
+        line.push_back('\n');
+    }
+
+    g_async_log_sink.write_line(line);
+}
+
 void log_init(const std::string &log_level)
 {
     g_min_log_level= _log_severity_level_info;
@@ -50,11 +319,18 @@ void log_init(const std::string &log_level)
     {
         g_min_log_level= _log_severity_level_fatal;
     }
+
+    g_async_log_sink.start();
 }
 
-bool log_can_emit_level(e_log_severity_level level)
+void log_dispose()
 {
-    return (level >= g_min_log_level);
+    g_async_log_sink.stop();
+}
+
+void log_set_sink_thread_initializer(const std::function<void()> &initializer)
+{
+    g_async_log_sink.set_thread_initializer(initializer);
 }
 
 std::string log_get_timestamp_prefix()
@@ -63,9 +339,17 @@ std::string log_get_timestamp_prefix()
     auto seconds = std::chrono::time_point_cast<std::chrono::seconds>(now);
     auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now - seconds);
     time_t in_time_t = std::chrono::system_clock::to_time_t(now);
+    struct tm local_time;
+
+    // std::localtime isn't safe to call from more than one thread
+#ifdef _WIN32
+    localtime_s(&local_time, &in_time_t);
+#else
+    localtime_r(&in_time_t, &local_time);
+#endif
 
     std::stringstream ss;
-    ss << "[" << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d %H:%M:%S") << "." << milliseconds.count() << "]: ";
+    ss << "[" << std::put_time(&local_time, "%Y-%m-%d %H:%M:%S") << "." << std::setfill('0') << std::setw(3) << milliseconds.count() << "]: ";
 
     return ss.str();
-}
\ No newline at end of file
+}
@@ -2,10 +2,10 @@
 #define SERVER_LOG_H
 
 //-- includes -----
-#include <streambuf>
+#include <functional>
 #include <ostream>
-#include <iostream>
-#include <mutex>
+#include <sstream>
+#include <string>
 
 //-- constants -----
 enum e_log_severity_level
@@ -18,105 +18,77 @@ enum e_log_severity_level
     _log_severity_level_fatal
 };
 
-//-- includes -----
-// From: http://stackoverflow.com/questions/760301/implementing-a-no-op-stdostream
-template <class t_char, class traits = std::char_traits<t_char> >
-class NullStreamBuffer: public std::basic_streambuf<t_char, traits> 
-{
-    typename traits::int_type overflow(typename traits::int_type c)
-    {
-        return traits::not_eof(c); // indicate success
-    }
-};
-
-template <class t_char, class traits = std::char_traits<t_char> >
-class NullStream: public std::basic_ostream<t_char, traits> 
+//-- definitions -----
+// Collects a single log line.
+// When the message goes out of scope the line is handed off to the async log sink,
+// which writes it to the console from a background thread.
+class ServerLogMessage
 {
 public:
-    NullStream()
-        : std::basic_ios<t_char, traits>(&m_sbuf)
-        , std::basic_ostream<t_char, traits>(&m_sbuf)
-    {
-        this->init(&m_sbuf);
-    }
+    ServerLogMessage(const char *function_name);
+    ~ServerLogMessage();
+
+    inline std::ostream &stream() { return m_stream; }
 
 private:
-    NullStreamBuffer<t_char, traits> m_sbuf;
+    std::ostringstream m_stream;
 };
 
-// From: http://stackoverflow.com/questions/36583873/thread-safe-access-of-stdofstream-member-using-stdmutex-member-and-operator
-//###HipsterSloth $TODO: This is only really thread safe per object added to the stream
-template <class char_type, class traits = std::char_traits<char_type> >
-class ThreadSafeStream
+// Lets the logging macros below be used as a statement without any
+// "dangling else" problems. operator& binds looser than operator<<.
+class ServerLogVoidify
 {
-protected:
-    std::mutex mutex;
-    std::basic_ostream<char_type, traits> *stream;
-
 public:
-    ThreadSafeStream(std::basic_ostream<char_type, traits> *_stream)
-        : stream(_stream)
-    {
-    }
-
-    void flush()
-    {
-        std::lock_guard<std::mutex> lock(mutex);
-
-        stream->flush();
-    }
-
-    template<typename T>
-    ThreadSafeStream<char_type>& operator<<(const T& value)
-    {
-        put(value);
-        return *this;
-    }
-
-protected:
-    template<typename T>
-    void put(const T& thing) 
-    {
-        std::lock_guard<std::mutex> lock(mutex);
-
-        *stream << thing;
-    }
+    inline void operator&(std::ostream &) {}
 };
 
 //-- globals -----
-extern std::ostream g_normal_logger;
-extern NullStream<char> g_null_logger;
-
-extern ThreadSafeStream<char> g_mt_normal_logger;
-extern ThreadSafeStream<char> g_mt_null_logger;
+extern e_log_severity_level g_min_log_level;
 
 //-- interface -----
+// Sets the minimum log level and starts the async log sink
 void log_init(const std::string &log_level);
-bool log_can_emit_level(e_log_severity_level level);
+
+// Writes out any queued log lines and stops the async log sink.
+// Lines logged after this are written to the console directly.
+// Also happens automatically at program exit.
+void log_dispose();
+
+// Runs the given function on the async log sink's thread, once now (if the sink is running)
+// and again every time the sink starts, e.g. to apply the service's thread scheduling policy.
+// Pass an empty function to stop running it.
+void log_set_sink_thread_initializer(const std::function<void()> &initializer);
+
+inline bool log_can_emit_level(e_log_severity_level level)
+{
+    return (level >= g_min_log_level);
+}
+
 std::string log_get_timestamp_prefix();
 
 //-- macros -----
-#define SELECT_LOG_STREAM(level) (log_can_emit_level(level) ? g_normal_logger : g_null_logger)
-#define SELECT_MT_LOG_STREAM(level) (log_can_emit_level(level) ? g_mt_normal_logger : g_mt_null_logger)
+// Nothing to the right of the macro (including the timestamp) is evaluated
+// unless the log level is enabled, so disabled log statements cost a single compare.
+#define SERVER_LOG_LEVEL_STREAM(level, function_name) \
+    !log_can_emit_level(level) ? (void)0 : ServerLogVoidify() & ServerLogMessage(function_name).stream()
 
-// Non Thread Safe Logger Macros
+// Logger Macros
 // Almost everything is on the main thread, so you almost always want to use these
-#define SERVER_LOG_TRACE(function_name) SELECT_LOG_STREAM(_log_severity_level_trace) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_LOG_DEBUG(function_name) SELECT_LOG_STREAM(_log_severity_level_debug) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_LOG_INFO(function_name) SELECT_LOG_STREAM(_log_severity_level_info) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_LOG_WARNING(function_name) SELECT_LOG_STREAM(_log_severity_level_warning) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_LOG_ERROR(function_name) SELECT_LOG_STREAM(_log_severity_level_error) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_LOG_FATAL(function_name) SELECT_LOG_STREAM(_log_severity_level_fatal) << log_get_timestamp_prefix() << function_name << " - "
+#define SERVER_LOG_TRACE(function_name) SERVER_LOG_LEVEL_STREAM(_log_severity_level_trace, function_name)
+#define SERVER_LOG_DEBUG(function_name) SERVER_LOG_LEVEL_STREAM(_log_severity_level_debug, function_name)
+#define SERVER_LOG_INFO(function_name) SERVER_LOG_LEVEL_STREAM(_log_severity_level_info, function_name)
+#define SERVER_LOG_WARNING(function_name) SERVER_LOG_LEVEL_STREAM(_log_severity_level_warning, function_name)
+#define SERVER_LOG_ERROR(function_name) SERVER_LOG_LEVEL_STREAM(_log_severity_level_error, function_name)
+#define SERVER_LOG_FATAL(function_name) SERVER_LOG_LEVEL_STREAM(_log_severity_level_fatal, function_name)
 
 // Thread Safe Logger Macros
-// Uses thread safe locking before appending data to the logging stream
-// Only use this when logging from other threads
-#define SERVER_MT_LOG_TRACE(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_trace) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_MT_LOG_DEBUG(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_debug) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_MT_LOG_INFO(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_info) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_MT_LOG_WARNING(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_warning) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_MT_LOG_ERROR(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_error) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_MT_LOG_FATAL(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_fatal) << log_get_timestamp_prefix() << function_name << " - "
- 
-#endif  // SERVER_LOG_H
+// Each log line is built up locally and queued as a whole, so every logger is thread safe now.
+// These are kept so that logging from other threads stays easy to spot.
+#define SERVER_MT_LOG_TRACE(function_name) SERVER_LOG_TRACE(function_name)
+#define SERVER_MT_LOG_DEBUG(function_name) SERVER_LOG_DEBUG(function_name)
+#define SERVER_MT_LOG_INFO(function_name) SERVER_LOG_INFO(function_name)
+#define SERVER_MT_LOG_WARNING(function_name) SERVER_LOG_WARNING(function_name)
+#define SERVER_MT_LOG_ERROR(function_name) SERVER_LOG_ERROR(function_name)
+#define SERVER_MT_LOG_FATAL(function_name) SERVER_LOG_FATAL(function_name)
 
+#endif  // SERVER_LOG_H
@@ -1,5 +1,8 @@
 //-- includes -----
 #include "ServerNetworkManager.h"
+#include "AllocationTracker.h"
+#include "InPlaceMessageParser.h"
+#include "PSMoveConfig.h"
 #include "ServerRequestHandler.h"
 #include "ServerLog.h"
 #include "packedmessage.h"
@@ -13,6 +16,7 @@
 #include <deque>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
+#include <boost/circular_buffer.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/cstdint.hpp>
 #include <boost/enable_shared_from_this.hpp>
@@ -24,6 +28,14 @@ using asio::ip::tcp;
 using asio::ip::udp;
 using boost::uint8_t;
 
+//-- constants -----
+// Data frames a connection can have waiting to be sent before its queue has to grow
+static const int k_initial_data_frame_queue_capacity = 32;
+
+static const char *k_default_multicast_group_address = "239.255.95.12"; // organization-local scope
+static const int k_default_multicast_port = 9513; // PSMOVE_SERVER_PORT + 1
+static const int k_default_multicast_ttl = 1; // don't leave the local subnet
+
 class ClientConnection;
 typedef boost::shared_ptr<ClientConnection> ClientConnectionPtr;
 
@@ -31,6 +43,70 @@ typedef map<int, ClientConnectionPtr> t_client_connection_map;
 typedef map<int, ClientConnectionPtr>::iterator t_client_connection_map_iter;
 typedef std::pair<int, ClientConnectionPtr> t_id_client_connection_pair;
 
+//-- private definitions -----
+class ServerNetworkConfig : public PSMoveConfig
+{
+public:
+    ServerNetworkConfig(const std::string &fnamebase = "ServerNetworkConfig")
+        : PSMoveConfig(fnamebase)
+        , multicast_enabled(false)
+        , multicast_group_address(k_default_multicast_group_address)
+        , multicast_port(k_default_multicast_port)
+        , multicast_ttl(k_default_multicast_ttl)
+        , multicast_interface_address()
+        , multicast_loopback(true)
+        , tracker_node_token()
+    {
+    };
+
+    const boost::property_tree::ptree
+    config2ptree()
+    {
+        boost::property_tree::ptree pt;
+
+        pt.put("multicast_enabled", multicast_enabled);
+        pt.put("multicast_group_address", multicast_group_address);
+        pt.put("multicast_port", multicast_port);
+        pt.put("multicast_ttl", multicast_ttl);
+        pt.put("multicast_interface_address", multicast_interface_address);
+        pt.put("multicast_loopback", multicast_loopback);
+        pt.put("tracker_node_token", tracker_node_token);
+
+        return pt;
+    }
+
+    void
+    ptree2config(const boost::property_tree::ptree &pt)
+    {
+        multicast_enabled = pt.get<bool>("multicast_enabled", false);
+        multicast_group_address = pt.get<std::string>("multicast_group_address", k_default_multicast_group_address);
+        multicast_port = pt.get<int>("multicast_port", k_default_multicast_port);
+        multicast_ttl = pt.get<int>("multicast_ttl", k_default_multicast_ttl);
+        multicast_interface_address = pt.get<std::string>("multicast_interface_address", "");
+        multicast_loopback = pt.get<bool>("multicast_loopback", true);
+        tracker_node_token = pt.get<std::string>("tracker_node_token", "");
+    }
+
+    // Lets clients ask for their controller data frames over a multicast group, 
+    // so the service serializes and sends each frame once no matter how many LAN clients listen
+    bool multicast_enabled;
+    std::string multicast_group_address;
+    int multicast_port;
+    int multicast_ttl;
+
+    // Local address of the interface multicast data frames go out on (empty = the OS default route).
+    // Use "127.0.0.1" with a local multicast route (e.g. "ip route add 239.0.0.0/8 dev lo") 
+    // to keep the group on the loopback interface.
+    std::string multicast_interface_address;
+
+    // Deliver the multicast data frames to clients running on the service's own machine too
+    bool multicast_loopback;
+
+    // Shared secret tracker nodes have to send with their observations (node_token in TrackerNodeConfig).
+    // Empty = observations from tracker nodes are ignored.
+    std::string tracker_node_token;
+};
+
 //-- private implementation -----
 class IServerNetworkEventListener
 {
@@ -157,6 +233,11 @@ public:
         return m_connection_started && m_has_pending_udp_write;
     }
 
+    bool has_queued_responses() const
+    {
+        return m_pending_responses.size() > 0;
+    }
+
     bool has_queued_controller_data_frames() const
     {
         return m_connection_started && m_pending_dataframes.size() > 0;
@@ -210,6 +291,12 @@ public:
     
     void add_device_data_frame_to_write_queue(DeviceOutputDataFramePtr data_frame)
     {
+        // Only grows when the client falls behind; never drop queued frames
+        if (m_pending_dataframes.full())
+        {
+            m_pending_dataframes.set_capacity(m_pending_dataframes.capacity() * 2);
+        }
+
         m_pending_dataframes.push_back(data_frame);
     }
 
@@ -240,9 +327,10 @@ public:
                         write_in_progress= true;
 
                         // Start an asynchronous operation to send the data frame
+                        // (just the packed bytes, the client reads the length from the header)
                         // NOTE: Even if the write completes immediate, the callback will only be called from io_service::poll()
                         m_udp_socket_ref.async_send_to(
-                            boost::asio::buffer(m_output_dataframe_buffer, sizeof(m_output_dataframe_buffer)),
+                            boost::asio::buffer(m_output_dataframe_buffer, HEADER_SIZE+msg_size),
                             m_udp_remote_endpoint,
                             boost::bind(&ClientConnection::handle_udp_write_device_data_frame_complete, this, _1));
                     }
@@ -285,7 +373,7 @@ private:
     PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> m_packed_output_dataframe;
 
     deque<ResponsePtr> m_pending_responses;
-    deque<DeviceOutputDataFramePtr> m_pending_dataframes;
+    boost::circular_buffer<DeviceOutputDataFramePtr> m_pending_dataframes;
     
     bool m_connection_started;
     bool m_connection_stopped;
@@ -310,7 +398,7 @@ private:
         , m_packed_response()
         , m_packed_output_dataframe()
         , m_pending_responses()
-        , m_pending_dataframes()
+        , m_pending_dataframes(k_initial_data_frame_queue_capacity)
         , m_connection_started(false)
         , m_connection_stopped(false)
         , m_has_pending_tcp_write(false)
@@ -515,11 +603,20 @@ public:
         , m_udp_socket(m_io_service, udp::endpoint(udp::v4(), port))
         , m_udp_connecting_remote_endpoint()
         , m_packed_input_dataframe(std::shared_ptr<PSMoveProtocol::DeviceInputDataFrame>(new PSMoveProtocol::DeviceInputDataFrame()))
+        , m_input_dataframe_parser()
         , m_udp_connection_result_write_buffer(false)
         , m_has_pending_udp_read(false)
+        , m_has_warned_unregistered_tracker_node(false)
         , m_connections()
+        , m_config()
+        , m_multicast_socket(m_io_service)
+        , m_multicast_endpoint()
+        , m_packed_multicast_dataframe()
+        , m_pending_multicast_dataframes(k_initial_data_frame_queue_capacity)
+        , m_has_pending_multicast_write(false)
     {
         memset(m_input_dataframe_buffer, 0, sizeof(m_input_dataframe_buffer));
+        memset(m_multicast_dataframe_buffer, 0, sizeof(m_multicast_dataframe_buffer));
     }
 
     virtual ~ServerNetworkManagerImpl()
@@ -562,6 +659,80 @@ public:
         start_udp_read_input_data_frame();
     }
 
+    /// Called during PSMoveService::startup()
+    /// Opens the multicast socket if the config has multicast enabled.
+    /// Multicast is optional so a failure here only leaves clients on unicast data frames.
+    void start_multicast_group()
+    {
+        m_config.load();
+
+        // Save the config back out again in case defaults changed
+        m_config.save();
+
+        if (!m_config.multicast_enabled)
+        {
+            return;
+        }
+
+        boost::system::error_code error;
+        const asio::ip::address group_address = 
+            asio::ip::address::from_string(m_config.multicast_group_address, error);
+
+        if (error || !group_address.is_v4() || !group_address.is_multicast())
+        {
+            SERVER_LOG_ERROR("ServerNetworkManager::start_multicast_group") 
+                << "\"" << m_config.multicast_group_address << "\" isn't an IPv4 multicast address. Multicast disabled.";
+            return;
+        }
+
+        m_multicast_socket.open(udp::v4(), error);
+        if (!error)
+        {
+            m_multicast_socket.set_option(asio::ip::multicast::hops(m_config.multicast_ttl), error);
+        }
+        if (!error)
+        {
+            m_multicast_socket.set_option(asio::ip::multicast::enable_loopback(m_config.multicast_loopback), error);
+        }
+        if (!error && !m_config.multicast_interface_address.empty())
+        {
+            const asio::ip::address interface_address = 
+                asio::ip::address::from_string(m_config.multicast_interface_address, error);
+
+            if (!error)
+            {
+                m_multicast_socket.set_option(asio::ip::multicast::outbound_interface(interface_address.to_v4()), error);
+            }
+        }
+
+        if (!error)
+        {
+            m_multicast_endpoint = udp::endpoint(group_address, static_cast<unsigned short>(m_config.multicast_port));
+
+            SERVER_LOG_INFO("ServerNetworkManager::start_multicast_group") 
+                << "Multicast data frames go to " << m_multicast_endpoint;
+        }
+        else
+        {
+            SERVER_LOG_ERROR("ServerNetworkManager::start_multicast_group") 
+                << "Failed to set up the multicast socket: " << error.message() << ". Multicast disabled.";
+
+            boost::system::error_code close_error;
+            m_multicast_socket.close(close_error);
+        }
+    }
+
+    bool get_multicast_group(std::string &out_address, int &out_port) const
+    {
+        if (m_multicast_socket.is_open())
+        {
+            out_address = m_multicast_endpoint.address().to_string();
+            out_port = m_multicast_endpoint.port();
+        }
+
+        return m_multicast_socket.is_open();
+    }
+
     void poll()
     {
         bool keep_polling= true;
@@ -570,8 +741,9 @@ public:
 
         while (keep_polling && iteration_count < k_max_iteration_count)
         {
-            // Start any pending writes on the UDP socket that can be started
+            // Start any pending writes on the UDP sockets that can be started
             start_udp_queued_data_frame_write();
+            start_multicast_queued_data_frame_write();
 
             // This call can execute any of the following callbacks:
             // * TCP request has finished reading
@@ -581,7 +753,9 @@ public:
 
             // In the event that a UDP data frame write completed immediately,
             // we should start another UDP data frame write.
-            keep_polling= has_queued_controller_data_frames_ready_to_start();
+            keep_polling= 
+                has_queued_controller_data_frames_ready_to_start() ||
+                (!m_has_pending_multicast_write && m_pending_multicast_dataframes.size() > 0);
 
             // ... but don't re-run this too many times
             ++iteration_count;
@@ -621,6 +795,20 @@ public:
             }
         }
 
+        // Close down the multicast socket
+        if (m_multicast_socket.is_open())
+        {
+            boost::system::error_code error;
+
+            m_multicast_socket.close(error);
+            if (error)
+            {
+                SERVER_LOG_ERROR("ServerNetworkManager::close_all_connections") << "Problem closing the multicast socket: " << error.message();
+            }
+        }
+        m_pending_multicast_dataframes.clear();
+        m_has_pending_multicast_write= false;
+
         m_connections.clear();
     }
 
@@ -650,6 +838,13 @@ public:
         }
     }
 
+    bool has_queued_responses(int connection_id)
+    {
+        t_client_connection_map_iter entry = m_connections.find(connection_id);
+
+        return entry != m_connections.end() && entry->second->has_queued_responses();
+    }
+
     void send_notification_to_all_clients(ResponsePtr response)
     {
         SERVER_LOG_DEBUG("ServerNetworkManager::send_notification") 
@@ -692,6 +887,30 @@ public:
         }
     }
 
+    void send_multicast_device_data_frame(DeviceOutputDataFramePtr data_frame)
+    {
+        if (m_multicast_socket.is_open())
+        {
+            SERVER_LOG_TRACE("ServerNetworkManager::send_multicast_device_data_frame") 
+                << "Sending data_frame to multicast group " << m_multicast_endpoint;
+
+            // Only grows when the socket falls behind; never drop queued frames
+            if (m_pending_multicast_dataframes.full())
+            {
+                m_pending_multicast_dataframes.set_capacity(m_pending_multicast_dataframes.capacity() * 2);
+            }
+
+            m_pending_multicast_dataframes.push_back(data_frame);
+
+            start_multicast_queued_data_frame_write();
+        }
+        else
+        {
+            SERVER_LOG_ERROR("ServerNetworkManager::send_multicast_device_data_frame") 
+                << "Can't send data_frame with multicast disabled";
+        }
+    }
+
     // -- IServerNetworkEventListener ----
 	virtual void handle_client_connection_stopped(int connection_id) override
     {
@@ -722,9 +941,11 @@ private:
     // The endpoint of the next connecting 
     udp::endpoint m_udp_connecting_remote_endpoint;
 
-    // A pending udp request from the client
-    uint8_t m_input_dataframe_buffer[HEADER_SIZE + MAX_INPUT_DATA_FRAME_MESSAGE_SIZE];
+    // A pending udp request from the client (or observations from a tracker node)
+    uint8_t m_input_dataframe_buffer[HEADER_SIZE + MAX_TRACKER_INPUT_DATA_FRAME_MESSAGE_SIZE];
     PackedMessage<PSMoveProtocol::DeviceInputDataFrame> m_packed_input_dataframe;
+    // Parses every input data frame into the same message without re-allocating its sub-messages
+    InPlaceMessageParser m_input_dataframe_parser;
 
     // A pending udp result sent to the client
     bool m_udp_connection_result_write_buffer;
@@ -732,14 +953,36 @@ private:
     // If true, we are already waiting for a client to send the connection id
     bool m_has_pending_udp_read;
 
+    // Only warn about the first rejected tracker node frame rather than every one of them
+    bool m_has_warned_unregistered_tracker_node;
+
     // A mapping from connection_id -> ClientConnectionPtr
     t_client_connection_map m_connections;
 
+    // Multicast group settings
+    ServerNetworkConfig m_config;
+
+    // UDP socket all multicast data frames go out on (only open when multicast is enabled)
+    udp::socket m_multicast_socket;
+    udp::endpoint m_multicast_endpoint;
+
+    // The multicast data frame currently being written
+    uint8_t m_multicast_dataframe_buffer[HEADER_SIZE+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
+    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> m_packed_multicast_dataframe;
+
+    // Multicast data frames waiting to be written
+    boost::circular_buffer<DeviceOutputDataFramePtr> m_pending_multicast_dataframes;
+
+    // If true, we are waiting on a multicast data frame write to finish
+    bool m_has_pending_multicast_write;
+
 protected:
     void handle_tcp_accept(ClientConnectionPtr connection, const boost::system::error_code& error)
     {        
         // A new client has connected
         //
+        AllocationTracker::noteConfigurationChange();
+
         if (!error)
         {
             SERVER_LOG_DEBUG("ServerNetworkManager::handle_tcp_accept") << "Accepting a new connection";
@@ -811,15 +1054,32 @@ protected:
         SERVER_LOG_DEBUG("    ") << show_hex(m_input_dataframe_buffer, total_len) << std::endl;
         SERVER_LOG_DEBUG("    ") << msg_len << " bytes" << std::endl;
 
-        // Parse the response buffer
-        if (m_packed_input_dataframe.unpack(m_input_dataframe_buffer, total_len))
+        // Parse the response buffer (the size in the header can't be trusted)
+        if (total_len <= sizeof(m_input_dataframe_buffer) &&
+            m_input_dataframe_parser.parse(
+                m_packed_input_dataframe.get_msg().get(), &m_input_dataframe_buffer[HEADER_SIZE], static_cast<int>(msg_len)))
         {
             DeviceInputDataFramePtr data_frame = m_packed_input_dataframe.get_msg();
 
             // Find the connection with the matching id
             t_client_connection_map_iter iter = m_connections.find(data_frame->connection_id());
 
-            if (iter != m_connections.end())
+            if (data_frame->device_category() == PSMoveProtocol::DeviceInputDataFrame_DeviceCategory_TRACKER)
+            {
+                // Tracker nodes stream observations without ever opening a client connection,
+                // so they have to present the shared tracker node token instead
+                if (is_registered_tracker_node(data_frame))
+                {
+                    m_request_handler_ref.handle_input_data_frame(data_frame);
+                }
+            }
+            else if (msg_len > MAX_INPUT_DATA_FRAME_MESSAGE_SIZE)
+            {
+                // Only tracker node observations get the bigger input buffer
+                SERVER_LOG_ERROR("ServerNetworkManager::handle_udp_data_frame_received")
+                    << "Ignoring oversized input data frame (" << msg_len << " bytes) from connection_id: " << data_frame->connection_id();
+            }
+            else if (iter != m_connections.end())
             {
                 SERVER_LOG_DEBUG("ServerNetworkManager::handle_udp_data_frame_received")
                     << "Found UDP client connected with matching connection_id: " << data_frame->connection_id();
@@ -854,6 +1114,32 @@ protected:
         }
     }
 
+    bool is_registered_tracker_node(DeviceInputDataFramePtr data_frame)
+    {
+        const std::string &expected_token = m_config.tracker_node_token;
+        const std::string &node_token = data_frame->tracker_data_packet().node_token();
+        bool bIsRegistered = !expected_token.empty() && node_token.size() == expected_token.size();
+
+        // Compare every character so the time taken doesn't give away how much of the token matched
+        unsigned char mismatch = 0;
+        for (size_t char_index = 0; bIsRegistered && char_index < expected_token.size(); ++char_index)
+        {
+            mismatch |= static_cast<unsigned char>(node_token[char_index] ^ expected_token[char_index]);
+        }
+        bIsRegistered = bIsRegistered && mismatch == 0;
+
+        if (!bIsRegistered && !m_has_warned_unregistered_tracker_node)
+        {
+            SERVER_LOG_WARNING("ServerNetworkManager::is_registered_tracker_node")
+                << "Ignoring observations from tracker node \"" << data_frame->tracker_data_packet().node_name()
+                << "\" at " << m_udp_connecting_remote_endpoint.address().to_string()
+                << ": its node_token doesn't match tracker_node_token in ServerNetworkConfig";
+            m_has_warned_unregistered_tracker_node = true;
+        }
+
+        return bIsRegistered;
+    }
+
     void start_udp_send_connection_result(bool success)
     {
         SERVER_LOG_DEBUG("ServerNetworkManager::start_udp_send_connection_result") 
@@ -895,6 +1181,58 @@ protected:
         }        
     }
 
+    // The multicast socket isn't shared with the connections, 
+    // so its writes don't have to wait on theirs
+    void start_multicast_queued_data_frame_write()
+    {
+        while (m_multicast_socket.is_open() && 
+               !m_has_pending_multicast_write && 
+               m_pending_multicast_dataframes.size() > 0)
+        {
+            DeviceOutputDataFramePtr dataframe= m_pending_multicast_dataframes.front();
+
+            m_packed_multicast_dataframe.set_msg(dataframe);
+            if (m_packed_multicast_dataframe.pack(m_multicast_dataframe_buffer, sizeof(m_multicast_dataframe_buffer)))
+            {
+                const int msg_size= m_packed_multicast_dataframe.get_msg()->ByteSize();
+
+                m_has_pending_multicast_write= true;
+
+                // Start an asynchronous operation to send the data frame
+                // (just the packed bytes, the client reads the length from the header)
+                // NOTE: Even if the write completes immediate, the callback will only be called from io_service::poll()
+                m_multicast_socket.async_send_to(
+                    boost::asio::buffer(m_multicast_dataframe_buffer, HEADER_SIZE+msg_size),
+                    m_multicast_endpoint,
+                    boost::bind(&ServerNetworkManagerImpl::handle_multicast_write_device_data_frame_complete, this, _1));
+            }
+            else
+            {
+                SERVER_LOG_ERROR("ServerNetworkManager::start_multicast_queued_data_frame_write") 
+                    << "DataFrame too big to fit in packet!";
+
+                m_pending_multicast_dataframes.pop_front();
+            }
+        }
+    }
+
+    void handle_multicast_write_device_data_frame_complete(const boost::system::error_code& ec)
+    {
+        // The socket was closed out from under the write
+        if (!m_has_pending_multicast_write)
+            return;
+
+        if (ec)
+        {
+            // Unlike a connection there's nothing to tear down, the frame is just lost
+            SERVER_LOG_WARNING("ServerNetworkManager::handle_multicast_write_device_data_frame_complete") 
+                << "Error sending multicast data frame: " << ec.message();
+        }
+
+        m_has_pending_multicast_write= false;
+        m_pending_multicast_dataframes.pop_front();
+    }
+
     bool has_queued_controller_data_frames_ready_to_start()
     {
         bool has_queued_write_ready_to_start= false;
@@ -953,6 +1291,7 @@ bool ServerNetworkManager::startup()
     m_instance= this;
     
     implementation_ptr->start_connection_accept();
+    implementation_ptr->start_multicast_group();
 
     return true;
 }
@@ -980,7 +1319,22 @@ void ServerNetworkManager::send_notification_to_all_clients(ResponsePtr response
     implementation_ptr->send_notification_to_all_clients(response);
 }
 
+bool ServerNetworkManager::has_queued_responses(int connection_id)
+{
+    return implementation_ptr->has_queued_responses(connection_id);
+}
+
 void ServerNetworkManager::send_device_data_frame(int connection_id, DeviceOutputDataFramePtr data_frame)
 {
     implementation_ptr->send_device_data_frame(connection_id, data_frame);
 }
+
+bool ServerNetworkManager::get_multicast_group(std::string &out_address, int &out_port) const
+{
+    return implementation_ptr->get_multicast_group(out_address, out_port);
+}
+
+void ServerNetworkManager::send_multicast_device_data_frame(DeviceOutputDataFramePtr data_frame)
+{
+    implementation_ptr->send_multicast_device_data_frame(data_frame);
+}
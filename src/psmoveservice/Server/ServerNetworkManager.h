@@ -3,6 +3,7 @@
 
 //-- includes -----
 #include "PSMoveProtocolInterface.h"
+#include <string>
 
 //-- pre-declarations -----
 class ServerRequestHandler;
@@ -52,9 +53,21 @@ public:
     void send_notification(int connection_id, ResponsePtr response);
     
     void send_notification_to_all_clients(ResponsePtr response);
+
+    /// True if the connection still has TCP responses or notifications waiting to be written.
+    /// Used to keep large, frequent notifications from piling up behind a slow client.
+    bool has_queued_responses(int connection_id);
     
     void send_device_data_frame(int connection_id, DeviceOutputDataFramePtr data_frame);
 
+    /// True if multicast is enabled in the ServerNetworkConfig and its socket opened.
+    /// out_address and out_port are the group clients join to receive multicast data frames.
+    bool get_multicast_group(std::string &out_address, int &out_port) const;
+
+    /// Sends the data frame once to every client that joined the multicast group.
+    /// Clients filter the frames by the device they're for.
+    void send_multicast_device_data_frame(DeviceOutputDataFramePtr data_frame);
+
 private:
     /// Must use the overloaded constructor
     ServerNetworkManager();
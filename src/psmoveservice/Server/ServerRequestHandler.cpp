@@ -1,6 +1,8 @@
 //-- includes -----
 #include "ServerRequestHandler.h"
 
+#include "AllocationTracker.h"
+
 #include "BluetoothRequests.h"
 #include "BluetoothQueries.h"
 #include "ControllerManager.h"
@@ -12,6 +14,7 @@
 #include "PSDualShock4Controller.h"
 #include "PSMoveController.h"
 #include "PSMoveProtocol.pb.h"
+#include "RemoteTracker.h"
 #include "ServerControllerView.h"
 #include "ServerDeviceView.h"
 #include "ServerNetworkManager.h"
@@ -20,11 +23,19 @@
 #include "ServerUtility.h"
 #include "TrackerManager.h"
 
+#include <algorithm>
 #include <cassert>
-#include <bitset>
+#include <cmath>
 #include <map>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 
+//-- constants -----
+// Change-only streams still get a frame this often so a dropped UDP packet can't leave a client stale
+static const long long k_change_only_keepalive_usec = 1000000;
+// Coarsest color mask preview resolution a client can ask for (1/8th of the video frame)
+static const int k_max_color_mask_preview_downscale = 8;
+
 //-- pre-declarations -----
 class ServerRequestHandlerImpl;
 typedef boost::shared_ptr<ServerRequestHandlerImpl> ServerRequestHandlerImplPtr;
@@ -33,24 +44,33 @@ typedef boost::shared_ptr<ServerRequestHandlerImpl> ServerRequestHandlerImplPtr;
 struct RequestConnectionState
 {
     int connection_id;
-    std::bitset<ControllerManager::k_max_devices> active_controller_streams;
-    std::bitset<TrackerManager::k_max_devices> active_tracker_streams;
+    // Stream subscription flags and per-stream settings, one entry per device slot.
+    // Sized to the device capacities the DeviceManager was started with.
+    std::vector<bool> active_controller_streams;
+    std::vector<bool> active_tracker_streams;
     AsyncBluetoothRequest *pending_bluetooth_request;
-    ControllerStreamInfo active_controller_stream_info[ControllerManager::k_max_devices];
-    TrackerStreamInfo active_tracker_stream_info[TrackerManager::k_max_devices];
+    std::vector<ControllerStreamInfo> active_controller_stream_info;
+    std::vector<TrackerStreamInfo> active_tracker_stream_info;
+    // Data frames each stream has published, kept for reuse (see acquire_stream_data_frame)
+    std::vector<std::vector<DeviceOutputDataFramePtr> > controller_stream_data_frames;
+    std::vector<std::vector<DeviceOutputDataFramePtr> > tracker_stream_data_frames;
 
-    RequestConnectionState()
+    RequestConnectionState(const int controller_count, const int tracker_count)
         : connection_id(-1)
-        , active_controller_streams()
-        , active_tracker_streams()
+        , active_controller_streams(controller_count, false)
+        , active_tracker_streams(tracker_count, false)
         , pending_bluetooth_request(nullptr)
+        , active_controller_stream_info(controller_count)
+        , active_tracker_stream_info(tracker_count)
+        , controller_stream_data_frames(controller_count)
+        , tracker_stream_data_frames(tracker_count)
     {
-        for (int index = 0; index < ControllerManager::k_max_devices; ++index)
+        for (int index = 0; index < controller_count; ++index)
         {
             active_controller_stream_info[index].Clear();
         }
 
-        for (int index = 0; index < TrackerManager::k_max_devices; ++index)
+        for (int index = 0; index < tracker_count; ++index)
         {
             active_tracker_stream_info[index].Clear();
         }
@@ -68,6 +88,24 @@ struct RequestContext
     RequestPtr request;
 };
 
+// The data frames shared by every connection streaming a controller over multicast
+struct MulticastControllerStream
+{
+    int subscriber_count;
+    // Settings merged from all of the subscribers (see rebuild_multicast_controller_stream)
+    ControllerStreamInfo stream_info;
+    // Data frames the stream has published, kept for reuse (see acquire_stream_data_frame)
+    std::vector<DeviceOutputDataFramePtr> data_frames;
+
+    MulticastControllerStream()
+        : subscriber_count(0)
+        , stream_info()
+        , data_frames()
+    {
+        stream_info.Clear();
+    }
+};
+
 //-- private implementation -----
 class ServerRequestHandlerImpl
 {
@@ -75,6 +113,8 @@ public:
     ServerRequestHandlerImpl(DeviceManager &deviceManager)
         : m_device_manager(deviceManager)
         , m_connection_state_map()
+        , m_multicast_controller_streams()
+        , m_remote_tracker_frame()
     {
     }
 
@@ -260,6 +300,11 @@ public:
                 handle_request__search_for_new_trackers(context, response);
                 break;
 
+            case PSMoveProtocol::Request_RequestType_GET_SERVICE_STATS:
+                response = new PSMoveProtocol::Response;
+                handle_request__get_service_stats(context, response);
+                break;
+
             default:
                 assert(0 && "Whoops, bad request!");
         }
@@ -274,15 +319,20 @@ public:
 
     void handle_input_data_frame(DeviceInputDataFramePtr data_frame)
     {
-        // The context holds everything a handler needs to evaluate a request
-        RequestConnectionStatePtr connection_state = FindOrCreateConnectionState(data_frame->connection_id());
-
         switch (data_frame->device_category())
         {
         case PSMoveProtocol::DeviceInputDataFrame::DeviceCategory::DeviceInputDataFrame_DeviceCategory_CONTROLLER:
             {
+                // The context holds everything a handler needs to evaluate a request
+                RequestConnectionStatePtr connection_state = FindOrCreateConnectionState(data_frame->connection_id());
+
                 handle_data_frame__controller_packet(connection_state, data_frame);
             } break;
+        case PSMoveProtocol::DeviceInputDataFrame::DeviceCategory::DeviceInputDataFrame_DeviceCategory_TRACKER:
+            {
+                // Tracker nodes don't have a client connection
+                handle_data_frame__tracker_packet(data_frame);
+            } break;
         }
     }
 
@@ -307,7 +357,7 @@ public:
             }
 
             // Clean up any controller state related to this connection
-            for (int controller_id = 0; controller_id < ControllerManager::k_max_devices; ++controller_id)
+            for (int controller_id = 0; controller_id < m_device_manager.getControllerViewMaxCount(); ++controller_id)
             {
                 const ControllerStreamInfo &streamInfo = connection_state->active_controller_stream_info[controller_id];
                 ServerControllerViewPtr controller_view = m_device_manager.getControllerViewPtr(controller_id);
@@ -329,17 +379,31 @@ public:
                 }
             }
 
-            // Halt any shared memory streams this connection has going
-            for (int tracker_id = 0; tracker_id < TrackerManager::k_max_devices; ++tracker_id)
+            // Halt any shared memory and network video streams this connection has going
+            for (int tracker_id = 0; tracker_id < m_device_manager.getTrackerViewMaxCount(); ++tracker_id)
             {
                 if (connection_state->active_tracker_stream_info[tracker_id].streaming_video_data)
                 {
                     m_device_manager.getTrackerViewPtr(tracker_id)->stopSharedMemoryVideoStream();
                 }
+
+                if (connection_state->active_tracker_stream_info[tracker_id].streaming_network_video)
+                {
+                    m_device_manager.getTrackerViewPtr(tracker_id)->stopNetworkVideoStream();
+                }
             }
 
             // Remove the connection state from the state map
             m_connection_state_map.erase(iter);
+
+            // Drop the connection's settings from any multicast streams it subscribed to
+            for (int controller_id = 0; controller_id < m_device_manager.getControllerViewMaxCount(); ++controller_id)
+            {
+                if (connection_state->active_controller_stream_info[controller_id].use_multicast)
+                {
+                    rebuild_multicast_controller_stream(controller_id);
+                }
+            }
         }
     }
 
@@ -347,7 +411,13 @@ public:
          ServerControllerView *controller_view, 
          ServerRequestHandler::t_generate_controller_data_frame_for_stream callback)
     {
-        int controller_id= controller_view->getDeviceID();
+        const int controller_id= controller_view->getDeviceID();
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now= 
+            std::chrono::high_resolution_clock::now();
+
+        // Only computed if a change-only stream is listening, then shared by all of them
+        ControllerStreamSnapshot snapshot;
+        bool bHasSnapshot= false;
 
         // Notify any connections that care about the controller update
         for (t_connection_state_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
@@ -355,17 +425,64 @@ public:
             int connection_id= iter->first;
             RequestConnectionStatePtr connection_state= iter->second;
 
-            if (connection_state->active_controller_streams.test(controller_id))
+            if (connection_state->active_controller_streams[controller_id])
             {
-                const ControllerStreamInfo &streamInfo=
+                ControllerStreamInfo &streamInfo=
                     connection_state->active_controller_stream_info[controller_id];
 
+                // Multicast subscribers get the shared data frame sent below
+                if (streamInfo.use_multicast)
+                {
+                    continue;
+                }
+
+                if (streamInfo.publish_on_change_only && !bHasSnapshot)
+                {
+                    controller_view->getStreamSnapshot(snapshot);
+                    bHasSnapshot= true;
+                }
+
+                // Skip streams that are over their rate cap or haven't seen a big enough change
+                if (!should_publish_to_stream(streamInfo, now, snapshot))
+                {
+                    continue;
+                }
+
                 // Fill out a data frame specific to this stream using the given callback
-                DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame);
+                DeviceOutputDataFramePtr data_frame= 
+                    acquire_stream_data_frame(connection_state->controller_stream_data_frames[controller_id]);
+                ++streamInfo.stream_sequence_number;
                 callback(controller_view, &streamInfo, data_frame);
 
                 // Send the controller data frame over the network
                 ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
+
+                mark_stream_published(streamInfo, now, snapshot);
+            }
+        }
+
+        // Serialize and send a single data frame for all of the multicast subscribers
+        if (controller_id < static_cast<int>(m_multicast_controller_streams.size()) &&
+            m_multicast_controller_streams[controller_id].subscriber_count > 0)
+        {
+            MulticastControllerStream &multicast_stream= m_multicast_controller_streams[controller_id];
+            ControllerStreamInfo &streamInfo= multicast_stream.stream_info;
+
+            if (streamInfo.publish_on_change_only && !bHasSnapshot)
+            {
+                controller_view->getStreamSnapshot(snapshot);
+                bHasSnapshot= true;
+            }
+
+            if (should_publish_to_stream(streamInfo, now, snapshot))
+            {
+                DeviceOutputDataFramePtr data_frame= acquire_stream_data_frame(multicast_stream.data_frames);
+                ++streamInfo.stream_sequence_number;
+                callback(controller_view, &streamInfo, data_frame);
+
+                ServerNetworkManager::get_instance()->send_multicast_device_data_frame(data_frame);
+
+                mark_stream_published(streamInfo, now, snapshot);
             }
         }
     }
@@ -382,22 +499,232 @@ public:
             int connection_id = iter->first;
             RequestConnectionStatePtr connection_state = iter->second;
 
-            if (connection_state->active_tracker_streams.test(tracker_id))
+            if (connection_state->active_tracker_streams[tracker_id])
             {
-                const TrackerStreamInfo &streamInfo =
+                TrackerStreamInfo &streamInfo =
                     connection_state->active_tracker_stream_info[tracker_id];
+                const TrackerColorMaskPreview *mask_preview = nullptr;
+                int mask_row = 0;
 
-                // Fill out a data frame specific to this stream using the given callback
-                DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame);
-                callback(tracker_view, &streamInfo, data_frame);
+                if (streamInfo.include_color_mask_preview)
+                {
+                    mask_preview = tracker_view->computeColorMaskPreview(
+                        get_controller_view_or_null(streamInfo.mask_controller_id),
+                        streamInfo.mask_tracking_color,
+                        streamInfo.mask_downscale);
+                }
 
-                // Send the tracker data frame over the network
-                ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
+                // A mask preview gets split across as many data frames as it takes
+                do
+                {
+                    // Fill out a data frame specific to this stream using the given callback
+                    DeviceOutputDataFramePtr data_frame = 
+                        acquire_stream_data_frame(connection_state->tracker_stream_data_frames[tracker_id]);
+                    callback(tracker_view, &streamInfo, data_frame);
+
+                    if (mask_preview != nullptr)
+                    {
+                        mask_row = ServerTrackerView::generateColorMaskPreviewDataFrame(mask_preview, mask_row, data_frame);
+                    }
+                    else if (data_frame->tracker_data_packet().has_color_mask_preview())
+                    {
+                        // Don't resend the mask rows left in a recycled data frame
+                        data_frame->mutable_tracker_data_packet()->clear_color_mask_preview();
+                    }
+
+                    // Send the tracker data frame over the network
+                    ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
+                } while (mask_preview != nullptr && mask_row < mask_preview->height);
+
+                if (streamInfo.streaming_network_video)
+                {
+                    publish_network_video_frame(connection_id, tracker_view, streamInfo);
+                }
             }
         }
     }
 
 protected:
+    // Sends the tracker's latest compressed video frame if this connection hasn't seen it yet.
+    // Frames are skipped while the connection is still writing earlier ones
+    // so a slow client only ever falls one frame behind.
+    void publish_network_video_frame(
+        int connection_id,
+        const ServerTrackerView *tracker_view,
+        TrackerStreamInfo &streamInfo)
+    {
+        TrackerNetworkVideoFramePtr video_frame = tracker_view->getLatestNetworkVideoFrame();
+
+        if (video_frame && 
+            video_frame->frame_sequence_num != streamInfo.last_network_video_frame_sequence_num &&
+            !ServerNetworkManager::get_instance()->has_queued_responses(connection_id))
+        {
+            ResponsePtr notification(new PSMoveProtocol::Response);
+            PSMoveProtocol::Response_ResultTrackerVideoFrame *video_frame_result = 
+                notification->mutable_result_tracker_video_frame();
+
+            notification->set_type(PSMoveProtocol::Response_ResponseType_TRACKER_VIDEO_FRAME);
+            notification->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+
+            video_frame_result->set_tracker_id(tracker_view->getDeviceID());
+            video_frame_result->set_frame_sequence_num(video_frame->frame_sequence_num);
+            video_frame_result->set_frame_width(video_frame->frame_width);
+            video_frame_result->set_frame_height(video_frame->frame_height);
+            video_frame_result->set_downscale(video_frame->downscale);
+            video_frame_result->set_jpeg_data(video_frame->jpeg_data.data(), video_frame->jpeg_data.size());
+
+            ServerNetworkManager::get_instance()->send_notification(connection_id, notification);
+            streamInfo.last_network_video_frame_sequence_num = video_frame->frame_sequence_num;
+        }
+    }
+
+    // Returns one of the stream's data frames that the network manager is done sending.
+    // A stream always fills its frames with the same callback and stream settings, 
+    // which overwrite every field they set the last time, so the frames aren't cleared first
+    // (clearing a proto3 message frees its sub-messages, which would just be allocated again).
+    // Only allocates while the stream warms up or when the send queue backs up.
+    static DeviceOutputDataFramePtr acquire_stream_data_frame(std::vector<DeviceOutputDataFramePtr> &stream_frames)
+    {
+        for (const DeviceOutputDataFramePtr &data_frame : stream_frames)
+        {
+            if (data_frame.use_count() == 1)
+            {
+                return data_frame;
+            }
+        }
+
+        stream_frames.push_back(DeviceOutputDataFramePtr(new PSMoveProtocol::DeviceOutputDataFrame));
+
+        return stream_frames.back();
+    }
+
+    static void mark_stream_published(
+        ControllerStreamInfo &streamInfo,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &now,
+        const ControllerStreamSnapshot &snapshot)
+    {
+        streamInfo.last_publish_timestamp= now;
+        streamInfo.has_published= true;
+        if (streamInfo.publish_on_change_only)
+        {
+            streamInfo.last_published_snapshot= snapshot;
+        }
+    }
+
+    // Merges the settings of every connection streaming the controller over multicast.
+    // The shared data frames include anything any subscriber asked for and go out as often 
+    // as the least rate limited subscriber asked for. They're only change-only if every subscriber is.
+    void rebuild_multicast_controller_stream(int controller_id)
+    {
+        const int controller_count= m_device_manager.getControllerViewMaxCount();
+
+        if (static_cast<int>(m_multicast_controller_streams.size()) < controller_count)
+        {
+            m_multicast_controller_streams.resize(controller_count);
+        }
+
+        MulticastControllerStream &multicast_stream= m_multicast_controller_streams[controller_id];
+        ControllerStreamInfo &merged= multicast_stream.stream_info;
+        // Subscribers coming and going doesn't restart the numbering the other subscribers count gaps with
+        const int stream_sequence_number= merged.stream_sequence_number;
+
+        // (any frames filled with the old settings could hold fields the new ones never overwrite)
+        multicast_stream.subscriber_count= 0;
+        multicast_stream.data_frames.clear();
+        merged.Clear();
+        merged.stream_sequence_number= stream_sequence_number;
+
+        for (t_connection_state_const_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
+        {
+            const RequestConnectionStatePtr &connection_state= iter->second;
+            const ControllerStreamInfo &streamInfo= connection_state->active_controller_stream_info[controller_id];
+
+            if (!connection_state->active_controller_streams[controller_id] || !streamInfo.use_multicast)
+            {
+                continue;
+            }
+
+            if (multicast_stream.subscriber_count == 0)
+            {
+                merged.min_publish_interval_usec= streamInfo.min_publish_interval_usec;
+                merged.publish_on_change_only= streamInfo.publish_on_change_only;
+                merged.position_change_threshold= streamInfo.position_change_threshold;
+                merged.orientation_change_threshold= streamInfo.orientation_change_threshold;
+            }
+            else
+            {
+                merged.min_publish_interval_usec= 
+                    std::min(merged.min_publish_interval_usec, streamInfo.min_publish_interval_usec);
+                merged.publish_on_change_only= merged.publish_on_change_only && streamInfo.publish_on_change_only;
+                merged.position_change_threshold= 
+                    fminf(merged.position_change_threshold, streamInfo.position_change_threshold);
+                merged.orientation_change_threshold= 
+                    fminf(merged.orientation_change_threshold, streamInfo.orientation_change_threshold);
+            }
+
+            merged.include_position_data|= streamInfo.include_position_data;
+            merged.include_physics_data|= streamInfo.include_physics_data;
+            merged.include_raw_sensor_data|= streamInfo.include_raw_sensor_data;
+            merged.include_calibrated_sensor_data|= streamInfo.include_calibrated_sensor_data;
+            merged.include_raw_tracker_data|= streamInfo.include_raw_tracker_data;
+            merged.use_multicast= true;
+
+            ++multicast_stream.subscriber_count;
+        }
+    }
+
+    static bool should_publish_to_stream(
+        const ControllerStreamInfo &streamInfo,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &now,
+        const ControllerStreamSnapshot &snapshot)
+    {
+        if (!streamInfo.has_published)
+        {
+            return true;
+        }
+
+        const long long usec_since_publish= 
+            std::chrono::duration_cast<std::chrono::microseconds>(now - streamInfo.last_publish_timestamp).count();
+
+        if (usec_since_publish < streamInfo.min_publish_interval_usec)
+        {
+            return false;
+        }
+
+        if (streamInfo.publish_on_change_only && usec_since_publish < k_change_only_keepalive_usec)
+        {
+            const ControllerStreamSnapshot &last= streamInfo.last_published_snapshot;
+
+            if (snapshot.all_buttons != last.all_buttons ||
+                snapshot.battery != last.battery ||
+                snapshot.is_tracking != last.is_tracking ||
+                memcmp(snapshot.analog_inputs, last.analog_inputs, sizeof(snapshot.analog_inputs)) != 0)
+            {
+                return true;
+            }
+
+            const float dx= snapshot.position.x - last.position.x;
+            const float dy= snapshot.position.y - last.position.y;
+            const float dz= snapshot.position.z - last.position.z;
+            const float position_delta_sqr= dx*dx + dy*dy + dz*dz;
+
+            if (position_delta_sqr > streamInfo.position_change_threshold*streamInfo.position_change_threshold)
+            {
+                return true;
+            }
+
+            // Angle between the two orientations: 2*acos(|q1.q2|)
+            const float dot= fabsf(
+                snapshot.orientation.w*last.orientation.w + snapshot.orientation.x*last.orientation.x +
+                snapshot.orientation.y*last.orientation.y + snapshot.orientation.z*last.orientation.z);
+            const float angle_delta= 2.f*acosf(fminf(dot, 1.f));
+
+            return angle_delta > streamInfo.orientation_change_threshold;
+        }
+
+        return true;
+    }
+
     RequestConnectionStatePtr FindOrCreateConnectionState(int connection_id)
     {
         t_connection_state_iter iter= m_connection_state_map.find(connection_id);
@@ -405,7 +732,11 @@ protected:
 
         if (iter == m_connection_state_map.end())
         {
-            connection_state= RequestConnectionStatePtr(new RequestConnectionState());
+            connection_state= 
+                RequestConnectionStatePtr(
+                    new RequestConnectionState(
+                        m_device_manager.getControllerViewMaxCount(),
+                        m_device_manager.getTrackerViewMaxCount()));
             connection_state->connection_id= connection_id;
 
             m_connection_state_map.insert(t_id_connection_state_pair(connection_id, connection_state));
@@ -485,6 +816,17 @@ protected:
                 controller_info->set_device_path(controller_view->getUSBDevicePath());
                 controller_info->set_device_serial(controller_view->getSerial());
                 controller_info->set_assigned_host_serial(controller_view->getAssignedHostBluetoothAddress());
+
+                const CommonControllerReportStatistics &report_statistics= controller_view->getReportStatistics();
+                controller_info->set_received_report_count(report_statistics.ReceivedReportCount);
+                controller_info->set_dropped_report_count(report_statistics.DroppedReportCount);
+                controller_info->set_report_rate(report_statistics.ReportRate);
+
+                const ControllerOpticalPoseEstimation *multicam_pose_estimate= controller_view->getMulticamPoseEstimate();
+                if (multicam_pose_estimate != nullptr)
+                {
+                    controller_info->set_optical_capture_skew(multicam_pose_estimate->capture_skew_milliseconds);
+                }
             }
         }
 
@@ -510,16 +852,49 @@ protected:
 
                 // The controller manager will always publish updates regardless of who is listening.
                 // All we have to do is keep track of which connections care about the updates.
-                context.connection_state->active_controller_streams.set(controller_id, true);
+                context.connection_state->active_controller_streams[controller_id]= true;
 
                 // Set control flags for the stream
+                // (any frames filled with the old settings could hold fields the new ones never overwrite)
                 streamInfo.Clear();
+                context.connection_state->controller_stream_data_frames[controller_id].clear();
                 streamInfo.include_position_data = request.include_position_data();
                 streamInfo.include_physics_data = request.include_physics_data();
                 streamInfo.include_raw_sensor_data = request.include_raw_sensor_data();
                 streamInfo.include_calibrated_sensor_data = request.include_calibrated_sensor_data();
                 streamInfo.include_raw_tracker_data = request.include_raw_tracker_data();
 
+                // Set rate and change-only publishing limits for the stream
+                if (request.max_publish_rate_hz() > 0.f)
+                {
+                    streamInfo.min_publish_interval_usec = 
+                        static_cast<long long>(1000000.0 / static_cast<double>(request.max_publish_rate_hz()));
+                }
+                streamInfo.publish_on_change_only = request.publish_on_change_only();
+                streamInfo.position_change_threshold = fmaxf(request.position_change_threshold_cm(), 0.f);
+                streamInfo.orientation_change_threshold = 
+                    fmaxf(request.orientation_change_threshold_deg(), 0.f) * 3.14159265f / 180.f;
+
+                // Join the controller's shared multicast stream if the service has a group to send to
+                std::string multicast_group_address;
+                int multicast_port= 0;
+
+                if (request.use_multicast())
+                {
+                    if (ServerNetworkManager::get_instance()->get_multicast_group(multicast_group_address, multicast_port))
+                    {
+                        streamInfo.use_multicast = true;
+                    }
+                    else
+                    {
+                        SERVER_LOG_INFO("ServerRequestHandler::start_controller_data_stream") 
+                            << "Multicast is disabled, streaming controller " << controller_id << " over unicast instead";
+                    }
+                }
+
+                // Also called for unicast streams in case this connection was a multicast subscriber
+                rebuild_multicast_controller_stream(controller_id);
+
                 if (streamInfo.include_position_data)
                 {
                     ServerControllerViewPtr controller_view = m_device_manager.getControllerViewPtr(controller_id);
@@ -527,6 +902,17 @@ protected:
                     controller_view->startTracking();
                 }
 
+                // Let the client know where to listen for the data frames
+                response->set_type(PSMoveProtocol::Response_ResponseType_CONTROLLER_DATA_STREAM_STARTED);
+                if (streamInfo.use_multicast)
+                {
+                    PSMoveProtocol::Response_ResultControllerDataStreamStarted *stream_result=
+                        response->mutable_result_controller_data_stream_started();
+
+                    stream_result->set_multicast_group_address(multicast_group_address);
+                    stream_result->set_multicast_port(multicast_port);
+                }
+
                 response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
             }
             else
@@ -564,8 +950,16 @@ protected:
                     controller_view->clearLEDOverride();
                 }
 
-                context.connection_state->active_controller_streams.set(controller_id, false);
+                const bool bWasMulticast= streamInfo.use_multicast;
+
+                context.connection_state->active_controller_streams[controller_id]= false;
                 context.connection_state->active_controller_stream_info[controller_id].Clear();
+                context.connection_state->controller_stream_data_frames[controller_id].clear();
+
+                if (bWasMulticast)
+                {
+                    rebuild_multicast_controller_stream(controller_id);
+                }
 
                 response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
             }
@@ -801,7 +1195,7 @@ protected:
                 config->magnetometer_basis_z = basis_z;
             }
 
-            config->save();
+            config->saveDeferred();
 
             // Reset the orientation filter state the calibration changed
             ControllerView->getOrientationFilterMutable()->resetFilterState();
@@ -833,7 +1227,7 @@ protected:
 
             // Save the noise radius in controller config
             config->accelerometer_noise_radius= request.noise_radius();
-            config->save();
+            config->saveDeferred();
 
             // Reset the orientation filter state the calibration changed
             positionFilter->setAccelerometerNoiseRadius(config->accelerometer_noise_radius);
@@ -852,7 +1246,7 @@ protected:
 
             // Save the noise radius in controller config
             config->accelerometer_noise_radius= request.noise_radius();
-            config->save();
+            config->saveDeferred();
 
             // Reset the orientation filter state the calibration changed
             positionFilter->setAccelerometerNoiseRadius(config->accelerometer_noise_radius);
@@ -884,7 +1278,7 @@ protected:
 
             config->gyro_drift= request.drift();
             config->gyro_variance= request.variance();
-            config->save();
+            config->saveDeferred();
 
             // Reset the orientation filter state the calibration changed
             ControllerView->getOrientationFilterMutable()->resetFilterState();
@@ -901,7 +1295,7 @@ protected:
 
             config->gyro_drift= request.drift();
             config->gyro_variance= request.variance();
-            config->save();
+            config->saveDeferred();
 
             // Reset the orientation filter state the calibration changed
             ControllerView->getOrientationFilterMutable()->resetFilterState();
@@ -953,6 +1347,9 @@ protected:
                 case CommonControllerState::PS3EYE:
                     tracker_info->set_tracker_type(PSMoveProtocol::PS3EYE);
                     break;
+                case CommonControllerState::RemoteTracker:
+                    tracker_info->set_tracker_type(PSMoveProtocol::REMOTE_TRACKER);
+                    break;
                 default:
                     assert(0 && "Unhandled tracker type");
                 }
@@ -972,6 +1369,9 @@ protected:
                 case ITrackerInterface::Generic_Webcam:
                     tracker_info->set_tracker_driver(PSMoveProtocol::GENERIC_WEBCAM);
                     break;
+                case ITrackerInterface::Network:
+                    tracker_info->set_tracker_driver(PSMoveProtocol::NETWORK);
+                    break;
                 default:
                     assert(0 && "Unhandled tracker type");
                 }
@@ -1017,7 +1417,16 @@ protected:
                     CommonDevicePose pose= tracker_view->getTrackerPose();
 
                     common_device_pose_to_protocol_pose(pose, tracker_info->mutable_tracker_pose());
-                }                
+                }
+
+                // Get the measured frame timing for the current video mode
+                {
+                    const TrackerFrameStatistics &frame_statistics= tracker_view->getFrameStatistics();
+
+                    tracker_info->set_frame_rate(frame_statistics.frame_rate);
+                    tracker_info->set_frame_interval_jitter(frame_statistics.frame_interval_jitter);
+                    tracker_info->set_frame_latency(frame_statistics.frame_latency);
+                }
             }
         }
 
@@ -1031,8 +1440,11 @@ protected:
         const PSMoveProtocol::Request_RequestStartTrackerDataStream& request =
             context.request->request_start_tracker_data_stream();
         int tracker_id = request.tracker_id();
+        // The mask color indexes the tracker's color presets
+        const int mask_tracking_color = static_cast<int>(request.mask_tracking_color());
 
-        if (ServerUtility::is_index_valid(tracker_id, m_device_manager.getTrackerViewMaxCount()))
+        if (ServerUtility::is_index_valid(tracker_id, m_device_manager.getTrackerViewMaxCount()) &&
+            ServerUtility::is_index_valid(mask_tracking_color, static_cast<int>(eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES)))
         {
             ServerTrackerViewPtr tracker_view = m_device_manager.getTrackerViewPtr(tracker_id);
 
@@ -1041,15 +1453,45 @@ protected:
                 TrackerStreamInfo &streamInfo =
                     context.connection_state->active_tracker_stream_info[tracker_id];
 
-                // The tracker manager will always publish updates regardless of who is listening.
-                // All we have to do is keep track of which connections care about the updates.
-                context.connection_state->active_tracker_streams.set(tracker_id, true);
+                // Restarting a running stream only changes its mask preview and network video settings
+                if (!context.connection_state->active_tracker_streams[tracker_id])
+                {
+                    // The tracker manager will always publish updates regardless of who is listening.
+                    // All we have to do is keep track of which connections care about the updates.
+                    context.connection_state->active_tracker_streams[tracker_id]= true;
 
-                // Set control flags for the stream
-                streamInfo.streaming_video_data = true;
+                    // Set control flags for the stream
+                    streamInfo.streaming_video_data = true;
+
+                    // Increment the number of stream listeners
+                    tracker_view->startSharedMemoryVideoStream();
+                }
+
+                streamInfo.include_color_mask_preview = request.include_color_mask_preview();
+                streamInfo.mask_tracking_color = static_cast<eCommonTrackingColorID>(mask_tracking_color);
+                streamInfo.mask_controller_id = request.mask_controller_id();
+                streamInfo.mask_downscale = 
+                    std::max(std::min(request.mask_downscale(), k_max_color_mask_preview_downscale), 1);
 
-                // Increment the number of stream listeners
-                tracker_view->startSharedMemoryVideoStream();
+                if (request.include_network_video())
+                {
+                    if (!streamInfo.streaming_network_video)
+                    {
+                        streamInfo.streaming_network_video = true;
+                        streamInfo.last_network_video_frame_sequence_num = -1;
+                        tracker_view->startNetworkVideoStream();
+                    }
+
+                    tracker_view->setNetworkVideoStreamSettings(
+                        request.network_video_max_rate_hz(),
+                        request.network_video_downscale(),
+                        request.network_video_jpeg_quality());
+                }
+                else if (streamInfo.streaming_network_video)
+                {
+                    streamInfo.streaming_network_video = false;
+                    tracker_view->stopNetworkVideoStream();
+                }
 
                 // Return the name of the shared memory block the video frames will be written to
                 response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
@@ -1078,11 +1520,23 @@ protected:
 
             if (tracker_view->getIsOpen())
             {
-                context.connection_state->active_tracker_streams.set(tracker_id, false);
-                context.connection_state->active_tracker_stream_info[tracker_id].Clear();
+                TrackerStreamInfo &streamInfo =
+                    context.connection_state->active_tracker_stream_info[tracker_id];
 
                 // Decrement the number of stream listeners
-                tracker_view->stopSharedMemoryVideoStream();
+                if (streamInfo.streaming_video_data)
+                {
+                    tracker_view->stopSharedMemoryVideoStream();
+                }
+
+                if (streamInfo.streaming_network_video)
+                {
+                    tracker_view->stopNetworkVideoStream();
+                }
+
+                context.connection_state->active_tracker_streams[tracker_id]= false;
+                streamInfo.Clear();
+                context.connection_state->tracker_stream_data_frames[tracker_id].clear();
 
                 response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
             }
@@ -1469,6 +1923,29 @@ protected:
         response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
     }
 
+    void handle_request__get_service_stats(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        const DeviceManagerServiceStats &stats = m_device_manager.getServiceStats();
+        PSMoveProtocol::Response_ResultServiceStats *service_stats = response->mutable_result_service_stats();
+
+        response->set_type(PSMoveProtocol::Response_ResponseType_SERVICE_STATS);
+
+        service_stats->set_stats_window(static_cast<float>(stats.stats_window_seconds));
+        service_stats->set_update_count(stats.update_count);
+        service_stats->set_predict_time_avg(static_cast<float>(stats.predict_avg_usec));
+        service_stats->set_predict_time_max(static_cast<float>(stats.predict_max_usec));
+        service_stats->set_publish_time_avg(static_cast<float>(stats.publish_avg_usec));
+        service_stats->set_publish_time_max(static_cast<float>(stats.publish_max_usec));
+        service_stats->set_wakeup_latency_avg(static_cast<float>(stats.wakeup_latency_avg_usec));
+        service_stats->set_wakeup_latency_max(static_cast<float>(stats.wakeup_latency_max_usec));
+        service_stats->set_late_wakeup_count(stats.late_wakeup_count);
+        service_stats->set_late_wakeup_threshold(static_cast<float>(stats.late_wakeup_threshold_usec));
+
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+    }
+
     // -- Data Frame Updates -----
     void handle_data_frame__controller_packet(
         RequestConnectionStatePtr connection_state,
@@ -1577,9 +2054,105 @@ protected:
         }
     }
 
+    void handle_data_frame__tracker_packet(
+        DeviceInputDataFramePtr data_frame)
+    {
+        const auto &trackerDataPacket = data_frame->tracker_data_packet();
+        // Reused for every data frame so its path and observation list keep their storage
+        RemoteTrackerFrame &frame = m_remote_tracker_frame;
+
+        RemoteTrackerFrame::makeDevicePath(
+            trackerDataPacket.node_name(), trackerDataPacket.node_tracker_id(), frame.device_path);
+        frame.frame_id = trackerDataPacket.frame_id();
+        frame.capture_timestamp_usec = trackerDataPacket.capture_timestamp_usec();
+        frame.receive_timestamp = std::chrono::high_resolution_clock::now();
+
+        frame.pixel_width = static_cast<int>(trackerDataPacket.tracker_screen_dimensions().x());
+        frame.pixel_height = static_cast<int>(trackerDataPacket.tracker_screen_dimensions().y());
+        frame.focal_length_x = trackerDataPacket.tracker_focal_lengths().x();
+        frame.focal_length_y = trackerDataPacket.tracker_focal_lengths().y();
+        frame.principal_x = trackerDataPacket.tracker_principal_point().x();
+        frame.principal_y = trackerDataPacket.tracker_principal_point().y();
+        frame.hfov = trackerDataPacket.tracker_hfov();
+        frame.vfov = trackerDataPacket.tracker_vfov();
+        frame.znear = trackerDataPacket.tracker_znear();
+        frame.zfar = trackerDataPacket.tracker_zfar();
+
+        frame.observations.clear();
+        for (const auto &observationPacket : trackerDataPacket.observations())
+        {
+            const int color_index = static_cast<int>(observationPacket.tracking_color());
+            RemoteTrackerObservation observation;
+
+            if (!ServerUtility::is_index_valid(color_index, static_cast<int>(eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES)))
+            {
+                continue;
+            }
+
+            observation.tracking_color_id = static_cast<eCommonTrackingColorID>(color_index);
+            observation.position.set(
+                observationPacket.position().x(), observationPacket.position().y(), observationPacket.position().z());
+
+            observation.bOrientationValid = observationPacket.orientation_valid();
+            observation.orientation.w = observationPacket.orientation().w();
+            observation.orientation.x = observationPacket.orientation().x();
+            observation.orientation.y = observationPacket.orientation().y();
+            observation.orientation.z = observationPacket.orientation().z();
+
+            memset(&observation.projection, 0, sizeof(CommonDeviceTrackingProjection));
+            if (observationPacket.has_ellipse_projection())
+            {
+                const auto &ellipse = observationPacket.ellipse_projection();
+
+                observation.projection.shape_type = eCommonTrackingProjectionType::ProjectionType_Ellipse;
+                observation.projection.shape.ellipse.center.set(ellipse.center().x(), ellipse.center().y());
+                observation.projection.shape.ellipse.half_x_extent = ellipse.half_x_extent();
+                observation.projection.shape.ellipse.half_y_extent = ellipse.half_y_extent();
+                observation.projection.shape.ellipse.angle = ellipse.angle();
+            }
+            else if (observationPacket.lightbar_projection().vertices_size() == 7)
+            {
+                const auto &polygon = observationPacket.lightbar_projection();
+
+                // The first three vertices are the triangle, the last four are the quad
+                observation.projection.shape_type = eCommonTrackingProjectionType::ProjectionType_LightBar;
+                for (int vertex_index = 0; vertex_index < 3; ++vertex_index)
+                {
+                    observation.projection.shape.lightbar.triangle[vertex_index].set(
+                        polygon.vertices(vertex_index).x(), polygon.vertices(vertex_index).y());
+                }
+                for (int vertex_index = 0; vertex_index < 4; ++vertex_index)
+                {
+                    observation.projection.shape.lightbar.quad[vertex_index].set(
+                        polygon.vertices(vertex_index + 3).x(), polygon.vertices(vertex_index + 3).y());
+                }
+            }
+            else
+            {
+                continue;
+            }
+            observation.projection.screen_area = observationPacket.screen_area();
+
+            frame.observations.push_back(observation);
+        }
+
+        // Tell the tracker manager to go look for the new remote tracker
+        if (RemoteTrackerRegistry::getInstance()->submitFrame(frame))
+        {
+            SERVER_LOG_INFO("ServerRequestHandler::handle_data_frame__tracker_packet")
+                << "New remote tracker streaming: " << frame.device_path;
+
+            m_device_manager.m_tracker_manager->mark_tracker_list_dirty();
+        }
+    }
+
 private:
     DeviceManager &m_device_manager;
     t_connection_state_map m_connection_state_map;
+    // Indexed by controller id, grows to the controller capacity on the first multicast subscription
+    std::vector<MulticastControllerStream> m_multicast_controller_streams;
+    // Scratch frame for the observations coming in from tracker nodes
+    RemoteTrackerFrame m_remote_tracker_frame;
 };
 
 //-- public interface -----
@@ -1624,6 +2197,9 @@ void ServerRequestHandler::shutdown()
 
 ResponsePtr ServerRequestHandler::handle_request(int connection_id, RequestPtr request)
 {
+    // Requests can start streams, open devices, etc
+    AllocationTracker::noteConfigurationChange();
+
     return m_implementation_ptr->handle_request(connection_id, request);
 }
 
@@ -1634,6 +2210,8 @@ void ServerRequestHandler::handle_input_data_frame(DeviceInputDataFramePtr data_
 
 void ServerRequestHandler::handle_client_connection_stopped(int connection_id)
 {
+    AllocationTracker::noteConfigurationChange();
+
     return m_implementation_ptr->handle_client_connection_stopped(connection_id);
 }
 
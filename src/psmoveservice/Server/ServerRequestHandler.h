@@ -2,7 +2,10 @@
 #define SERVER_REQUEST_HANDLER_H
 
 // -- includes -----
+#include "DeviceInterface.h"
 #include "PSMoveProtocolInterface.h"
+#include <chrono>
+#include <cstring>
 
 // -- pre-declarations -----
 class DeviceManager;
@@ -12,6 +15,28 @@ namespace boost {
 }};
 
 // -- definitions -----
+/// The subset of controller state a change-only stream compares against
+/// to decide if a connection needs a new data frame
+struct ControllerStreamSnapshot
+{
+    CommonDevicePosition position; // cm
+    CommonDeviceQuaternion orientation;
+    unsigned int all_buttons;
+    unsigned char analog_inputs[6]; // Triggers and sticks quantized to one byte each
+    int battery;
+    bool is_tracking;
+
+    inline void Clear()
+    {
+        position.clear();
+        orientation.clear();
+        all_buttons = 0;
+        memset(analog_inputs, 0, sizeof(analog_inputs));
+        battery = 0;
+        is_tracking = false;
+    }
+};
+
 struct ControllerStreamInfo
 {
     bool include_position_data;
@@ -22,6 +47,22 @@ struct ControllerStreamInfo
     bool led_override_active;
     int last_data_input_sequence_number;
 
+    // Data frames go to the service's multicast group instead of this connection
+    bool use_multicast;
+
+    // Rate cap: minimum time between data frames (0 = every controller update)
+    long long min_publish_interval_usec;
+    // Change-only publishing: thresholds applied to last_published_snapshot
+    bool publish_on_change_only;
+    float position_change_threshold; // cm
+    float orientation_change_threshold; // radians
+    
+    std::chrono::time_point<std::chrono::high_resolution_clock> last_publish_timestamp;
+    ControllerStreamSnapshot last_published_snapshot;
+    bool has_published;
+    // Number of the last data frame sent on the stream (see ControllerDataPacket.stream_sequence_num)
+    int stream_sequence_number;
+
     inline void Clear()
     {
         include_position_data = false;
@@ -31,6 +72,15 @@ struct ControllerStreamInfo
         include_raw_tracker_data = false;
         led_override_active = false;
         last_data_input_sequence_number = -1;
+        use_multicast = false;
+        min_publish_interval_usec = 0;
+        publish_on_change_only = false;
+        position_change_threshold = 0.f;
+        orientation_change_threshold = 0.f;
+        last_publish_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>();
+        last_published_snapshot.Clear();
+        has_published = false;
+        stream_sequence_number = 0;
     }
 };
 
@@ -38,9 +88,25 @@ struct TrackerStreamInfo
 {
     bool streaming_video_data;
 
+    // Color filter mask preview sent along with the tracker data frames
+    bool include_color_mask_preview;
+    eCommonTrackingColorID mask_tracking_color;
+    int mask_controller_id; // -1 = use the tracker's own color presets
+    int mask_downscale;
+
+    // JPEG video frames sent over TCP for clients that can't open the shared memory stream
+    bool streaming_network_video;
+    int last_network_video_frame_sequence_num; // -1 = none sent yet
+
     inline void Clear()
     {
         streaming_video_data = false;
+        include_color_mask_preview = false;
+        mask_tracking_color = eCommonTrackingColorID::Magenta;
+        mask_controller_id = -1;
+        mask_downscale = 1;
+        streaming_network_video = false;
+        last_network_video_frame_sequence_num = -1;
     }
 };
 
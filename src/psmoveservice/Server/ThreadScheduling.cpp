@@ -0,0 +1,329 @@
+//-- includes -----
+#include "ThreadScheduling.h"
+#include "ServerLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+//-- constants -----
+static const char *k_thread_role_names[_threadRole_COUNT] = { "main", "job", "background" };
+
+static const int k_max_cpu_count = 64;
+static const int k_min_realtime_priority = 1;
+static const int k_max_realtime_priority = 99;
+static const int k_min_nice = -20;
+static const int k_max_nice = 19;
+
+//-- globals -----
+static std::mutex g_settings_mutex;
+static ThreadSchedulingSettings g_settings;
+
+//-- prototypes -----
+static bool set_current_thread_name(const char *thread_name);
+static bool set_current_thread_affinity(unsigned long long cpu_mask, int &out_error);
+static bool set_current_thread_realtime_priority(int priority, int &out_error);
+static bool set_current_thread_nice(int nice, int &out_error);
+static bool lock_process_memory(int &out_error);
+
+//-- public interface -----
+namespace ThreadScheduling
+{
+    void setSettings(const ThreadSchedulingSettings &settings)
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_settings_mutex);
+            g_settings = settings;
+        }
+
+        if (settings.lock_memory)
+        {
+            int error = 0;
+
+            if (lock_process_memory(error))
+            {
+                SERVER_LOG_INFO("ThreadScheduling::setSettings") << "Locked process memory into RAM";
+            }
+            else
+            {
+                SERVER_LOG_WARNING("ThreadScheduling::setSettings")
+                    << "Failed to lock process memory (" << strerror(error) << "). "
+                    << "Raise the memlock limit or run with CAP_IPC_LOCK; continuing with pageable memory.";
+            }
+        }
+    }
+
+    bool applyToCurrentThread(eThreadRole role, const char *thread_name)
+    {
+        ThreadSchedulingPolicy policy;
+        {
+            std::lock_guard<std::mutex> lock(g_settings_mutex);
+            policy = g_settings.policies[role];
+        }
+
+        // Warnings name the role when the thread keeps its own name
+        const char *log_name = (thread_name != nullptr) ? thread_name : k_thread_role_names[role];
+        bool success = (thread_name == nullptr) || set_current_thread_name(thread_name);
+
+        if (!policy.cpu_set.empty())
+        {
+            unsigned long long cpu_mask = 0;
+            int error = 0;
+
+            if (!parseCpuSet(policy.cpu_set, cpu_mask))
+            {
+                SERVER_LOG_WARNING("ThreadScheduling::applyToCurrentThread")
+                    << log_name << ": Ignoring malformed " << k_thread_role_names[role]
+                    << " cpu set \"" << policy.cpu_set << "\"";
+                success = false;
+            }
+            else if (!set_current_thread_affinity(cpu_mask, error))
+            {
+                SERVER_LOG_WARNING("ThreadScheduling::applyToCurrentThread")
+                    << log_name << ": Failed to pin to cpus \"" << policy.cpu_set << "\" (" << strerror(error) << ")";
+                success = false;
+            }
+            else
+            {
+                SERVER_LOG_INFO("ThreadScheduling::applyToCurrentThread")
+                    << log_name << ": Pinned to cpus \"" << policy.cpu_set << "\"";
+            }
+        }
+
+        bool bRealtime = false;
+        if (policy.realtime_priority > 0)
+        {
+            const int priority =
+                std::max(std::min(policy.realtime_priority, k_max_realtime_priority), k_min_realtime_priority);
+            int error = 0;
+
+            if (set_current_thread_realtime_priority(priority, error))
+            {
+                SERVER_LOG_INFO("ThreadScheduling::applyToCurrentThread")
+                    << log_name << ": Using real-time scheduling at priority " << priority;
+                bRealtime = true;
+            }
+            else
+            {
+                SERVER_LOG_WARNING("ThreadScheduling::applyToCurrentThread")
+                    << log_name << ": Real-time scheduling was refused (" << strerror(error) << "). "
+                    << "Grant CAP_SYS_NICE or an rtprio limit; keeping normal scheduling.";
+                success = false;
+            }
+        }
+
+        // Niceness only matters under the normal scheduler
+        if (!bRealtime && policy.nice != 0)
+        {
+            const int nice = std::max(std::min(policy.nice, k_max_nice), k_min_nice);
+            int error = 0;
+
+            if (set_current_thread_nice(nice, error))
+            {
+                SERVER_LOG_INFO("ThreadScheduling::applyToCurrentThread")
+                    << log_name << ": Using niceness " << nice;
+            }
+            else
+            {
+                SERVER_LOG_WARNING("ThreadScheduling::applyToCurrentThread")
+                    << log_name << ": Failed to set niceness " << nice << " (" << strerror(error) << ")";
+                success = false;
+            }
+        }
+
+        return success;
+    }
+
+    bool parseCpuSet(const std::string &cpu_set, unsigned long long &out_cpu_mask)
+    {
+        const char *cursor = cpu_set.c_str();
+        unsigned long long cpu_mask = 0;
+        bool success = true;
+
+        while (success && *cursor != '\0')
+        {
+            char *range_end = nullptr;
+            const long first_cpu = strtol(cursor, &range_end, 10);
+            long last_cpu = first_cpu;
+
+            success = (range_end != cursor);
+            cursor = range_end;
+
+            if (success && *cursor == '-')
+            {
+                const char *last_start = cursor + 1;
+
+                last_cpu = strtol(last_start, &range_end, 10);
+                success = (range_end != last_start);
+                cursor = range_end;
+            }
+
+            success = success && first_cpu >= 0 && first_cpu <= last_cpu && last_cpu < k_max_cpu_count;
+
+            if (success)
+            {
+                for (long cpu = first_cpu; cpu <= last_cpu; ++cpu)
+                {
+                    cpu_mask |= (1ULL << cpu);
+                }
+
+                if (*cursor == ',')
+                {
+                    ++cursor;
+                    success = (*cursor != '\0');
+                }
+                else
+                {
+                    success = (*cursor == '\0');
+                }
+            }
+        }
+
+        if (success && cpu_mask != 0)
+        {
+            out_cpu_mask = cpu_mask;
+        }
+
+        return success && cpu_mask != 0;
+    }
+};
+
+//-- private functions -----
+#ifdef _WIN32
+static bool set_current_thread_name(const char *thread_name)
+{
+    // SetThreadDescription needs a newer SDK than we build against
+    return true;
+}
+
+static bool set_current_thread_affinity(unsigned long long cpu_mask, int &out_error)
+{
+    const DWORD_PTR windows_mask = static_cast<DWORD_PTR>(cpu_mask);
+    bool success = (windows_mask == cpu_mask) && SetThreadAffinityMask(GetCurrentThread(), windows_mask) != 0;
+
+    out_error = success ? 0 : EINVAL;
+    return success;
+}
+
+static bool set_current_thread_realtime_priority(int priority, int &out_error)
+{
+    bool success = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+
+    out_error = success ? 0 : EPERM;
+    return success;
+}
+
+static bool set_current_thread_nice(int nice, int &out_error)
+{
+    int windows_priority = THREAD_PRIORITY_NORMAL;
+
+    if (nice <= -10) windows_priority = THREAD_PRIORITY_HIGHEST;
+    else if (nice < 0) windows_priority = THREAD_PRIORITY_ABOVE_NORMAL;
+    else if (nice >= 10) windows_priority = THREAD_PRIORITY_LOWEST;
+    else if (nice > 0) windows_priority = THREAD_PRIORITY_BELOW_NORMAL;
+
+    bool success = SetThreadPriority(GetCurrentThread(), windows_priority) != 0;
+
+    out_error = success ? 0 : EPERM;
+    return success;
+}
+
+static bool lock_process_memory(int &out_error)
+{
+    // No mlockall() equivalent; VirtualLock only covers ranges we allocate ourselves
+    out_error = ENOSYS;
+    return false;
+}
+#else
+static bool set_current_thread_name(const char *thread_name)
+{
+#if defined(__linux__)
+    char truncated_name[16];
+
+    strncpy(truncated_name, thread_name, sizeof(truncated_name) - 1);
+    truncated_name[sizeof(truncated_name) - 1] = '\0';
+
+    return pthread_setname_np(pthread_self(), truncated_name) == 0;
+#elif defined(__APPLE__)
+    return pthread_setname_np(thread_name) == 0;
+#else
+    return true;
+#endif
+}
+
+static bool set_current_thread_affinity(unsigned long long cpu_mask, int &out_error)
+{
+#if defined(__linux__)
+    cpu_set_t cpus;
+
+    CPU_ZERO(&cpus);
+    for (int cpu = 0; cpu < k_max_cpu_count; ++cpu)
+    {
+        if ((cpu_mask & (1ULL << cpu)) != 0)
+        {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+
+    out_error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    return out_error == 0;
+#else
+    // OSX only takes affinity hints, not hard cpu sets
+    out_error = ENOSYS;
+    return false;
+#endif
+}
+
+static bool set_current_thread_realtime_priority(int priority, int &out_error)
+{
+    sched_param param;
+
+    memset(&param, 0, sizeof(param));
+    param.sched_priority =
+        std::max(std::min(priority, sched_get_priority_max(SCHED_FIFO)), sched_get_priority_min(SCHED_FIFO));
+
+    out_error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    return out_error == 0;
+}
+
+static bool set_current_thread_nice(int nice, int &out_error)
+{
+#if defined(__linux__)
+    // On Linux niceness is per thread when addressed by thread id
+    const id_t thread_id = static_cast<id_t>(syscall(SYS_gettid));
+    bool success = setpriority(PRIO_PROCESS, thread_id, nice) == 0;
+
+    out_error = success ? 0 : errno;
+    return success;
+#else
+    // setpriority() would change the whole process here
+    out_error = ENOSYS;
+    return false;
+#endif
+}
+
+static bool lock_process_memory(int &out_error)
+{
+    bool success = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+
+    out_error = success ? 0 : errno;
+    return success;
+}
+#endif
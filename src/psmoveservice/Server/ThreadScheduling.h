@@ -0,0 +1,69 @@
+#ifndef THREAD_SCHEDULING_H
+#define THREAD_SCHEDULING_H
+
+//-- includes -----
+#include <string>
+
+//-- constants -----
+// The service threads that can be given their own scheduling policy
+enum eThreadRole
+{
+    _threadRole_main,       // Main loop: controller HID polling, tracker capture and publishing
+    _threadRole_job,        // Job system workers: blob tracking and sensor fusion
+    _threadRole_background, // Device enumeration, background device opens, config writer and log sink
+
+    _threadRole_COUNT
+};
+
+//-- definitions -----
+struct ThreadSchedulingPolicy
+{
+    // CPUs the thread may run on, ex) "2-3,6". Empty leaves the thread on any CPU.
+    std::string cpu_set;
+    // 1-99 requests SCHED_FIFO at that priority (time critical priority on Windows).
+    // 0 keeps the normal time sharing scheduler.
+    int realtime_priority;
+    // Niceness under the normal scheduler (-20 to 19). Negative values need privileges.
+    int nice;
+
+    ThreadSchedulingPolicy()
+        : cpu_set()
+        , realtime_priority(0)
+        , nice(0)
+    {}
+};
+
+struct ThreadSchedulingSettings
+{
+    ThreadSchedulingPolicy policies[_threadRole_COUNT];
+    // Lock all current and future pages of the process into RAM so the update loop never page faults
+    bool lock_memory;
+
+    ThreadSchedulingSettings()
+        : lock_memory(false)
+    {}
+};
+
+//-- interface -----
+// Pins service threads to CPUs and raises their priority per the DeviceManager config.
+// Everything here is best effort: when the service isn't privileged enough
+// a warning is logged and the thread keeps running with the default scheduling.
+namespace ThreadScheduling
+{
+    /// Stores the settings used by applyToCurrentThread() and locks memory if requested.
+    /// Call once at startup before any of the threads it applies to are started.
+    void setSettings(const ThreadSchedulingSettings &settings);
+
+    /// Names the calling thread and applies the policy for the given role to it.
+    /// \param role Which policy to use
+    /// \param thread_name Name shown by the OS tools (at most 15 characters are kept on Linux).
+    /// nullptr keeps the current name (on Linux the main thread's name is the process name).
+    /// \return true if every part of the policy could be applied
+    bool applyToCurrentThread(eThreadRole role, const char *thread_name);
+
+    /// Parses a cpu set string of the form "0-3,6" into a bit mask.
+    /// \return false if the string is malformed or names a CPU past the 64th
+    bool parseCpuSet(const std::string &cpu_set, unsigned long long &out_cpu_mask);
+};
+
+#endif // THREAD_SCHEDULING_H
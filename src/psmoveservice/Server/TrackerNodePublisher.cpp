@@ -0,0 +1,380 @@
+//-- includes -----
+#include "TrackerNodePublisher.h"
+#include "DeviceInterface.h"
+#include "PSMoveConfig.h"
+#include "PSMoveProtocolInterface.h"
+#include "PSMoveProtocol.pb.h"
+#include "ServerControllerView.h"
+#include "ServerLog.h"
+#include "ServerTrackerView.h"
+#include "PackedMessage.h"
+
+#include <boost/asio.hpp>
+#include <chrono>
+
+//-- pre-declarations -----
+using namespace boost;
+using asio::ip::udp;
+
+//-- constants -----
+static const char *k_default_server_address = "127.0.0.1"; // loopback stand-in for the central service
+static const int k_default_server_port = 9512; // PSMOVE_SERVER_PORT
+static const float k_default_sphere_radius = 2.25f; // cm, the PSMove tracking bulb
+static const size_t k_max_node_string_length = 64; // node_name/node_token, keeps packets under MAX_TRACKER_INPUT_DATA_FRAME_MESSAGE_SIZE
+
+static const char *k_tracking_color_names[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES] = {
+    "magenta", "cyan", "yellow", "red", "green", "blue"
+};
+
+//-- private definitions -----
+class TrackerNodeConfig : public PSMoveConfig
+{
+public:
+    TrackerNodeConfig(const std::string &fnamebase = "TrackerNodeConfig")
+        : PSMoveConfig(fnamebase)
+        , server_address(k_default_server_address)
+        , server_port(k_default_server_port)
+        , node_name()
+        , node_token()
+        , sphere_radius(k_default_sphere_radius)
+    {
+        for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+        {
+            track_color[color_index] = true;
+        }
+    };
+
+    const boost::property_tree::ptree
+    config2ptree()
+    {
+        boost::property_tree::ptree pt;
+
+        pt.put("server_address", server_address);
+        pt.put("server_port", server_port);
+        pt.put("node_name", node_name);
+        pt.put("node_token", node_token);
+        pt.put("sphere_radius", sphere_radius);
+
+        for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+        {
+            pt.put(std::string("track_color.") + k_tracking_color_names[color_index], track_color[color_index]);
+        }
+
+        return pt;
+    }
+
+    void
+    ptree2config(const boost::property_tree::ptree &pt)
+    {
+        server_address = pt.get<std::string>("server_address", k_default_server_address);
+        server_port = pt.get<int>("server_port", k_default_server_port);
+        node_name = pt.get<std::string>("node_name", "");
+        node_token = pt.get<std::string>("node_token", "");
+        sphere_radius = pt.get<float>("sphere_radius", k_default_sphere_radius);
+
+        for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+        {
+            track_color[color_index] = pt.get<bool>(std::string("track_color.") + k_tracking_color_names[color_index], true);
+        }
+    }
+
+    // Address of the central PSMoveService the observations are sent to
+    std::string server_address;
+    int server_port;
+
+    // Name the central service uses to tell tracker nodes apart (defaults to the host name)
+    std::string node_name;
+
+    // Shared secret the central service accepts observations with (its tracker_node_token)
+    std::string node_token;
+
+    // Radius of the tracking sphere fit to every blob
+    float sphere_radius;
+
+    // Which tracking colors to look for in every video frame
+    bool track_color[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES];
+};
+
+class TrackerNodePublisherImpl
+{
+public:
+    TrackerNodePublisherImpl(asio::io_service &io_service)
+        : m_io_service(io_service)
+        , m_udp_socket(io_service)
+        , m_server_endpoint()
+        , m_config()
+        , m_packed_data_frame()
+        , m_data_frame_buffer()
+    {
+    }
+
+    bool startup()
+    {
+        bool bSuccess = true;
+
+        m_config.load();
+
+        if (m_config.node_name.empty())
+        {
+            m_config.node_name = asio::ip::host_name();
+        }
+
+        if (m_config.node_name.length() > k_max_node_string_length)
+        {
+            SERVER_LOG_WARNING("TrackerNodePublisher::startup") << "node_name \"" << m_config.node_name
+                << "\" is longer than " << k_max_node_string_length << " characters. Truncating.";
+            m_config.node_name.resize(k_max_node_string_length);
+        }
+
+        if (m_config.node_token.empty() || m_config.node_token.length() > k_max_node_string_length)
+        {
+            SERVER_LOG_ERROR("TrackerNodePublisher::startup") << "node_token in TrackerNodeConfig must be 1-"
+                << k_max_node_string_length << " characters and match tracker_node_token in the central service's ServerNetworkConfig";
+            bSuccess = false;
+        }
+
+        // Save the config back out again in case defaults changed
+        m_config.save();
+
+        if (bSuccess)
+        {
+            try
+            {
+                udp::resolver resolver(m_io_service);
+                udp::resolver::query query(
+                    udp::v4(), m_config.server_address, std::to_string(m_config.server_port));
+
+                m_server_endpoint = *resolver.resolve(query);
+                m_udp_socket.open(udp::v4());
+
+                SERVER_LOG_INFO("TrackerNodePublisher::startup") << "Tracker node \"" << m_config.node_name
+                    << "\" streaming to " << m_config.server_address << ":" << m_config.server_port;
+            }
+            catch (boost::system::system_error &error)
+            {
+                SERVER_LOG_ERROR("TrackerNodePublisher::startup") << "Failed to resolve central service address "
+                    << m_config.server_address << ": " << error.what();
+                bSuccess = false;
+            }
+        }
+
+        return bSuccess;
+    }
+
+    void shutdown()
+    {
+        if (m_udp_socket.is_open())
+        {
+            boost::system::error_code error;
+
+            m_udp_socket.close(error);
+        }
+    }
+
+    void publish_tracker_observations(ServerTrackerView *tracker_view, int frame_id)
+    {
+        DeviceInputDataFramePtr data_frame(new PSMoveProtocol::DeviceInputDataFrame);
+        PSMoveProtocol::DeviceInputDataFrame_TrackerDataPacket *tracker_packet = data_frame->mutable_tracker_data_packet();
+
+        data_frame->set_connection_id(-1);
+        data_frame->set_device_category(PSMoveProtocol::DeviceInputDataFrame_DeviceCategory_TRACKER);
+
+        tracker_packet->set_node_name(m_config.node_name);
+        tracker_packet->set_node_token(m_config.node_token);
+        tracker_packet->set_node_tracker_id(tracker_view->getDeviceID());
+        tracker_packet->set_frame_id(frame_id);
+        tracker_packet->set_capture_timestamp_usec(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                tracker_view->getLastFrameCaptureTimestamp().time_since_epoch()).count());
+
+        // The central service needs the camera properties the observations were computed with
+        {
+            float pixelWidth, pixelHeight;
+            float focalLengthX, focalLengthY, principalX, principalY;
+            float hfov, vfov, znear, zfar;
+
+            tracker_view->getPixelDimensions(pixelWidth, pixelHeight);
+            tracker_view->getCameraIntrinsics(focalLengthX, focalLengthY, principalX, principalY);
+            tracker_view->getFOV(hfov, vfov);
+            tracker_view->getZRange(znear, zfar);
+
+            tracker_packet->mutable_tracker_screen_dimensions()->set_x(pixelWidth);
+            tracker_packet->mutable_tracker_screen_dimensions()->set_y(pixelHeight);
+            tracker_packet->mutable_tracker_focal_lengths()->set_x(focalLengthX);
+            tracker_packet->mutable_tracker_focal_lengths()->set_y(focalLengthY);
+            tracker_packet->mutable_tracker_principal_point()->set_x(principalX);
+            tracker_packet->mutable_tracker_principal_point()->set_y(principalY);
+            tracker_packet->set_tracker_hfov(hfov);
+            tracker_packet->set_tracker_vfov(vfov);
+            tracker_packet->set_tracker_znear(znear);
+            tracker_packet->set_tracker_zfar(zfar);
+        }
+
+        // Without any controllers attached to the node, look for a sphere of every enabled tracking color
+        CommonDeviceTrackingShape tracking_shape;
+        tracking_shape.shape_type = eCommonTrackingShapeType::Sphere;
+        tracking_shape.shape.sphere.radius = m_config.sphere_radius;
+
+        for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+        {
+            if (!m_config.track_color[color_index])
+            {
+                continue;
+            }
+
+            const eCommonTrackingColorID tracking_color_id = static_cast<eCommonTrackingColorID>(color_index);
+            CommonHSVColorRange hsv_color_range;
+            ControllerOpticalPoseEstimation pose_estimate;
+
+            tracker_view->getTrackingColorPreset(nullptr, tracking_color_id, &hsv_color_range);
+            pose_estimate.clear();
+
+            if (tracker_view->computePoseForTrackingShape(&tracking_shape, &hsv_color_range, nullptr, &pose_estimate))
+            {
+                add_observation(tracking_color_id, pose_estimate, tracker_packet->add_observations());
+            }
+        }
+
+        send_data_frame(data_frame);
+    }
+
+private:
+    static void add_observation(
+        const eCommonTrackingColorID tracking_color_id,
+        const ControllerOpticalPoseEstimation &pose_estimate,
+        PSMoveProtocol::DeviceInputDataFrame_TrackerDataPacket_ControllerObservation *observation)
+    {
+        observation->set_tracking_color(static_cast<PSMoveProtocol::TrackingColorType>(tracking_color_id));
+
+        observation->mutable_position()->set_x(pose_estimate.position.x);
+        observation->mutable_position()->set_y(pose_estimate.position.y);
+        observation->mutable_position()->set_z(pose_estimate.position.z);
+
+        if (pose_estimate.bOrientationValid)
+        {
+            observation->set_orientation_valid(true);
+            observation->mutable_orientation()->set_w(pose_estimate.orientation.w);
+            observation->mutable_orientation()->set_x(pose_estimate.orientation.x);
+            observation->mutable_orientation()->set_y(pose_estimate.orientation.y);
+            observation->mutable_orientation()->set_z(pose_estimate.orientation.z);
+        }
+
+        switch (pose_estimate.projection.shape_type)
+        {
+        case eCommonTrackingProjectionType::ProjectionType_Ellipse:
+            {
+                PSMoveProtocol::Ellipse *ellipse = observation->mutable_ellipse_projection();
+
+                ellipse->mutable_center()->set_x(pose_estimate.projection.shape.ellipse.center.x);
+                ellipse->mutable_center()->set_y(pose_estimate.projection.shape.ellipse.center.y);
+                ellipse->set_half_x_extent(pose_estimate.projection.shape.ellipse.half_x_extent);
+                ellipse->set_half_y_extent(pose_estimate.projection.shape.ellipse.half_y_extent);
+                ellipse->set_angle(pose_estimate.projection.shape.ellipse.angle);
+            } break;
+        case eCommonTrackingProjectionType::ProjectionType_LightBar:
+            {
+                PSMoveProtocol::Polygon *polygon = observation->mutable_lightbar_projection();
+
+                for (int vertex_index = 0; vertex_index < 3; ++vertex_index)
+                {
+                    PSMoveProtocol::Pixel *pixel = polygon->add_vertices();
+
+                    pixel->set_x(pose_estimate.projection.shape.lightbar.triangle[vertex_index].x);
+                    pixel->set_y(pose_estimate.projection.shape.lightbar.triangle[vertex_index].y);
+                }
+
+                for (int vertex_index = 0; vertex_index < 4; ++vertex_index)
+                {
+                    PSMoveProtocol::Pixel *pixel = polygon->add_vertices();
+
+                    pixel->set_x(pose_estimate.projection.shape.lightbar.quad[vertex_index].x);
+                    pixel->set_y(pose_estimate.projection.shape.lightbar.quad[vertex_index].y);
+                }
+            } break;
+        default:
+            break;
+        }
+
+        observation->set_screen_area(pose_estimate.projection.screen_area);
+    }
+
+    void send_data_frame(DeviceInputDataFramePtr data_frame)
+    {
+        m_packed_data_frame.set_msg(data_frame);
+
+        if (m_packed_data_frame.pack(m_data_frame_buffer, sizeof(m_data_frame_buffer)))
+        {
+            const int msg_size = data_frame->ByteSize();
+            boost::system::error_code error;
+
+            m_udp_socket.send_to(
+                asio::buffer(m_data_frame_buffer, HEADER_SIZE + msg_size),
+                m_server_endpoint, 0, error);
+
+            if (error)
+            {
+                SERVER_LOG_WARNING("TrackerNodePublisher::send_data_frame")
+                    << "Failed to send tracker observations: " << error.message();
+            }
+        }
+        else
+        {
+            SERVER_LOG_ERROR("TrackerNodePublisher::send_data_frame")
+                << "Tracker observations too big to fit in packet!";
+        }
+    }
+
+    asio::io_service &m_io_service;
+    udp::socket m_udp_socket;
+    udp::endpoint m_server_endpoint;
+    TrackerNodeConfig m_config;
+
+    PackedMessage<PSMoveProtocol::DeviceInputDataFrame> m_packed_data_frame;
+    uint8_t m_data_frame_buffer[HEADER_SIZE + MAX_TRACKER_INPUT_DATA_FRAME_MESSAGE_SIZE];
+};
+
+//-- public interface -----
+TrackerNodePublisher *TrackerNodePublisher::m_instance = NULL;
+
+TrackerNodePublisher::TrackerNodePublisher(boost::asio::io_service *io_service)
+    : implementation_ptr(new TrackerNodePublisherImpl(*io_service))
+{
+}
+
+TrackerNodePublisher::~TrackerNodePublisher()
+{
+    if (m_instance != NULL)
+    {
+        SERVER_LOG_ERROR("~TrackerNodePublisher()") << "Tracker node publisher deleted without shutdown() getting called first";
+    }
+
+    if (implementation_ptr != nullptr)
+    {
+        delete implementation_ptr;
+        implementation_ptr = nullptr;
+    }
+}
+
+bool TrackerNodePublisher::startup()
+{
+    bool bSuccess = implementation_ptr->startup();
+
+    if (bSuccess)
+    {
+        m_instance = this;
+    }
+
+    return bSuccess;
+}
+
+void TrackerNodePublisher::shutdown()
+{
+    implementation_ptr->shutdown();
+
+    m_instance = NULL;
+}
+
+void TrackerNodePublisher::publish_tracker_observations(ServerTrackerView *tracker_view, int frame_id)
+{
+    implementation_ptr->publish_tracker_observations(tracker_view, frame_id);
+}
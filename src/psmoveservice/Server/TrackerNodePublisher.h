@@ -0,0 +1,50 @@
+#ifndef TRACKER_NODE_PUBLISHER_H
+#define TRACKER_NODE_PUBLISHER_H
+
+//-- pre-declarations -----
+class ServerTrackerView;
+
+namespace boost {
+    namespace asio {
+        class io_service;
+    }
+}
+
+//-- definitions -----
+// -Tracker Node Publisher-
+/// Used when PSMoveService runs as a headless tracker node next to its cameras.
+/// Runs the blob tracking on every new local video frame and sends only the
+/// resulting tracker relative observations to the central PSMoveService over UDP.
+class TrackerNodePublisher
+{
+public:
+    TrackerNodePublisher(boost::asio::io_service *io_service);
+    virtual ~TrackerNodePublisher();
+
+    static TrackerNodePublisher *get_instance() { return m_instance; }
+
+    /// Called by PSMoveService::startup() in tracker node mode
+    /**
+     Loads the TrackerNodeConfig and resolves the central service address
+     */
+    bool startup();
+
+    /// Called by PSMoveService::shutdown() in tracker node mode
+    void shutdown();
+
+    /// Called by ServerTrackerView::publish_device_data_frame() for every new video frame
+    void publish_tracker_observations(ServerTrackerView *tracker_view, int frame_id);
+
+private:
+    /// Must use the overloaded constructor
+    TrackerNodePublisher();
+
+    /// private implementation - same lifetime as the TrackerNodePublisher
+    class TrackerNodePublisherImpl *implementation_ptr;
+
+    /// Singleton instance of the class
+    /// Assigned in startup, cleared in shutdown
+    static TrackerNodePublisher *m_instance;
+};
+
+#endif  // TRACKER_NODE_PUBLISHER_H
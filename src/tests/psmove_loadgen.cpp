@@ -0,0 +1,1432 @@
+#include "ClientConstants.h"
+#include "ClientLog.h"
+#include "ClientNetworkInterface.h"
+#include "ClientNetworkManager.h"
+#include "PSMoveProtocolInterface.h"
+#include "PSMoveProtocol.pb.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux) || defined (__APPLE__)
+#include <unistd.h>
+#endif
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+// Soak benchmark for PSMoveService's networking.
+// Opens a number of simulated clients (each with its own TCP/UDP connection, just like separate
+// PSMoveClient apps) that stream every controller and tracker the service has and fire off a
+// mix of requests, then reports per-client delivered rates, sequence number gaps and
+// publish-to-receive latency percentiles as it goes plus a JSON summary for comparing runs.
+//
+// The service needs something to stream: real controllers, and/or stand-in trackers from
+// test_tracker_node. Latencies come from the publish timestamps the service puts in every
+// data frame and are only meaningful when the load generator runs on the service's machine
+// (both sides read the same monotonic clock). Pass --service-pid to also sample the service's CPU use.
+
+#define LATENCY_BUCKET_USEC 10
+#define LATENCY_BUCKET_COUNT 10000 // 100ms, anything slower lands in the overflow bucket
+#define MAX_PLAUSIBLE_LATENCY_USEC 10000000 // Anything past 10s means the clocks don't match
+
+enum eRequestKind
+{
+    REQUEST_CONTROLLER_LIST,
+    REQUEST_TRACKER_LIST,
+    REQUEST_TRACKER_SETTINGS,
+    REQUEST_RESTART_CONTROLLER_STREAM,
+
+    REQUEST_KIND_COUNT
+};
+
+static const char *k_request_kind_names[REQUEST_KIND_COUNT] = {
+    "controller_list",
+    "tracker_list",
+    "tracker_settings",
+    "restart_stream"
+};
+
+struct LoadGenSettings
+{
+    std::string host;
+    std::string port;
+    int client_count;
+    float duration_seconds; // 0 = until interrupted
+    float report_interval_seconds;
+    int poll_interval_usec;
+
+    bool stream_controllers;
+    bool stream_trackers;
+    bool include_position_data;
+    bool include_physics_data;
+    bool include_raw_sensor_data;
+    bool include_calibrated_sensor_data;
+    bool include_raw_tracker_data;
+    bool use_multicast;
+    float max_publish_rate_hz;
+    bool publish_on_change_only;
+
+    // Random requests per second per client, picked by weight
+    float requests_per_second;
+    int request_weights[REQUEST_KIND_COUNT];
+
+    int service_pid;
+    std::string json_path;
+
+    LoadGenSettings()
+        : host("localhost")
+        , port(PSMOVESERVICE_DEFAULT_PORT)
+        , client_count(20)
+        , duration_seconds(60.f)
+        , report_interval_seconds(10.f)
+        , poll_interval_usec(500)
+        , stream_controllers(true)
+        , stream_trackers(true)
+        , include_position_data(true)
+        , include_physics_data(false)
+        , include_raw_sensor_data(false)
+        , include_calibrated_sensor_data(false)
+        , include_raw_tracker_data(false)
+        , use_multicast(false)
+        , max_publish_rate_hz(0.f)
+        , publish_on_change_only(false)
+        , requests_per_second(1.f)
+        , service_pid(0)
+        , json_path()
+    {
+        request_weights[REQUEST_CONTROLLER_LIST] = 2;
+        request_weights[REQUEST_TRACKER_LIST] = 1;
+        request_weights[REQUEST_TRACKER_SETTINGS] = 1;
+        request_weights[REQUEST_RESTART_CONTROLLER_STREAM] = 0;
+    }
+};
+
+volatile std::sig_atomic_t g_keep_running = 1;
+
+static void handle_termination_signal(int)
+{
+    g_keep_running = 0;
+}
+
+static long long get_time_usec()
+{
+    // Same clock the service stamps its data frames with
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-- LatencyHistogram -----
+// Fixed size so a long soak run doesn't grow memory with every sample
+class LatencyHistogram
+{
+public:
+    LatencyHistogram()
+        : m_buckets(LATENCY_BUCKET_COUNT + 1, 0)
+        , m_count(0)
+        , m_sum_usec(0)
+        , m_max_usec(0)
+    {
+    }
+
+    void add(long long latency_usec)
+    {
+        const long long clamped_usec = std::max(latency_usec, 0LL);
+        const size_t bucket_index = static_cast<size_t>(std::min(clamped_usec / LATENCY_BUCKET_USEC, static_cast<long long>(LATENCY_BUCKET_COUNT)));
+
+        ++m_buckets[bucket_index];
+        ++m_count;
+        m_sum_usec += clamped_usec;
+        m_max_usec = std::max(m_max_usec, clamped_usec);
+    }
+
+    void merge(const LatencyHistogram &other)
+    {
+        for (size_t bucket_index = 0; bucket_index < m_buckets.size(); ++bucket_index)
+        {
+            m_buckets[bucket_index] += other.m_buckets[bucket_index];
+        }
+
+        m_count += other.m_count;
+        m_sum_usec += other.m_sum_usec;
+        m_max_usec = std::max(m_max_usec, other.m_max_usec);
+    }
+
+    void clear()
+    {
+        std::fill(m_buckets.begin(), m_buckets.end(), 0);
+        m_count = 0;
+        m_sum_usec = 0;
+        m_max_usec = 0;
+    }
+
+    unsigned long long getCount() const { return m_count; }
+    float getMeanMs() const { return m_count > 0 ? static_cast<float>(m_sum_usec / m_count) / 1000.f : 0.f; }
+    float getMaxMs() const { return static_cast<float>(m_max_usec) / 1000.f; }
+
+    // Upper edge of the bucket the percentile falls in (the max if it's in the overflow bucket)
+    float getPercentileMs(double percentile) const
+    {
+        float result = 0.f;
+
+        if (m_count > 0)
+        {
+            const unsigned long long rank = static_cast<unsigned long long>(std::ceil(percentile / 100.0 * static_cast<double>(m_count)));
+            unsigned long long seen = 0;
+            size_t bucket_index = 0;
+
+            while (bucket_index < m_buckets.size() && seen + m_buckets[bucket_index] < std::max(rank, 1ULL))
+            {
+                seen += m_buckets[bucket_index];
+                ++bucket_index;
+            }
+
+            result =
+                (bucket_index < LATENCY_BUCKET_COUNT)
+                ? std::min(static_cast<float>((bucket_index + 1) * LATENCY_BUCKET_USEC) / 1000.f, getMaxMs())
+                : getMaxMs();
+        }
+
+        return result;
+    }
+
+private:
+    std::vector<unsigned int> m_buckets;
+    unsigned long long m_count;
+    long long m_sum_usec;
+    long long m_max_usec;
+};
+
+//-- DeliveryStats -----
+// Data frames received from one kind of device stream
+struct DeliveryStats
+{
+    unsigned long long received_count;
+    unsigned long long missing_count;      // Skipped sequence numbers (rate capped and change-only streams skip on purpose)
+    unsigned long long out_of_order_count; // Arrived after a newer frame of the same stream
+    unsigned long long unusable_timestamp_count; // Not stamped, or the clocks don't match (load generator on another machine)
+    LatencyHistogram latency;
+
+    DeliveryStats()
+        : received_count(0)
+        , missing_count(0)
+        , out_of_order_count(0)
+        , unusable_timestamp_count(0)
+        , latency()
+    {
+    }
+
+    void merge(const DeliveryStats &other)
+    {
+        received_count += other.received_count;
+        missing_count += other.missing_count;
+        out_of_order_count += other.out_of_order_count;
+        unusable_timestamp_count += other.unusable_timestamp_count;
+        latency.merge(other.latency);
+    }
+
+    void clear()
+    {
+        *this = DeliveryStats();
+    }
+
+    double getLossRatio() const
+    {
+        const unsigned long long expected_count = received_count + missing_count;
+
+        return expected_count > 0 ? static_cast<double>(missing_count) / static_cast<double>(expected_count) : 0.0;
+    }
+};
+
+struct RequestStats
+{
+    unsigned long long sent_count;
+    unsigned long long failed_count;
+    LatencyHistogram latency;
+
+    RequestStats()
+        : sent_count(0)
+        , failed_count(0)
+        , latency()
+    {
+    }
+
+    void merge(const RequestStats &other)
+    {
+        sent_count += other.sent_count;
+        failed_count += other.failed_count;
+        latency.merge(other.latency);
+    }
+};
+
+// Everything that happened in one report interval, summed over all clients
+struct IntervalStats
+{
+    DeliveryStats controller;
+    DeliveryStats tracker;
+    RequestStats requests;
+
+    void clear()
+    {
+        controller.clear();
+        tracker.clear();
+        requests = RequestStats();
+    }
+};
+
+//-- ServiceCpuSampler -----
+// Total CPU time the service process has used, read from the OS
+class ServiceCpuSampler
+{
+public:
+    ServiceCpuSampler(int pid)
+        : m_pid(pid)
+    {
+    }
+
+    bool sampleCpuSeconds(double &out_cpu_seconds) const
+    {
+        bool bSuccess = false;
+
+        if (m_pid > 0)
+        {
+#if defined(_WIN32)
+            HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(m_pid));
+
+            if (process != NULL)
+            {
+                FILETIME creation_time, exit_time, kernel_time, user_time;
+
+                if (GetProcessTimes(process, &creation_time, &exit_time, &kernel_time, &user_time))
+                {
+                    // FILETIMEs count 100ns ticks
+                    const unsigned long long kernel_ticks = (static_cast<unsigned long long>(kernel_time.dwHighDateTime) << 32) | kernel_time.dwLowDateTime;
+                    const unsigned long long user_ticks = (static_cast<unsigned long long>(user_time.dwHighDateTime) << 32) | user_time.dwLowDateTime;
+
+                    out_cpu_seconds = static_cast<double>(kernel_ticks + user_ticks) / 10000000.0;
+                    bSuccess = true;
+                }
+
+                CloseHandle(process);
+            }
+#elif defined(__linux)
+            std::stringstream stat_path;
+            stat_path << "/proc/" << m_pid << "/stat";
+
+            std::ifstream stat_file(stat_path.str().c_str());
+            std::string stat_line;
+
+            if (std::getline(stat_file, stat_line))
+            {
+                // The process name (field 2) can contain spaces, so count fields from the last ')'
+                const size_t name_end = stat_line.rfind(')');
+
+                if (name_end != std::string::npos)
+                {
+                    std::stringstream fields(stat_line.substr(name_end + 1));
+                    std::string field;
+                    unsigned long long utime = 0, stime = 0;
+
+                    // Fields 3 (state) through 13 come before utime and stime
+                    for (int field_index = 3; field_index <= 13 && (fields >> field); ++field_index)
+                    {
+                    }
+
+                    if (fields >> utime >> stime)
+                    {
+                        out_cpu_seconds = static_cast<double>(utime + stime) / static_cast<double>(sysconf(_SC_CLK_TCK));
+                        bSuccess = true;
+                    }
+                }
+            }
+#endif
+        }
+
+        return bSuccess;
+    }
+
+private:
+    int m_pid;
+};
+
+//-- SimulatedClient -----
+class SimulatedClient :
+    public IDataFrameListener,
+    public INotificationListener,
+    public IResponseListener,
+    public IClientNetworkEventListener
+{
+public:
+    SimulatedClient(int client_index, const LoadGenSettings &settings, IntervalStats *interval_stats)
+        : m_client_index(client_index)
+        , m_settings(settings)
+        , m_interval_stats(interval_stats)
+        , m_network_manager(settings.host, settings.port, this, this, this, this)
+        , m_random(static_cast<unsigned int>(client_index) * 7919u + 1u)
+        , m_is_connected(false)
+        , m_connection_error_count(0)
+        , m_next_request_id(0)
+        , m_next_random_request_time_usec(0)
+    {
+    }
+
+    virtual ~SimulatedClient()
+    {
+    }
+
+    bool startup()
+    {
+        return m_network_manager.startup();
+    }
+
+    void update(long long now_usec)
+    {
+        m_network_manager.update();
+
+        if (m_is_connected && m_settings.requests_per_second > 0.f && now_usec >= m_next_random_request_time_usec)
+        {
+            // Jitter the spacing so the clients don't all fire at once
+            std::uniform_real_distribution<float> spacing_scale(0.5f, 1.5f);
+            const float interval_usec = 1000000.f / m_settings.requests_per_second;
+
+            send_random_request();
+            m_next_random_request_time_usec = now_usec + static_cast<long long>(interval_usec * spacing_scale(m_random));
+        }
+    }
+
+    void shutdown()
+    {
+        m_network_manager.update();
+        m_network_manager.shutdown();
+    }
+
+    int getClientIndex() const { return m_client_index; }
+    bool getIsConnected() const { return m_is_connected; }
+    int getConnectionErrorCount() const { return m_connection_error_count; }
+    int getControllerStreamCount() const { return static_cast<int>(m_controller_streams.size()); }
+    int getTrackerStreamCount() const { return static_cast<int>(m_tracker_streams.size()); }
+    const DeliveryStats &getControllerStats() const { return m_controller_stats; }
+    const DeliveryStats &getTrackerStats() const { return m_tracker_stats; }
+    const RequestStats &getRequestStats() const { return m_request_stats; }
+
+    // IClientNetworkEventListener
+    virtual void handle_server_connection_opened() override
+    {
+        m_is_connected = true;
+
+        if (m_settings.stream_controllers || m_settings.request_weights[REQUEST_RESTART_CONTROLLER_STREAM] > 0)
+        {
+            request_controller_list();
+        }
+
+        if (m_settings.stream_trackers || m_settings.request_weights[REQUEST_TRACKER_SETTINGS] > 0)
+        {
+            request_tracker_list();
+        }
+    }
+
+    virtual void handle_server_connection_open_failed(const boost::system::error_code& ec) override
+    {
+        std::cerr << "Client " << m_client_index << " failed to connect: " << ec.message() << std::endl;
+        m_is_connected = false;
+        ++m_connection_error_count;
+    }
+
+    virtual void handle_server_connection_closed() override
+    {
+        m_is_connected = false;
+    }
+
+    virtual void handle_server_connection_close_failed(const boost::system::error_code& ec) override
+    {
+        ++m_connection_error_count;
+    }
+
+    virtual void handle_server_connection_socket_error(const boost::system::error_code& ec) override
+    {
+        std::cerr << "Client " << m_client_index << " socket error: " << ec.message() << std::endl;
+        m_is_connected = false;
+        ++m_connection_error_count;
+    }
+
+    // IResponseListener
+    virtual void handle_request_canceled(RequestPtr request) override
+    {
+        m_pending_requests.erase(request->request_id());
+        ++m_request_stats.failed_count;
+        ++m_interval_stats->requests.failed_count;
+    }
+
+    virtual void handle_response(ResponsePtr response) override
+    {
+        std::map<int, PendingRequest>::iterator pending_iter = m_pending_requests.find(response->request_id());
+
+        if (pending_iter == m_pending_requests.end())
+        {
+            return;
+        }
+
+        const PendingRequest pending_request = pending_iter->second;
+        const long long latency_usec = get_time_usec() - pending_request.send_time_usec;
+
+        m_pending_requests.erase(pending_iter);
+        m_request_stats.latency.add(latency_usec);
+        m_interval_stats->requests.latency.add(latency_usec);
+
+        if (response->result_code() != PSMoveProtocol::Response_ResultCode_RESULT_OK)
+        {
+            ++m_request_stats.failed_count;
+            ++m_interval_stats->requests.failed_count;
+            return;
+        }
+
+        switch (response->type())
+        {
+        case PSMoveProtocol::Response_ResponseType_CONTROLLER_LIST:
+            {
+                const auto &controller_list = response->result_controller_list();
+
+                m_controller_ids.clear();
+                for (int list_index = 0; list_index < controller_list.controllers_size(); ++list_index)
+                {
+                    const int controller_id = controller_list.controllers(list_index).controller_id();
+
+                    m_controller_ids.push_back(controller_id);
+
+                    if (m_settings.stream_controllers && m_controller_streams.find(controller_id) == m_controller_streams.end())
+                    {
+                        start_controller_stream(controller_id);
+                    }
+                }
+            } break;
+        case PSMoveProtocol::Response_ResponseType_TRACKER_LIST:
+            {
+                const auto &tracker_list = response->result_tracker_list();
+
+                m_tracker_ids.clear();
+                for (int list_index = 0; list_index < tracker_list.trackers_size(); ++list_index)
+                {
+                    const int tracker_id = tracker_list.trackers(list_index).tracker_id();
+
+                    m_tracker_ids.push_back(tracker_id);
+
+                    if (m_settings.stream_trackers && m_tracker_streams.find(tracker_id) == m_tracker_streams.end())
+                    {
+                        start_tracker_stream(tracker_id);
+                    }
+                }
+            } break;
+        case PSMoveProtocol::Response_ResponseType_CONTROLLER_DATA_STREAM_STARTED:
+            {
+                const auto &stream_result = response->result_controller_data_stream_started();
+
+                if (!stream_result.multicast_group_address().empty() &&
+                    m_network_manager.join_multicast_group(stream_result.multicast_group_address(), stream_result.multicast_port()))
+                {
+                    m_network_manager.set_multicast_controller_subscription(pending_request.device_id, true);
+                }
+            } break;
+        default:
+            break;
+        }
+    }
+
+    // INotificationListener
+    virtual void handle_notification(ResponsePtr notification) override
+    {
+        switch (notification->type())
+        {
+        case PSMoveProtocol::Response_ResponseType_CONTROLLER_LIST_UPDATED:
+            request_controller_list();
+            break;
+        case PSMoveProtocol::Response_ResponseType_TRACKER_LIST_UPDATED:
+            request_tracker_list();
+            break;
+        default:
+            break;
+        }
+    }
+
+    // IDataFrameListener
+    virtual void handle_data_frame(DeviceOutputDataFramePtr data_frame) override
+    {
+        const long long receive_time_usec = get_time_usec();
+
+        switch (data_frame->device_category())
+        {
+        case PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER:
+            {
+                const auto &packet = data_frame->controller_data_packet();
+
+                record_data_frame(
+                    m_controller_streams, packet.controller_id(), packet.sequence_num(),
+                    packet.publish_timestamp_usec(), receive_time_usec,
+                    m_controller_stats, m_interval_stats->controller);
+            } break;
+        case PSMoveProtocol::DeviceOutputDataFrame::TRACKER:
+            {
+                const auto &packet = data_frame->tracker_data_packet();
+
+                record_data_frame(
+                    m_tracker_streams, packet.tracker_id(), packet.sequence_num(),
+                    packet.publish_timestamp_usec(), receive_time_usec,
+                    m_tracker_stats, m_interval_stats->tracker);
+            } break;
+        default:
+            break;
+        }
+    }
+
+private:
+    struct PendingRequest
+    {
+        int device_id;
+        long long send_time_usec;
+    };
+
+    struct StreamState
+    {
+        bool has_sequence_num;
+        int last_sequence_num;
+    };
+
+    typedef std::map<int, StreamState> t_stream_map;
+
+    void send_request(int device_id, RequestPtr request)
+    {
+        PendingRequest pending_request;
+        pending_request.device_id = device_id;
+        pending_request.send_time_usec = get_time_usec();
+
+        request->set_request_id(m_next_request_id++);
+        m_pending_requests[request->request_id()] = pending_request;
+
+        ++m_request_stats.sent_count;
+        ++m_interval_stats->requests.sent_count;
+
+        m_network_manager.send_request(request);
+    }
+
+    void request_controller_list()
+    {
+        RequestPtr request(new PSMoveProtocol::Request());
+        request->set_type(PSMoveProtocol::Request_RequestType_GET_CONTROLLER_LIST);
+
+        send_request(-1, request);
+    }
+
+    void request_tracker_list()
+    {
+        RequestPtr request(new PSMoveProtocol::Request());
+        request->set_type(PSMoveProtocol::Request_RequestType_GET_TRACKER_LIST);
+
+        send_request(-1, request);
+    }
+
+    void start_controller_stream(int controller_id)
+    {
+        RequestPtr request(new PSMoveProtocol::Request());
+        request->set_type(PSMoveProtocol::Request_RequestType_START_CONTROLLER_DATA_STREAM);
+
+        auto *stream_request = request->mutable_request_start_psmove_data_stream();
+        stream_request->set_controller_id(controller_id);
+        stream_request->set_include_position_data(m_settings.include_position_data);
+        stream_request->set_include_physics_data(m_settings.include_physics_data);
+        stream_request->set_include_raw_sensor_data(m_settings.include_raw_sensor_data);
+        stream_request->set_include_calibrated_sensor_data(m_settings.include_calibrated_sensor_data);
+        stream_request->set_include_raw_tracker_data(m_settings.include_raw_tracker_data);
+        stream_request->set_use_multicast(m_settings.use_multicast);
+        stream_request->set_max_publish_rate_hz(m_settings.max_publish_rate_hz);
+        stream_request->set_publish_on_change_only(m_settings.publish_on_change_only);
+
+        // The gap since the stream last ran isn't loss
+        StreamState &stream = m_controller_streams[controller_id];
+        stream.has_sequence_num = false;
+        stream.last_sequence_num = 0;
+
+        send_request(controller_id, request);
+    }
+
+    void stop_controller_stream(int controller_id)
+    {
+        RequestPtr request(new PSMoveProtocol::Request());
+        request->set_type(PSMoveProtocol::Request_RequestType_STOP_CONTROLLER_DATA_STREAM);
+        request->mutable_request_stop_psmove_data_stream()->set_controller_id(controller_id);
+
+        m_controller_streams.erase(controller_id);
+        m_network_manager.set_multicast_controller_subscription(controller_id, false);
+
+        send_request(controller_id, request);
+    }
+
+    void start_tracker_stream(int tracker_id)
+    {
+        RequestPtr request(new PSMoveProtocol::Request());
+        request->set_type(PSMoveProtocol::Request_RequestType_START_TRACKER_DATA_STREAM);
+        request->mutable_request_start_tracker_data_stream()->set_tracker_id(tracker_id);
+
+        StreamState &stream = m_tracker_streams[tracker_id];
+        stream.has_sequence_num = false;
+        stream.last_sequence_num = 0;
+
+        send_request(tracker_id, request);
+    }
+
+    void send_random_request()
+    {
+        int total_weight = 0;
+
+        for (int kind_index = 0; kind_index < REQUEST_KIND_COUNT; ++kind_index)
+        {
+            total_weight += m_settings.request_weights[kind_index];
+        }
+
+        if (total_weight <= 0)
+        {
+            return;
+        }
+
+        std::uniform_int_distribution<int> weight_distribution(0, total_weight - 1);
+        int pick = weight_distribution(m_random);
+        int kind_index = 0;
+
+        while (pick >= m_settings.request_weights[kind_index])
+        {
+            pick -= m_settings.request_weights[kind_index];
+            ++kind_index;
+        }
+
+        switch (static_cast<eRequestKind>(kind_index))
+        {
+        case REQUEST_CONTROLLER_LIST:
+            request_controller_list();
+            break;
+        case REQUEST_TRACKER_LIST:
+            request_tracker_list();
+            break;
+        case REQUEST_TRACKER_SETTINGS:
+            if (!m_tracker_ids.empty())
+            {
+                std::uniform_int_distribution<size_t> tracker_distribution(0, m_tracker_ids.size() - 1);
+                const int tracker_id = m_tracker_ids[tracker_distribution(m_random)];
+
+                RequestPtr request(new PSMoveProtocol::Request());
+                request->set_type(PSMoveProtocol::Request_RequestType_GET_TRACKER_SETTINGS);
+                request->mutable_request_get_tracker_settings()->set_tracker_id(tracker_id);
+                request->mutable_request_get_tracker_settings()->set_controller_id(
+                    m_controller_ids.empty() ? -1 : m_controller_ids[0]);
+
+                send_request(tracker_id, request);
+            }
+            break;
+        case REQUEST_RESTART_CONTROLLER_STREAM:
+            if (!m_controller_ids.empty())
+            {
+                std::uniform_int_distribution<size_t> controller_distribution(0, m_controller_ids.size() - 1);
+                const int controller_id = m_controller_ids[controller_distribution(m_random)];
+
+                // Requests are handled in order, so the start always lands after the stop
+                stop_controller_stream(controller_id);
+                start_controller_stream(controller_id);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    void record_data_frame(
+        t_stream_map &streams, int device_id, int sequence_num,
+        unsigned long long publish_time_usec, long long receive_time_usec,
+        DeliveryStats &client_stats, DeliveryStats &interval_stats)
+    {
+        t_stream_map::iterator stream_iter = streams.find(device_id);
+
+        // Straggler from a stream that was just stopped (or somebody else's multicast subscription)
+        if (stream_iter == streams.end())
+        {
+            return;
+        }
+
+        StreamState &stream = stream_iter->second;
+        unsigned long long missing_count = 0;
+        unsigned long long out_of_order_count = 0;
+
+        if (!stream.has_sequence_num || sequence_num > stream.last_sequence_num)
+        {
+            if (stream.has_sequence_num)
+            {
+                missing_count = static_cast<unsigned long long>(sequence_num - stream.last_sequence_num - 1);
+            }
+
+            stream.has_sequence_num = true;
+            stream.last_sequence_num = sequence_num;
+        }
+        else
+        {
+            out_of_order_count = 1;
+        }
+
+        client_stats.received_count += 1;
+        client_stats.missing_count += missing_count;
+        client_stats.out_of_order_count += out_of_order_count;
+        interval_stats.received_count += 1;
+        interval_stats.missing_count += missing_count;
+        interval_stats.out_of_order_count += out_of_order_count;
+
+        const long long latency_usec = receive_time_usec - static_cast<long long>(publish_time_usec);
+
+        if (publish_time_usec != 0 && latency_usec >= 0 && latency_usec < MAX_PLAUSIBLE_LATENCY_USEC)
+        {
+            client_stats.latency.add(latency_usec);
+            interval_stats.latency.add(latency_usec);
+        }
+        else
+        {
+            ++client_stats.unusable_timestamp_count;
+            ++interval_stats.unusable_timestamp_count;
+        }
+    }
+
+    int m_client_index;
+    const LoadGenSettings &m_settings;
+    IntervalStats *m_interval_stats;
+    ClientNetworkManager m_network_manager;
+    std::mt19937 m_random;
+
+    bool m_is_connected;
+    int m_connection_error_count;
+
+    int m_next_request_id;
+    long long m_next_random_request_time_usec;
+    std::map<int, PendingRequest> m_pending_requests;
+
+    std::vector<int> m_controller_ids;
+    std::vector<int> m_tracker_ids;
+    t_stream_map m_controller_streams;
+    t_stream_map m_tracker_streams;
+
+    DeliveryStats m_controller_stats;
+    DeliveryStats m_tracker_stats;
+    RequestStats m_request_stats;
+};
+
+//-- JsonWriter -----
+// Just enough JSON writing for the summary, so the run results can be diffed between builds
+class JsonWriter
+{
+public:
+    JsonWriter(std::ostream &stream)
+        : m_stream(stream)
+        , m_needs_comma()
+    {
+    }
+
+    void beginObject(const char *key = nullptr) { beginScope(key, '{'); }
+    void endObject() { endScope('}'); }
+    void beginArray(const char *key = nullptr) { beginScope(key, '['); }
+    void endArray() { endScope(']'); }
+
+    void value(const char *key, double number)
+    {
+        writeKey(key);
+        m_stream << number;
+    }
+
+    void value(const char *key, unsigned long long number)
+    {
+        writeKey(key);
+        m_stream << number;
+    }
+
+    void value(const char *key, int number)
+    {
+        writeKey(key);
+        m_stream << number;
+    }
+
+    void value(const char *key, bool boolean)
+    {
+        writeKey(key);
+        m_stream << (boolean ? "true" : "false");
+    }
+
+    void value(const char *key, const std::string &string)
+    {
+        writeKey(key);
+        m_stream << '"';
+        for (char c : string)
+        {
+            if (c == '"' || c == '\\')
+            {
+                m_stream << '\\';
+            }
+            m_stream << c;
+        }
+        m_stream << '"';
+    }
+
+private:
+    void writeKey(const char *key)
+    {
+        if (!m_needs_comma.empty())
+        {
+            if (m_needs_comma.back())
+            {
+                m_stream << ',';
+            }
+            m_needs_comma.back() = true;
+
+            m_stream << '\n' << std::string(m_needs_comma.size() * 2, ' ');
+        }
+
+        if (key != nullptr)
+        {
+            m_stream << '"' << key << "\": ";
+        }
+    }
+
+    void beginScope(const char *key, char open_char)
+    {
+        writeKey(key);
+        m_stream << open_char;
+        m_needs_comma.push_back(false);
+    }
+
+    void endScope(char close_char)
+    {
+        m_needs_comma.pop_back();
+        m_stream << '\n' << std::string(m_needs_comma.size() * 2, ' ') << close_char;
+    }
+
+    std::ostream &m_stream;
+    std::vector<bool> m_needs_comma;
+};
+
+static void write_latency_json(JsonWriter &writer, const char *key, const LatencyHistogram &latency)
+{
+    writer.beginObject(key);
+    writer.value("count", latency.getCount());
+    writer.value("mean", static_cast<double>(latency.getMeanMs()));
+    writer.value("p50", static_cast<double>(latency.getPercentileMs(50.0)));
+    writer.value("p90", static_cast<double>(latency.getPercentileMs(90.0)));
+    writer.value("p99", static_cast<double>(latency.getPercentileMs(99.0)));
+    writer.value("p999", static_cast<double>(latency.getPercentileMs(99.9)));
+    writer.value("max", static_cast<double>(latency.getMaxMs()));
+    writer.endObject();
+}
+
+static void write_delivery_json(JsonWriter &writer, const char *key, const DeliveryStats &stats, double duration_seconds)
+{
+    writer.beginObject(key);
+    writer.value("received_frames", stats.received_count);
+    writer.value("frames_per_second", duration_seconds > 0.0 ? static_cast<double>(stats.received_count) / duration_seconds : 0.0);
+    writer.value("missing_frames", stats.missing_count);
+    writer.value("loss_ratio", stats.getLossRatio());
+    writer.value("out_of_order_frames", stats.out_of_order_count);
+    writer.value("unusable_timestamps", stats.unusable_timestamp_count);
+    write_latency_json(writer, "latency_ms", stats.latency);
+    writer.endObject();
+}
+
+static void write_request_json(JsonWriter &writer, const char *key, const RequestStats &stats)
+{
+    writer.beginObject(key);
+    writer.value("sent", stats.sent_count);
+    writer.value("failed", stats.failed_count);
+    write_latency_json(writer, "latency_ms", stats.latency);
+    writer.endObject();
+}
+
+//-- LoadGenerator -----
+struct IntervalSummary
+{
+    double time_seconds;
+    int connected_client_count;
+    double controller_frames_per_second;
+    double controller_loss_ratio;
+    float controller_latency_p99_ms;
+    double tracker_frames_per_second;
+    float tracker_latency_p99_ms;
+    float request_latency_p99_ms;
+    double service_cpu_percent; // -1 if not sampled
+};
+
+class LoadGenerator
+{
+public:
+    LoadGenerator(const LoadGenSettings &settings)
+        : m_settings(settings)
+        , m_cpu_sampler(settings.service_pid)
+        , m_clients()
+        , m_interval_stats()
+        , m_intervals()
+        , m_start_time_usec(0)
+        , m_run_seconds(0.0)
+        , m_has_cpu_samples(false)
+        , m_start_cpu_seconds(0.0)
+        , m_end_cpu_seconds(0.0)
+        , m_peak_interval_cpu_percent(0.0)
+    {
+    }
+
+    ~LoadGenerator()
+    {
+        for (SimulatedClient *client : m_clients)
+        {
+            delete client;
+        }
+    }
+
+    bool run()
+    {
+        for (int client_index = 0; client_index < m_settings.client_count; ++client_index)
+        {
+            SimulatedClient *client = new SimulatedClient(client_index, m_settings, &m_interval_stats);
+
+            if (!client->startup())
+            {
+                std::cerr << "Failed to start client " << client_index << std::endl;
+                delete client;
+                return false;
+            }
+
+            m_clients.push_back(client);
+        }
+
+        m_start_time_usec = get_time_usec();
+        m_has_cpu_samples = m_cpu_sampler.sampleCpuSeconds(m_start_cpu_seconds);
+
+        if (m_settings.service_pid > 0 && !m_has_cpu_samples)
+        {
+            std::cerr << "Can't read the CPU use of process " << m_settings.service_pid << ", skipping service CPU sampling" << std::endl;
+        }
+
+        const long long duration_usec = static_cast<long long>(m_settings.duration_seconds * 1000000.f);
+        const long long report_interval_usec = static_cast<long long>(std::max(m_settings.report_interval_seconds, 0.1f) * 1000000.f);
+        long long interval_start_usec = m_start_time_usec;
+        double interval_start_cpu_seconds = m_start_cpu_seconds;
+        long long now_usec = m_start_time_usec;
+
+        while (g_keep_running && (duration_usec <= 0 || now_usec - m_start_time_usec < duration_usec))
+        {
+            for (SimulatedClient *client : m_clients)
+            {
+                client->update(now_usec);
+            }
+
+            std::this_thread::sleep_for(std::chrono::microseconds(m_settings.poll_interval_usec));
+            now_usec = get_time_usec();
+
+            if (now_usec - interval_start_usec >= report_interval_usec)
+            {
+                finish_interval(interval_start_usec, now_usec, interval_start_cpu_seconds);
+                interval_start_usec = now_usec;
+            }
+        }
+
+        if (now_usec > interval_start_usec)
+        {
+            finish_interval(interval_start_usec, now_usec, interval_start_cpu_seconds);
+        }
+
+        m_run_seconds = static_cast<double>(now_usec - m_start_time_usec) / 1000000.0;
+
+        for (SimulatedClient *client : m_clients)
+        {
+            client->shutdown();
+        }
+
+        return true;
+    }
+
+    void printSummary(std::ostream &stream) const
+    {
+        DeliveryStats controller_totals, tracker_totals;
+        RequestStats request_totals;
+
+        gather_totals(controller_totals, tracker_totals, request_totals);
+
+        stream << "Ran " << m_clients.size() << " clients for " << m_run_seconds << "s" << std::endl;
+        stream << "  controller frames: " << controller_totals.received_count
+            << " (" << get_rate(controller_totals.received_count) << "/s), "
+            << controller_totals.getLossRatio() * 100.0 << "% missing, latency p50 "
+            << controller_totals.latency.getPercentileMs(50.0) << "ms p99 "
+            << controller_totals.latency.getPercentileMs(99.0) << "ms max "
+            << controller_totals.latency.getMaxMs() << "ms" << std::endl;
+        stream << "  tracker frames: " << tracker_totals.received_count
+            << " (" << get_rate(tracker_totals.received_count) << "/s), "
+            << tracker_totals.getLossRatio() * 100.0 << "% missing, latency p99 "
+            << tracker_totals.latency.getPercentileMs(99.0) << "ms" << std::endl;
+        stream << "  requests: " << request_totals.sent_count << " sent, " << request_totals.failed_count
+            << " failed, latency p99 " << request_totals.latency.getPercentileMs(99.0) << "ms" << std::endl;
+
+        if (m_has_cpu_samples)
+        {
+            stream << "  service cpu: " << get_average_cpu_percent() << "% average, "
+                << m_peak_interval_cpu_percent << "% peak interval" << std::endl;
+        }
+    }
+
+    void writeJson(std::ostream &stream) const
+    {
+        JsonWriter writer(stream);
+        DeliveryStats controller_totals, tracker_totals;
+        RequestStats request_totals;
+
+        gather_totals(controller_totals, tracker_totals, request_totals);
+
+        writer.beginObject();
+
+        writer.beginObject("settings");
+        writer.value("host", m_settings.host);
+        writer.value("port", m_settings.port);
+        writer.value("clients", m_settings.client_count);
+        writer.value("duration_seconds", static_cast<double>(m_settings.duration_seconds));
+        writer.value("poll_interval_usec", m_settings.poll_interval_usec);
+        writer.value("stream_controllers", m_settings.stream_controllers);
+        writer.value("stream_trackers", m_settings.stream_trackers);
+        writer.value("include_position_data", m_settings.include_position_data);
+        writer.value("include_physics_data", m_settings.include_physics_data);
+        writer.value("include_raw_sensor_data", m_settings.include_raw_sensor_data);
+        writer.value("include_calibrated_sensor_data", m_settings.include_calibrated_sensor_data);
+        writer.value("include_raw_tracker_data", m_settings.include_raw_tracker_data);
+        writer.value("use_multicast", m_settings.use_multicast);
+        writer.value("max_publish_rate_hz", static_cast<double>(m_settings.max_publish_rate_hz));
+        writer.value("publish_on_change_only", m_settings.publish_on_change_only);
+        writer.value("requests_per_second", static_cast<double>(m_settings.requests_per_second));
+        writer.beginObject("request_mix");
+        for (int kind_index = 0; kind_index < REQUEST_KIND_COUNT; ++kind_index)
+        {
+            writer.value(k_request_kind_names[kind_index], m_settings.request_weights[kind_index]);
+        }
+        writer.endObject();
+        writer.endObject();
+
+        writer.value("run_seconds", m_run_seconds);
+
+        writer.beginObject("service_cpu");
+        writer.value("sampled", m_has_cpu_samples);
+        writer.value("average_percent", m_has_cpu_samples ? get_average_cpu_percent() : -1.0);
+        writer.value("peak_interval_percent", m_has_cpu_samples ? m_peak_interval_cpu_percent : -1.0);
+        writer.endObject();
+
+        writer.beginObject("totals");
+        writer.value("connected_clients", get_connected_client_count());
+        writer.value("connection_errors", get_connection_error_count());
+        write_delivery_json(writer, "controller", controller_totals, m_run_seconds);
+        write_delivery_json(writer, "tracker", tracker_totals, m_run_seconds);
+        write_request_json(writer, "requests", request_totals);
+        writer.endObject();
+
+        writer.beginArray("clients");
+        for (const SimulatedClient *client : m_clients)
+        {
+            writer.beginObject();
+            writer.value("index", client->getClientIndex());
+            writer.value("connected", client->getIsConnected());
+            writer.value("connection_errors", client->getConnectionErrorCount());
+            writer.value("controller_streams", client->getControllerStreamCount());
+            writer.value("tracker_streams", client->getTrackerStreamCount());
+            write_delivery_json(writer, "controller", client->getControllerStats(), m_run_seconds);
+            write_delivery_json(writer, "tracker", client->getTrackerStats(), m_run_seconds);
+            write_request_json(writer, "requests", client->getRequestStats());
+            writer.endObject();
+        }
+        writer.endArray();
+
+        writer.beginArray("intervals");
+        for (const IntervalSummary &interval : m_intervals)
+        {
+            writer.beginObject();
+            writer.value("time_seconds", interval.time_seconds);
+            writer.value("connected_clients", interval.connected_client_count);
+            writer.value("controller_frames_per_second", interval.controller_frames_per_second);
+            writer.value("controller_loss_ratio", interval.controller_loss_ratio);
+            writer.value("controller_latency_p99_ms", static_cast<double>(interval.controller_latency_p99_ms));
+            writer.value("tracker_frames_per_second", interval.tracker_frames_per_second);
+            writer.value("tracker_latency_p99_ms", static_cast<double>(interval.tracker_latency_p99_ms));
+            writer.value("request_latency_p99_ms", static_cast<double>(interval.request_latency_p99_ms));
+            writer.value("service_cpu_percent", interval.service_cpu_percent);
+            writer.endObject();
+        }
+        writer.endArray();
+
+        writer.endObject();
+        stream << std::endl;
+    }
+
+private:
+    void finish_interval(long long interval_start_usec, long long now_usec, double &in_out_interval_start_cpu_seconds)
+    {
+        const double interval_seconds = static_cast<double>(now_usec - interval_start_usec) / 1000000.0;
+        IntervalSummary summary;
+
+        summary.time_seconds = static_cast<double>(now_usec - m_start_time_usec) / 1000000.0;
+        summary.connected_client_count = get_connected_client_count();
+        summary.controller_frames_per_second = static_cast<double>(m_interval_stats.controller.received_count) / interval_seconds;
+        summary.controller_loss_ratio = m_interval_stats.controller.getLossRatio();
+        summary.controller_latency_p99_ms = m_interval_stats.controller.latency.getPercentileMs(99.0);
+        summary.tracker_frames_per_second = static_cast<double>(m_interval_stats.tracker.received_count) / interval_seconds;
+        summary.tracker_latency_p99_ms = m_interval_stats.tracker.latency.getPercentileMs(99.0);
+        summary.request_latency_p99_ms = m_interval_stats.requests.latency.getPercentileMs(99.0);
+        summary.service_cpu_percent = -1.0;
+
+        double cpu_seconds = 0.0;
+        if (m_has_cpu_samples && m_cpu_sampler.sampleCpuSeconds(cpu_seconds))
+        {
+            summary.service_cpu_percent = (cpu_seconds - in_out_interval_start_cpu_seconds) / interval_seconds * 100.0;
+            m_peak_interval_cpu_percent = std::max(m_peak_interval_cpu_percent, summary.service_cpu_percent);
+            m_end_cpu_seconds = cpu_seconds;
+            in_out_interval_start_cpu_seconds = cpu_seconds;
+        }
+
+        std::cout << "[" << summary.time_seconds << "s] "
+            << summary.connected_client_count << "/" << m_clients.size() << " clients connected, controllers "
+            << summary.controller_frames_per_second << " frames/s ("
+            << summary.controller_loss_ratio * 100.0 << "% missing, p99 " << summary.controller_latency_p99_ms << "ms), trackers "
+            << summary.tracker_frames_per_second << " frames/s (p99 " << summary.tracker_latency_p99_ms << "ms), requests "
+            << m_interval_stats.requests.sent_count << " (p99 " << summary.request_latency_p99_ms << "ms)";
+        if (summary.service_cpu_percent >= 0.0)
+        {
+            std::cout << ", service cpu " << summary.service_cpu_percent << "%";
+        }
+        std::cout << std::endl;
+
+        m_intervals.push_back(summary);
+        m_interval_stats.clear();
+    }
+
+    void gather_totals(DeliveryStats &out_controller, DeliveryStats &out_tracker, RequestStats &out_requests) const
+    {
+        for (const SimulatedClient *client : m_clients)
+        {
+            out_controller.merge(client->getControllerStats());
+            out_tracker.merge(client->getTrackerStats());
+            out_requests.merge(client->getRequestStats());
+        }
+    }
+
+    int get_connected_client_count() const
+    {
+        int connected_count = 0;
+
+        for (const SimulatedClient *client : m_clients)
+        {
+            connected_count += client->getIsConnected() ? 1 : 0;
+        }
+
+        return connected_count;
+    }
+
+    int get_connection_error_count() const
+    {
+        int error_count = 0;
+
+        for (const SimulatedClient *client : m_clients)
+        {
+            error_count += client->getConnectionErrorCount();
+        }
+
+        return error_count;
+    }
+
+    double get_rate(unsigned long long count) const
+    {
+        return m_run_seconds > 0.0 ? static_cast<double>(count) / m_run_seconds : 0.0;
+    }
+
+    double get_average_cpu_percent() const
+    {
+        return m_run_seconds > 0.0 ? (m_end_cpu_seconds - m_start_cpu_seconds) / m_run_seconds * 100.0 : 0.0;
+    }
+
+    const LoadGenSettings &m_settings;
+    ServiceCpuSampler m_cpu_sampler;
+    std::vector<SimulatedClient *> m_clients;
+    IntervalStats m_interval_stats;
+    std::vector<IntervalSummary> m_intervals;
+
+    long long m_start_time_usec;
+    double m_run_seconds;
+
+    bool m_has_cpu_samples;
+    double m_start_cpu_seconds;
+    double m_end_cpu_seconds;
+    double m_peak_interval_cpu_percent;
+};
+
+//-- command line -----
+static void print_usage()
+{
+    std::cerr
+        << "Usage: psmove_loadgen [options]\n"
+        << "  --host <host>               Service address (localhost)\n"
+        << "  --port <port>               Service port (" << PSMOVESERVICE_DEFAULT_PORT << ")\n"
+        << "  --clients <n>               Simulated clients (20)\n"
+        << "  --duration <s>              Run length, 0 = until interrupted (60)\n"
+        << "  --report-interval <s>       Progress report interval (10)\n"
+        << "  --poll-interval-us <us>     Sleep between network polls, bounds latency resolution (500)\n"
+        << "  --no-controllers            Don't stream controllers\n"
+        << "  --no-trackers               Don't stream trackers\n"
+        << "  --stream-flags <list>       Comma separated: position,physics,raw_sensor,calibrated_sensor,\n"
+        << "                              raw_tracker,multicast (position)\n"
+        << "  --max-rate <hz>             Controller stream rate cap, 0 = uncapped (0)\n"
+        << "  --change-only               Only publish controller frames on change\n"
+        << "  --requests-per-second <n>   Random requests per client per second (1)\n"
+        << "  --request-mix <list>        Comma separated name=weight of controller_list, tracker_list,\n"
+        << "                              tracker_settings, restart_stream (controller_list=2,tracker_list=1,tracker_settings=1)\n"
+        << "  --service-pid <pid>         Sample the service's CPU use\n"
+        << "  --json <path>               Write the results as JSON\n";
+}
+
+static bool parse_stream_flags(const std::string &list, LoadGenSettings &settings)
+{
+    std::stringstream list_stream(list);
+    std::string flag;
+    bool bSuccess = true;
+
+    settings.include_position_data = false;
+
+    while (bSuccess && std::getline(list_stream, flag, ','))
+    {
+        if (flag == "position") settings.include_position_data = true;
+        else if (flag == "physics") settings.include_physics_data = true;
+        else if (flag == "raw_sensor") settings.include_raw_sensor_data = true;
+        else if (flag == "calibrated_sensor") settings.include_calibrated_sensor_data = true;
+        else if (flag == "raw_tracker") settings.include_raw_tracker_data = true;
+        else if (flag == "multicast") settings.use_multicast = true;
+        else if (!flag.empty())
+        {
+            std::cerr << "Unknown stream flag: " << flag << std::endl;
+            bSuccess = false;
+        }
+    }
+
+    return bSuccess;
+}
+
+static bool parse_request_mix(const std::string &list, LoadGenSettings &settings)
+{
+    std::stringstream list_stream(list);
+    std::string entry;
+    bool bSuccess = true;
+
+    std::fill(settings.request_weights, settings.request_weights + REQUEST_KIND_COUNT, 0);
+
+    while (bSuccess && std::getline(list_stream, entry, ','))
+    {
+        const size_t separator = entry.find('=');
+        const std::string name = entry.substr(0, separator);
+        const int weight = (separator != std::string::npos) ? atoi(entry.c_str() + separator + 1) : 1;
+        int kind_index = 0;
+
+        while (kind_index < REQUEST_KIND_COUNT && name != k_request_kind_names[kind_index])
+        {
+            ++kind_index;
+        }
+
+        if (kind_index < REQUEST_KIND_COUNT && weight >= 0)
+        {
+            settings.request_weights[kind_index] = weight;
+        }
+        else
+        {
+            std::cerr << "Bad request mix entry: " << entry << std::endl;
+            bSuccess = false;
+        }
+    }
+
+    return bSuccess;
+}
+
+static bool parse_arguments(int argc, char *argv[], LoadGenSettings &settings)
+{
+    bool bSuccess = true;
+
+    for (int arg_index = 1; bSuccess && arg_index < argc; ++arg_index)
+    {
+        const std::string arg = argv[arg_index];
+        const bool bHasValue = arg_index + 1 < argc;
+        const char *value = bHasValue ? argv[arg_index + 1] : "";
+
+        if (arg == "--no-controllers") settings.stream_controllers = false;
+        else if (arg == "--no-trackers") settings.stream_trackers = false;
+        else if (arg == "--change-only") settings.publish_on_change_only = true;
+        else if (!bHasValue) bSuccess = false;
+        else
+        {
+            ++arg_index;
+
+            if (arg == "--host") settings.host = value;
+            else if (arg == "--port") settings.port = value;
+            else if (arg == "--clients") settings.client_count = atoi(value);
+            else if (arg == "--duration") settings.duration_seconds = static_cast<float>(atof(value));
+            else if (arg == "--report-interval") settings.report_interval_seconds = static_cast<float>(atof(value));
+            else if (arg == "--poll-interval-us") settings.poll_interval_usec = atoi(value);
+            else if (arg == "--stream-flags") bSuccess = parse_stream_flags(value, settings);
+            else if (arg == "--max-rate") settings.max_publish_rate_hz = static_cast<float>(atof(value));
+            else if (arg == "--requests-per-second") settings.requests_per_second = static_cast<float>(atof(value));
+            else if (arg == "--request-mix") bSuccess = parse_request_mix(value, settings);
+            else if (arg == "--service-pid") settings.service_pid = atoi(value);
+            else if (arg == "--json") settings.json_path = value;
+            else bSuccess = false;
+        }
+    }
+
+    return bSuccess && settings.client_count > 0 && settings.poll_interval_usec >= 0;
+}
+
+int main(int argc, char *argv[])
+{
+    LoadGenSettings settings;
+
+    if (!parse_arguments(argc, argv, settings))
+    {
+        print_usage();
+        return -1;
+    }
+
+    // The clients' connection chatter would drown out the reports
+    log_init(_log_severity_level_warning);
+
+    std::signal(SIGINT, handle_termination_signal);
+    std::signal(SIGTERM, handle_termination_signal);
+
+    LoadGenerator load_generator(settings);
+    bool success = load_generator.run();
+
+    if (success)
+    {
+        load_generator.printSummary(std::cout);
+
+        if (!settings.json_path.empty())
+        {
+            std::ofstream json_file(settings.json_path.c_str());
+
+            load_generator.writeJson(json_file);
+            success = json_file.good();
+
+            if (!success)
+            {
+                std::cerr << "Failed to write " << settings.json_path << std::endl;
+            }
+        }
+    }
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,362 @@
+#include "BlobLabeler.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+
+// Checks the run-length blob labeler used by the tracker against brute force
+// answers on small synthetic masks, checks that contours traced at a coarser
+// working resolution map back onto the full resolution frame precisely,
+// then times it on a noisy VGA mask.
+
+#define FRAME_WIDTH 640
+#define FRAME_HEIGHT 480
+#define BENCHMARK_ITERATIONS 200
+#define COARSE_PYRAMID_SCALE 4 // Same as the tracker view's
+#define MIN_WORKING_BLOB_DIAMETER 32 // Same as the tracker view's
+#define MAX_MAPPED_CENTER_ERROR 1.f // full resolution pixels (half a pixel of rounding per axis, plus sampling)
+
+struct TestPoint
+{
+    TestPoint(int _x, int _y) : x(_x), y(_y) {}
+    int x, y;
+};
+
+class TestMask
+{
+public:
+    TestMask(int width, int height)
+        : m_width(width)
+        , m_height(height)
+        , m_pixels(width*height, 0)
+    {}
+
+    void fillRect(int x0, int y0, int x1, int y1)
+    {
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                set(x, y, 255);
+    }
+
+    void fillCircle(int cx, int cy, int radius)
+    {
+        for (int y = cy - radius; y <= cy + radius; ++y)
+            for (int x = cx - radius; x <= cx + radius; ++x)
+                if ((x - cx)*(x - cx) + (y - cy)*(y - cy) <= radius*radius)
+                    set(x, y, 255);
+    }
+
+    void set(int x, int y, unsigned char value)
+    {
+        if (x >= 0 && x < m_width && y >= 0 && y < m_height)
+            m_pixels[y*m_width + x] = value;
+    }
+
+    bool isSet(int x, int y) const
+    {
+        return x >= 0 && x < m_width && y >= 0 && y < m_height && m_pixels[y*m_width + x] != 0;
+    }
+
+    // Set pixels with at least one 4-connected background neighbor
+    std::set<std::pair<int, int> > boundaryPixels() const
+    {
+        std::set<std::pair<int, int> > result;
+
+        for (int y = 0; y < m_height; ++y)
+            for (int x = 0; x < m_width; ++x)
+                if (isSet(x, y) && (!isSet(x-1, y) || !isSet(x+1, y) || !isSet(x, y-1) || !isSet(x, y+1)))
+                    result.insert(std::make_pair(x, y));
+
+        return result;
+    }
+
+    int label(BlobLabeler &labeler) const
+    {
+        return labeler.labelMask(m_pixels.data(), m_width, m_height, m_width);
+    }
+
+    // The window of this mask at 1/scale resolution, like an area resize of the
+    // window followed by the color threshold: a pixel is set when most of its block is
+    TestMask downsampleWindow(int window_x, int window_y, int window_width, int window_height, int scale) const
+    {
+        TestMask result(window_width / scale, window_height / scale);
+
+        for (int y = 0; y < result.m_height; ++y)
+        {
+            for (int x = 0; x < result.m_width; ++x)
+            {
+                int set_count = 0;
+
+                for (int block_y = 0; block_y < scale; ++block_y)
+                    for (int block_x = 0; block_x < scale; ++block_x)
+                        if (isSet(window_x + x*scale + block_x, window_y + y*scale + block_y))
+                            ++set_count;
+
+                result.set(x, y, (2*set_count >= scale*scale) ? 255 : 0);
+            }
+        }
+
+        return result;
+    }
+
+private:
+    int m_width, m_height;
+    std::vector<unsigned char> m_pixels;
+};
+
+static bool g_success= true;
+
+static void check(bool condition, const char *description)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << description << std::endl;
+        g_success= false;
+    }
+}
+
+static bool nearly_equal(double a, double b)
+{
+    return fabs(a - b) <= 1e-6 * (1.0 + fabs(a) + fabs(b));
+}
+
+// The traced boundary of a single simply connected blob should visit exactly its boundary pixels
+static void check_boundary(const TestMask &mask, const BlobLabeler &labeler, int blob_index, const char *description)
+{
+    std::vector<TestPoint> boundary;
+    labeler.traceBlobBoundary(blob_index, boundary);
+
+    std::set<std::pair<int, int> > traced;
+    for (const TestPoint &point : boundary)
+    {
+        traced.insert(std::make_pair(point.x, point.y));
+    }
+
+    check(traced == mask.boundaryPixels(), description);
+}
+
+// Mean position of the contour points
+static void get_contour_center(const std::vector<TestPoint> &contour, float &out_x, float &out_y)
+{
+    double sum_x = 0.0, sum_y = 0.0;
+
+    for (const TestPoint &point : contour)
+    {
+        sum_x += point.x;
+        sum_y += point.y;
+    }
+
+    out_x = static_cast<float>(sum_x / static_cast<double>(contour.size()));
+    out_y = static_cast<float>(sum_y / static_cast<double>(contour.size()));
+}
+
+// Mean distance of the contour points from the given center
+static float get_contour_radius(const std::vector<TestPoint> &contour, float center_x, float center_y)
+{
+    double sum = 0.0;
+
+    for (const TestPoint &point : contour)
+    {
+        sum += sqrt((point.x - center_x)*(point.x - center_x) + (point.y - center_y)*(point.y - center_y));
+    }
+
+    return static_cast<float>(sum / static_cast<double>(contour.size()));
+}
+
+int main()
+{
+    BlobLabeler labeler;
+
+    // Empty mask
+    {
+        TestMask mask(32, 32);
+
+        check(mask.label(labeler) == 0, "empty mask has no blobs");
+        check(labeler.findLargestBlob() == -1, "empty mask has no largest blob");
+    }
+
+    // Single pixel
+    {
+        TestMask mask(8, 8);
+        mask.set(3, 4, 255);
+
+        check(mask.label(labeler) == 1, "single pixel is one blob");
+
+        std::vector<TestPoint> boundary;
+        labeler.traceBlobBoundary(0, boundary);
+        check(boundary.size() == 1 && boundary[0].x == 3 && boundary[0].y == 4, "single pixel boundary");
+    }
+
+    // Rectangle: area, bounds and moments against closed form sums
+    {
+        TestMask mask(64, 48);
+        mask.fillRect(10, 5, 29, 14);
+
+        check(mask.label(labeler) == 1, "rectangle is one blob");
+
+        const BlobInfo &blob = labeler.getBlob(0);
+        double m10 = 0, m01 = 0, m20 = 0, m11 = 0, m02 = 0;
+        for (int y = 5; y <= 14; ++y)
+        {
+            for (int x = 10; x <= 29; ++x)
+            {
+                m10 += x; m01 += y; m20 += x*x; m11 += x*y; m02 += y*y;
+            }
+        }
+
+        check(blob.area == 200, "rectangle area");
+        check(blob.min_x == 10 && blob.max_x == 29 && blob.min_y == 5 && blob.max_y == 14, "rectangle bounds");
+        check(blob.start_x == 10 && blob.start_y == 5, "rectangle trace start");
+        check(nearly_equal(blob.m10, m10) && nearly_equal(blob.m01, m01), "rectangle first moments");
+        check(nearly_equal(blob.m20, m20) && nearly_equal(blob.m11, m11) && nearly_equal(blob.m02, m02), "rectangle second moments");
+        check(nearly_equal(blob.getCentroidX(), 19.5) && nearly_equal(blob.getCentroidY(), 9.5), "rectangle centroid");
+        check_boundary(mask, labeler, 0, "rectangle boundary");
+    }
+
+    // U shape and a diagonal: runs that only join further down the mask, and 8-connectivity
+    {
+        TestMask mask(64, 64);
+        mask.fillRect(5, 5, 8, 30);
+        mask.fillRect(20, 2, 23, 30);
+        mask.fillRect(5, 31, 23, 34);
+        for (int step = 0; step < 10; ++step)
+        {
+            mask.set(40 + step, 10 + step, 255);
+        }
+
+        check(mask.label(labeler) == 2, "U shape and diagonal are two blobs");
+
+        const int largest = labeler.findLargestBlob();
+        check(largest >= 0 && labeler.getBlob(largest).area == 4*26 + 4*29 + 19*4, "U shape area");
+        check(largest >= 0 && labeler.getBlob(largest).start_x == 20 && labeler.getBlob(largest).start_y == 2, "U shape trace start");
+        check(labeler.getBlob(1 - largest).area == 10, "diagonal area");
+    }
+
+    // Working resolution: the coarsest scale that leaves the blob MIN_WORKING_BLOB_DIAMETER pixels across
+    {
+        check(selectBlobWorkingScale(40, COARSE_PYRAMID_SCALE, MIN_WORKING_BLOB_DIAMETER) == 4, "big blob stays at the coarse level");
+        check(selectBlobWorkingScale(32, COARSE_PYRAMID_SCALE, MIN_WORKING_BLOB_DIAMETER) == 4, "coarse level just wide enough");
+        check(selectBlobWorkingScale(31, COARSE_PYRAMID_SCALE, MIN_WORKING_BLOB_DIAMETER) == 2, "mid size blob at half resolution");
+        check(selectBlobWorkingScale(16, COARSE_PYRAMID_SCALE, MIN_WORKING_BLOB_DIAMETER) == 2, "half resolution just wide enough");
+        check(selectBlobWorkingScale(15, COARSE_PYRAMID_SCALE, MIN_WORKING_BLOB_DIAMETER) == 1, "small blob at full resolution");
+    }
+
+    // Mapping working window points back into the frame: the middle of the block each one covers
+    {
+        std::vector<TestPoint> points;
+        points.push_back(TestPoint(0, 0));
+        points.push_back(TestPoint(3, 5));
+
+        mapWorkingPointsToFrame(8, 12, 4, points);
+        check(points[0].x == 10 && points[0].y == 14 && points[1].x == 22 && points[1].y == 34, "quarter resolution window mapping");
+
+        mapWorkingPointsToFrame(100, 50, 1, points);
+        check(points[0].x == 110 && points[0].y == 64, "full resolution window mapping only offsets");
+    }
+
+    // A disc traced at each working resolution lands where the full resolution trace does.
+    // The window is aligned to the coarse level like the tracker view's search windows.
+    {
+        const float center_x = 333.f, center_y = 241.f;
+        const int radius = 60;
+        const int window_x = 268, window_y = 176, window_size = 132;
+        TestMask frame(FRAME_WIDTH, FRAME_HEIGHT);
+        float full_resolution_radius = 0.f;
+
+        frame.fillCircle(static_cast<int>(center_x), static_cast<int>(center_y), radius);
+
+        for (int scale = 1; scale <= COARSE_PYRAMID_SCALE; scale *= 2)
+        {
+            const TestMask working = frame.downsampleWindow(window_x, window_y, window_size, window_size, scale);
+            std::vector<TestPoint> contour;
+
+            working.label(labeler);
+            labeler.traceBlobBoundary(labeler.findLargestBlob(), contour);
+
+            // What the contour would be off by without the half pixel
+            std::vector<TestPoint> unshifted_contour;
+            for (const TestPoint &point : contour)
+            {
+                unshifted_contour.push_back(TestPoint(window_x + point.x*scale, window_y + point.y*scale));
+            }
+
+            mapWorkingPointsToFrame(window_x, window_y, scale, contour);
+
+            float mapped_x, mapped_y, unshifted_x, unshifted_y;
+            get_contour_center(contour, mapped_x, mapped_y);
+            get_contour_center(unshifted_contour, unshifted_x, unshifted_y);
+
+            const float center_error = static_cast<float>(sqrt((mapped_x - center_x)*(mapped_x - center_x) + (mapped_y - center_y)*(mapped_y - center_y)));
+            const float unshifted_error = static_cast<float>(sqrt((unshifted_x - center_x)*(unshifted_x - center_x) + (unshifted_y - center_y)*(unshifted_y - center_y)));
+            const float mapped_radius = get_contour_radius(contour, center_x, center_y);
+
+            if (scale == 1)
+            {
+                full_resolution_radius = mapped_radius;
+            }
+
+            std::cout << "contour traced at 1/" << scale << " resolution: center off by " << center_error
+                << "px (" << unshifted_error << "px without the half pixel), radius " << mapped_radius
+                << "px (" << full_resolution_radius << "px at full resolution)" << std::endl;
+
+            check(contour.size() > 6, "mapped contour has enough points to fit");
+            check(center_error <= MAX_MAPPED_CENTER_ERROR, "mapped contour center matches the disc");
+            // At 1/2 resolution the middle of a block falls between two frame pixels, either way is half a pixel off
+            check(scale <= 2 || center_error < unshifted_error, "half pixel offset centers the mapped contour");
+            // Boundary pixel centers sit half a working pixel inside the edge at every resolution
+            check(fabsf(mapped_radius - full_resolution_radius) <= 0.5f*static_cast<float>(scale), "mapped contour radius matches the full resolution trace");
+        }
+    }
+
+    // Disc surrounded by single pixel noise
+    {
+        TestMask mask(FRAME_WIDTH, FRAME_HEIGHT);
+        TestMask disc(FRAME_WIDTH, FRAME_HEIGHT);
+
+        srand(1);
+        for (int speck = 0; speck < 2000; ++speck)
+        {
+            mask.set((rand() % (FRAME_WIDTH/2)) * 2, (rand() % (FRAME_HEIGHT/2)) * 2, 255);
+        }
+        mask.fillRect(300, 200, 380, 280);
+        mask.fillCircle(340, 240, 30);
+        disc.fillRect(300, 200, 380, 280);
+        disc.fillCircle(340, 240, 30);
+
+        // Keep the noise from touching the disc so the boundary check stays exact
+        for (int y = 198; y <= 282; ++y)
+        {
+            for (int x = 298; x <= 382; ++x)
+            {
+                mask.set(x, y, disc.isSet(x, y) ? 255 : 0);
+            }
+        }
+
+        const int blob_count = mask.label(labeler);
+        const int largest = labeler.findLargestBlob();
+
+        check(blob_count > 1000, "noise specks are separate blobs");
+        check(largest >= 0 && labeler.getBlob(largest).area == 81*81, "largest blob is the disc");
+        check_boundary(disc, labeler, largest, "disc boundary ignores the noise");
+
+        std::vector<TestPoint> boundary;
+        const auto start= std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < BENCHMARK_ITERATIONS; ++iteration)
+        {
+            mask.label(labeler);
+            labeler.traceBlobBoundary(labeler.findLargestBlob(), boundary);
+        }
+        const auto end= std::chrono::high_resolution_clock::now();
+
+        std::cout << "label + trace noisy " << FRAME_WIDTH << "x" << FRAME_HEIGHT << " mask (" << blob_count << " blobs): "
+            << std::chrono::duration<double, std::micro>(end - start).count() / BENCHMARK_ITERATIONS << " us/frame" << std::endl;
+    }
+
+    std::cout << (g_success ? "PASSED" : "FAILED") << std::endl;
+
+    return g_success ? 0 : -1;
+}
@@ -0,0 +1,269 @@
+#include "ColorMaskRunLength.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Checks the run-length encoding of the color mask previews the service sends for color calibration:
+// empty, full and noisy masks come back exactly as they went in, also when split across
+// many data frames, a row too big for a data frame gets clipped but still decodes to full width,
+// and malformed run streams are refused.
+
+#define MASK_WIDTH 640 // Wide enough for multi-byte run lengths
+#define MASK_HEIGHT 48
+#define MASK_STRIDE 656 // Rows padded like an OpenCV ROI
+#define MAX_RUN_BYTES 1024 // Same budget as a data frame's mask packet
+#define CLIPPED_MAX_RUN_BYTES 24
+
+typedef std::vector<unsigned char> t_mask;
+
+static void fill_mask(t_mask &mask, unsigned char value)
+{
+    mask.assign(MASK_STRIDE*MASK_HEIGHT, 0);
+
+    for (int row = 0; row < MASK_HEIGHT; ++row)
+    {
+        for (int x = 0; x < MASK_WIDTH; ++x)
+        {
+            mask[row*MASK_STRIDE + x] = value;
+        }
+    }
+}
+
+// Speckle plus a few longer runs, from a fixed seed so failures are repeatable
+static void fill_noisy_mask(t_mask &mask)
+{
+    unsigned int seed = 12345;
+
+    mask.assign(MASK_STRIDE*MASK_HEIGHT, 0);
+
+    for (int row = 0; row < MASK_HEIGHT; ++row)
+    {
+        for (int x = 0; x < MASK_WIDTH; ++x)
+        {
+            seed = seed*1103515245u + 12345u;
+
+            const bool bInBlob = x >= 200 + row && x < 350 + row;
+            const bool bSpeckle = ((seed >> 16) % 5) == 0;
+
+            // Any non-zero value counts as masked
+            mask[row*MASK_STRIDE + x] = (bInBlob != bSpeckle) ? static_cast<unsigned char>(1 + (seed >> 24) % 255) : 0;
+        }
+    }
+}
+
+static bool masks_equal(const t_mask &expected, const t_mask &decoded)
+{
+    for (int row = 0; row < MASK_HEIGHT; ++row)
+    {
+        for (int x = 0; x < MASK_WIDTH; ++x)
+        {
+            if ((expected[row*MASK_STRIDE + x] != 0 ? 255 : 0) != decoded[row*MASK_STRIDE + x])
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Encodes the whole mask in as many max_bytes sized chunks as it takes and decodes it back,
+// the way the service sends it and the client puts it back together
+static bool round_trip(const t_mask &mask, int max_bytes, t_mask &out_decoded, int &out_chunk_count, size_t &out_total_bytes)
+{
+    std::string runs;
+    int start_row = 0;
+    bool bSuccess = true;
+
+    out_decoded.assign(MASK_STRIDE*MASK_HEIGHT, 0x55);
+    out_chunk_count = 0;
+    out_total_bytes = 0;
+
+    while (bSuccess && start_row < MASK_HEIGHT)
+    {
+        const int row_count =
+            ColorMaskRunLength::encodeRows(
+                mask.data(), MASK_WIDTH, MASK_HEIGHT, MASK_STRIDE,
+                start_row, MASK_HEIGHT, max_bytes, runs);
+
+        bSuccess =
+            row_count > 0 &&
+            runs.size() <= static_cast<size_t>(max_bytes) &&
+            ColorMaskRunLength::decodeRows(
+                runs, MASK_WIDTH, row_count, out_decoded.data() + start_row*MASK_STRIDE, MASK_STRIDE);
+
+        start_row += row_count;
+        out_total_bytes += runs.size();
+        ++out_chunk_count;
+    }
+
+    return bSuccess;
+}
+
+static bool test_round_trip(const char *name, const t_mask &mask)
+{
+    t_mask decoded;
+    int chunk_count = 0;
+    size_t total_bytes = 0;
+
+    const bool bDecoded = round_trip(mask, MAX_RUN_BYTES, decoded, chunk_count, total_bytes);
+    const bool success = bDecoded && masks_equal(mask, decoded);
+
+    std::cout << name << ": " << total_bytes << " bytes in " << chunk_count << " chunk(s), "
+        << (success ? "matches" : "mismatch") << std::endl;
+
+    return success;
+}
+
+static bool test_empty_and_full_rows()
+{
+    t_mask mask;
+    std::string runs;
+    bool success = true;
+
+    // An empty row is one unmasked run, a full row an empty unmasked run and one masked run
+    fill_mask(mask, 0);
+    success &= test_round_trip("empty rows", mask);
+    success &=
+        ColorMaskRunLength::encodeRows(mask.data(), MASK_WIDTH, MASK_HEIGHT, MASK_STRIDE, 0, 1, MAX_RUN_BYTES, runs) == 1 &&
+        runs.size() == 2;
+
+    fill_mask(mask, 255);
+    success &= test_round_trip("full rows", mask);
+    success &=
+        ColorMaskRunLength::encodeRows(mask.data(), MASK_WIDTH, MASK_HEIGHT, MASK_STRIDE, 0, 1, MAX_RUN_BYTES, runs) == 1 &&
+        runs.size() == 3 && runs[0] == 0;
+
+    // Nothing left to encode past the last row
+    success &=
+        ColorMaskRunLength::encodeRows(mask.data(), MASK_WIDTH, MASK_HEIGHT, MASK_STRIDE, MASK_HEIGHT, 1, MAX_RUN_BYTES, runs) == 0 &&
+        runs.empty();
+
+    return success;
+}
+
+static bool test_noisy_rows()
+{
+    t_mask mask;
+    t_mask decoded;
+    int chunk_count = 0;
+    size_t total_bytes = 0;
+
+    fill_noisy_mask(mask);
+
+    // Too much for one data frame, so it has to come through in pieces
+    const bool success =
+        test_round_trip("noisy rows", mask) &&
+        round_trip(mask, MAX_RUN_BYTES, decoded, chunk_count, total_bytes) &&
+        chunk_count > 1;
+
+    return success;
+}
+
+static bool test_clipped_row()
+{
+    t_mask mask;
+    t_mask decoded;
+    std::string runs;
+
+    fill_noisy_mask(mask);
+
+    // A noisy row has far more runs than fit, it gets sent on its own with its tail as one run
+    const int row_count =
+        ColorMaskRunLength::encodeRows(
+            mask.data(), MASK_WIDTH, MASK_HEIGHT, MASK_STRIDE, 0, MASK_HEIGHT, CLIPPED_MAX_RUN_BYTES, runs);
+
+    decoded.assign(MASK_WIDTH, 0x55);
+    const bool bDecoded =
+        row_count == 1 &&
+        runs.size() <= CLIPPED_MAX_RUN_BYTES &&
+        ColorMaskRunLength::decodeRows(runs, MASK_WIDTH, 1, decoded.data(), MASK_WIDTH);
+
+    // Exact up to the clip, the same value all the way to the end of the row after it
+    int first_mismatch = MASK_WIDTH;
+    for (int x = 0; x < MASK_WIDTH && first_mismatch == MASK_WIDTH; ++x)
+    {
+        if ((mask[x] != 0 ? 255 : 0) != decoded[x])
+        {
+            first_mismatch = x;
+        }
+    }
+
+    bool bUniformTail = first_mismatch > 0 && first_mismatch < MASK_WIDTH;
+    for (int x = first_mismatch; bUniformTail && x < MASK_WIDTH; ++x)
+    {
+        bUniformTail = decoded[x] == decoded[MASK_WIDTH - 1] && (decoded[x] == 0 || decoded[x] == 255);
+    }
+
+    // The next call picks up with the following row
+    const int next_row_count =
+        ColorMaskRunLength::encodeRows(
+            mask.data(), MASK_WIDTH, MASK_HEIGHT, MASK_STRIDE, 1, MASK_HEIGHT, CLIPPED_MAX_RUN_BYTES, runs);
+
+    const bool success = bDecoded && bUniformTail && next_row_count == 1;
+
+    std::cout << "clipped row: " << row_count << " row in " << CLIPPED_MAX_RUN_BYTES << " bytes, exact for "
+        << first_mismatch << " of " << MASK_WIDTH << " pixels" << std::endl;
+
+    return success;
+}
+
+static bool test_malformed_runs()
+{
+    t_mask mask;
+    t_mask decoded(MASK_WIDTH*2);
+    std::string runs;
+    bool success = true;
+
+    fill_noisy_mask(mask);
+    ColorMaskRunLength::encodeRows(mask.data(), MASK_WIDTH, MASK_HEIGHT, MASK_STRIDE, 0, 2, MAX_RUN_BYTES, runs);
+
+    // Sanity check the stream the bad ones are made from
+    success &= ColorMaskRunLength::decodeRows(runs, MASK_WIDTH, 2, decoded.data(), MASK_WIDTH);
+
+    // Cut short
+    success &= !ColorMaskRunLength::decodeRows(runs.substr(0, runs.size() - 1), MASK_WIDTH, 2, decoded.data(), MASK_WIDTH);
+    // More rows asked for than were sent
+    success &= !ColorMaskRunLength::decodeRows(runs, MASK_WIDTH, 3, decoded.data(), MASK_WIDTH);
+    // Bytes left over
+    success &= !ColorMaskRunLength::decodeRows(runs + '\x01', MASK_WIDTH, 2, decoded.data(), MASK_WIDTH);
+
+    // A run longer than the row
+    std::string long_run;
+    long_run.push_back(static_cast<char>(0x81)); // 641, little endian base 128
+    long_run.push_back(static_cast<char>(0x05));
+    success &= !ColorMaskRunLength::decodeRows(long_run, MASK_WIDTH, 1, decoded.data(), MASK_WIDTH);
+
+    // Runs adding up past the row
+    std::string overflowing_runs;
+    overflowing_runs.push_back(static_cast<char>(0xD8)); // 600
+    overflowing_runs.push_back(static_cast<char>(0x04));
+    overflowing_runs.push_back(static_cast<char>(0x64)); // 100
+    success &= !ColorMaskRunLength::decodeRows(overflowing_runs, MASK_WIDTH, 1, decoded.data(), MASK_WIDTH);
+
+    // A varint that never ends, and one too long for 32 bits
+    success &= !ColorMaskRunLength::decodeRows(std::string(1, static_cast<char>(0x80)), MASK_WIDTH, 1, decoded.data(), MASK_WIDTH);
+    success &= !ColorMaskRunLength::decodeRows(std::string(6, static_cast<char>(0xFF)), MASK_WIDTH, 1, decoded.data(), MASK_WIDTH);
+
+    // Nothing at all for a row
+    success &= !ColorMaskRunLength::decodeRows(std::string(), MASK_WIDTH, 1, decoded.data(), MASK_WIDTH);
+
+    std::cout << "malformed runs: " << (success ? "refused" : "accepted") << std::endl;
+
+    return success;
+}
+
+int main()
+{
+    bool success = true;
+
+    success &= test_empty_and_full_rows();
+    success &= test_noisy_rows();
+    success &= test_clipped_row();
+    success &= test_malformed_runs();
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,346 @@
+#include "PSMoveConfig.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+// Checks the deferred config writer: saves are debounced, flushing writes everything out,
+// the latest snapshot always wins, concurrent flushes don't lose saves, synchronous saves racing
+// the writer thread never corrupt the file or leave temp files behind, and the
+// thread initializer (how the service applies its scheduling policy) runs on the writer thread.
+// Every config file the test writes is removed again at the end.
+
+#define DEBOUNCE_WAIT_MS 750 // Comfortably past the writer's 250ms debounce
+#define CONCURRENT_THREAD_COUNT 4
+#define CONCURRENT_SAVE_COUNT 50
+#define RACING_SAVE_COUNT 200
+
+class CounterConfig : public PSMoveConfig
+{
+public:
+    CounterConfig(const std::string &fnamebase) : PSMoveConfig(fnamebase), value(0) {}
+
+    int value;
+
+    virtual const boost::property_tree::ptree config2ptree()
+    {
+        boost::property_tree::ptree pt;
+        pt.put("value", value);
+        return pt;
+    }
+
+    virtual void ptree2config(const boost::property_tree::ptree &pt)
+    {
+        value = pt.get<int>("value", -1);
+    }
+};
+
+// Config files (and temp files next to them) to remove once the test is done
+static std::set<std::string> g_written_config_paths;
+
+static void note_written_config(CounterConfig &config)
+{
+    g_written_config_paths.insert(config.getConfigPath());
+}
+
+static int count_temp_files(const std::string &config_path)
+{
+    const boost::filesystem::path path(config_path);
+    const std::string temp_prefix = path.filename().string() + ".";
+    boost::system::error_code error;
+    int temp_file_count = 0;
+
+    for (boost::filesystem::directory_iterator iter(path.parent_path(), error), end; !error && iter != end; iter.increment(error))
+    {
+        const std::string filename = iter->path().filename().string();
+
+        if (filename.compare(0, temp_prefix.size(), temp_prefix) == 0 &&
+            filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".tmp") == 0)
+        {
+            ++temp_file_count;
+        }
+    }
+
+    return temp_file_count;
+}
+
+static void remove_written_configs()
+{
+    for (const std::string &config_path : g_written_config_paths)
+    {
+        const boost::filesystem::path path(config_path);
+        const std::string temp_prefix = path.filename().string() + ".";
+        boost::system::error_code error;
+        std::vector<boost::filesystem::path> temp_paths;
+
+        for (boost::filesystem::directory_iterator iter(path.parent_path(), error), end; !error && iter != end; iter.increment(error))
+        {
+            if (iter->path().filename().string().compare(0, temp_prefix.size(), temp_prefix) == 0)
+            {
+                temp_paths.push_back(iter->path());
+            }
+        }
+
+        for (const boost::filesystem::path &temp_path : temp_paths)
+        {
+            boost::filesystem::remove(temp_path, error);
+        }
+
+        boost::filesystem::remove(path, error);
+    }
+}
+
+static int read_saved_value(const std::string &fnamebase)
+{
+    CounterConfig config(fnamebase);
+
+    return config.load() ? config.value : -1;
+}
+
+static void sleep_millisecond(int sleep_ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+}
+
+static bool test_debounce()
+{
+    CounterConfig config("test_config_writer_debounce");
+    note_written_config(config);
+
+    config.value = 0;
+    config.save();
+
+    for (int value = 1; value <= 5; ++value)
+    {
+        config.value = value;
+        config.saveDeferred();
+    }
+
+    const int value_before_debounce = read_saved_value(config.ConfigFileBase);
+    sleep_millisecond(DEBOUNCE_WAIT_MS);
+    const int value_after_debounce = read_saved_value(config.ConfigFileBase);
+
+    std::cout << "debounce: " << value_before_debounce << " right away, " << value_after_debounce << " once settled" << std::endl;
+
+    return value_before_debounce == 0 && value_after_debounce == 5;
+}
+
+static bool test_flush()
+{
+    CounterConfig config("test_config_writer_flush");
+    note_written_config(config);
+
+    config.value = 6;
+    config.saveDeferred();
+    PSMoveConfig::flushDeferredSaves();
+
+    const int value_after_flush = read_saved_value(config.ConfigFileBase);
+
+    // A save after the flush has to start the writer up again
+    config.value = 7;
+    config.saveDeferred();
+    PSMoveConfig::flushDeferredSaves();
+
+    const int value_after_second_flush = read_saved_value(config.ConfigFileBase);
+
+    std::cout << "flush: " << value_after_flush << ", then " << value_after_second_flush << std::endl;
+
+    return value_after_flush == 6 && value_after_second_flush == 7;
+}
+
+static bool test_ordering()
+{
+    CounterConfig config("test_config_writer_ordering");
+    note_written_config(config);
+
+    // A synchronous save replaces a deferred one still waiting
+    config.value = 8;
+    config.saveDeferred();
+    config.value = 9;
+    config.save();
+    PSMoveConfig::flushDeferredSaves();
+
+    const int value_after_save = read_saved_value(config.ConfigFileBase);
+
+    config.value = 10;
+    config.saveDeferred();
+    config.value = 11;
+    config.saveDeferred();
+    PSMoveConfig::flushDeferredSaves();
+
+    const int value_after_deferred = read_saved_value(config.ConfigFileBase);
+
+    std::cout << "ordering: " << value_after_save << ", then " << value_after_deferred << std::endl;
+
+    return value_after_save == 9 && value_after_deferred == 11;
+}
+
+static bool test_concurrent_flush()
+{
+    std::vector<std::thread> threads;
+    bool success = true;
+
+    for (int thread_index = 0; thread_index < CONCURRENT_THREAD_COUNT; ++thread_index)
+    {
+        CounterConfig config("test_config_writer_concurrent_" + std::to_string(thread_index));
+        note_written_config(config);
+    }
+
+    for (int thread_index = 0; thread_index < CONCURRENT_THREAD_COUNT; ++thread_index)
+    {
+        threads.push_back(std::thread([thread_index]() {
+            CounterConfig config("test_config_writer_concurrent_" + std::to_string(thread_index));
+
+            for (int value = 1; value <= CONCURRENT_SAVE_COUNT; ++value)
+            {
+                config.value = value;
+                config.saveDeferred();
+
+                if ((value % 3) == 0)
+                {
+                    PSMoveConfig::flushDeferredSaves();
+                }
+            }
+        }));
+    }
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    PSMoveConfig::flushDeferredSaves();
+
+    for (int thread_index = 0; thread_index < CONCURRENT_THREAD_COUNT; ++thread_index)
+    {
+        const int saved_value = read_saved_value("test_config_writer_concurrent_" + std::to_string(thread_index));
+
+        std::cout << "concurrent flush: config " << thread_index << " saved " << saved_value << std::endl;
+        success &= (saved_value == CONCURRENT_SAVE_COUNT);
+    }
+
+    return success;
+}
+
+static bool test_racing_save()
+{
+    CounterConfig config("test_config_writer_racing");
+    std::atomic_bool bDeferredSavesDone(false);
+    int failed_save_count = 0;
+    int corrupt_read_count = 0;
+
+    note_written_config(config);
+
+    // Another copy of the same config keeps the writer thread busy with deferred saves of the same file
+    std::thread deferred_thread([&bDeferredSavesDone]() {
+        CounterConfig deferred_config("test_config_writer_racing");
+
+        for (int value = 1; value <= RACING_SAVE_COUNT; ++value)
+        {
+            deferred_config.value = -value;
+            deferred_config.saveDeferred();
+            PSMoveConfig::flushDeferredSaves();
+        }
+
+        bDeferredSavesDone = true;
+    });
+
+    // While synchronous saves and reads hit the same file
+    for (int value = 1; value <= RACING_SAVE_COUNT || !bDeferredSavesDone; ++value)
+    {
+        config.value = value;
+        if (!config.save())
+        {
+            ++failed_save_count;
+        }
+
+        try
+        {
+            boost::property_tree::ptree pt;
+            boost::property_tree::read_json(config.getConfigPath(), pt);
+        }
+        catch (const std::exception &)
+        {
+            ++corrupt_read_count;
+        }
+    }
+
+    deferred_thread.join();
+
+    // The last save always wins
+    config.value = RACING_SAVE_COUNT + 1;
+    config.save();
+    PSMoveConfig::flushDeferredSaves();
+
+    const int saved_value = read_saved_value(config.ConfigFileBase);
+    const int temp_file_count = count_temp_files(config.getConfigPath());
+
+    std::cout << "racing save: " << failed_save_count << " failed save(s), " << corrupt_read_count << " corrupt read(s), saved " << saved_value
+        << ", " << temp_file_count << " temp file(s) left" << std::endl;
+
+    return failed_save_count == 0 && corrupt_read_count == 0 && saved_value == RACING_SAVE_COUNT + 1 && temp_file_count == 0;
+}
+
+static bool test_thread_initializer()
+{
+    CounterConfig config("test_config_writer_initializer");
+    note_written_config(config);
+    std::atomic_int initializer_call_count(0);
+    std::atomic_bool bRanOnOtherThread(true);
+    const std::thread::id main_thread_id = std::this_thread::get_id();
+
+    // Set while the writer is running: runs once on the running thread
+    config.value = 12;
+    config.saveDeferred();
+    PSMoveConfig::setWriterThreadInitializer([&]() {
+        ++initializer_call_count;
+        bRanOnOtherThread = bRanOnOtherThread && std::this_thread::get_id() != main_thread_id;
+    });
+    sleep_millisecond(DEBOUNCE_WAIT_MS);
+    const int calls_while_running = initializer_call_count.load();
+    PSMoveConfig::flushDeferredSaves();
+
+    // And again when the writer starts back up
+    config.value = 13;
+    config.saveDeferred();
+    PSMoveConfig::flushDeferredSaves();
+    const int calls_after_restart = initializer_call_count.load();
+
+    // Cleared: the writer starts without it
+    PSMoveConfig::setWriterThreadInitializer(std::function<void()>());
+    config.value = 14;
+    config.saveDeferred();
+    PSMoveConfig::flushDeferredSaves();
+    const int calls_after_clear = initializer_call_count.load();
+
+    std::cout << "thread initializer: " << calls_while_running << " call(s) while running, "
+        << calls_after_restart << " after a restart, " << calls_after_clear << " after clearing" << std::endl;
+
+    return 
+        calls_while_running == 1 && calls_after_restart == 2 && calls_after_clear == 2 && 
+        bRanOnOtherThread && read_saved_value(config.ConfigFileBase) == 14;
+}
+
+int main()
+{
+    bool success = true;
+
+    success &= test_debounce();
+    success &= test_flush();
+    success &= test_ordering();
+    success &= test_concurrent_flush();
+    success &= test_racing_save();
+    success &= test_thread_initializer();
+
+    remove_written_configs();
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,307 @@
+#include "ClientControllerJitterBuffer.h"
+#include "PSMoveProtocol.pb.h"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+// Checks the client's controller jitter buffer with made up clocks:
+// frames come out in sequence order with late, duplicate and missing frames counted
+// (missing by the stream's own numbering, so frames a stream skips on purpose aren't missing),
+// the pose is interpolated between frames and extrapolated (no further than the cap) past the newest,
+// and frames get scheduled by the service's publish times moved onto the local clock
+// by the fastest transit time seen, not by when they happened to arrive.
+
+#define FRAME_INTERVAL_USEC 10000 // 100Hz controller stream
+#define BASE_TRANSIT_USEC 5000
+#define SERVICE_CLOCK_START_USEC 1000000 // The service's clock has nothing to do with ours
+#define MAX_EXTRAPOLATION_USEC 100000 // Same as the jitter buffer's cap
+#define MAX_POSITION_ERROR 0.001f // cm
+#define MAX_ORIENTATION_ERROR 0.0001f
+
+typedef PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket t_data_frame;
+
+static const long long k_presentation_time_max = std::numeric_limits<long long>::max();
+
+static long long get_publish_time_usec(int sequence_num)
+{
+    return SERVICE_CLOCK_START_USEC + static_cast<long long>(sequence_num)*FRAME_INTERVAL_USEC;
+}
+
+static void make_data_frame(
+    int sequence_num, float position_x, float yaw_radians, bool bIncludeVelocity, float velocity_x,
+    t_data_frame &out_data_frame)
+{
+    PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_PSMoveState *psmove_state;
+
+    out_data_frame.Clear();
+    out_data_frame.set_controller_type(PSMoveProtocol::PSMOVE);
+    out_data_frame.set_sequence_num(sequence_num);
+    out_data_frame.set_isconnected(true);
+    out_data_frame.set_publish_timestamp_usec(static_cast<unsigned long long>(get_publish_time_usec(sequence_num)));
+
+    psmove_state = out_data_frame.mutable_psmove_state();
+    psmove_state->mutable_position()->set_x(position_x);
+    psmove_state->mutable_orientation()->set_w(cosf(yaw_radians*0.5f));
+    psmove_state->mutable_orientation()->set_y(sinf(yaw_radians*0.5f));
+
+    if (bIncludeVelocity)
+    {
+        psmove_state->mutable_physics_data()->mutable_velocity()->set_i(velocity_x);
+        psmove_state->mutable_physics_data()->mutable_angular_velocity();
+    }
+}
+
+static void add_frame(ClientControllerJitterBuffer &jitter_buffer, int sequence_num, long long transit_usec)
+{
+    t_data_frame data_frame;
+
+    make_data_frame(sequence_num, static_cast<float>(sequence_num), 0.f, false, 0.f, data_frame);
+    jitter_buffer.addDataFrame(&data_frame, get_publish_time_usec(sequence_num) + transit_usec);
+}
+
+static bool test_ordering()
+{
+    ClientControllerJitterBuffer jitter_buffer(20.f);
+    ClientControllerJitterBufferStatistics statistics;
+    std::vector<int> presented;
+    const t_data_frame *data_frame;
+
+    // Reordered on the way, one duplicate, and 4 never shows up
+    add_frame(jitter_buffer, 1, BASE_TRANSIT_USEC);
+    add_frame(jitter_buffer, 3, BASE_TRANSIT_USEC);
+    add_frame(jitter_buffer, 2, BASE_TRANSIT_USEC);
+    add_frame(jitter_buffer, 3, BASE_TRANSIT_USEC);
+    add_frame(jitter_buffer, 5, BASE_TRANSIT_USEC);
+
+    jitter_buffer.getStatistics(statistics);
+    const bool bBufferedOk = statistics.BufferedFrameCount == 4 && statistics.MissingFrameCount == 1;
+
+    while ((data_frame = jitter_buffer.popDueDataFrame(k_presentation_time_max)) != nullptr)
+    {
+        presented.push_back(data_frame->sequence_num());
+    }
+
+    // Too late, a newer frame was already presented
+    add_frame(jitter_buffer, 4, BASE_TRANSIT_USEC);
+    jitter_buffer.getStatistics(statistics);
+
+    std::cout << "ordering: presented";
+    for (int sequence_num : presented)
+    {
+        std::cout << " " << sequence_num;
+    }
+    std::cout << ", " << statistics.LateFrameCount << " late, " << statistics.MissingFrameCount << " missing" << std::endl;
+
+    return
+        bBufferedOk &&
+        presented == std::vector<int>({ 1, 2, 3, 5 }) &&
+        statistics.BufferedFrameCount == 0 &&
+        statistics.LateFrameCount == 1 &&
+        statistics.MissingFrameCount == 1;
+}
+
+static void add_stream_frame(ClientControllerJitterBuffer &jitter_buffer, int sequence_num, int stream_sequence_num)
+{
+    t_data_frame data_frame;
+
+    make_data_frame(sequence_num, static_cast<float>(sequence_num), 0.f, false, 0.f, data_frame);
+    data_frame.set_stream_sequence_num(stream_sequence_num);
+    jitter_buffer.addDataFrame(&data_frame, get_publish_time_usec(sequence_num) + BASE_TRANSIT_USEC);
+}
+
+static bool test_stream_numbering()
+{
+    ClientControllerJitterBuffer jitter_buffer(20.f);
+    ClientControllerJitterBufferStatistics statistics;
+    bool success = true;
+
+    // A rate capped stream only gets every third controller update, none of them lost
+    add_stream_frame(jitter_buffer, 3, 1);
+    add_stream_frame(jitter_buffer, 6, 2);
+    add_stream_frame(jitter_buffer, 9, 3);
+    jitter_buffer.getStatistics(statistics);
+    success &= statistics.MissingFrameCount == 0;
+
+    // Then one does get lost, and one shows up late to fill its gap
+    add_stream_frame(jitter_buffer, 18, 6);
+    add_stream_frame(jitter_buffer, 12, 4);
+    jitter_buffer.getStatistics(statistics);
+    const int missing_after_loss = statistics.MissingFrameCount;
+    success &= missing_after_loss == 1;
+
+    // Restarting the stream numbers it from 1 again, which isn't a gap
+    add_stream_frame(jitter_buffer, 21, 1);
+    add_stream_frame(jitter_buffer, 24, 2);
+    jitter_buffer.getStatistics(statistics);
+    success &= statistics.MissingFrameCount == 1;
+
+    std::cout << "stream numbering: " << missing_after_loss << " missing after a loss, "
+        << statistics.MissingFrameCount << " after a restart" << std::endl;
+
+    return success;
+}
+
+static bool test_interpolation()
+{
+    ClientControllerJitterBuffer jitter_buffer(20.f);
+    const float yaw_90 = 1.5707963f;
+    t_data_frame data_frame;
+    PSMovePose pose;
+    bool success = true;
+
+    // Moving 10cm and turning 90 degrees over one frame interval
+    make_data_frame(1, 0.f, 0.f, false, 0.f, data_frame);
+    jitter_buffer.addDataFrame(&data_frame, get_publish_time_usec(1) + BASE_TRANSIT_USEC);
+    make_data_frame(2, 10.f, yaw_90, false, 0.f, data_frame);
+    jitter_buffer.addDataFrame(&data_frame, get_publish_time_usec(2) + BASE_TRANSIT_USEC);
+
+    // Nothing to present before the first frame is due
+    const long long first_frame_local_usec = get_publish_time_usec(1) + BASE_TRANSIT_USEC;
+    success &= jitter_buffer.popDueDataFrame(first_frame_local_usec - 1) == nullptr;
+    success &= !jitter_buffer.computePresentedPose(first_frame_local_usec - 1, pose);
+
+    // Only the first frame is due, the second is still a frame interval away
+    const t_data_frame *presented = jitter_buffer.popDueDataFrame(first_frame_local_usec);
+    success &= presented != nullptr && presented->sequence_num() == 1;
+    success &= jitter_buffer.popDueDataFrame(first_frame_local_usec) == nullptr;
+
+    // Halfway between the two
+    success &= jitter_buffer.computePresentedPose(first_frame_local_usec + FRAME_INTERVAL_USEC/2, pose);
+    const float halfway_x = pose.Position.x;
+    const float halfway_w = pose.Orientation.w;
+    const float halfway_y = pose.Orientation.y;
+    success &= fabsf(halfway_x - 5.f) <= MAX_POSITION_ERROR;
+    success &= fabsf(halfway_w - cosf(yaw_90*0.25f)) <= MAX_ORIENTATION_ERROR;
+    success &= fabsf(halfway_y - sinf(yaw_90*0.25f)) <= MAX_ORIENTATION_ERROR;
+
+    // Never past the next frame while waiting on it
+    success &= jitter_buffer.computePresentedPose(first_frame_local_usec + 3*FRAME_INTERVAL_USEC/2, pose);
+    success &= fabsf(pose.Position.x - 10.f) <= MAX_POSITION_ERROR;
+
+    std::cout << "interpolation: halfway at x=" << halfway_x << "cm, q=(" << halfway_w << ", 0, " << halfway_y << ", 0)" << std::endl;
+
+    return success;
+}
+
+static bool test_extrapolation()
+{
+    ClientControllerJitterBuffer jitter_buffer(20.f);
+    ClientControllerJitterBufferStatistics statistics;
+    t_data_frame data_frame;
+    PSMovePose pose;
+    bool success = true;
+
+    // Moving at 100cm/s with no newer frame to move towards
+    make_data_frame(1, 0.f, 0.f, true, 100.f, data_frame);
+    jitter_buffer.addDataFrame(&data_frame, get_publish_time_usec(1) + BASE_TRANSIT_USEC);
+
+    const long long frame_local_usec = get_publish_time_usec(1) + BASE_TRANSIT_USEC;
+    success &= jitter_buffer.popDueDataFrame(frame_local_usec) != nullptr;
+
+    success &= jitter_buffer.computePresentedPose(frame_local_usec + 50000, pose);
+    const float extrapolated_x = pose.Position.x;
+    success &= fabsf(extrapolated_x - 5.f) <= MAX_POSITION_ERROR;
+
+    // A long stall only gets extrapolated as far as the cap
+    success &= jitter_buffer.computePresentedPose(frame_local_usec + 10*MAX_EXTRAPOLATION_USEC, pose);
+    const float capped_x = pose.Position.x;
+    success &= fabsf(capped_x - 100.f*MAX_EXTRAPOLATION_USEC/1000000.f) <= MAX_POSITION_ERROR;
+    success &= fabsf(pose.Orientation.w - 1.f) <= MAX_ORIENTATION_ERROR;
+
+    jitter_buffer.getStatistics(statistics);
+    success &= statistics.ExtrapolatedPoseCount == 2;
+
+    // Without velocities the pose just holds
+    make_data_frame(2, 1.f, 0.f, false, 0.f, data_frame);
+    jitter_buffer.addDataFrame(&data_frame, get_publish_time_usec(2) + BASE_TRANSIT_USEC);
+    success &= jitter_buffer.popDueDataFrame(k_presentation_time_max) != nullptr;
+    success &= jitter_buffer.computePresentedPose(get_publish_time_usec(2) + BASE_TRANSIT_USEC + 50000, pose);
+    success &= fabsf(pose.Position.x - 1.f) <= MAX_POSITION_ERROR;
+
+    jitter_buffer.getStatistics(statistics);
+    success &= statistics.ExtrapolatedPoseCount == 2;
+
+    std::cout << "extrapolation: x=" << extrapolated_x << "cm after 50ms, " << capped_x << "cm after "
+        << 10*MAX_EXTRAPOLATION_USEC/1000 << "ms" << std::endl;
+
+    return success;
+}
+
+// Returns the first local time the frame with the given sequence number is due at
+static long long find_due_time(ClientControllerJitterBuffer &jitter_buffer, int sequence_num, long long search_start_usec)
+{
+    for (long long local_time_usec = search_start_usec; local_time_usec < search_start_usec + 10*FRAME_INTERVAL_USEC; ++local_time_usec)
+    {
+        const t_data_frame *data_frame = jitter_buffer.popDueDataFrame(local_time_usec);
+
+        if (data_frame != nullptr)
+        {
+            return (data_frame->sequence_num() == sequence_num) ? local_time_usec : -1;
+        }
+    }
+
+    return -1;
+}
+
+static bool test_clock_offset()
+{
+    ClientControllerJitterBuffer jitter_buffer(20.f);
+    ClientControllerJitterBufferStatistics statistics;
+    bool success = true;
+
+    // The first frame took longer than usual, the second was as quick as it gets
+    add_frame(jitter_buffer, 1, BASE_TRANSIT_USEC + 3000);
+    add_frame(jitter_buffer, 2, BASE_TRANSIT_USEC);
+    const long long due_1 = find_due_time(jitter_buffer, 1, get_publish_time_usec(1));
+    const long long due_2 = find_due_time(jitter_buffer, 2, due_1);
+
+    // Frame 1 had nothing better to go on than its own transit time,
+    // frame 2 on is placed by the fastest transit time seen
+    success &= due_1 == get_publish_time_usec(1) + BASE_TRANSIT_USEC + 3000;
+    success &= due_2 == get_publish_time_usec(2) + BASE_TRANSIT_USEC;
+
+    // A frame held up on the way still goes out a frame interval after the one before it
+    // (give or take the slow drift the offset estimate allows)
+    add_frame(jitter_buffer, 3, BASE_TRANSIT_USEC + 8000);
+    const long long due_3 = find_due_time(jitter_buffer, 3, due_2);
+    success &= due_3 >= due_2 + FRAME_INTERVAL_USEC && due_3 <= due_2 + FRAME_INTERVAL_USEC + 10;
+
+    // A frame faster than any before it moves the estimate down right away
+    add_frame(jitter_buffer, 4, BASE_TRANSIT_USEC - 1000);
+    const long long due_4 = find_due_time(jitter_buffer, 4, due_3);
+    success &= due_4 == get_publish_time_usec(4) + BASE_TRANSIT_USEC - 1000;
+
+    // Without a publish time all there is to go on is the receive time
+    t_data_frame data_frame;
+    const long long receive_time_5 = get_publish_time_usec(5) + 4*BASE_TRANSIT_USEC;
+    make_data_frame(5, 5.f, 0.f, false, 0.f, data_frame);
+    data_frame.set_publish_timestamp_usec(0);
+    jitter_buffer.addDataFrame(&data_frame, receive_time_5);
+    const long long due_5 = find_due_time(jitter_buffer, 5, due_4);
+    success &= due_5 == receive_time_5;
+
+    jitter_buffer.getStatistics(statistics);
+    success &= statistics.JitterMilliseconds > 0.f;
+
+    std::cout << "clock offset: frames due " << (due_2 - due_1) << ", " << (due_3 - due_2) << ", "
+        << (due_4 - due_3) << ", " << (due_5 - due_4) << "us apart, jitter " << statistics.JitterMilliseconds << "ms" << std::endl;
+
+    return success;
+}
+
+int main()
+{
+    bool success = true;
+
+    success &= test_ordering();
+    success &= test_stream_numbering();
+    success &= test_interpolation();
+    success &= test_extrapolation();
+    success &= test_clock_offset();
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,235 @@
+#include "DeviceInterface.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// Checks ControllerReportClock against simulated controller report streams:
+// time deltas across timestamp wraps, dropped reports across sequence counter wraps,
+// stale timestamps after a long gap, and measuring an unknown timestamp tick length
+// from jittery report arrival times (like the PSMove's).
+
+// DS4-like counters (16 bit timestamp, 5.33us ticks, 8 bit sequence, 4ms reports)
+#define DS4_TIMESTAMP_BITS 16
+#define DS4_TIMESTAMP_TICK_SECONDS (16.f / 3.f / 1000000.f)
+#define DS4_SEQUENCE_BITS 8
+#define DS4_REPORT_INTERVAL_SECONDS 0.004f
+
+// PSMove-like counters (16 bit timestamp of unknown tick length, 4 bit sequence, ~11.5ms reports)
+#define PSMOVE_TIMESTAMP_BITS 16
+#define PSMOVE_SEQUENCE_BITS 4
+#define PSMOVE_REPORT_INTERVAL_SECONDS 0.0115f
+#define PSMOVE_HIDDEN_TICK_SECONDS 0.0000072f // What the simulated controller really counts in
+#define PSMOVE_ARRIVAL_JITTER_SECONDS 0.002f
+#define PSMOVE_REPORT_COUNT 1000
+
+#define MAX_TIME_DELTA_ERROR 0.0001f // seconds
+#define MAX_TICK_MEASUREMENT_ERROR 0.01f // fraction of the real tick length
+
+typedef std::chrono::time_point<std::chrono::high_resolution_clock> t_timestamp;
+
+// Simulated controller: counts time and reports in its own wrapping counters
+struct SimulatedController
+{
+    int timestamp_bits;
+    int sequence_bits;
+    double tick_seconds;
+    double report_interval_seconds;
+
+    double controller_time;
+    int report_index;
+
+    SimulatedController(int in_timestamp_bits, int in_sequence_bits, double in_tick_seconds, double in_report_interval_seconds)
+        : timestamp_bits(in_timestamp_bits)
+        , sequence_bits(in_sequence_bits)
+        , tick_seconds(in_tick_seconds)
+        , report_interval_seconds(in_report_interval_seconds)
+        , controller_time(0.0)
+        , report_index(0)
+    {
+    }
+
+    // Advances to the next report, skipping the given number of reports that get lost
+    void advance(int dropped_report_count)
+    {
+        report_index+= dropped_report_count + 1;
+        controller_time+= report_interval_seconds * static_cast<double>(dropped_report_count + 1);
+    }
+
+    unsigned int getRawTimestamp() const
+    {
+        const unsigned long long ticks= static_cast<unsigned long long>(controller_time / tick_seconds);
+
+        return static_cast<unsigned int>(ticks & ((1ull << timestamp_bits) - 1));
+    }
+
+    int getRawSequence() const
+    {
+        return report_index & ((1 << sequence_bits) - 1);
+    }
+};
+
+static t_timestamp get_arrival_time(const t_timestamp &start, double seconds)
+{
+    return start + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+static void process_report(
+    ControllerReportClock &clock,
+    const SimulatedController &controller,
+    const t_timestamp &start,
+    double arrival_offset_seconds,
+    CommonControllerState &state)
+{
+    clock.processReport(
+        controller.getRawTimestamp(),
+        controller.getRawSequence(),
+        get_arrival_time(start, controller.controller_time + arrival_offset_seconds),
+        state);
+}
+
+static bool test_known_tick()
+{
+    const t_timestamp start= std::chrono::high_resolution_clock::now();
+    ControllerReportClock clock(DS4_TIMESTAMP_BITS, DS4_TIMESTAMP_TICK_SECONDS, DS4_SEQUENCE_BITS, DS4_REPORT_INTERVAL_SECONDS);
+    SimulatedController controller(DS4_TIMESTAMP_BITS, DS4_SEQUENCE_BITS, DS4_TIMESTAMP_TICK_SECONDS, DS4_REPORT_INTERVAL_SECONDS);
+    CommonControllerState state;
+    bool success= true;
+
+    // The first report has nothing to compare against
+    process_report(clock, controller, start, 0.0, state);
+    success&= !state.bTimeDeltaValid && state.DroppedReportCount == 0;
+
+    // Back-to-back reports, running well past several timestamp counter wraps (~350ms each)
+    int invalid_count= 0;
+    int dropped_count= 0;
+    float max_error= 0.f;
+    for (int report = 0; report < 500; ++report)
+    {
+        controller.advance(0);
+        process_report(clock, controller, start, 0.0, state);
+
+        invalid_count+= state.bTimeDeltaValid ? 0 : 1;
+        dropped_count+= state.DroppedReportCount;
+        max_error= std::max(max_error, fabsf(state.TimeDeltaSeconds - DS4_REPORT_INTERVAL_SECONDS));
+    }
+
+    std::cout << "known tick: " << invalid_count << " invalid deltas, " << dropped_count << " dropped, max dt error " << max_error << "s" << std::endl;
+    success&= invalid_count == 0 && dropped_count == 0 && max_error <= MAX_TIME_DELTA_ERROR;
+
+    // A few lost reports
+    controller.advance(3);
+    process_report(clock, controller, start, 0.0, state);
+    const int small_drop= state.DroppedReportCount;
+    const float small_drop_dt= state.TimeDeltaSeconds;
+
+    // Lose 259 reports (~1s, longer than one timestamp counter period).
+    // The timestamp can't be trusted then, so only the visible sequence step is counted.
+    controller.advance(259);
+    process_report(clock, controller, start, 0.0, state);
+    const bool bStaleAfterLongGap= !state.bTimeDeltaValid;
+    const int long_gap_drop= state.DroppedReportCount;
+
+    std::cout << "known tick: " << small_drop << " dropped (dt " << small_drop_dt << "s), after a long gap valid=" << !bStaleAfterLongGap
+        << " dropped " << long_gap_drop << std::endl;
+    success&= small_drop == 3 && fabsf(small_drop_dt - 4.f * DS4_REPORT_INTERVAL_SECONDS) <= MAX_TIME_DELTA_ERROR;
+    success&= bStaleAfterLongGap && long_gap_drop == (259 % 256);
+
+    // After reset() the next report starts over
+    clock.reset();
+    controller.advance(0);
+    process_report(clock, controller, start, 0.0, state);
+    success&= !state.bTimeDeltaValid && state.DroppedReportCount == 0;
+
+    return success;
+}
+
+static bool test_sequence_wrap_recovery()
+{
+    const t_timestamp start= std::chrono::high_resolution_clock::now();
+    const float tick_seconds= 0.00001f;
+    ControllerReportClock clock(PSMOVE_TIMESTAMP_BITS, tick_seconds, PSMOVE_SEQUENCE_BITS, PSMOVE_REPORT_INTERVAL_SECONDS);
+    SimulatedController controller(PSMOVE_TIMESTAMP_BITS, PSMOVE_SEQUENCE_BITS, tick_seconds, PSMOVE_REPORT_INTERVAL_SECONDS);
+    CommonControllerState state;
+
+    process_report(clock, controller, start, 0.0, state);
+    for (int report = 0; report < 50; ++report)
+    {
+        controller.advance(0);
+        process_report(clock, controller, start, 0.0, state);
+    }
+
+    // 4 bit sequence counter: 18 lost reports look like 2 to the counter alone
+    controller.advance(18);
+    process_report(clock, controller, start, 0.0, state);
+
+    std::cout << "sequence wrap: " << state.DroppedReportCount << " dropped (expected 18)" << std::endl;
+
+    return state.bTimeDeltaValid && state.DroppedReportCount == 18;
+}
+
+static bool test_measured_tick()
+{
+    const t_timestamp start= std::chrono::high_resolution_clock::now();
+    ControllerReportClock clock(PSMOVE_TIMESTAMP_BITS, 0.f, PSMOVE_SEQUENCE_BITS, PSMOVE_REPORT_INTERVAL_SECONDS);
+    SimulatedController controller(PSMOVE_TIMESTAMP_BITS, PSMOVE_SEQUENCE_BITS, PSMOVE_HIDDEN_TICK_SECONDS, PSMOVE_REPORT_INTERVAL_SECONDS);
+    CommonControllerState state;
+    int first_valid_report= -1;
+    int valid_before_measured= 0;
+    float max_error_after_measured= 0.f;
+
+    for (int report = 0; report < PSMOVE_REPORT_COUNT; ++report)
+    {
+        // Arrival times jitter with the USB/Bluetooth polling, and every so often a report is lost
+        const double jitter= PSMOVE_ARRIVAL_JITTER_SECONDS * sin(static_cast<double>(report) * 1.7);
+        const bool bKnownBefore= clock.getTimestampTickSeconds() > 0.f;
+
+        controller.advance((report % 37) == 36 ? 1 : 0);
+        process_report(clock, controller, start, jitter, state);
+
+        if (state.bTimeDeltaValid)
+        {
+            if (!bKnownBefore)
+            {
+                ++valid_before_measured;
+            }
+            else if (state.DroppedReportCount == 0)
+            {
+                max_error_after_measured=
+                    std::max(max_error_after_measured, fabsf(state.TimeDeltaSeconds - PSMOVE_REPORT_INTERVAL_SECONDS));
+            }
+
+            if (first_valid_report < 0)
+            {
+                first_valid_report= report;
+            }
+        }
+    }
+
+    const float measured_tick= clock.getTimestampTickSeconds();
+    const float tick_error= fabsf(measured_tick - PSMOVE_HIDDEN_TICK_SECONDS) / PSMOVE_HIDDEN_TICK_SECONDS;
+
+    std::cout << "measured tick: " << measured_tick * 1000000.f << "us (real " << PSMOVE_HIDDEN_TICK_SECONDS * 1000000.f
+        << "us, error " << tick_error * 100.f << "%), first valid dt at report " << first_valid_report
+        << ", max dt error after " << max_error_after_measured << "s" << std::endl;
+
+    // No time deltas until the tick is known, then accurate ones
+    return
+        measured_tick > 0.f && tick_error <= MAX_TICK_MEASUREMENT_ERROR &&
+        valid_before_measured == 0 && first_valid_report > 0 &&
+        max_error_after_measured <= PSMOVE_REPORT_INTERVAL_SECONDS * MAX_TICK_MEASUREMENT_ERROR;
+}
+
+int main()
+{
+    bool success= true;
+
+    success&= test_known_tick();
+    success&= test_sequence_wrap_recovery();
+    success&= test_measured_tick();
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,628 @@
+#include "BlobLabeler.h"
+#include "ControllerOpticalPoseStorage.h"
+#include "JobSystem.h"
+#include "OrientationFilter.h"
+#include "PackedMessage.h"
+#include "PositionFilter.h"
+#include "PSMoveProtocol.pb.h"
+#include "PSMoveProtocolInterface.h"
+#include "ServerLog.h"
+#include "TrackerObservationSync.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Benchmarks the per-tick tracking and publish loops at the old default device counts and at the
+// largest capacities the config allows (ControllerManager/TrackerManager k_max_supported_devices).
+// Mirrors ControllerManager::updateStateAndPredict and the publish that follows it:
+// - one job per tracker that finds every controller's blob in that tracker's coarse
+//   (1/4 resolution) mask with the real BlobLabeler and writes the per tracker estimates
+//   into the real ControllerOpticalPoseStorage
+// - one job per controller that soft synchronizes the tracker observations with the real
+//   synchronize_observation_times, fuses them (area weighted, like the optical pose fusion)
+//   out of the storage's scratch arrays and steps the real orientation and position filters
+// - the publish loops of ServerRequestHandler: for every connection, each controller's data frame
+//   filled in like generate_psmove_data_frame_for_stream (every include_* option on, so the
+//   raw tracker data covers every tracker) and each tracker's data frame, all packed into the
+//   fixed size UDP buffer like ServerNetworkManager does
+// The real ServerRequestHandler and ServerControllerView aren't driven directly since a
+// controller stream can only be started on an opened (bluetooth) controller.
+
+#define MASK_WIDTH 160
+#define MASK_HEIGHT 120
+#define WARMUP_TICK_COUNT 20
+#define TICK_COUNT 500
+#define TRACKER_TICK_BUDGET_USEC (1000000.0 / 75.0) // PS3Eye at 75fps
+#define CONNECTION_COUNT 4 // clients streaming every controller and tracker
+#define SYNC_TOLERANCE_MILLISECONDS 15 // about one frame at 75fps, like the tracker sync config default
+#define TRACKER_FOCAL_LENGTH_PX 554.f // PS3Eye at 640x480
+
+struct Point
+{
+    int x, y;
+
+    Point(int in_x, int in_y) : x(in_x), y(in_y) {}
+};
+
+struct CapacityConfig
+{
+    const char *label;
+    int tracker_count;
+    int controller_count;
+};
+
+static const CapacityConfig k_capacity_configs[] = {
+    { "default capacity", 4, 5 },
+    { "max capacity", 8, 16 },
+};
+
+// Per tracker scratch space, like the tracker view's video buffers
+struct TrackerWorkspace
+{
+    BlobLabeler labeler;
+    std::vector<unsigned char> mask;
+    std::vector<Point> boundary;
+
+    TrackerWorkspace() : mask(MASK_WIDTH*MASK_HEIGHT, 0) {}
+};
+
+struct ControllerState
+{
+    OrientationFilter orientation_filter;
+    PositionFilter position_filter;
+    Eigen::Vector3f fused_position;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    ControllerState()
+        : fused_position(Eigen::Vector3f::Zero())
+    {
+        orientation_filter.setFusionType(OrientationFilter::FusionTypeComplementaryMARG);
+        position_filter.setFusionType(PositionFilter::FusionTypeComplimentaryOpticalIMU);
+    }
+};
+
+// Stand in for thresholding the coarse level of a tracker's frame for one controller's color:
+// a disc that moves with the tick and differs per tracker/controller, plus a little noise
+static void draw_controller_mask(int tick, int tracker_id, int controller_id, std::vector<unsigned char> &mask)
+{
+    const int center_x = 30 + ((tick + tracker_id * 13 + controller_id * 7) % 100);
+    const int center_y = 30 + ((tick / 2 + controller_id * 11) % 60);
+    const int radius = 4 + ((tracker_id + controller_id) % 12);
+
+    for (int y = 0; y < MASK_HEIGHT; ++y)
+    {
+        for (int x = 0; x < MASK_WIDTH; ++x)
+        {
+            const int dx = x - center_x;
+            const int dy = y - center_y;
+            const bool bInDisc = dx*dx + dy*dy <= radius*radius;
+            const bool bNoise = ((x * 31 + y * 17 + tick * 7 + controller_id) % 211) == 0;
+
+            mask[y*MASK_WIDTH + x] = (bInDisc || bNoise) ? 255 : 0;
+        }
+    }
+}
+
+// Stand in for the per connection ControllerStreamInfo options
+struct StreamSettings
+{
+    bool include_position_data;
+    bool include_raw_sensor_data;
+    bool include_calibrated_sensor_data;
+    bool include_raw_tracker_data;
+    bool include_physics_data;
+    int stream_sequence_number;
+
+    StreamSettings()
+        : include_position_data(true)
+        , include_raw_sensor_data(true)
+        , include_calibrated_sensor_data(true)
+        , include_raw_tracker_data(true)
+        , include_physics_data(true)
+        , stream_sequence_number(0)
+    {}
+};
+
+// A connection's streams and the data frames they reuse (see acquire_stream_data_frame)
+struct ConnectionState
+{
+    std::vector<StreamSettings> controller_streams;
+    std::vector<DeviceOutputDataFramePtr> controller_data_frames;
+    std::vector<DeviceOutputDataFramePtr> tracker_data_frames;
+
+    ConnectionState(int controller_count, int tracker_count)
+        : controller_streams(controller_count)
+    {
+        for (int controller_id = 0; controller_id < controller_count; ++controller_id)
+        {
+            controller_data_frames.push_back(DeviceOutputDataFramePtr(new PSMoveProtocol::DeviceOutputDataFrame));
+        }
+
+        for (int tracker_id = 0; tracker_id < tracker_count; ++tracker_id)
+        {
+            tracker_data_frames.push_back(DeviceOutputDataFramePtr(new PSMoveProtocol::DeviceOutputDataFrame));
+        }
+    }
+};
+
+struct PublishStatistics
+{
+    int packed_frame_count;
+    int oversized_frame_count;
+    int largest_controller_frame_bytes;
+
+    PublishStatistics()
+        : packed_frame_count(0)
+        , oversized_frame_count(0)
+        , largest_controller_frame_bytes(0)
+    {}
+};
+
+static void compute_tracker_estimates(
+    int tick,
+    int tracker_id,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &frame_timestamp,
+    ControllerOpticalPoseStorage &storage,
+    TrackerWorkspace &workspace)
+{
+    for (int controller_id = 0; controller_id < storage.getControllerCount(); ++controller_id)
+    {
+        ControllerOpticalPoseSlice slice;
+        storage.getControllerSlice(controller_id, slice);
+
+        ControllerOpticalPoseEstimation &estimate = slice.tracker_pose_estimations[tracker_id];
+
+        draw_controller_mask(tick, tracker_id, controller_id, workspace.mask);
+        workspace.labeler.labelMask(workspace.mask.data(), MASK_WIDTH, MASK_HEIGHT, MASK_WIDTH);
+
+        const int blob_index = workspace.labeler.findLargestBlob();
+        workspace.labeler.traceBlobBoundary(blob_index, workspace.boundary);
+
+        estimate.last_update_timestamp = frame_timestamp;
+        estimate.bValidTimestamps = true;
+        estimate.bCurrentlyTracking = blob_index >= 0;
+        if (estimate.bCurrentlyTracking)
+        {
+            const BlobInfo &blob = workspace.labeler.getBlob(blob_index);
+            // Full resolution screen location of the blob, relative to the image center
+            const float screen_x = blob.getCentroidX() * 4.f - 320.f;
+            const float screen_y = blob.getCentroidY() * 4.f - 240.f;
+            const float half_extent = sqrtf(static_cast<float>(blob.area) / 3.14159265f) * 4.f;
+            const float distance = 50.f + static_cast<float>(workspace.boundary.size());
+
+            // Each camera exposes on its own clock, up to a frame apart
+            estimate.capture_timestamp =
+                frame_timestamp - std::chrono::microseconds(((tracker_id * 3571 + tick * 911) % 13000));
+            estimate.last_visible_timestamp = frame_timestamp;
+
+            estimate.position.x = screen_x * distance / TRACKER_FOCAL_LENGTH_PX;
+            estimate.position.y = screen_y * distance / TRACKER_FOCAL_LENGTH_PX;
+            estimate.position.z = distance;
+
+            estimate.projection.shape_type = eCommonTrackingProjectionType::ProjectionType_Ellipse;
+            estimate.projection.shape.ellipse.center.x = screen_x;
+            estimate.projection.shape.ellipse.center.y = screen_y;
+            estimate.projection.shape.ellipse.half_x_extent = half_extent;
+            estimate.projection.shape.ellipse.half_y_extent = half_extent;
+            estimate.projection.shape.ellipse.angle = 0.f;
+            estimate.projection.screen_area = static_cast<float>(blob.area) * 16.f;
+        }
+    }
+}
+
+static void update_controller(
+    int tick,
+    int controller_id,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &frame_timestamp,
+    ControllerOpticalPoseStorage &storage,
+    ControllerState &controller)
+{
+    ControllerOpticalPoseSlice slice;
+    storage.getControllerSlice(controller_id, slice);
+
+    // Gather the trackers that can see the controller
+    int valid_tracker_count = 0;
+    for (int tracker_id = 0; tracker_id < slice.tracker_count; ++tracker_id)
+    {
+        const ControllerOpticalPoseEstimation &estimate = slice.tracker_pose_estimations[tracker_id];
+
+        if (estimate.bCurrentlyTracking)
+        {
+            slice.valid_position_tracker_ids[valid_tracker_count] = tracker_id;
+            slice.capture_timestamps[valid_tracker_count] = estimate.capture_timestamp;
+            slice.orientation_weights[valid_tracker_count] = estimate.projection.screen_area;
+            ++valid_tracker_count;
+        }
+    }
+
+    // Drop the observations too old to line up with this frame
+    float capture_skew_milliseconds = 0.f;
+    const int synchronized_count = synchronize_observation_times(
+        frame_timestamp, SYNC_TOLERANCE_MILLISECONDS,
+        slice.capture_timestamps, valid_tracker_count,
+        slice.synchronized_indices, slice.extrapolation_seconds, capture_skew_milliseconds);
+
+    // Area weighted average of the synchronized observations
+    Eigen::Vector3f position_sum = Eigen::Vector3f::Zero();
+    float screen_area_sum = 0.f;
+
+    for (int list_index = 0; list_index < synchronized_count; ++list_index)
+    {
+        const int valid_index = slice.synchronized_indices[list_index];
+        const int tracker_id = slice.valid_position_tracker_ids[valid_index];
+        const CommonDevicePosition &position = slice.tracker_pose_estimations[tracker_id].position;
+        const float weight = slice.orientation_weights[valid_index];
+
+        slice.synchronized_positions[list_index] = position;
+        position_sum += Eigen::Vector3f(position.x, position.y, position.z) * weight;
+        screen_area_sum += weight;
+    }
+
+    if (screen_area_sum > 0.f)
+    {
+        controller.fused_position = position_sum / screen_area_sum;
+    }
+
+    // Two IMU frames per controller report, like the PSMove
+    const float angle = static_cast<float>(tick) * 0.01f + static_cast<float>(controller_id);
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        OrientationSensorPacket orientation_packet;
+        orientation_packet.orientation = Eigen::Quaternionf::Identity();
+        orientation_packet.orientation_source = OrientationSource_PreviousFrame;
+        orientation_packet.orientation_quality = 0.f;
+        orientation_packet.accelerometer = Eigen::Vector3f(sinf(angle) * 0.1f, 1.f, cosf(angle) * 0.1f);
+        orientation_packet.magnetometer = Eigen::Vector3f(0.f, -0.5f, 0.8f);
+        orientation_packet.gyroscope = Eigen::Vector3f(0.1f, cosf(angle), 0.05f);
+        controller.orientation_filter.update(1.f / 120.f, orientation_packet);
+
+        PositionSensorPacket position_packet;
+        position_packet.world_position = controller.fused_position;
+        position_packet.position_source = (frame == 0) ? PositionSource_Optical : PositionSource_PreviousFrame;
+        position_packet.position_quality = (screen_area_sum > 0.f) ? 1.f : 0.f;
+        position_packet.world_orientation = controller.orientation_filter.getOrientation();
+        position_packet.accelerometer = orientation_packet.accelerometer;
+        controller.position_filter.update(1.f / 120.f, position_packet);
+    }
+}
+
+// Fills in a PSMove data frame the way ServerControllerView::generate_controller_data_frame_for_stream does
+static void generate_controller_data_frame(
+    int tick,
+    int controller_id,
+    const ControllerOpticalPoseSlice &slice,
+    const ControllerState &controller,
+    const StreamSettings &stream,
+    DeviceOutputDataFramePtr &data_frame)
+{
+    auto *controller_data_frame = data_frame->mutable_controller_data_packet();
+    auto *psmove_data_frame = controller_data_frame->mutable_psmove_state();
+    const Eigen::Quaternionf orientation = controller.orientation_filter.getOrientation();
+    const Eigen::Vector3f position = controller.position_filter.getPosition();
+    const Eigen::Vector3f velocity = controller.position_filter.getVelocity();
+    const Eigen::Vector3f acceleration = controller.position_filter.getAcceleration();
+    const Eigen::Vector3f angular_velocity = controller.orientation_filter.getAngularVelocity();
+    const Eigen::Vector3f angular_acceleration = controller.orientation_filter.getAngularAcceleration();
+
+    controller_data_frame->set_controller_id(controller_id);
+    controller_data_frame->set_sequence_num(tick);
+    controller_data_frame->set_stream_sequence_num(stream.stream_sequence_number);
+    controller_data_frame->set_isconnected(true);
+    controller_data_frame->set_publish_timestamp_usec(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+
+    psmove_data_frame->set_validhardwarecalibration(true);
+    psmove_data_frame->set_iscurrentlytracking(true);
+    psmove_data_frame->set_istrackingenabled(true);
+    psmove_data_frame->set_isorientationvalid(controller.orientation_filter.getIsFusionStateValid());
+    psmove_data_frame->set_ispositionvalid(controller.position_filter.getIsFusionStateValid());
+
+    psmove_data_frame->mutable_orientation()->set_w(orientation.w());
+    psmove_data_frame->mutable_orientation()->set_x(orientation.x());
+    psmove_data_frame->mutable_orientation()->set_y(orientation.y());
+    psmove_data_frame->mutable_orientation()->set_z(orientation.z());
+
+    psmove_data_frame->mutable_position()->set_x(stream.include_position_data ? position.x() : 0.f);
+    psmove_data_frame->mutable_position()->set_y(stream.include_position_data ? position.y() : 0.f);
+    psmove_data_frame->mutable_position()->set_z(stream.include_position_data ? position.z() : 0.f);
+
+    psmove_data_frame->set_trigger_value(static_cast<unsigned char>(tick));
+    controller_data_frame->set_button_down_bitmask(tick & 0x1ff);
+
+    if (stream.include_raw_sensor_data)
+    {
+        auto *raw_sensor_data = psmove_data_frame->mutable_raw_sensor_data();
+
+        raw_sensor_data->mutable_magnetometer()->set_i(-120);
+        raw_sensor_data->mutable_magnetometer()->set_j(340);
+        raw_sensor_data->mutable_magnetometer()->set_k(-87);
+        raw_sensor_data->mutable_accelerometer()->set_i(-512 + tick % 64);
+        raw_sensor_data->mutable_accelerometer()->set_j(4096);
+        raw_sensor_data->mutable_accelerometer()->set_k(300);
+        raw_sensor_data->mutable_gyroscope()->set_i(12);
+        raw_sensor_data->mutable_gyroscope()->set_j(-7 - tick % 32);
+        raw_sensor_data->mutable_gyroscope()->set_k(3);
+    }
+
+    if (stream.include_calibrated_sensor_data)
+    {
+        auto *calibrated_sensor_data = psmove_data_frame->mutable_calibrated_sensor_data();
+
+        calibrated_sensor_data->mutable_magnetometer()->set_i(0.f);
+        calibrated_sensor_data->mutable_magnetometer()->set_j(-0.5f);
+        calibrated_sensor_data->mutable_magnetometer()->set_k(0.8f);
+        calibrated_sensor_data->mutable_accelerometer()->set_i(0.1f);
+        calibrated_sensor_data->mutable_accelerometer()->set_j(1.f);
+        calibrated_sensor_data->mutable_accelerometer()->set_k(0.1f);
+        calibrated_sensor_data->mutable_gyroscope()->set_i(angular_velocity.x());
+        calibrated_sensor_data->mutable_gyroscope()->set_j(angular_velocity.y());
+        calibrated_sensor_data->mutable_gyroscope()->set_k(angular_velocity.z());
+    }
+
+    if (stream.include_raw_tracker_data)
+    {
+        auto *raw_tracker_data = psmove_data_frame->mutable_raw_tracker_data();
+        int valid_tracker_count = 0;
+
+        // Data frames are reused from one publish to the next, so start the lists over
+        raw_tracker_data->Clear();
+
+        for (int tracker_id = 0; tracker_id < slice.tracker_count; ++tracker_id)
+        {
+            const ControllerOpticalPoseEstimation &estimate = slice.tracker_pose_estimations[tracker_id];
+
+            if (estimate.bCurrentlyTracking)
+            {
+                const CommonDevicePosition &tracker_relative_position = estimate.position;
+                const CommonDeviceTrackingProjection &projection = estimate.projection;
+
+                // Pinhole projection back onto the tracker screen
+                // (what projectTrackerRelativePosition does with no distortion, minus OpenCV)
+                {
+                    PSMoveProtocol::Pixel *pixel = raw_tracker_data->add_screen_locations();
+
+                    pixel->set_x(tracker_relative_position.x * TRACKER_FOCAL_LENGTH_PX / tracker_relative_position.z + 320.f);
+                    pixel->set_y(tracker_relative_position.y * TRACKER_FOCAL_LENGTH_PX / tracker_relative_position.z + 240.f);
+                }
+
+                {
+                    PSMoveProtocol::Position *position_data = raw_tracker_data->add_relative_positions();
+
+                    position_data->set_x(tracker_relative_position.x);
+                    position_data->set_y(tracker_relative_position.y);
+                    position_data->set_z(tracker_relative_position.z);
+                }
+
+                {
+                    PSMoveProtocol::Ellipse *ellipse = raw_tracker_data->add_projected_spheres();
+
+                    ellipse->mutable_center()->set_x(projection.shape.ellipse.center.x);
+                    ellipse->mutable_center()->set_y(projection.shape.ellipse.center.y);
+                    ellipse->set_half_x_extent(projection.shape.ellipse.half_x_extent);
+                    ellipse->set_half_y_extent(projection.shape.ellipse.half_y_extent);
+                    ellipse->set_angle(projection.shape.ellipse.angle);
+                }
+
+                raw_tracker_data->add_tracker_ids(tracker_id);
+                ++valid_tracker_count;
+            }
+        }
+
+        raw_tracker_data->set_valid_tracker_count(valid_tracker_count);
+    }
+
+    if (stream.include_physics_data)
+    {
+        auto *physics_data = psmove_data_frame->mutable_physics_data();
+
+        physics_data->mutable_velocity()->set_i(velocity.x());
+        physics_data->mutable_velocity()->set_j(velocity.y());
+        physics_data->mutable_velocity()->set_k(velocity.z());
+        physics_data->mutable_acceleration()->set_i(acceleration.x());
+        physics_data->mutable_acceleration()->set_j(acceleration.y());
+        physics_data->mutable_acceleration()->set_k(acceleration.z());
+        physics_data->mutable_angular_velocity()->set_i(angular_velocity.x());
+        physics_data->mutable_angular_velocity()->set_j(angular_velocity.y());
+        physics_data->mutable_angular_velocity()->set_k(angular_velocity.z());
+        physics_data->mutable_angular_acceleration()->set_i(angular_acceleration.x());
+        physics_data->mutable_angular_acceleration()->set_j(angular_acceleration.y());
+        physics_data->mutable_angular_acceleration()->set_k(angular_acceleration.z());
+    }
+
+    controller_data_frame->set_controller_type(PSMoveProtocol::PSMOVE);
+    data_frame->set_device_category(PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER);
+}
+
+// Fills in a tracker data frame the way ServerTrackerView::generate_tracker_data_frame_for_stream does
+static void generate_tracker_data_frame(int tick, int tracker_id, DeviceOutputDataFramePtr &data_frame)
+{
+    auto *tracker_data_frame = data_frame->mutable_tracker_data_packet();
+
+    tracker_data_frame->set_tracker_id(tracker_id);
+    tracker_data_frame->set_sequence_num(tick);
+    tracker_data_frame->set_isconnected(true);
+    tracker_data_frame->set_publish_timestamp_usec(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    tracker_data_frame->set_tracker_type(PSMoveProtocol::PS3EYE);
+
+    data_frame->set_device_category(PSMoveProtocol::DeviceOutputDataFrame::TRACKER);
+}
+
+// Packs a data frame into the fixed size UDP buffer, like ClientConnection::start_udp_write_queued_device_data_frame
+static void pack_data_frame(
+    const DeviceOutputDataFramePtr &data_frame,
+    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> &packed_data_frame,
+    boost::uint8_t *buffer, int buffer_size,
+    PublishStatistics &statistics)
+{
+    packed_data_frame.set_msg(data_frame);
+
+    if (packed_data_frame.pack(buffer, buffer_size))
+    {
+        ++statistics.packed_frame_count;
+    }
+    else
+    {
+        ++statistics.oversized_frame_count;
+    }
+}
+
+static void publish_data_frames(
+    int tick,
+    ControllerOpticalPoseStorage &storage,
+    const std::vector<ControllerState *> &controllers,
+    std::vector<ConnectionState> &connections,
+    PublishStatistics &statistics)
+{
+    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> packed_data_frame;
+    boost::uint8_t buffer[HEADER_SIZE + MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
+
+    // ControllerManager::publish: every controller to every connection streaming it
+    for (int controller_id = 0; controller_id < storage.getControllerCount(); ++controller_id)
+    {
+        ControllerOpticalPoseSlice slice;
+        storage.getControllerSlice(controller_id, slice);
+
+        for (ConnectionState &connection : connections)
+        {
+            StreamSettings &stream = connection.controller_streams[controller_id];
+            DeviceOutputDataFramePtr &data_frame = connection.controller_data_frames[controller_id];
+
+            ++stream.stream_sequence_number;
+            generate_controller_data_frame(tick, controller_id, slice, *controllers[controller_id], stream, data_frame);
+            pack_data_frame(data_frame, packed_data_frame, buffer, sizeof(buffer), statistics);
+
+            statistics.largest_controller_frame_bytes =
+                std::max(statistics.largest_controller_frame_bytes, data_frame->ByteSize());
+        }
+    }
+
+    // TrackerManager::publish: every tracker to every connection streaming it
+    for (int tracker_id = 0; tracker_id < storage.getTrackerCount(); ++tracker_id)
+    {
+        for (ConnectionState &connection : connections)
+        {
+            DeviceOutputDataFramePtr &data_frame = connection.tracker_data_frames[tracker_id];
+
+            generate_tracker_data_frame(tick, tracker_id, data_frame);
+            pack_data_frame(data_frame, packed_data_frame, buffer, sizeof(buffer), statistics);
+        }
+    }
+}
+
+static bool run_benchmark(const CapacityConfig &config, JobSystem &job_system)
+{
+    ControllerOpticalPoseStorage storage(config.controller_count, config.tracker_count);
+    std::vector<TrackerWorkspace> workspaces(config.tracker_count);
+    std::vector<ControllerState *> controllers;
+    std::vector<ConnectionState> connections;
+    PublishStatistics publish_statistics;
+    double tracker_total_usec = 0.0, tracker_max_usec = 0.0;
+    double controller_total_usec = 0.0, controller_max_usec = 0.0;
+    double publish_total_usec = 0.0, publish_max_usec = 0.0;
+
+    for (int controller_id = 0; controller_id < config.controller_count; ++controller_id)
+    {
+        controllers.push_back(new ControllerState);
+    }
+
+    for (int connection_index = 0; connection_index < CONNECTION_COUNT; ++connection_index)
+    {
+        connections.push_back(ConnectionState(config.controller_count, config.tracker_count));
+    }
+
+    for (int tick = 0; tick < WARMUP_TICK_COUNT + TICK_COUNT; ++tick)
+    {
+        const auto tracker_start = std::chrono::high_resolution_clock::now();
+
+        job_system.parallelFor(
+            config.tracker_count,
+            [tick, tracker_start, &storage, &workspaces](int tracker_id) {
+                compute_tracker_estimates(tick, tracker_id, tracker_start, storage, workspaces[tracker_id]);
+            });
+
+        const auto controller_start = std::chrono::high_resolution_clock::now();
+
+        job_system.parallelFor(
+            config.controller_count,
+            [tick, tracker_start, &storage, &controllers](int controller_id) {
+                update_controller(tick, controller_id, tracker_start, storage, *controllers[controller_id]);
+            });
+
+        const auto publish_start = std::chrono::high_resolution_clock::now();
+
+        publish_data_frames(tick, storage, controllers, connections, publish_statistics);
+
+        const auto publish_end = std::chrono::high_resolution_clock::now();
+
+        if (tick >= WARMUP_TICK_COUNT)
+        {
+            const double tracker_usec = std::chrono::duration<double, std::micro>(controller_start - tracker_start).count();
+            const double controller_usec = std::chrono::duration<double, std::micro>(publish_start - controller_start).count();
+            const double publish_usec = std::chrono::duration<double, std::micro>(publish_end - publish_start).count();
+
+            tracker_total_usec += tracker_usec;
+            tracker_max_usec = std::max(tracker_max_usec, tracker_usec);
+            controller_total_usec += controller_usec;
+            controller_max_usec = std::max(controller_max_usec, controller_usec);
+            publish_total_usec += publish_usec;
+            publish_max_usec = std::max(publish_max_usec, publish_usec);
+        }
+    }
+
+    bool bFiltersValid = true;
+    for (ControllerState *controller : controllers)
+    {
+        const Eigen::Quaternionf orientation = controller->orientation_filter.getOrientation();
+        const Eigen::Vector3f position = controller->position_filter.getPosition();
+
+        bFiltersValid &= orientation.coeffs().allFinite() && position.allFinite();
+        delete controller;
+    }
+
+    const bool bFramesFit = publish_statistics.oversized_frame_count == 0;
+    const double tick_avg_usec = (tracker_total_usec + controller_total_usec + publish_total_usec) / TICK_COUNT;
+
+    std::cout << config.label << " (" << config.tracker_count << " trackers, " << config.controller_count << " controllers, "
+        << CONNECTION_COUNT << " connections): "
+        << "per-tracker loop avg/max " << tracker_total_usec / TICK_COUNT << "/" << tracker_max_usec << " us, "
+        << "per-controller loop avg/max " << controller_total_usec / TICK_COUNT << "/" << controller_max_usec << " us, "
+        << "publish loop avg/max " << publish_total_usec / TICK_COUNT << "/" << publish_max_usec << " us, "
+        << 100.0 * tick_avg_usec / TRACKER_TICK_BUDGET_USEC << "% of a 75fps frame" << std::endl;
+    std::cout << "  " << publish_statistics.packed_frame_count << " data frames packed, largest controller frame "
+        << publish_statistics.largest_controller_frame_bytes << "/" << MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE << " bytes"
+        << (bFramesFit ? "" : " DATA FRAMES TOO BIG FOR THE UDP BUFFER")
+        << (bFiltersValid ? "" : " INVALID FILTER STATE") << std::endl;
+
+    return bFiltersValid && bFramesFit;
+}
+
+int main()
+{
+    bool success = true;
+
+    log_init("error");
+
+    {
+        JobSystem job_system(JobSystem::getDefaultThreadCount());
+
+        std::cout << job_system.getThreadCount() << " thread(s)" << std::endl;
+
+        for (const CapacityConfig &config : k_capacity_configs)
+        {
+            success &= run_benchmark(config, job_system);
+        }
+    }
+
+    log_dispose();
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,232 @@
+#include "FilterHistory.h"
+#include "OrientationFilter.h"
+#include "PositionFilter.h"
+#include "ServerLog.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// Checks the controller filter history used to fuse delayed optical measurements:
+// the ring buffer keeps the newest samples, an optical frame lands on the right sample
+// (never on or before one that was already fused), and rewinding the filters to that
+// sample and replaying the newer IMU samples gives the same result as if the optical
+// measurement had been fused on time.
+
+#define SAMPLE_COUNT 12
+#define SAMPLE_INTERVAL_MS 8
+#define OPTICAL_SAMPLE_INDEX 4
+#define MAX_REPLAY_ERROR 1e-5f
+
+typedef std::chrono::time_point<std::chrono::high_resolution_clock> t_timestamp;
+
+static t_timestamp get_sample_timestamp(const t_timestamp &start, int sample_index)
+{
+    return start + std::chrono::milliseconds(sample_index * SAMPLE_INTERVAL_MS);
+}
+
+static void init_filters(OrientationFilter &orientation_filter, PositionFilter &position_filter)
+{
+    orientation_filter.setFusionType(OrientationFilter::FusionTypeComplementaryMARG);
+    position_filter.setFusionType(PositionFilter::FusionTypeComplimentaryOpticalIMU);
+}
+
+// Steps the filters with one IMU sample, fusing an optical position along with it if asked to
+static void apply_sample(
+    int sample_index,
+    bool bApplyOptical,
+    OrientationFilter &orientation_filter,
+    PositionFilter &position_filter)
+{
+    const float angle = static_cast<float>(sample_index) * 0.1f;
+    const float delta_time = static_cast<float>(SAMPLE_INTERVAL_MS) / 1000.f;
+
+    OrientationSensorPacket orientation_packet;
+    orientation_packet.orientation = Eigen::Quaternionf::Identity();
+    orientation_packet.orientation_source = OrientationSource_PreviousFrame;
+    orientation_packet.orientation_quality = 0.f;
+    orientation_packet.accelerometer = Eigen::Vector3f(sinf(angle) * 0.2f, 1.f, cosf(angle) * 0.2f);
+    orientation_packet.magnetometer = Eigen::Vector3f(0.f, -0.5f, 0.8f);
+    orientation_packet.gyroscope = Eigen::Vector3f(0.3f, cosf(angle), 0.1f);
+    orientation_filter.update(delta_time, orientation_packet);
+
+    PositionSensorPacket position_packet;
+    position_packet.world_position = bApplyOptical ? Eigen::Vector3f(10.f, 20.f, 30.f) : position_filter.getPosition();
+    position_packet.position_source = bApplyOptical ? PositionSource_Optical : PositionSource_PreviousFrame;
+    position_packet.position_quality = bApplyOptical ? 1.f : 0.f;
+    position_packet.world_orientation = orientation_filter.getOrientation();
+    position_packet.accelerometer = orientation_packet.accelerometer;
+    position_filter.update(delta_time, position_packet);
+}
+
+static float get_filter_difference(
+    const OrientationFilter &orientation_a, const PositionFilter &position_a,
+    const OrientationFilter &orientation_b, const PositionFilter &position_b)
+{
+    const float orientation_difference = (orientation_a.getOrientation().coeffs() - orientation_b.getOrientation().coeffs()).norm();
+    const float position_difference = (position_a.getPosition() - position_b.getPosition()).norm();
+
+    return std::max(orientation_difference, position_difference);
+}
+
+static bool test_ring_buffer()
+{
+    ControllerFilterHistory history;
+    bool success = true;
+
+    for (int sample_index = 0; sample_index < k_filter_history_size + 4; ++sample_index)
+    {
+        FilterHistoryEntry &entry = history.push();
+
+        entry.poll_sequence_number = sample_index;
+        entry.bOpticalApplied = true;
+    }
+
+    const int oldest = history.at(0).poll_sequence_number;
+    const int newest = history.at(history.count - 1).poll_sequence_number;
+
+    std::cout << "ring buffer: " << history.count << " entries, oldest " << oldest << ", newest " << newest << std::endl;
+    success &= history.count == k_filter_history_size && oldest == 4 && newest == k_filter_history_size + 3;
+
+    // A pushed entry starts out without an optical measurement
+    history.at(history.count - 1).bOpticalApplied = true;
+    success &= !history.push().bOpticalApplied;
+
+    history.clear();
+    success &= history.count == 0 && history.findOpticalSampleIndex(t_timestamp()) == -1;
+
+    return success;
+}
+
+static bool test_optical_sample_index()
+{
+    const t_timestamp start = std::chrono::high_resolution_clock::now();
+    ControllerFilterHistory history;
+    bool success = true;
+
+    for (int sample_index = 0; sample_index < SAMPLE_COUNT; ++sample_index)
+    {
+        history.push().sample_timestamp = get_sample_timestamp(start, sample_index);
+    }
+
+    // Between two samples: the first sample taken after the capture
+    const int between_index = history.findOpticalSampleIndex(start + std::chrono::milliseconds(3 * SAMPLE_INTERVAL_MS - 1));
+    // Exactly on a sample
+    const int exact_index = history.findOpticalSampleIndex(get_sample_timestamp(start, 5));
+    // Older than every sample: the oldest one
+    const int oldest_index = history.findOpticalSampleIndex(start - std::chrono::milliseconds(100));
+    // Newer than every sample: the newest one
+    const int newest_index = history.findOpticalSampleIndex(get_sample_timestamp(start, SAMPLE_COUNT + 10));
+
+    std::cout << "optical sample index: between " << between_index << ", exact " << exact_index
+        << ", oldest " << oldest_index << ", newest " << newest_index << std::endl;
+    success &= between_index == 3 && exact_index == 5 && oldest_index == 0 && newest_index == SAMPLE_COUNT - 1;
+
+    // Never at or before a sample that already had an optical measurement fused
+    history.at(6).bOpticalApplied = true;
+    const int after_fused_index = history.findOpticalSampleIndex(get_sample_timestamp(start, 2));
+    const int past_fused_index = history.findOpticalSampleIndex(get_sample_timestamp(start, 9));
+
+    history.at(SAMPLE_COUNT - 1).bOpticalApplied = true;
+    const int none_left_index = history.findOpticalSampleIndex(get_sample_timestamp(start, 2));
+
+    std::cout << "optical sample index after a fused sample: " << after_fused_index << ", " << past_fused_index
+        << ", none left " << none_left_index << std::endl;
+    success &= after_fused_index == 7 && past_fused_index == 9 && none_left_index == SAMPLE_COUNT;
+
+    return success;
+}
+
+static bool test_replay_matches_on_time_fusion()
+{
+    const t_timestamp start = std::chrono::high_resolution_clock::now();
+    bool success = true;
+
+    // What the filters would have done had the optical measurement arrived on time
+    OrientationFilter on_time_orientation;
+    PositionFilter on_time_position;
+    init_filters(on_time_orientation, on_time_position);
+    for (int sample_index = 0; sample_index < SAMPLE_COUNT; ++sample_index)
+    {
+        apply_sample(sample_index, sample_index == OPTICAL_SAMPLE_INDEX, on_time_orientation, on_time_position);
+    }
+
+    // IMU only, the optical measurement never arrives
+    OrientationFilter imu_only_orientation;
+    PositionFilter imu_only_position;
+    init_filters(imu_only_orientation, imu_only_position);
+    for (int sample_index = 0; sample_index < SAMPLE_COUNT; ++sample_index)
+    {
+        apply_sample(sample_index, false, imu_only_orientation, imu_only_position);
+    }
+
+    // IMU samples go through the history as they come in, like ServerControllerView::update_filters_with_history
+    ControllerFilterHistory history;
+    OrientationFilter orientation_filter;
+    PositionFilter position_filter;
+    init_filters(orientation_filter, position_filter);
+    for (int sample_index = 0; sample_index < SAMPLE_COUNT; ++sample_index)
+    {
+        FilterHistoryEntry &entry = history.push();
+
+        entry.sample_timestamp = get_sample_timestamp(start, sample_index);
+        entry.poll_sequence_number = sample_index;
+        history.saveFiltersBefore(history.count - 1, &orientation_filter, &position_filter);
+        apply_sample(sample_index, false, orientation_filter, position_filter);
+    }
+
+    // The optical measurement shows up late: rewind to the sample it was captured at and replay
+    const int optical_index = history.findOpticalSampleIndex(get_sample_timestamp(start, OPTICAL_SAMPLE_INDEX));
+
+    history.rewindFiltersTo(optical_index, &orientation_filter, &position_filter);
+    for (int history_index = optical_index; history_index < history.count; ++history_index)
+    {
+        FilterHistoryEntry &entry = history.at(history_index);
+
+        history.saveFiltersBefore(history_index, &orientation_filter, &position_filter);
+        entry.bOpticalApplied = (history_index == optical_index);
+        apply_sample(entry.poll_sequence_number, entry.bOpticalApplied, orientation_filter, position_filter);
+    }
+
+    const float replay_error =
+        get_filter_difference(orientation_filter, position_filter, on_time_orientation, on_time_position);
+    const float optical_effect =
+        get_filter_difference(imu_only_orientation, imu_only_position, on_time_orientation, on_time_position);
+
+    std::cout << "replay: fused at sample " << optical_index << ", error vs on-time fusion " << replay_error
+        << " (optical measurement moved the filters by " << optical_effect << ")" << std::endl;
+
+    // The optical measurement has to actually matter for the comparison to mean anything
+    success &= optical_index == OPTICAL_SAMPLE_INDEX && replay_error <= MAX_REPLAY_ERROR && optical_effect > MAX_REPLAY_ERROR;
+
+    // A rewind restores the exact filter state from before the sample
+    OrientationFilter rewound_orientation;
+    PositionFilter rewound_position;
+    init_filters(rewound_orientation, rewound_position);
+    history.rewindFiltersTo(0, &rewound_orientation, &rewound_position);
+
+    OrientationFilter fresh_orientation;
+    PositionFilter fresh_position;
+    init_filters(fresh_orientation, fresh_position);
+
+    success &= get_filter_difference(rewound_orientation, rewound_position, fresh_orientation, fresh_position) == 0.f;
+
+    return success;
+}
+
+int main()
+{
+    bool success = true;
+
+    log_init("error");
+
+    success &= test_ring_buffer();
+    success &= test_optical_sample_index();
+    success &= test_replay_matches_on_time_fusion();
+
+    log_dispose();
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}
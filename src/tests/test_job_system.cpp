@@ -0,0 +1,143 @@
+#include "JobSystem.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Runs a synthetic version of the per-tick tracking work (one job per tracker that writes
+// a result slot per controller, then one job per controller that fuses its slots)
+// on the job system and checks it matches the serial answer exactly for every thread count.
+
+#define TRACKER_COUNT 8
+#define CONTROLLER_COUNT 5
+#define MAX_THREAD_COUNT 8
+#define TICK_COUNT 200
+#define WORK_ITERATIONS 2000
+
+struct SyntheticTick
+{
+    std::vector<double> tracker_results; // [tracker_id*CONTROLLER_COUNT + controller_id]
+    std::vector<double> controller_results; // [controller_id]
+
+    SyntheticTick()
+        : tracker_results(TRACKER_COUNT*CONTROLLER_COUNT, 0.0)
+        , controller_results(CONTROLLER_COUNT, 0.0)
+    {}
+};
+
+// Stand-in for finding a controller's blob in a tracker's frame
+static double synthetic_vision(int tick, int tracker_id, int controller_id)
+{
+    double value = static_cast<double>(tick + 1) * 0.001;
+
+    // Uneven work per tracker, like trackers that can and can't see a controller
+    const int iterations = WORK_ITERATIONS * (1 + (tracker_id % 3));
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        value = sin(value + static_cast<double>(tracker_id) * 0.37 + static_cast<double>(controller_id) * 0.11);
+    }
+
+    return value;
+}
+
+static void run_tick(JobSystem *job_system, int tick, SyntheticTick &state)
+{
+    job_system->parallelFor(TRACKER_COUNT, [tick, &state](int tracker_id) {
+        for (int controller_id = 0; controller_id < CONTROLLER_COUNT; ++controller_id)
+        {
+            state.tracker_results[tracker_id*CONTROLLER_COUNT + controller_id] =
+                synthetic_vision(tick, tracker_id, controller_id);
+        }
+    });
+
+    job_system->parallelFor(CONTROLLER_COUNT, [&state](int controller_id) {
+        double fused = state.controller_results[controller_id] * 0.5;
+
+        for (int tracker_id = 0; tracker_id < TRACKER_COUNT; ++tracker_id)
+        {
+            fused += state.tracker_results[tracker_id*CONTROLLER_COUNT + controller_id];
+        }
+
+        state.controller_results[controller_id] = fused;
+    });
+}
+
+static void run_serial_tick(int tick, SyntheticTick &state)
+{
+    for (int tracker_id = 0; tracker_id < TRACKER_COUNT; ++tracker_id)
+    {
+        for (int controller_id = 0; controller_id < CONTROLLER_COUNT; ++controller_id)
+        {
+            state.tracker_results[tracker_id*CONTROLLER_COUNT + controller_id] =
+                synthetic_vision(tick, tracker_id, controller_id);
+        }
+    }
+
+    for (int controller_id = 0; controller_id < CONTROLLER_COUNT; ++controller_id)
+    {
+        double fused = state.controller_results[controller_id] * 0.5;
+
+        for (int tracker_id = 0; tracker_id < TRACKER_COUNT; ++tracker_id)
+        {
+            fused += state.tracker_results[tracker_id*CONTROLLER_COUNT + controller_id];
+        }
+
+        state.controller_results[controller_id] = fused;
+    }
+}
+
+int main()
+{
+    bool success = true;
+
+    SyntheticTick expected;
+    const auto serial_start = std::chrono::high_resolution_clock::now();
+    for (int tick = 0; tick < TICK_COUNT; ++tick)
+    {
+        run_serial_tick(tick, expected);
+    }
+    const auto serial_end = std::chrono::high_resolution_clock::now();
+    const double serial_us =
+        std::chrono::duration<double, std::micro>(serial_end - serial_start).count() / TICK_COUNT;
+
+    std::cout << "serial: " << serial_us << " us/tick" << std::endl;
+
+    for (int thread_count = 1; thread_count <= MAX_THREAD_COUNT; ++thread_count)
+    {
+        JobSystem job_system(thread_count);
+        SyntheticTick actual;
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (int tick = 0; tick < TICK_COUNT; ++tick)
+        {
+            run_tick(&job_system, tick, actual);
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        const double tick_us = std::chrono::duration<double, std::micro>(end - start).count() / TICK_COUNT;
+
+        // Every job writes its own slots, so results must be bit for bit identical
+        const bool matches =
+            actual.tracker_results == expected.tracker_results &&
+            actual.controller_results == expected.controller_results;
+
+        std::cout << job_system.getThreadCount() << " thread(s): " << tick_us << " us/tick ("
+            << serial_us / tick_us << "x)" << (matches ? "" : " MISMATCH") << std::endl;
+
+        success &= matches;
+    }
+
+    // Degenerate batches
+    {
+        JobSystem job_system(4);
+        int call_count = 0;
+
+        job_system.parallelFor(0, [&call_count](int) { ++call_count; });
+        job_system.parallelFor(1, [&call_count](int) { ++call_count; });
+        success &= (call_count == 1);
+    }
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}
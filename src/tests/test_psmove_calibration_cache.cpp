@@ -0,0 +1,202 @@
+#include "PSMoveCalibrationCache.h"
+#include "ServerLog.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Checks the PS Move calibration cache: how a freshly read entry gets merged into the
+// cached one (empty fields keep the cached values, only a differing value that was
+// already cached counts as stale), the hex encoding the calibration blob is stored with,
+// and that entries make it through the config file format, serial numbers included.
+
+#define CALIBRATION_BLOB_SIZE 49 // Same size as the blob a PS Move reports
+
+static PSMoveCalibrationCacheEntry make_entry(
+    const char *bt_addr,
+    const char *host_bt_addr,
+    const std::vector<unsigned char> &calibration_blob)
+{
+    PSMoveCalibrationCacheEntry entry;
+
+    entry.bt_addr = bt_addr;
+    entry.host_bt_addr = host_bt_addr;
+    entry.calibration_blob = calibration_blob;
+
+    return entry;
+}
+
+static std::vector<unsigned char> make_blob(int seed)
+{
+    std::vector<unsigned char> blob(CALIBRATION_BLOB_SIZE);
+
+    for (int byte_index = 0; byte_index < CALIBRATION_BLOB_SIZE; ++byte_index)
+    {
+        blob[byte_index] = static_cast<unsigned char>(seed + byte_index * 37);
+    }
+
+    return blob;
+}
+
+static bool entries_equal(const PSMoveCalibrationCacheEntry &a, const PSMoveCalibrationCacheEntry &b)
+{
+    return a.bt_addr == b.bt_addr && a.host_bt_addr == b.host_bt_addr && a.calibration_blob == b.calibration_blob;
+}
+
+static bool test_merge_entry()
+{
+    const std::vector<unsigned char> blob = make_blob(1);
+    const std::vector<unsigned char> other_blob = make_blob(2);
+    const std::vector<unsigned char> no_blob;
+    PSMoveCalibrationCacheEntry cached_entry;
+    bool bChanged = true;
+    bool success = true;
+
+    // A first connection only has the addresses, nothing was cached yet so nothing is stale
+    bool bModified = PSMoveCalibrationCache::mergeEntry(
+        cached_entry, make_entry("00:06:f7:11:22:33", "00:1a:7d:da:71:13", no_blob), bChanged);
+    success &= bModified && !bChanged;
+    success &= entries_equal(cached_entry, make_entry("00:06:f7:11:22:33", "00:1a:7d:da:71:13", no_blob));
+
+    // The background read fills in the blob, which isn't stale either
+    bModified = PSMoveCalibrationCache::mergeEntry(
+        cached_entry, make_entry("00:06:f7:11:22:33", "00:1a:7d:da:71:13", blob), bChanged);
+    success &= bModified && !bChanged;
+    success &= cached_entry.calibration_blob == blob;
+
+    // Reading the same values again changes nothing
+    bModified = PSMoveCalibrationCache::mergeEntry(
+        cached_entry, make_entry("00:06:f7:11:22:33", "00:1a:7d:da:71:13", blob), bChanged);
+    success &= !bModified && !bChanged;
+
+    // Empty fields keep what was cached
+    bModified = PSMoveCalibrationCache::mergeEntry(cached_entry, make_entry("", "", no_blob), bChanged);
+    success &= !bModified && !bChanged;
+    success &= entries_equal(cached_entry, make_entry("00:06:f7:11:22:33", "00:1a:7d:da:71:13", blob));
+
+    // Paired with another host since it was cached
+    bModified = PSMoveCalibrationCache::mergeEntry(
+        cached_entry, make_entry("", "00:1a:7d:da:71:14", no_blob), bChanged);
+    success &= bModified && bChanged;
+    success &= entries_equal(cached_entry, make_entry("00:06:f7:11:22:33", "00:1a:7d:da:71:14", blob));
+
+    // Recalibrated since it was cached
+    bModified = PSMoveCalibrationCache::mergeEntry(
+        cached_entry, make_entry("00:06:f7:11:22:33", "00:1a:7d:da:71:14", other_blob), bChanged);
+    success &= bModified && bChanged;
+    success &= cached_entry.calibration_blob == other_blob;
+
+    std::cout << "merge entry: " << (success ? "ok" : "mismatch") << std::endl;
+
+    return success;
+}
+
+static bool test_hex_round_trip()
+{
+    std::vector<unsigned char> every_byte(256);
+    std::vector<unsigned char> decoded;
+    bool success = true;
+
+    for (int byte = 0; byte < 256; ++byte)
+    {
+        every_byte[byte] = static_cast<unsigned char>(byte);
+    }
+
+    const std::string every_byte_hex = PSMoveCalibrationCache::blobToHexString(every_byte);
+    success &= every_byte_hex.size() == 512;
+    success &= every_byte_hex.compare(0, 8, "00010203") == 0;
+    success &= every_byte_hex.compare(504, 8, "fcfdfeff") == 0;
+    success &= PSMoveCalibrationCache::hexStringToBlob(every_byte_hex, decoded) && decoded == every_byte;
+
+    const std::vector<unsigned char> blob = make_blob(3);
+    success &= PSMoveCalibrationCache::hexStringToBlob(PSMoveCalibrationCache::blobToHexString(blob), decoded);
+    success &= decoded == blob;
+
+    // No blob cached yet
+    success &= PSMoveCalibrationCache::blobToHexString(std::vector<unsigned char>()).empty();
+    success &= PSMoveCalibrationCache::hexStringToBlob("", decoded) && decoded.empty();
+
+    // Hand edited config files may use upper case
+    success &= PSMoveCalibrationCache::hexStringToBlob("0aFf", decoded);
+    success &= decoded.size() == 2 && decoded[0] == 0x0a && decoded[1] == 0xff;
+
+    // Malformed strings are refused and leave no partial blob behind
+    const char *malformed_strings[] = { "0", "abc", "zz", "0g", "g0", "+1", " 1", "-1", "0a 1" };
+    for (const char *malformed : malformed_strings)
+    {
+        decoded.assign(4, 0x55);
+        if (PSMoveCalibrationCache::hexStringToBlob(malformed, decoded) || !decoded.empty())
+        {
+            std::cout << "hex round trip: accepted \"" << malformed << "\"" << std::endl;
+            success = false;
+        }
+    }
+
+    std::cout << "hex round trip: " << (success ? "ok" : "mismatch") << std::endl;
+
+    return success;
+}
+
+static bool test_config_round_trip()
+{
+    PSMoveCalibrationCache &cache = PSMoveCalibrationCache::getInstance();
+    const PSMoveCalibrationCacheEntry entry = make_entry("00:06:f7:11:22:33", "00:1a:7d:da:71:13", make_blob(4));
+    // Serial numbers with '.' in them must not get split into nested config keys
+    const std::string serial = "00:06:f7:11:22:33.hid";
+    const std::string malformed_serial = "00:06:f7:44:55:66";
+    PSMoveCalibrationCacheEntry found_entry;
+    bool success = true;
+
+    // Only in memory, nothing is saved
+    boost::property_tree::ptree pt;
+    boost::property_tree::ptree entry_pt;
+    boost::property_tree::ptree malformed_entry_pt;
+
+    entry_pt.put("bt_addr", entry.bt_addr);
+    entry_pt.put("host_bt_addr", entry.host_bt_addr);
+    entry_pt.put("calibration_blob", PSMoveCalibrationCache::blobToHexString(entry.calibration_blob));
+    malformed_entry_pt.put("bt_addr", "00:06:f7:44:55:66");
+    malformed_entry_pt.put("host_bt_addr", "00:1a:7d:da:71:13");
+    malformed_entry_pt.put("calibration_blob", "not hex");
+
+    pt.put("version", PSMoveCalibrationCache::CONFIG_VERSION);
+    pt.put_child(boost::property_tree::ptree::path_type("controllers/" + serial, '/'), entry_pt);
+    pt.put_child(boost::property_tree::ptree::path_type("controllers/" + malformed_serial, '/'), malformed_entry_pt);
+
+    cache.ptree2config(pt);
+    success &= cache.findEntry(serial, found_entry) && entries_equal(found_entry, entry);
+
+    // A malformed blob is dropped but the addresses are still good
+    success &= cache.findEntry(malformed_serial, found_entry) && found_entry.calibration_blob.empty();
+
+    // And back out the same way
+    cache.ptree2config(cache.config2ptree());
+    success &= cache.findEntry(serial, found_entry) && entries_equal(found_entry, entry);
+
+    // Another config version starts over empty
+    pt.put("version", PSMoveCalibrationCache::CONFIG_VERSION + 1);
+    cache.ptree2config(pt);
+    success &= !cache.findEntry(serial, found_entry);
+
+    std::cout << "config round trip: " << (success ? "ok" : "mismatch") << std::endl;
+
+    return success;
+}
+
+int main()
+{
+    bool success = true;
+
+    log_init("info");
+
+    success &= test_merge_entry();
+    success &= test_hex_round_trip();
+    success &= test_config_round_trip();
+
+    PSMoveCalibrationCache::getInstance().shutdown();
+    log_dispose();
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,283 @@
+#include "ServerLog.h"
+#include "PackedMessage.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+// Benchmarks the server logging macros.
+// Mirrors the per-packet debug logging in ServerNetworkManager (timestamp + show_hex dump of a datagram)
+// and checks that when the log level is "info" none of those arguments get evaluated.
+// Also checks that the async sink loses no lines when it isn't overrun, including lines
+// logged from other threads while the sink is shutting down, and that the sink thread
+// initializer (how the service applies its scheduling policy) runs on the sink thread.
+
+#define ITERATION_COUNT 1000000
+#define ENABLED_ITERATION_COUNT 100000
+#define DATAGRAM_SIZE 128
+#define PACED_BATCH_COUNT 50
+#define PACED_BATCH_SIZE 1024 // Well under the sink's 4096 line ring buffer
+#define PACED_BATCH_INTERVAL_MS 20 // Plenty of time for the sink thread to empty the ring buffer
+#define SHUTDOWN_THREAD_COUNT 4
+#define SHUTDOWN_LINES_PER_THREAD 500
+
+// Eats everything written to it, so that the enabled benchmark measures the logger and not the console
+class NullStreamBuffer : public std::streambuf
+{
+protected:
+    int_type overflow(int_type c) override
+    {
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char *, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+// Eats everything written to it like NullStreamBuffer, but counts the lines
+class LineCountingStreamBuffer : public NullStreamBuffer
+{
+public:
+    LineCountingStreamBuffer() : m_line_count(0) {}
+
+    int getLineCount() const { return m_line_count.load(); }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        if (c == '\n')
+        {
+            ++m_line_count;
+        }
+
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize count) override
+    {
+        for (std::streamsize index = 0; index < count; ++index)
+        {
+            if (s[index] == '\n')
+            {
+                ++m_line_count;
+            }
+        }
+
+        return count;
+    }
+
+private:
+    std::atomic_int m_line_count;
+};
+
+// Stand in for the old SELECT_LOG_STREAM() macros, which always evaluated their arguments
+static std::ostream g_legacy_null_logger(new NullStreamBuffer);
+
+static int g_argument_evaluation_count= 0;
+static volatile int g_loop_sink= 0;
+
+static std::string expensive_log_argument(const uint8_t *buffer, unsigned length)
+{
+    ++g_argument_evaluation_count;
+    return show_hex(buffer, length);
+}
+
+static double elapsed_nsec_per_call(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &start,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &end,
+    int iterations)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+}
+
+int main()
+{
+    uint8_t datagram[DATAGRAM_SIZE];
+    bool success= true;
+
+    for (int index = 0; index < DATAGRAM_SIZE; ++index)
+    {
+        datagram[index]= static_cast<uint8_t>(index);
+    }
+
+    log_init("info");
+
+    // Baseline: the loop with no logging in it
+    {
+        const auto start= std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < ITERATION_COUNT; ++iteration)
+        {
+            g_loop_sink= iteration;
+        }
+        const auto end= std::chrono::high_resolution_clock::now();
+
+        std::cout << "baseline loop:                " << elapsed_nsec_per_call(start, end, ITERATION_COUNT) << " ns/iteration" << std::endl;
+    }
+
+    // Disabled debug logging at info level
+    {
+        const auto start= std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < ITERATION_COUNT; ++iteration)
+        {
+            g_loop_sink= iteration;
+            SERVER_LOG_DEBUG("    ") << expensive_log_argument(datagram, DATAGRAM_SIZE) << std::endl;
+        }
+        const auto end= std::chrono::high_resolution_clock::now();
+
+        std::cout << "disabled SERVER_LOG_DEBUG:    " << elapsed_nsec_per_call(start, end, ITERATION_COUNT) << " ns/iteration" << std::endl;
+
+        if (g_argument_evaluation_count != 0)
+        {
+            std::cerr << "FAILED: disabled log statement evaluated its arguments " << g_argument_evaluation_count << " times" << std::endl;
+            success= false;
+        }
+    }
+
+    // What the same disabled statement cost before the log macros were level gated
+    {
+        const auto start= std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < ENABLED_ITERATION_COUNT; ++iteration)
+        {
+            g_loop_sink= iteration;
+            g_legacy_null_logger << log_get_timestamp_prefix() << "    " << " - " << show_hex(datagram, DATAGRAM_SIZE) << std::endl;
+        }
+        const auto end= std::chrono::high_resolution_clock::now();
+
+        std::cout << "legacy null stream:           " << elapsed_nsec_per_call(start, end, ENABLED_ITERATION_COUNT) << " ns/iteration" << std::endl;
+    }
+
+    // Enabled info logging through the async sink (console output discarded)
+    {
+        NullStreamBuffer null_buffer;
+        std::streambuf *console_buffer= std::cout.rdbuf(&null_buffer);
+
+        const auto start= std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < ENABLED_ITERATION_COUNT; ++iteration)
+        {
+            SERVER_LOG_INFO("test_server_log") << "iteration " << iteration;
+        }
+        const auto end= std::chrono::high_resolution_clock::now();
+
+        log_dispose();
+        std::cout.rdbuf(console_buffer);
+
+        std::cout << "enabled SERVER_LOG_INFO:      " << elapsed_nsec_per_call(start, end, ENABLED_ITERATION_COUNT) << " ns/iteration (async)" << std::endl;
+    }
+
+    // Enabled info logging paced so that the sink never fills up and drops lines.
+    // Only the logging calls are timed, not the pauses that let the sink catch up.
+    {
+        LineCountingStreamBuffer counting_buffer;
+        std::streambuf *console_buffer= std::cout.rdbuf(&counting_buffer);
+        double total_nsec= 0.0;
+
+        log_init("info");
+
+        for (int batch = 0; batch < PACED_BATCH_COUNT; ++batch)
+        {
+            const auto start= std::chrono::high_resolution_clock::now();
+            for (int iteration = 0; iteration < PACED_BATCH_SIZE; ++iteration)
+            {
+                SERVER_LOG_INFO("test_server_log") << "batch " << batch << " iteration " << iteration;
+            }
+            const auto end= std::chrono::high_resolution_clock::now();
+
+            total_nsec+= std::chrono::duration<double, std::nano>(end - start).count();
+            std::this_thread::sleep_for(std::chrono::milliseconds(PACED_BATCH_INTERVAL_MS));
+        }
+
+        log_dispose();
+        std::cout.rdbuf(console_buffer);
+
+        const int expected_line_count= PACED_BATCH_COUNT*PACED_BATCH_SIZE;
+        const int line_count= counting_buffer.getLineCount();
+
+        std::cout << "paced SERVER_LOG_INFO:        " << total_nsec / static_cast<double>(expected_line_count) << " ns/iteration (async, no drops)" << std::endl;
+
+        // A "lines dropped" notice would show up as an extra line
+        if (line_count != expected_line_count)
+        {
+            std::cerr << "FAILED: paced logging wrote " << line_count << " of " << expected_line_count << " lines" << std::endl;
+            success= false;
+        }
+    }
+
+    // Lines logged from other threads while the sink shuts down are all written out
+    {
+        LineCountingStreamBuffer counting_buffer;
+        std::streambuf *console_buffer= std::cout.rdbuf(&counting_buffer);
+        std::vector<std::thread> threads;
+
+        log_init("info");
+
+        for (int thread_index = 0; thread_index < SHUTDOWN_THREAD_COUNT; ++thread_index)
+        {
+            threads.push_back(std::thread([thread_index]() {
+                for (int iteration = 0; iteration < SHUTDOWN_LINES_PER_THREAD; ++iteration)
+                {
+                    SERVER_MT_LOG_INFO("test_server_log") << "thread " << thread_index << " iteration " << iteration;
+                }
+            }));
+        }
+
+        log_dispose();
+
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        std::cout.rdbuf(console_buffer);
+
+        const int expected_line_count= SHUTDOWN_THREAD_COUNT*SHUTDOWN_LINES_PER_THREAD;
+        const int line_count= counting_buffer.getLineCount();
+
+        std::cout << "lines logged during shutdown: " << line_count << "/" << expected_line_count << std::endl;
+
+        if (line_count != expected_line_count)
+        {
+            success= false;
+        }
+    }
+
+    // The sink thread initializer runs on the sink thread, once when set and again on every restart
+    {
+        std::atomic_int initializer_call_count(0);
+        std::atomic_bool bRanOnOtherThread(true);
+        const std::thread::id main_thread_id= std::this_thread::get_id();
+
+        log_init("info");
+        log_set_sink_thread_initializer([&]() {
+            ++initializer_call_count;
+            bRanOnOtherThread= bRanOnOtherThread && std::this_thread::get_id() != main_thread_id;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(PACED_BATCH_INTERVAL_MS));
+        const int calls_while_running= initializer_call_count.load();
+
+        log_dispose();
+        log_init("info");
+        std::this_thread::sleep_for(std::chrono::milliseconds(PACED_BATCH_INTERVAL_MS));
+        const int calls_after_restart= initializer_call_count.load();
+
+        log_set_sink_thread_initializer(std::function<void()>());
+        log_dispose();
+
+        std::cout << "sink thread initializer:      " << calls_while_running << " call(s) while running, "
+            << calls_after_restart << " after a restart" << std::endl;
+
+        if (calls_while_running != 1 || calls_after_restart != 2 || !bRanOnOtherThread)
+        {
+            success= false;
+        }
+    }
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,462 @@
+#include "AllocationTracker.h"
+#include "BlobLabeler.h"
+#include "DeviceManager.h"
+#include "InPlaceMessageParser.h"
+#include "JobSystem.h"
+#include "PackedMessage.h"
+#include "PSMoveProtocol.pb.h"
+#include "ServerLog.h"
+#include "ServerNetworkManager.h"
+#include "ServerRequestHandler.h"
+
+#include <boost/asio.hpp>
+#include <boost/circular_buffer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Built with the service sources and PSMOVESERVICE_TRACK_ALLOCATIONS so the global allocator is hooked.
+// Checks that the counting works at all (operator new and, where it can be hooked, malloc),
+// that the pieces the update loop leans on every tick (blob labeling, the job system,
+// the device state queues, parsing input data frames) stop allocating once they have warmed up,
+// and then runs the real update loop (DeviceManager + ServerNetworkManager) while a client
+// streams controller input data frames at it over UDP.
+
+#define MASK_WIDTH 160
+#define MASK_HEIGHT 120
+#define WARMUP_TICK_COUNT 10
+#define STEADY_TICK_COUNT 200
+#define JOB_THREAD_COUNT 3
+#define JOB_COUNT 8
+#define STATE_BUFFER_MAX 16
+#define PARSE_CONTROLLER_FRAME_INTERVAL 10
+#define PARSE_MAX_OBSERVATIONS 3
+#define SERVICE_PORT 9519 // Not the service's own port, so the test can run next to it
+#define SERVICE_WARMUP_MS 2000 // Enough for startup enumeration and the client connection to settle
+#define SERVICE_STEADY_MS 2500 // Covers at least two periodic controller enumerations (without hotplug events)
+#define SERVICE_TICK_SLEEP_MS 1 // Same as PSMOVE_UPDATE_SLEEP_MS
+#define CLIENT_SEND_INTERVAL_MS 4
+
+struct Point
+{
+    int x, y;
+
+    Point(int in_x, int in_y) : x(in_x), y(in_y) {}
+};
+
+struct DeviceState
+{
+    int sequence;
+    float values[32];
+};
+
+// Draws a moving disc plus a little noise so the blob count and boundary length change every tick
+static void draw_mask(int tick, std::vector<unsigned char> &mask)
+{
+    const int center_x = 40 + (tick % 80);
+    const int center_y = 60 + ((tick / 3) % 20) - 10;
+    const int radius = 10 + (tick % 7);
+
+    for (int y = 0; y < MASK_HEIGHT; ++y)
+    {
+        for (int x = 0; x < MASK_WIDTH; ++x)
+        {
+            const int dx = x - center_x;
+            const int dy = y - center_y;
+            const bool bInDisc = dx*dx + dy*dy <= radius*radius;
+            const bool bNoise = ((x * 31 + y * 17 + tick * 7) % 97) == 0;
+
+            mask[y*MASK_WIDTH + x] = (bInDisc || bNoise) ? 255 : 0;
+        }
+    }
+}
+
+// Keeps the optimizer from eliding the deliberate allocations
+static int *volatile g_deliberate_allocation = nullptr;
+
+static bool test_counting()
+{
+    AllocationTracker::trackCurrentThread();
+
+    unsigned long long start = AllocationTracker::getAllocationCount();
+    g_deliberate_allocation = new int(42);
+    const unsigned long long new_count = AllocationTracker::getAllocationCount() - start;
+    delete g_deliberate_allocation;
+
+    // Like the C APIs and cv::fastMalloc do
+    start = AllocationTracker::getAllocationCount();
+    g_deliberate_allocation = static_cast<int *>(std::malloc(sizeof(int)));
+    const unsigned long long malloc_count = AllocationTracker::getAllocationCount() - start;
+    std::free(g_deliberate_allocation);
+
+    const unsigned long long expected_malloc_count = AllocationTracker::getIsMallocHooked() ? 1 : 0;
+    const bool success = AllocationTracker::getIsEnabled() && new_count == 1 && malloc_count == expected_malloc_count;
+
+    std::cout << "counting: " << new_count << " allocation(s) seen for one new, "
+        << malloc_count << " for one malloc (malloc " << (AllocationTracker::getIsMallocHooked() ? "hooked" : "not hooked")
+        << ")" << std::endl;
+
+    return success;
+}
+
+static bool test_blob_labeler()
+{
+    BlobLabeler labeler;
+    std::vector<unsigned char> mask(MASK_WIDTH*MASK_HEIGHT, 0);
+    std::vector<Point> boundary;
+    int blob_total = 0;
+
+    for (int tick = 0; tick < WARMUP_TICK_COUNT; ++tick)
+    {
+        // Warm up with the biggest disc so every buffer reaches its steady state size
+        draw_mask(6, mask);
+        labeler.labelMask(mask.data(), MASK_WIDTH, MASK_HEIGHT, MASK_WIDTH);
+        labeler.traceBlobBoundary(labeler.findLargestBlob(), boundary);
+    }
+
+    const unsigned long long start = AllocationTracker::getAllocationCount();
+    for (int tick = 0; tick < STEADY_TICK_COUNT; ++tick)
+    {
+        draw_mask(tick, mask);
+        blob_total += labeler.labelMask(mask.data(), MASK_WIDTH, MASK_HEIGHT, MASK_WIDTH);
+        labeler.traceBlobBoundary(labeler.findLargestBlob(), boundary);
+    }
+    const unsigned long long allocation_count = AllocationTracker::getAllocationCount() - start;
+
+    std::cout << "blob labeler: " << allocation_count << " allocation(s) over " << STEADY_TICK_COUNT
+        << " ticks (" << blob_total << " blobs)" << std::endl;
+
+    return blob_total > 0 && allocation_count == 0;
+}
+
+static bool test_job_system()
+{
+    bool success = true;
+    int results[JOB_COUNT];
+    JobSystem job_system(JOB_THREAD_COUNT, [](int) {
+        AllocationTracker::trackCurrentThread();
+    });
+
+    for (int tick = 0; tick < WARMUP_TICK_COUNT; ++tick)
+    {
+        job_system.parallelFor(JOB_COUNT, [&results, tick](int job_index) { results[job_index] = tick + job_index; });
+    }
+
+    const unsigned long long start = AllocationTracker::getAllocationCount();
+    for (int tick = 0; tick < STEADY_TICK_COUNT; ++tick)
+    {
+        job_system.parallelFor(JOB_COUNT, [&results, tick](int job_index) { results[job_index] = tick + job_index; });
+    }
+    const unsigned long long allocation_count = AllocationTracker::getAllocationCount() - start;
+
+    for (int job_index = 0; job_index < JOB_COUNT; ++job_index)
+    {
+        success &= (results[job_index] == STEADY_TICK_COUNT - 1 + job_index);
+    }
+
+    std::cout << "job system: " << allocation_count << " allocation(s) over " << STEADY_TICK_COUNT
+        << " ticks" << std::endl;
+
+    return success && allocation_count == 0;
+}
+
+static bool test_state_queue()
+{
+    boost::circular_buffer<DeviceState> states(STATE_BUFFER_MAX);
+    DeviceState state = DeviceState();
+
+    const unsigned long long start = AllocationTracker::getAllocationCount();
+    for (int tick = 0; tick < STEADY_TICK_COUNT; ++tick)
+    {
+        state.sequence = tick;
+        states.push_back(state);
+    }
+    const unsigned long long allocation_count = AllocationTracker::getAllocationCount() - start;
+
+    std::cout << "state queue: " << allocation_count << " allocation(s) over " << STEADY_TICK_COUNT
+        << " ticks" << std::endl;
+
+    return allocation_count == 0 &&
+        states.size() == STATE_BUFFER_MAX &&
+        states.front().sequence == STEADY_TICK_COUNT - STATE_BUFFER_MAX &&
+        states.back().sequence == STEADY_TICK_COUNT - 1;
+}
+
+// Fills in an input data frame the way tracker nodes and clients vary them from one frame to the next:
+// tracker observations come and go and switch between an ellipse and a lightbar projection,
+// and every so often a controller data frame comes through instead
+static void build_input_data_frame(int frame, PSMoveProtocol::DeviceInputDataFrame &data_frame)
+{
+    data_frame.Clear();
+
+    if ((frame % PARSE_CONTROLLER_FRAME_INTERVAL) == PARSE_CONTROLLER_FRAME_INTERVAL - 1)
+    {
+        PSMoveProtocol::DeviceInputDataFrame_ControllerDataPacket *controller_packet =
+            data_frame.mutable_controller_data_packet();
+
+        data_frame.set_connection_id(7);
+        data_frame.set_device_category(PSMoveProtocol::DeviceInputDataFrame_DeviceCategory_CONTROLLER);
+        controller_packet->set_controller_id(frame % 3);
+        controller_packet->set_sequence_num(frame);
+        controller_packet->mutable_psmove_state()->set_rumble_value(frame % 256);
+    }
+    else
+    {
+        PSMoveProtocol::DeviceInputDataFrame_TrackerDataPacket *tracker_packet =
+            data_frame.mutable_tracker_data_packet();
+        const int observation_count = 1 + (frame % PARSE_MAX_OBSERVATIONS);
+
+        data_frame.set_device_category(PSMoveProtocol::DeviceInputDataFrame_DeviceCategory_TRACKER);
+        tracker_packet->set_node_name("living-room-tracker-node");
+        tracker_packet->set_node_token("0123456789abcdef0123456789abcdef");
+        tracker_packet->set_node_tracker_id(frame % 2);
+        tracker_packet->set_frame_id(frame);
+        tracker_packet->set_capture_timestamp_usec(1000000ll + frame * 13333ll);
+        tracker_packet->mutable_tracker_screen_dimensions()->set_x(640.f);
+        tracker_packet->mutable_tracker_screen_dimensions()->set_y(480.f);
+
+        for (int observation_index = 0; observation_index < observation_count; ++observation_index)
+        {
+            PSMoveProtocol::DeviceInputDataFrame_TrackerDataPacket_ControllerObservation *observation =
+                tracker_packet->add_observations();
+            const float offset = static_cast<float>(frame + observation_index);
+
+            observation->set_tracking_color(static_cast<PSMoveProtocol::TrackingColorType>(observation_index));
+            observation->mutable_position()->set_x(offset);
+            observation->mutable_position()->set_z(100.f + offset);
+            observation->set_screen_area(40.f + offset);
+
+            if (((frame + observation_index) % 2) == 0)
+            {
+                observation->mutable_ellipse_projection()->mutable_center()->set_x(320.f + offset);
+                observation->mutable_ellipse_projection()->set_half_x_extent(12.f);
+            }
+            else
+            {
+                observation->set_orientation_valid(true);
+                observation->mutable_orientation()->set_w(1.f);
+
+                for (int vertex_index = 0; vertex_index < 4; ++vertex_index)
+                {
+                    PSMoveProtocol::Pixel *vertex = observation->mutable_lightbar_projection()->add_vertices();
+
+                    vertex->set_x(300.f + offset + vertex_index);
+                    vertex->set_y(200.f + vertex_index);
+                }
+            }
+        }
+    }
+}
+
+static bool test_in_place_parser()
+{
+    InPlaceMessageParser parser;
+    PSMoveProtocol::DeviceInputDataFrame data_frame;
+    PSMoveProtocol::DeviceInputDataFrame parsed_data_frame;
+    PSMoveProtocol::DeviceInputDataFrame expected_data_frame;
+    std::string bytes;
+    unsigned long long allocation_count = 0;
+    int mismatch_count = 0;
+
+    for (int frame = 0; frame < WARMUP_TICK_COUNT + STEADY_TICK_COUNT; ++frame)
+    {
+        build_input_data_frame(frame, data_frame);
+        data_frame.SerializeToString(&bytes);
+
+        const unsigned long long start = AllocationTracker::getAllocationCount();
+        const bool bParsed = parser.parse(&parsed_data_frame, bytes.data(), static_cast<int>(bytes.size()));
+        if (frame >= WARMUP_TICK_COUNT)
+        {
+            allocation_count += AllocationTracker::getAllocationCount() - start;
+        }
+
+        // Has to come out exactly like a regular parse, sub-message presence included
+        expected_data_frame.ParseFromString(bytes);
+        if (!bParsed || parsed_data_frame.SerializeAsString() != expected_data_frame.SerializeAsString())
+        {
+            ++mismatch_count;
+        }
+    }
+
+    // Malformed data (a sub-message length running past the end) is refused
+    build_input_data_frame(0, data_frame);
+    data_frame.SerializeToString(&bytes);
+    const bool bRefusedTruncated = !parser.parse(&parsed_data_frame, bytes.data(), static_cast<int>(bytes.size()) - 3);
+
+    std::cout << "in place parser: " << allocation_count << " allocation(s) over " << STEADY_TICK_COUNT
+        << " data frames, " << mismatch_count << " mismatch(es) with a regular parse, truncated data "
+        << (bRefusedTruncated ? "refused" : "accepted") << std::endl;
+
+    return allocation_count == 0 && mismatch_count == 0 && bRefusedTruncated;
+}
+
+// Stands in for a client: connects over TCP to get a connection id, then streams controller
+// input data frames over UDP (rumble updates, like a game sends) until told to stop.
+// Runs on its own thread, which isn't tracked, so only the service's allocations get counted.
+static void run_test_client(std::atomic_bool *bStop, std::atomic_int *sent_count)
+{
+    using boost::asio::ip::tcp;
+    using boost::asio::ip::udp;
+
+    boost::asio::io_service io_service;
+    boost::system::error_code error;
+    const boost::asio::ip::address loopback = boost::asio::ip::address_v4::loopback();
+    tcp::socket tcp_socket(io_service);
+    udp::socket udp_socket(io_service);
+
+    // The service sends the connection id as soon as it accepts the connection
+    PackedMessage<PSMoveProtocol::Response> packed_response(ResponsePtr(new PSMoveProtocol::Response));
+    data_buffer response_buffer(HEADER_SIZE);
+
+    tcp_socket.connect(tcp::endpoint(loopback, SERVICE_PORT), error);
+    if (!error)
+    {
+        boost::asio::read(tcp_socket, boost::asio::buffer(response_buffer), error);
+    }
+    if (!error)
+    {
+        response_buffer.resize(HEADER_SIZE + packed_response.decode_header(response_buffer));
+        boost::asio::read(tcp_socket, boost::asio::buffer(&response_buffer[HEADER_SIZE], response_buffer.size() - HEADER_SIZE), error);
+    }
+    if (error || 
+        !packed_response.unpack(response_buffer) || 
+        packed_response.get_msg()->type() != PSMoveProtocol::Response_ResponseType_CONNECTION_INFO)
+    {
+        std::cout << "test client: didn't get a connection id (" << error.message() << ")" << std::endl;
+        return;
+    }
+
+    PackedMessage<PSMoveProtocol::DeviceInputDataFrame> packed_data_frame(
+        DeviceInputDataFramePtr(new PSMoveProtocol::DeviceInputDataFrame));
+    DeviceInputDataFramePtr data_frame = packed_data_frame.get_msg();
+    const udp::endpoint service_endpoint(loopback, SERVICE_PORT);
+    data_buffer data_frame_buffer;
+
+    data_frame->set_connection_id(packed_response.get_msg()->result_connection_info().tcp_connection_id());
+    data_frame->set_device_category(PSMoveProtocol::DeviceInputDataFrame_DeviceCategory_CONTROLLER);
+    data_frame->mutable_controller_data_packet()->set_controller_id(0);
+    data_frame->mutable_controller_data_packet()->set_controller_type(PSMoveProtocol::PSMOVE);
+
+    udp_socket.open(udp::v4(), error);
+    for (int sequence_num = 1; !error && !bStop->load(); ++sequence_num)
+    {
+        data_frame->mutable_controller_data_packet()->set_sequence_num(sequence_num);
+        data_frame->mutable_controller_data_packet()->mutable_psmove_state()->set_rumble_value(sequence_num % 256);
+        packed_data_frame.pack(data_frame_buffer);
+
+        udp_socket.send_to(boost::asio::buffer(data_frame_buffer), service_endpoint, 0, error);
+        if (!error)
+        {
+            ++(*sent_count);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(CLIENT_SEND_INTERVAL_MS));
+    }
+
+    tcp_socket.close(error);
+    udp_socket.close(error);
+}
+
+// Ticks the update loop the way PSMoveServiceImpl does
+static bool test_service_loop()
+{
+    boost::asio::io_service io_service;
+    DeviceManager device_manager;
+    ServerRequestHandler request_handler(&device_manager);
+    ServerNetworkManager network_manager(&io_service, SERVICE_PORT, &request_handler);
+    std::atomic_bool bStopClient(false);
+    std::atomic_int sent_count(0);
+    unsigned long long steady_allocation_count = 0;
+    int steady_tick_count = 0;
+    int allocating_tick_count = 0;
+    int steady_start_sent_count = 0;
+
+    bool success = network_manager.startup() && device_manager.startup() && request_handler.startup();
+
+    if (success)
+    {
+        std::thread client_thread(run_test_client, &bStopClient, &sent_count);
+
+        // Startup opened every device, give the loop time to settle like the service does
+        AllocationTracker::trackCurrentThread();
+        AllocationTracker::noteConfigurationChange();
+
+        const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        for (;;)
+        {
+            const long long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+            if (elapsed_ms >= SERVICE_WARMUP_MS + SERVICE_STEADY_MS)
+            {
+                break;
+            }
+
+            const bool bSteady = elapsed_ms >= SERVICE_WARMUP_MS;
+            if (bSteady && steady_tick_count == 0)
+            {
+                steady_start_sent_count = sent_count.load();
+            }
+
+            const unsigned long long tick_start = AllocationTracker::beginTick();
+            request_handler.update();
+            device_manager.update();
+            network_manager.update();
+            const unsigned long long tick_allocation_count = AllocationTracker::endTick(tick_start);
+
+            if (bSteady)
+            {
+                steady_allocation_count += tick_allocation_count;
+                allocating_tick_count += (tick_allocation_count > 0) ? 1 : 0;
+                ++steady_tick_count;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(SERVICE_TICK_SLEEP_MS));
+        }
+
+        bStopClient = true;
+        client_thread.join();
+    }
+    else
+    {
+        std::cout << "service loop: startup failed" << std::endl;
+    }
+
+    request_handler.shutdown();
+    device_manager.shutdown();
+    network_manager.shutdown();
+
+    const int steady_sent_count = sent_count.load() - steady_start_sent_count;
+
+    std::cout << "service loop: " << steady_allocation_count << " allocation(s) in " << allocating_tick_count
+        << " of " << steady_tick_count << " ticks while " << steady_sent_count << " input data frames came in" << std::endl;
+
+    return success && steady_tick_count > 0 && steady_sent_count > 0 && steady_allocation_count == 0;
+}
+
+int main()
+{
+    bool success = test_counting();
+
+    log_init("info");
+
+    // No point checking for zero if allocations aren't being seen
+    if (success)
+    {
+        success &= test_blob_labeler();
+        success &= test_job_system();
+        success &= test_state_queue();
+        success &= test_in_place_parser();
+        success &= test_service_loop();
+    }
+
+    log_dispose();
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}
@@ -0,0 +1,192 @@
+#include "PSMoveProtocolInterface.h"
+#include "PSMoveProtocol.pb.h"
+#include "PackedMessage.h"
+#include <boost/asio.hpp>
+#include <cstring>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+
+#if defined(__linux) || defined (__APPLE__)
+#include <unistd.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Pretends to be a tracker node with a single camera watching a sphere
+// that moves in a circle in front of it. Use this to exercise the
+// remote tracker path of PSMoveService without a second machine.
+
+#define FRAME_INTERVAL 16 // ms (~60Hz)
+
+#define SCREEN_WIDTH 640.f
+#define SCREEN_HEIGHT 480.f
+#define FOCAL_LENGTH 554.2563f
+#define HFOV 60.f
+#define VFOV 45.f
+#define ZNEAR 10.f
+#define ZFAR 200.f
+
+#define CIRCLE_RADIUS 20.f // cm
+#define CIRCLE_DEPTH 100.f // cm
+#define SPHERE_RADIUS 2.25f // cm
+
+bool g_keep_running= true;
+
+void sleep_millisecond(int sleepMs)
+{
+#if defined(__linux) || defined (__APPLE__)
+    usleep(sleepMs * 1000);
+#endif
+#ifdef _WIN32
+    Sleep(sleepMs);
+#endif
+}
+
+void handle_termination_signal(
+    const boost::system::error_code& error, // Result of operation.
+    int signal_number)
+{
+    std::cout << "Received termination signal. Stopping Tracker Node." << std::endl;
+    g_keep_running= false;
+}
+
+void build_tracker_data_frame(
+    const char *node_name,
+    const char *node_token,
+    int frame_id,
+    PSMoveProtocol::DeviceInputDataFrame *data_frame)
+{
+    PSMoveProtocol::DeviceInputDataFrame_TrackerDataPacket *tracker_packet = data_frame->mutable_tracker_data_packet();
+
+    data_frame->set_connection_id(-1);
+    data_frame->set_device_category(PSMoveProtocol::DeviceInputDataFrame_DeviceCategory_TRACKER);
+
+    tracker_packet->set_node_name(node_name);
+    tracker_packet->set_node_token(node_token);
+    tracker_packet->set_node_tracker_id(0);
+    tracker_packet->set_frame_id(frame_id);
+    tracker_packet->set_capture_timestamp_usec(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now().time_since_epoch()).count());
+
+    tracker_packet->mutable_tracker_screen_dimensions()->set_x(SCREEN_WIDTH);
+    tracker_packet->mutable_tracker_screen_dimensions()->set_y(SCREEN_HEIGHT);
+    tracker_packet->mutable_tracker_focal_lengths()->set_x(FOCAL_LENGTH);
+    tracker_packet->mutable_tracker_focal_lengths()->set_y(FOCAL_LENGTH);
+    tracker_packet->mutable_tracker_principal_point()->set_x(SCREEN_WIDTH / 2.f);
+    tracker_packet->mutable_tracker_principal_point()->set_y(SCREEN_HEIGHT / 2.f);
+    tracker_packet->set_tracker_hfov(HFOV);
+    tracker_packet->set_tracker_vfov(VFOV);
+    tracker_packet->set_tracker_znear(ZNEAR);
+    tracker_packet->set_tracker_zfar(ZFAR);
+
+    // One full circle every 4 seconds
+    const float angle = static_cast<float>(frame_id) * 2.f * 3.14159265f / 240.f;
+    const float x = CIRCLE_RADIUS * cosf(angle);
+    const float y = CIRCLE_RADIUS * sinf(angle);
+    const float z = CIRCLE_DEPTH;
+    const float projected_radius = FOCAL_LENGTH * SPHERE_RADIUS / z;
+
+    PSMoveProtocol::DeviceInputDataFrame_TrackerDataPacket_ControllerObservation *observation =
+        tracker_packet->add_observations();
+
+    observation->set_tracking_color(PSMoveProtocol::Magenta);
+    observation->mutable_position()->set_x(x);
+    observation->mutable_position()->set_y(y);
+    observation->mutable_position()->set_z(z);
+    observation->set_orientation_valid(false);
+
+    PSMoveProtocol::Ellipse *ellipse = observation->mutable_ellipse_projection();
+    ellipse->mutable_center()->set_x(SCREEN_WIDTH / 2.f + FOCAL_LENGTH * x / z);
+    ellipse->mutable_center()->set_y(SCREEN_HEIGHT / 2.f - FOCAL_LENGTH * y / z);
+    ellipse->set_half_x_extent(projected_radius);
+    ellipse->set_half_y_extent(projected_radius);
+    ellipse->set_angle(0.f);
+
+    observation->set_screen_area(3.14159265f * projected_radius * projected_radius);
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        if (argc < 3 || argc > 4)
+        {
+            // node_token has to match tracker_node_token in the service's ServerNetworkConfig
+            std::cerr << "Usage: test_tracker_node <host> <node_token> [node_name]" << std::endl;
+            return 1;
+        }
+
+        const char *node_token= argv[2];
+        const char *node_name= (argc == 4) ? argv[3] : "test_tracker_node";
+        boost::asio::io_service io_service;
+
+        // Register to handle the signals that indicate when the node should exit.
+        boost::asio::signal_set signals(io_service);
+        signals.add(SIGINT);
+        signals.add(SIGTERM);
+#if defined(SIGQUIT)
+        signals.add(SIGQUIT);
+#endif // defined(SIGQUIT)
+        signals.async_wait(&handle_termination_signal);
+
+        boost::asio::ip::udp::resolver resolver(io_service);
+        boost::asio::ip::udp::resolver::query query(boost::asio::ip::udp::v4(), argv[1], "9512");
+        boost::asio::ip::udp::endpoint receiver_endpoint = *resolver.resolve(query);
+
+        boost::asio::ip::udp::socket socket(io_service);
+        socket.open(boost::asio::ip::udp::v4());
+
+        PackedMessage<PSMoveProtocol::DeviceInputDataFrame> packed_data_frame;
+        uint8_t data_frame_buffer[HEADER_SIZE + MAX_TRACKER_INPUT_DATA_FRAME_MESSAGE_SIZE];
+        int frame_id= 0;
+
+        std::cout << "Streaming tracker node '" << node_name << "' to " << argv[1] << ":9512" << std::endl;
+
+        while (g_keep_running)
+        {
+            DeviceInputDataFramePtr data_frame(new PSMoveProtocol::DeviceInputDataFrame);
+
+            build_tracker_data_frame(node_name, node_token, frame_id, data_frame.get());
+            packed_data_frame.set_msg(data_frame);
+
+            if (packed_data_frame.pack(data_frame_buffer, sizeof(data_frame_buffer)))
+            {
+                boost::system::error_code error;
+
+                socket.send_to(
+                    boost::asio::buffer(data_frame_buffer, HEADER_SIZE + data_frame->ByteSize()),
+                    receiver_endpoint, 0, error);
+
+                if (error)
+                {
+                    std::cerr << "Failed to send tracker frame: " << error.message() << std::endl;
+                }
+            }
+            else
+            {
+                std::cerr << "Tracker frame too big to fit in packet!" << std::endl;
+            }
+
+            if ((frame_id % 60) == 0)
+            {
+                std::cout << "Sent " << frame_id << " tracker frames" << std::endl;
+            }
+            ++frame_id;
+
+            io_service.poll();
+
+            sleep_millisecond(FRAME_INTERVAL);
+        }
+
+        socket.close();
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+
+  return 0;
+}
@@ -0,0 +1,165 @@
+#include "TrackerObservationSync.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// Checks the soft synchronization of multi-camera observations that runs before triangulation:
+// stale observations are dropped past the tolerance, the rest get moved forward by their
+// age along the controller's velocity, and a tolerance of 0 turns it all off.
+
+#define TOLERANCE_MILLISECONDS 20
+#define MAX_POSITION_ERROR 0.001f // cm
+#define MAX_TIME_ERROR 0.00001f // seconds
+
+typedef std::chrono::time_point<std::chrono::high_resolution_clock> t_timestamp;
+
+static t_timestamp get_capture_timestamp(const t_timestamp &reference, float age_milliseconds)
+{
+    return reference - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+        std::chrono::duration<float, std::milli>(age_milliseconds));
+}
+
+static bool test_tolerance_drop()
+{
+    const t_timestamp reference = std::chrono::high_resolution_clock::now();
+    // Four trackers: the reference one, two within the tolerance and one a frame and a half behind
+    const float capture_ages[4] = { 0.f, 5.f, 25.f, 13.3f };
+    t_timestamp capture_timestamps[4];
+    int synchronized_indices[4];
+    float extrapolation_seconds[4];
+    float capture_skew_milliseconds = -1.f;
+    bool success = true;
+
+    for (int index = 0; index < 4; ++index)
+    {
+        capture_timestamps[index] = get_capture_timestamp(reference, capture_ages[index]);
+    }
+
+    const int synchronized_count =
+        synchronize_observation_times(
+            reference, TOLERANCE_MILLISECONDS, capture_timestamps, 4,
+            synchronized_indices, extrapolation_seconds, capture_skew_milliseconds);
+
+    std::cout << "tolerance drop: kept " << synchronized_count << " (";
+    for (int sync_index = 0; sync_index < synchronized_count; ++sync_index)
+    {
+        std::cout << (sync_index > 0 ? ", " : "") << synchronized_indices[sync_index] << " +" << extrapolation_seconds[sync_index] * 1000.f << "ms";
+    }
+    std::cout << "), skew " << capture_skew_milliseconds << "ms" << std::endl;
+
+    // The stale observation is gone and the kept ones stay in order
+    success &= synchronized_count == 3;
+    success &= synchronized_indices[0] == 0 && synchronized_indices[1] == 1 && synchronized_indices[2] == 3;
+    success &= extrapolation_seconds[0] == 0.f;
+    success &= fabsf(extrapolation_seconds[1] - 0.005f) <= MAX_TIME_ERROR;
+    success &= fabsf(extrapolation_seconds[2] - 0.0133f) <= MAX_TIME_ERROR;
+    success &= fabsf(capture_skew_milliseconds - 13.3f) <= MAX_TIME_ERROR * 1000.f;
+
+    // Right at the tolerance is still kept
+    capture_timestamps[2] = get_capture_timestamp(reference, static_cast<float>(TOLERANCE_MILLISECONDS));
+    success &=
+        synchronize_observation_times(
+            reference, TOLERANCE_MILLISECONDS, capture_timestamps, 4,
+            synchronized_indices, extrapolation_seconds, capture_skew_milliseconds) == 4;
+
+    return success;
+}
+
+static bool test_sync_disabled()
+{
+    const t_timestamp reference = std::chrono::high_resolution_clock::now();
+    const float capture_ages[3] = { 0.f, 8.f, 250.f };
+    t_timestamp capture_timestamps[3];
+    int synchronized_indices[3];
+    float extrapolation_seconds[3];
+    float capture_skew_milliseconds = -1.f;
+    bool success = true;
+
+    for (int index = 0; index < 3; ++index)
+    {
+        capture_timestamps[index] = get_capture_timestamp(reference, capture_ages[index]);
+    }
+
+    // A tolerance of 0 keeps everything where it was
+    const int synchronized_count =
+        synchronize_observation_times(
+            reference, 0, capture_timestamps, 3,
+            synchronized_indices, extrapolation_seconds, capture_skew_milliseconds);
+
+    std::cout << "sync disabled: kept " << synchronized_count << ", skew " << capture_skew_milliseconds << "ms" << std::endl;
+
+    success &= synchronized_count == 3;
+    for (int sync_index = 0; sync_index < synchronized_count; ++sync_index)
+    {
+        success &= synchronized_indices[sync_index] == sync_index && extrapolation_seconds[sync_index] == 0.f;
+    }
+
+    return success;
+}
+
+static bool test_extrapolation()
+{
+    const t_timestamp reference = std::chrono::high_resolution_clock::now();
+    // A controller moving at a constant velocity seen by two trackers 12.5ms apart
+    CommonDeviceVector velocity;
+    velocity.i = 120.f;
+    velocity.j = -40.f;
+    velocity.k = 15.f;
+
+    CommonDevicePosition position_at_reference;
+    position_at_reference.set(10.f, 100.f, -50.f);
+
+    const float capture_ages[2] = { 0.f, 12.5f };
+    t_timestamp capture_timestamps[2];
+    CommonDevicePosition observed_positions[2];
+
+    for (int index = 0; index < 2; ++index)
+    {
+        const float age_seconds = capture_ages[index] / 1000.f;
+
+        capture_timestamps[index] = get_capture_timestamp(reference, capture_ages[index]);
+        observed_positions[index] = extrapolate_observation_position(position_at_reference, velocity, -age_seconds);
+    }
+
+    int synchronized_indices[2];
+    float extrapolation_seconds[2];
+    float capture_skew_milliseconds;
+    const int synchronized_count =
+        synchronize_observation_times(
+            reference, TOLERANCE_MILLISECONDS, capture_timestamps, 2,
+            synchronized_indices, extrapolation_seconds, capture_skew_milliseconds);
+
+    // Without synchronization the late observation is 1.5cm behind, which triangulation would smear
+    float max_error_before = 0.f;
+    float max_error_after = 0.f;
+    for (int sync_index = 0; sync_index < synchronized_count; ++sync_index)
+    {
+        const CommonDevicePosition &observed = observed_positions[synchronized_indices[sync_index]];
+        const CommonDevicePosition synchronized =
+            extrapolate_observation_position(observed, velocity, extrapolation_seconds[sync_index]);
+
+        max_error_before = std::max(max_error_before, fabsf(observed.x - position_at_reference.x));
+        max_error_after = std::max(max_error_after, fabsf(synchronized.x - position_at_reference.x));
+        max_error_after = std::max(max_error_after, fabsf(synchronized.y - position_at_reference.y));
+        max_error_after = std::max(max_error_after, fabsf(synchronized.z - position_at_reference.z));
+    }
+
+    std::cout << "extrapolation: error " << max_error_before << "cm before, " << max_error_after << "cm after" << std::endl;
+
+    return synchronized_count == 2 && max_error_before > 1.f && max_error_after <= MAX_POSITION_ERROR;
+}
+
+int main()
+{
+    bool success = true;
+
+    success &= test_tolerance_drop();
+    success &= test_sync_disabled();
+    success &= test_extrapolation();
+
+    std::cout << (success ? "PASSED" : "FAILED") << std::endl;
+
+    return success ? 0 : -1;
+}